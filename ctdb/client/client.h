@@ -950,6 +950,67 @@ int ctdb_db_traverse(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
 		     uint32_t destnode, struct timeval timeout,
 		     ctdb_rec_parser_func_t parser, void *private_data);
 
+/**
+ * @brief Async computation start to a streaming cluster-wide database traverse
+ *
+ * This is like ctdb_db_traverse_send(), but the nodes send the records
+ * in batches and only send more batches when the earlier ones have been
+ * queued to the client, so a slow client does not make the nodes queue
+ * up the whole database.  Only the records with a key starting with
+ * prefix are sent.
+ *
+ * @param[in] mem_ctx Talloc memory context
+ * @param[in] ev Tevent context
+ * @param[in] client Client connection context
+ * @param[in] db Database context
+ * @param[in] destnode Node id
+ * @param[in] timeout How long to wait
+ * @param[in] prefix Key prefix, tdb_null for all records
+ * @param[in] parser Record parser function
+ * @param[in] private_data Private data for parser
+ * @return a new tevent req on success, NULL on failure
+ */
+struct tevent_req *ctdb_db_traverse_stream_send(
+					TALLOC_CTX *mem_ctx,
+					struct tevent_context *ev,
+					struct ctdb_client_context *client,
+					struct ctdb_db_context *db,
+					uint32_t destnode,
+					struct timeval timeout,
+					TDB_DATA prefix,
+					ctdb_rec_parser_func_t parser,
+					void *private_data);
+
+/**
+ * @brief Async computation end to a streaming cluster-wide database traverse
+ *
+ * @param[in] req Tevent request
+ * @param[out] perr errno in case of failure
+ * @return true on success, false on failure
+ */
+bool ctdb_db_traverse_stream_recv(struct tevent_req *req, int *perr);
+
+/**
+ * @brief Sync wrapper for a streaming cluster-wide database traverse
+ *
+ * @param[in] mem_ctx Talloc memory context
+ * @param[in] ev Tevent context
+ * @param[in] client Client connection context
+ * @param[in] db Database context
+ * @param[in] destnode Node id
+ * @param[in] timeout How long to wait
+ * @param[in] prefix Key prefix, tdb_null for all records
+ * @param[in] parser Record parser function
+ * @param[in] private_data Private data for parser
+ * @return 0 on success, errno on failure or non-zero status from parser
+ */
+int ctdb_db_traverse_stream(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+			    struct ctdb_client_context *client,
+			    struct ctdb_db_context *db,
+			    uint32_t destnode, struct timeval timeout,
+			    TDB_DATA prefix,
+			    ctdb_rec_parser_func_t parser, void *private_data);
+
 /**
  * @brief Fetch a record from a local database
  *
@@ -1031,6 +1092,61 @@ int ctdb_fetch_lock(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
 		    struct ctdb_record_handle **out,
 		    struct ctdb_ltdb_header *header, TDB_DATA *data);
 
+/**
+ * @brief Async computation start to migrate a batch of records
+ *
+ * This function is used to bring several records of a distributed
+ * database to the local node at once, e.g. before locking a set of
+ * related records.
+ *
+ * A migration request is sent for each record that is not already
+ * available for read/write access on the local node.  All requests
+ * are outstanding at the same time, so the whole batch is migrated
+ * in a single round trip.  The records are not locked, so one of them
+ * may be migrated away again before it is locked with ctdb_fetch_lock().
+ *
+ * @param[in] mem_ctx Talloc memory context
+ * @param[in] ev Tevent context
+ * @param[in] client Client context
+ * @param[in] db Database context
+ * @param[in] keys Array of record keys
+ * @param[in] num_keys Number of record keys
+ * @return a new tevent req on success, NULL on failure
+ */
+struct tevent_req *ctdb_migrate_records_send(TALLOC_CTX *mem_ctx,
+					     struct tevent_context *ev,
+					     struct ctdb_client_context *client,
+					     struct ctdb_db_context *db,
+					     TDB_DATA *keys,
+					     unsigned int num_keys);
+
+/**
+ * @brief Async computation end to migrate a batch of records
+ *
+ * @param[in] req Tevent request
+ * @param[out] perr errno in case of failure
+ * @return true on success, false on failure
+ */
+bool ctdb_migrate_records_recv(struct tevent_req *req, int *perr);
+
+/**
+ * @brief Sync wrapper to migrate a batch of records
+ *
+ * @see ctdb_migrate_records_send
+ *
+ * @param[in] mem_ctx Talloc memory context
+ * @param[in] ev Tevent context
+ * @param[in] client Client context
+ * @param[in] db Database context
+ * @param[in] keys Array of record keys
+ * @param[in] num_keys Number of record keys
+ * @return 0 on success, errno on failure
+ */
+int ctdb_migrate_records(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+			 struct ctdb_client_context *client,
+			 struct ctdb_db_context *db,
+			 TDB_DATA *keys, unsigned int num_keys);
+
 /**
  * @brief Update a locked record
  *
@@ -1097,6 +1097,281 @@ int ctdb_db_traverse(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
 	return 0;
 }
 
+struct ctdb_db_traverse_stream_state {
+	struct tevent_context *ev;
+	struct ctdb_client_context *client;
+	struct ctdb_db_context *db;
+	uint32_t destnode;
+	uint64_t srvid;
+	struct timeval timeout;
+	TDB_DATA prefix;
+	ctdb_rec_parser_func_t parser;
+	void *private_data;
+	int result;
+	bool done;
+};
+
+static void ctdb_db_traverse_stream_handler_set(struct tevent_req *subreq);
+static void ctdb_db_traverse_stream_started(struct tevent_req *subreq);
+static void ctdb_db_traverse_stream_handler(uint64_t srvid, TDB_DATA data,
+					    void *private_data);
+static void ctdb_db_traverse_stream_remove_handler(struct tevent_req *req);
+static void ctdb_db_traverse_stream_handler_removed(
+					struct tevent_req *subreq);
+
+struct tevent_req *ctdb_db_traverse_stream_send(
+					TALLOC_CTX *mem_ctx,
+					struct tevent_context *ev,
+					struct ctdb_client_context *client,
+					struct ctdb_db_context *db,
+					uint32_t destnode,
+					struct timeval timeout,
+					TDB_DATA prefix,
+					ctdb_rec_parser_func_t parser,
+					void *private_data)
+{
+	struct tevent_req *req, *subreq;
+	struct ctdb_db_traverse_stream_state *state;
+
+	req = tevent_req_create(mem_ctx, &state,
+				struct ctdb_db_traverse_stream_state);
+	if (req == NULL) {
+		return NULL;
+	}
+
+	state->ev = ev;
+	state->client = client;
+	state->db = db;
+	state->destnode = destnode;
+	state->srvid = CTDB_SRVID_CLIENT_RANGE | getpid();
+	state->timeout = timeout;
+	state->prefix = prefix;
+	state->parser = parser;
+	state->private_data = private_data;
+
+	subreq = ctdb_client_set_message_handler_send(
+					state, ev, client, state->srvid,
+					ctdb_db_traverse_stream_handler, req);
+	if (tevent_req_nomem(subreq, req)) {
+		return tevent_req_post(req, ev);
+	}
+	tevent_req_set_callback(subreq, ctdb_db_traverse_stream_handler_set,
+				req);
+
+	return req;
+}
+
+static void ctdb_db_traverse_stream_handler_set(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_db_traverse_stream_state *state = tevent_req_data(
+		req, struct ctdb_db_traverse_stream_state);
+	struct ctdb_traverse_start_stream traverse;
+	struct ctdb_req_control request;
+	int ret = 0;
+	bool status;
+
+	status = ctdb_client_set_message_handler_recv(subreq, &ret);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		tevent_req_error(req, ret);
+		return;
+	}
+
+	traverse = (struct ctdb_traverse_start_stream) {
+		.db_id = ctdb_db_id(state->db),
+		.reqid = 0,
+		.srvid = state->srvid,
+		.withemptyrecords = false,
+		.prefix = state->prefix,
+	};
+
+	ctdb_req_control_traverse_start_stream(&request, &traverse);
+	subreq = ctdb_client_control_send(state, state->ev, state->client,
+					  state->destnode, state->timeout,
+					  &request);
+	if (subreq == NULL) {
+		state->result = ENOMEM;
+		ctdb_db_traverse_stream_remove_handler(req);
+		return;
+	}
+	tevent_req_set_callback(subreq, ctdb_db_traverse_stream_started, req);
+}
+
+static void ctdb_db_traverse_stream_started(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_db_traverse_stream_state *state = tevent_req_data(
+		req, struct ctdb_db_traverse_stream_state);
+	struct ctdb_reply_control *reply;
+	int ret = 0;
+	bool status;
+
+	status = ctdb_client_control_recv(subreq, &ret, state, &reply);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		DEBUG(DEBUG_ERR, ("traverse: control failed, ret=%d\n", ret));
+		state->result = ret;
+		ctdb_db_traverse_stream_remove_handler(req);
+		return;
+	}
+
+	ret = ctdb_reply_control_traverse_start_stream(reply);
+	talloc_free(reply);
+	if (ret != 0) {
+		DEBUG(DEBUG_ERR, ("traverse: control reply failed, ret=%d\n",
+				  ret));
+		state->result = ret;
+		ctdb_db_traverse_stream_remove_handler(req);
+		return;
+	}
+}
+
+static int ctdb_db_traverse_stream_parser(uint32_t reqid,
+					  struct ctdb_ltdb_header *nullheader,
+					  TDB_DATA key, TDB_DATA data,
+					  void *private_data)
+{
+	struct ctdb_db_traverse_stream_state *state =
+		(struct ctdb_db_traverse_stream_state *)private_data;
+	struct ctdb_ltdb_header header;
+	int ret;
+
+	ret = ctdb_ltdb_header_extract(&data, &header);
+	if (ret != 0) {
+		return 0;
+	}
+
+	if (data.dsize == 0) {
+		return 0;
+	}
+
+	return state->parser(reqid, &header, key, data, state->private_data);
+}
+
+static void ctdb_db_traverse_stream_handler(uint64_t srvid, TDB_DATA data,
+					    void *private_data)
+{
+	struct tevent_req *req = talloc_get_type_abort(
+		private_data, struct tevent_req);
+	struct ctdb_db_traverse_stream_state *state = tevent_req_data(
+		req, struct ctdb_db_traverse_stream_state);
+	struct ctdb_rec_buffer *recbuf;
+	size_t np;
+	int ret;
+
+	if (state->done) {
+		return;
+	}
+
+	ret = ctdb_rec_buffer_pull(data.dptr, data.dsize, state, &recbuf, &np);
+	if (ret != 0) {
+		return;
+	}
+
+	/* An empty batch ends the traverse */
+	if (recbuf->count == 0) {
+		talloc_free(recbuf);
+		state->done = true;
+		ctdb_db_traverse_stream_remove_handler(req);
+		return;
+	}
+
+	ret = ctdb_rec_buffer_traverse(recbuf, ctdb_db_traverse_stream_parser,
+				       state);
+	talloc_free(recbuf);
+	if (ret != 0) {
+		state->result = ret;
+		state->done = true;
+		ctdb_db_traverse_stream_remove_handler(req);
+	}
+}
+
+static void ctdb_db_traverse_stream_remove_handler(struct tevent_req *req)
+{
+	struct ctdb_db_traverse_stream_state *state = tevent_req_data(
+		req, struct ctdb_db_traverse_stream_state);
+	struct tevent_req *subreq;
+
+	subreq = ctdb_client_remove_message_handler_send(state, state->ev,
+							 state->client,
+							 state->srvid, req);
+	if (tevent_req_nomem(subreq, req)) {
+		return;
+	}
+	tevent_req_set_callback(subreq,
+				ctdb_db_traverse_stream_handler_removed, req);
+}
+
+static void ctdb_db_traverse_stream_handler_removed(
+					struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_db_traverse_stream_state *state = tevent_req_data(
+		req, struct ctdb_db_traverse_stream_state);
+	int ret;
+	bool status;
+
+	status = ctdb_client_remove_message_handler_recv(subreq, &ret);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		tevent_req_error(req, ret);
+		return;
+	}
+
+	if (state->result != 0) {
+		tevent_req_error(req, state->result);
+		return;
+	}
+
+	tevent_req_done(req);
+}
+
+bool ctdb_db_traverse_stream_recv(struct tevent_req *req, int *perr)
+{
+	int ret;
+
+	if (tevent_req_is_unix_error(req, &ret)) {
+		if (perr != NULL) {
+			*perr = ret;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+int ctdb_db_traverse_stream(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+			    struct ctdb_client_context *client,
+			    struct ctdb_db_context *db,
+			    uint32_t destnode, struct timeval timeout,
+			    TDB_DATA prefix,
+			    ctdb_rec_parser_func_t parser, void *private_data)
+{
+	struct tevent_req *req;
+	int ret = 0;
+	bool status;
+
+	req = ctdb_db_traverse_stream_send(mem_ctx, ev, client, db, destnode,
+					   timeout, prefix, parser,
+					   private_data);
+	if (req == NULL) {
+		return ENOMEM;
+	}
+
+	tevent_req_poll(req, ev);
+
+	status = ctdb_db_traverse_stream_recv(req, &ret);
+	if (! status) {
+		return ret;
+	}
+
+	return 0;
+}
+
 int ctdb_ltdb_fetch(struct ctdb_db_context *db, TDB_DATA key,
 		    struct ctdb_ltdb_header *header,
 		    TALLOC_CTX *mem_ctx, TDB_DATA *data)
@@ -1460,6 +1735,170 @@ int ctdb_fetch_lock(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
 	return 0;
 }
 
+/*
+ * Migrate a batch of records from volatile database
+ *
+ * A CTDB_REQ_CALL is sent for every record that is not already
+ * available for read/write access on the local node.  All the
+ * requests are in flight at once, so the batch costs a single
+ * round trip rather than one per record.  The records are not
+ * locked; the caller uses ctdb_fetch_lock() on each record
+ * afterwards, which normally finds it local and does not migrate.
+ */
+
+struct ctdb_migrate_records_state {
+	struct ctdb_db_context *db;
+	unsigned int pending;
+};
+
+static void ctdb_migrate_records_done(struct tevent_req *subreq);
+
+struct tevent_req *ctdb_migrate_records_send(TALLOC_CTX *mem_ctx,
+					     struct tevent_context *ev,
+					     struct ctdb_client_context *client,
+					     struct ctdb_db_context *db,
+					     TDB_DATA *keys,
+					     unsigned int num_keys)
+{
+	struct tevent_req *req, *subreq;
+	struct ctdb_migrate_records_state *state;
+	struct ctdb_ltdb_header header;
+	struct ctdb_req_call request;
+	uint32_t pnn;
+	unsigned int i;
+	int ret;
+
+	req = tevent_req_create(mem_ctx, &state,
+				struct ctdb_migrate_records_state);
+	if (req == NULL) {
+		return NULL;
+	}
+
+	state->db = db;
+	state->pending = 0;
+
+	/* Check that database is not persistent */
+	if (! ctdb_db_volatile(db)) {
+		DEBUG(DEBUG_ERR, ("migrate_records: %s database not volatile\n",
+				  db->db_name));
+		tevent_req_error(req, EINVAL);
+		return tevent_req_post(req, ev);
+	}
+
+	pnn = ctdb_client_pnn(client);
+
+	for (i=0; i<num_keys; i++) {
+		ret = ctdb_ltdb_fetch(db, keys[i], &header, NULL, NULL);
+		if (ret != 0) {
+			tevent_req_error(req, ret);
+			return tevent_req_post(req, ev);
+		}
+
+		/* Same checks as ctdb_fetch_lock_check() for read/write */
+		if (header.dmaster == pnn &&
+		    ! (header.flags & CTDB_REC_RO_HAVE_DELEGATIONS)) {
+			continue;
+		}
+
+		ZERO_STRUCT(request);
+		request.flags = CTDB_IMMEDIATE_MIGRATION;
+		request.db_id = db->db_id;
+		request.callid = CTDB_NULL_FUNC;
+		request.key = keys[i];
+		request.calldata = tdb_null;
+
+		subreq = ctdb_client_call_send(state, ev, client, &request);
+		if (tevent_req_nomem(subreq, req)) {
+			return tevent_req_post(req, ev);
+		}
+		tevent_req_set_callback(subreq, ctdb_migrate_records_done,
+					req);
+
+		state->pending += 1;
+	}
+
+	if (state->pending == 0) {
+		tevent_req_done(req);
+		return tevent_req_post(req, ev);
+	}
+
+	return req;
+}
+
+static void ctdb_migrate_records_done(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_migrate_records_state *state = tevent_req_data(
+		req, struct ctdb_migrate_records_state);
+	struct ctdb_reply_call *reply;
+	int ret;
+	bool status;
+
+	status = ctdb_client_call_recv(subreq, state, &reply, &ret);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		DEBUG(DEBUG_ERR, ("migrate_records: %s CALL failed, ret=%d\n",
+				  state->db->db_name, ret));
+		tevent_req_error(req, ret);
+		return;
+	}
+
+	if (reply->status != 0) {
+		talloc_free(reply);
+		tevent_req_error(req, EIO);
+		return;
+	}
+	talloc_free(reply);
+
+	state->pending -= 1;
+	if (state->pending > 0) {
+		return;
+	}
+
+	tevent_req_done(req);
+}
+
+bool ctdb_migrate_records_recv(struct tevent_req *req, int *perr)
+{
+	int err;
+
+	if (tevent_req_is_unix_error(req, &err)) {
+		if (perr != NULL) {
+			*perr = err;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+int ctdb_migrate_records(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+			 struct ctdb_client_context *client,
+			 struct ctdb_db_context *db,
+			 TDB_DATA *keys, unsigned int num_keys)
+{
+	struct tevent_req *req;
+	int ret;
+	bool status;
+
+	req = ctdb_migrate_records_send(mem_ctx, ev, client, db,
+					keys, num_keys);
+	if (req == NULL) {
+		return ENOMEM;
+	}
+
+	tevent_req_poll(req, ev);
+
+	status = ctdb_migrate_records_recv(req, &ret);
+	talloc_free(req);
+	if (! status) {
+		return ret;
+	}
+
+	return 0;
+}
+
 int ctdb_store_record(struct ctdb_record_handle *h, TDB_DATA data)
 {
 	uint8_t header[sizeof(struct ctdb_ltdb_header)];
@@ -2098,16 +2537,42 @@ bool ctdb_g_lock_unlock_recv(struct tevent_req *req, int *perr)
 /*
  * Persistent database functions
  */
+
+/*
+ * A commit releases the g_lock of the database as soon as its changes
+ * are in the local database, before they have been replicated.  It
+ * leaves a barrier record next to the g_lock, so that the next
+ * transaction waits for those changes to reach the other nodes before
+ * it reads anything.
+ */
+struct ctdb_transaction_barrier {
+	uint64_t seqnum;
+	uint32_t pnn;
+	struct ctdb_trans3_ticket ticket;
+};
+
+static int ctdb_transaction_fetch_db_seqnum(struct ctdb_transaction_handle *h,
+					    uint64_t *seqnum);
+
 struct ctdb_transaction_start_state {
 	struct tevent_context *ev;
 	struct ctdb_client_context *client;
 	struct timeval timeout;
 	struct ctdb_transaction_handle *h;
 	uint32_t destnode;
+	struct ctdb_transaction_barrier barrier;
+	int error;
 };
 
 static void ctdb_transaction_g_lock_attached(struct tevent_req *subreq);
 static void ctdb_transaction_g_lock_done(struct tevent_req *subreq);
+static void ctdb_transaction_barrier_fetched(struct tevent_req *subreq);
+static void ctdb_transaction_barrier_check(struct tevent_req *req);
+static void ctdb_transaction_barrier_waited(struct tevent_req *subreq);
+static void ctdb_transaction_barrier_recovered(struct tevent_req *subreq);
+static void ctdb_transaction_barrier_vnnmap(struct tevent_req *subreq);
+static void ctdb_transaction_start_failed(struct tevent_req *req, int ret);
+static void ctdb_transaction_start_unlocked(struct tevent_req *subreq);
 
 struct tevent_req *ctdb_transaction_start_send(TALLOC_CTX *mem_ctx,
 					       struct tevent_context *ev,
@@ -2133,6 +2598,7 @@ struct tevent_req *ctdb_transaction_start_send(TALLOC_CTX *mem_ctx,
 
 	state->ev = ev;
 	state->client = client;
+	state->timeout = timeout;
 	state->destnode = ctdb_client_pnn(client);
 
 	h = talloc_zero(db, struct ctdb_transaction_handle);
@@ -2150,57 +2616,313 @@ struct tevent_req *ctdb_transaction_start_send(TALLOC_CTX *mem_ctx,
 	 * active for multiple databases */
 	h->sid = ctdb_client_get_server_id(client, db->db_id);
 
-	h->recbuf = ctdb_rec_buffer_init(h, db->db_id);
-	if (tevent_req_nomem(h->recbuf, req)) {
-		return tevent_req_post(req, ev);
+	h->recbuf = ctdb_rec_buffer_init(h, db->db_id);
+	if (tevent_req_nomem(h->recbuf, req)) {
+		return tevent_req_post(req, ev);
+	}
+
+	h->lock_name = talloc_asprintf(h, "transaction_db_0x%08x", db->db_id);
+	if (tevent_req_nomem(h->lock_name, req)) {
+		return tevent_req_post(req, ev);
+	}
+
+	h->barrier_name = talloc_asprintf(h, "%s_barrier", h->lock_name);
+	if (tevent_req_nomem(h->barrier_name, req)) {
+		return tevent_req_post(req, ev);
+	}
+
+	state->h = h;
+
+	subreq = ctdb_attach_send(state, ev, client, timeout, "g_lock.tdb", 0);
+	if (tevent_req_nomem(subreq, req)) {
+		return tevent_req_post(req, ev);
+	}
+	tevent_req_set_callback(subreq, ctdb_transaction_g_lock_attached, req);
+
+	return req;
+}
+
+static void ctdb_transaction_g_lock_attached(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_start_state *state = tevent_req_data(
+		req, struct ctdb_transaction_start_state);
+	bool status;
+	int ret;
+
+	status = ctdb_attach_recv(subreq, &ret, &state->h->db_g_lock);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		DEBUG(DEBUG_ERR,
+		      ("transaction_start: %s attach g_lock.tdb failed\n",
+		       state->h->db->db_name));
+		tevent_req_error(req, ret);
+		return;
+	}
+
+	subreq = ctdb_g_lock_lock_send(state, state->ev, state->client,
+				       state->h->db_g_lock,
+				       state->h->lock_name,
+				       &state->h->sid, state->h->readonly);
+	if (tevent_req_nomem(subreq, req)) {
+		return;
+	}
+	tevent_req_set_callback(subreq, ctdb_transaction_g_lock_done, req);
+}
+
+static void ctdb_transaction_g_lock_done(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_start_state *state = tevent_req_data(
+		req, struct ctdb_transaction_start_state);
+	int ret;
+	bool status;
+
+	TDB_DATA key;
+
+	status = ctdb_g_lock_lock_recv(subreq, &ret);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		DEBUG(DEBUG_ERR,
+		      ("transaction_start: %s g_lock lock failed, ret=%d\n",
+		       state->h->db->db_name, ret));
+		tevent_req_error(req, ret);
+		return;
+	}
+
+	key.dptr = discard_const(state->h->barrier_name);
+	key.dsize = strlen(state->h->barrier_name) + 1;
+
+	subreq = ctdb_fetch_lock_send(state, state->ev, state->client,
+				      state->h->db_g_lock, key, false);
+	if (subreq == NULL) {
+		ctdb_transaction_start_failed(req, ENOMEM);
+		return;
+	}
+	tevent_req_set_callback(subreq, ctdb_transaction_barrier_fetched, req);
+}
+
+static void ctdb_transaction_barrier_fetched(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_start_state *state = tevent_req_data(
+		req, struct ctdb_transaction_start_state);
+	struct ctdb_record_handle *h;
+	TDB_DATA data;
+	int ret;
+
+	h = ctdb_fetch_lock_recv(subreq, NULL, state, &data, &ret);
+	TALLOC_FREE(subreq);
+	if (h == NULL) {
+		DEBUG(DEBUG_ERR,
+		      ("transaction_start: %s barrier fetch failed, ret=%d\n",
+		       state->h->db->db_name, ret));
+		ctdb_transaction_start_failed(req, ret);
+		return;
+	}
+	talloc_free(h);
+
+	if (data.dsize != sizeof(state->barrier)) {
+		/* No commit has left a barrier */
+		talloc_free(data.dptr);
+		tevent_req_done(req);
+		return;
+	}
+
+	memcpy(&state->barrier, data.dptr, sizeof(state->barrier));
+	talloc_free(data.dptr);
+
+	if (state->barrier.pnn == state->destnode) {
+		/* Commits are written locally before the barrier */
+		tevent_req_done(req);
+		return;
+	}
+
+	ctdb_transaction_barrier_check(req);
+}
+
+/*
+ * Wait until the last commit has been written on all nodes, unless the
+ * local database already has it
+ */
+static void ctdb_transaction_barrier_check(struct tevent_req *req)
+{
+	struct ctdb_transaction_start_state *state = tevent_req_data(
+		req, struct ctdb_transaction_start_state);
+	struct ctdb_req_control request;
+	struct tevent_req *subreq;
+	uint64_t seqnum;
+	int ret;
+
+	ret = ctdb_transaction_fetch_db_seqnum(state->h, &seqnum);
+	if (ret != 0) {
+		ctdb_transaction_start_failed(req, ret);
+		return;
+	}
+
+	if (seqnum >= state->barrier.seqnum) {
+		tevent_req_done(req);
+		return;
+	}
+
+	ctdb_req_control_trans3_commit_wait(&request, &state->barrier.ticket);
+	subreq = ctdb_client_control_send(state, state->ev, state->client,
+					  state->barrier.pnn, state->timeout,
+					  &request);
+	if (subreq == NULL) {
+		ctdb_transaction_start_failed(req, ENOMEM);
+		return;
+	}
+	tevent_req_set_callback(subreq, ctdb_transaction_barrier_waited, req);
+}
+
+static void ctdb_transaction_barrier_waited(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_start_state *state = tevent_req_data(
+		req, struct ctdb_transaction_start_state);
+	struct ctdb_reply_control *reply;
+	struct ctdb_req_control request;
+	int ret;
+	bool status;
+
+	status = ctdb_client_control_recv(subreq, &ret, state, &reply);
+	TALLOC_FREE(subreq);
+	if (status) {
+		ret = ctdb_reply_control_trans3_commit_wait(reply);
+		talloc_free(reply);
+		if (ret == 0) {
+			tevent_req_done(req);
+			return;
+		}
 	}
 
-	h->lock_name = talloc_asprintf(h, "transaction_db_0x%08x", db->db_id);
-	if (tevent_req_nomem(h->lock_name, req)) {
-		return tevent_req_post(req, ev);
+	/*
+	 * The node that made the commit is gone, or a recovery ended the
+	 * wait.  Once a recovery has made the database the same on all
+	 * nodes, the generation changes and there is nothing left to
+	 * wait for.  The local node holds the reply for a ticket of
+	 * another node until the end of the next recovery.
+	 */
+	DEBUG(DEBUG_INFO,
+	      ("transaction_start: %s wait for commit on node %u failed\n",
+	       state->h->db->db_name, state->barrier.pnn));
+
+	ctdb_req_control_trans3_commit_wait(&request, &state->barrier.ticket);
+	subreq = ctdb_client_control_send(state, state->ev, state->client,
+					  state->destnode, tevent_timeval_zero(),
+					  &request);
+	if (subreq == NULL) {
+		ctdb_transaction_start_failed(req, ENOMEM);
+		return;
 	}
+	tevent_req_set_callback(subreq, ctdb_transaction_barrier_recovered,
+				req);
+}
 
-	state->h = h;
+static void ctdb_transaction_barrier_recovered(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_start_state *state = tevent_req_data(
+		req, struct ctdb_transaction_start_state);
+	struct ctdb_reply_control *reply;
+	struct ctdb_req_control request;
+	int ret;
+	bool status;
 
-	subreq = ctdb_attach_send(state, ev, client, timeout, "g_lock.tdb", 0);
-	if (tevent_req_nomem(subreq, req)) {
-		return tevent_req_post(req, ev);
+	status = ctdb_client_control_recv(subreq, &ret, state, &reply);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		DEBUG(DEBUG_ERR,
+		      ("transaction_start: %s TRANS3_COMMIT_WAIT failed, "
+		       "ret=%d\n", state->h->db->db_name, ret));
+		ctdb_transaction_start_failed(req, ret);
+		return;
 	}
-	tevent_req_set_callback(subreq, ctdb_transaction_g_lock_attached, req);
 
-	return req;
+	/* Status 2 means the wait was ended by the recovery */
+	ret = ctdb_reply_control_trans3_commit_wait(reply);
+	talloc_free(reply);
+	if (ret != 0 && ret != 2) {
+		ctdb_transaction_start_failed(req, EIO);
+		return;
+	}
+
+	ctdb_req_control_getvnnmap(&request);
+	subreq = ctdb_client_control_send(state, state->ev, state->client,
+					  state->destnode, state->timeout,
+					  &request);
+	if (subreq == NULL) {
+		ctdb_transaction_start_failed(req, ENOMEM);
+		return;
+	}
+	tevent_req_set_callback(subreq, ctdb_transaction_barrier_vnnmap, req);
 }
 
-static void ctdb_transaction_g_lock_attached(struct tevent_req *subreq)
+static void ctdb_transaction_barrier_vnnmap(struct tevent_req *subreq)
 {
 	struct tevent_req *req = tevent_req_callback_data(
 		subreq, struct tevent_req);
 	struct ctdb_transaction_start_state *state = tevent_req_data(
 		req, struct ctdb_transaction_start_state);
-	bool status;
+	struct ctdb_reply_control *reply;
+	struct ctdb_vnn_map *vnnmap;
 	int ret;
+	bool status;
 
-	status = ctdb_attach_recv(subreq, &ret, &state->h->db_g_lock);
+	status = ctdb_client_control_recv(subreq, &ret, state, &reply);
 	TALLOC_FREE(subreq);
 	if (! status) {
 		DEBUG(DEBUG_ERR,
-		      ("transaction_start: %s attach g_lock.tdb failed\n",
-		       state->h->db->db_name));
-		tevent_req_error(req, ret);
+		      ("transaction_start: %s GETVNNMAP failed, ret=%d\n",
+		       state->h->db->db_name, ret));
+		ctdb_transaction_start_failed(req, ret);
 		return;
 	}
 
-	subreq = ctdb_g_lock_lock_send(state, state->ev, state->client,
-				       state->h->db_g_lock,
-				       state->h->lock_name,
-				       &state->h->sid, state->h->readonly);
+	ret = ctdb_reply_control_getvnnmap(reply, state, &vnnmap);
+	talloc_free(reply);
+	if (ret != 0) {
+		ctdb_transaction_start_failed(req, ret);
+		return;
+	}
+
+	if (vnnmap->generation != state->barrier.ticket.generation) {
+		talloc_free(vnnmap);
+		tevent_req_done(req);
+		return;
+	}
+	talloc_free(vnnmap);
+
+	ctdb_transaction_barrier_check(req);
+}
+
+/*
+ * Drop the g_lock when the transaction could not be started after all
+ */
+static void ctdb_transaction_start_failed(struct tevent_req *req, int ret)
+{
+	struct ctdb_transaction_start_state *state = tevent_req_data(
+		req, struct ctdb_transaction_start_state);
+	struct ctdb_transaction_handle *h = state->h;
+	struct tevent_req *subreq;
+
+	state->error = ret;
+
+	subreq = ctdb_g_lock_unlock_send(state, state->ev, h->client,
+					 h->db_g_lock, h->lock_name, h->sid);
 	if (tevent_req_nomem(subreq, req)) {
 		return;
 	}
-	tevent_req_set_callback(subreq, ctdb_transaction_g_lock_done, req);
+	tevent_req_set_callback(subreq, ctdb_transaction_start_unlocked, req);
 }
 
-static void ctdb_transaction_g_lock_done(struct tevent_req *subreq)
+static void ctdb_transaction_start_unlocked(struct tevent_req *subreq)
 {
 	struct tevent_req *req = tevent_req_callback_data(
 		subreq, struct tevent_req);
@@ -2209,17 +2931,16 @@ static void ctdb_transaction_g_lock_done(struct tevent_req *subreq)
 	int ret;
 	bool status;
 
-	status = ctdb_g_lock_lock_recv(subreq, &ret);
+	status = ctdb_g_lock_unlock_recv(subreq, &ret);
 	TALLOC_FREE(subreq);
 	if (! status) {
 		DEBUG(DEBUG_ERR,
-		      ("transaction_start: %s g_lock lock failed, ret=%d\n",
+		      ("transaction_start: %s g_lock unlock failed, ret=%d\n",
 		       state->h->db->db_name, ret));
-		tevent_req_error(req, ret);
-		return;
 	}
 
-	tevent_req_done(req);
+	TALLOC_FREE(state->h);
+	tevent_req_error(req, state->error);
 }
 
 struct ctdb_transaction_handle *ctdb_transaction_start_recv(
@@ -2470,11 +3191,26 @@ struct ctdb_transaction_commit_state {
 	struct timeval timeout;
 	struct ctdb_transaction_handle *h;
 	uint64_t seqnum;
+	struct ctdb_trans3_ticket *ticket;
+	bool barrier, waited, unlocked;
 };
 
+static void ctdb_transaction_commit_started(struct tevent_req *subreq);
+static void ctdb_transaction_commit_legacy(struct tevent_req *req);
 static void ctdb_transaction_commit_done(struct tevent_req *subreq);
+static void ctdb_transaction_commit_barrier(struct tevent_req *subreq);
+static void ctdb_transaction_commit_next(struct tevent_req *req);
+static void ctdb_transaction_commit_waited(struct tevent_req *subreq);
 static void ctdb_transaction_commit_g_lock_done(struct tevent_req *subreq);
 
+/*
+ * The commit is written to the local database with TRANS3_COMMIT_START,
+ * which replies before the other nodes have the changes.  The g_lock is
+ * released after leaving a barrier for the next transaction, and then
+ * the commit waits with TRANS3_COMMIT_WAIT until its own changes have
+ * been replicated.  ctdbd replicates the commits of all its clients in
+ * groups, so many writers share the cost of the round trips.
+ */
 struct tevent_req *ctdb_transaction_commit_send(
 					TALLOC_CTX *mem_ctx,
 					struct tevent_context *ev,
@@ -2508,18 +3244,240 @@ struct tevent_req *ctdb_transaction_commit_send(
 		return tevent_req_post(req, ev);
 	}
 
-	ctdb_req_control_trans3_commit(&request, h->recbuf);
+	ctdb_req_control_trans3_commit_start(&request, h->recbuf);
 	subreq = ctdb_client_control_send(state, ev, h->client,
 					  ctdb_client_pnn(h->client),
 					  timeout, &request);
 	if (tevent_req_nomem(subreq, req)) {
 		return tevent_req_post(req, ev);
 	}
-	tevent_req_set_callback(subreq, ctdb_transaction_commit_done, req);
+	tevent_req_set_callback(subreq, ctdb_transaction_commit_started, req);
 
 	return req;
 }
 
+static void ctdb_transaction_commit_started(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_commit_state *state = tevent_req_data(
+		req, struct ctdb_transaction_commit_state);
+	struct ctdb_transaction_handle *h = state->h;
+	struct ctdb_reply_control *reply;
+	uint64_t seqnum;
+	TDB_DATA key;
+	int ret;
+	bool status;
+
+	status = ctdb_client_control_recv(subreq, &ret, state, &reply);
+	TALLOC_FREE(subreq);
+	if (! status) {
+		DEBUG(DEBUG_ERR,
+		      ("transaction_commit: %s TRANS3_COMMIT_START failed, "
+		       "ret=%d\n", h->db->db_name, ret));
+		tevent_req_error(req, ret);
+		return;
+	}
+
+	ret = ctdb_reply_control_trans3_commit_start(reply, state,
+						     &state->ticket);
+	talloc_free(reply);
+
+	if (ret != 0) {
+		/*
+		 * Control failed due to recovery, or ctdbd does not
+		 * support it
+		 */
+		ret = ctdb_transaction_fetch_db_seqnum(h, &seqnum);
+		if (ret != 0) {
+			tevent_req_error(req, ret);
+			return;
+		}
+
+		if (seqnum == state->seqnum) {
+			ctdb_transaction_commit_legacy(req);
+			return;
+		}
+
+		if (seqnum != state->seqnum + 1) {
+			DEBUG(DEBUG_ERR,
+			      ("transaction_commit: %s seqnum mismatch "
+			       "0x%"PRIx64" != 0x%"PRIx64" + 1\n",
+			       h->db->db_name, seqnum, state->seqnum));
+			tevent_req_error(req, EIO);
+			return;
+		}
+
+		/* The recovery has written the commit on all nodes */
+		state->waited = true;
+		ctdb_transaction_commit_next(req);
+		return;
+	}
+
+	key.dptr = discard_const(h->barrier_name);
+	key.dsize = strlen(h->barrier_name) + 1;
+
+	subreq = ctdb_fetch_lock_send(state, state->ev, h->client,
+				      h->db_g_lock, key, false);
+	if (tevent_req_nomem(subreq, req)) {
+		return;
+	}
+	tevent_req_set_callback(subreq, ctdb_transaction_commit_barrier, req);
+}
+
+static void ctdb_transaction_commit_barrier(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_commit_state *state = tevent_req_data(
+		req, struct ctdb_transaction_commit_state);
+	struct ctdb_transaction_handle *h = state->h;
+	struct ctdb_record_handle *rh;
+	struct ctdb_transaction_barrier barrier;
+	TDB_DATA data;
+	int ret;
+
+	rh = ctdb_fetch_lock_recv(subreq, NULL, state, NULL, &ret);
+	TALLOC_FREE(subreq);
+	if (rh == NULL) {
+		DEBUG(DEBUG_ERR,
+		      ("transaction_commit: %s barrier fetch failed, ret=%d\n",
+		       h->db->db_name, ret));
+		ctdb_transaction_commit_next(req);
+		return;
+	}
+
+	barrier.seqnum = state->seqnum + 1;
+	barrier.pnn = ctdb_client_pnn(h->client);
+	barrier.ticket = *state->ticket;
+
+	data.dptr = (uint8_t *)&barrier;
+	data.dsize = sizeof(barrier);
+
+	ret = ctdb_store_record(rh, data);
+	talloc_free(rh);
+	if (ret != 0) {
+		DEBUG(DEBUG_ERR,
+		      ("transaction_commit: %s barrier store failed, ret=%d\n",
+		       h->db->db_name, ret));
+		ctdb_transaction_commit_next(req);
+		return;
+	}
+
+	state->barrier = true;
+	ctdb_transaction_commit_next(req);
+}
+
+/*
+ * Without a barrier, the g_lock is held until the commit has been
+ * replicated, as with TRANS3_COMMIT
+ */
+static void ctdb_transaction_commit_next(struct tevent_req *req)
+{
+	struct ctdb_transaction_commit_state *state = tevent_req_data(
+		req, struct ctdb_transaction_commit_state);
+	struct ctdb_transaction_handle *h = state->h;
+	struct ctdb_req_control request;
+	struct tevent_req *subreq;
+
+	if (! state->unlocked && (state->waited || state->barrier)) {
+		subreq = ctdb_g_lock_unlock_send(state, state->ev, h->client,
+						 h->db_g_lock, h->lock_name,
+						 h->sid);
+		if (tevent_req_nomem(subreq, req)) {
+			return;
+		}
+		tevent_req_set_callback(subreq,
+					ctdb_transaction_commit_g_lock_done,
+					req);
+		return;
+	}
+
+	if (! state->waited) {
+		ctdb_req_control_trans3_commit_wait(&request, state->ticket);
+		subreq = ctdb_client_control_send(state, state->ev, h->client,
+						  ctdb_client_pnn(h->client),
+						  state->timeout, &request);
+		if (tevent_req_nomem(subreq, req)) {
+			return;
+		}
+		tevent_req_set_callback(subreq,
+					ctdb_transaction_commit_waited, req);
+		return;
+	}
+
+	talloc_free(state->h);
+	tevent_req_done(req);
+}
+
+static void ctdb_transaction_commit_waited(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct ctdb_transaction_commit_state *state = tevent_req_data(
+		req, struct ctdb_transaction_commit_state);
+	struct ctdb_transaction_handle *h = state->h;
+	struct ctdb_reply_control *reply;
+	uint64_t seqnum;
+	int ret;
+	bool status;
+
+	status = ctdb_client_control_recv(subreq, &ret, state, &reply);
+	TALLOC_FREE(subreq);
+	if (status) {
+		ret = ctdb_reply_control_trans3_commit_wait(reply);
+		talloc_free(reply);
+	}
+
+	if (! status || ret != 0) {
+		/*
+		 * Replication was ended by a recovery.  The recovery
+		 * keeps the database with the highest sequence number,
+		 * so the commit made it if it is still in the local
+		 * database.
+		 */
+		ret = ctdb_transaction_fetch_db_seqnum(h, &seqnum);
+		if (ret != 0) {
+			tevent_req_error(req, ret);
+			return;
+		}
+
+		if (seqnum < state->seqnum + 1) {
+			DEBUG(DEBUG_ERR,
+			      ("transaction_commit: %s seqnum mismatch "
+			       "0x%"PRIx64" < 0x%"PRIx64" + 1\n",
+			       h->db->db_name, seqnum, state->seqnum));
+			tevent_req_error(req, EIO);
+			return;
+		}
+	}
+
+	state->waited = true;
+	ctdb_transaction_commit_next(req);
+}
+
+/*
+ * ctdbd does not support TRANS3_COMMIT_START, or a recovery was
+ * running.  Commit with TRANS3_COMMIT, which replies once the commit
+ * has been written on all nodes.
+ */
+static void ctdb_transaction_commit_legacy(struct tevent_req *req)
+{
+	struct ctdb_transaction_commit_state *state = tevent_req_data(
+		req, struct ctdb_transaction_commit_state);
+	struct ctdb_req_control request;
+	struct tevent_req *subreq;
+
+	ctdb_req_control_trans3_commit(&request, state->h->recbuf);
+	subreq = ctdb_client_control_send(state, state->ev, state->h->client,
+					  ctdb_client_pnn(state->h->client),
+					  state->timeout, &request);
+	if (tevent_req_nomem(subreq, req)) {
+		return;
+	}
+	tevent_req_set_callback(subreq, ctdb_transaction_commit_done, req);
+}
+
 static void ctdb_transaction_commit_done(struct tevent_req *subreq)
 {
 	struct tevent_req *req = tevent_req_callback_data(
@@ -2555,21 +3513,8 @@ static void ctdb_transaction_commit_done(struct tevent_req *subreq)
 		}
 
 		if (seqnum == state->seqnum) {
-			struct ctdb_req_control request;
-
 			/* try again */
-			ctdb_req_control_trans3_commit(&request,
-						       state->h->recbuf);
-			subreq = ctdb_client_control_send(
-					state, state->ev, state->h->client,
-					ctdb_client_pnn(state->h->client),
-					state->timeout, &request);
-			if (tevent_req_nomem(subreq, req)) {
-				return;
-			}
-			tevent_req_set_callback(subreq,
-						ctdb_transaction_commit_done,
-						req);
+			ctdb_transaction_commit_legacy(req);
 			return;
 		}
 
@@ -2584,13 +3529,8 @@ static void ctdb_transaction_commit_done(struct tevent_req *subreq)
 	}
 
 	/* trans3_commit successful */
-	subreq = ctdb_g_lock_unlock_send(state, state->ev, h->client,
-					 h->db_g_lock, h->lock_name, h->sid);
-	if (tevent_req_nomem(subreq, req)) {
-		return;
-	}
-	tevent_req_set_callback(subreq, ctdb_transaction_commit_g_lock_done,
-				req);
+	state->waited = true;
+	ctdb_transaction_commit_next(req);
 }
 
 static void ctdb_transaction_commit_g_lock_done(struct tevent_req *subreq)
@@ -2612,8 +3552,8 @@ static void ctdb_transaction_commit_g_lock_done(struct tevent_req *subreq)
 		return;
 	}
 
-	talloc_free(state->h);
-	tevent_req_done(req);
+	state->unlocked = true;
+	ctdb_transaction_commit_next(req);
 }
 
 bool ctdb_transaction_commit_recv(struct tevent_req *req, int *perr)
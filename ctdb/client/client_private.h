@@ -61,6 +61,7 @@ struct ctdb_transaction_handle {
 	struct ctdb_rec_buffer *recbuf;
 	struct ctdb_server_id sid;
 	const char *lock_name;
+	const char *barrier_name;
 	bool readonly;
 	bool updated;
 };
@@ -30,6 +30,8 @@
 
 #include "ctdb_private.h"
 
+#include "protocol/protocol_util.h"
+
 #include "common/common.h"
 #include "common/logging.h"
 
@@ -145,12 +147,8 @@ void ctdb_db_set_sticky(struct ctdb_db_context *ctdb_db)
 */
 uint32_t ctdb_lmaster(struct ctdb_context *ctdb, const TDB_DATA *key)
 {
-	uint32_t idx, lmaster;
-
-	idx = ctdb_hash(key) % ctdb->vnn_map->size;
-	lmaster = ctdb->vnn_map->map[idx];
-
-	return lmaster;
+	return ctdb_vnn_map_lmaster(ctdb->vnn_map, ctdb_hash(key),
+				    ctdb->lmaster_consistent);
 }
 
 
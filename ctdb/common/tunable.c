@@ -157,6 +157,10 @@ static struct {
 		offsetof(struct ctdb_tunable_list, ip_alloc_algorithm) },
 	{ "AllowMixedVersions", 0, false,
 		offsetof(struct ctdb_tunable_list, allow_mixed_versions) },
+	{ "ConsistentLMaster", 0, false,
+		offsetof(struct ctdb_tunable_list, consistent_lmaster) },
+	{ "TraverseWindow", 4, false,
+		offsetof(struct ctdb_tunable_list, traverse_window) },
 	{ NULL, 0, true, }
 };
 
@@ -296,6 +296,7 @@ struct ctdb_context {
 #define MAX_STAT_HISTORY 100
 	struct ctdb_statistics statistics_history[MAX_STAT_HISTORY];
 	struct ctdb_vnn_map *vnn_map;
+	bool lmaster_consistent; /* latched from tunable with vnn_map */
 	uint32_t num_clients;
 	uint32_t recovery_master;
 	struct ctdb_client_ip *client_ip_list;
@@ -358,6 +359,7 @@ struct ctdb_db_context {
 	int pending_requests;
 	struct revokechild_handle *revokechild_active;
 	struct ctdb_persistent_state *persistent_state;
+	struct ctdb_persistent_queue *persistent_queue;
 	struct trbt_tree *delete_queue;
 	struct trbt_tree *sticky_records; 
 	int (*ctdb_ltdb_store_fn)(struct ctdb_db_context *ctdb_db,
@@ -765,6 +767,12 @@ void ctdb_persistent_finish_trans3_commits(struct ctdb_context *ctdb);
 int32_t ctdb_control_trans3_commit(struct ctdb_context *ctdb,
 				   struct ctdb_req_control_old *c,
 				   TDB_DATA recdata, bool *async_reply);
+int32_t ctdb_control_trans3_commit_start(struct ctdb_context *ctdb,
+					 struct ctdb_req_control_old *c,
+					 TDB_DATA recdata, bool *async_reply);
+int32_t ctdb_control_trans3_commit_wait(struct ctdb_context *ctdb,
+					struct ctdb_req_control_old *c,
+					TDB_DATA indata, bool *async_reply);
 
 int32_t ctdb_control_start_persistent_update(struct ctdb_context *ctdb,
 					     struct ctdb_req_control_old *c,
@@ -953,6 +961,12 @@ int32_t ctdb_control_traverse_start_ext(struct ctdb_context *ctdb,
 int32_t ctdb_control_traverse_start(struct ctdb_context *ctdb,
 				    TDB_DATA indata, TDB_DATA *outdata,
 				    uint32_t srcnode, uint32_t client_id);
+int32_t ctdb_control_traverse_start_stream(struct ctdb_context *ctdb,
+					   TDB_DATA indata, TDB_DATA *outdata,
+					   uint32_t srcnode,
+					   uint32_t client_id);
+int32_t ctdb_control_traverse_all_stream(struct ctdb_context *ctdb,
+					 TDB_DATA indata, TDB_DATA *outdata);
 
 /* from ctdb_tunables.c */
 
@@ -249,6 +249,31 @@ struct ctdb_marshall_buffer {
 	uint8_t data[1];
 };
 
+/*
+  structures used to start a streaming traverse, on the wire the
+  optional key prefix follows the fixed fields
+ */
+struct ctdb_traverse_start_stream_old {
+	uint32_t db_id;
+	uint32_t reqid;
+	uint64_t srvid;
+	bool withemptyrecords;
+	uint32_t prefix_len;
+	uint8_t prefix[1];
+};
+
+struct ctdb_traverse_all_stream_old {
+	uint32_t db_id;
+	uint32_t reqid;
+	uint32_t pnn;
+	uint32_t client_reqid;
+	uint64_t srvid;
+	uint32_t window;
+	bool withemptyrecords;
+	uint32_t prefix_len;
+	uint8_t prefix[1];
+};
+
 /*
   structure for setting a tunable
  */
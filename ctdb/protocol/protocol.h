@@ -125,6 +125,12 @@ struct ctdb_call {
 /* SRVID to assign of banning credits */
 #define CTDB_SRVID_BANNING	0xF002000000000000LL
 
+/* SRVID prefix used by streaming traverse for record batches */
+#define CTDB_SRVID_TRAVERSE_DATA	0xF003000000000000LL
+
+/* SRVID prefix used by streaming traverse to return batch credits */
+#define CTDB_SRVID_TRAVERSE_CREDIT	0xF004000000000000LL
+
 /* SRVID to inform of election data */
 #define CTDB_SRVID_ELECTION	0xF100000000000000LL
 
@@ -373,6 +379,10 @@ enum ctdb_controls {CTDB_CONTROL_PROCESS_EXISTS          = 0,
 		    CTDB_CONTROL_CHECK_PID_SRVID         = 151,
 		    CTDB_CONTROL_TUNNEL_REGISTER         = 152,
 		    CTDB_CONTROL_TUNNEL_DEREGISTER       = 153,
+		    CTDB_CONTROL_TRAVERSE_START_STREAM   = 154,
+		    CTDB_CONTROL_TRAVERSE_ALL_STREAM     = 155,
+		    CTDB_CONTROL_TRANS3_COMMIT_START     = 156,
+		    CTDB_CONTROL_TRANS3_COMMIT_WAIT      = 157,
 };
 
 #define MAX_COUNT_BUCKETS 16
@@ -554,6 +564,25 @@ struct ctdb_traverse_all_ext {
 	bool withemptyrecords;
 };
 
+struct ctdb_traverse_start_stream {
+	uint32_t db_id;
+	uint32_t reqid;
+	uint64_t srvid;
+	bool withemptyrecords;
+	TDB_DATA prefix;
+};
+
+struct ctdb_traverse_all_stream {
+	uint32_t db_id;
+	uint32_t reqid;
+	uint32_t pnn;
+	uint32_t client_reqid;
+	uint64_t srvid;
+	uint32_t window;
+	bool withemptyrecords;
+	TDB_DATA prefix;
+};
+
 typedef union {
 	struct sockaddr sa;
 	struct sockaddr_in ip;
@@ -656,6 +685,8 @@ struct ctdb_tunable_list {
 	uint32_t queue_buffer_size;
 	uint32_t ip_alloc_algorithm;
 	uint32_t allow_mixed_versions;
+	uint32_t consistent_lmaster;
+	uint32_t traverse_window;
 };
 
 struct ctdb_tickle_list {
@@ -675,6 +706,13 @@ struct ctdb_transdb {
 	uint32_t tid;
 };
 
+struct ctdb_trans3_ticket {
+	uint32_t db_id;
+	uint32_t generation;
+	uint32_t tid;
+	uint32_t pnn;
+};
+
 struct ctdb_uptime {
 	struct timeval current_time;
 	struct timeval ctdbd_start_time;
@@ -888,6 +926,9 @@ struct ctdb_req_control_data {
 		struct ctdb_traverse_start_ext *traverse_start_ext;
 		struct ctdb_traverse_all_ext *traverse_all_ext;
 		struct ctdb_pid_srvid *pid_srvid;
+		struct ctdb_traverse_start_stream *traverse_start_stream;
+		struct ctdb_traverse_all_stream *traverse_all_stream;
+		struct ctdb_trans3_ticket *ticket;
 	} data;
 };
 
@@ -923,6 +964,7 @@ struct ctdb_reply_control_data {
 		enum ctdb_runstate runstate;
 		uint32_t num_records;
 		int tdb_flags;
+		struct ctdb_trans3_ticket *ticket;
 	} data;
 };
 
@@ -609,6 +609,21 @@ void ctdb_req_control_tunnel_deregister(struct ctdb_req_control *request,
 					uint64_t tunnel_id);
 int ctdb_reply_control_tunnel_deregister(struct ctdb_reply_control *reply);
 
+void ctdb_req_control_traverse_start_stream(
+			struct ctdb_req_control *request,
+			struct ctdb_traverse_start_stream *traverse);
+int ctdb_reply_control_traverse_start_stream(struct ctdb_reply_control *reply);
+
+void ctdb_req_control_trans3_commit_start(struct ctdb_req_control *request,
+					  struct ctdb_rec_buffer *recbuf);
+int ctdb_reply_control_trans3_commit_start(struct ctdb_reply_control *reply,
+					   TALLOC_CTX *mem_ctx,
+					   struct ctdb_trans3_ticket **ticket);
+
+void ctdb_req_control_trans3_commit_wait(struct ctdb_req_control *request,
+					 struct ctdb_trans3_ticket *ticket);
+int ctdb_reply_control_trans3_commit_wait(struct ctdb_reply_control *reply);
+
 /* From protocol/protocol_debug.c */
 
 void ctdb_packet_print(uint8_t *buf, size_t buflen, FILE *fp);
@@ -2371,3 +2371,75 @@ int ctdb_reply_control_tunnel_deregister(struct ctdb_reply_control *reply)
 
 	return reply->status;
 }
+
+/* CTDB_CONTROL_TRAVERSE_START_STREAM */
+
+void ctdb_req_control_traverse_start_stream(
+			struct ctdb_req_control *request,
+			struct ctdb_traverse_start_stream *traverse)
+{
+	request->opcode = CTDB_CONTROL_TRAVERSE_START_STREAM;
+	request->pad = 0;
+	request->srvid = 0;
+	request->client_id = 0;
+	request->flags = 0;
+
+	request->rdata.opcode = CTDB_CONTROL_TRAVERSE_START_STREAM;
+	request->rdata.data.traverse_start_stream = traverse;
+}
+
+int ctdb_reply_control_traverse_start_stream(struct ctdb_reply_control *reply)
+{
+	return ctdb_reply_control_generic(reply,
+					  CTDB_CONTROL_TRAVERSE_START_STREAM);
+}
+
+/* CTDB_CONTROL_TRANS3_COMMIT_START */
+
+void ctdb_req_control_trans3_commit_start(struct ctdb_req_control *request,
+					  struct ctdb_rec_buffer *recbuf)
+{
+	request->opcode = CTDB_CONTROL_TRANS3_COMMIT_START;
+	request->pad = 0;
+	request->srvid = 0;
+	request->client_id = 0;
+	request->flags = 0;
+
+	request->rdata.opcode = CTDB_CONTROL_TRANS3_COMMIT_START;
+	request->rdata.data.recbuf = recbuf;
+}
+
+int ctdb_reply_control_trans3_commit_start(struct ctdb_reply_control *reply,
+					   TALLOC_CTX *mem_ctx,
+					   struct ctdb_trans3_ticket **ticket)
+{
+	if (reply->rdata.opcode != CTDB_CONTROL_TRANS3_COMMIT_START) {
+		return EPROTO;
+	}
+
+	if (reply->status == 0) {
+		*ticket = talloc_steal(mem_ctx, reply->rdata.data.ticket);
+	}
+	return reply->status;
+}
+
+/* CTDB_CONTROL_TRANS3_COMMIT_WAIT */
+
+void ctdb_req_control_trans3_commit_wait(struct ctdb_req_control *request,
+					 struct ctdb_trans3_ticket *ticket)
+{
+	request->opcode = CTDB_CONTROL_TRANS3_COMMIT_WAIT;
+	request->pad = 0;
+	request->srvid = 0;
+	request->client_id = 0;
+	request->flags = 0;
+
+	request->rdata.opcode = CTDB_CONTROL_TRANS3_COMMIT_WAIT;
+	request->rdata.data.ticket = ticket;
+}
+
+int ctdb_reply_control_trans3_commit_wait(struct ctdb_reply_control *reply)
+{
+	return ctdb_reply_control_generic(reply,
+					  CTDB_CONTROL_TRANS3_COMMIT_WAIT);
+}
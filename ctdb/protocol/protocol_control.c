@@ -426,6 +426,24 @@ static size_t ctdb_req_control_data_len(struct ctdb_req_control_data *cd)
 
 	case CTDB_CONTROL_TUNNEL_DEREGISTER:
 		break;
+
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		len = ctdb_traverse_start_stream_len(
+				cd->data.traverse_start_stream);
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		len = ctdb_traverse_all_stream_len(
+				cd->data.traverse_all_stream);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		len = ctdb_rec_buffer_len(cd->data.recbuf);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		len = ctdb_trans3_ticket_len(cd->data.ticket);
+		break;
 	}
 
 	return len;
@@ -711,6 +729,24 @@ static void ctdb_req_control_data_push(struct ctdb_req_control_data *cd,
 	case CTDB_CONTROL_CHECK_PID_SRVID:
 		ctdb_pid_srvid_push(cd->data.pid_srvid, buf, &np);
 		break;
+
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		ctdb_traverse_start_stream_push(cd->data.traverse_start_stream,
+						buf, &np);
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		ctdb_traverse_all_stream_push(cd->data.traverse_all_stream,
+					      buf, &np);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		ctdb_rec_buffer_push(cd->data.recbuf, buf, &np);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		ctdb_trans3_ticket_push(cd->data.ticket, buf, &np);
+		break;
 	}
 
 	*npush = np;
@@ -1046,6 +1082,28 @@ static int ctdb_req_control_data_pull(uint8_t *buf, size_t buflen,
 		ret = ctdb_pid_srvid_pull(buf, buflen, mem_ctx,
 					  &cd->data.pid_srvid, &np);
 		break;
+
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		ret = ctdb_traverse_start_stream_pull(
+				buf, buflen, mem_ctx,
+				&cd->data.traverse_start_stream, &np);
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		ret = ctdb_traverse_all_stream_pull(
+				buf, buflen, mem_ctx,
+				&cd->data.traverse_all_stream, &np);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		ret = ctdb_rec_buffer_pull(buf, buflen, mem_ctx,
+					   &cd->data.recbuf, &np);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		ret = ctdb_trans3_ticket_pull(buf, buflen, mem_ctx,
+					      &cd->data.ticket, &np);
+		break;
 	}
 
 	if (ret != 0) {
@@ -1428,6 +1486,19 @@ static size_t ctdb_reply_control_data_len(struct ctdb_reply_control_data *cd)
 
 	case CTDB_CONTROL_TUNNEL_DEREGISTER:
 		break;
+
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		len = ctdb_trans3_ticket_len(cd->data.ticket);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		break;
 	}
 
 	return len;
@@ -1592,6 +1663,10 @@ static void ctdb_reply_control_data_push(struct ctdb_reply_control_data *cd,
 
 	case CTDB_CONTROL_CHECK_PID_SRVID:
 		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		ctdb_trans3_ticket_push(cd->data.ticket, buf, &np);
+		break;
 	}
 
 	*npush = np;
@@ -1787,6 +1862,11 @@ static int ctdb_reply_control_data_pull(uint8_t *buf, size_t buflen,
 
 	case CTDB_CONTROL_CHECK_PID_SRVID:
 		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		ret = ctdb_trans3_ticket_pull(buf, buflen, mem_ctx,
+					      &cd->data.ticket, &np);
+		break;
 	}
 
 	if (ret != 0) {
@@ -242,6 +242,10 @@ static void ctdb_opcode_print(uint32_t opcode, FILE *fp)
 		{ CTDB_CONTROL_CHECK_PID_SRVID, "CHECK_PID_SRVID" },
 		{ CTDB_CONTROL_TUNNEL_REGISTER, "TUNNEL_REGISTER" },
 		{ CTDB_CONTROL_TUNNEL_DEREGISTER, "TUNNEL_DEREGISTER" },
+		{ CTDB_CONTROL_TRAVERSE_START_STREAM, "TRAVERSE_START_STREAM" },
+		{ CTDB_CONTROL_TRAVERSE_ALL_STREAM, "TRAVERSE_ALL_STREAM" },
+		{ CTDB_CONTROL_TRANS3_COMMIT_START, "TRANS3_COMMIT_START" },
+		{ CTDB_CONTROL_TRANS3_COMMIT_WAIT, "TRANS3_COMMIT_WAIT" },
 		{ MAP_END, "" },
 	};
 
@@ -286,6 +290,12 @@ static void ctdb_srvid_print(uint64_t srvid, FILE *fp)
 	} else if ((srvid & prefix) == CTDB_SRVID_RECOVERY) {
 		srvid = srvid & ~CTDB_SRVID_RECOVERY;
 		fprintf(fp, "RECOVERY-%"PRIx64"", srvid);
+	} else if ((srvid & prefix) == CTDB_SRVID_TRAVERSE_DATA) {
+		srvid = srvid & ~CTDB_SRVID_TRAVERSE_DATA;
+		fprintf(fp, "TRAVERSE_DATA-%"PRIx64"", srvid);
+	} else if ((srvid & prefix) == CTDB_SRVID_TRAVERSE_CREDIT) {
+		srvid = srvid & ~CTDB_SRVID_TRAVERSE_CREDIT;
+		fprintf(fp, "TRAVERSE_CREDIT-%"PRIx64"", srvid);
 	} else if (srvid == CTDB_SRVID_BANNING) {
 		fprintf(fp, "BANNING");
 	} else if (srvid == CTDB_SRVID_ELECTION) {
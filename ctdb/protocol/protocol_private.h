@@ -173,6 +173,22 @@ int ctdb_traverse_all_ext_pull(uint8_t *buf, size_t buflen,
 			       struct ctdb_traverse_all_ext **out,
 			       size_t *npull);
 
+size_t ctdb_traverse_start_stream_len(struct ctdb_traverse_start_stream *in);
+void ctdb_traverse_start_stream_push(struct ctdb_traverse_start_stream *in,
+				     uint8_t *buf, size_t *npush);
+int ctdb_traverse_start_stream_pull(uint8_t *buf, size_t buflen,
+				    TALLOC_CTX *mem_ctx,
+				    struct ctdb_traverse_start_stream **out,
+				    size_t *npull);
+
+size_t ctdb_traverse_all_stream_len(struct ctdb_traverse_all_stream *in);
+void ctdb_traverse_all_stream_push(struct ctdb_traverse_all_stream *in,
+				   uint8_t *buf, size_t *npush);
+int ctdb_traverse_all_stream_pull(uint8_t *buf, size_t buflen,
+				  TALLOC_CTX *mem_ctx,
+				  struct ctdb_traverse_all_stream **out,
+				  size_t *npull);
+
 size_t ctdb_sock_addr_len(ctdb_sock_addr *in);
 void ctdb_sock_addr_push(ctdb_sock_addr *in, uint8_t *buf, size_t *npush);
 int ctdb_sock_addr_pull_elems(uint8_t *buf, size_t buflen,
@@ -233,6 +249,12 @@ void ctdb_transdb_push(struct ctdb_transdb *in, uint8_t *buf, size_t *npush);
 int ctdb_transdb_pull(uint8_t *buf, size_t buflen, TALLOC_CTX *mem_ctx,
 		     struct ctdb_transdb **out, size_t *npull);
 
+size_t ctdb_trans3_ticket_len(struct ctdb_trans3_ticket *in);
+void ctdb_trans3_ticket_push(struct ctdb_trans3_ticket *in, uint8_t *buf,
+			     size_t *npush);
+int ctdb_trans3_ticket_pull(uint8_t *buf, size_t buflen, TALLOC_CTX *mem_ctx,
+			    struct ctdb_trans3_ticket **out, size_t *npull);
+
 size_t ctdb_uptime_len(struct ctdb_uptime *in);
 void ctdb_uptime_push(struct ctdb_uptime *in, uint8_t *buf, size_t *npush);
 int ctdb_uptime_pull(uint8_t *buf, size_t buflen, TALLOC_CTX *mem_ctx,
@@ -2076,6 +2076,231 @@ fail:
 	return ret;
 }
 
+size_t ctdb_traverse_start_stream_len(struct ctdb_traverse_start_stream *in)
+{
+	return ctdb_uint32_len(&in->db_id) +
+		ctdb_uint32_len(&in->reqid) +
+		ctdb_uint64_len(&in->srvid) +
+		ctdb_bool_len(&in->withemptyrecords) +
+		ctdb_padding_len(3) +
+		ctdb_tdb_datan_len(&in->prefix);
+}
+
+void ctdb_traverse_start_stream_push(struct ctdb_traverse_start_stream *in,
+				     uint8_t *buf, size_t *npush)
+{
+	size_t offset = 0, np;
+
+	ctdb_uint32_push(&in->db_id, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->reqid, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint64_push(&in->srvid, buf+offset, &np);
+	offset += np;
+
+	ctdb_bool_push(&in->withemptyrecords, buf+offset, &np);
+	offset += np;
+
+	ctdb_padding_push(3, buf+offset, &np);
+	offset += np;
+
+	ctdb_tdb_datan_push(&in->prefix, buf+offset, &np);
+	offset += np;
+
+	*npush = offset;
+}
+
+int ctdb_traverse_start_stream_pull(uint8_t *buf, size_t buflen,
+				    TALLOC_CTX *mem_ctx,
+				    struct ctdb_traverse_start_stream **out,
+				    size_t *npull)
+{
+	struct ctdb_traverse_start_stream *val;
+	size_t offset = 0, np;
+	int ret;
+
+	val = talloc(mem_ctx, struct ctdb_traverse_start_stream);
+	if (val == NULL) {
+		return ENOMEM;
+	}
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->db_id, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->reqid, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint64_pull(buf+offset, buflen-offset, &val->srvid, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_bool_pull(buf+offset, buflen-offset,
+			     &val->withemptyrecords, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_padding_pull(buf+offset, buflen-offset, 3, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_tdb_datan_pull(buf+offset, buflen-offset, val,
+				  &val->prefix, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	*out = val;
+	*npull = offset;
+	return 0;
+
+fail:
+	talloc_free(val);
+	return ret;
+}
+
+size_t ctdb_traverse_all_stream_len(struct ctdb_traverse_all_stream *in)
+{
+	return ctdb_uint32_len(&in->db_id) +
+		ctdb_uint32_len(&in->reqid) +
+		ctdb_uint32_len(&in->pnn) +
+		ctdb_uint32_len(&in->client_reqid) +
+		ctdb_uint64_len(&in->srvid) +
+		ctdb_uint32_len(&in->window) +
+		ctdb_bool_len(&in->withemptyrecords) +
+		ctdb_padding_len(3) +
+		ctdb_tdb_datan_len(&in->prefix);
+}
+
+void ctdb_traverse_all_stream_push(struct ctdb_traverse_all_stream *in,
+				   uint8_t *buf, size_t *npush)
+{
+	size_t offset = 0, np;
+
+	ctdb_uint32_push(&in->db_id, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->reqid, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->pnn, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->client_reqid, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint64_push(&in->srvid, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->window, buf+offset, &np);
+	offset += np;
+
+	ctdb_bool_push(&in->withemptyrecords, buf+offset, &np);
+	offset += np;
+
+	ctdb_padding_push(3, buf+offset, &np);
+	offset += np;
+
+	ctdb_tdb_datan_push(&in->prefix, buf+offset, &np);
+	offset += np;
+
+	*npush = offset;
+}
+
+int ctdb_traverse_all_stream_pull(uint8_t *buf, size_t buflen,
+				  TALLOC_CTX *mem_ctx,
+				  struct ctdb_traverse_all_stream **out,
+				  size_t *npull)
+{
+	struct ctdb_traverse_all_stream *val;
+	size_t offset = 0, np;
+	int ret;
+
+	val = talloc(mem_ctx, struct ctdb_traverse_all_stream);
+	if (val == NULL) {
+		return ENOMEM;
+	}
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->db_id, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->reqid, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->pnn, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->client_reqid,
+			       &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint64_pull(buf+offset, buflen-offset, &val->srvid, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->window, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_bool_pull(buf+offset, buflen-offset,
+			     &val->withemptyrecords, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_padding_pull(buf+offset, buflen-offset, 3, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_tdb_datan_pull(buf+offset, buflen-offset, val,
+				  &val->prefix, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	*out = val;
+	*npull = offset;
+	return 0;
+
+fail:
+	talloc_free(val);
+	return ret;
+}
+
 size_t ctdb_sock_addr_len(ctdb_sock_addr *in)
 {
 	return sizeof(ctdb_sock_addr);
@@ -2560,7 +2785,9 @@ size_t ctdb_tunable_list_len(struct ctdb_tunable_list *in)
 		ctdb_uint32_len(&in->rec_buffer_size_limit) +
 		ctdb_uint32_len(&in->queue_buffer_size) +
 		ctdb_uint32_len(&in->ip_alloc_algorithm) +
-		ctdb_uint32_len(&in->allow_mixed_versions);
+		ctdb_uint32_len(&in->allow_mixed_versions) +
+		ctdb_uint32_len(&in->consistent_lmaster) +
+		ctdb_uint32_len(&in->traverse_window);
 }
 
 void ctdb_tunable_list_push(struct ctdb_tunable_list *in, uint8_t *buf,
@@ -2754,6 +2981,12 @@ void ctdb_tunable_list_push(struct ctdb_tunable_list *in, uint8_t *buf,
 	ctdb_uint32_push(&in->allow_mixed_versions, buf+offset, &np);
 	offset += np;
 
+	ctdb_uint32_push(&in->consistent_lmaster, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->traverse_window, buf+offset, &np);
+	offset += np;
+
 	*npush = offset;
 }
 
@@ -3199,6 +3432,20 @@ static int ctdb_tunable_list_pull_elems(uint8_t *buf, size_t buflen,
 	}
 	offset += np;
 
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset,
+			       &out->consistent_lmaster, &np);
+	if (ret != 0) {
+		return ret;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset,
+			       &out->traverse_window, &np);
+	if (ret != 0) {
+		return ret;
+	}
+	offset += np;
+
 	*npull = offset;
 	return 0;
 }
@@ -3432,6 +3679,80 @@ fail:
 	return ret;
 }
 
+size_t ctdb_trans3_ticket_len(struct ctdb_trans3_ticket *in)
+{
+	return ctdb_uint32_len(&in->db_id) +
+		ctdb_uint32_len(&in->generation) +
+		ctdb_uint32_len(&in->tid) +
+		ctdb_uint32_len(&in->pnn);
+}
+
+void ctdb_trans3_ticket_push(struct ctdb_trans3_ticket *in, uint8_t *buf,
+			     size_t *npush)
+{
+	size_t offset = 0, np;
+
+	ctdb_uint32_push(&in->db_id, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->generation, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->tid, buf+offset, &np);
+	offset += np;
+
+	ctdb_uint32_push(&in->pnn, buf+offset, &np);
+	offset += np;
+
+	*npush = offset;
+}
+
+int ctdb_trans3_ticket_pull(uint8_t *buf, size_t buflen, TALLOC_CTX *mem_ctx,
+			    struct ctdb_trans3_ticket **out, size_t *npull)
+{
+	struct ctdb_trans3_ticket *val;
+	size_t offset = 0, np;
+	int ret;
+
+	val = talloc(mem_ctx, struct ctdb_trans3_ticket);
+	if (val == NULL) {
+		return ENOMEM;
+	}
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->db_id, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->generation,
+			       &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->tid, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	ret = ctdb_uint32_pull(buf+offset, buflen-offset, &val->pnn, &np);
+	if (ret != 0) {
+		goto fail;
+	}
+	offset += np;
+
+	*out = val;
+	*npull = offset;
+	return 0;
+
+fail:
+	talloc_free(val);
+	return ret;
+}
+
 size_t ctdb_uptime_len(struct ctdb_uptime *in)
 {
 	return ctdb_timeval_len(&in->current_time) +
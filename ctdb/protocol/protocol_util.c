@@ -656,3 +656,47 @@ fail:
 	talloc_free(list);
 	return EINVAL;
 }
+
+/*
+ * Mix the bits of a 32-bit value (murmur3 finalizer)
+ */
+static uint32_t vnn_map_mix(uint32_t h)
+{
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+
+	return h;
+}
+
+/*
+ * With modulo mapping almost every hash maps to a different node when
+ * the size of the vnn map changes.  With rendezvous hashing, each node
+ * in the vnn map gets a weight derived from the hash and the node's pnn,
+ * and the node with the highest weight is selected.  A membership change
+ * then only moves the hashes mapped to the node that was added/removed.
+ */
+uint32_t ctdb_vnn_map_lmaster(struct ctdb_vnn_map *vnnmap, uint32_t hash,
+			      bool consistent)
+{
+	uint32_t i, idx, weight, max_weight;
+
+	if (! consistent) {
+		idx = hash % vnnmap->size;
+		return vnnmap->map[idx];
+	}
+
+	idx = 0;
+	max_weight = 0;
+	for (i=0; i<vnnmap->size; i++) {
+		weight = vnn_map_mix(hash ^ vnn_map_mix(vnnmap->map[i] + 1));
+		if (i == 0 || weight > max_weight) {
+			idx = i;
+			max_weight = weight;
+		}
+	}
+
+	return vnnmap->map[idx];
+}
@@ -69,4 +69,7 @@ const char *ctdb_connection_list_to_string(
 int ctdb_connection_list_read(TALLOC_CTX *mem_ctx, bool client_first,
 			      struct ctdb_connection_list **conn_list);
 
+uint32_t ctdb_vnn_map_lmaster(struct ctdb_vnn_map *vnnmap, uint32_t hash,
+			      bool consistent);
+
 #endif /* __CTDB_PROTOCOL_UTIL_H__ */
@@ -706,6 +706,22 @@ static int32_t ctdb_control_dispatch(struct ctdb_context *ctdb,
 	case CTDB_CONTROL_TUNNEL_DEREGISTER:
 		return ctdb_control_tunnel_deregister(ctdb, client_id, srvid);
 
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		return ctdb_control_traverse_start_stream(ctdb, indata, outdata,
+							  srcnode, client_id);
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		return ctdb_control_traverse_all_stream(ctdb, indata, outdata);
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		return ctdb_control_trans3_commit_start(ctdb, c, indata,
+							async_reply);
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		CHECK_CONTROL_DATA_SIZE(sizeof(struct ctdb_trans3_ticket));
+		return ctdb_control_trans3_commit_wait(ctdb, c, indata,
+						       async_reply);
+
 	default:
 		DEBUG(DEBUG_CRIT,(__location__ " Unknown CTDB control opcode %u\n", opcode));
 		return -1;
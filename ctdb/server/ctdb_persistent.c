@@ -28,6 +28,7 @@
 #include <tevent.h>
 
 #include "lib/tdb_wrap/tdb_wrap.h"
+#include "lib/util/dlinklist.h"
 #include "lib/util/debug.h"
 #include "lib/util/samba_util.h"
 
@@ -48,6 +49,64 @@ struct ctdb_persistent_state {
 	uint32_t num_failed, num_sent;
 };
 
+/*
+ * Commits started with TRANS3_COMMIT_START are written to the local
+ * database and acknowledged straight away, so that the client can drop
+ * the g_lock of the database before the other nodes have the changes.
+ * They are then replicated in order.  While one group of commits is
+ * being written on the other nodes, the commits that follow are
+ * collected, and sent together in the next UPDATE_RECORD.  So a burst
+ * of transactions from many processes costs one round trip and one tdb
+ * transaction on every other node per group, not per transaction.
+ * TRANS3_COMMIT_WAIT replies once a commit has been replicated.
+ */
+struct ctdb_persistent_commit {
+	struct ctdb_persistent_commit *prev, *next;
+	struct ctdb_persistent_queue *queue;
+	struct ctdb_req_control_old *c;
+	TDB_DATA recdata;
+	uint32_t tid;
+};
+
+struct ctdb_persistent_group {
+	struct ctdb_persistent_queue *queue;
+	uint32_t tid;
+	uint32_t num_commits;
+	uint32_t num_pending;
+};
+
+enum ctdb_persistent_wait {
+	CTDB_PERSISTENT_WAIT_REPLICATED,	/* TRANS3_COMMIT_WAIT */
+	CTDB_PERSISTENT_WAIT_IDLE,		/* deferred TRANS3_COMMIT */
+	CTDB_PERSISTENT_WAIT_RECOVERY,		/* end of the next recovery */
+};
+
+struct ctdb_persistent_waiter {
+	struct ctdb_persistent_waiter *prev, *next;
+	struct ctdb_req_control_old *c;
+	uint32_t tid;
+	enum ctdb_persistent_wait wait;
+};
+
+struct ctdb_persistent_queue {
+	struct ctdb_context *ctdb;
+	struct ctdb_db_context *ctdb_db;
+	struct ctdb_persistent_commit *applying;
+	struct ctdb_persistent_commit *pending;
+	struct ctdb_persistent_group *group;
+	struct ctdb_persistent_waiter *waiters;
+	uint32_t last_tid;		/* last commit written locally */
+	uint32_t replicated_tid;	/* last commit written on all nodes */
+};
+
+static void ctdb_persistent_queue_finish(struct ctdb_persistent_queue *queue);
+static bool ctdb_persistent_queue_idle(struct ctdb_persistent_queue *queue);
+static int32_t ctdb_persistent_queue_wait(struct ctdb_persistent_queue *queue,
+					  struct ctdb_req_control_old *c,
+					  uint32_t tid,
+					  enum ctdb_persistent_wait wait,
+					  bool *async_reply);
+
 /*
   1) all nodes fail, and all nodes reply
   2) some nodes fail, all nodes reply
@@ -141,6 +200,10 @@ void ctdb_persistent_finish_trans3_commits(struct ctdb_context *ctdb)
 	for (ctdb_db = ctdb->db_list; ctdb_db; ctdb_db = ctdb_db->next) {
 		struct ctdb_persistent_state *state;
 
+		if (ctdb_db->persistent_queue != NULL) {
+			ctdb_persistent_queue_finish(ctdb_db->persistent_queue);
+		}
+
 		if (ctdb_db->persistent_state == NULL) {
 			continue;
 		}
@@ -209,6 +272,19 @@ int32_t ctdb_control_trans3_commit(struct ctdb_context *ctdb,
 		return -1;
 	}
 
+	if (ctdb_db->persistent_queue != NULL &&
+	    !ctdb_persistent_queue_idle(ctdb_db->persistent_queue)) {
+		/*
+		 * Commits started with TRANS3_COMMIT_START are still
+		 * being replicated.  Let them go first, so that every
+		 * node sees the updates in the same order.
+		 */
+		return ctdb_persistent_queue_wait(ctdb_db->persistent_queue,
+						  c, 0,
+						  CTDB_PERSISTENT_WAIT_IDLE,
+						  async_reply);
+	}
+
 	if (ctdb_db->persistent_state != NULL) {
 		DEBUG(DEBUG_ERR, (__location__ " Error: "
 				  "ctdb_control_trans3_commit "
@@ -276,6 +352,485 @@ int32_t ctdb_control_trans3_commit(struct ctdb_context *ctdb,
 	return 0;
 }
 
+static struct ctdb_persistent_queue *ctdb_persistent_queue_get(
+					struct ctdb_db_context *ctdb_db)
+{
+	struct ctdb_persistent_queue *queue;
+
+	if (ctdb_db->persistent_queue != NULL) {
+		return ctdb_db->persistent_queue;
+	}
+
+	queue = talloc_zero(ctdb_db, struct ctdb_persistent_queue);
+	if (queue == NULL) {
+		return NULL;
+	}
+
+	queue->ctdb = ctdb_db->ctdb;
+	queue->ctdb_db = ctdb_db;
+
+	ctdb_db->persistent_queue = queue;
+	return queue;
+}
+
+static bool ctdb_persistent_queue_idle(struct ctdb_persistent_queue *queue)
+{
+	return (queue->applying == NULL && queue->pending == NULL &&
+		queue->group == NULL);
+}
+
+/*
+ * Has the commit with the given id been written on all nodes?
+ */
+static bool ctdb_persistent_replicated(struct ctdb_persistent_queue *queue,
+				       uint32_t tid)
+{
+	return ((int32_t)(tid - queue->replicated_tid) <= 0);
+}
+
+static void ctdb_persistent_trans3_resume(struct ctdb_context *ctdb,
+					  struct ctdb_req_control_old *c)
+{
+	TDB_DATA recdata;
+	bool async_reply = false;
+	int32_t ret;
+
+	recdata.dptr = &c->data[0];
+	recdata.dsize = c->datalen;
+
+	ret = ctdb_control_trans3_commit(ctdb, c, recdata, &async_reply);
+	if (! async_reply) {
+		ctdb_request_control_reply(ctdb, c, NULL, ret, NULL);
+		talloc_free(c);
+	}
+}
+
+/*
+ * Reply to the waiters whose commits have been replicated, and restart
+ * deferred TRANS3_COMMIT controls once nothing is left to replicate.
+ */
+static void ctdb_persistent_queue_wakeup(struct ctdb_persistent_queue *queue)
+{
+	struct ctdb_persistent_waiter *w, *next;
+
+	for (w = queue->waiters; w != NULL; w = next) {
+		next = w->next;
+
+		if (w->wait == CTDB_PERSISTENT_WAIT_RECOVERY) {
+			continue;
+		}
+
+		if (w->wait == CTDB_PERSISTENT_WAIT_IDLE) {
+			if (! ctdb_persistent_queue_idle(queue)) {
+				continue;
+			}
+
+			DLIST_REMOVE(queue->waiters, w);
+			ctdb_persistent_trans3_resume(
+				queue->ctdb, talloc_steal(queue->ctdb, w->c));
+			talloc_free(w);
+			continue;
+		}
+
+		if (! ctdb_persistent_replicated(queue, w->tid)) {
+			continue;
+		}
+
+		DLIST_REMOVE(queue->waiters, w);
+		ctdb_request_control_reply(queue->ctdb, w->c, NULL, 0, NULL);
+		talloc_free(w);
+	}
+}
+
+static int32_t ctdb_persistent_queue_wait(struct ctdb_persistent_queue *queue,
+					  struct ctdb_req_control_old *c,
+					  uint32_t tid,
+					  enum ctdb_persistent_wait wait,
+					  bool *async_reply)
+{
+	struct ctdb_persistent_waiter *w;
+
+	w = talloc_zero(queue, struct ctdb_persistent_waiter);
+	CTDB_NO_MEMORY(queue->ctdb, w);
+
+	w->c = talloc_steal(w, c);
+	w->tid = tid;
+	w->wait = wait;
+
+	DLIST_ADD_END(queue->waiters, w);
+
+	*async_reply = true;
+	return 0;
+}
+
+/*
+ * Finish all commits at the end of a recovery.  The recovery has made
+ * the database the same on all nodes, so there is nothing left to send.
+ * The clients check the database sequence number to find out whether
+ * their changes made it.
+ */
+static void ctdb_persistent_queue_finish(struct ctdb_persistent_queue *queue)
+{
+	struct ctdb_persistent_commit *commit;
+	struct ctdb_persistent_waiter *w;
+
+	if (queue->applying != NULL) {
+		ctdb_request_control_reply(queue->ctdb, queue->applying->c,
+					   NULL, 2,
+					   "trans3 commit ended by recovery");
+		TALLOC_FREE(queue->applying);
+	}
+
+	while ((commit = queue->pending) != NULL) {
+		DLIST_REMOVE(queue->pending, commit);
+		talloc_free(commit);
+	}
+
+	TALLOC_FREE(queue->group);
+	queue->replicated_tid = queue->last_tid;
+
+	while ((w = queue->waiters) != NULL) {
+		DLIST_REMOVE(queue->waiters, w);
+		ctdb_request_control_reply(queue->ctdb, w->c, NULL, 2,
+					   "trans3 commit ended by recovery");
+		talloc_free(w);
+	}
+}
+
+static void ctdb_persistent_queue_send(struct ctdb_persistent_queue *queue);
+
+static void ctdb_persistent_group_done(struct ctdb_persistent_group *group)
+{
+	struct ctdb_persistent_queue *queue = group->queue;
+
+	DEBUG(DEBUG_DEBUG, ("Replicated %u commits to db 0x%08x\n",
+			    group->num_commits, queue->ctdb_db->db_id));
+
+	queue->replicated_tid = group->tid;
+	queue->group = NULL;
+	talloc_free(group);
+
+	ctdb_persistent_queue_send(queue);
+	ctdb_persistent_queue_wakeup(queue);
+}
+
+/*
+  called when a node has written a group of commits
+ */
+static void ctdb_persistent_group_callback(struct ctdb_context *ctdb,
+					   int32_t status, TDB_DATA data,
+					   const char *errormsg,
+					   void *private_data)
+{
+	struct ctdb_persistent_group *group = talloc_get_type_abort(
+		private_data, struct ctdb_persistent_group);
+
+	if (ctdb->recovery_mode != CTDB_RECOVERY_NORMAL) {
+		DEBUG(DEBUG_INFO, ("ctdb_persistent_group_callback: ignoring "
+				   "reply during recovery\n"));
+		return;
+	}
+
+	if (status != 0) {
+		DEBUG(DEBUG_ERR, ("ctdb_persistent_group_callback failed "
+				  "with status %d (%s)\n", status,
+				  errormsg ? errormsg : "no error message given"));
+		/*
+		 * As for TRANS3_COMMIT, let the recovery bring the nodes
+		 * back in sync and finish the commits.
+		 */
+		ctdb->recovery_mode = CTDB_RECOVERY_ACTIVE;
+		return;
+	}
+
+	group->num_pending--;
+	if (group->num_pending != 0) {
+		return;
+	}
+
+	ctdb_persistent_group_done(group);
+}
+
+/*
+ * Send all commits that have been written locally to the other nodes as
+ * one group, unless a group is already on its way.
+ */
+static void ctdb_persistent_queue_send(struct ctdb_persistent_queue *queue)
+{
+	struct ctdb_context *ctdb = queue->ctdb;
+	struct ctdb_persistent_group *group;
+	struct ctdb_persistent_commit *commit;
+	struct ctdb_marshall_buffer *m;
+	TDB_DATA recdata;
+	size_t hdr_len = offsetof(struct ctdb_marshall_buffer, data);
+	size_t len, offset;
+	int i;
+
+	if (queue->group != NULL || queue->pending == NULL) {
+		return;
+	}
+
+	group = talloc_zero(queue, struct ctdb_persistent_group);
+	if (group == NULL) {
+		DEBUG(DEBUG_ERR, (__location__ " Memory allocation error\n"));
+		ctdb->recovery_mode = CTDB_RECOVERY_ACTIVE;
+		return;
+	}
+	group->queue = queue;
+
+	len = hdr_len;
+	for (commit = queue->pending; commit != NULL; commit = commit->next) {
+		len += commit->recdata.dsize - hdr_len;
+	}
+
+	m = talloc_size(group, len);
+	if (m == NULL) {
+		DEBUG(DEBUG_ERR, (__location__ " Memory allocation error\n"));
+		talloc_free(group);
+		ctdb->recovery_mode = CTDB_RECOVERY_ACTIVE;
+		return;
+	}
+
+	m->db_id = queue->ctdb_db->db_id;
+	m->count = 0;
+	offset = hdr_len;
+
+	/*
+	 * The records of each commit follow those of the commits before
+	 * it, so a record changed by several commits ends up with the
+	 * newest data.  The group is written in a single tdb
+	 * transaction, which keeps every commit atomic.
+	 */
+	while ((commit = queue->pending) != NULL) {
+		struct ctdb_marshall_buffer *cm =
+			(struct ctdb_marshall_buffer *)commit->recdata.dptr;
+		size_t n = commit->recdata.dsize - hdr_len;
+
+		memcpy((uint8_t *)m + offset, &cm->data[0], n);
+		offset += n;
+		m->count += cm->count;
+
+		group->tid = commit->tid;
+		group->num_commits += 1;
+
+		DLIST_REMOVE(queue->pending, commit);
+		talloc_free(commit);
+	}
+
+	recdata.dptr = (uint8_t *)m;
+	recdata.dsize = len;
+
+	queue->group = group;
+
+	for (i = 0; i < ctdb->vnn_map->size; i++) {
+		struct ctdb_node *node = ctdb->nodes[ctdb->vnn_map->map[i]];
+		int ret;
+
+		/* only send to other active nodes */
+		if (node->pnn == ctdb->pnn ||
+		    node->flags & NODE_FLAGS_INACTIVE) {
+			continue;
+		}
+
+		ret = ctdb_daemon_send_control(ctdb, node->pnn, 0,
+					       CTDB_CONTROL_UPDATE_RECORD,
+					       0, 0, recdata,
+					       ctdb_persistent_group_callback,
+					       group);
+		if (ret == -1) {
+			DEBUG(DEBUG_ERR, ("Unable to send "
+					  "CTDB_CONTROL_UPDATE_RECORD "
+					  "to pnn %u\n", node->pnn));
+			ctdb->recovery_mode = CTDB_RECOVERY_ACTIVE;
+			return;
+		}
+
+		group->num_pending++;
+	}
+
+	talloc_free(m);
+
+	if (group->num_pending == 0) {
+		ctdb_persistent_group_done(group);
+	}
+}
+
+/*
+  called when a commit has been written to the local database
+ */
+static void ctdb_persistent_commit_written(struct ctdb_context *ctdb,
+					   int32_t status, TDB_DATA data,
+					   const char *errormsg,
+					   void *private_data)
+{
+	struct ctdb_persistent_commit *commit = talloc_get_type_abort(
+		private_data, struct ctdb_persistent_commit);
+	struct ctdb_persistent_queue *queue = commit->queue;
+	struct ctdb_trans3_ticket ticket;
+	TDB_DATA outdata;
+
+	if (ctdb->recovery_mode != CTDB_RECOVERY_NORMAL) {
+		DEBUG(DEBUG_INFO, ("ctdb_persistent_commit_written: ignoring "
+				   "reply during recovery\n"));
+		return;
+	}
+
+	if (status != 0) {
+		DEBUG(DEBUG_ERR, ("ctdb_persistent_commit_written failed "
+				  "with status %d (%s)\n", status,
+				  errormsg ? errormsg : "no error message given"));
+		ctdb->recovery_mode = CTDB_RECOVERY_ACTIVE;
+		return;
+	}
+
+	queue->applying = NULL;
+	queue->last_tid += 1;
+	commit->tid = queue->last_tid;
+
+	ticket.db_id = queue->ctdb_db->db_id;
+	ticket.generation = ctdb->vnn_map->generation;
+	ticket.tid = commit->tid;
+	ticket.pnn = ctdb->pnn;
+
+	outdata.dptr = (uint8_t *)&ticket;
+	outdata.dsize = sizeof(ticket);
+	ctdb_request_control_reply(ctdb, commit->c, &outdata, 0, NULL);
+
+	DLIST_ADD_END(queue->pending, commit);
+	ctdb_persistent_queue_send(queue);
+}
+
+/*
+ * Write a transaction to the local database and queue it for
+ * replication.  The reply carries the ticket to wait for with
+ * TRANS3_COMMIT_WAIT.
+ */
+int32_t ctdb_control_trans3_commit_start(struct ctdb_context *ctdb,
+					 struct ctdb_req_control_old *c,
+					 TDB_DATA recdata, bool *async_reply)
+{
+	struct ctdb_marshall_buffer *m =
+		(struct ctdb_marshall_buffer *)recdata.dptr;
+	struct ctdb_db_context *ctdb_db;
+	struct ctdb_persistent_queue *queue;
+	struct ctdb_persistent_commit *commit;
+	int ret;
+
+	if (ctdb->recovery_mode != CTDB_RECOVERY_NORMAL) {
+		DEBUG(DEBUG_INFO, ("rejecting ctdb_control_trans3_commit_start "
+				   "when recovery active\n"));
+		return -1;
+	}
+
+	if (recdata.dsize < offsetof(struct ctdb_marshall_buffer, data)) {
+		DEBUG(DEBUG_ERR, (__location__ " Invalid data in "
+				  "ctdb_control_trans3_commit_start\n"));
+		return -1;
+	}
+
+	ctdb_db = find_ctdb_db(ctdb, m->db_id);
+	if (ctdb_db == NULL) {
+		DEBUG(DEBUG_ERR, (__location__ " ctdb_control_trans3_commit_start: "
+				  "Unknown database db_id[0x%08x]\n", m->db_id));
+		return -1;
+	}
+
+	if (ctdb_db_volatile(ctdb_db)) {
+		DEBUG(DEBUG_ERR, (__location__ " ctdb_control_trans3_commit_start: "
+				  "Database db_id[0x%08x] is volatile\n",
+				  m->db_id));
+		return -1;
+	}
+
+	queue = ctdb_persistent_queue_get(ctdb_db);
+	CTDB_NO_MEMORY(ctdb, queue);
+
+	if (ctdb_db->persistent_state != NULL || queue->applying != NULL) {
+		DEBUG(DEBUG_ERR, (__location__ " Error: "
+				  "ctdb_control_trans3_commit_start "
+				  "called while a transaction commit is "
+				  "active. db_id[0x%08x]\n", m->db_id));
+		return -1;
+	}
+
+	commit = talloc_zero(queue, struct ctdb_persistent_commit);
+	CTDB_NO_MEMORY(ctdb, commit);
+
+	commit->queue = queue;
+	commit->recdata = recdata;
+
+	ret = ctdb_daemon_send_control(ctdb, ctdb->pnn, 0,
+				       CTDB_CONTROL_UPDATE_RECORD,
+				       c->client_id, 0, recdata,
+				       ctdb_persistent_commit_written,
+				       commit);
+	if (ret == -1) {
+		DEBUG(DEBUG_ERR, ("Unable to send CTDB_CONTROL_UPDATE_RECORD "
+				  "to local node\n"));
+		talloc_free(commit);
+		return -1;
+	}
+
+	/* recdata points into the control, keep it until replicated */
+	commit->c = talloc_steal(commit, c);
+	queue->applying = commit;
+
+	*async_reply = true;
+	return 0;
+}
+
+/*
+ * Reply once the commit of the ticket has been written on all nodes.
+ * A recovery since the ticket was handed out has already made the
+ * database the same on all nodes.
+ *
+ * During a recovery, and for a ticket handed out by another node, the
+ * reply is deferred until the end of the next recovery.  The latter
+ * lets a client that cannot reach the node that made the commit block
+ * until a recovery has taken care of it.
+ */
+int32_t ctdb_control_trans3_commit_wait(struct ctdb_context *ctdb,
+					struct ctdb_req_control_old *c,
+					TDB_DATA indata, bool *async_reply)
+{
+	struct ctdb_trans3_ticket *t = (struct ctdb_trans3_ticket *)indata.dptr;
+	struct ctdb_db_context *ctdb_db;
+	struct ctdb_persistent_queue *queue;
+
+	ctdb_db = find_ctdb_db(ctdb, t->db_id);
+	if (ctdb_db == NULL) {
+		DEBUG(DEBUG_ERR, (__location__ " ctdb_control_trans3_commit_wait: "
+				  "Unknown database db_id[0x%08x]\n", t->db_id));
+		return -1;
+	}
+
+	if (ctdb->recovery_mode == CTDB_RECOVERY_NORMAL &&
+	    t->generation != ctdb->vnn_map->generation) {
+		return 0;
+	}
+
+	if (ctdb->recovery_mode != CTDB_RECOVERY_NORMAL ||
+	    t->pnn != ctdb->pnn) {
+		DEBUG(DEBUG_INFO, ("deferring ctdb_control_trans3_commit_wait "
+				   "until the end of recovery\n"));
+		queue = ctdb_persistent_queue_get(ctdb_db);
+		CTDB_NO_MEMORY(ctdb, queue);
+
+		return ctdb_persistent_queue_wait(queue, c, t->tid,
+						  CTDB_PERSISTENT_WAIT_RECOVERY,
+						  async_reply);
+	}
+
+	queue = ctdb_db->persistent_queue;
+	if (queue == NULL || ctdb_persistent_replicated(queue, t->tid)) {
+		return 0;
+	}
+
+	return ctdb_persistent_queue_wait(queue, c, t->tid,
+					  CTDB_PERSISTENT_WAIT_REPLICATED,
+					  async_reply);
+}
+
 
 /*
   backwards compatibility:
@@ -68,6 +68,7 @@ int
 ctdb_control_setvnnmap(struct ctdb_context *ctdb, uint32_t opcode, TDB_DATA indata, TDB_DATA *outdata)
 {
 	struct ctdb_vnn_map_wire *map = (struct ctdb_vnn_map_wire *)indata.dptr;
+	bool consistent;
 
 	if (ctdb->recovery_mode != CTDB_RECOVERY_ACTIVE) {
 		DEBUG(DEBUG_ERR, ("Attempt to set vnnmap when not in recovery\n"));
@@ -86,6 +87,18 @@ ctdb_control_setvnnmap(struct ctdb_context *ctdb, uint32_t opcode, TDB_DATA inda
 
 	memcpy(ctdb->vnn_map->map, map->map, sizeof(uint32_t)*map->size);
 
+	/*
+	 * The lmaster mapping only changes along with the vnn map, so
+	 * that all the nodes switch mapping during the same recovery
+	 */
+	consistent = (ctdb->tunable.consistent_lmaster != 0);
+	if (ctdb->lmaster_consistent != consistent) {
+		ctdb->lmaster_consistent = consistent;
+		DEBUG(DEBUG_NOTICE, ("Switching to %s lmaster mapping\n",
+				     ctdb->lmaster_consistent ?
+				     "consistent hash" : "modulo"));
+	}
+
 	return 0;
 }
 
@@ -33,6 +33,7 @@
 
 #include "protocol/protocol.h"
 #include "protocol/protocol_api.h"
+#include "protocol/protocol_util.h"
 #include "client/client.h"
 
 #include "common/logging.h"
@@ -390,6 +391,67 @@ static int recdb_file(struct recdb_context *recdb, TALLOC_CTX *mem_ctx,
  * Pull database from a single node
  */
 
+/*
+ * Count the records for which the lmaster changes with the new vnnmap
+ */
+
+struct recdb_lmaster_traverse_state {
+	struct ctdb_vnn_map *old_vnnmap;
+	struct ctdb_vnn_map *vnnmap;
+	bool consistent;
+	unsigned int num_records;
+	unsigned int num_moved;
+};
+
+static int recdb_lmaster_traverse(struct tdb_context *tdb,
+				  TDB_DATA key, TDB_DATA data,
+				  void *private_data)
+{
+	struct recdb_lmaster_traverse_state *state =
+		(struct recdb_lmaster_traverse_state *)private_data;
+	uint32_t hash, old_lmaster, lmaster;
+
+	hash = tdb_jenkins_hash(&key);
+	old_lmaster = ctdb_vnn_map_lmaster(state->old_vnnmap, hash,
+					   state->consistent);
+	lmaster = ctdb_vnn_map_lmaster(state->vnnmap, hash,
+				       state->consistent);
+
+	state->num_records += 1;
+	if (lmaster != old_lmaster) {
+		state->num_moved += 1;
+	}
+
+	return 0;
+}
+
+static int recdb_lmaster_moved(struct recdb_context *recdb,
+			       struct ctdb_vnn_map *old_vnnmap,
+			       struct ctdb_vnn_map *vnnmap,
+			       bool consistent,
+			       unsigned int *num_records,
+			       unsigned int *num_moved)
+{
+	struct recdb_lmaster_traverse_state state;
+	int ret;
+
+	state = (struct recdb_lmaster_traverse_state) {
+		.old_vnnmap = old_vnnmap,
+		.vnnmap = vnnmap,
+		.consistent = consistent,
+	};
+
+	ret = tdb_traverse_read(recdb_tdb(recdb), recdb_lmaster_traverse,
+				&state);
+	if (ret == -1) {
+		return EIO;
+	}
+
+	*num_records = state.num_records;
+	*num_moved = state.num_moved;
+	return 0;
+}
+
 struct pull_database_state {
 	struct tevent_context *ev;
 	struct ctdb_client_context *client;
@@ -1444,6 +1506,8 @@ struct recover_db_state {
 	int count;
 	uint32_t *caps;
 	uint32_t *ban_credits;
+	struct ctdb_vnn_map *old_vnnmap;
+	struct ctdb_vnn_map *vnnmap;
 	uint32_t db_id;
 	uint8_t db_flags;
 
@@ -1471,7 +1535,8 @@ static struct tevent_req *recover_db_send(TALLOC_CTX *mem_ctx,
 					  uint32_t *pnn_list, int count,
 					  uint32_t *caps,
 					  uint32_t *ban_credits,
-					  uint32_t generation,
+					  struct ctdb_vnn_map *old_vnnmap,
+					  struct ctdb_vnn_map *vnnmap,
 					  uint32_t db_id, uint8_t db_flags)
 {
 	struct tevent_req *req, *subreq;
@@ -1490,12 +1555,14 @@ static struct tevent_req *recover_db_send(TALLOC_CTX *mem_ctx,
 	state->count = count;
 	state->caps = caps;
 	state->ban_credits = ban_credits;
+	state->old_vnnmap = old_vnnmap;
+	state->vnnmap = vnnmap;
 	state->db_id = db_id;
 	state->db_flags = db_flags;
 
 	state->destnode = ctdb_client_pnn(client);
 	state->transdb.db_id = db_id;
-	state->transdb.tid = generation;
+	state->transdb.tid = vnnmap->generation;
 
 	ctdb_req_control_get_dbname(&request, db_id);
 	subreq = ctdb_client_control_send(state, ev, client, state->destnode,
@@ -1701,6 +1768,7 @@ static void recover_db_collect_done(struct tevent_req *subreq)
 	struct recover_db_state *state = tevent_req_data(
 		req, struct recover_db_state);
 	struct ctdb_req_control request;
+	unsigned int num_records, num_moved;
 	int ret;
 	bool status;
 
@@ -1716,6 +1784,19 @@ static void recover_db_collect_done(struct tevent_req *subreq)
 		return;
 	}
 
+	if (! recdb_persistent(state->recdb) &&
+	    state->old_vnnmap->generation != INVALID_GENERATION) {
+		ret = recdb_lmaster_moved(state->recdb, state->old_vnnmap,
+					  state->vnnmap,
+					  state->tun_list->consistent_lmaster,
+					  &num_records, &num_moved);
+		if (ret == 0) {
+			D_NOTICE("%s: lmaster changed for %u of %u records\n",
+				 recdb_name(state->recdb), num_moved,
+				 num_records);
+		}
+	}
+
 	ctdb_req_control_wipe_database(&request, &state->transdb);
 	subreq = ctdb_client_control_multi_send(state, state->ev,
 						state->client,
@@ -1904,7 +1985,8 @@ struct db_recovery_one_state {
 	int count;
 	uint32_t *caps;
 	uint32_t *ban_credits;
-	uint32_t generation;
+	struct ctdb_vnn_map *old_vnnmap;
+	struct ctdb_vnn_map *vnnmap;
 	uint32_t db_id;
 	uint8_t db_flags;
 	int num_fails;
@@ -1920,7 +2002,8 @@ static struct tevent_req *db_recovery_send(TALLOC_CTX *mem_ctx,
 					   uint32_t *pnn_list, int count,
 					   uint32_t *caps,
 					   uint32_t *ban_credits,
-					   uint32_t generation)
+					   struct ctdb_vnn_map *old_vnnmap,
+					   struct ctdb_vnn_map *vnnmap)
 {
 	struct tevent_req *req, *subreq;
 	struct db_recovery_state *state;
@@ -1957,13 +2040,14 @@ static struct tevent_req *db_recovery_send(TALLOC_CTX *mem_ctx,
 		substate->count = count;
 		substate->caps = caps;
 		substate->ban_credits = ban_credits;
-		substate->generation = generation;
+		substate->old_vnnmap = old_vnnmap;
+		substate->vnnmap = vnnmap;
 		substate->db_id = dbmap->dbs[i].db_id;
 		substate->db_flags = dbmap->dbs[i].flags;
 
 		subreq = recover_db_send(state, ev, client, tun_list,
 					 pnn_list, count, caps, ban_credits,
-					 generation, substate->db_id,
+					 old_vnnmap, vnnmap, substate->db_id,
 					 substate->db_flags);
 		if (tevent_req_nomem(subreq, req)) {
 			return tevent_req_post(req, ev);
@@ -1999,7 +2083,8 @@ static void db_recovery_one_done(struct tevent_req *subreq)
 					 substate->tun_list,
 					 substate->pnn_list, substate->count,
 					 substate->caps, substate->ban_credits,
-					 substate->generation, substate->db_id,
+					 substate->old_vnnmap, substate->vnnmap,
+					 substate->db_id,
 					 substate->db_flags);
 		if (tevent_req_nomem(subreq, req)) {
 			goto failed;
@@ -2069,6 +2154,7 @@ struct recovery_state {
 	uint32_t *caps;
 	uint32_t *ban_credits;
 	struct ctdb_tunable_list *tun_list;
+	struct ctdb_vnn_map *old_vnnmap;
 	struct ctdb_vnn_map *vnnmap;
 	struct ctdb_dbid_map *dbmap;
 };
@@ -2080,6 +2166,7 @@ static void recovery_capabilities_done(struct tevent_req *subreq);
 static void recovery_dbmap_done(struct tevent_req *subreq);
 static void recovery_active_done(struct tevent_req *subreq);
 static void recovery_start_recovery_done(struct tevent_req *subreq);
+static void recovery_tunable_update_done(struct tevent_req *subreq);
 static void recovery_vnnmap_update_done(struct tevent_req *subreq);
 static void recovery_db_recovery_done(struct tevent_req *subreq);
 static void recovery_failed_done(struct tevent_req *subreq);
@@ -2432,7 +2519,7 @@ static void recovery_active_done(struct tevent_req *subreq)
 
 	vnnmap->generation = state->generation;
 
-	talloc_free(state->vnnmap);
+	state->old_vnnmap = state->vnnmap;
 	state->vnnmap = vnnmap;
 
 	ctdb_req_control_start_recovery(&request);
@@ -2453,6 +2540,7 @@ static void recovery_start_recovery_done(struct tevent_req *subreq)
 	struct recovery_state *state = tevent_req_data(
 		req, struct recovery_state);
 	struct ctdb_req_control request;
+	struct ctdb_tunable tunable;
 	int *err_list;
 	int ret;
 	bool status;
@@ -2480,6 +2568,64 @@ static void recovery_start_recovery_done(struct tevent_req *subreq)
 
 	D_ERR("start_recovery event finished\n");
 
+	/*
+	 * The lmaster mapping is switched when the vnnmap is set, so make
+	 * sure all the nodes use the same mapping as the recmaster.
+	 *
+	 * Nodes running an older version do not know this tunable and
+	 * always use the default mapping.  So they can only take part
+	 * if the tunable is 0, in which case a failure to set it is
+	 * ignored, to keep rolling upgrades working.
+	 */
+	tunable.name = "ConsistentLMaster";
+	tunable.value = state->tun_list->consistent_lmaster;
+
+	ctdb_req_control_set_tunable(&request, &tunable);
+	subreq = ctdb_client_control_multi_send(state, state->ev,
+						state->client,
+						state->pnn_list, state->count,
+						TIMEOUT(), &request);
+	if (tevent_req_nomem(subreq, req)) {
+		return;
+	}
+	tevent_req_set_callback(subreq, recovery_tunable_update_done, req);
+}
+
+static void recovery_tunable_update_done(struct tevent_req *subreq)
+{
+	struct tevent_req *req = tevent_req_callback_data(
+		subreq, struct tevent_req);
+	struct recovery_state *state = tevent_req_data(
+		req, struct recovery_state);
+	struct ctdb_req_control request;
+	int *err_list;
+	int ret;
+	bool status;
+
+	status = ctdb_client_control_multi_recv(subreq, &ret, NULL, &err_list,
+						NULL);
+	TALLOC_FREE(subreq);
+	if (! status && state->tun_list->consistent_lmaster == 0) {
+		D_NOTICE("failed to set tunable ConsistentLMaster to 0,"
+			 " ignoring\n");
+	} else if (! status) {
+		int ret2;
+		uint32_t pnn;
+
+		ret2 = ctdb_client_control_multi_error(state->pnn_list,
+						       state->count,
+						       err_list, &pnn);
+		if (ret2 != 0) {
+			D_ERR("failed to set tunable ConsistentLMaster"
+			      " on node %u, ret=%d\n", pnn, ret2);
+		} else {
+			D_ERR("failed to set tunable ConsistentLMaster,"
+			      " ret=%d\n", ret);
+		}
+		tevent_req_error(req, ret);
+		return;
+	}
+
 	ctdb_req_control_setvnnmap(&request, state->vnnmap);
 	subreq = ctdb_client_control_multi_send(state, state->ev,
 						state->client,
@@ -2527,7 +2673,7 @@ static void recovery_vnnmap_update_done(struct tevent_req *subreq)
 				  state->dbmap, state->tun_list,
 				  state->pnn_list, state->count,
 				  state->caps, state->ban_credits,
-				  state->vnnmap->generation);
+				  state->old_vnnmap, state->vnnmap);
 	if (tevent_req_nomem(subreq, req)) {
 		return;
 	}
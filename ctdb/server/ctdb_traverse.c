@@ -62,6 +62,12 @@ struct ctdb_traverse_local_handle {
 	struct tevent_fd *fde;
 	int records_failed;
 	int records_sent;
+	/* streaming traverse, only used in the child */
+	bool stream;
+	uint32_t credits;
+	bool credit_timedout;
+	TDB_DATA prefix;
+	struct ctdb_marshall_buffer *recs;
 };
 
 /*
@@ -106,8 +112,126 @@ static int traverse_local_destructor(struct ctdb_traverse_local_handle *h)
 	return 0;
 }
 
+static void ctdb_traverse_stream_credit(uint64_t srvid, TDB_DATA data,
+					void *private_data)
+{
+	struct ctdb_traverse_local_handle *h = talloc_get_type_abort(
+		private_data, struct ctdb_traverse_local_handle);
+	uint32_t credits;
+
+	if (data.dsize != sizeof(uint32_t)) {
+		return;
+	}
+
+	memcpy(&credits, data.dptr, sizeof(credits));
+	h->credits += credits;
+}
+
+static void ctdb_traverse_stream_timeout(struct tevent_context *ev,
+					 struct tevent_timer *te,
+					 struct timeval t, void *private_data)
+{
+	struct ctdb_traverse_local_handle *h = talloc_get_type_abort(
+		private_data, struct ctdb_traverse_local_handle);
+
+	h->credit_timedout = true;
+}
+
+/*
+  send the current batch of records to the originator, waiting for it
+  to acknowledge earlier batches if the window is used up. This is only
+  called between the records of ctdb_traverse_stream_local(), never
+  from inside a tdb traverse, so a slow originator does not hold up
+  transactions on the database.
+ */
+static int ctdb_traverse_stream_flush(struct ctdb_traverse_local_handle *h)
+{
+	struct ctdb_context *ctdb = h->ctdb_db->ctdb;
+	struct tevent_timer *te;
+	uint64_t srvid;
+	int ret;
+
+	if (h->credits == 0) {
+		te = tevent_add_timer(ctdb->ev, h,
+				      timeval_current_ofs(
+					      ctdb->tunable.traverse_timeout, 0),
+				      ctdb_traverse_stream_timeout, h);
+		if (te == NULL) {
+			return ENOMEM;
+		}
+
+		while (h->credits == 0 && !h->credit_timedout) {
+			tevent_loop_once(ctdb->ev);
+		}
+		talloc_free(te);
+
+		if (h->credits == 0) {
+			DEBUG(DEBUG_ERR, ("Timed out waiting for traverse "
+					  "credits db:%s reqid:%d\n",
+					  h->ctdb_db->db_name, h->reqid));
+			return ETIMEDOUT;
+		}
+	}
+
+	srvid = CTDB_SRVID_TRAVERSE_DATA | ((uint64_t)ctdb->pnn << 32) |
+		h->reqid;
+	ret = ctdb_client_send_message(ctdb, h->srcnode, srvid,
+				       ctdb_marshall_finish(h->recs));
+	TALLOC_FREE(h->recs);
+	if (ret != 0) {
+		return EIO;
+	}
+
+	h->credits -= 1;
+	return 0;
+}
+
+static int ctdb_traverse_stream_add(struct ctdb_traverse_local_handle *h,
+				    TDB_DATA key, TDB_DATA data)
+{
+	struct ctdb_context *ctdb = h->ctdb_db->ctdb;
+	int ret;
+
+	h->recs = ctdb_marshall_add(h, h->recs, h->ctdb_db->db_id,
+				    h->client_reqid, key, NULL, data);
+	if (h->recs == NULL) {
+		h->records_failed++;
+		return -1;
+	}
+
+	h->records_sent++;
+
+	if (talloc_get_size(h->recs) < ctdb->tunable.rec_buffer_size_limit) {
+		return 0;
+	}
+
+	ret = ctdb_traverse_stream_flush(h);
+	if (ret != 0) {
+		h->records_failed++;
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
-  callback from tdb_traverse_read()
+  end a streaming traverse by appending an empty record to the last
+  batch of records
+ */
+static int ctdb_traverse_stream_end(struct ctdb_traverse_local_handle *h)
+{
+	h->recs = ctdb_marshall_add(h, h->recs, h->ctdb_db->db_id,
+				    h->client_reqid, tdb_null, NULL, tdb_null);
+	if (h->recs == NULL) {
+		return ENOMEM;
+	}
+
+	return ctdb_traverse_stream_flush(h);
+}
+
+/*
+  callback from tdb_traverse_read(), also called for each record of a
+  streaming traverse
  */
 static int ctdb_traverse_local_fn(struct tdb_context *tdb, TDB_DATA key, TDB_DATA data, void *p)
 {
@@ -134,6 +258,17 @@ static int ctdb_traverse_local_fn(struct tdb_context *tdb, TDB_DATA key, TDB_DAT
 		}
 	}
 
+	if (h->prefix.dsize > 0) {
+		if (key.dsize < h->prefix.dsize ||
+		    memcmp(key.dptr, h->prefix.dptr, h->prefix.dsize) != 0) {
+			return 0;
+		}
+	}
+
+	if (h->stream) {
+		return ctdb_traverse_stream_add(h, key, data);
+	}
+
 	d = ctdb_marshall_record(h, h->reqid, key, NULL, data);
 	if (d == NULL) {
 		/* error handling is tricky in this child code .... */
@@ -155,6 +290,54 @@ static int ctdb_traverse_local_fn(struct tdb_context *tdb, TDB_DATA key, TDB_DAT
 	return 0;
 }
 
+/*
+  streaming traverse of the local ltdb
+
+  Rather than tdb_traverse_read(), which holds the traverse lock and so
+  blocks transactions until it is done, walk the records with
+  tdb_firstkey()/tdb_nextkey(). When the window is used up we stop
+  after the current record and wait for credits holding only the read
+  lock on that record, which blocks neither writes nor transactions.
+  tdb_nextkey() then resumes from it, even if it was deleted meanwhile.
+ */
+static int ctdb_traverse_stream_local(struct ctdb_traverse_local_handle *h)
+{
+	struct tdb_context *tdb = h->ctdb_db->ltdb->tdb;
+	TDB_DATA key, next, data;
+	int ret;
+
+	key = tdb_firstkey(tdb);
+	while (key.dptr != NULL) {
+		data = tdb_fetch(tdb, key);
+		if (data.dptr != NULL) {
+			ret = ctdb_traverse_local_fn(tdb, key, data, h);
+			free(data.dptr);
+			if (ret != 0) {
+				free(key.dptr);
+				return -1;
+			}
+		}
+
+		next = tdb_nextkey(tdb, key);
+		if (next.dptr == NULL && tdb_exists(tdb, key) == 0) {
+			/*
+			 * With the last record gone, tdb_nextkey() may
+			 * have lost its place rather than reached the
+			 * end. Fail instead of returning a short traverse.
+			 */
+			DEBUG(DEBUG_ERR, ("Lost position in traverse "
+					  "db:%s reqid:%d\n",
+					  h->ctdb_db->db_name, h->reqid));
+			free(key.dptr);
+			return -1;
+		}
+		free(key.dptr);
+		key = next;
+	}
+
+	return 0;
+}
+
 struct traverse_all_state {
 	struct ctdb_context *ctdb;
 	struct ctdb_traverse_local_handle *h;
@@ -163,6 +346,9 @@ struct traverse_all_state {
 	uint32_t client_reqid;
 	uint64_t srvid;
 	bool withemptyrecords;
+	bool stream;
+	uint32_t window;
+	TDB_DATA prefix;
 };
 
 /*
@@ -208,6 +394,9 @@ static struct ctdb_traverse_local_handle *ctdb_traverse_local(struct ctdb_db_con
 	h->srvid = all_state->srvid;
 	h->srcnode = all_state->srcnode;
 	h->withemptyrecords = all_state->withemptyrecords;
+	h->stream = all_state->stream;
+	h->credits = all_state->window;
+	h->prefix = all_state->prefix;
 
 	if (h->child == 0) {
 		/* start the traverse in the child */
@@ -225,6 +414,19 @@ static struct ctdb_traverse_local_handle *ctdb_traverse_local(struct ctdb_db_con
 			_exit(0);
 		}
 
+		if (h->stream) {
+			uint64_t srvid = CTDB_SRVID_TRAVERSE_CREDIT |
+				((uint64_t)h->srcnode << 32) | h->reqid;
+
+			ret = ctdb_client_set_message_handler(
+				ctdb, srvid, ctdb_traverse_stream_credit, h);
+			if (ret != 0) {
+				res = 0;
+				sys_write(h->fd[1], &res, sizeof(int));
+				_exit(0);
+			}
+		}
+
 		d = ctdb_marshall_record(h, h->reqid, tdb_null, NULL, tdb_null);
 		if (d == NULL) {
 			res = 0;
@@ -232,7 +434,12 @@ static struct ctdb_traverse_local_handle *ctdb_traverse_local(struct ctdb_db_con
 			_exit(0);
 		}
 
-		res = tdb_traverse_read(ctdb_db->ltdb->tdb, ctdb_traverse_local_fn, h);
+		if (h->stream) {
+			res = ctdb_traverse_stream_local(h);
+		} else {
+			res = tdb_traverse_read(ctdb_db->ltdb->tdb,
+						ctdb_traverse_local_fn, h);
+		}
 		if (res == -1 || h->records_failed > 0) {
 			/* traverse failed */
 			res = -(h->records_sent);
@@ -240,21 +447,34 @@ static struct ctdb_traverse_local_handle *ctdb_traverse_local(struct ctdb_db_con
 			res = h->records_sent;
 		}
 
-		/* Wait till all the data is flushed from output queue */
-		while (ctdb_queue_length(ctdb->daemon.queue) > 0) {
-			tevent_loop_once(ctdb->ev);
-		}
+		if (h->stream) {
+			/* End traverse with the last batch of records */
+			ret = ctdb_traverse_stream_end(h);
+			if (ret != 0) {
+				if (res > 0) {
+					res = -res;
+				}
+			}
+		} else {
+			/*
+			 * Wait till all the data is flushed from output
+			 * queue
+			 */
+			while (ctdb_queue_length(ctdb->daemon.queue) > 0) {
+				tevent_loop_once(ctdb->ev);
+			}
 
-		/* End traverse by sending empty record */
-		outdata.dptr = (uint8_t *)d;
-		outdata.dsize = d->length;
-		ret = ctdb_control(ctdb, h->srcnode, 0,
-				   CTDB_CONTROL_TRAVERSE_DATA,
-				   CTDB_CTRL_FLAG_NOREPLY, outdata,
-				   NULL, NULL, &status, NULL, NULL);
-		if (ret == -1 || status == -1) {
-			if (res > 0) {
-				res = -res;
+			/* End traverse by sending empty record */
+			outdata.dptr = (uint8_t *)d;
+			outdata.dsize = d->length;
+			ret = ctdb_control(ctdb, h->srcnode, 0,
+					   CTDB_CONTROL_TRAVERSE_DATA,
+					   CTDB_CTRL_FLAG_NOREPLY, outdata,
+					   NULL, NULL, &status, NULL, NULL);
+			if (ret == -1 || status == -1) {
+				if (res > 0) {
+					res = -res;
+				}
 			}
 		}
 
@@ -318,6 +538,27 @@ static void ctdb_traverse_all_timeout(struct tevent_context *ev,
 }
 
 
+/*
+  persistent databases are only traversed on one node, preferably the
+  local one
+ */
+static uint32_t ctdb_traverse_persistent_node(struct ctdb_context *ctdb)
+{
+	int i;
+
+	/* check we are in the vnnmap */
+	for (i=0; i < ctdb->vnn_map->size; i++) {
+		if (ctdb->vnn_map->map[i] == ctdb->pnn) {
+			return ctdb->pnn;
+		}
+	}
+
+	/* if we are not in the vnn map we just pick the first
+	 * node instead
+	 */
+	return ctdb->vnn_map->map[0];
+}
+
 struct traverse_start_state {
 	struct ctdb_context *ctdb;
 	struct ctdb_traverse_all_handle *h;
@@ -390,23 +631,8 @@ static struct ctdb_traverse_all_handle *ctdb_daemon_traverse_all(struct ctdb_db_
 		/* normal database, traverse all nodes */	  
 		destination = CTDB_BROADCAST_VNNMAP;
 	} else {
-		int i;
-		/* persistent database, traverse one node, preferably
-		 * the local one
-		 */
-		destination = ctdb->pnn;
-		/* check we are in the vnnmap */
-		for (i=0; i < ctdb->vnn_map->size; i++) {
-			if (ctdb->vnn_map->map[i] == ctdb->pnn) {
-				break;
-			}
-		}
-		/* if we are not in the vnn map we just pick the first
-		 * node instead
-		 */
-		if (i == ctdb->vnn_map->size) {
-			destination = ctdb->vnn_map->map[0];
-		}
+		/* persistent database, traverse one node */
+		destination = ctdb_traverse_persistent_node(ctdb);
 	}
 
 	/* tell all the nodes in the cluster to start sending records to this
@@ -480,7 +706,7 @@ int32_t ctdb_control_traverse_all_ext(struct ctdb_context *ctdb, TDB_DATA data,
 				     ctdb_db->db_name, ctdb_db->unhealthy_reason));
 	}
 
-	state = talloc(ctdb_db, struct traverse_all_state);
+	state = talloc_zero(ctdb_db, struct traverse_all_state);
 	if (state == NULL) {
 		return -1;
 	}
@@ -532,7 +758,7 @@ int32_t ctdb_control_traverse_all(struct ctdb_context *ctdb, TDB_DATA data, TDB_
 				     ctdb_db->db_name, ctdb_db->unhealthy_reason));
 	}
 
-	state = talloc(ctdb_db, struct traverse_all_state);
+	state = talloc_zero(ctdb_db, struct traverse_all_state);
 	if (state == NULL) {
 		return -1;
 	}
@@ -779,3 +1005,453 @@ int32_t ctdb_control_traverse_start(struct ctdb_context *ctdb,
 
 	return ctdb_control_traverse_start_ext(ctdb, data2, outdata, srcnode, client_id);
 }
+
+
+/*
+  streaming traverse
+
+  Each node sends the records in batches as messages to the node that
+  started the traverse.  A node may have "window" batches in flight and
+  then waits for credits, which are only returned once the batches have
+  been queued to the client.  The last batch from each node ends with an
+  empty record.  The batches are forwarded to the client unchanged and
+  the traverse is ended by an empty batch.
+ */
+struct traverse_stream_node {
+	struct traverse_stream_state *state;
+	uint32_t pnn;
+	uint32_t unacked;
+	bool done;
+};
+
+struct traverse_stream_state {
+	struct ctdb_context *ctdb;
+	struct ctdb_db_context *ctdb_db;
+	struct ctdb_client *client;
+	uint32_t reqid;
+	uint32_t client_reqid;
+	uint64_t srvid;
+	uint32_t window;
+	struct traverse_stream_node *nodes;
+	unsigned int num_nodes;
+	unsigned int num_done;
+	struct tevent_timer *timeout_te;
+	struct tevent_timer *credit_te;
+	int num_records;
+	int num_batches;
+};
+
+static int traverse_stream_destructor(struct traverse_stream_state *state)
+{
+	struct ctdb_traverse_start r;
+	TDB_DATA data;
+
+	reqid_remove(state->ctdb->idr, state->reqid);
+
+	if (state->num_done == state->num_nodes) {
+		return 0;
+	}
+
+	DEBUG(DEBUG_ERR, (__location__ " Streaming traverse cancelled for "
+			  "database:0x%08x\n", state->ctdb_db->db_id));
+	r.db_id = state->ctdb_db->db_id;
+	r.reqid = state->client_reqid;
+	r.srvid = state->srvid;
+
+	data.dptr = (uint8_t *)&r;
+	data.dsize = sizeof(r);
+
+	ctdb_daemon_send_control(state->ctdb, CTDB_BROADCAST_CONNECTED, 0,
+				 CTDB_CONTROL_TRAVERSE_KILL,
+				 0, CTDB_CTRL_FLAG_NOREPLY, data, NULL, NULL);
+	return 0;
+}
+
+/*
+  an empty batch tells the client that the traverse has ended
+ */
+static void traverse_stream_send_end(struct traverse_stream_state *state)
+{
+	struct ctdb_marshall_buffer m;
+	TDB_DATA data;
+
+	m.db_id = state->ctdb_db->db_id;
+	m.count = 0;
+
+	data.dptr = (uint8_t *)&m;
+	data.dsize = offsetof(struct ctdb_marshall_buffer, data);
+
+	srvid_dispatch(state->ctdb->srv, state->srvid, 0, data);
+}
+
+static void traverse_stream_timeout(struct tevent_context *ev,
+				    struct tevent_timer *te,
+				    struct timeval t, void *private_data)
+{
+	struct traverse_stream_state *state = talloc_get_type_abort(
+		private_data, struct traverse_stream_state);
+
+	DEBUG(DEBUG_ERR, (__location__ " Streaming traverse timeout on "
+			  "database:%s\n", state->ctdb_db->db_name));
+	CTDB_INCREMENT_STAT(state->ctdb, timeouts.traverse);
+
+	traverse_stream_send_end(state);
+	talloc_free(state);
+}
+
+static void traverse_stream_progress(struct traverse_stream_state *state)
+{
+	struct ctdb_context *ctdb = state->ctdb;
+
+	TALLOC_FREE(state->timeout_te);
+	state->timeout_te = tevent_add_timer(
+		ctdb->ev, state,
+		timeval_current_ofs(ctdb->tunable.traverse_timeout, 0),
+		traverse_stream_timeout, state);
+}
+
+static void traverse_stream_done(struct tevent_context *ev,
+				 struct tevent_timer *te,
+				 struct timeval t, void *private_data)
+{
+	struct traverse_stream_state *state = talloc_get_type_abort(
+		private_data, struct traverse_stream_state);
+
+	DEBUG(DEBUG_NOTICE, ("Ending streaming traverse on DB %s (id %d), "
+			     "records %d, batches %d\n",
+			     state->ctdb_db->db_name, state->reqid,
+			     state->num_records, state->num_batches));
+
+	traverse_stream_send_end(state);
+	talloc_free(state);
+}
+
+static void traverse_stream_credit(struct traverse_stream_state *state);
+
+static void traverse_stream_credit_retry(struct tevent_context *ev,
+					 struct tevent_timer *te,
+					 struct timeval t, void *private_data)
+{
+	struct traverse_stream_state *state = talloc_get_type_abort(
+		private_data, struct traverse_stream_state);
+
+	state->credit_te = NULL;
+	traverse_stream_credit(state);
+}
+
+/*
+  return credits for the batches queued to the client, unless the
+  client is not keeping up
+ */
+static void traverse_stream_credit(struct traverse_stream_state *state)
+{
+	struct ctdb_context *ctdb = state->ctdb;
+	uint64_t srvid;
+	unsigned int i;
+	int ret;
+
+	if (ctdb_queue_length(state->client->queue) >= state->window) {
+		if (state->credit_te == NULL) {
+			state->credit_te = tevent_add_timer(
+				ctdb->ev, state, timeval_current_ofs_msec(10),
+				traverse_stream_credit_retry, state);
+		}
+		return;
+	}
+
+	srvid = CTDB_SRVID_TRAVERSE_CREDIT | ((uint64_t)ctdb->pnn << 32) |
+		state->reqid;
+
+	for (i=0; i<state->num_nodes; i++) {
+		struct traverse_stream_node *node = &state->nodes[i];
+		TDB_DATA data;
+
+		if (node->unacked == 0) {
+			continue;
+		}
+
+		data.dptr = (uint8_t *)&node->unacked;
+		data.dsize = sizeof(node->unacked);
+
+		ret = ctdb_daemon_send_message(ctdb, node->pnn, srvid, data);
+		if (ret != 0) {
+			DEBUG(DEBUG_ERR, ("Failed to send traverse credits "
+					  "to node %u\n", node->pnn));
+		}
+		node->unacked = 0;
+	}
+}
+
+static void traverse_stream_data_handler(uint64_t srvid, TDB_DATA data,
+					 void *private_data)
+{
+	struct traverse_stream_node *node =
+		(struct traverse_stream_node *)private_data;
+	struct traverse_stream_state *state = node->state;
+	struct ctdb_marshall_buffer *m;
+	struct ctdb_rec_data_old *r = NULL;
+	size_t offset, last = 0;
+	uint32_t i;
+
+	if (node->done) {
+		return;
+	}
+
+	offset = offsetof(struct ctdb_marshall_buffer, data);
+	if (data.dsize < offset) {
+		goto fail;
+	}
+
+	m = (struct ctdb_marshall_buffer *)data.dptr;
+	for (i=0; i<m->count; i++) {
+		if (data.dsize - offset <
+		    offsetof(struct ctdb_rec_data_old, data)) {
+			goto fail;
+		}
+		r = (struct ctdb_rec_data_old *)&data.dptr[offset];
+		if (r->length < offsetof(struct ctdb_rec_data_old, data) ||
+		    r->length > data.dsize - offset) {
+			goto fail;
+		}
+		last = offset;
+		offset += r->length;
+	}
+
+	traverse_stream_progress(state);
+
+	/* Strip the empty record ending the traverse on this node */
+	if (r != NULL && r->keylen == 0 && r->datalen == 0) {
+		m->count -= 1;
+		data.dsize = last;
+		node->done = true;
+	}
+
+	if (m->count > 0) {
+		srvid_dispatch(state->ctdb->srv, state->srvid, 0, data);
+		state->num_records += m->count;
+		state->num_batches += 1;
+	}
+
+	if (node->done) {
+		state->num_done += 1;
+		if (state->num_done == state->num_nodes) {
+			/* Do not free handlers from within srvid_dispatch */
+			tevent_add_timer(state->ctdb->ev, state,
+					 timeval_zero(),
+					 traverse_stream_done, state);
+		}
+		return;
+	}
+
+	node->unacked += 1;
+	traverse_stream_credit(state);
+	return;
+
+fail:
+	DEBUG(DEBUG_ERR, ("Bad record batch from node %u in streaming "
+			  "traverse\n", node->pnn));
+}
+
+/**
+ * start a streaming traverse_all - called as a control from a client.
+ */
+int32_t ctdb_control_traverse_start_stream(struct ctdb_context *ctdb,
+					   TDB_DATA indata,
+					   TDB_DATA *outdata,
+					   uint32_t srcnode,
+					   uint32_t client_id)
+{
+	struct ctdb_traverse_start_stream_old *d =
+		(struct ctdb_traverse_start_stream_old *)indata.dptr;
+	struct ctdb_traverse_all_stream_old *r;
+	struct traverse_stream_state *state;
+	struct ctdb_db_context *ctdb_db;
+	struct ctdb_client *client = reqid_find(ctdb->idr, client_id, struct ctdb_client);
+	size_t hdrlen = offsetof(struct ctdb_traverse_start_stream_old, prefix);
+	TDB_DATA data;
+	uint32_t destination;
+	unsigned int i;
+	int ret;
+
+	if (client == NULL) {
+		DEBUG(DEBUG_ERR,(__location__ " No client found\n"));
+		return -1;
+	}
+
+	if (indata.dsize < hdrlen || indata.dsize != hdrlen + d->prefix_len) {
+		DEBUG(DEBUG_ERR,("Bad record size in ctdb_control_traverse_start_stream\n"));
+		return -1;
+	}
+
+	ctdb_db = find_ctdb_db(ctdb, d->db_id);
+	if (ctdb_db == NULL) {
+		return -1;
+	}
+
+	if (ctdb_db->unhealthy_reason) {
+		if (ctdb->tunable.allow_unhealthy_db_read == 0) {
+			DEBUG(DEBUG_ERR,("db(%s) unhealty in ctdb_control_traverse_start_stream: %s\n",
+					ctdb_db->db_name, ctdb_db->unhealthy_reason));
+			return -1;
+		}
+		DEBUG(DEBUG_WARNING,("warn: db(%s) unhealty in ctdb_control_traverse_start_stream: %s\n",
+				     ctdb_db->db_name, ctdb_db->unhealthy_reason));
+	}
+
+	state = talloc_zero(client, struct traverse_stream_state);
+	if (state == NULL) {
+		return -1;
+	}
+
+	state->ctdb = ctdb;
+	state->ctdb_db = ctdb_db;
+	state->client = client;
+	state->reqid = reqid_new(ctdb->idr, state);
+	state->client_reqid = d->reqid;
+	state->srvid = d->srvid;
+	state->window = MAX(ctdb->tunable.traverse_window, 1);
+
+	talloc_set_destructor(state, traverse_stream_destructor);
+
+	if (ctdb_db_volatile(ctdb_db)) {
+		/* normal database, traverse all nodes */
+		destination = CTDB_BROADCAST_VNNMAP;
+		state->num_nodes = ctdb->vnn_map->size;
+	} else {
+		/* persistent database, traverse one node */
+		destination = ctdb_traverse_persistent_node(ctdb);
+		state->num_nodes = 1;
+	}
+
+	state->nodes = talloc_zero_array(state, struct traverse_stream_node,
+					 state->num_nodes);
+	if (state->nodes == NULL) {
+		goto fail;
+	}
+
+	for (i=0; i<state->num_nodes; i++) {
+		struct traverse_stream_node *node = &state->nodes[i];
+		uint64_t srvid;
+
+		node->state = state;
+		if (destination == CTDB_BROADCAST_VNNMAP) {
+			node->pnn = ctdb->vnn_map->map[i];
+		} else {
+			node->pnn = destination;
+		}
+
+		srvid = CTDB_SRVID_TRAVERSE_DATA |
+			((uint64_t)node->pnn << 32) | state->reqid;
+		ret = srvid_register(ctdb->srv, state, srvid,
+				     traverse_stream_data_handler, node);
+		if (ret != 0) {
+			goto fail;
+		}
+	}
+
+	data.dsize = offsetof(struct ctdb_traverse_all_stream_old, prefix) +
+		d->prefix_len;
+	data.dptr = talloc_zero_size(state, data.dsize);
+	if (data.dptr == NULL) {
+		goto fail;
+	}
+
+	r = (struct ctdb_traverse_all_stream_old *)data.dptr;
+	r->db_id = ctdb_db->db_id;
+	r->reqid = state->reqid;
+	r->pnn = ctdb->pnn;
+	r->client_reqid = d->reqid;
+	r->srvid = d->srvid;
+	r->window = state->window;
+	r->withemptyrecords = d->withemptyrecords;
+	r->prefix_len = d->prefix_len;
+	memcpy(r->prefix, d->prefix, d->prefix_len);
+
+	ret = ctdb_daemon_send_control(ctdb, destination, 0,
+				       CTDB_CONTROL_TRAVERSE_ALL_STREAM,
+				       0, CTDB_CTRL_FLAG_NOREPLY, data,
+				       NULL, NULL);
+	talloc_free(data.dptr);
+	if (ret != 0) {
+		goto fail;
+	}
+
+	DEBUG(DEBUG_NOTICE,("Starting streaming traverse on DB %s (id %d)\n",
+			    ctdb_db->db_name, state->reqid));
+
+	traverse_stream_progress(state);
+	return 0;
+
+fail:
+	/* No node is traversing yet */
+	state->num_done = state->num_nodes;
+	talloc_free(state);
+	return -1;
+}
+
+/*
+  called when a CTDB_CONTROL_TRAVERSE_ALL_STREAM control comes in. We
+  then setup a traverse of our local ltdb, sending the records in
+  batches as messages back to the originator
+ */
+int32_t ctdb_control_traverse_all_stream(struct ctdb_context *ctdb,
+					 TDB_DATA data, TDB_DATA *outdata)
+{
+	struct ctdb_traverse_all_stream_old *c =
+		(struct ctdb_traverse_all_stream_old *)data.dptr;
+	size_t hdrlen = offsetof(struct ctdb_traverse_all_stream_old, prefix);
+	struct traverse_all_state *state;
+	struct ctdb_db_context *ctdb_db;
+
+	if (data.dsize < hdrlen || data.dsize != hdrlen + c->prefix_len) {
+		DEBUG(DEBUG_ERR,(__location__ " Invalid size in ctdb_control_traverse_all_stream\n"));
+		return -1;
+	}
+
+	ctdb_db = find_ctdb_db(ctdb, c->db_id);
+	if (ctdb_db == NULL) {
+		return -1;
+	}
+
+	if (ctdb_db->unhealthy_reason) {
+		if (ctdb->tunable.allow_unhealthy_db_read == 0) {
+			DEBUG(DEBUG_ERR,("db(%s) unhealty in ctdb_control_traverse_all_stream: %s\n",
+					ctdb_db->db_name, ctdb_db->unhealthy_reason));
+			return -1;
+		}
+		DEBUG(DEBUG_WARNING,("warn: db(%s) unhealty in ctdb_control_traverse_all_stream: %s\n",
+				     ctdb_db->db_name, ctdb_db->unhealthy_reason));
+	}
+
+	state = talloc_zero(ctdb_db, struct traverse_all_state);
+	if (state == NULL) {
+		return -1;
+	}
+
+	state->reqid = c->reqid;
+	state->srcnode = c->pnn;
+	state->ctdb = ctdb;
+	state->client_reqid = c->client_reqid;
+	state->srvid = c->srvid;
+	state->withemptyrecords = c->withemptyrecords;
+	state->stream = true;
+	state->window = MAX(c->window, 1);
+
+	if (c->prefix_len > 0) {
+		state->prefix.dptr = talloc_memdup(state, c->prefix,
+						   c->prefix_len);
+		if (state->prefix.dptr == NULL) {
+			talloc_free(state);
+			return -1;
+		}
+		state->prefix.dsize = c->prefix_len;
+	}
+
+	state->h = ctdb_traverse_local(ctdb_db, traverse_all_callback, state);
+	if (state->h == NULL) {
+		talloc_free(state);
+		return -1;
+	}
+
+	return 0;
+}
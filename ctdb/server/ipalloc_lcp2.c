@@ -29,9 +29,30 @@
 
 #include "server/ipalloc_private.h"
 
+/*
+ * Cached state for the LCP2 algorithm.
+ *
+ * IPs are indexed in all_ips order.  For each IP the sum of the
+ * squared distances to the IPs currently hosted by each node is
+ * cached in dsums and is updated incrementally whenever an IP is
+ * moved.  This means that the cost of a candidate move can be looked
+ * up rather than recalculated by walking the whole IP list, which
+ * makes a takeover run with many addresses O(N^2) rather than O(N^3).
+ */
+struct lcp2_state {
+	struct ipalloc_state *ipalloc_state;
+	int num_ips;
+	uint32_t num_nodes;
+	struct public_ip_list **ips;
+	uint32_t *keys;		/* num_ips x IP_KEYLEN */
+	uint32_t *dsums;	/* num_ips x num_nodes */
+	uint32_t *imbalances;
+	bool *rebalance_candidates;
+};
+
 /*
  * This is the length of the longtest common prefix between the IPs.
- * It is calculated by XOR-ing the 2 IPs together and counting the
+ * It is calculated by XOR-ing the 2 IP keys together and counting the
  * number of leading zeroes.  The implementation means that all
  * addresses end up being 128 bits long.
  *
@@ -39,19 +60,15 @@
  * 12 bytes of 0 prefix padding will hurt the algorithm if there are
  * lots of nodes and IP addresses?
  */
-static uint32_t ip_distance(ctdb_sock_addr *ip1, ctdb_sock_addr *ip2)
+static uint32_t ip_distance(const uint32_t *k1, const uint32_t *k2)
 {
-	uint32_t ip1_k[IP_KEYLEN];
-	uint32_t *t;
 	int i;
 	uint32_t x;
 
 	uint32_t distance = 0;
 
-	memcpy(ip1_k, ip_key(ip1), sizeof(ip1_k));
-	t = ip_key(ip2);
 	for (i=0; i<IP_KEYLEN; i++) {
-		x = ip1_k[i] ^ t[i];
+		x = k1[i] ^ k2[i];
 		if (x == 0) {
 			distance += 32;
 		} else {
@@ -68,91 +85,134 @@ static uint32_t ip_distance(ctdb_sock_addr *ip1, ctdb_sock_addr *ip2)
 	return distance;
 }
 
-/* Calculate the IP distance for the given IP relative to IPs on the
-   given node.  The ips argument is generally the all_ips variable
-   used in the main part of the algorithm.
- */
-static uint32_t ip_distance_2_sum(ctdb_sock_addr *ip,
-				  struct public_ip_list *ips,
-				  int pnn)
+static uint32_t lcp2_ip_distance_2(struct lcp2_state *lcp2, int i, int j)
 {
-	struct public_ip_list *t;
 	uint32_t d;
 
-	uint32_t sum = 0;
-
-	for (t = ips; t != NULL; t = t->next) {
-		if (t->pnn != pnn) {
-			continue;
-		}
+	d = ip_distance(&lcp2->keys[i * IP_KEYLEN],
+			&lcp2->keys[j * IP_KEYLEN]);
 
-		/* Optimisation: We never calculate the distance
-		 * between an address and itself.  This allows us to
-		 * calculate the effect of removing an address from a
-		 * node by simply calculating the distance between
-		 * that address and all of the exitsing addresses.
-		 * Moreover, we assume that we're only ever dealing
-		 * with addresses from all_ips so we can identify an
-		 * address via a pointer rather than doing a more
-		 * expensive address comparison. */
-		if (&(t->addr) == ip) {
-			continue;
-		}
-
-		d = ip_distance(ip, &(t->addr));
-		sum += d * d;  /* Cheaper than pulling in math.h :-) */
-	}
-
-	return sum;
+	return d * d;  /* Cheaper than pulling in math.h :-) */
 }
 
-/* Return the LCP2 imbalance metric for addresses currently assigned
-   to the given node.
+/* Return the sum of the squared IP distances between the IP with the
+ * given index and the IPs currently hosted by the given node.  The
+ * IP itself is never included, so this is both the cost of adding
+ * the IP to a node and the saving from removing it from its current
+ * node.
  */
-static uint32_t lcp2_imbalance(struct public_ip_list * all_ips, int pnn)
+static uint32_t lcp2_dsum(struct lcp2_state *lcp2, int i, uint32_t pnn)
 {
-	struct public_ip_list *t;
+	return lcp2->dsums[i * lcp2->num_nodes + pnn];
+}
 
-	uint32_t imbalance = 0;
+/* Move the IP with the given index to dstnode, updating the cached
+ * distance sums of all other IPs.  Node imbalances are updated by
+ * the caller, since it has already calculated them.
+ */
+static void lcp2_move_ip(struct lcp2_state *lcp2, int i, uint32_t dstnode)
+{
+	uint32_t srcnode = lcp2->ips[i]->pnn;
+	uint32_t *dsums;
+	uint32_t d2;
+	int j;
 
-	for (t = all_ips; t != NULL; t = t->next) {
-		if (t->pnn != pnn) {
+	for (j = 0; j < lcp2->num_ips; j++) {
+		if (j == i) {
 			continue;
 		}
-		/* Pass the rest of the IPs rather than the whole
-		   all_ips input list.
-		*/
-		imbalance += ip_distance_2_sum(&(t->addr), t->next, pnn);
+
+		d2 = lcp2_ip_distance_2(lcp2, i, j);
+		dsums = &lcp2->dsums[j * lcp2->num_nodes];
+		if (srcnode != -1) {
+			dsums[srcnode] -= d2;
+		}
+		dsums[dstnode] += d2;
 	}
 
-	return imbalance;
+	lcp2->ips[i]->pnn = dstnode;
 }
 
 static bool lcp2_init(struct ipalloc_state *ipalloc_state,
-		      uint32_t **lcp2_imbalances,
-		      bool **rebalance_candidates)
+		      struct lcp2_state **lcp2_out)
 {
-	int i, numnodes;
+	struct lcp2_state *lcp2;
+	int i, j, num_ips;
+	uint32_t numnodes, pnn_i, pnn_j, d2;
 	struct public_ip_list *t;
 
 	numnodes = ipalloc_state->num;
 
-	*rebalance_candidates = talloc_array(ipalloc_state, bool, numnodes);
-	if (*rebalance_candidates == NULL) {
-		DEBUG(DEBUG_ERR, (__location__ " out of memory\n"));
-		return false;
+	num_ips = 0;
+	for (t = ipalloc_state->all_ips; t != NULL; t = t->next) {
+		num_ips++;
 	}
-	*lcp2_imbalances = talloc_array(ipalloc_state, uint32_t, numnodes);
-	if (*lcp2_imbalances == NULL) {
+
+	lcp2 = talloc_zero(ipalloc_state, struct lcp2_state);
+	if (lcp2 == NULL) {
 		DEBUG(DEBUG_ERR, (__location__ " out of memory\n"));
 		return false;
 	}
+	lcp2->ipalloc_state = ipalloc_state;
+	lcp2->num_ips = num_ips;
+	lcp2->num_nodes = numnodes;
+
+	lcp2->rebalance_candidates = talloc_array(lcp2, bool, numnodes);
+	if (lcp2->rebalance_candidates == NULL) {
+		goto fail;
+	}
+	lcp2->imbalances = talloc_zero_array(lcp2, uint32_t, numnodes);
+	if (lcp2->imbalances == NULL) {
+		goto fail;
+	}
+	lcp2->ips = talloc_array(lcp2, struct public_ip_list *, num_ips);
+	if (lcp2->ips == NULL) {
+		goto fail;
+	}
+	lcp2->keys = talloc_array(lcp2, uint32_t, num_ips * IP_KEYLEN);
+	if (lcp2->keys == NULL) {
+		goto fail;
+	}
+	lcp2->dsums = talloc_zero_array(lcp2, uint32_t, num_ips * numnodes);
+	if (lcp2->dsums == NULL) {
+		goto fail;
+	}
+
+	for (i = 0, t = ipalloc_state->all_ips; t != NULL; i++, t = t->next) {
+		lcp2->ips[i] = t;
+		memcpy(&lcp2->keys[i * IP_KEYLEN], ip_key(&t->addr),
+		       IP_KEYLEN * sizeof(uint32_t));
+	}
+
+	/* Each pair of IPs contributes its squared distance to the
+	 * distance sum of each IP relative to the node hosting the
+	 * other IP.  Pairs hosted by the same node also contribute to
+	 * that node's imbalance.
+	 */
+	for (i = 0; i < num_ips; i++) {
+		pnn_i = lcp2->ips[i]->pnn;
+		for (j = i + 1; j < num_ips; j++) {
+			pnn_j = lcp2->ips[j]->pnn;
+			if (pnn_i == -1 && pnn_j == -1) {
+				continue;
+			}
+
+			d2 = lcp2_ip_distance_2(lcp2, i, j);
+			if (pnn_j != -1) {
+				lcp2->dsums[i * numnodes + pnn_j] += d2;
+			}
+			if (pnn_i != -1) {
+				lcp2->dsums[j * numnodes + pnn_i] += d2;
+			}
+			if (pnn_i != -1 && pnn_i == pnn_j) {
+				lcp2->imbalances[pnn_i] += d2;
+			}
+		}
+	}
 
 	for (i=0; i<numnodes; i++) {
-		(*lcp2_imbalances)[i] =
-			lcp2_imbalance(ipalloc_state->all_ips, i);
 		/* First step: assume all nodes are candidates */
-		(*rebalance_candidates)[i] = true;
+		lcp2->rebalance_candidates[i] = true;
 	}
 
 	/* 2nd step: if a node has IPs assigned then it must have been
@@ -164,10 +224,12 @@ static bool lcp2_init(struct ipalloc_state *ipalloc_state,
 	 */
 	for (t = ipalloc_state->all_ips; t != NULL; t = t->next) {
 		if (t->pnn != -1) {
-			(*rebalance_candidates)[t->pnn] = false;
+			lcp2->rebalance_candidates[t->pnn] = false;
 		}
 	}
 
+	*lcp2_out = lcp2;
+
 	/* 3rd step: if a node is forced to re-balance then
 	   we allow failback onto the node */
 	if (ipalloc_state->force_rebalance_nodes == NULL) {
@@ -185,25 +247,30 @@ static bool lcp2_init(struct ipalloc_state *ipalloc_state,
 
 		DEBUG(DEBUG_NOTICE,
 		      ("Forcing rebalancing of IPs to node %u\n", pnn));
-		(*rebalance_candidates)[pnn] = true;
+		lcp2->rebalance_candidates[pnn] = true;
 	}
 
 	return true;
+
+fail:
+	DEBUG(DEBUG_ERR, (__location__ " out of memory\n"));
+	talloc_free(lcp2);
+	return false;
 }
 
 /* Allocate any unassigned addresses using the LCP2 algorithm to find
  * the IP/node combination that will cost the least.
  */
-static void lcp2_allocate_unassigned(struct ipalloc_state *ipalloc_state,
-				     uint32_t *lcp2_imbalances)
+static void lcp2_allocate_unassigned(struct lcp2_state *lcp2)
 {
+	struct ipalloc_state *ipalloc_state = lcp2->ipalloc_state;
+	uint32_t *lcp2_imbalances = lcp2->imbalances;
 	struct public_ip_list *t;
-	int dstnode, numnodes;
+	int i, dstnode, numnodes;
 
-	int minnode;
+	int minnode, minidx;
 	uint32_t mindsum, dstdsum, dstimbl;
 	uint32_t minimbl = 0;
-	struct public_ip_list *minip;
 
 	bool should_loop = true;
 	bool have_unassigned = true;
@@ -218,10 +285,11 @@ static void lcp2_allocate_unassigned(struct ipalloc_state *ipalloc_state,
 
 		minnode = -1;
 		mindsum = 0;
-		minip = NULL;
+		minidx = -1;
 
 		/* loop over each unassigned ip. */
-		for (t = ipalloc_state->all_ips; t != NULL ; t = t->next) {
+		for (i = 0; i < lcp2->num_ips; i++) {
+			t = lcp2->ips[i];
 			if (t->pnn != -1) {
 				continue;
 			}
@@ -235,9 +303,7 @@ static void lcp2_allocate_unassigned(struct ipalloc_state *ipalloc_state,
 					continue;
 				}
 
-				dstdsum = ip_distance_2_sum(&(t->addr),
-							    ipalloc_state->all_ips,
-							    dstnode);
+				dstdsum = lcp2_dsum(lcp2, i, dstnode);
 				dstimbl = lcp2_imbalances[dstnode] + dstdsum;
 				DEBUG(DEBUG_DEBUG,
 				      (" %s -> %d [+%d]\n",
@@ -252,7 +318,7 @@ static void lcp2_allocate_unassigned(struct ipalloc_state *ipalloc_state,
 					minnode = dstnode;
 					minimbl = dstimbl;
 					mindsum = dstdsum;
-					minip = t;
+					minidx = i;
 					should_loop = true;
 				}
 			}
@@ -262,12 +328,13 @@ static void lcp2_allocate_unassigned(struct ipalloc_state *ipalloc_state,
 
 		/* If we found one then assign it to the given node. */
 		if (minnode != -1) {
-			minip->pnn = minnode;
+			lcp2_move_ip(lcp2, minidx, minnode);
 			lcp2_imbalances[minnode] = minimbl;
 			DEBUG(DEBUG_INFO,(" %s -> %d [+%d]\n",
 					  ctdb_sock_addr_to_string(
 						  ipalloc_state,
-						  &(minip->addr), false),
+						  &(lcp2->ips[minidx]->addr),
+						  false),
 					  minnode,
 					  mindsum));
 		}
@@ -301,20 +368,19 @@ static void lcp2_allocate_unassigned(struct ipalloc_state *ipalloc_state,
  * to move IPs from, determines the best IP/destination node
  * combination to move from the source node.
  */
-static bool lcp2_failback_candidate(struct ipalloc_state *ipalloc_state,
-				    int srcnode,
-				    uint32_t *lcp2_imbalances,
-				    bool *rebalance_candidates)
+static bool lcp2_failback_candidate(struct lcp2_state *lcp2, int srcnode)
 {
-	int dstnode, mindstnode, numnodes;
+	struct ipalloc_state *ipalloc_state = lcp2->ipalloc_state;
+	uint32_t *lcp2_imbalances = lcp2->imbalances;
+	bool *rebalance_candidates = lcp2->rebalance_candidates;
+	int i, dstnode, mindstnode, minidx, numnodes;
 	uint32_t srcimbl, srcdsum, dstimbl, dstdsum;
 	uint32_t minsrcimbl, mindstimbl;
-	struct public_ip_list *minip;
 	struct public_ip_list *t;
 
 	/* Find an IP and destination node that best reduces imbalance. */
 	srcimbl = 0;
-	minip = NULL;
+	minidx = -1;
 	minsrcimbl = 0;
 	mindstnode = -1;
 	mindstimbl = 0;
@@ -325,16 +391,15 @@ static bool lcp2_failback_candidate(struct ipalloc_state *ipalloc_state,
 	DEBUG(DEBUG_DEBUG,(" CONSIDERING MOVES FROM %d [%d]\n",
 			   srcnode, lcp2_imbalances[srcnode]));
 
-	for (t = ipalloc_state->all_ips; t != NULL; t = t->next) {
+	for (i = 0; i < lcp2->num_ips; i++) {
+		t = lcp2->ips[i];
 		/* Only consider addresses on srcnode. */
 		if (t->pnn != srcnode) {
 			continue;
 		}
 
 		/* What is this IP address costing the source node? */
-		srcdsum = ip_distance_2_sum(&(t->addr),
-					    ipalloc_state->all_ips,
-					    srcnode);
+		srcdsum = lcp2_dsum(lcp2, i, srcnode);
 		srcimbl = lcp2_imbalances[srcnode] - srcdsum;
 
 		/* Consider this IP address would cost each potential
@@ -355,9 +420,7 @@ static bool lcp2_failback_candidate(struct ipalloc_state *ipalloc_state,
 				continue;
 			}
 
-			dstdsum = ip_distance_2_sum(&(t->addr),
-						    ipalloc_state->all_ips,
-						    dstnode);
+			dstdsum = lcp2_dsum(lcp2, i, dstnode);
 			dstimbl = lcp2_imbalances[dstnode] + dstdsum;
 			DEBUG(DEBUG_DEBUG,(" %d [%d] -> %s -> %d [+%d]\n",
 					   srcnode, -srcdsum,
@@ -371,7 +434,7 @@ static bool lcp2_failback_candidate(struct ipalloc_state *ipalloc_state,
 			    ((mindstnode == -1) ||				\
 			     ((srcimbl + dstimbl) < (minsrcimbl + mindstimbl)))) {
 
-				minip = t;
+				minidx = i;
 				minsrcimbl = srcimbl;
 				mindstnode = dstnode;
 				mindstimbl = dstimbl;
@@ -386,13 +449,14 @@ static bool lcp2_failback_candidate(struct ipalloc_state *ipalloc_state,
 		      ("%d [%d] -> %s -> %d [+%d]\n",
 		       srcnode, minsrcimbl - lcp2_imbalances[srcnode],
 		       ctdb_sock_addr_to_string(ipalloc_state,
-						&(minip->addr), false),
+						&(lcp2->ips[minidx]->addr),
+						false),
 		       mindstnode, mindstimbl - lcp2_imbalances[mindstnode]));
 
 
 		lcp2_imbalances[srcnode] = minsrcimbl;
 		lcp2_imbalances[mindstnode] = mindstimbl;
-		minip->pnn = mindstnode;
+		lcp2_move_ip(lcp2, minidx, mindstnode);
 
 		return true;
 	}
@@ -423,15 +487,14 @@ static int lcp2_cmp_imbalance_pnn(const void * a, const void * b)
  * node with the highest LCP2 imbalance, and then determines the best
  * IP/destination node combination to move from the source node.
  */
-static void lcp2_failback(struct ipalloc_state *ipalloc_state,
-			  uint32_t *lcp2_imbalances,
-			  bool *rebalance_candidates)
+static void lcp2_failback(struct lcp2_state *lcp2)
 {
+	uint32_t *lcp2_imbalances = lcp2->imbalances;
 	int i, numnodes;
 	struct lcp2_imbalance_pnn * lips;
 	bool again;
 
-	numnodes = ipalloc_state->num;
+	numnodes = lcp2->num_nodes;
 
 try_again:
 	/* Put the imbalances and nodes into an array, sort them and
@@ -440,7 +503,7 @@ try_again:
 	 */
 	DEBUG(DEBUG_DEBUG,("+++++++++++++++++++++++++++++++++++++++++\n"));
 	DEBUG(DEBUG_DEBUG,("Selecting most imbalanced node from:\n"));
-	lips = talloc_array(ipalloc_state, struct lcp2_imbalance_pnn, numnodes);
+	lips = talloc_array(lcp2, struct lcp2_imbalance_pnn, numnodes);
 	for (i = 0; i < numnodes; i++) {
 		lips[i].imbalance = lcp2_imbalances[i];
 		lips[i].pnn = i;
@@ -458,10 +521,7 @@ try_again:
 			break;
 		}
 
-		if (lcp2_failback_candidate(ipalloc_state,
-					    lips[i].pnn,
-					    lcp2_imbalances,
-					    rebalance_candidates)) {
+		if (lcp2_failback_candidate(lcp2, lips[i].pnn)) {
 			again = true;
 			break;
 		}
@@ -475,20 +535,18 @@ try_again:
 
 bool ipalloc_lcp2(struct ipalloc_state *ipalloc_state)
 {
-	uint32_t *lcp2_imbalances;
-	bool *rebalance_candidates;
+	struct lcp2_state *lcp2 = NULL;
 	int numnodes, num_rebalance_candidates, i;
 	bool ret = true;
 
 	unassign_unsuitable_ips(ipalloc_state);
 
-	if (!lcp2_init(ipalloc_state,
-		       &lcp2_imbalances, &rebalance_candidates)) {
+	if (!lcp2_init(ipalloc_state, &lcp2)) {
 		ret = false;
 		goto finished;
 	}
 
-	lcp2_allocate_unassigned(ipalloc_state, lcp2_imbalances);
+	lcp2_allocate_unassigned(lcp2);
 
 	/* If we don't want IPs to fail back then don't rebalance IPs. */
 	if (ipalloc_state->no_ip_failback) {
@@ -502,7 +560,7 @@ bool ipalloc_lcp2(struct ipalloc_state *ipalloc_state)
 	numnodes = ipalloc_state->num;
 	num_rebalance_candidates = 0;
 	for (i=0; i<numnodes; i++) {
-		if (rebalance_candidates[i]) {
+		if (lcp2->rebalance_candidates[i]) {
 			num_rebalance_candidates++;
 		}
 	}
@@ -513,8 +571,9 @@ bool ipalloc_lcp2(struct ipalloc_state *ipalloc_state)
 	/* Now, try to make sure the ip adresses are evenly distributed
 	   across the nodes.
 	*/
-	lcp2_failback(ipalloc_state, lcp2_imbalances, rebalance_candidates);
+	lcp2_failback(lcp2);
 
 finished:
+	talloc_free(lcp2);
 	return ret;
 }
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+test_info()
+{
+    cat <<EOF
+Run the fetch_many test and sanity check the output.
+
+This measures the latency of locking a set of records that keep
+moving between nodes, with and without batched record migration.
+
+Prerequisites:
+
+* An active CTDB cluster with at least 2 active nodes.
+EOF
+}
+
+. "${TEST_SCRIPTS_DIR}/integration.bash"
+
+ctdb_test_init "$@"
+
+set -e
+
+cluster_is_healthy
+
+try_command_on_node 0 "$CTDB listnodes"
+num_nodes=$(echo "$out" | wc -l)
+
+if [ -z "$CTDB_TEST_TIMELIMIT" ] ; then
+    CTDB_TEST_TIMELIMIT=10
+fi
+
+echo "Running fetch_many on all $num_nodes nodes."
+try_command_on_node -v -p all $CTDB_TEST_WRAPPER $VALGRIND fetch_many \
+	-n $num_nodes -t $CTDB_TEST_TIMELIMIT
+
+pat='^(Waiting for cluster|(Sequential|Batched)\[[[:digit:]]+\]: [[:digit:]]+ batches of [[:digit:]]+ records, [[:digit:]]+(\.[[:digit:]]+)? ms/batch)$'
+sanity_check_output 2 "$pat" "$out"
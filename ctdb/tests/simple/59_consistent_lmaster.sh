@@ -0,0 +1,110 @@
+#!/bin/bash
+
+test_info()
+{
+    cat <<EOF
+Verify that the ConsistentLMaster tunable is pushed from the recovery
+master to all nodes during recovery and that records stay accessible
+after switching the lmaster mapping.
+
+Prerequisites:
+
+* An active CTDB cluster with at least 2 active nodes.
+
+Steps:
+
+1. Create a test database and store records from all nodes
+2. Set ConsistentLMaster to 1 on the recovery master only
+3. Force a recovery
+4. Verify that ConsistentLMaster is 1 on all nodes
+5. Stop a node, update and read back the records from all active nodes
+
+Expected results:
+
+* All nodes use the lmaster mapping of the recovery master and the
+  records are readable and writable from all nodes.
+EOF
+}
+
+. "${TEST_SCRIPTS_DIR}/integration.bash"
+
+ctdb_test_init "$@"
+
+set -e
+
+cluster_is_healthy
+
+# Reset configuration
+ctdb_restart_when_done
+
+TESTDB="lmaster_test.tdb"
+
+try_command_on_node 0 "$CTDB listnodes | wc -l"
+num_nodes="$out"
+
+try_command_on_node any $CTDB recmaster
+recmaster="$out"
+
+echo "create test database $TESTDB"
+try_command_on_node 0 $CTDB attach $TESTDB
+
+store_and_check ()
+{
+    local value="$1"
+    local pnn keys num
+
+    keys=""
+    for pnn in $active_pnns ; do
+	keys="$keys $(seq -f "key${pnn}-%g" 1 10)"
+    done
+
+    for pnn in $active_pnns ; do
+	try_command_on_node $pnn \
+	    "for k in $(seq -f "key${pnn}-%g" 1 10 | xargs) ; do \
+		$CTDB writekey $TESTDB \$k $value ; done"
+    done
+
+    for pnn in $active_pnns ; do
+	try_command_on_node $pnn \
+	    "for k in $(echo $keys) ; do $CTDB readkey $TESTDB \$k ; done"
+	num=$(echo "$out" | grep -c "^Data: size:${#value} ptr:\[${value}\]$")
+	if [ "$num" != "$(echo $keys | wc -w)" ] ; then
+	    echo "BAD: node $pnn read $num records with value $value"
+	    echo "$out"
+	    exit 1
+	fi
+    done
+}
+
+active_pnns=$(seq 0 $((num_nodes - 1)))
+store_and_check "value1"
+
+echo "Setting ConsistentLMaster=1 on recmaster node $recmaster"
+try_command_on_node $recmaster $CTDB setvar ConsistentLMaster 1
+
+echo "force recovery"
+try_command_on_node $recmaster $CTDB recover
+wait_until_node_has_status $recmaster recovered
+
+echo "Checking ConsistentLMaster on all nodes"
+try_command_on_node -v all $CTDB getvar ConsistentLMaster
+if [ $(echo "$out" | grep -c "^ConsistentLMaster *= 1$") -ne $num_nodes ] ; then
+    echo "BAD: ConsistentLMaster not set on all nodes"
+    exit 1
+fi
+
+store_and_check "value2"
+
+stopped=$(( (recmaster + 1) % num_nodes ))
+echo "stop node $stopped"
+try_command_on_node $stopped $CTDB stop
+wait_until_node_has_status $stopped stopped
+
+active_pnns=$(echo "$active_pnns" | grep -vx "$stopped")
+store_and_check "value3"
+
+echo "continue node $stopped"
+try_command_on_node $stopped $CTDB continue
+wait_until_node_has_status $stopped notstopped
+
+echo "GOOD: records accessible with consistent lmaster mapping"
@@ -0,0 +1,43 @@
+#!/bin/bash
+
+test_info()
+{
+    cat <<EOF
+Run the traverse_stream test and sanity check the output.
+
+This compares the throughput of the old and the streaming cluster-wide
+traverse, and how much the memory use of ctdbd grows during a traverse
+with a slow client.
+
+Prerequisites:
+
+* An active CTDB cluster with at least 2 active nodes.
+EOF
+}
+
+. "${TEST_SCRIPTS_DIR}/integration.bash"
+
+ctdb_test_init "$@"
+
+set -e
+
+cluster_is_healthy
+
+# Reset configuration
+ctdb_restart_when_done
+
+try_command_on_node 0 "$CTDB listnodes"
+num_nodes=$(echo "$out" | wc -l)
+
+# Use small batches, so that the window is small compared to the database
+try_command_on_node all $CTDB setvar RecBufferSizeLimit 65536
+
+try_command_on_node 0 $CTDB attach traverse_stream.tdb
+try_command_on_node 0 $CTDB wipedb traverse_stream.tdb
+
+echo "Running traverse_stream on all $num_nodes nodes."
+try_command_on_node -v -p all $CTDB_TEST_WRAPPER $VALGRIND traverse_stream \
+	-n $num_nodes
+
+pat='^(Waiting for cluster|(Slow stream traverse|Slow traverse)\[0\]: [[:digit:]]+ records, ctdbd memory \+-?[[:digit:]]+ kB|(Stream traverse|Traverse)\[0\]: [[:digit:]]+ records, [[:digit:]]+ records/sec)$'
+sanity_check_output 4 "$pat" "$out"
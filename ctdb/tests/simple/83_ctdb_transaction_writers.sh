@@ -0,0 +1,42 @@
+#!/bin/bash
+
+test_info()
+{
+    cat <<EOF
+Run the transaction_writers test and sanity check the output.
+
+This compares the throughput of a single writer process with that of
+many concurrent writer processes on a persistent database, and checks
+that no transaction is lost when ctdbd replicates concurrent commits
+together.
+
+Prerequisites:
+
+* An active CTDB cluster with at least 2 active nodes.
+EOF
+}
+
+. "${TEST_SCRIPTS_DIR}/integration.bash"
+
+ctdb_test_init "$@"
+
+set -e
+
+cluster_is_healthy
+
+TESTDB="transaction_writers.tdb"
+
+try_command_on_node 0 "$CTDB attach $TESTDB persistent"
+try_command_on_node 0 "$CTDB wipedb $TESTDB"
+
+try_command_on_node 0 "$CTDB listnodes"
+num_nodes=$(echo "$out" | wc -l)
+
+t="$CTDB_TEST_WRAPPER $VALGRIND transaction_writers \
+	-n ${num_nodes} -D ${TESTDB} -T persistent -k testkey"
+
+echo "Running transaction_writers on all $num_nodes nodes."
+try_command_on_node -v -p all "$t"
+
+pat='^(Waiting for cluster|Transaction writers\[[[:digit:]]+\]: [[:digit:]]+ writers, [[:digit:]]+ transactions, [[:digit:]]+ transactions/sec)$'
+sanity_check_output $((num_nodes * 2)) "$pat" "$out"
@@ -0,0 +1,215 @@
+/*
+   ctdb record migration latency benchmark
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "replace.h"
+#include "system/network.h"
+#include "system/time.h"
+
+#include "lib/util/tevent_unix.h"
+#include "lib/util/time.h"
+
+#include "client/client.h"
+#include "tests/src/test_options.h"
+#include "tests/src/cluster_wait.h"
+
+#define TESTDB		"fetch_many.tdb"
+#define NUM_KEYS	16
+
+/*
+ * Every node repeatedly locks and updates the same set of NUM_KEYS
+ * records, so the records keep moving between the nodes.  This is run
+ * twice: first locking the records one after the other, which
+ * migrates each record separately, then migrating the whole set with
+ * ctdb_migrate_records() before locking them.
+ */
+
+static int fetch_many_update(TALLOC_CTX *mem_ctx,
+			     struct tevent_context *ev,
+			     struct ctdb_client_context *client,
+			     struct ctdb_db_context *ctdb_db,
+			     TDB_DATA *keys, int num_keys)
+{
+	struct ctdb_record_handle *h;
+	TDB_DATA data;
+	uint32_t count;
+	int ret, i;
+
+	for (i=0; i<num_keys; i++) {
+		ret = ctdb_fetch_lock(mem_ctx, ev, client, ctdb_db, keys[i],
+				      false, &h, NULL, &data);
+		if (ret != 0) {
+			fprintf(stderr, "Failed to fetch record, ret=%d\n",
+				ret);
+			return ret;
+		}
+
+		count = 0;
+		if (data.dsize == sizeof(uint32_t)) {
+			count = *(uint32_t *)data.dptr;
+		}
+		TALLOC_FREE(data.dptr);
+
+		count += 1;
+		data.dsize = sizeof(uint32_t);
+		data.dptr = (uint8_t *)&count;
+
+		ret = ctdb_store_record(h, data);
+		talloc_free(h);
+		if (ret != 0) {
+			fprintf(stderr, "Failed to store record, ret=%d\n",
+				ret);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int fetch_many_run(TALLOC_CTX *mem_ctx,
+			  struct tevent_context *ev,
+			  struct ctdb_client_context *client,
+			  struct ctdb_db_context *ctdb_db,
+			  TDB_DATA *keys, int num_keys,
+			  bool batched, int timelimit)
+{
+	struct timeval start;
+	double elapsed;
+	int count = 0;
+	int ret;
+
+	start = tevent_timeval_current();
+
+	do {
+		if (batched) {
+			ret = ctdb_migrate_records(mem_ctx, ev, client,
+						   ctdb_db, keys, num_keys);
+			if (ret != 0) {
+				fprintf(stderr,
+					"Failed to migrate records, ret=%d\n",
+					ret);
+				return ret;
+			}
+		}
+
+		ret = fetch_many_update(mem_ctx, ev, client, ctdb_db,
+					keys, num_keys);
+		if (ret != 0) {
+			return ret;
+		}
+
+		count += 1;
+		elapsed = timeval_elapsed(&start);
+	} while (elapsed < timelimit);
+
+	printf("%s[%u]: %d batches of %d records, %.3f ms/batch\n",
+	       batched ? "Batched" : "Sequential",
+	       ctdb_client_pnn(client), count, num_keys,
+	       elapsed * 1000.0 / count);
+	fflush(stdout);
+
+	return 0;
+}
+
+int main(int argc, const char *argv[])
+{
+	const struct test_options *opts;
+	TALLOC_CTX *mem_ctx;
+	struct tevent_context *ev;
+	struct ctdb_client_context *client;
+	struct ctdb_db_context *ctdb_db;
+	struct tevent_req *req;
+	TDB_DATA keys[NUM_KEYS];
+	int ret, i;
+	bool status;
+
+	status = process_options_basic(argc, argv, &opts);
+	if (! status) {
+		exit(1);
+	}
+
+	mem_ctx = talloc_new(NULL);
+	if (mem_ctx == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ev = tevent_context_init(mem_ctx);
+	if (ev == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ret = ctdb_client_init(mem_ctx, ev, opts->socket, &client);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to initialize client, ret=%d\n", ret);
+		exit(1);
+	}
+
+	if (! ctdb_recovery_wait(ev, client)) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ret = ctdb_attach(ev, client, tevent_timeval_zero(), TESTDB, 0,
+			  &ctdb_db);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to attach to DB %s\n", TESTDB);
+		exit(1);
+	}
+
+	for (i=0; i<NUM_KEYS; i++) {
+		keys[i].dptr = (uint8_t *)talloc_asprintf(mem_ctx,
+							  "testkey-%d", i);
+		if (keys[i].dptr == NULL) {
+			fprintf(stderr, "Memory allocation error\n");
+			exit(1);
+		}
+		keys[i].dsize = strlen((char *)keys[i].dptr);
+	}
+
+	req = cluster_wait_send(mem_ctx, ev, client, opts->num_nodes);
+	if (req == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	tevent_req_poll(req, ev);
+
+	status = cluster_wait_recv(req, &ret);
+	if (! status) {
+		fprintf(stderr, "Failed to wait for cluster, ret=%d\n", ret);
+		exit(1);
+	}
+	talloc_free(req);
+
+	ret = fetch_many_run(mem_ctx, ev, client, ctdb_db, keys, NUM_KEYS,
+			     false, opts->timelimit);
+	if (ret != 0) {
+		fprintf(stderr, "fetch many test failed\n");
+		exit(1);
+	}
+
+	ret = fetch_many_run(mem_ctx, ev, client, ctdb_db, keys, NUM_KEYS,
+			     true, opts->timelimit);
+	if (ret != 0) {
+		fprintf(stderr, "fetch many test failed\n");
+		exit(1);
+	}
+
+	talloc_free(mem_ctx);
+	return 0;
+}
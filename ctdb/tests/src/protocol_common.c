@@ -667,6 +667,52 @@ void verify_ctdb_traverse_all_ext(struct ctdb_traverse_all_ext *p1,
 	assert(p1->withemptyrecords == p2->withemptyrecords);
 }
 
+void fill_ctdb_traverse_start_stream(TALLOC_CTX *mem_ctx,
+				     struct ctdb_traverse_start_stream *p)
+{
+	p->db_id = rand32();
+	p->reqid = rand32();
+	p->srvid = rand64();
+	p->withemptyrecords = rand_int(2);
+	fill_tdb_data(mem_ctx, &p->prefix);
+}
+
+void verify_ctdb_traverse_start_stream(struct ctdb_traverse_start_stream *p1,
+				       struct ctdb_traverse_start_stream *p2)
+{
+	assert(p1->db_id == p2->db_id);
+	assert(p1->reqid == p2->reqid);
+	assert(p1->srvid == p2->srvid);
+	assert(p1->withemptyrecords == p2->withemptyrecords);
+	verify_tdb_data(&p1->prefix, &p2->prefix);
+}
+
+void fill_ctdb_traverse_all_stream(TALLOC_CTX *mem_ctx,
+				   struct ctdb_traverse_all_stream *p)
+{
+	p->db_id = rand32();
+	p->reqid = rand32();
+	p->pnn = rand32();
+	p->client_reqid = rand32();
+	p->srvid = rand64();
+	p->window = rand32();
+	p->withemptyrecords = rand_int(2);
+	fill_tdb_data(mem_ctx, &p->prefix);
+}
+
+void verify_ctdb_traverse_all_stream(struct ctdb_traverse_all_stream *p1,
+				     struct ctdb_traverse_all_stream *p2)
+{
+	assert(p1->db_id == p2->db_id);
+	assert(p1->reqid == p2->reqid);
+	assert(p1->pnn == p2->pnn);
+	assert(p1->client_reqid == p2->client_reqid);
+	assert(p1->srvid == p2->srvid);
+	assert(p1->window == p2->window);
+	assert(p1->withemptyrecords == p2->withemptyrecords);
+	verify_tdb_data(&p1->prefix, &p2->prefix);
+}
+
 void fill_ctdb_sock_addr(TALLOC_CTX *mem_ctx, ctdb_sock_addr *p)
 {
 	if (rand_int(2) == 0) {
@@ -848,6 +894,8 @@ void fill_ctdb_tunable_list(TALLOC_CTX *mem_ctx, struct ctdb_tunable_list *p)
 	p->queue_buffer_size = rand32();
 	p->ip_alloc_algorithm = rand32();
 	p->allow_mixed_versions = rand32();
+	p->consistent_lmaster = rand32();
+	p->traverse_window = rand32();
 }
 
 void verify_ctdb_tunable_list(struct ctdb_tunable_list *p1,
@@ -915,6 +963,8 @@ void verify_ctdb_tunable_list(struct ctdb_tunable_list *p1,
 	assert(p1->queue_buffer_size == p2->queue_buffer_size);
 	assert(p1->ip_alloc_algorithm == p2->ip_alloc_algorithm);
 	assert(p1->allow_mixed_versions == p2->allow_mixed_versions);
+	assert(p1->consistent_lmaster == p2->consistent_lmaster);
+	assert(p1->traverse_window == p2->traverse_window);
 }
 
 void fill_ctdb_tickle_list(TALLOC_CTX *mem_ctx, struct ctdb_tickle_list *p)
@@ -977,6 +1027,23 @@ void verify_ctdb_transdb(struct ctdb_transdb *p1, struct ctdb_transdb *p2)
 	assert(p1->tid == p2->tid);
 }
 
+void fill_ctdb_trans3_ticket(TALLOC_CTX *mem_ctx, struct ctdb_trans3_ticket *p)
+{
+	p->db_id = rand32();
+	p->generation = rand32();
+	p->tid = rand32();
+	p->pnn = rand32();
+}
+
+void verify_ctdb_trans3_ticket(struct ctdb_trans3_ticket *p1,
+			       struct ctdb_trans3_ticket *p2)
+{
+	assert(p1->db_id == p2->db_id);
+	assert(p1->generation == p2->generation);
+	assert(p1->tid == p2->tid);
+	assert(p1->pnn == p2->pnn);
+}
+
 void fill_ctdb_uptime(TALLOC_CTX *mem_ctx, struct ctdb_uptime *p)
 {
 	fill_ctdb_timeval(&p->current_time);
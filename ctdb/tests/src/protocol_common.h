@@ -231,6 +231,16 @@ void fill_ctdb_traverse_all_ext(TALLOC_CTX *mem_ctx,
 void verify_ctdb_traverse_all_ext(struct ctdb_traverse_all_ext *p1,
 				  struct ctdb_traverse_all_ext *p2);
 
+void fill_ctdb_traverse_start_stream(TALLOC_CTX *mem_ctx,
+				     struct ctdb_traverse_start_stream *p);
+void verify_ctdb_traverse_start_stream(struct ctdb_traverse_start_stream *p1,
+				       struct ctdb_traverse_start_stream *p2);
+
+void fill_ctdb_traverse_all_stream(TALLOC_CTX *mem_ctx,
+				   struct ctdb_traverse_all_stream *p);
+void verify_ctdb_traverse_all_stream(struct ctdb_traverse_all_stream *p1,
+				     struct ctdb_traverse_all_stream *p2);
+
 void fill_ctdb_sock_addr(TALLOC_CTX *mem_ctx, ctdb_sock_addr *p);
 void verify_ctdb_sock_addr(ctdb_sock_addr *p1, ctdb_sock_addr *p2);
 
@@ -269,6 +279,10 @@ void verify_ctdb_addr_info(struct ctdb_addr_info *p1,
 void fill_ctdb_transdb(TALLOC_CTX *mem_ctx, struct ctdb_transdb *p);
 void verify_ctdb_transdb(struct ctdb_transdb *p1, struct ctdb_transdb *p2);
 
+void fill_ctdb_trans3_ticket(TALLOC_CTX *mem_ctx, struct ctdb_trans3_ticket *p);
+void verify_ctdb_trans3_ticket(struct ctdb_trans3_ticket *p1,
+			       struct ctdb_trans3_ticket *p2);
+
 void fill_ctdb_uptime(TALLOC_CTX *mem_ctx, struct ctdb_uptime *p);
 void verify_ctdb_uptime(struct ctdb_uptime *p1, struct ctdb_uptime *p2);
 
@@ -615,6 +615,30 @@ void fill_ctdb_req_control_data(TALLOC_CTX *mem_ctx,
 
 	case CTDB_CONTROL_TUNNEL_DEREGISTER:
 		break;
+
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		cd->data.traverse_start_stream = talloc(mem_ctx, struct ctdb_traverse_start_stream);
+		assert(cd->data.traverse_start_stream != NULL);
+		fill_ctdb_traverse_start_stream(mem_ctx, cd->data.traverse_start_stream);
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		cd->data.traverse_all_stream = talloc(mem_ctx, struct ctdb_traverse_all_stream);
+		assert(cd->data.traverse_all_stream != NULL);
+		fill_ctdb_traverse_all_stream(mem_ctx, cd->data.traverse_all_stream);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		cd->data.recbuf = talloc(mem_ctx, struct ctdb_rec_buffer);
+		assert(cd->data.recbuf != NULL);
+		fill_ctdb_rec_buffer(mem_ctx, cd->data.recbuf);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		cd->data.ticket = talloc(mem_ctx, struct ctdb_trans3_ticket);
+		assert(cd->data.ticket != NULL);
+		fill_ctdb_trans3_ticket(mem_ctx, cd->data.ticket);
+		break;
 	}
 }
 
@@ -1026,6 +1050,24 @@ void verify_ctdb_req_control_data(struct ctdb_req_control_data *cd,
 
 	case CTDB_CONTROL_TUNNEL_DEREGISTER:
 		break;
+
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		verify_ctdb_traverse_start_stream(cd->data.traverse_start_stream,
+						  cd2->data.traverse_start_stream);
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		verify_ctdb_traverse_all_stream(cd->data.traverse_all_stream,
+						cd2->data.traverse_all_stream);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		verify_ctdb_rec_buffer(cd->data.recbuf, cd2->data.recbuf);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		verify_ctdb_trans3_ticket(cd->data.ticket, cd2->data.ticket);
+		break;
 	}
 }
 
@@ -1447,6 +1489,21 @@ void fill_ctdb_reply_control_data(TALLOC_CTX *mem_ctx,
 	case CTDB_CONTROL_TUNNEL_DEREGISTER:
 		break;
 
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		cd->data.ticket = talloc(mem_ctx, struct ctdb_trans3_ticket);
+		assert(cd->data.ticket != NULL);
+		fill_ctdb_trans3_ticket(mem_ctx, cd->data.ticket);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		break;
+
 	}
 }
 
@@ -1801,6 +1858,19 @@ void verify_ctdb_reply_control_data(struct ctdb_reply_control_data *cd,
 	case CTDB_CONTROL_TUNNEL_DEREGISTER:
 		break;
 
+	case CTDB_CONTROL_TRAVERSE_START_STREAM:
+		break;
+
+	case CTDB_CONTROL_TRAVERSE_ALL_STREAM:
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_START:
+		verify_ctdb_trans3_ticket(cd->data.ticket, cd2->data.ticket);
+		break;
+
+	case CTDB_CONTROL_TRANS3_COMMIT_WAIT:
+		break;
+
 	}
 }
 
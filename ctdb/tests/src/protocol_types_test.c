@@ -45,6 +45,10 @@ PROTOCOL_TYPE3_TEST(struct ctdb_traverse_start, ctdb_traverse_start);
 PROTOCOL_TYPE3_TEST(struct ctdb_traverse_all, ctdb_traverse_all);
 PROTOCOL_TYPE3_TEST(struct ctdb_traverse_start_ext, ctdb_traverse_start_ext);
 PROTOCOL_TYPE3_TEST(struct ctdb_traverse_all_ext, ctdb_traverse_all_ext);
+PROTOCOL_TYPE3_TEST(struct ctdb_traverse_start_stream,
+		    ctdb_traverse_start_stream);
+PROTOCOL_TYPE3_TEST(struct ctdb_traverse_all_stream,
+		    ctdb_traverse_all_stream);
 PROTOCOL_TYPE3_TEST(ctdb_sock_addr, ctdb_sock_addr);
 PROTOCOL_TYPE3_TEST(struct ctdb_connection, ctdb_connection);
 PROTOCOL_TYPE3_TEST(struct ctdb_connection_list, ctdb_connection_list);
@@ -55,6 +59,7 @@ PROTOCOL_TYPE3_TEST(struct ctdb_tunable_list, ctdb_tunable_list);
 PROTOCOL_TYPE3_TEST(struct ctdb_tickle_list, ctdb_tickle_list);
 PROTOCOL_TYPE3_TEST(struct ctdb_addr_info, ctdb_addr_info);
 PROTOCOL_TYPE3_TEST(struct ctdb_transdb, ctdb_transdb);
+PROTOCOL_TYPE3_TEST(struct ctdb_trans3_ticket, ctdb_trans3_ticket);
 PROTOCOL_TYPE3_TEST(struct ctdb_uptime, ctdb_uptime);
 PROTOCOL_TYPE3_TEST(struct ctdb_public_ip, ctdb_public_ip);
 PROTOCOL_TYPE3_TEST(struct ctdb_public_ip_list, ctdb_public_ip_list);
@@ -150,6 +155,8 @@ int main(int argc, char *argv[])
 	TEST_FUNC(ctdb_traverse_all)();
 	TEST_FUNC(ctdb_traverse_start_ext)();
 	TEST_FUNC(ctdb_traverse_all_ext)();
+	TEST_FUNC(ctdb_traverse_start_stream)();
+	TEST_FUNC(ctdb_traverse_all_stream)();
 	TEST_FUNC(ctdb_sock_addr)();
 	TEST_FUNC(ctdb_connection)();
 	TEST_FUNC(ctdb_connection_list)();
@@ -160,6 +167,7 @@ int main(int argc, char *argv[])
 	TEST_FUNC(ctdb_tickle_list)();
 	TEST_FUNC(ctdb_addr_info)();
 	TEST_FUNC(ctdb_transdb)();
+	TEST_FUNC(ctdb_trans3_ticket)();
 	TEST_FUNC(ctdb_uptime)();
 	TEST_FUNC(ctdb_public_ip)();
 	TEST_FUNC(ctdb_public_ip_list)();
@@ -285,6 +285,85 @@ fe80::6af7:28ff:fefa:d136:12346 fe80::6af7:28ff:fefa:d137:54323\n\
 fe80::6af7:28ff:fefa:d138:12345 fe80::6af7:28ff:fefa:d137:54322\n\
 "
 
+/*
+ * Test lmaster selection from vnnmap
+ */
+
+#define NUM_HASHES 10000
+
+static void test_vnn_map_lmaster_modulo(uint32_t size)
+{
+	struct ctdb_vnn_map vnnmap;
+	uint32_t map[size];
+	uint32_t i, hash;
+
+	for (i=0; i<size; i++) {
+		map[i] = size - i;
+	}
+	vnnmap.generation = 2;
+	vnnmap.size = size;
+	vnnmap.map = map;
+
+	for (i=0; i<NUM_HASHES; i++) {
+		hash = i * 2654435761U;
+		assert(ctdb_vnn_map_lmaster(&vnnmap, hash, false) ==
+		       map[hash % size]);
+	}
+}
+
+/*
+ * Remove the node at index del from the vnnmap and check that only the
+ * hashes that were mapped to that node change lmaster
+ */
+static void test_vnn_map_lmaster_consistent(uint32_t size, uint32_t del)
+{
+	struct ctdb_vnn_map vnnmap1, vnnmap2;
+	uint32_t map1[size], map2[size-1], count[size];
+	uint32_t i, j, hash, lmaster1, lmaster2, moved;
+
+	for (i=0, j=0; i<size; i++) {
+		map1[i] = i;
+		if (i != del) {
+			map2[j++] = i;
+		}
+		count[i] = 0;
+	}
+	vnnmap1.generation = 2;
+	vnnmap1.size = size;
+	vnnmap1.map = map1;
+	vnnmap2.generation = 3;
+	vnnmap2.size = size - 1;
+	vnnmap2.map = map2;
+
+	moved = 0;
+	for (i=0; i<NUM_HASHES; i++) {
+		hash = i * 2654435761U;
+		lmaster1 = ctdb_vnn_map_lmaster(&vnnmap1, hash, true);
+		lmaster2 = ctdb_vnn_map_lmaster(&vnnmap2, hash, true);
+
+		assert(lmaster1 < size);
+		assert(lmaster2 != del);
+		count[lmaster1] += 1;
+
+		/*
+		 * This also means that adding the node back only moves
+		 * hashes to that node
+		 */
+		if (lmaster1 == del) {
+			moved += 1;
+		} else {
+			assert(lmaster1 == lmaster2);
+		}
+	}
+
+	/* Hashes are spread evenly, within 20% */
+	for (i=0; i<size; i++) {
+		assert(count[i] * size > NUM_HASHES * 8 / 10);
+		assert(count[i] * size < NUM_HASHES * 12 / 10);
+	}
+	assert(moved == count[del]);
+}
+
 int main(int argc, char *argv[])
 {
 	test_sock_addr_to_string("0.0.0.0", false);
@@ -346,5 +425,14 @@ int main(int argc, char *argv[])
 				      "# Comment\n\n127.0.0.1: 127.0.0.1:124\n"
 				      CONN6);
 
+	test_vnn_map_lmaster_modulo(1);
+	test_vnn_map_lmaster_modulo(3);
+	test_vnn_map_lmaster_modulo(8);
+
+	test_vnn_map_lmaster_consistent(2, 0);
+	test_vnn_map_lmaster_consistent(3, 1);
+	test_vnn_map_lmaster_consistent(5, 4);
+	test_vnn_map_lmaster_consistent(8, 3);
+
 	return 0;
 }
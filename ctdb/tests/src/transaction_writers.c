@@ -0,0 +1,479 @@
+/*
+   ctdb benchmark for many writer processes on a replicated database
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "replace.h"
+#include "system/filesys.h"
+#include "system/network.h"
+#include "system/time.h"
+#include "system/wait.h"
+
+#include "lib/util/sys_rw.h"
+#include "lib/util/tevent_unix.h"
+#include "lib/util/time.h"
+
+#include "client/client.h"
+#include "tests/src/test_options.h"
+#include "tests/src/cluster_wait.h"
+
+#define NUM_WRITERS		32
+#define NUM_TRANSACTIONS	20
+
+/*
+ * Every node runs the same number of transactions twice: first with a
+ * single writer process, then with NUM_WRITERS writer processes, each
+ * with its own connection to ctdbd.  Each transaction increments the
+ * counter of the writer in its own record, and the counter of the node
+ * in a record shared by all nodes.  ctdbd replicates the commits of
+ * concurrent writers in groups, so the second run needs far fewer
+ * cluster-wide round trips per transaction.
+ */
+
+static int transaction_writer_increment(TALLOC_CTX *mem_ctx,
+					struct ctdb_transaction_handle *h,
+					TDB_DATA key, int index, int num)
+{
+	TDB_DATA data;
+	uint32_t *counter;
+	int ret;
+
+	ret = ctdb_transaction_fetch_record(h, key, mem_ctx, &data);
+	if (ret != 0) {
+		fprintf(stderr, "transaction fetch record failed\n");
+		return ret;
+	}
+
+	if (data.dsize < num * sizeof(uint32_t)) {
+		TALLOC_FREE(data.dptr);
+
+		data.dsize = num * sizeof(uint32_t);
+		data.dptr = (uint8_t *)talloc_zero_array(mem_ctx, uint32_t,
+							 num);
+		if (data.dptr == NULL) {
+			return ENOMEM;
+		}
+	}
+
+	counter = (uint32_t *)data.dptr;
+	counter[index] += 1;
+
+	ret = ctdb_transaction_store_record(h, key, data);
+	talloc_free(data.dptr);
+	if (ret != 0) {
+		fprintf(stderr, "transaction store failed\n");
+		return ret;
+	}
+
+	return 0;
+}
+
+static int transaction_writer_loop(TALLOC_CTX *mem_ctx,
+				   struct tevent_context *ev,
+				   struct ctdb_client_context *client,
+				   struct ctdb_db_context *ctdb_db,
+				   int num_nodes, const char *keystr,
+				   int writer, int count)
+{
+	struct ctdb_transaction_handle *h;
+	uint32_t pnn = ctdb_client_pnn(client);
+	TDB_DATA key, wkey;
+	int ret, i;
+
+	key.dptr = discard_const(keystr);
+	key.dsize = strlen(keystr);
+
+	wkey.dptr = (uint8_t *)talloc_asprintf(mem_ctx, "%s-%u-%d",
+					       keystr, pnn, writer);
+	if (wkey.dptr == NULL) {
+		return ENOMEM;
+	}
+	wkey.dsize = strlen((char *)wkey.dptr);
+
+	for (i=0; i<count; i++) {
+		ret = ctdb_transaction_start(mem_ctx, ev, client,
+					     tevent_timeval_zero(), ctdb_db,
+					     false, &h);
+		if (ret != 0) {
+			fprintf(stderr, "transaction start failed\n");
+			return ret;
+		}
+
+		ret = transaction_writer_increment(mem_ctx, h, wkey, 0, 1);
+		if (ret != 0) {
+			ctdb_transaction_cancel(h);
+			return ret;
+		}
+
+		ret = transaction_writer_increment(mem_ctx, h, key, pnn,
+						   num_nodes);
+		if (ret != 0) {
+			ctdb_transaction_cancel(h);
+			return ret;
+		}
+
+		ret = ctdb_transaction_commit(h);
+		if (ret != 0) {
+			fprintf(stderr, "transaction commit failed - %s\n",
+				strerror(ret));
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Connect to ctdbd, report readiness and wait for the signal to go
+ */
+static void transaction_writer_child(const char *sockpath,
+				     const char *dbname, uint8_t db_flags,
+				     int num_nodes, const char *keystr,
+				     int writer, int count,
+				     int ready_fd, int go_fd)
+{
+	TALLOC_CTX *mem_ctx;
+	struct tevent_context *ev;
+	struct ctdb_client_context *client;
+	struct ctdb_db_context *ctdb_db;
+	char c = 0;
+	ssize_t n;
+	int ret;
+
+	mem_ctx = talloc_new(NULL);
+	if (mem_ctx == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		_exit(1);
+	}
+
+	ev = tevent_context_init(mem_ctx);
+	if (ev == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		_exit(1);
+	}
+
+	ret = ctdb_client_init(mem_ctx, ev, sockpath, &client);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to initialize client, ret=%d\n", ret);
+		_exit(1);
+	}
+
+	ret = ctdb_attach(ev, client, tevent_timeval_zero(), dbname,
+			  db_flags, &ctdb_db);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to attach to DB %s\n", dbname);
+		_exit(1);
+	}
+
+	n = sys_write(ready_fd, &c, 1);
+	if (n != 1) {
+		_exit(1);
+	}
+	close(ready_fd);
+
+	/* The parent closes the other end to start all writers at once */
+	n = sys_read(go_fd, &c, 1);
+	if (n != 0) {
+		_exit(1);
+	}
+
+	ret = transaction_writer_loop(mem_ctx, ev, client, ctdb_db,
+				      num_nodes, keystr, writer, count);
+	if (ret != 0) {
+		_exit(1);
+	}
+
+	talloc_free(mem_ctx);
+	_exit(0);
+}
+
+static int transaction_writers_run(const struct test_options *opts,
+				   uint8_t db_flags, uint32_t pnn,
+				   int num_writers)
+{
+	struct timeval start;
+	int count = NUM_WRITERS * NUM_TRANSACTIONS / num_writers;
+	int ready_fd[2], go_fd[2];
+	int ret = 0, status, i;
+	pid_t pid;
+	char c;
+	ssize_t n;
+
+	ret = pipe(ready_fd);
+	if (ret != 0) {
+		return errno;
+	}
+
+	ret = pipe(go_fd);
+	if (ret != 0) {
+		ret = errno;
+		close(ready_fd[0]);
+		close(ready_fd[1]);
+		return ret;
+	}
+
+	for (i=0; i<num_writers; i++) {
+		pid = fork();
+		if (pid == -1) {
+			ret = errno;
+			break;
+		}
+
+		if (pid == 0) {
+			close(ready_fd[0]);
+			close(go_fd[1]);
+			transaction_writer_child(opts->socket, opts->dbname,
+						 db_flags, opts->num_nodes,
+						 opts->keystr, i, count,
+						 ready_fd[1], go_fd[0]);
+		}
+	}
+
+	close(ready_fd[1]);
+	close(go_fd[0]);
+
+	if (ret == 0) {
+		for (i=0; i<num_writers; i++) {
+			n = sys_read(ready_fd[0], &c, 1);
+			if (n != 1) {
+				fprintf(stderr, "Writer failed to connect\n");
+				ret = EIO;
+				break;
+			}
+		}
+	}
+
+	start = tevent_timeval_current();
+	close(go_fd[1]);
+	close(ready_fd[0]);
+
+	while ((pid = waitpid(-1, &status, 0)) > 0) {
+		if (! WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			ret = EIO;
+		}
+	}
+
+	if (ret != 0) {
+		return ret;
+	}
+
+	printf("Transaction writers[%u]: %d writers, %d transactions, "
+	       "%.0f transactions/sec\n",
+	       pnn, num_writers, num_writers * count,
+	       num_writers * count / timeval_elapsed(&start));
+	fflush(stdout);
+
+	return 0;
+}
+
+static int transaction_writers_check(TALLOC_CTX *mem_ctx,
+				     struct tevent_context *ev,
+				     struct ctdb_client_context *client,
+				     struct ctdb_db_context *ctdb_db,
+				     int num_nodes, const char *keystr,
+				     bool *done)
+{
+	struct ctdb_transaction_handle *h;
+	uint32_t pnn = ctdb_client_pnn(client);
+	uint32_t expected;
+	TDB_DATA key, data;
+	int ret, i;
+
+	ret = ctdb_transaction_start(mem_ctx, ev, client,
+				     tevent_timeval_zero(), ctdb_db, true,
+				     &h);
+	if (ret != 0) {
+		fprintf(stderr, "transaction start failed\n");
+		return ret;
+	}
+
+	/* Every writer runs in both rounds */
+	for (i=0; i<NUM_WRITERS; i++) {
+		key.dptr = (uint8_t *)talloc_asprintf(mem_ctx, "%s-%u-%d",
+						      keystr, pnn, i);
+		if (key.dptr == NULL) {
+			ret = ENOMEM;
+			goto done;
+		}
+		key.dsize = strlen((char *)key.dptr);
+
+		expected = NUM_TRANSACTIONS;
+		if (i == 0) {
+			expected += NUM_WRITERS * NUM_TRANSACTIONS;
+		}
+
+		ret = ctdb_transaction_fetch_record(h, key, mem_ctx, &data);
+		if (ret != 0) {
+			goto done;
+		}
+
+		if (data.dsize != sizeof(uint32_t) ||
+		    *(uint32_t *)data.dptr != expected) {
+			fprintf(stderr, "Counter mismatch for %s\n",
+				(char *)key.dptr);
+			ret = EIO;
+			goto done;
+		}
+	}
+
+	key.dptr = discard_const(keystr);
+	key.dsize = strlen(keystr);
+
+	ret = ctdb_transaction_fetch_record(h, key, mem_ctx, &data);
+	if (ret != 0) {
+		goto done;
+	}
+
+	if (data.dsize != num_nodes * sizeof(uint32_t)) {
+		fprintf(stderr, "Counter mismatch for %s\n", keystr);
+		ret = EIO;
+		goto done;
+	}
+
+	/*
+	 * The other nodes may still be writing.  Their counters must
+	 * never be ahead of what they can have written.
+	 */
+	expected = 2 * NUM_WRITERS * NUM_TRANSACTIONS;
+	*done = true;
+	for (i=0; i<num_nodes; i++) {
+		uint32_t value = ((uint32_t *)data.dptr)[i];
+
+		if (value > expected || (i == pnn && value != expected)) {
+			fprintf(stderr, "Counter mismatch for %s[%d]\n",
+				keystr, i);
+			ret = EIO;
+			goto done;
+		}
+
+		if (value != expected) {
+			*done = false;
+		}
+	}
+
+done:
+	ctdb_transaction_cancel(h);
+	return ret;
+}
+
+int main(int argc, const char *argv[])
+{
+	const struct test_options *opts;
+	TALLOC_CTX *mem_ctx;
+	struct tevent_context *ev;
+	struct ctdb_client_context *client;
+	struct ctdb_db_context *ctdb_db;
+	struct tevent_req *req;
+	uint8_t db_flags;
+	uint32_t pnn;
+	int ret, i;
+	bool status, done = false;
+
+	status = process_options_database(argc, argv, &opts);
+	if (! status) {
+		exit(1);
+	}
+
+	mem_ctx = talloc_new(NULL);
+	if (mem_ctx == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ev = tevent_context_init(mem_ctx);
+	if (ev == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ret = ctdb_client_init(mem_ctx, ev, opts->socket, &client);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to initialize client, ret=%d\n", ret);
+		exit(1);
+	}
+
+	if (! ctdb_recovery_wait(ev, client)) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	if (strcmp(opts->dbtype, "persistent") == 0) {
+		db_flags = CTDB_DB_FLAGS_PERSISTENT;
+	} else if (strcmp(opts->dbtype, "replicated") == 0) {
+		db_flags = CTDB_DB_FLAGS_REPLICATED;
+	} else {
+		fprintf(stderr, "Database must be persistent or replicated\n");
+		exit(1);
+	}
+
+	ret = ctdb_attach(ev, client, tevent_timeval_zero(), opts->dbname,
+			  db_flags, &ctdb_db);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to attach to persistent DB %s\n",
+			opts->dbname);
+		exit(1);
+	}
+
+	pnn = ctdb_client_pnn(client);
+
+	req = cluster_wait_send(mem_ctx, ev, client, opts->num_nodes);
+	if (req == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	tevent_req_poll(req, ev);
+
+	status = cluster_wait_recv(req, &ret);
+	if (! status) {
+		fprintf(stderr, "Failed to wait for cluster, ret=%d\n", ret);
+		exit(1);
+	}
+	talloc_free(req);
+
+	ret = transaction_writers_run(opts, db_flags, pnn, 1);
+	if (ret != 0) {
+		fprintf(stderr, "Single writer failed, ret=%d\n", ret);
+		exit(1);
+	}
+
+	ret = transaction_writers_run(opts, db_flags, pnn, NUM_WRITERS);
+	if (ret != 0) {
+		fprintf(stderr, "Concurrent writers failed, ret=%d\n", ret);
+		exit(1);
+	}
+
+	/* Wait for the writers on the other nodes */
+	for (i=0; i<120 && ! done; i++) {
+		if (i > 0) {
+			sleep(1);
+		}
+
+		ret = transaction_writers_check(mem_ctx, ev, client, ctdb_db,
+						opts->num_nodes, opts->keystr,
+						&done);
+		if (ret != 0) {
+			exit(1);
+		}
+	}
+
+	if (! done) {
+		fprintf(stderr, "Writers on other nodes did not finish\n");
+		exit(1);
+	}
+
+	talloc_free(mem_ctx);
+	return 0;
+}
@@ -0,0 +1,342 @@
+/*
+   ctdb streaming traverse benchmark
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "replace.h"
+#include "system/filesys.h"
+#include "system/network.h"
+#include "system/time.h"
+
+#include "lib/tdb_wrap/tdb_wrap.h"
+#include "lib/util/tevent_unix.h"
+#include "lib/util/time.h"
+
+#include "client/client.h"
+#include "client/client_sync.h"
+#include "client/client_private.h"
+#include "tests/src/test_options.h"
+#include "tests/src/cluster_wait.h"
+
+#define TESTDB		"traverse_stream.tdb"
+#define NUM_RECORDS	5000
+#define VALUE_SIZE	256
+#define SLOW_BATCH	100
+
+/*
+ * Every node stores NUM_RECORDS records, then node 0 traverses the
+ * database with the old traverse and the streaming traverse.  Each
+ * traverse is run twice: once as fast as possible to measure the
+ * throughput, and once with a client that keeps stalling, to measure
+ * how much the memory use of the local ctdbd grows while it has to
+ * queue records for the client.  While the client stalls during the
+ * streaming traverse, starting a transaction on the local database must
+ * not block.
+ */
+
+struct traverse_stream_state {
+	pid_t ctdbd_pid;
+	bool slow;
+	struct tdb_context *tdb;
+	bool blocked;
+	int count;
+	long base_kb;
+	long peak_kb;
+};
+
+static long ctdbd_rss_kb(pid_t pid)
+{
+	char path[PATH_MAX];
+	char line[256];
+	FILE *fp;
+	long rss = -1;
+
+	snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strncmp(line, "VmRSS:", 6) == 0) {
+			rss = strtol(line+6, NULL, 10);
+			break;
+		}
+	}
+
+	fclose(fp);
+	return rss;
+}
+
+static int traverse_stream_parser(uint32_t reqid,
+				  struct ctdb_ltdb_header *header,
+				  TDB_DATA key, TDB_DATA data,
+				  void *private_data)
+{
+	struct traverse_stream_state *state =
+		(struct traverse_stream_state *)private_data;
+	long rss;
+
+	state->count += 1;
+
+	if (state->slow && state->count % SLOW_BATCH == 0) {
+		usleep(2000);
+		rss = ctdbd_rss_kb(state->ctdbd_pid);
+		if (rss > state->peak_kb) {
+			state->peak_kb = rss;
+		}
+
+		if (state->tdb != NULL && state->count == SLOW_BATCH) {
+			/*
+			 * Give the traverse children time to use up
+			 * their window, then check that they do not hold
+			 * the traverse lock while they wait for credits.
+			 */
+			sleep(1);
+			if (tdb_transaction_start_nonblock(state->tdb) != 0) {
+				state->blocked = true;
+			} else {
+				tdb_transaction_cancel(state->tdb);
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int traverse_stream_populate(TALLOC_CTX *mem_ctx,
+				    struct tevent_context *ev,
+				    struct ctdb_client_context *client,
+				    struct ctdb_db_context *ctdb_db)
+{
+	struct ctdb_record_handle *h;
+	uint8_t value[VALUE_SIZE];
+	TDB_DATA key, data;
+	int ret, i;
+
+	memset(value, 'x', sizeof(value));
+
+	for (i=0; i<NUM_RECORDS; i++) {
+		key.dptr = (uint8_t *)talloc_asprintf(mem_ctx, "key-%u-%d",
+						      ctdb_client_pnn(client),
+						      i);
+		if (key.dptr == NULL) {
+			return ENOMEM;
+		}
+		key.dsize = strlen((char *)key.dptr);
+
+		ret = ctdb_fetch_lock(mem_ctx, ev, client, ctdb_db, key,
+				      false, &h, NULL, NULL);
+		if (ret != 0) {
+			fprintf(stderr, "Failed to fetch record, ret=%d\n",
+				ret);
+			return ret;
+		}
+
+		data.dptr = value;
+		data.dsize = sizeof(value);
+
+		ret = ctdb_store_record(h, data);
+		talloc_free(h);
+		talloc_free(key.dptr);
+		if (ret != 0) {
+			fprintf(stderr, "Failed to store record, ret=%d\n",
+				ret);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int traverse_stream_run(TALLOC_CTX *mem_ctx,
+			       struct tevent_context *ev,
+			       struct ctdb_client_context *client,
+			       struct ctdb_db_context *ctdb_db,
+			       pid_t ctdbd_pid, int num_nodes,
+			       bool stream, bool slow)
+{
+	struct traverse_stream_state state = {
+		.ctdbd_pid = ctdbd_pid,
+		.slow = slow,
+		/* The local database, as opened by ctdb_attach() */
+		.tdb = (stream && slow) ? ctdb_db->ltdb->tdb : NULL,
+	};
+	struct timeval start;
+	double elapsed;
+	int ret;
+
+	state.base_kb = ctdbd_rss_kb(ctdbd_pid);
+	state.peak_kb = state.base_kb;
+
+	start = tevent_timeval_current();
+
+	if (stream) {
+		ret = ctdb_db_traverse_stream(mem_ctx, ev, client, ctdb_db,
+					      CTDB_CURRENT_NODE,
+					      tevent_timeval_zero(),
+					      tdb_null,
+					      traverse_stream_parser,
+					      &state);
+	} else {
+		ret = ctdb_db_traverse(mem_ctx, ev, client, ctdb_db,
+				       CTDB_CURRENT_NODE,
+				       tevent_timeval_zero(),
+				       traverse_stream_parser, &state);
+	}
+	if (ret != 0) {
+		fprintf(stderr, "Traverse failed, ret=%d\n", ret);
+		return ret;
+	}
+
+	elapsed = timeval_elapsed(&start);
+
+	if (state.count != num_nodes * NUM_RECORDS) {
+		fprintf(stderr, "Traverse returned %d records, expected %d\n",
+			state.count, num_nodes * NUM_RECORDS);
+		return EIO;
+	}
+
+	if (state.blocked) {
+		fprintf(stderr, "Transaction blocked during traverse\n");
+		return EIO;
+	}
+
+	if (slow) {
+		printf("%s[%u]: %d records, ctdbd memory +%ld kB\n",
+		       stream ? "Slow stream traverse" : "Slow traverse",
+		       ctdb_client_pnn(client), state.count,
+		       state.peak_kb - state.base_kb);
+	} else {
+		printf("%s[%u]: %d records, %.0f records/sec\n",
+		       stream ? "Stream traverse" : "Traverse",
+		       ctdb_client_pnn(client), state.count,
+		       state.count / elapsed);
+	}
+	fflush(stdout);
+
+	return 0;
+}
+
+int main(int argc, const char *argv[])
+{
+	const struct test_options *opts;
+	TALLOC_CTX *mem_ctx;
+	struct tevent_context *ev;
+	struct ctdb_client_context *client;
+	struct ctdb_db_context *ctdb_db;
+	struct tevent_req *req;
+	pid_t ctdbd_pid;
+	int ret;
+	bool status;
+
+	status = process_options_basic(argc, argv, &opts);
+	if (! status) {
+		exit(1);
+	}
+
+	mem_ctx = talloc_new(NULL);
+	if (mem_ctx == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ev = tevent_context_init(mem_ctx);
+	if (ev == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ret = ctdb_client_init(mem_ctx, ev, opts->socket, &client);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to initialize client, ret=%d\n", ret);
+		exit(1);
+	}
+
+	if (! ctdb_recovery_wait(ev, client)) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	ret = ctdb_attach(ev, client, tevent_timeval_zero(), TESTDB, 0,
+			  &ctdb_db);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to attach to DB %s\n", TESTDB);
+		exit(1);
+	}
+
+	ret = ctdb_ctrl_get_pid(mem_ctx, ev, client, CTDB_CURRENT_NODE,
+				tevent_timeval_zero(), &ctdbd_pid);
+	if (ret != 0) {
+		fprintf(stderr, "Failed to get ctdbd pid, ret=%d\n", ret);
+		exit(1);
+	}
+
+	ret = traverse_stream_populate(mem_ctx, ev, client, ctdb_db);
+	if (ret != 0) {
+		exit(1);
+	}
+
+	req = cluster_wait_send(mem_ctx, ev, client, opts->num_nodes);
+	if (req == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		exit(1);
+	}
+
+	tevent_req_poll(req, ev);
+
+	status = cluster_wait_recv(req, &ret);
+	if (! status) {
+		fprintf(stderr, "Failed to wait for cluster, ret=%d\n", ret);
+		exit(1);
+	}
+	talloc_free(req);
+
+	if (ctdb_client_pnn(client) != 0) {
+		talloc_free(mem_ctx);
+		return 0;
+	}
+
+	/*
+	 * Run the streaming traverse first, so it does not benefit from
+	 * memory that ctdbd has already grown to for the old traverse
+	 */
+	ret = traverse_stream_run(mem_ctx, ev, client, ctdb_db, ctdbd_pid,
+				  opts->num_nodes, true, true);
+	if (ret != 0) {
+		exit(1);
+	}
+
+	ret = traverse_stream_run(mem_ctx, ev, client, ctdb_db, ctdbd_pid,
+				  opts->num_nodes, false, true);
+	if (ret != 0) {
+		exit(1);
+	}
+
+	ret = traverse_stream_run(mem_ctx, ev, client, ctdb_db, ctdbd_pid,
+				  opts->num_nodes, true, false);
+	if (ret != 0) {
+		exit(1);
+	}
+
+	ret = traverse_stream_run(mem_ctx, ev, client, ctdb_db, ctdbd_pid,
+				  opts->num_nodes, false, false);
+	if (ret != 0) {
+		exit(1);
+	}
+
+	talloc_free(mem_ctx);
+	return 0;
+}
@@ -0,0 +1,2413 @@
+#!/bin/sh
+
+. "${TEST_SCRIPTS_DIR}/unit.sh"
+
+define_test "1200 IPs, 8 nodes, 0 -> 8 healthy"
+
+export CTDB_TEST_LOGLEVEL=ERR
+
+required_result <<EOF
+10.0.5.240 0
+10.0.5.239 1
+10.0.5.238 2
+10.0.5.237 3
+10.0.5.236 4
+10.0.5.235 5
+10.0.5.234 6
+10.0.5.233 7
+10.0.5.232 0
+10.0.5.231 1
+10.0.5.230 2
+10.0.5.229 3
+10.0.5.228 4
+10.0.5.227 5
+10.0.5.226 6
+10.0.5.225 7
+10.0.5.224 0
+10.0.5.223 0
+10.0.5.222 1
+10.0.5.221 2
+10.0.5.220 3
+10.0.5.219 4
+10.0.5.218 5
+10.0.5.217 6
+10.0.5.216 7
+10.0.5.215 1
+10.0.5.214 2
+10.0.5.213 3
+10.0.5.212 4
+10.0.5.211 5
+10.0.5.210 6
+10.0.5.209 7
+10.0.5.208 0
+10.0.5.207 1
+10.0.5.206 2
+10.0.5.205 3
+10.0.5.204 4
+10.0.5.203 5
+10.0.5.202 6
+10.0.5.201 7
+10.0.5.200 0
+10.0.5.199 1
+10.0.5.198 2
+10.0.5.197 3
+10.0.5.196 4
+10.0.5.195 5
+10.0.5.194 6
+10.0.5.193 7
+10.0.5.192 0
+10.0.5.191 0
+10.0.5.190 1
+10.0.5.189 2
+10.0.5.188 3
+10.0.5.187 4
+10.0.5.186 5
+10.0.5.185 6
+10.0.5.184 7
+10.0.5.183 1
+10.0.5.182 2
+10.0.5.181 3
+10.0.5.180 4
+10.0.5.179 5
+10.0.5.178 6
+10.0.5.177 7
+10.0.5.176 0
+10.0.5.175 0
+10.0.5.174 1
+10.0.5.173 2
+10.0.5.172 3
+10.0.5.171 4
+10.0.5.170 5
+10.0.5.169 6
+10.0.5.168 7
+10.0.5.167 1
+10.0.5.166 2
+10.0.5.165 3
+10.0.5.164 4
+10.0.5.163 5
+10.0.5.162 6
+10.0.5.161 7
+10.0.5.160 0
+10.0.5.159 0
+10.0.5.158 1
+10.0.5.157 2
+10.0.5.156 3
+10.0.5.155 4
+10.0.5.154 5
+10.0.5.153 6
+10.0.5.152 7
+10.0.5.151 1
+10.0.5.150 2
+10.0.5.149 3
+10.0.5.148 4
+10.0.5.147 5
+10.0.5.146 6
+10.0.5.145 7
+10.0.5.144 0
+10.0.5.143 1
+10.0.5.142 2
+10.0.5.141 3
+10.0.5.140 4
+10.0.5.139 5
+10.0.5.138 6
+10.0.5.137 7
+10.0.5.136 0
+10.0.5.135 1
+10.0.5.134 2
+10.0.5.133 3
+10.0.5.132 4
+10.0.5.131 5
+10.0.5.130 6
+10.0.5.129 7
+10.0.5.128 0
+10.0.5.127 0
+10.0.5.126 1
+10.0.5.125 2
+10.0.5.124 3
+10.0.5.123 4
+10.0.5.122 5
+10.0.5.121 6
+10.0.5.120 7
+10.0.5.119 0
+10.0.5.118 1
+10.0.5.117 2
+10.0.5.116 3
+10.0.5.115 4
+10.0.5.114 5
+10.0.5.113 6
+10.0.5.112 7
+10.0.5.111 0
+10.0.5.110 1
+10.0.5.109 2
+10.0.5.108 3
+10.0.5.107 4
+10.0.5.106 5
+10.0.5.105 6
+10.0.5.104 7
+10.0.5.103 0
+10.0.5.102 1
+10.0.5.101 2
+10.0.5.100 3
+10.0.5.99 4
+10.0.5.98 5
+10.0.5.97 6
+10.0.5.96 7
+10.0.5.95 0
+10.0.5.94 1
+10.0.5.93 2
+10.0.5.92 3
+10.0.5.91 4
+10.0.5.90 5
+10.0.5.89 6
+10.0.5.88 7
+10.0.5.87 0
+10.0.5.86 1
+10.0.5.85 2
+10.0.5.84 3
+10.0.5.83 4
+10.0.5.82 5
+10.0.5.81 6
+10.0.5.80 7
+10.0.5.79 0
+10.0.5.78 1
+10.0.5.77 2
+10.0.5.76 3
+10.0.5.75 4
+10.0.5.74 5
+10.0.5.73 6
+10.0.5.72 7
+10.0.5.71 1
+10.0.5.70 2
+10.0.5.69 3
+10.0.5.68 4
+10.0.5.67 5
+10.0.5.66 6
+10.0.5.65 7
+10.0.5.64 0
+10.0.5.63 0
+10.0.5.62 1
+10.0.5.61 2
+10.0.5.60 3
+10.0.5.59 4
+10.0.5.58 5
+10.0.5.57 6
+10.0.5.56 7
+10.0.5.55 0
+10.0.5.54 1
+10.0.5.53 2
+10.0.5.52 3
+10.0.5.51 4
+10.0.5.50 5
+10.0.5.49 6
+10.0.5.48 7
+10.0.5.47 0
+10.0.5.46 1
+10.0.5.45 2
+10.0.5.44 3
+10.0.5.43 4
+10.0.5.42 5
+10.0.5.41 6
+10.0.5.40 7
+10.0.5.39 1
+10.0.5.38 2
+10.0.5.37 3
+10.0.5.36 4
+10.0.5.35 5
+10.0.5.34 6
+10.0.5.33 7
+10.0.5.32 0
+10.0.5.31 0
+10.0.5.30 1
+10.0.5.29 2
+10.0.5.28 3
+10.0.5.27 4
+10.0.5.26 5
+10.0.5.25 6
+10.0.5.24 7
+10.0.5.23 1
+10.0.5.22 2
+10.0.5.21 3
+10.0.5.20 4
+10.0.5.19 5
+10.0.5.18 6
+10.0.5.17 7
+10.0.5.16 0
+10.0.5.15 1
+10.0.5.14 2
+10.0.5.13 3
+10.0.5.12 4
+10.0.5.11 5
+10.0.5.10 6
+10.0.5.9 7
+10.0.5.8 0
+10.0.5.7 1
+10.0.5.6 2
+10.0.5.5 3
+10.0.5.4 4
+10.0.5.3 5
+10.0.5.2 6
+10.0.5.1 7
+10.0.4.240 0
+10.0.4.239 1
+10.0.4.238 2
+10.0.4.237 3
+10.0.4.236 4
+10.0.4.235 5
+10.0.4.234 6
+10.0.4.233 7
+10.0.4.232 0
+10.0.4.231 1
+10.0.4.230 2
+10.0.4.229 3
+10.0.4.228 4
+10.0.4.227 5
+10.0.4.226 6
+10.0.4.225 7
+10.0.4.224 0
+10.0.4.223 0
+10.0.4.222 1
+10.0.4.221 2
+10.0.4.220 3
+10.0.4.219 4
+10.0.4.218 5
+10.0.4.217 6
+10.0.4.216 7
+10.0.4.215 1
+10.0.4.214 2
+10.0.4.213 3
+10.0.4.212 4
+10.0.4.211 5
+10.0.4.210 6
+10.0.4.209 7
+10.0.4.208 0
+10.0.4.207 1
+10.0.4.206 2
+10.0.4.205 3
+10.0.4.204 4
+10.0.4.203 5
+10.0.4.202 6
+10.0.4.201 7
+10.0.4.200 0
+10.0.4.199 1
+10.0.4.198 2
+10.0.4.197 3
+10.0.4.196 4
+10.0.4.195 5
+10.0.4.194 6
+10.0.4.193 7
+10.0.4.192 0
+10.0.4.191 0
+10.0.4.190 1
+10.0.4.189 2
+10.0.4.188 3
+10.0.4.187 4
+10.0.4.186 5
+10.0.4.185 6
+10.0.4.184 7
+10.0.4.183 1
+10.0.4.182 2
+10.0.4.181 3
+10.0.4.180 4
+10.0.4.179 5
+10.0.4.178 6
+10.0.4.177 7
+10.0.4.176 0
+10.0.4.175 0
+10.0.4.174 1
+10.0.4.173 2
+10.0.4.172 3
+10.0.4.171 4
+10.0.4.170 5
+10.0.4.169 6
+10.0.4.168 7
+10.0.4.167 1
+10.0.4.166 2
+10.0.4.165 3
+10.0.4.164 4
+10.0.4.163 5
+10.0.4.162 6
+10.0.4.161 7
+10.0.4.160 0
+10.0.4.159 0
+10.0.4.158 1
+10.0.4.157 2
+10.0.4.156 3
+10.0.4.155 4
+10.0.4.154 5
+10.0.4.153 6
+10.0.4.152 7
+10.0.4.151 1
+10.0.4.150 2
+10.0.4.149 3
+10.0.4.148 4
+10.0.4.147 5
+10.0.4.146 6
+10.0.4.145 7
+10.0.4.144 0
+10.0.4.143 1
+10.0.4.142 2
+10.0.4.141 3
+10.0.4.140 4
+10.0.4.139 5
+10.0.4.138 6
+10.0.4.137 7
+10.0.4.136 0
+10.0.4.135 1
+10.0.4.134 2
+10.0.4.133 3
+10.0.4.132 4
+10.0.4.131 5
+10.0.4.130 6
+10.0.4.129 7
+10.0.4.128 0
+10.0.4.127 0
+10.0.4.126 1
+10.0.4.125 2
+10.0.4.124 3
+10.0.4.123 4
+10.0.4.122 5
+10.0.4.121 6
+10.0.4.120 7
+10.0.4.119 0
+10.0.4.118 1
+10.0.4.117 2
+10.0.4.116 3
+10.0.4.115 4
+10.0.4.114 5
+10.0.4.113 6
+10.0.4.112 7
+10.0.4.111 0
+10.0.4.110 1
+10.0.4.109 2
+10.0.4.108 3
+10.0.4.107 4
+10.0.4.106 5
+10.0.4.105 6
+10.0.4.104 7
+10.0.4.103 0
+10.0.4.102 1
+10.0.4.101 2
+10.0.4.100 3
+10.0.4.99 4
+10.0.4.98 5
+10.0.4.97 6
+10.0.4.96 7
+10.0.4.95 0
+10.0.4.94 1
+10.0.4.93 2
+10.0.4.92 3
+10.0.4.91 4
+10.0.4.90 5
+10.0.4.89 6
+10.0.4.88 7
+10.0.4.87 0
+10.0.4.86 1
+10.0.4.85 2
+10.0.4.84 3
+10.0.4.83 4
+10.0.4.82 5
+10.0.4.81 6
+10.0.4.80 7
+10.0.4.79 0
+10.0.4.78 1
+10.0.4.77 2
+10.0.4.76 3
+10.0.4.75 4
+10.0.4.74 5
+10.0.4.73 6
+10.0.4.72 7
+10.0.4.71 1
+10.0.4.70 2
+10.0.4.69 3
+10.0.4.68 4
+10.0.4.67 5
+10.0.4.66 6
+10.0.4.65 7
+10.0.4.64 0
+10.0.4.63 0
+10.0.4.62 1
+10.0.4.61 2
+10.0.4.60 3
+10.0.4.59 4
+10.0.4.58 5
+10.0.4.57 6
+10.0.4.56 7
+10.0.4.55 0
+10.0.4.54 1
+10.0.4.53 2
+10.0.4.52 3
+10.0.4.51 4
+10.0.4.50 5
+10.0.4.49 6
+10.0.4.48 7
+10.0.4.47 0
+10.0.4.46 1
+10.0.4.45 2
+10.0.4.44 3
+10.0.4.43 4
+10.0.4.42 5
+10.0.4.41 6
+10.0.4.40 7
+10.0.4.39 1
+10.0.4.38 2
+10.0.4.37 3
+10.0.4.36 4
+10.0.4.35 5
+10.0.4.34 6
+10.0.4.33 7
+10.0.4.32 0
+10.0.4.31 0
+10.0.4.30 1
+10.0.4.29 2
+10.0.4.28 3
+10.0.4.27 4
+10.0.4.26 5
+10.0.4.25 6
+10.0.4.24 7
+10.0.4.23 1
+10.0.4.22 2
+10.0.4.21 3
+10.0.4.20 4
+10.0.4.19 5
+10.0.4.18 6
+10.0.4.17 7
+10.0.4.16 0
+10.0.4.15 1
+10.0.4.14 2
+10.0.4.13 3
+10.0.4.12 4
+10.0.4.11 5
+10.0.4.10 6
+10.0.4.9 7
+10.0.4.8 0
+10.0.4.7 1
+10.0.4.6 2
+10.0.4.5 3
+10.0.4.4 4
+10.0.4.3 5
+10.0.4.2 6
+10.0.4.1 7
+10.0.3.240 0
+10.0.3.239 1
+10.0.3.238 2
+10.0.3.237 3
+10.0.3.236 4
+10.0.3.235 5
+10.0.3.234 6
+10.0.3.233 7
+10.0.3.232 0
+10.0.3.231 1
+10.0.3.230 2
+10.0.3.229 3
+10.0.3.228 4
+10.0.3.227 5
+10.0.3.226 6
+10.0.3.225 7
+10.0.3.224 0
+10.0.3.223 0
+10.0.3.222 1
+10.0.3.221 2
+10.0.3.220 3
+10.0.3.219 4
+10.0.3.218 5
+10.0.3.217 6
+10.0.3.216 7
+10.0.3.215 1
+10.0.3.214 2
+10.0.3.213 3
+10.0.3.212 4
+10.0.3.211 5
+10.0.3.210 6
+10.0.3.209 7
+10.0.3.208 0
+10.0.3.207 1
+10.0.3.206 2
+10.0.3.205 3
+10.0.3.204 4
+10.0.3.203 5
+10.0.3.202 6
+10.0.3.201 7
+10.0.3.200 0
+10.0.3.199 1
+10.0.3.198 2
+10.0.3.197 3
+10.0.3.196 4
+10.0.3.195 5
+10.0.3.194 6
+10.0.3.193 7
+10.0.3.192 0
+10.0.3.191 0
+10.0.3.190 1
+10.0.3.189 2
+10.0.3.188 3
+10.0.3.187 4
+10.0.3.186 5
+10.0.3.185 6
+10.0.3.184 7
+10.0.3.183 0
+10.0.3.182 1
+10.0.3.181 2
+10.0.3.180 3
+10.0.3.179 4
+10.0.3.178 5
+10.0.3.177 6
+10.0.3.176 7
+10.0.3.175 0
+10.0.3.174 1
+10.0.3.173 2
+10.0.3.172 3
+10.0.3.171 4
+10.0.3.170 5
+10.0.3.169 6
+10.0.3.168 7
+10.0.3.167 1
+10.0.3.166 2
+10.0.3.165 3
+10.0.3.164 4
+10.0.3.163 5
+10.0.3.162 6
+10.0.3.161 7
+10.0.3.160 0
+10.0.3.159 0
+10.0.3.158 1
+10.0.3.157 2
+10.0.3.156 3
+10.0.3.155 4
+10.0.3.154 5
+10.0.3.153 6
+10.0.3.152 7
+10.0.3.151 1
+10.0.3.150 2
+10.0.3.149 3
+10.0.3.148 4
+10.0.3.147 5
+10.0.3.146 6
+10.0.3.145 7
+10.0.3.144 0
+10.0.3.143 1
+10.0.3.142 2
+10.0.3.141 3
+10.0.3.140 4
+10.0.3.139 5
+10.0.3.138 6
+10.0.3.137 7
+10.0.3.136 0
+10.0.3.135 1
+10.0.3.134 2
+10.0.3.133 3
+10.0.3.132 4
+10.0.3.131 5
+10.0.3.130 6
+10.0.3.129 7
+10.0.3.128 0
+10.0.3.127 0
+10.0.3.126 1
+10.0.3.125 2
+10.0.3.124 3
+10.0.3.123 4
+10.0.3.122 5
+10.0.3.121 6
+10.0.3.120 7
+10.0.3.119 1
+10.0.3.118 2
+10.0.3.117 3
+10.0.3.116 4
+10.0.3.115 5
+10.0.3.114 6
+10.0.3.113 7
+10.0.3.112 0
+10.0.3.111 0
+10.0.3.110 1
+10.0.3.109 2
+10.0.3.108 3
+10.0.3.107 4
+10.0.3.106 5
+10.0.3.105 6
+10.0.3.104 7
+10.0.3.103 0
+10.0.3.102 1
+10.0.3.101 2
+10.0.3.100 3
+10.0.3.99 4
+10.0.3.98 5
+10.0.3.97 6
+10.0.3.96 7
+10.0.3.95 0
+10.0.3.94 1
+10.0.3.93 2
+10.0.3.92 3
+10.0.3.91 4
+10.0.3.90 5
+10.0.3.89 6
+10.0.3.88 7
+10.0.3.87 0
+10.0.3.86 1
+10.0.3.85 2
+10.0.3.84 3
+10.0.3.83 4
+10.0.3.82 5
+10.0.3.81 6
+10.0.3.80 7
+10.0.3.79 0
+10.0.3.78 1
+10.0.3.77 2
+10.0.3.76 3
+10.0.3.75 4
+10.0.3.74 5
+10.0.3.73 6
+10.0.3.72 7
+10.0.3.71 1
+10.0.3.70 2
+10.0.3.69 3
+10.0.3.68 4
+10.0.3.67 5
+10.0.3.66 6
+10.0.3.65 7
+10.0.3.64 0
+10.0.3.63 0
+10.0.3.62 1
+10.0.3.61 2
+10.0.3.60 3
+10.0.3.59 4
+10.0.3.58 5
+10.0.3.57 6
+10.0.3.56 7
+10.0.3.55 1
+10.0.3.54 2
+10.0.3.53 3
+10.0.3.52 4
+10.0.3.51 5
+10.0.3.50 6
+10.0.3.49 7
+10.0.3.48 0
+10.0.3.47 0
+10.0.3.46 1
+10.0.3.45 2
+10.0.3.44 3
+10.0.3.43 4
+10.0.3.42 5
+10.0.3.41 6
+10.0.3.40 7
+10.0.3.39 1
+10.0.3.38 2
+10.0.3.37 3
+10.0.3.36 4
+10.0.3.35 5
+10.0.3.34 6
+10.0.3.33 7
+10.0.3.32 0
+10.0.3.31 0
+10.0.3.30 1
+10.0.3.29 2
+10.0.3.28 3
+10.0.3.27 4
+10.0.3.26 5
+10.0.3.25 6
+10.0.3.24 7
+10.0.3.23 1
+10.0.3.22 2
+10.0.3.21 3
+10.0.3.20 4
+10.0.3.19 5
+10.0.3.18 6
+10.0.3.17 7
+10.0.3.16 0
+10.0.3.15 1
+10.0.3.14 2
+10.0.3.13 3
+10.0.3.12 4
+10.0.3.11 5
+10.0.3.10 6
+10.0.3.9 7
+10.0.3.8 0
+10.0.3.7 1
+10.0.3.6 2
+10.0.3.5 3
+10.0.3.4 4
+10.0.3.3 5
+10.0.3.2 6
+10.0.3.1 7
+10.0.2.240 0
+10.0.2.239 1
+10.0.2.238 2
+10.0.2.237 3
+10.0.2.236 4
+10.0.2.235 5
+10.0.2.234 6
+10.0.2.233 7
+10.0.2.232 0
+10.0.2.231 1
+10.0.2.230 2
+10.0.2.229 3
+10.0.2.228 4
+10.0.2.227 5
+10.0.2.226 6
+10.0.2.225 7
+10.0.2.224 0
+10.0.2.223 0
+10.0.2.222 1
+10.0.2.221 2
+10.0.2.220 3
+10.0.2.219 4
+10.0.2.218 5
+10.0.2.217 6
+10.0.2.216 7
+10.0.2.215 1
+10.0.2.214 2
+10.0.2.213 3
+10.0.2.212 4
+10.0.2.211 5
+10.0.2.210 6
+10.0.2.209 7
+10.0.2.208 0
+10.0.2.207 1
+10.0.2.206 2
+10.0.2.205 3
+10.0.2.204 4
+10.0.2.203 5
+10.0.2.202 6
+10.0.2.201 7
+10.0.2.200 0
+10.0.2.199 1
+10.0.2.198 2
+10.0.2.197 3
+10.0.2.196 4
+10.0.2.195 5
+10.0.2.194 6
+10.0.2.193 7
+10.0.2.192 0
+10.0.2.191 0
+10.0.2.190 1
+10.0.2.189 2
+10.0.2.188 3
+10.0.2.187 4
+10.0.2.186 5
+10.0.2.185 6
+10.0.2.184 7
+10.0.2.183 0
+10.0.2.182 1
+10.0.2.181 2
+10.0.2.180 3
+10.0.2.179 4
+10.0.2.178 5
+10.0.2.177 6
+10.0.2.176 7
+10.0.2.175 0
+10.0.2.174 1
+10.0.2.173 2
+10.0.2.172 3
+10.0.2.171 4
+10.0.2.170 5
+10.0.2.169 6
+10.0.2.168 7
+10.0.2.167 1
+10.0.2.166 2
+10.0.2.165 3
+10.0.2.164 4
+10.0.2.163 5
+10.0.2.162 6
+10.0.2.161 7
+10.0.2.160 0
+10.0.2.159 0
+10.0.2.158 1
+10.0.2.157 2
+10.0.2.156 3
+10.0.2.155 4
+10.0.2.154 5
+10.0.2.153 6
+10.0.2.152 7
+10.0.2.151 1
+10.0.2.150 2
+10.0.2.149 3
+10.0.2.148 4
+10.0.2.147 5
+10.0.2.146 6
+10.0.2.145 7
+10.0.2.144 0
+10.0.2.143 1
+10.0.2.142 2
+10.0.2.141 3
+10.0.2.140 4
+10.0.2.139 5
+10.0.2.138 6
+10.0.2.137 7
+10.0.2.136 0
+10.0.2.135 1
+10.0.2.134 2
+10.0.2.133 3
+10.0.2.132 4
+10.0.2.131 5
+10.0.2.130 6
+10.0.2.129 7
+10.0.2.128 0
+10.0.2.127 0
+10.0.2.126 1
+10.0.2.125 2
+10.0.2.124 3
+10.0.2.123 4
+10.0.2.122 5
+10.0.2.121 6
+10.0.2.120 7
+10.0.2.119 0
+10.0.2.118 1
+10.0.2.117 2
+10.0.2.116 3
+10.0.2.115 4
+10.0.2.114 5
+10.0.2.113 6
+10.0.2.112 7
+10.0.2.111 0
+10.0.2.110 1
+10.0.2.109 2
+10.0.2.108 3
+10.0.2.107 4
+10.0.2.106 5
+10.0.2.105 6
+10.0.2.104 7
+10.0.2.103 0
+10.0.2.102 1
+10.0.2.101 2
+10.0.2.100 3
+10.0.2.99 4
+10.0.2.98 5
+10.0.2.97 6
+10.0.2.96 7
+10.0.2.95 0
+10.0.2.94 1
+10.0.2.93 2
+10.0.2.92 3
+10.0.2.91 4
+10.0.2.90 5
+10.0.2.89 6
+10.0.2.88 7
+10.0.2.87 0
+10.0.2.86 1
+10.0.2.85 2
+10.0.2.84 3
+10.0.2.83 4
+10.0.2.82 5
+10.0.2.81 6
+10.0.2.80 7
+10.0.2.79 0
+10.0.2.78 1
+10.0.2.77 2
+10.0.2.76 3
+10.0.2.75 4
+10.0.2.74 5
+10.0.2.73 6
+10.0.2.72 7
+10.0.2.71 1
+10.0.2.70 2
+10.0.2.69 3
+10.0.2.68 4
+10.0.2.67 5
+10.0.2.66 6
+10.0.2.65 7
+10.0.2.64 0
+10.0.2.63 0
+10.0.2.62 1
+10.0.2.61 2
+10.0.2.60 3
+10.0.2.59 4
+10.0.2.58 5
+10.0.2.57 6
+10.0.2.56 7
+10.0.2.55 0
+10.0.2.54 1
+10.0.2.53 2
+10.0.2.52 3
+10.0.2.51 4
+10.0.2.50 5
+10.0.2.49 6
+10.0.2.48 7
+10.0.2.47 1
+10.0.2.46 2
+10.0.2.45 3
+10.0.2.44 4
+10.0.2.43 5
+10.0.2.42 6
+10.0.2.41 7
+10.0.2.40 0
+10.0.2.39 1
+10.0.2.38 2
+10.0.2.37 3
+10.0.2.36 4
+10.0.2.35 5
+10.0.2.34 6
+10.0.2.33 7
+10.0.2.32 0
+10.0.2.31 0
+10.0.2.30 1
+10.0.2.29 2
+10.0.2.28 3
+10.0.2.27 4
+10.0.2.26 5
+10.0.2.25 6
+10.0.2.24 7
+10.0.2.23 1
+10.0.2.22 2
+10.0.2.21 3
+10.0.2.20 4
+10.0.2.19 5
+10.0.2.18 6
+10.0.2.17 7
+10.0.2.16 0
+10.0.2.15 1
+10.0.2.14 2
+10.0.2.13 3
+10.0.2.12 4
+10.0.2.11 5
+10.0.2.10 6
+10.0.2.9 7
+10.0.2.8 0
+10.0.2.7 1
+10.0.2.6 2
+10.0.2.5 3
+10.0.2.4 4
+10.0.2.3 5
+10.0.2.2 6
+10.0.2.1 7
+10.0.1.240 0
+10.0.1.239 1
+10.0.1.238 2
+10.0.1.237 3
+10.0.1.236 4
+10.0.1.235 5
+10.0.1.234 6
+10.0.1.233 7
+10.0.1.232 0
+10.0.1.231 1
+10.0.1.230 2
+10.0.1.229 3
+10.0.1.228 4
+10.0.1.227 5
+10.0.1.226 6
+10.0.1.225 7
+10.0.1.224 0
+10.0.1.223 0
+10.0.1.222 1
+10.0.1.221 2
+10.0.1.220 3
+10.0.1.219 4
+10.0.1.218 5
+10.0.1.217 6
+10.0.1.216 7
+10.0.1.215 1
+10.0.1.214 2
+10.0.1.213 3
+10.0.1.212 4
+10.0.1.211 5
+10.0.1.210 6
+10.0.1.209 7
+10.0.1.208 0
+10.0.1.207 1
+10.0.1.206 2
+10.0.1.205 3
+10.0.1.204 4
+10.0.1.203 5
+10.0.1.202 6
+10.0.1.201 7
+10.0.1.200 0
+10.0.1.199 1
+10.0.1.198 2
+10.0.1.197 3
+10.0.1.196 4
+10.0.1.195 5
+10.0.1.194 6
+10.0.1.193 7
+10.0.1.192 0
+10.0.1.191 0
+10.0.1.190 1
+10.0.1.189 2
+10.0.1.188 3
+10.0.1.187 4
+10.0.1.186 5
+10.0.1.185 6
+10.0.1.184 7
+10.0.1.183 0
+10.0.1.182 1
+10.0.1.181 2
+10.0.1.180 3
+10.0.1.179 4
+10.0.1.178 5
+10.0.1.177 6
+10.0.1.176 7
+10.0.1.175 0
+10.0.1.174 1
+10.0.1.173 2
+10.0.1.172 3
+10.0.1.171 4
+10.0.1.170 5
+10.0.1.169 6
+10.0.1.168 7
+10.0.1.167 1
+10.0.1.166 2
+10.0.1.165 3
+10.0.1.164 4
+10.0.1.163 5
+10.0.1.162 6
+10.0.1.161 7
+10.0.1.160 0
+10.0.1.159 0
+10.0.1.158 1
+10.0.1.157 2
+10.0.1.156 3
+10.0.1.155 4
+10.0.1.154 5
+10.0.1.153 6
+10.0.1.152 7
+10.0.1.151 1
+10.0.1.150 2
+10.0.1.149 3
+10.0.1.148 4
+10.0.1.147 5
+10.0.1.146 6
+10.0.1.145 7
+10.0.1.144 0
+10.0.1.143 1
+10.0.1.142 2
+10.0.1.141 3
+10.0.1.140 4
+10.0.1.139 5
+10.0.1.138 6
+10.0.1.137 7
+10.0.1.136 0
+10.0.1.135 1
+10.0.1.134 2
+10.0.1.133 3
+10.0.1.132 4
+10.0.1.131 5
+10.0.1.130 6
+10.0.1.129 7
+10.0.1.128 0
+10.0.1.127 0
+10.0.1.126 1
+10.0.1.125 2
+10.0.1.124 3
+10.0.1.123 4
+10.0.1.122 5
+10.0.1.121 6
+10.0.1.120 7
+10.0.1.119 0
+10.0.1.118 1
+10.0.1.117 2
+10.0.1.116 3
+10.0.1.115 4
+10.0.1.114 5
+10.0.1.113 6
+10.0.1.112 7
+10.0.1.111 0
+10.0.1.110 1
+10.0.1.109 2
+10.0.1.108 3
+10.0.1.107 4
+10.0.1.106 5
+10.0.1.105 6
+10.0.1.104 7
+10.0.1.103 1
+10.0.1.102 2
+10.0.1.101 3
+10.0.1.100 4
+10.0.1.99 5
+10.0.1.98 6
+10.0.1.97 7
+10.0.1.96 0
+10.0.1.95 0
+10.0.1.94 1
+10.0.1.93 2
+10.0.1.92 3
+10.0.1.91 4
+10.0.1.90 5
+10.0.1.89 6
+10.0.1.88 7
+10.0.1.87 0
+10.0.1.86 1
+10.0.1.85 2
+10.0.1.84 3
+10.0.1.83 4
+10.0.1.82 5
+10.0.1.81 6
+10.0.1.80 7
+10.0.1.79 0
+10.0.1.78 1
+10.0.1.77 2
+10.0.1.76 3
+10.0.1.75 4
+10.0.1.74 5
+10.0.1.73 6
+10.0.1.72 7
+10.0.1.71 1
+10.0.1.70 2
+10.0.1.69 3
+10.0.1.68 4
+10.0.1.67 5
+10.0.1.66 6
+10.0.1.65 7
+10.0.1.64 0
+10.0.1.63 0
+10.0.1.62 1
+10.0.1.61 2
+10.0.1.60 3
+10.0.1.59 4
+10.0.1.58 5
+10.0.1.57 6
+10.0.1.56 7
+10.0.1.55 0
+10.0.1.54 1
+10.0.1.53 2
+10.0.1.52 3
+10.0.1.51 4
+10.0.1.50 5
+10.0.1.49 6
+10.0.1.48 7
+10.0.1.47 0
+10.0.1.46 1
+10.0.1.45 2
+10.0.1.44 3
+10.0.1.43 4
+10.0.1.42 5
+10.0.1.41 6
+10.0.1.40 7
+10.0.1.39 1
+10.0.1.38 2
+10.0.1.37 3
+10.0.1.36 4
+10.0.1.35 5
+10.0.1.34 6
+10.0.1.33 7
+10.0.1.32 0
+10.0.1.31 0
+10.0.1.30 1
+10.0.1.29 2
+10.0.1.28 3
+10.0.1.27 4
+10.0.1.26 5
+10.0.1.25 6
+10.0.1.24 7
+10.0.1.23 1
+10.0.1.22 2
+10.0.1.21 3
+10.0.1.20 4
+10.0.1.19 5
+10.0.1.18 6
+10.0.1.17 7
+10.0.1.16 0
+10.0.1.15 1
+10.0.1.14 2
+10.0.1.13 3
+10.0.1.12 4
+10.0.1.11 5
+10.0.1.10 6
+10.0.1.9 7
+10.0.1.8 0
+10.0.1.7 1
+10.0.1.6 2
+10.0.1.5 3
+10.0.1.4 4
+10.0.1.3 5
+10.0.1.2 6
+10.0.1.1 7
+EOF
+
+simple_test 0,0,0,0,0,0,0,0 <<EOF
+10.0.1.1 -1
+10.0.1.2 -1
+10.0.1.3 -1
+10.0.1.4 -1
+10.0.1.5 -1
+10.0.1.6 -1
+10.0.1.7 -1
+10.0.1.8 -1
+10.0.1.9 -1
+10.0.1.10 -1
+10.0.1.11 -1
+10.0.1.12 -1
+10.0.1.13 -1
+10.0.1.14 -1
+10.0.1.15 -1
+10.0.1.16 -1
+10.0.1.17 -1
+10.0.1.18 -1
+10.0.1.19 -1
+10.0.1.20 -1
+10.0.1.21 -1
+10.0.1.22 -1
+10.0.1.23 -1
+10.0.1.24 -1
+10.0.1.25 -1
+10.0.1.26 -1
+10.0.1.27 -1
+10.0.1.28 -1
+10.0.1.29 -1
+10.0.1.30 -1
+10.0.1.31 -1
+10.0.1.32 -1
+10.0.1.33 -1
+10.0.1.34 -1
+10.0.1.35 -1
+10.0.1.36 -1
+10.0.1.37 -1
+10.0.1.38 -1
+10.0.1.39 -1
+10.0.1.40 -1
+10.0.1.41 -1
+10.0.1.42 -1
+10.0.1.43 -1
+10.0.1.44 -1
+10.0.1.45 -1
+10.0.1.46 -1
+10.0.1.47 -1
+10.0.1.48 -1
+10.0.1.49 -1
+10.0.1.50 -1
+10.0.1.51 -1
+10.0.1.52 -1
+10.0.1.53 -1
+10.0.1.54 -1
+10.0.1.55 -1
+10.0.1.56 -1
+10.0.1.57 -1
+10.0.1.58 -1
+10.0.1.59 -1
+10.0.1.60 -1
+10.0.1.61 -1
+10.0.1.62 -1
+10.0.1.63 -1
+10.0.1.64 -1
+10.0.1.65 -1
+10.0.1.66 -1
+10.0.1.67 -1
+10.0.1.68 -1
+10.0.1.69 -1
+10.0.1.70 -1
+10.0.1.71 -1
+10.0.1.72 -1
+10.0.1.73 -1
+10.0.1.74 -1
+10.0.1.75 -1
+10.0.1.76 -1
+10.0.1.77 -1
+10.0.1.78 -1
+10.0.1.79 -1
+10.0.1.80 -1
+10.0.1.81 -1
+10.0.1.82 -1
+10.0.1.83 -1
+10.0.1.84 -1
+10.0.1.85 -1
+10.0.1.86 -1
+10.0.1.87 -1
+10.0.1.88 -1
+10.0.1.89 -1
+10.0.1.90 -1
+10.0.1.91 -1
+10.0.1.92 -1
+10.0.1.93 -1
+10.0.1.94 -1
+10.0.1.95 -1
+10.0.1.96 -1
+10.0.1.97 -1
+10.0.1.98 -1
+10.0.1.99 -1
+10.0.1.100 -1
+10.0.1.101 -1
+10.0.1.102 -1
+10.0.1.103 -1
+10.0.1.104 -1
+10.0.1.105 -1
+10.0.1.106 -1
+10.0.1.107 -1
+10.0.1.108 -1
+10.0.1.109 -1
+10.0.1.110 -1
+10.0.1.111 -1
+10.0.1.112 -1
+10.0.1.113 -1
+10.0.1.114 -1
+10.0.1.115 -1
+10.0.1.116 -1
+10.0.1.117 -1
+10.0.1.118 -1
+10.0.1.119 -1
+10.0.1.120 -1
+10.0.1.121 -1
+10.0.1.122 -1
+10.0.1.123 -1
+10.0.1.124 -1
+10.0.1.125 -1
+10.0.1.126 -1
+10.0.1.127 -1
+10.0.1.128 -1
+10.0.1.129 -1
+10.0.1.130 -1
+10.0.1.131 -1
+10.0.1.132 -1
+10.0.1.133 -1
+10.0.1.134 -1
+10.0.1.135 -1
+10.0.1.136 -1
+10.0.1.137 -1
+10.0.1.138 -1
+10.0.1.139 -1
+10.0.1.140 -1
+10.0.1.141 -1
+10.0.1.142 -1
+10.0.1.143 -1
+10.0.1.144 -1
+10.0.1.145 -1
+10.0.1.146 -1
+10.0.1.147 -1
+10.0.1.148 -1
+10.0.1.149 -1
+10.0.1.150 -1
+10.0.1.151 -1
+10.0.1.152 -1
+10.0.1.153 -1
+10.0.1.154 -1
+10.0.1.155 -1
+10.0.1.156 -1
+10.0.1.157 -1
+10.0.1.158 -1
+10.0.1.159 -1
+10.0.1.160 -1
+10.0.1.161 -1
+10.0.1.162 -1
+10.0.1.163 -1
+10.0.1.164 -1
+10.0.1.165 -1
+10.0.1.166 -1
+10.0.1.167 -1
+10.0.1.168 -1
+10.0.1.169 -1
+10.0.1.170 -1
+10.0.1.171 -1
+10.0.1.172 -1
+10.0.1.173 -1
+10.0.1.174 -1
+10.0.1.175 -1
+10.0.1.176 -1
+10.0.1.177 -1
+10.0.1.178 -1
+10.0.1.179 -1
+10.0.1.180 -1
+10.0.1.181 -1
+10.0.1.182 -1
+10.0.1.183 -1
+10.0.1.184 -1
+10.0.1.185 -1
+10.0.1.186 -1
+10.0.1.187 -1
+10.0.1.188 -1
+10.0.1.189 -1
+10.0.1.190 -1
+10.0.1.191 -1
+10.0.1.192 -1
+10.0.1.193 -1
+10.0.1.194 -1
+10.0.1.195 -1
+10.0.1.196 -1
+10.0.1.197 -1
+10.0.1.198 -1
+10.0.1.199 -1
+10.0.1.200 -1
+10.0.1.201 -1
+10.0.1.202 -1
+10.0.1.203 -1
+10.0.1.204 -1
+10.0.1.205 -1
+10.0.1.206 -1
+10.0.1.207 -1
+10.0.1.208 -1
+10.0.1.209 -1
+10.0.1.210 -1
+10.0.1.211 -1
+10.0.1.212 -1
+10.0.1.213 -1
+10.0.1.214 -1
+10.0.1.215 -1
+10.0.1.216 -1
+10.0.1.217 -1
+10.0.1.218 -1
+10.0.1.219 -1
+10.0.1.220 -1
+10.0.1.221 -1
+10.0.1.222 -1
+10.0.1.223 -1
+10.0.1.224 -1
+10.0.1.225 -1
+10.0.1.226 -1
+10.0.1.227 -1
+10.0.1.228 -1
+10.0.1.229 -1
+10.0.1.230 -1
+10.0.1.231 -1
+10.0.1.232 -1
+10.0.1.233 -1
+10.0.1.234 -1
+10.0.1.235 -1
+10.0.1.236 -1
+10.0.1.237 -1
+10.0.1.238 -1
+10.0.1.239 -1
+10.0.1.240 -1
+10.0.2.1 -1
+10.0.2.2 -1
+10.0.2.3 -1
+10.0.2.4 -1
+10.0.2.5 -1
+10.0.2.6 -1
+10.0.2.7 -1
+10.0.2.8 -1
+10.0.2.9 -1
+10.0.2.10 -1
+10.0.2.11 -1
+10.0.2.12 -1
+10.0.2.13 -1
+10.0.2.14 -1
+10.0.2.15 -1
+10.0.2.16 -1
+10.0.2.17 -1
+10.0.2.18 -1
+10.0.2.19 -1
+10.0.2.20 -1
+10.0.2.21 -1
+10.0.2.22 -1
+10.0.2.23 -1
+10.0.2.24 -1
+10.0.2.25 -1
+10.0.2.26 -1
+10.0.2.27 -1
+10.0.2.28 -1
+10.0.2.29 -1
+10.0.2.30 -1
+10.0.2.31 -1
+10.0.2.32 -1
+10.0.2.33 -1
+10.0.2.34 -1
+10.0.2.35 -1
+10.0.2.36 -1
+10.0.2.37 -1
+10.0.2.38 -1
+10.0.2.39 -1
+10.0.2.40 -1
+10.0.2.41 -1
+10.0.2.42 -1
+10.0.2.43 -1
+10.0.2.44 -1
+10.0.2.45 -1
+10.0.2.46 -1
+10.0.2.47 -1
+10.0.2.48 -1
+10.0.2.49 -1
+10.0.2.50 -1
+10.0.2.51 -1
+10.0.2.52 -1
+10.0.2.53 -1
+10.0.2.54 -1
+10.0.2.55 -1
+10.0.2.56 -1
+10.0.2.57 -1
+10.0.2.58 -1
+10.0.2.59 -1
+10.0.2.60 -1
+10.0.2.61 -1
+10.0.2.62 -1
+10.0.2.63 -1
+10.0.2.64 -1
+10.0.2.65 -1
+10.0.2.66 -1
+10.0.2.67 -1
+10.0.2.68 -1
+10.0.2.69 -1
+10.0.2.70 -1
+10.0.2.71 -1
+10.0.2.72 -1
+10.0.2.73 -1
+10.0.2.74 -1
+10.0.2.75 -1
+10.0.2.76 -1
+10.0.2.77 -1
+10.0.2.78 -1
+10.0.2.79 -1
+10.0.2.80 -1
+10.0.2.81 -1
+10.0.2.82 -1
+10.0.2.83 -1
+10.0.2.84 -1
+10.0.2.85 -1
+10.0.2.86 -1
+10.0.2.87 -1
+10.0.2.88 -1
+10.0.2.89 -1
+10.0.2.90 -1
+10.0.2.91 -1
+10.0.2.92 -1
+10.0.2.93 -1
+10.0.2.94 -1
+10.0.2.95 -1
+10.0.2.96 -1
+10.0.2.97 -1
+10.0.2.98 -1
+10.0.2.99 -1
+10.0.2.100 -1
+10.0.2.101 -1
+10.0.2.102 -1
+10.0.2.103 -1
+10.0.2.104 -1
+10.0.2.105 -1
+10.0.2.106 -1
+10.0.2.107 -1
+10.0.2.108 -1
+10.0.2.109 -1
+10.0.2.110 -1
+10.0.2.111 -1
+10.0.2.112 -1
+10.0.2.113 -1
+10.0.2.114 -1
+10.0.2.115 -1
+10.0.2.116 -1
+10.0.2.117 -1
+10.0.2.118 -1
+10.0.2.119 -1
+10.0.2.120 -1
+10.0.2.121 -1
+10.0.2.122 -1
+10.0.2.123 -1
+10.0.2.124 -1
+10.0.2.125 -1
+10.0.2.126 -1
+10.0.2.127 -1
+10.0.2.128 -1
+10.0.2.129 -1
+10.0.2.130 -1
+10.0.2.131 -1
+10.0.2.132 -1
+10.0.2.133 -1
+10.0.2.134 -1
+10.0.2.135 -1
+10.0.2.136 -1
+10.0.2.137 -1
+10.0.2.138 -1
+10.0.2.139 -1
+10.0.2.140 -1
+10.0.2.141 -1
+10.0.2.142 -1
+10.0.2.143 -1
+10.0.2.144 -1
+10.0.2.145 -1
+10.0.2.146 -1
+10.0.2.147 -1
+10.0.2.148 -1
+10.0.2.149 -1
+10.0.2.150 -1
+10.0.2.151 -1
+10.0.2.152 -1
+10.0.2.153 -1
+10.0.2.154 -1
+10.0.2.155 -1
+10.0.2.156 -1
+10.0.2.157 -1
+10.0.2.158 -1
+10.0.2.159 -1
+10.0.2.160 -1
+10.0.2.161 -1
+10.0.2.162 -1
+10.0.2.163 -1
+10.0.2.164 -1
+10.0.2.165 -1
+10.0.2.166 -1
+10.0.2.167 -1
+10.0.2.168 -1
+10.0.2.169 -1
+10.0.2.170 -1
+10.0.2.171 -1
+10.0.2.172 -1
+10.0.2.173 -1
+10.0.2.174 -1
+10.0.2.175 -1
+10.0.2.176 -1
+10.0.2.177 -1
+10.0.2.178 -1
+10.0.2.179 -1
+10.0.2.180 -1
+10.0.2.181 -1
+10.0.2.182 -1
+10.0.2.183 -1
+10.0.2.184 -1
+10.0.2.185 -1
+10.0.2.186 -1
+10.0.2.187 -1
+10.0.2.188 -1
+10.0.2.189 -1
+10.0.2.190 -1
+10.0.2.191 -1
+10.0.2.192 -1
+10.0.2.193 -1
+10.0.2.194 -1
+10.0.2.195 -1
+10.0.2.196 -1
+10.0.2.197 -1
+10.0.2.198 -1
+10.0.2.199 -1
+10.0.2.200 -1
+10.0.2.201 -1
+10.0.2.202 -1
+10.0.2.203 -1
+10.0.2.204 -1
+10.0.2.205 -1
+10.0.2.206 -1
+10.0.2.207 -1
+10.0.2.208 -1
+10.0.2.209 -1
+10.0.2.210 -1
+10.0.2.211 -1
+10.0.2.212 -1
+10.0.2.213 -1
+10.0.2.214 -1
+10.0.2.215 -1
+10.0.2.216 -1
+10.0.2.217 -1
+10.0.2.218 -1
+10.0.2.219 -1
+10.0.2.220 -1
+10.0.2.221 -1
+10.0.2.222 -1
+10.0.2.223 -1
+10.0.2.224 -1
+10.0.2.225 -1
+10.0.2.226 -1
+10.0.2.227 -1
+10.0.2.228 -1
+10.0.2.229 -1
+10.0.2.230 -1
+10.0.2.231 -1
+10.0.2.232 -1
+10.0.2.233 -1
+10.0.2.234 -1
+10.0.2.235 -1
+10.0.2.236 -1
+10.0.2.237 -1
+10.0.2.238 -1
+10.0.2.239 -1
+10.0.2.240 -1
+10.0.3.1 -1
+10.0.3.2 -1
+10.0.3.3 -1
+10.0.3.4 -1
+10.0.3.5 -1
+10.0.3.6 -1
+10.0.3.7 -1
+10.0.3.8 -1
+10.0.3.9 -1
+10.0.3.10 -1
+10.0.3.11 -1
+10.0.3.12 -1
+10.0.3.13 -1
+10.0.3.14 -1
+10.0.3.15 -1
+10.0.3.16 -1
+10.0.3.17 -1
+10.0.3.18 -1
+10.0.3.19 -1
+10.0.3.20 -1
+10.0.3.21 -1
+10.0.3.22 -1
+10.0.3.23 -1
+10.0.3.24 -1
+10.0.3.25 -1
+10.0.3.26 -1
+10.0.3.27 -1
+10.0.3.28 -1
+10.0.3.29 -1
+10.0.3.30 -1
+10.0.3.31 -1
+10.0.3.32 -1
+10.0.3.33 -1
+10.0.3.34 -1
+10.0.3.35 -1
+10.0.3.36 -1
+10.0.3.37 -1
+10.0.3.38 -1
+10.0.3.39 -1
+10.0.3.40 -1
+10.0.3.41 -1
+10.0.3.42 -1
+10.0.3.43 -1
+10.0.3.44 -1
+10.0.3.45 -1
+10.0.3.46 -1
+10.0.3.47 -1
+10.0.3.48 -1
+10.0.3.49 -1
+10.0.3.50 -1
+10.0.3.51 -1
+10.0.3.52 -1
+10.0.3.53 -1
+10.0.3.54 -1
+10.0.3.55 -1
+10.0.3.56 -1
+10.0.3.57 -1
+10.0.3.58 -1
+10.0.3.59 -1
+10.0.3.60 -1
+10.0.3.61 -1
+10.0.3.62 -1
+10.0.3.63 -1
+10.0.3.64 -1
+10.0.3.65 -1
+10.0.3.66 -1
+10.0.3.67 -1
+10.0.3.68 -1
+10.0.3.69 -1
+10.0.3.70 -1
+10.0.3.71 -1
+10.0.3.72 -1
+10.0.3.73 -1
+10.0.3.74 -1
+10.0.3.75 -1
+10.0.3.76 -1
+10.0.3.77 -1
+10.0.3.78 -1
+10.0.3.79 -1
+10.0.3.80 -1
+10.0.3.81 -1
+10.0.3.82 -1
+10.0.3.83 -1
+10.0.3.84 -1
+10.0.3.85 -1
+10.0.3.86 -1
+10.0.3.87 -1
+10.0.3.88 -1
+10.0.3.89 -1
+10.0.3.90 -1
+10.0.3.91 -1
+10.0.3.92 -1
+10.0.3.93 -1
+10.0.3.94 -1
+10.0.3.95 -1
+10.0.3.96 -1
+10.0.3.97 -1
+10.0.3.98 -1
+10.0.3.99 -1
+10.0.3.100 -1
+10.0.3.101 -1
+10.0.3.102 -1
+10.0.3.103 -1
+10.0.3.104 -1
+10.0.3.105 -1
+10.0.3.106 -1
+10.0.3.107 -1
+10.0.3.108 -1
+10.0.3.109 -1
+10.0.3.110 -1
+10.0.3.111 -1
+10.0.3.112 -1
+10.0.3.113 -1
+10.0.3.114 -1
+10.0.3.115 -1
+10.0.3.116 -1
+10.0.3.117 -1
+10.0.3.118 -1
+10.0.3.119 -1
+10.0.3.120 -1
+10.0.3.121 -1
+10.0.3.122 -1
+10.0.3.123 -1
+10.0.3.124 -1
+10.0.3.125 -1
+10.0.3.126 -1
+10.0.3.127 -1
+10.0.3.128 -1
+10.0.3.129 -1
+10.0.3.130 -1
+10.0.3.131 -1
+10.0.3.132 -1
+10.0.3.133 -1
+10.0.3.134 -1
+10.0.3.135 -1
+10.0.3.136 -1
+10.0.3.137 -1
+10.0.3.138 -1
+10.0.3.139 -1
+10.0.3.140 -1
+10.0.3.141 -1
+10.0.3.142 -1
+10.0.3.143 -1
+10.0.3.144 -1
+10.0.3.145 -1
+10.0.3.146 -1
+10.0.3.147 -1
+10.0.3.148 -1
+10.0.3.149 -1
+10.0.3.150 -1
+10.0.3.151 -1
+10.0.3.152 -1
+10.0.3.153 -1
+10.0.3.154 -1
+10.0.3.155 -1
+10.0.3.156 -1
+10.0.3.157 -1
+10.0.3.158 -1
+10.0.3.159 -1
+10.0.3.160 -1
+10.0.3.161 -1
+10.0.3.162 -1
+10.0.3.163 -1
+10.0.3.164 -1
+10.0.3.165 -1
+10.0.3.166 -1
+10.0.3.167 -1
+10.0.3.168 -1
+10.0.3.169 -1
+10.0.3.170 -1
+10.0.3.171 -1
+10.0.3.172 -1
+10.0.3.173 -1
+10.0.3.174 -1
+10.0.3.175 -1
+10.0.3.176 -1
+10.0.3.177 -1
+10.0.3.178 -1
+10.0.3.179 -1
+10.0.3.180 -1
+10.0.3.181 -1
+10.0.3.182 -1
+10.0.3.183 -1
+10.0.3.184 -1
+10.0.3.185 -1
+10.0.3.186 -1
+10.0.3.187 -1
+10.0.3.188 -1
+10.0.3.189 -1
+10.0.3.190 -1
+10.0.3.191 -1
+10.0.3.192 -1
+10.0.3.193 -1
+10.0.3.194 -1
+10.0.3.195 -1
+10.0.3.196 -1
+10.0.3.197 -1
+10.0.3.198 -1
+10.0.3.199 -1
+10.0.3.200 -1
+10.0.3.201 -1
+10.0.3.202 -1
+10.0.3.203 -1
+10.0.3.204 -1
+10.0.3.205 -1
+10.0.3.206 -1
+10.0.3.207 -1
+10.0.3.208 -1
+10.0.3.209 -1
+10.0.3.210 -1
+10.0.3.211 -1
+10.0.3.212 -1
+10.0.3.213 -1
+10.0.3.214 -1
+10.0.3.215 -1
+10.0.3.216 -1
+10.0.3.217 -1
+10.0.3.218 -1
+10.0.3.219 -1
+10.0.3.220 -1
+10.0.3.221 -1
+10.0.3.222 -1
+10.0.3.223 -1
+10.0.3.224 -1
+10.0.3.225 -1
+10.0.3.226 -1
+10.0.3.227 -1
+10.0.3.228 -1
+10.0.3.229 -1
+10.0.3.230 -1
+10.0.3.231 -1
+10.0.3.232 -1
+10.0.3.233 -1
+10.0.3.234 -1
+10.0.3.235 -1
+10.0.3.236 -1
+10.0.3.237 -1
+10.0.3.238 -1
+10.0.3.239 -1
+10.0.3.240 -1
+10.0.4.1 -1
+10.0.4.2 -1
+10.0.4.3 -1
+10.0.4.4 -1
+10.0.4.5 -1
+10.0.4.6 -1
+10.0.4.7 -1
+10.0.4.8 -1
+10.0.4.9 -1
+10.0.4.10 -1
+10.0.4.11 -1
+10.0.4.12 -1
+10.0.4.13 -1
+10.0.4.14 -1
+10.0.4.15 -1
+10.0.4.16 -1
+10.0.4.17 -1
+10.0.4.18 -1
+10.0.4.19 -1
+10.0.4.20 -1
+10.0.4.21 -1
+10.0.4.22 -1
+10.0.4.23 -1
+10.0.4.24 -1
+10.0.4.25 -1
+10.0.4.26 -1
+10.0.4.27 -1
+10.0.4.28 -1
+10.0.4.29 -1
+10.0.4.30 -1
+10.0.4.31 -1
+10.0.4.32 -1
+10.0.4.33 -1
+10.0.4.34 -1
+10.0.4.35 -1
+10.0.4.36 -1
+10.0.4.37 -1
+10.0.4.38 -1
+10.0.4.39 -1
+10.0.4.40 -1
+10.0.4.41 -1
+10.0.4.42 -1
+10.0.4.43 -1
+10.0.4.44 -1
+10.0.4.45 -1
+10.0.4.46 -1
+10.0.4.47 -1
+10.0.4.48 -1
+10.0.4.49 -1
+10.0.4.50 -1
+10.0.4.51 -1
+10.0.4.52 -1
+10.0.4.53 -1
+10.0.4.54 -1
+10.0.4.55 -1
+10.0.4.56 -1
+10.0.4.57 -1
+10.0.4.58 -1
+10.0.4.59 -1
+10.0.4.60 -1
+10.0.4.61 -1
+10.0.4.62 -1
+10.0.4.63 -1
+10.0.4.64 -1
+10.0.4.65 -1
+10.0.4.66 -1
+10.0.4.67 -1
+10.0.4.68 -1
+10.0.4.69 -1
+10.0.4.70 -1
+10.0.4.71 -1
+10.0.4.72 -1
+10.0.4.73 -1
+10.0.4.74 -1
+10.0.4.75 -1
+10.0.4.76 -1
+10.0.4.77 -1
+10.0.4.78 -1
+10.0.4.79 -1
+10.0.4.80 -1
+10.0.4.81 -1
+10.0.4.82 -1
+10.0.4.83 -1
+10.0.4.84 -1
+10.0.4.85 -1
+10.0.4.86 -1
+10.0.4.87 -1
+10.0.4.88 -1
+10.0.4.89 -1
+10.0.4.90 -1
+10.0.4.91 -1
+10.0.4.92 -1
+10.0.4.93 -1
+10.0.4.94 -1
+10.0.4.95 -1
+10.0.4.96 -1
+10.0.4.97 -1
+10.0.4.98 -1
+10.0.4.99 -1
+10.0.4.100 -1
+10.0.4.101 -1
+10.0.4.102 -1
+10.0.4.103 -1
+10.0.4.104 -1
+10.0.4.105 -1
+10.0.4.106 -1
+10.0.4.107 -1
+10.0.4.108 -1
+10.0.4.109 -1
+10.0.4.110 -1
+10.0.4.111 -1
+10.0.4.112 -1
+10.0.4.113 -1
+10.0.4.114 -1
+10.0.4.115 -1
+10.0.4.116 -1
+10.0.4.117 -1
+10.0.4.118 -1
+10.0.4.119 -1
+10.0.4.120 -1
+10.0.4.121 -1
+10.0.4.122 -1
+10.0.4.123 -1
+10.0.4.124 -1
+10.0.4.125 -1
+10.0.4.126 -1
+10.0.4.127 -1
+10.0.4.128 -1
+10.0.4.129 -1
+10.0.4.130 -1
+10.0.4.131 -1
+10.0.4.132 -1
+10.0.4.133 -1
+10.0.4.134 -1
+10.0.4.135 -1
+10.0.4.136 -1
+10.0.4.137 -1
+10.0.4.138 -1
+10.0.4.139 -1
+10.0.4.140 -1
+10.0.4.141 -1
+10.0.4.142 -1
+10.0.4.143 -1
+10.0.4.144 -1
+10.0.4.145 -1
+10.0.4.146 -1
+10.0.4.147 -1
+10.0.4.148 -1
+10.0.4.149 -1
+10.0.4.150 -1
+10.0.4.151 -1
+10.0.4.152 -1
+10.0.4.153 -1
+10.0.4.154 -1
+10.0.4.155 -1
+10.0.4.156 -1
+10.0.4.157 -1
+10.0.4.158 -1
+10.0.4.159 -1
+10.0.4.160 -1
+10.0.4.161 -1
+10.0.4.162 -1
+10.0.4.163 -1
+10.0.4.164 -1
+10.0.4.165 -1
+10.0.4.166 -1
+10.0.4.167 -1
+10.0.4.168 -1
+10.0.4.169 -1
+10.0.4.170 -1
+10.0.4.171 -1
+10.0.4.172 -1
+10.0.4.173 -1
+10.0.4.174 -1
+10.0.4.175 -1
+10.0.4.176 -1
+10.0.4.177 -1
+10.0.4.178 -1
+10.0.4.179 -1
+10.0.4.180 -1
+10.0.4.181 -1
+10.0.4.182 -1
+10.0.4.183 -1
+10.0.4.184 -1
+10.0.4.185 -1
+10.0.4.186 -1
+10.0.4.187 -1
+10.0.4.188 -1
+10.0.4.189 -1
+10.0.4.190 -1
+10.0.4.191 -1
+10.0.4.192 -1
+10.0.4.193 -1
+10.0.4.194 -1
+10.0.4.195 -1
+10.0.4.196 -1
+10.0.4.197 -1
+10.0.4.198 -1
+10.0.4.199 -1
+10.0.4.200 -1
+10.0.4.201 -1
+10.0.4.202 -1
+10.0.4.203 -1
+10.0.4.204 -1
+10.0.4.205 -1
+10.0.4.206 -1
+10.0.4.207 -1
+10.0.4.208 -1
+10.0.4.209 -1
+10.0.4.210 -1
+10.0.4.211 -1
+10.0.4.212 -1
+10.0.4.213 -1
+10.0.4.214 -1
+10.0.4.215 -1
+10.0.4.216 -1
+10.0.4.217 -1
+10.0.4.218 -1
+10.0.4.219 -1
+10.0.4.220 -1
+10.0.4.221 -1
+10.0.4.222 -1
+10.0.4.223 -1
+10.0.4.224 -1
+10.0.4.225 -1
+10.0.4.226 -1
+10.0.4.227 -1
+10.0.4.228 -1
+10.0.4.229 -1
+10.0.4.230 -1
+10.0.4.231 -1
+10.0.4.232 -1
+10.0.4.233 -1
+10.0.4.234 -1
+10.0.4.235 -1
+10.0.4.236 -1
+10.0.4.237 -1
+10.0.4.238 -1
+10.0.4.239 -1
+10.0.4.240 -1
+10.0.5.1 -1
+10.0.5.2 -1
+10.0.5.3 -1
+10.0.5.4 -1
+10.0.5.5 -1
+10.0.5.6 -1
+10.0.5.7 -1
+10.0.5.8 -1
+10.0.5.9 -1
+10.0.5.10 -1
+10.0.5.11 -1
+10.0.5.12 -1
+10.0.5.13 -1
+10.0.5.14 -1
+10.0.5.15 -1
+10.0.5.16 -1
+10.0.5.17 -1
+10.0.5.18 -1
+10.0.5.19 -1
+10.0.5.20 -1
+10.0.5.21 -1
+10.0.5.22 -1
+10.0.5.23 -1
+10.0.5.24 -1
+10.0.5.25 -1
+10.0.5.26 -1
+10.0.5.27 -1
+10.0.5.28 -1
+10.0.5.29 -1
+10.0.5.30 -1
+10.0.5.31 -1
+10.0.5.32 -1
+10.0.5.33 -1
+10.0.5.34 -1
+10.0.5.35 -1
+10.0.5.36 -1
+10.0.5.37 -1
+10.0.5.38 -1
+10.0.5.39 -1
+10.0.5.40 -1
+10.0.5.41 -1
+10.0.5.42 -1
+10.0.5.43 -1
+10.0.5.44 -1
+10.0.5.45 -1
+10.0.5.46 -1
+10.0.5.47 -1
+10.0.5.48 -1
+10.0.5.49 -1
+10.0.5.50 -1
+10.0.5.51 -1
+10.0.5.52 -1
+10.0.5.53 -1
+10.0.5.54 -1
+10.0.5.55 -1
+10.0.5.56 -1
+10.0.5.57 -1
+10.0.5.58 -1
+10.0.5.59 -1
+10.0.5.60 -1
+10.0.5.61 -1
+10.0.5.62 -1
+10.0.5.63 -1
+10.0.5.64 -1
+10.0.5.65 -1
+10.0.5.66 -1
+10.0.5.67 -1
+10.0.5.68 -1
+10.0.5.69 -1
+10.0.5.70 -1
+10.0.5.71 -1
+10.0.5.72 -1
+10.0.5.73 -1
+10.0.5.74 -1
+10.0.5.75 -1
+10.0.5.76 -1
+10.0.5.77 -1
+10.0.5.78 -1
+10.0.5.79 -1
+10.0.5.80 -1
+10.0.5.81 -1
+10.0.5.82 -1
+10.0.5.83 -1
+10.0.5.84 -1
+10.0.5.85 -1
+10.0.5.86 -1
+10.0.5.87 -1
+10.0.5.88 -1
+10.0.5.89 -1
+10.0.5.90 -1
+10.0.5.91 -1
+10.0.5.92 -1
+10.0.5.93 -1
+10.0.5.94 -1
+10.0.5.95 -1
+10.0.5.96 -1
+10.0.5.97 -1
+10.0.5.98 -1
+10.0.5.99 -1
+10.0.5.100 -1
+10.0.5.101 -1
+10.0.5.102 -1
+10.0.5.103 -1
+10.0.5.104 -1
+10.0.5.105 -1
+10.0.5.106 -1
+10.0.5.107 -1
+10.0.5.108 -1
+10.0.5.109 -1
+10.0.5.110 -1
+10.0.5.111 -1
+10.0.5.112 -1
+10.0.5.113 -1
+10.0.5.114 -1
+10.0.5.115 -1
+10.0.5.116 -1
+10.0.5.117 -1
+10.0.5.118 -1
+10.0.5.119 -1
+10.0.5.120 -1
+10.0.5.121 -1
+10.0.5.122 -1
+10.0.5.123 -1
+10.0.5.124 -1
+10.0.5.125 -1
+10.0.5.126 -1
+10.0.5.127 -1
+10.0.5.128 -1
+10.0.5.129 -1
+10.0.5.130 -1
+10.0.5.131 -1
+10.0.5.132 -1
+10.0.5.133 -1
+10.0.5.134 -1
+10.0.5.135 -1
+10.0.5.136 -1
+10.0.5.137 -1
+10.0.5.138 -1
+10.0.5.139 -1
+10.0.5.140 -1
+10.0.5.141 -1
+10.0.5.142 -1
+10.0.5.143 -1
+10.0.5.144 -1
+10.0.5.145 -1
+10.0.5.146 -1
+10.0.5.147 -1
+10.0.5.148 -1
+10.0.5.149 -1
+10.0.5.150 -1
+10.0.5.151 -1
+10.0.5.152 -1
+10.0.5.153 -1
+10.0.5.154 -1
+10.0.5.155 -1
+10.0.5.156 -1
+10.0.5.157 -1
+10.0.5.158 -1
+10.0.5.159 -1
+10.0.5.160 -1
+10.0.5.161 -1
+10.0.5.162 -1
+10.0.5.163 -1
+10.0.5.164 -1
+10.0.5.165 -1
+10.0.5.166 -1
+10.0.5.167 -1
+10.0.5.168 -1
+10.0.5.169 -1
+10.0.5.170 -1
+10.0.5.171 -1
+10.0.5.172 -1
+10.0.5.173 -1
+10.0.5.174 -1
+10.0.5.175 -1
+10.0.5.176 -1
+10.0.5.177 -1
+10.0.5.178 -1
+10.0.5.179 -1
+10.0.5.180 -1
+10.0.5.181 -1
+10.0.5.182 -1
+10.0.5.183 -1
+10.0.5.184 -1
+10.0.5.185 -1
+10.0.5.186 -1
+10.0.5.187 -1
+10.0.5.188 -1
+10.0.5.189 -1
+10.0.5.190 -1
+10.0.5.191 -1
+10.0.5.192 -1
+10.0.5.193 -1
+10.0.5.194 -1
+10.0.5.195 -1
+10.0.5.196 -1
+10.0.5.197 -1
+10.0.5.198 -1
+10.0.5.199 -1
+10.0.5.200 -1
+10.0.5.201 -1
+10.0.5.202 -1
+10.0.5.203 -1
+10.0.5.204 -1
+10.0.5.205 -1
+10.0.5.206 -1
+10.0.5.207 -1
+10.0.5.208 -1
+10.0.5.209 -1
+10.0.5.210 -1
+10.0.5.211 -1
+10.0.5.212 -1
+10.0.5.213 -1
+10.0.5.214 -1
+10.0.5.215 -1
+10.0.5.216 -1
+10.0.5.217 -1
+10.0.5.218 -1
+10.0.5.219 -1
+10.0.5.220 -1
+10.0.5.221 -1
+10.0.5.222 -1
+10.0.5.223 -1
+10.0.5.224 -1
+10.0.5.225 -1
+10.0.5.226 -1
+10.0.5.227 -1
+10.0.5.228 -1
+10.0.5.229 -1
+10.0.5.230 -1
+10.0.5.231 -1
+10.0.5.232 -1
+10.0.5.233 -1
+10.0.5.234 -1
+10.0.5.235 -1
+10.0.5.236 -1
+10.0.5.237 -1
+10.0.5.238 -1
+10.0.5.239 -1
+10.0.5.240 -1
+EOF
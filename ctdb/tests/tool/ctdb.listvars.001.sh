@@ -65,6 +65,8 @@ RecBufferSizeLimit         = 1000000
 QueueBufferSize            = 1024
 IPAllocAlgorithm           = 2
 AllowMixedVersions         = 0
+ConsistentLMaster          = 0
+TraverseWindow             = 4
 EOF
 
 simple_test
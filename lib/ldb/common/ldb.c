@@ -350,6 +350,7 @@ int ldb_error_at(struct ldb_context *ldb, int ecode,
 */
 int ldb_transaction_start(struct ldb_context *ldb)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_module *next_module;
 	int status;
 
@@ -371,7 +372,10 @@ int ldb_transaction_start(struct ldb_context *ldb)
 
 	ldb_reset_err_string(ldb);
 
+	ldb_module_timing_call_op(next_module, LDB_MODULE_TIMING_START_TRANS,
+				  &frame);
 	status = next_module->ops->start_transaction(next_module);
+	ldb_module_timing_leave(&frame);
 	if (status != LDB_SUCCESS) {
 		if (ldb->err_string == NULL) {
 			/* no error string was setup by the backend */
@@ -398,6 +402,7 @@ int ldb_transaction_start(struct ldb_context *ldb)
 */
 int ldb_transaction_prepare_commit(struct ldb_context *ldb)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_module *next_module;
 	int status;
 
@@ -425,13 +430,19 @@ int ldb_transaction_prepare_commit(struct ldb_context *ldb)
 		return LDB_SUCCESS;
 	}
 
+	ldb_module_timing_call_op(next_module,
+				  LDB_MODULE_TIMING_PREPARE_COMMIT, &frame);
 	status = next_module->ops->prepare_commit(next_module);
+	ldb_module_timing_leave(&frame);
 	if (status != LDB_SUCCESS) {
 		ldb->transaction_active--;
 		/* if a next_module fails the prepare then we need
 		   to call the end transaction for everyone */
 		FIRST_OP(ldb, del_transaction);
+		ldb_module_timing_call_op(next_module,
+					  LDB_MODULE_TIMING_DEL_TRANS, &frame);
 		next_module->ops->del_transaction(next_module);
+		ldb_module_timing_leave(&frame);
 		if (ldb->err_string == NULL) {
 			/* no error string was setup by the backend */
 			ldb_asprintf_errstring(ldb,
@@ -454,6 +465,7 @@ int ldb_transaction_prepare_commit(struct ldb_context *ldb)
 */
 int ldb_transaction_commit(struct ldb_context *ldb)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_module *next_module;
 	int status;
 
@@ -483,7 +495,10 @@ int ldb_transaction_commit(struct ldb_context *ldb)
 	ldb_reset_err_string(ldb);
 
 	FIRST_OP(ldb, end_transaction);
+	ldb_module_timing_call_op(next_module, LDB_MODULE_TIMING_END_TRANS,
+				  &frame);
 	status = next_module->ops->end_transaction(next_module);
+	ldb_module_timing_leave(&frame);
 	if (status != LDB_SUCCESS) {
 		if (ldb->err_string == NULL) {
 			/* no error string was setup by the backend */
@@ -498,7 +513,10 @@ int ldb_transaction_commit(struct ldb_context *ldb)
 		}
 		/* cancel the transaction */
 		FIRST_OP(ldb, del_transaction);
+		ldb_module_timing_call_op(next_module,
+					  LDB_MODULE_TIMING_DEL_TRANS, &frame);
 		next_module->ops->del_transaction(next_module);
+		ldb_module_timing_leave(&frame);
 	}
 	return status;
 }
@@ -509,6 +527,7 @@ int ldb_transaction_commit(struct ldb_context *ldb)
 */
 int ldb_transaction_cancel(struct ldb_context *ldb)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_module *next_module;
 	int status;
 
@@ -532,7 +551,10 @@ int ldb_transaction_cancel(struct ldb_context *ldb)
 
 	FIRST_OP(ldb, del_transaction);
 
+	ldb_module_timing_call_op(next_module, LDB_MODULE_TIMING_DEL_TRANS,
+				  &frame);
 	status = next_module->ops->del_transaction(next_module);
+	ldb_module_timing_leave(&frame);
 	if (status != LDB_SUCCESS) {
 		if (ldb->err_string == NULL) {
 			/* no error string was setup by the backend */
@@ -985,11 +1007,16 @@ struct ldb_db_lock_context {
  */
 static int ldb_db_lock_destructor(struct ldb_db_lock_context *lock_context)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 	struct ldb_module *next_module;
 	FIRST_OP_NOERR(lock_context->ldb, read_unlock);
 	if (next_module != NULL) {
+		ldb_module_timing_call_op(next_module,
+					  LDB_MODULE_TIMING_READ_UNLOCK,
+					  &frame);
 		ret = next_module->ops->read_unlock(next_module);
+		ldb_module_timing_leave(&frame);
 	} else {
 		ret = LDB_SUCCESS;
 	}
@@ -1054,6 +1081,7 @@ static int lock_search(struct ldb_module *lock_module, struct ldb_request *req)
 	struct ldb_request *down_req = NULL;
 	struct ldb_db_lock_context *lock_context;
 	struct ldb_context *ldb = ldb_module_get_ctx(lock_module);
+	struct ldb_module_timing_frame frame;
 	int ret;
 
 	lock_context = talloc(req, struct ldb_db_lock_context);
@@ -1081,7 +1109,10 @@ static int lock_search(struct ldb_module *lock_module, struct ldb_request *req)
 	/* call DB lock */
 	FIRST_OP_NOERR(ldb, read_lock);
 	if (next_module != NULL) {
+		ldb_module_timing_call_op(next_module,
+					  LDB_MODULE_TIMING_READ_LOCK, &frame);
 		ret = next_module->ops->read_lock(next_module);
+		ldb_module_timing_leave(&frame);
 	} else {
 		ret = LDB_ERR_UNSUPPORTED_CRITICAL_EXTENSION;
 	}
@@ -1115,6 +1146,7 @@ static int lock_search(struct ldb_module *lock_module, struct ldb_request *req)
 */
 int ldb_request(struct ldb_context *ldb, struct ldb_request *req)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_module *next_module;
 	int ret;
 
@@ -1129,6 +1161,9 @@ int ldb_request(struct ldb_context *ldb, struct ldb_request *req)
 		ldb_trace_request(ldb, req);
 	}
 
+	/* the callback is that of whoever is calling us */
+	ldb_request_timing_set_owner(req, NULL);
+
 	/* call the first module in the chain */
 	switch (req->operation) {
 	case LDB_SEARCH:
@@ -1184,7 +1219,9 @@ int ldb_request(struct ldb_context *ldb, struct ldb_request *req)
 			 */
 			return ret;
 		}
+		ldb_module_timing_call(next_module, req, &frame);
 		ret = next_module->ops->add(next_module, req);
+		ldb_module_timing_leave(&frame);
 		break;
 	case LDB_MODIFY:
 		if (!ldb_dn_validate(req->op.mod.message->dn)) {
@@ -1201,7 +1238,9 @@ int ldb_request(struct ldb_context *ldb, struct ldb_request *req)
 			 */
 			return ret;
 		}
+		ldb_module_timing_call(next_module, req, &frame);
 		ret = next_module->ops->modify(next_module, req);
+		ldb_module_timing_leave(&frame);
 		break;
 	case LDB_DELETE:
 		if (!ldb_dn_validate(req->op.del.dn)) {
@@ -1210,7 +1249,9 @@ int ldb_request(struct ldb_context *ldb, struct ldb_request *req)
 			return LDB_ERR_INVALID_DN_SYNTAX;
 		}
 		FIRST_OP(ldb, del);
+		ldb_module_timing_call(next_module, req, &frame);
 		ret = next_module->ops->del(next_module, req);
+		ldb_module_timing_leave(&frame);
 		break;
 	case LDB_RENAME:
 		if (!ldb_dn_validate(req->op.rename.olddn)) {
@@ -1224,15 +1265,21 @@ int ldb_request(struct ldb_context *ldb, struct ldb_request *req)
 			return LDB_ERR_INVALID_DN_SYNTAX;
 		}
 		FIRST_OP(ldb, rename);
+		ldb_module_timing_call(next_module, req, &frame);
 		ret = next_module->ops->rename(next_module, req);
+		ldb_module_timing_leave(&frame);
 		break;
 	case LDB_EXTENDED:
 		FIRST_OP(ldb, extended);
+		ldb_module_timing_call(next_module, req, &frame);
 		ret = next_module->ops->extended(next_module, req);
+		ldb_module_timing_leave(&frame);
 		break;
 	default:
 		FIRST_OP(ldb, request);
+		ldb_module_timing_call(next_module, req, &frame);
 		ret = next_module->ops->request(next_module, req);
+		ldb_module_timing_leave(&frame);
 		break;
 	}
 
@@ -76,6 +76,33 @@ static int ldb_match_scope(struct ldb_context *ldb,
 }
 
 
+/*
+  match if an element found in the message is present
+*/
+static int ldb_match_present_el(struct ldb_context *ldb,
+				const struct ldb_schema_attribute *a,
+				const struct ldb_message_element *el,
+				bool *matched)
+{
+	if (!a) {
+		return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
+	}
+
+	if (a->syntax->operator_fn) {
+		unsigned int i;
+		for (i = 0; i < el->num_values; i++) {
+			int ret = a->syntax->operator_fn(ldb, LDB_OP_PRESENT, a, &el->values[i], NULL, matched);
+			if (ret != LDB_SUCCESS) return ret;
+			if (*matched) return LDB_SUCCESS;
+		}
+		*matched = false;
+		return LDB_SUCCESS;
+	}
+
+	*matched = true;
+	return LDB_SUCCESS;
+}
+
 /*
   match if node is present
 */
@@ -99,22 +126,50 @@ static int ldb_match_present(struct ldb_context *ldb,
 	}
 
 	a = ldb_schema_attribute_by_name(ldb, el->name);
+
+	return ldb_match_present_el(ldb, a, el, matched);
+}
+
+/*
+  match a >= or <= comparison against an element found in the message
+*/
+static int ldb_match_comparison_el(struct ldb_context *ldb,
+				   const struct ldb_schema_attribute *a,
+				   const struct ldb_message_element *el,
+				   const struct ldb_val *value,
+				   enum ldb_parse_op comp_op, bool *matched)
+{
+	unsigned int i;
+
 	if (!a) {
 		return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
 	}
 
-	if (a->syntax->operator_fn) {
-		unsigned int i;
-		for (i = 0; i < el->num_values; i++) {
-			int ret = a->syntax->operator_fn(ldb, LDB_OP_PRESENT, a, &el->values[i], NULL, matched);
+	for (i = 0; i < el->num_values; i++) {
+		if (a->syntax->operator_fn) {
+			int ret;
+			ret = a->syntax->operator_fn(ldb, comp_op, a, &el->values[i], value, matched);
 			if (ret != LDB_SUCCESS) return ret;
 			if (*matched) return LDB_SUCCESS;
+		} else {
+			int ret = a->syntax->comparison_fn(ldb, ldb, &el->values[i], value);
+
+			if (ret == 0) {
+				*matched = true;
+				return LDB_SUCCESS;
+			}
+			if (ret > 0 && comp_op == LDB_OP_GREATER) {
+				*matched = true;
+				return LDB_SUCCESS;
+			}
+			if (ret < 0 && comp_op == LDB_OP_LESS) {
+				*matched = true;
+				return LDB_SUCCESS;
+			}
 		}
-		*matched = false;
-		return LDB_SUCCESS;
 	}
 
-	*matched = true;
+	*matched = false;
 	return LDB_SUCCESS;
 }
 
@@ -124,7 +179,6 @@ static int ldb_match_comparison(struct ldb_context *ldb,
 				enum ldb_scope scope,
 				enum ldb_parse_op comp_op, bool *matched)
 {
-	unsigned int i;
 	struct ldb_message_element *el;
 	const struct ldb_schema_attribute *a;
 
@@ -140,28 +194,36 @@ static int ldb_match_comparison(struct ldb_context *ldb,
 	}
 
 	a = ldb_schema_attribute_by_name(ldb, el->name);
-	if (!a) {
+
+	return ldb_match_comparison_el(ldb, a, el, &tree->u.comparison.value,
+				       comp_op, matched);
+}
+
+/*
+  match an equality filter against an element found in the message
+*/
+static int ldb_match_equality_el(struct ldb_context *ldb,
+				 const struct ldb_schema_attribute *a,
+				 const struct ldb_message_element *el,
+				 const struct ldb_val *value,
+				 bool *matched)
+{
+	unsigned int i;
+	int ret;
+
+	if (a == NULL) {
 		return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
 	}
 
-	for (i = 0; i < el->num_values; i++) {
+	for (i=0;i<el->num_values;i++) {
 		if (a->syntax->operator_fn) {
-			int ret;
-			ret = a->syntax->operator_fn(ldb, comp_op, a, &el->values[i], &tree->u.comparison.value, matched);
+			ret = a->syntax->operator_fn(ldb, LDB_OP_EQUALITY, a,
+						     value, &el->values[i], matched);
 			if (ret != LDB_SUCCESS) return ret;
 			if (*matched) return LDB_SUCCESS;
 		} else {
-			int ret = a->syntax->comparison_fn(ldb, ldb, &el->values[i], &tree->u.comparison.value);
-
-			if (ret == 0) {
-				*matched = true;
-				return LDB_SUCCESS;
-			}
-			if (ret > 0 && comp_op == LDB_OP_GREATER) {
-				*matched = true;
-				return LDB_SUCCESS;
-			}
-			if (ret < 0 && comp_op == LDB_OP_LESS) {
+			if (a->syntax->comparison_fn(ldb, ldb, value,
+						     &el->values[i]) == 0) {
 				*matched = true;
 				return LDB_SUCCESS;
 			}
@@ -181,7 +243,6 @@ static int ldb_match_equality(struct ldb_context *ldb,
 			      enum ldb_scope scope,
 			      bool *matched)
 {
-	unsigned int i;
 	struct ldb_message_element *el;
 	const struct ldb_schema_attribute *a;
 	struct ldb_dn *valuedn;
@@ -210,117 +271,133 @@ static int ldb_match_equality(struct ldb_context *ldb,
 	}
 
 	a = ldb_schema_attribute_by_name(ldb, el->name);
-	if (a == NULL) {
-		return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
+
+	return ldb_match_equality_el(ldb, a, el, &tree->u.equality.value,
+				     matched);
+}
+
+/*
+  canonicalise the chunks of a substring filter once, rather than for
+  each value compared.  *never is set if a chunk can not match anything
+*/
+static int ldb_wildcard_chunks(struct ldb_context *ldb,
+			       TALLOC_CTX *mem_ctx,
+			       const struct ldb_schema_attribute *a,
+			       const struct ldb_parse_tree *tree,
+			       struct ldb_val **_chunks,
+			       bool *never)
+{
+	struct ldb_val *chunks;
+	unsigned int c;
+
+	*_chunks = NULL;
+	*never = false;
+
+	if (tree->u.substring.chunks == NULL) {
+		*never = true;
+		return LDB_SUCCESS;
 	}
 
-	for (i=0;i<el->num_values;i++) {
-		if (a->syntax->operator_fn) {
-			ret = a->syntax->operator_fn(ldb, LDB_OP_EQUALITY, a,
-						     &tree->u.equality.value, &el->values[i], matched);
-			if (ret != LDB_SUCCESS) return ret;
-			if (*matched) return LDB_SUCCESS;
-		} else {
-			if (a->syntax->comparison_fn(ldb, ldb, &tree->u.equality.value,
-						     &el->values[i]) == 0) {
-				*matched = true;
-				return LDB_SUCCESS;
-			}
+	for (c = 0; tree->u.substring.chunks[c]; c++) /* noop */ ;
+	if (c == 0) {
+		*never = true;
+		return LDB_SUCCESS;
+	}
+
+	chunks = talloc_array(mem_ctx, struct ldb_val, c + 1);
+	if (chunks == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	for (c = 0; tree->u.substring.chunks[c]; c++) {
+		if (a->syntax->canonicalise_fn(ldb, chunks,
+					       tree->u.substring.chunks[c],
+					       &chunks[c]) != 0) {
+			*never = true;
+			break;
+		}
+		/*
+		 * Empty strings are returned as length 0. Ensure
+		 * we can cope with this.
+		 */
+		if (chunks[c].length == 0) {
+			*never = true;
+			break;
 		}
 	}
+	chunks[c].data = NULL;
+	chunks[c].length = 0;
 
-	*matched = false;
+	*_chunks = chunks;
 	return LDB_SUCCESS;
 }
 
+/*
+  match a value against the chunks of a substring filter, canonicalised
+  by ldb_wildcard_chunks()
+*/
 static int ldb_wildcard_compare(struct ldb_context *ldb,
+				const struct ldb_schema_attribute *a,
 				const struct ldb_parse_tree *tree,
+				const struct ldb_val *chunks,
+				bool never,
 				const struct ldb_val value, bool *matched)
 {
-	const struct ldb_schema_attribute *a;
 	struct ldb_val val;
-	struct ldb_val cnk;
-	struct ldb_val *chunk;
+	const struct ldb_val *cnk;
 	uint8_t *save_p = NULL;
 	unsigned int c = 0;
 
-	a = ldb_schema_attribute_by_name(ldb, tree->u.substring.attr);
-	if (!a) {
-		return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
-	}
-
-	if (tree->u.substring.chunks == NULL) {
-		*matched = false;
-		return LDB_SUCCESS;
-	}
-
 	if (a->syntax->canonicalise_fn(ldb, ldb, &value, &val) != 0) {
 		return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
 	}
 
 	save_p = val.data;
-	cnk.data = NULL;
+
+	if (never) {
+		goto mismatch;
+	}
 
 	if ( ! tree->u.substring.start_with_wildcard ) {
 
-		chunk = tree->u.substring.chunks[c];
-		if (a->syntax->canonicalise_fn(ldb, ldb, chunk, &cnk) != 0) goto mismatch;
+		cnk = &chunks[c];
 
 		/* This deals with wildcard prefix searches on binary attributes (eg objectGUID) */
-		if (cnk.length > val.length) {
-			goto mismatch;
-		}
-		/*
-		 * Empty strings are returned as length 0. Ensure
-		 * we can cope with this.
-		 */
-		if (cnk.length == 0) {
+		if (cnk->length > val.length) {
 			goto mismatch;
 		}
 
-		if (memcmp((char *)val.data, (char *)cnk.data, cnk.length) != 0) goto mismatch;
-		val.length -= cnk.length;
-		val.data += cnk.length;
+		if (memcmp((char *)val.data, (char *)cnk->data, cnk->length) != 0) goto mismatch;
+		val.length -= cnk->length;
+		val.data += cnk->length;
 		c++;
-		talloc_free(cnk.data);
-		cnk.data = NULL;
 	}
 
-	while (tree->u.substring.chunks[c]) {
+	while (chunks[c].data != NULL) {
 		uint8_t *p;
 
-		chunk = tree->u.substring.chunks[c];
-		if(a->syntax->canonicalise_fn(ldb, ldb, chunk, &cnk) != 0) goto mismatch;
+		cnk = &chunks[c];
 
-		/*
-		 * Empty strings are returned as length 0. Ensure
-		 * we can cope with this.
-		 */
-		if (cnk.length == 0) {
-			goto mismatch;
-		}
 		/*
 		 * Values might be binary blobs. Don't use string
 		 * search, but memory search instead.
 		 */
 		p = memmem((const void *)val.data,val.length,
-			   (const void *)cnk.data, cnk.length);
+			   (const void *)cnk->data, cnk->length);
 		if (p == NULL) goto mismatch;
-		if ( (! tree->u.substring.chunks[c + 1]) && (! tree->u.substring.end_with_wildcard) ) {
+		if ( (chunks[c + 1].data == NULL) && (! tree->u.substring.end_with_wildcard) ) {
 			uint8_t *g;
 			do { /* greedy */
-				g = memmem(p + cnk.length,
+				g = memmem(p + cnk->length,
 					val.length - (p - val.data),
-					(const uint8_t *)cnk.data,
-					cnk.length);
+					(const uint8_t *)cnk->data,
+					cnk->length);
 				if (g) p = g;
 			} while(g);
 		}
-		val.length = val.length - (p - (uint8_t *)(val.data)) - cnk.length;
-		val.data = (uint8_t *)(p + cnk.length);
+		val.length = val.length - (p - (uint8_t *)(val.data)) - cnk->length;
+		val.data = (uint8_t *)(p + cnk->length);
 		c++;
-		talloc_free(cnk.data);
-		cnk.data = NULL;
 	}
 
 	/* last chunk may not have reached end of string */
@@ -332,7 +409,6 @@ static int ldb_wildcard_compare(struct ldb_context *ldb,
 mismatch:
 	*matched = false;
 	talloc_free(save_p);
-	talloc_free(cnk.data);
 	return LDB_SUCCESS;
 }
 
@@ -346,22 +422,36 @@ static int ldb_match_substring(struct ldb_context *ldb,
 {
 	unsigned int i;
 	struct ldb_message_element *el;
+	const struct ldb_schema_attribute *a;
+	struct ldb_val *chunks = NULL;
+	bool never;
+	int ret;
 
 	el = ldb_msg_find_element(msg, tree->u.substring.attr);
-	if (el == NULL) {
+	if (el == NULL || el->num_values == 0) {
 		*matched = false;
 		return LDB_SUCCESS;
 	}
 
+	a = ldb_schema_attribute_by_name(ldb, tree->u.substring.attr);
+	if (!a) {
+		return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
+	}
+
+	ret = ldb_wildcard_chunks(ldb, ldb, a, tree, &chunks, &never);
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
 	for (i = 0; i < el->num_values; i++) {
-		int ret;
-		ret = ldb_wildcard_compare(ldb, tree, el->values[i], matched);
-		if (ret != LDB_SUCCESS) return ret;
-		if (*matched) return LDB_SUCCESS;
+		ret = ldb_wildcard_compare(ldb, a, tree, chunks, never,
+					   el->values[i], matched);
+		if (ret != LDB_SUCCESS) break;
+		if (*matched) break;
 	}
 
-	*matched = false;
-	return LDB_SUCCESS;
+	talloc_free(chunks);
+	return ret;
 }
 
 
@@ -632,6 +722,315 @@ int ldb_match_msg_error(struct ldb_context *ldb,
 	return ldb_match_message(ldb, msg, tree, scope, matched);
 }
 
+/*
+  A search filter compiled by ldb_match_compile().  The parse tree is
+  flattened into an array of nodes in prefix order, each holding the
+  index of the node after its subtree.  ldb_match_compiled_node()
+  still recurses into the children of AND, OR and NOT, but steps from
+  one child to the next through that index rather than the parse tree.
+
+  The work that only depends on the filter is done once: the attribute
+  handlers are looked up, the DN of a (dn=...) filter is parsed and
+  the chunks of a substring filter are canonicalised.
+*/
+struct ldb_match_node {
+	enum ldb_parse_op operation;
+	const struct ldb_parse_tree *tree;
+
+	/* the node after this one and all its children */
+	unsigned int next;
+
+	/* the attribute is "dn" or "distinguishedName" */
+	bool is_dn;
+	const struct ldb_schema_attribute *a;
+
+	/* LDB_OP_EQUALITY on the DN */
+	struct ldb_dn *value_dn;
+
+	/* LDB_OP_SUBSTRING */
+	struct ldb_val *chunks;
+	bool never;
+};
+
+struct ldb_match_program {
+	unsigned int num_nodes;
+	struct ldb_match_node *nodes;
+};
+
+static unsigned int ldb_match_count_nodes(const struct ldb_parse_tree *tree)
+{
+	unsigned int i, count = 1;
+
+	switch (tree->operation) {
+	case LDB_OP_AND:
+	case LDB_OP_OR:
+		for (i = 0; i < tree->u.list.num_elements; i++) {
+			count += ldb_match_count_nodes(tree->u.list.elements[i]);
+		}
+		break;
+	case LDB_OP_NOT:
+		count += ldb_match_count_nodes(tree->u.isnot.child);
+		break;
+	default:
+		break;
+	}
+	return count;
+}
+
+static int ldb_match_compile_node(struct ldb_context *ldb,
+				  struct ldb_match_program *program,
+				  const struct ldb_parse_tree *tree,
+				  unsigned int *idx)
+{
+	struct ldb_match_node *node = &program->nodes[*idx];
+	unsigned int i;
+	int ret;
+
+	node->operation = tree->operation;
+	node->tree = tree;
+	(*idx)++;
+
+	switch (tree->operation) {
+	case LDB_OP_AND:
+	case LDB_OP_OR:
+		for (i = 0; i < tree->u.list.num_elements; i++) {
+			ret = ldb_match_compile_node(ldb, program,
+						     tree->u.list.elements[i],
+						     idx);
+			if (ret != LDB_SUCCESS) {
+				return ret;
+			}
+		}
+		break;
+
+	case LDB_OP_NOT:
+		ret = ldb_match_compile_node(ldb, program,
+					     tree->u.isnot.child, idx);
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
+		break;
+
+	case LDB_OP_EQUALITY:
+		if (ldb_attr_dn(tree->u.equality.attr) == 0) {
+			node->is_dn = true;
+			/* NULL is reported as LDB_ERR_INVALID_DN_SYNTAX */
+			node->value_dn = ldb_dn_from_ldb_val(program, ldb,
+							     &tree->u.equality.value);
+			break;
+		}
+		node->a = ldb_schema_attribute_by_name(ldb,
+						       tree->u.equality.attr);
+		break;
+
+	case LDB_OP_GREATER:
+	case LDB_OP_LESS:
+	case LDB_OP_APPROX:
+		node->a = ldb_schema_attribute_by_name(ldb,
+						       tree->u.comparison.attr);
+		break;
+
+	case LDB_OP_PRESENT:
+		node->is_dn = (ldb_attr_dn(tree->u.present.attr) == 0);
+		node->a = ldb_schema_attribute_by_name(ldb,
+						       tree->u.present.attr);
+		break;
+
+	case LDB_OP_SUBSTRING:
+		node->a = ldb_schema_attribute_by_name(ldb,
+						       tree->u.substring.attr);
+		if (node->a == NULL) {
+			break;
+		}
+		ret = ldb_wildcard_chunks(ldb, program, node->a, tree,
+					  &node->chunks, &node->never);
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
+		break;
+
+	case LDB_OP_EXTENDED:
+		break;
+	}
+
+	node->next = *idx;
+	return LDB_SUCCESS;
+}
+
+/*
+  compile a search filter for ldb_match_compiled_msg_error(), which
+  gives the same result as ldb_match_msg_error() on the tree.
+
+  The program refers to the tree and to the attribute handlers, so
+  must not be used once the tree is freed or the schema changes.
+*/
+int ldb_match_compile(struct ldb_context *ldb,
+		      TALLOC_CTX *mem_ctx,
+		      const struct ldb_parse_tree *tree,
+		      struct ldb_match_program **_program)
+{
+	struct ldb_match_program *program;
+	unsigned int idx = 0;
+	int ret;
+
+	program = talloc_zero(mem_ctx, struct ldb_match_program);
+	if (program == NULL) {
+		return ldb_oom(ldb);
+	}
+
+	program->num_nodes = ldb_match_count_nodes(tree);
+	program->nodes = talloc_zero_array(program, struct ldb_match_node,
+					   program->num_nodes);
+	if (program->nodes == NULL) {
+		talloc_free(program);
+		return ldb_oom(ldb);
+	}
+
+	ret = ldb_match_compile_node(ldb, program, tree, &idx);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(program);
+		return ret;
+	}
+
+	*_program = program;
+	return LDB_SUCCESS;
+}
+
+static int ldb_match_compiled_node(struct ldb_context *ldb,
+				   const struct ldb_match_program *program,
+				   unsigned int idx,
+				   const struct ldb_message *msg,
+				   enum ldb_scope scope, bool *matched)
+{
+	const struct ldb_match_node *node = &program->nodes[idx];
+	const struct ldb_parse_tree *tree = node->tree;
+	struct ldb_message_element *el;
+	unsigned int i;
+	int ret;
+
+	switch (node->operation) {
+	case LDB_OP_AND:
+		for (i = idx + 1; i < node->next; i = program->nodes[i].next) {
+			ret = ldb_match_compiled_node(ldb, program, i, msg,
+						      scope, matched);
+			if (ret != LDB_SUCCESS) return ret;
+			if (!*matched) return LDB_SUCCESS;
+		}
+		*matched = true;
+		return LDB_SUCCESS;
+
+	case LDB_OP_OR:
+		for (i = idx + 1; i < node->next; i = program->nodes[i].next) {
+			ret = ldb_match_compiled_node(ldb, program, i, msg,
+						      scope, matched);
+			if (ret != LDB_SUCCESS) return ret;
+			if (*matched) return LDB_SUCCESS;
+		}
+		*matched = false;
+		return LDB_SUCCESS;
+
+	case LDB_OP_NOT:
+		ret = ldb_match_compiled_node(ldb, program, idx + 1, msg,
+					      scope, matched);
+		if (ret != LDB_SUCCESS) return ret;
+		*matched = ! *matched;
+		return LDB_SUCCESS;
+
+	case LDB_OP_EQUALITY:
+		if (node->is_dn) {
+			if (node->value_dn == NULL) {
+				return LDB_ERR_INVALID_DN_SYNTAX;
+			}
+			*matched = (ldb_dn_compare(msg->dn, node->value_dn) == 0);
+			return LDB_SUCCESS;
+		}
+		el = ldb_msg_find_element(msg, tree->u.equality.attr);
+		if (el == NULL) {
+			*matched = false;
+			return LDB_SUCCESS;
+		}
+		return ldb_match_equality_el(ldb, node->a, el,
+					     &tree->u.equality.value,
+					     matched);
+
+	case LDB_OP_SUBSTRING:
+		el = ldb_msg_find_element(msg, tree->u.substring.attr);
+		if (el == NULL) {
+			*matched = false;
+			return LDB_SUCCESS;
+		}
+		for (i = 0; i < el->num_values; i++) {
+			if (node->a == NULL) {
+				return LDB_ERR_INVALID_ATTRIBUTE_SYNTAX;
+			}
+			ret = ldb_wildcard_compare(ldb, node->a, tree,
+						   node->chunks, node->never,
+						   el->values[i], matched);
+			if (ret != LDB_SUCCESS) return ret;
+			if (*matched) return LDB_SUCCESS;
+		}
+		*matched = false;
+		return LDB_SUCCESS;
+
+	case LDB_OP_GREATER:
+	case LDB_OP_LESS:
+		el = ldb_msg_find_element(msg, tree->u.comparison.attr);
+		if (el == NULL) {
+			*matched = false;
+			return LDB_SUCCESS;
+		}
+		return ldb_match_comparison_el(ldb, node->a, el,
+					       &tree->u.comparison.value,
+					       node->operation, matched);
+
+	case LDB_OP_PRESENT:
+		if (node->is_dn) {
+			*matched = true;
+			return LDB_SUCCESS;
+		}
+		el = ldb_msg_find_element(msg, tree->u.present.attr);
+		if (el == NULL) {
+			*matched = false;
+			return LDB_SUCCESS;
+		}
+		return ldb_match_present_el(ldb, node->a, el, matched);
+
+	case LDB_OP_APPROX:
+		return ldb_match_comparison(ldb, msg, tree, scope,
+					    LDB_OP_APPROX, matched);
+
+	case LDB_OP_EXTENDED:
+		return ldb_match_extended(ldb, msg, tree, scope, matched);
+	}
+
+	return LDB_ERR_INAPPROPRIATE_MATCHING;
+}
+
+/*
+  the compiled equivalent of ldb_match_msg_error()
+*/
+int ldb_match_compiled_msg_error(struct ldb_context *ldb,
+				 const struct ldb_message *msg,
+				 const struct ldb_match_program *program,
+				 struct ldb_dn *base,
+				 enum ldb_scope scope,
+				 bool *matched)
+{
+	if ( ! ldb_match_scope(ldb, base, msg->dn, scope) ) {
+		*matched = false;
+		return LDB_SUCCESS;
+	}
+
+	*matched = false;
+
+	if (scope != LDB_SCOPE_BASE && ldb_dn_is_special(msg->dn)) {
+		/* don't match special records except on base searches */
+		return LDB_SUCCESS;
+	}
+
+	return ldb_match_compiled_node(ldb, program, 0, msg, scope, matched);
+}
+
 int ldb_match_msg_objectclass(const struct ldb_message *msg,
 			      const char *objectclass)
 {
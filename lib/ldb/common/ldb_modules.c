@@ -302,6 +302,287 @@ int ldb_register_module(const struct ldb_module_ops *ops)
 	return LDB_SUCCESS;
 }
 
+/*
+  per-module timing
+
+  The counters of a module are found by name when the module is set
+  up, and are never freed, so a frame can hold on to them.
+*/
+struct ldb_module_timing {
+	struct ldb_module_timing *next;
+	const char *name;
+	struct {
+		uint64_t calls;
+		uint64_t nsec;
+	} ops[LDB_MODULE_TIMING_NUM_OPS];
+};
+
+static const char * const ldb_module_timing_op_names[LDB_MODULE_TIMING_NUM_OPS] = {
+	[LDB_MODULE_TIMING_SEARCH] = "search",
+	[LDB_MODULE_TIMING_ADD] = "add",
+	[LDB_MODULE_TIMING_MODIFY] = "modify",
+	[LDB_MODULE_TIMING_DELETE] = "delete",
+	[LDB_MODULE_TIMING_RENAME] = "rename",
+	[LDB_MODULE_TIMING_EXTENDED] = "extended",
+	[LDB_MODULE_TIMING_REQUEST] = "request",
+	[LDB_MODULE_TIMING_START_TRANS] = "start_transaction",
+	[LDB_MODULE_TIMING_PREPARE_COMMIT] = "prepare_commit",
+	[LDB_MODULE_TIMING_END_TRANS] = "end_transaction",
+	[LDB_MODULE_TIMING_DEL_TRANS] = "del_transaction",
+	[LDB_MODULE_TIMING_READ_LOCK] = "read_lock",
+	[LDB_MODULE_TIMING_READ_UNLOCK] = "read_unlock",
+};
+
+static struct {
+	bool enabled;
+	/* bumped by every enable, so older frames are ignored */
+	uint64_t generation;
+	struct ldb_module_timing *modules;
+	/* who is running now, and since when */
+	struct ldb_module_timing *current;
+	unsigned int op;
+	struct timespec since;
+} ldb_timing;
+
+static struct ldb_module_timing *ldb_module_timing_find(const char *name)
+{
+	struct ldb_module_timing *t;
+
+	for (t = ldb_timing.modules; t != NULL; t = t->next) {
+		if (strcmp(t->name, name) == 0) {
+			return t;
+		}
+	}
+
+	/*
+	 * Like the registered modules, this is never freed, as frames
+	 * and modules in any ldb context may point to it
+	 */
+	t = talloc_zero(NULL, struct ldb_module_timing);
+	if (t == NULL) {
+		return NULL;
+	}
+	t->name = talloc_strdup(t, name);
+	if (t->name == NULL) {
+		talloc_free(t);
+		return NULL;
+	}
+	t->next = ldb_timing.modules;
+	ldb_timing.modules = t;
+
+	return t;
+}
+
+static enum ldb_module_timing_op ldb_module_timing_req_op(struct ldb_request *req)
+{
+	switch (req->operation) {
+	case LDB_SEARCH:
+		return LDB_MODULE_TIMING_SEARCH;
+	case LDB_ADD:
+		return LDB_MODULE_TIMING_ADD;
+	case LDB_MODIFY:
+		return LDB_MODULE_TIMING_MODIFY;
+	case LDB_DELETE:
+		return LDB_MODULE_TIMING_DELETE;
+	case LDB_RENAME:
+		return LDB_MODULE_TIMING_RENAME;
+	case LDB_EXTENDED:
+		return LDB_MODULE_TIMING_EXTENDED;
+	default:
+		return LDB_MODULE_TIMING_REQUEST;
+	}
+}
+
+/*
+  charge the time since the last switch to whoever was running, and
+  make timing and op the running ones
+*/
+static void ldb_module_timing_switch(struct ldb_module_timing *timing,
+				     unsigned int op,
+				     struct ldb_module_timing_frame *frame)
+{
+	struct timespec now;
+
+	clock_gettime(CUSTOM_CLOCK_MONOTONIC, &now);
+
+	if (ldb_timing.current != NULL) {
+		int64_t nsec;
+
+		nsec = (int64_t)(now.tv_sec - ldb_timing.since.tv_sec)
+			* 1000000000 + (now.tv_nsec - ldb_timing.since.tv_nsec);
+		if (nsec > 0) {
+			ldb_timing.current->ops[ldb_timing.op].nsec += nsec;
+		}
+	}
+	ldb_timing.since = now;
+
+	if (frame != NULL) {
+		frame->timing = ldb_timing.current;
+		frame->op = ldb_timing.op;
+		frame->generation = ldb_timing.generation;
+	}
+	ldb_timing.current = timing;
+	ldb_timing.op = op;
+}
+
+void ldb_module_timing_enable(bool enable)
+{
+	if (enable == ldb_timing.enabled) {
+		return;
+	}
+	if (enable) {
+		ldb_timing.generation++;
+		ldb_timing.current = NULL;
+		clock_gettime(CUSTOM_CLOCK_MONOTONIC, &ldb_timing.since);
+	}
+	ldb_timing.enabled = enable;
+}
+
+bool ldb_module_timing_enabled(void)
+{
+	return ldb_timing.enabled;
+}
+
+void ldb_module_timing_reset(void)
+{
+	struct ldb_module_timing *t;
+
+	for (t = ldb_timing.modules; t != NULL; t = t->next) {
+		memset(t->ops, 0, sizeof(t->ops));
+	}
+	clock_gettime(CUSTOM_CLOCK_MONOTONIC, &ldb_timing.since);
+}
+
+const char **ldb_module_timing_report(TALLOC_CTX *mem_ctx)
+{
+	struct ldb_module_timing *t;
+	const char **report;
+	size_t n = 0;
+
+	if (ldb_timing.enabled) {
+		/* include the time of whoever is running now */
+		ldb_module_timing_switch(ldb_timing.current, ldb_timing.op,
+					 NULL);
+	}
+
+	report = talloc_array(mem_ctx, const char *, 1);
+	if (report == NULL) {
+		return NULL;
+	}
+
+	for (t = ldb_timing.modules; t != NULL; t = t->next) {
+		unsigned int op;
+
+		for (op = 0; op < LDB_MODULE_TIMING_NUM_OPS; op++) {
+			const char **tmp;
+
+			if (t->ops[op].calls == 0 && t->ops[op].nsec == 0) {
+				continue;
+			}
+			tmp = talloc_realloc(mem_ctx, report, const char *,
+					     n + 2);
+			if (tmp == NULL) {
+				talloc_free(report);
+				return NULL;
+			}
+			report = tmp;
+			report[n] = talloc_asprintf(report,
+						    "%s %s %llu %llu",
+						    t->name,
+						    ldb_module_timing_op_names[op],
+						    (unsigned long long)t->ops[op].calls,
+						    (unsigned long long)(t->ops[op].nsec / 1000));
+			if (report[n] == NULL) {
+				talloc_free(report);
+				return NULL;
+			}
+			n++;
+		}
+	}
+	report[n] = NULL;
+
+	return report;
+}
+
+void ldb_module_timing_enter(struct ldb_module *module,
+			     struct ldb_request *req,
+			     struct ldb_module_timing_frame *frame)
+{
+	frame->generation = 0;
+	if (!ldb_timing.enabled) {
+		return;
+	}
+	ldb_module_timing_switch(module->timing,
+				 ldb_module_timing_req_op(req),
+				 frame);
+}
+
+void ldb_module_timing_enter_callback(struct ldb_request *req,
+				      struct ldb_module_timing_frame *frame)
+{
+	frame->generation = 0;
+	if (!ldb_timing.enabled) {
+		return;
+	}
+	ldb_module_timing_switch(req->handle->timing_owner,
+				 ldb_module_timing_req_op(req),
+				 frame);
+}
+
+void ldb_module_timing_leave(struct ldb_module_timing_frame *frame)
+{
+	/*
+	 * Nothing to go back to if timing was disabled (and maybe
+	 * enabled again) since the frame was entered
+	 */
+	if (!ldb_timing.enabled ||
+	    frame->generation != ldb_timing.generation) {
+		return;
+	}
+	ldb_module_timing_switch(frame->timing, frame->op, NULL);
+}
+
+void ldb_module_timing_call_op(struct ldb_module *module,
+			       enum ldb_module_timing_op op,
+			       struct ldb_module_timing_frame *frame)
+{
+	frame->generation = 0;
+	if (!ldb_timing.enabled) {
+		return;
+	}
+	if (module->timing != NULL) {
+		module->timing->ops[op].calls++;
+	}
+	ldb_module_timing_switch(module->timing, op, frame);
+}
+
+void ldb_module_timing_call(struct ldb_module *module,
+			    struct ldb_request *req,
+			    struct ldb_module_timing_frame *frame)
+{
+	ldb_module_timing_call_op(module, ldb_module_timing_req_op(req), frame);
+}
+
+/*
+  remember the module whose callback a request calls, the first time
+  the request is passed on.  A NULL module, or one without counters
+  like those partition and ldb_request() use to reach the next
+  module, stands for whoever is running now.
+*/
+void ldb_request_timing_set_owner(struct ldb_request *req,
+				  struct ldb_module *module)
+{
+	if (req->handle->timing_owner_set) {
+		return;
+	}
+	if (module != NULL && module->timing != NULL) {
+		req->handle->timing_owner = module->timing;
+	} else if (ldb_timing.enabled) {
+		req->handle->timing_owner = ldb_timing.current;
+	}
+	req->handle->timing_owner_set = true;
+}
+
 /*
   load a list of modules
  */
@@ -337,6 +618,7 @@ int ldb_module_load_list(struct ldb_context *ldb, const char **module_list,
 
 		current->ldb = ldb;
 		current->ops = ops;
+		current->timing = ldb_module_timing_find(ops->name);
 
 		DLIST_ADD(module, current);
 	}
@@ -483,6 +765,11 @@ struct ldb_module *ldb_module_new(TALLOC_CTX *memctx,
 	module->ldb = ldb;
 	module->prev = module->next = NULL;
 	module->ops = ops;
+	/* partition makes modules without ops to reach its backends */
+	module->timing = NULL;
+	if (ops != NULL) {
+		module->timing = ldb_module_timing_find(ops->name);
+	}
 
 	return module;
 }
@@ -518,6 +805,7 @@ void ldb_module_set_private(struct ldb_module *module, void *private_data)
 
 int ldb_next_request(struct ldb_module *module, struct ldb_request *request)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 
 	if (request->callback == NULL) {
@@ -525,39 +813,50 @@ int ldb_next_request(struct ldb_module *module, struct ldb_request *request)
 		return LDB_ERR_UNWILLING_TO_PERFORM;
 	}
 
+	ldb_request_timing_set_owner(request, module);
+
 	request->handle->nesting++;
 
 	switch (request->operation) {
 	case LDB_SEARCH:
 		FIND_OP(module, search);
+		ldb_module_timing_call(module, request, &frame);
 		ret = module->ops->search(module, request);
 		break;
 	case LDB_ADD:
 		FIND_OP(module, add);
+		ldb_module_timing_call(module, request, &frame);
 		ret = module->ops->add(module, request);
 		break;
 	case LDB_MODIFY:
 		FIND_OP(module, modify);
+		ldb_module_timing_call(module, request, &frame);
 		ret = module->ops->modify(module, request);
 		break;
 	case LDB_DELETE:
 		FIND_OP(module, del);
+		ldb_module_timing_call(module, request, &frame);
 		ret = module->ops->del(module, request);
 		break;
 	case LDB_RENAME:
 		FIND_OP(module, rename);
+		ldb_module_timing_call(module, request, &frame);
 		ret = module->ops->rename(module, request);
 		break;
 	case LDB_EXTENDED:
 		FIND_OP(module, extended);
+		ldb_module_timing_call(module, request, &frame);
 		ret = module->ops->extended(module, request);
 		break;
 	default:
 		FIND_OP(module, request);
+		ldb_module_timing_call(module, request, &frame);
 		ret = module->ops->request(module, request);
 		break;
 	}
 
+	ldb_module_timing_leave(&frame);
+
 	request->handle->nesting--;
 
 	if (ret == LDB_SUCCESS) {
@@ -615,9 +914,12 @@ int ldb_next_init(struct ldb_module *module)
 
 int ldb_next_start_trans(struct ldb_module *module)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 	FIND_OP(module, start_transaction);
+	ldb_module_timing_call_op(module, LDB_MODULE_TIMING_START_TRANS, &frame);
 	ret = module->ops->start_transaction(module);
+	ldb_module_timing_leave(&frame);
 	if (ret == LDB_SUCCESS) {
 		return ret;
 	}
@@ -634,9 +936,12 @@ int ldb_next_start_trans(struct ldb_module *module)
 
 int ldb_next_end_trans(struct ldb_module *module)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 	FIND_OP(module, end_transaction);
+	ldb_module_timing_call_op(module, LDB_MODULE_TIMING_END_TRANS, &frame);
 	ret = module->ops->end_transaction(module);
+	ldb_module_timing_leave(&frame);
 	if (ret == LDB_SUCCESS) {
 		return ret;
 	}
@@ -653,9 +958,12 @@ int ldb_next_end_trans(struct ldb_module *module)
 
 int ldb_next_read_lock(struct ldb_module *module)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 	FIND_OP(module, read_lock);
+	ldb_module_timing_call_op(module, LDB_MODULE_TIMING_READ_LOCK, &frame);
 	ret = module->ops->read_lock(module);
+	ldb_module_timing_leave(&frame);
 	if (ret == LDB_SUCCESS) {
 		return ret;
 	}
@@ -676,9 +984,12 @@ int ldb_next_read_lock(struct ldb_module *module)
 
 int ldb_next_read_unlock(struct ldb_module *module)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 	FIND_OP(module, read_unlock);
+	ldb_module_timing_call_op(module, LDB_MODULE_TIMING_READ_UNLOCK, &frame);
 	ret = module->ops->read_unlock(module);
+	ldb_module_timing_leave(&frame);
 	if (ret == LDB_SUCCESS) {
 		return ret;
 	}
@@ -699,6 +1010,7 @@ int ldb_next_read_unlock(struct ldb_module *module)
 
 int ldb_next_prepare_commit(struct ldb_module *module)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 	FIND_OP_NOERR(module, prepare_commit);
 	if (module == NULL) {
@@ -706,7 +1018,10 @@ int ldb_next_prepare_commit(struct ldb_module *module)
 		   backends */
 		return LDB_SUCCESS;
 	}
+	ldb_module_timing_call_op(module, LDB_MODULE_TIMING_PREPARE_COMMIT,
+				  &frame);
 	ret = module->ops->prepare_commit(module);
+	ldb_module_timing_leave(&frame);
 	if (ret == LDB_SUCCESS) {
 		return ret;
 	}
@@ -723,9 +1038,12 @@ int ldb_next_prepare_commit(struct ldb_module *module)
 
 int ldb_next_del_trans(struct ldb_module *module)
 {
+	struct ldb_module_timing_frame frame;
 	int ret;
 	FIND_OP(module, del_transaction);
+	ldb_module_timing_call_op(module, LDB_MODULE_TIMING_DEL_TRANS, &frame);
 	ret = module->ops->del_transaction(module);
+	ldb_module_timing_leave(&frame);
 	if (ret == LDB_SUCCESS) {
 		return ret;
 	}
@@ -754,7 +1072,9 @@ int ldb_module_send_entry(struct ldb_request *req,
 			  struct ldb_message *msg,
 			  struct ldb_control **ctrls)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_reply *ares;
+	int ret;
 
 	ares = talloc_zero(req, struct ldb_reply);
 	if (!ares) {
@@ -790,7 +1110,11 @@ int ldb_module_send_entry(struct ldb_request *req,
 		ldb_debug_end(req->handle->ldb, LDB_DEBUG_TRACE);
 	}
 
-	return req->callback(req, ares);
+	ldb_module_timing_enter_callback(req, &frame);
+	ret = req->callback(req, ares);
+	ldb_module_timing_leave(&frame);
+
+	return ret;
 }
 
 /* calls the request callback to send an referrals
@@ -803,7 +1127,9 @@ int ldb_module_send_entry(struct ldb_request *req,
 int ldb_module_send_referral(struct ldb_request *req,
 					   char *ref)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_reply *ares;
+	int ret;
 
 	ares = talloc_zero(req, struct ldb_reply);
 	if (!ares) {
@@ -822,7 +1148,11 @@ int ldb_module_send_referral(struct ldb_request *req,
 		ldb_debug_end(req->handle->ldb, LDB_DEBUG_TRACE);
 	}
 
-	return req->callback(req, ares);
+	ldb_module_timing_enter_callback(req, &frame);
+	ret = req->callback(req, ares);
+	ldb_module_timing_leave(&frame);
+
+	return ret;
 }
 
 /* calls the original request callback
@@ -839,7 +1169,9 @@ int ldb_module_done(struct ldb_request *req,
 		    struct ldb_extended *response,
 		    int error)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_reply *ares;
+	int ret;
 
 	ares = talloc_zero(req, struct ldb_reply);
 	if (!ares) {
@@ -865,7 +1197,11 @@ int ldb_module_done(struct ldb_request *req,
 		ldb_debug_end(req->handle->ldb, LDB_DEBUG_TRACE);
 	}
 
-	return req->callback(req, ares);
+	ldb_module_timing_enter_callback(req, &frame);
+	ret = req->callback(req, ares);
+	ldb_module_timing_leave(&frame);
+
+	return ret;
 }
 
 /* to be used *only* in modules init functions.
@@ -33,11 +33,41 @@
 
 #include "ldb_private.h"
 
-/* change this if the data format ever changes */
-#define LDB_PACKING_FORMAT 0x26011967
-
-/* old packing formats */
-#define LDB_PACKING_FORMAT_NODN 0x26011966
+/*
+ * The packing formats are defined in ldb_module.h:
+ *
+ * LDB_PACKING_FORMAT (version 1) is
+ *
+ *   uint32 format
+ *   uint32 number of elements
+ *   DN, \0 terminated
+ *   for each element:
+ *     attribute name, \0 terminated
+ *     uint32 number of values
+ *     for each value:
+ *       uint32 length, the value data, \0
+ *
+ * so finding an attribute means walking all the values of all the
+ * attributes before it.
+ *
+ * LDB_PACKING_FORMAT_V2 puts a directory of the attribute names at
+ * the front, each name followed by the offset of its values from the
+ * start of the buffer:
+ *
+ *   uint32 format
+ *   uint32 number of elements
+ *   DN, \0 terminated
+ *   for each element:
+ *     attribute name, \0 terminated
+ *     uint32 offset of the values
+ *   for each element:
+ *     uint32 number of values
+ *     for each value:
+ *       uint32 length, the value data, \0
+ *
+ * so a selective unpack only reads the directory and then jumps to
+ * the values of the attributes it wants.
+ */
 
 /* use a portable integer format */
 static void put_uint32(uint8_t *p, int ofs, unsigned int val)
@@ -65,23 +95,61 @@ static int attribute_storable_values(const struct ldb_message_element *el)
 }
 
 /*
-  pack a ldb message into a linear buffer in a ldb_val
+  pack the values of an element at *pp, moving *pp past them
+*/
+static void ldb_pack_element_values(uint8_t **pp,
+				    const struct ldb_message_element *el)
+{
+	uint8_t *p = *pp;
+	unsigned int j;
+
+	put_uint32(p, 0, el->num_values);
+	p += 4;
+	for (j=0;j<el->num_values;j++) {
+		put_uint32(p, 0, el->values[j].length);
+		memcpy(p+4, el->values[j].data, el->values[j].length);
+		p[4+el->values[j].length] = 0;
+		p += 4 + el->values[j].length + 1;
+	}
+
+	*pp = p;
+}
+
+/*
+  pack a ldb message into a linear buffer in a ldb_val, in the given
+  packing format
 
   note that this routine avoids saving elements with zero values,
   as these are equivalent to having no element
 
   caller frees the data buffer after use
 */
-int ldb_pack_data(struct ldb_context *ldb,
-		  const struct ldb_message *message,
-		  struct ldb_val *data)
+int ldb_pack_data_format(struct ldb_context *ldb,
+			 const struct ldb_message *message,
+			 struct ldb_val *data,
+			 uint32_t pack_format_version)
 {
 	unsigned int i, j, real_elements=0;
 	size_t size, dn_len, attr_len, value_len;
+	size_t dir_size = 0, element_overhead;
 	const char *dn;
-	uint8_t *p;
+	uint8_t *p, *values;
 	size_t len;
 
+	switch (pack_format_version) {
+	case LDB_PACKING_FORMAT:
+		/* name terminator, number of values */
+		element_overhead = 5;
+		break;
+	case LDB_PACKING_FORMAT_V2:
+		/* name terminator, offset, number of values */
+		element_overhead = 9;
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+
 	dn = ldb_dn_get_linearized(message->dn);
 	if (dn == NULL) {
 		errno = ENOMEM;
@@ -111,11 +179,11 @@ int ldb_pack_data(struct ldb_context *ldb,
 
 		real_elements++;
 
-		if (size + 5 < size) {
+		if (size + element_overhead < size) {
 			errno = ENOMEM;
 			return -1;
 		}
-		size += 5;
+		size += element_overhead;
 
 		attr_len = strlen(message->elements[i].name);
 		if (size + attr_len < size) {
@@ -123,6 +191,7 @@ int ldb_pack_data(struct ldb_context *ldb,
 			return -1;
 		}
 		size += attr_len;
+		dir_size += attr_len + 5;
 
 		for (j=0;j<message->elements[i].num_values;j++) {
 			if (size + 5 < size) {
@@ -140,6 +209,13 @@ int ldb_pack_data(struct ldb_context *ldb,
 		}
 	}
 
+	/* the V2 offsets are 32 bit */
+	if (pack_format_version == LDB_PACKING_FORMAT_V2 &&
+	    size > UINT32_MAX) {
+		errno = ENOMEM;
+		return -1;
+	}
+
 	/* allocate it */
 	data->data = talloc_array(ldb, uint8_t, size);
 	if (!data->data) {
@@ -149,7 +225,7 @@ int ldb_pack_data(struct ldb_context *ldb,
 	data->length = size;
 
 	p = data->data;
-	put_uint32(p, 0, LDB_PACKING_FORMAT);
+	put_uint32(p, 0, pack_format_version);
 	put_uint32(p, 4, real_elements);
 	p += 8;
 
@@ -159,6 +235,12 @@ int ldb_pack_data(struct ldb_context *ldb,
 	memcpy(p, dn, len+1);
 	p += len + 1;
 
+	/*
+	 * In V2 the names go into the directory at p, and the values
+	 * after it
+	 */
+	values = p + dir_size;
+
 	for (i=0;i<message->num_elements;i++) {
 		if (attribute_storable_values(&message->elements[i]) == 0) {
 			continue;
@@ -166,20 +248,46 @@ int ldb_pack_data(struct ldb_context *ldb,
 		len = strlen(message->elements[i].name);
 		memcpy(p, message->elements[i].name, len+1);
 		p += len + 1;
-		put_uint32(p, 0, message->elements[i].num_values);
-		p += 4;
-		for (j=0;j<message->elements[i].num_values;j++) {
-			put_uint32(p, 0, message->elements[i].values[j].length);
-			memcpy(p+4, message->elements[i].values[j].data,
-			       message->elements[i].values[j].length);
-			p[4+message->elements[i].values[j].length] = 0;
-			p += 4 + message->elements[i].values[j].length + 1;
+		if (pack_format_version == LDB_PACKING_FORMAT_V2) {
+			put_uint32(p, 0, values - data->data);
+			p += 4;
+			/* the values follow the directory */
+			ldb_pack_element_values(&values,
+						&message->elements[i]);
+		} else {
+			ldb_pack_element_values(&p, &message->elements[i]);
 		}
 	}
 
 	return 0;
 }
 
+/*
+  pack a ldb message into a linear buffer in a ldb_val
+
+  caller frees the data buffer after use
+*/
+int ldb_pack_data(struct ldb_context *ldb,
+		  const struct ldb_message *message,
+		  struct ldb_val *data)
+{
+	return ldb_pack_data_format(ldb, message, data, LDB_PACKING_FORMAT);
+}
+
+/*
+  find the packing format of a packed message, without unpacking it
+*/
+int ldb_unpack_get_format(const struct ldb_val *data,
+			  uint32_t *pack_format_version)
+{
+	if (data->length < 8) {
+		errno = EIO;
+		return -1;
+	}
+	*pack_format_version = pull_uint32(data->data, 0);
+	return 0;
+}
+
 static bool ldb_consume_element_data(uint8_t **pp, size_t *premaining)
 {
 	unsigned int remaining = *premaining;
@@ -211,6 +319,124 @@ static bool ldb_consume_element_data(uint8_t **pp, size_t *premaining)
 }
 
 
+/*
+  is attr in the list of attributes to unpack?  found counts the
+  matches so far, so the search stops once all were found
+*/
+static bool ldb_attr_in_unpack_list(const char *attr,
+				    const char * const *list,
+				    unsigned int list_size,
+				    unsigned int *found)
+{
+	unsigned int h;
+
+	for (h = 0; h < list_size && *found < list_size; h++) {
+		if (ldb_attr_cmp(attr, list[h]) == 0) {
+			(*found)++;
+			return true;
+		}
+	}
+	return false;
+}
+
+static int ldb_unpack_element_name(struct ldb_message *message,
+				   struct ldb_message_element *element,
+				   const char *attr,
+				   size_t attr_len,
+				   unsigned int flags)
+{
+	if (flags & LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC) {
+		element->name = attr;
+	} else {
+		element->name = talloc_memdup(message->elements, attr, attr_len+1);
+
+		if (element->name == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+	element->flags = 0;
+	return 0;
+}
+
+/*
+  unpack the values of an element at *pp, moving *pp past them
+
+  single_value is used for a single valued element with
+  LDB_UNPACK_DATA_FLAG_NO_VALUES_ALLOC
+*/
+static bool ldb_unpack_element_values(struct ldb_message *message,
+				      struct ldb_message_element *element,
+				      struct ldb_val *single_value,
+				      unsigned int flags,
+				      uint8_t **pp,
+				      size_t *premaining)
+{
+	uint8_t *p = *pp;
+	size_t remaining = *premaining;
+	unsigned int j;
+	size_t len;
+
+	if (remaining < 4) {
+		errno = EIO;
+		return false;
+	}
+	element->num_values = pull_uint32(p, 0);
+	element->values = NULL;
+	if ((flags & LDB_UNPACK_DATA_FLAG_NO_VALUES_ALLOC) &&
+	    single_value != NULL &&
+	    element->num_values == 1) {
+		element->values = single_value;
+	} else if (element->num_values != 0) {
+		element->values = talloc_array(message->elements,
+					       struct ldb_val,
+					       element->num_values);
+		if (!element->values) {
+			errno = ENOMEM;
+			return false;
+		}
+	}
+	p += 4;
+	remaining -= 4;
+	for (j = 0; j < element->num_values; j++) {
+		if (remaining < 5) {
+			errno = EIO;
+			return false;
+		}
+		remaining -= 5;
+
+		len = pull_uint32(p, 0);
+		if (remaining < len) {
+			errno = EIO;
+			return false;
+		}
+		if (len + 1 < len) {
+			errno = EIO;
+			return false;
+		}
+
+		element->values[j].length = len;
+		if (flags & LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC) {
+			element->values[j].data = p + 4;
+		} else {
+			element->values[j].data = talloc_size(element->values, len+1);
+			if (element->values[j].data == NULL) {
+				errno = ENOMEM;
+				return false;
+			}
+			memcpy(element->values[j].data, p + 4,
+			       len);
+			element->values[j].data[len] = 0;
+		}
+		remaining -= len;
+		p += len+4+1;
+	}
+
+	*pp = p;
+	*premaining = remaining;
+	return true;
+}
+
 /*
  * Unpack a ldb message from a linear buffer in ldb_val
  *
@@ -228,11 +454,11 @@ int ldb_unpack_data_only_attr_list_flags(struct ldb_context *ldb,
 	uint8_t *p;
 	size_t remaining;
 	size_t dn_len;
-	unsigned int i, j;
+	unsigned int i;
 	unsigned format;
 	unsigned int nelem = 0;
-	size_t len;
 	unsigned int found = 0;
+	int ret;
 	struct ldb_val *ldb_val_single_array = NULL;
 
 	if (list == NULL) {
@@ -262,6 +488,7 @@ int ldb_unpack_data_only_attr_list_flags(struct ldb_context *ldb,
 		break;
 
 	case LDB_PACKING_FORMAT:
+	case LDB_PACKING_FORMAT_V2:
 		/*
 		 * With this check, we know that the DN at p is \0
 		 * terminated.
@@ -342,7 +569,81 @@ int ldb_unpack_data_only_attr_list_flags(struct ldb_context *ldb,
 		}
 	}
 
-	for (i=0;i<message->num_elements;i++) {
+	if (format == LDB_PACKING_FORMAT_V2) {
+		/*
+		 * Walk the directory, and only jump to the values of
+		 * the attributes we want
+		 */
+		for (i=0;i<message->num_elements;i++) {
+			const char *attr = NULL;
+			size_t attr_len;
+			uint32_t offset;
+			uint8_t *v = NULL;
+			size_t v_remaining;
+			struct ldb_message_element *element = NULL;
+
+			if (list_size != 0 && found == list_size) {
+				/* nothing more we want */
+				break;
+			}
+
+			if (remaining < 6) {
+				errno = EIO;
+				goto failed;
+			}
+			/*
+			 * With this check, we know that the attribute
+			 * name at p is \0 terminated, and followed by
+			 * the offset.
+			 */
+			attr_len = strnlen((char *)p, remaining-4);
+			if (attr_len == remaining-4) {
+				errno = EIO;
+				goto failed;
+			}
+			if (attr_len == 0) {
+				errno = EIO;
+				goto failed;
+			}
+			attr = (char *)p;
+			offset = pull_uint32(p, attr_len + 1);
+			remaining -= attr_len + 5;
+			p += attr_len + 5;
+
+			if (list_size != 0 &&
+			    !ldb_attr_in_unpack_list(attr, list, list_size,
+						     &found)) {
+				continue;
+			}
+
+			if (offset > data->length) {
+				errno = EIO;
+				goto failed;
+			}
+			v = data->data + offset;
+			v_remaining = data->length - offset;
+
+			element = &message->elements[nelem];
+			ret = ldb_unpack_element_name(message, element,
+						      attr, attr_len, flags);
+			if (ret != 0) {
+				goto failed;
+			}
+			if (!ldb_unpack_element_values(
+				    message, element,
+				    ldb_val_single_array != NULL ?
+				    &ldb_val_single_array[nelem] : NULL,
+				    flags, &v, &v_remaining)) {
+				goto failed;
+			}
+			nelem++;
+		}
+
+		/* The values follow the directory, so are not all read */
+		remaining = 0;
+	}
+
+	for (i=0;format != LDB_PACKING_FORMAT_V2 && i<message->num_elements;i++) {
 		const char *attr = NULL;
 		size_t attr_len;
 		struct ldb_message_element *element = NULL;
@@ -375,22 +676,12 @@ int ldb_unpack_data_only_attr_list_flags(struct ldb_context *ldb,
 		 * and can dwarf the cost of looping.
 		 */
 		if (list_size != 0) {
-			bool keep = false;
-			unsigned int h;
-
 			/*
 			 * We know that p has a \0 terminator before the
 			 * end of the buffer due to the check above.
 			 */
-			for (h = 0; h < list_size && found < list_size; h++) {
-				if (ldb_attr_cmp(attr, list[h]) == 0) {
-					keep = true;
-					found++;
-					break;
-				}
-			}
-
-			if (!keep) {
+			if (!ldb_attr_in_unpack_list(attr, list, list_size,
+						     &found)) {
 				if (remaining < (attr_len + 1)) {
 					errno = EIO;
 					goto failed;
@@ -405,17 +696,11 @@ int ldb_unpack_data_only_attr_list_flags(struct ldb_context *ldb,
 			}
 		}
 		element = &message->elements[nelem];
-		if (flags & LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC) {
-			element->name = attr;
-		} else {
-			element->name = talloc_memdup(message->elements, attr, attr_len+1);
-
-			if (element->name == NULL) {
-				errno = ENOMEM;
-				goto failed;
-			}
+		ret = ldb_unpack_element_name(message, element,
+					      attr, attr_len, flags);
+		if (ret != 0) {
+			goto failed;
 		}
-		element->flags = 0;
 
 		if (remaining < (attr_len + 1)) {
 			errno = EIO;
@@ -423,58 +708,12 @@ int ldb_unpack_data_only_attr_list_flags(struct ldb_context *ldb,
 		}
 		remaining -= attr_len + 1;
 		p += attr_len + 1;
-		element->num_values = pull_uint32(p, 0);
-		element->values = NULL;
-		if ((flags & LDB_UNPACK_DATA_FLAG_NO_VALUES_ALLOC) && element->num_values == 1) {
-			element->values = &ldb_val_single_array[nelem];
-		} else if (element->num_values != 0) {
-			element->values = talloc_array(message->elements,
-						       struct ldb_val,
-						       element->num_values);
-			if (!element->values) {
-				errno = ENOMEM;
-				goto failed;
-			}
-		}
-		p += 4;
-		if (remaining < 4) {
-			errno = EIO;
+		if (!ldb_unpack_element_values(message, element,
+					       ldb_val_single_array != NULL ?
+					       &ldb_val_single_array[nelem] : NULL,
+					       flags, &p, &remaining)) {
 			goto failed;
 		}
-		remaining -= 4;
-		for (j = 0; j < element->num_values; j++) {
-			if (remaining < 5) {
-				errno = EIO;
-				goto failed;
-			}
-			remaining -= 5;
-
-			len = pull_uint32(p, 0);
-			if (remaining < len) {
-				errno = EIO;
-				goto failed;
-			}
-			if (len + 1 < len) {
-				errno = EIO;
-				goto failed;
-			}
-
-			element->values[j].length = len;
-			if (flags & LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC) {
-				element->values[j].data = p + 4;
-			} else {
-				element->values[j].data = talloc_size(element->values, len+1);
-				if (element->values[j].data == NULL) {
-					errno = ENOMEM;
-					goto failed;
-				}
-				memcpy(element->values[j].data, p + 4,
-				       len);
-				element->values[j].data[len] = 0;
-			}
-			remaining -= len;
-			p += len+4+1;
-		}
 		nelem++;
 	}
 	/*
@@ -446,6 +446,17 @@ const struct ldb_dn_extended_syntax *ldb_dn_extended_syntax_by_name(struct ldb_c
  */
 #define LDB_ATTR_FLAG_INDEXED      (1<<7)
 
+/*
+ * The attribute has an ordered index, usable for >= and <= searches
+ */
+#define LDB_ATTR_FLAG_ORDERED_INDEX (1<<8)
+
+/*
+ * The attribute has a prefix index, usable for initial substring
+ * searches
+ */
+#define LDB_ATTR_FLAG_PREFIX_INDEX (1<<9)
+
 /**
   LDAP attribute syntax for a DN
 
@@ -241,6 +241,20 @@ int ldb_match_msg_error(struct ldb_context *ldb,
 			enum ldb_scope scope,
 			bool *matched);
 
+struct ldb_match_program;
+
+int ldb_match_compile(struct ldb_context *ldb,
+		      TALLOC_CTX *mem_ctx,
+		      const struct ldb_parse_tree *tree,
+		      struct ldb_match_program **_program);
+
+int ldb_match_compiled_msg_error(struct ldb_context *ldb,
+				 const struct ldb_message *msg,
+				 const struct ldb_match_program *program,
+				 struct ldb_dn *base,
+				 enum ldb_scope scope,
+				 bool *matched);
+
 int ldb_match_msg_objectclass(const struct ldb_message *msg,
 			      const char *objectclass);
 
@@ -268,6 +282,51 @@ int ldb_next_init(struct ldb_module *module);
 int ldb_next_read_lock(struct ldb_module *module);
 int ldb_next_read_unlock(struct ldb_module *module);
 
+/*
+ * Per-module timing
+ *
+ * While enabled, the time between control passing into a module (or
+ * backend) and it passing on to another module, to a callback or back
+ * to the caller of ldb is added to that module and the operation it
+ * is doing, and the calls to each module are counted.  The counters
+ * are per process, kept by module name over all ldb contexts.
+ */
+struct ldb_module_timing;
+
+struct ldb_module_timing_frame {
+	/* private to ldb_modules.c */
+	struct ldb_module_timing *timing;
+	unsigned int op;
+	uint64_t generation;
+};
+
+void ldb_module_timing_enable(bool enable);
+bool ldb_module_timing_enabled(void);
+void ldb_module_timing_reset(void);
+
+/*
+ * Returns a NULL terminated list of "<module> <operation> <calls>
+ * <microseconds>" strings, one for each operation a module has been
+ * called for.
+ */
+const char **ldb_module_timing_report(TALLOC_CTX *mem_ctx);
+
+/*
+ * For backends that do the work of a request later, from an event:
+ * count the time until ldb_module_timing_leave() against the module.
+ */
+void ldb_module_timing_enter(struct ldb_module *module,
+			     struct ldb_request *req,
+			     struct ldb_module_timing_frame *frame);
+/*
+ * For backends that call req->callback() directly: count the time
+ * until ldb_module_timing_leave() against the module that made the
+ * request.
+ */
+void ldb_module_timing_enter_callback(struct ldb_request *req,
+				      struct ldb_module_timing_frame *frame);
+void ldb_module_timing_leave(struct ldb_module_timing_frame *frame);
+
 void ldb_set_errstring(struct ldb_context *ldb, const char *err_string);
 void ldb_asprintf_errstring(struct ldb_context *ldb, const char *format, ...) PRINTF_ATTRIBUTE(2,3);
 void ldb_reset_err_string(struct ldb_context *ldb);
@@ -510,6 +569,29 @@ int ldb_register_extended_match_rule(struct ldb_context *ldb,
 int ldb_pack_data(struct ldb_context *ldb,
 		  const struct ldb_message *message,
 		  struct ldb_val *data);
+
+#define LDB_PACKING_FORMAT_NODN 0x26011966
+#define LDB_PACKING_FORMAT 0x26011967
+/*
+ * LDB_PACKING_FORMAT_V2 puts a directory of attribute names and
+ * value offsets at the front of the record, so a selective unpack
+ * can skip straight to the attributes it wants.
+ */
+#define LDB_PACKING_FORMAT_V2 0x26011968
+
+/*
+ * Pack a ldb message in the given format (LDB_PACKING_FORMAT or
+ * LDB_PACKING_FORMAT_V2)
+ */
+int ldb_pack_data_format(struct ldb_context *ldb,
+			 const struct ldb_message *message,
+			 struct ldb_val *data,
+			 uint32_t pack_format_version);
+/*
+ * Return the format a packed ldb message was written in
+ */
+int ldb_unpack_get_format(const struct ldb_val *data,
+			  uint32_t *pack_format_version);
 /*
  * Unpack a ldb message from a linear buffer in ldb_val
  *
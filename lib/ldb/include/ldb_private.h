@@ -68,6 +68,13 @@ struct ldb_handle {
 	/* used for debugging */
 	struct ldb_request *parent;
 	const char *location;
+
+	/*
+	 * The module whose callback this request calls, for the module
+	 * timing.  NULL if that is the caller of ldb.
+	 */
+	struct ldb_module_timing *timing_owner;
+	bool timing_owner_set;
 };
 
 /* basic module structure */
@@ -76,6 +83,24 @@ struct ldb_module {
 	struct ldb_context *ldb;
 	void *private_data;
 	const struct ldb_module_ops *ops;
+	struct ldb_module_timing *timing;
+};
+
+enum ldb_module_timing_op {
+	LDB_MODULE_TIMING_SEARCH = 0,
+	LDB_MODULE_TIMING_ADD,
+	LDB_MODULE_TIMING_MODIFY,
+	LDB_MODULE_TIMING_DELETE,
+	LDB_MODULE_TIMING_RENAME,
+	LDB_MODULE_TIMING_EXTENDED,
+	LDB_MODULE_TIMING_REQUEST,
+	LDB_MODULE_TIMING_START_TRANS,
+	LDB_MODULE_TIMING_PREPARE_COMMIT,
+	LDB_MODULE_TIMING_END_TRANS,
+	LDB_MODULE_TIMING_DEL_TRANS,
+	LDB_MODULE_TIMING_READ_LOCK,
+	LDB_MODULE_TIMING_READ_UNLOCK,
+	LDB_MODULE_TIMING_NUM_OPS
 };
 
 /*
@@ -211,6 +236,15 @@ void ldb_dump_results(struct ldb_context *ldb, struct ldb_result *result, FILE *
 const char **ldb_modules_list_from_string(struct ldb_context *ldb, TALLOC_CTX *mem_ctx, const char *string);
 int ldb_load_modules(struct ldb_context *ldb, const char *options[]);
 
+void ldb_request_timing_set_owner(struct ldb_request *req,
+				  struct ldb_module *module);
+void ldb_module_timing_call(struct ldb_module *module,
+			    struct ldb_request *req,
+			    struct ldb_module_timing_frame *frame);
+void ldb_module_timing_call_op(struct ldb_module *module,
+			       enum ldb_module_timing_op op,
+			       struct ldb_module_timing_frame *frame);
+
 struct ldb_val ldb_binary_decode(TALLOC_CTX *mem_ctx, const char *str);
 
 
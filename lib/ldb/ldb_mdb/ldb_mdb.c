@@ -0,0 +1,977 @@
+/*
+   ldb database library using the LMDB key value store
+
+     ** NOTE! The following LGPL license applies to the ldb
+     ** library. This does NOT imply that all of Samba is released
+     ** under the LGPL
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 3 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ *  Name: ldb_mdb
+ *
+ *  Component: ldb LMDB backend
+ *
+ *  Description: an implementation of the ldb_tdb kv_db_ops on top of
+ *  LMDB.  All of the ldb logic (packing, indexing, caching and the
+ *  module operations) is shared with the tdb backend, only the key
+ *  value store underneath is different.
+ *
+ *  Compared with tdb, LMDB gives us:
+ *
+ *   - MVCC readers.  A search runs inside a read transaction on a
+ *     snapshot of the database and never blocks, or is blocked by,
+ *     a writer.  tdb instead takes an all-record read lock.
+ *
+ *   - 64 bit file offsets, so a database is not limited to 4GB.
+ *
+ *   - cheap read transactions.  The read transaction handle is kept
+ *     between searches and only reset/renewed, which does not need
+ *     any allocation or system call.
+ */
+
+#include "ldb_tdb/ldb_tdb.h"
+#include "ldb_mdb.h"
+#include "dlinklist.h"
+
+#define MDB_URL_PREFIX		"mdb://"
+#define MDB_URL_PREFIX_SIZE	(sizeof(MDB_URL_PREFIX) - 1)
+
+#define LDB_MDB_MAX_READERS	2048
+
+int ldb_mdb_err_map(int lmdb_err)
+{
+	switch (lmdb_err) {
+	case MDB_SUCCESS:
+		return LDB_SUCCESS;
+	case EIO:
+		return LDB_ERR_PROTOCOL_ERROR;
+	case MDB_INCOMPATIBLE:
+	case MDB_CORRUPTED:
+	case MDB_INVALID:
+	case MDB_VERSION_MISMATCH:
+	case MDB_MAP_FULL:
+	case MDB_MAP_RESIZED:
+	case MDB_READERS_FULL:
+	case MDB_TXN_FULL:
+	case MDB_PAGE_FULL:
+	case ENOMEM:
+		return LDB_ERR_OPERATIONS_ERROR;
+	case MDB_BAD_TXN:
+	case MDB_BAD_RSLOT:
+	case EINVAL:
+		return LDB_ERR_PROTOCOL_ERROR;
+	case MDB_BAD_VALSIZE:
+		return LDB_ERR_UNWILLING_TO_PERFORM;
+	case MDB_KEYEXIST:
+		return LDB_ERR_ENTRY_ALREADY_EXISTS;
+	case MDB_NOTFOUND:
+	case ENOENT:
+		return LDB_ERR_NO_SUCH_OBJECT;
+	case EACCES:
+	case EPERM:
+		return LDB_ERR_INSUFFICIENT_ACCESS_RIGHTS;
+	case EBUSY:
+		return LDB_ERR_BUSY;
+	default:
+		break;
+	}
+	return LDB_ERR_OTHER;
+}
+
+/*
+  record an LMDB error, log it and return the matching ldb error code
+*/
+static int lmdb_error_at(struct ldb_context *ldb,
+			 int ecode,
+			 const char *file,
+			 int line)
+{
+	int ldb_err = ldb_mdb_err_map(ecode);
+	char *reason = NULL;
+
+	/* a missing record is an expected result, not worth a message */
+	if (ecode == MDB_NOTFOUND) {
+		return ldb_err;
+	}
+
+	reason = mdb_strerror(ecode);
+	ldb_asprintf_errstring(ldb,
+			       "(%d) - %s at %s:%d",
+			       ecode,
+			       reason,
+			       file,
+			       line);
+	return ldb_err;
+}
+
+#define ldb_mdb_error(ldb, ecode) lmdb_error_at(ldb, ecode, __FILE__, __LINE__)
+
+/*
+ * An LMDB environment can not be used in a child process, and the
+ * transaction state held in it would be wrong in any case.
+ */
+static bool lmdb_pvt_check_pid(struct lmdb_private *lmdb)
+{
+	if (lmdb->pid != getpid()) {
+		ldb_asprintf_errstring(lmdb->ldb,
+				       "Reusing ldb opened by pid %d in "
+				       "process %d\n",
+				       (int)lmdb->pid,
+				       (int)getpid());
+		lmdb->error = MDB_BAD_TXN;
+		return false;
+	}
+	return true;
+}
+
+static MDB_txn *lmdb_trans_get_tx(struct lmdb_trans *ltx)
+{
+	if (ltx == NULL) {
+		return NULL;
+	}
+	return ltx->tx;
+}
+
+/*
+  the transaction reads and writes go to: the innermost write
+  transaction if there is one, otherwise the current read transaction
+*/
+static MDB_txn *get_current_txn(struct lmdb_private *lmdb)
+{
+	if (lmdb->txlist != NULL) {
+		return lmdb_trans_get_tx(lmdb->txlist);
+	}
+	if (lmdb->read_txn_active) {
+		return lmdb->read_txn;
+	}
+	return NULL;
+}
+
+/*
+  start the read transaction, re-using the handle of the last one
+*/
+static int lmdb_read_txn_begin(struct lmdb_private *lmdb)
+{
+	int ret;
+
+	if (!lmdb_pvt_check_pid(lmdb)) {
+		return MDB_BAD_TXN;
+	}
+
+	if (lmdb->read_txn != NULL) {
+		ret = mdb_txn_renew(lmdb->read_txn);
+		if (ret == MDB_SUCCESS) {
+			lmdb->read_txn_active = true;
+			return MDB_SUCCESS;
+		}
+		mdb_txn_abort(lmdb->read_txn);
+		lmdb->read_txn = NULL;
+	}
+
+	ret = mdb_txn_begin(lmdb->env, NULL, MDB_RDONLY, &lmdb->read_txn);
+	if (ret != MDB_SUCCESS) {
+		lmdb->read_txn = NULL;
+		return ret;
+	}
+	lmdb->read_txn_active = true;
+	return MDB_SUCCESS;
+}
+
+static void lmdb_read_txn_end(struct lmdb_private *lmdb)
+{
+	if (!lmdb->read_txn_active) {
+		return;
+	}
+	mdb_txn_reset(lmdb->read_txn);
+	lmdb->read_txn_active = false;
+}
+
+static int lmdb_store(struct ltdb_private *ltdb,
+		      struct ldb_val key,
+		      struct ldb_val data, int flags)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	MDB_val mdb_key;
+	MDB_val mdb_data;
+	int mdb_flags;
+	MDB_txn *txn = NULL;
+
+	if (ltdb->read_only) {
+		lmdb->error = EACCES;
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+
+	txn = lmdb_trans_get_tx(lmdb->txlist);
+	if (txn == NULL) {
+		ldb_debug(lmdb->ldb, LDB_DEBUG_FATAL, "No transaction");
+		lmdb->error = EINVAL;
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+
+	/*
+	 * Without the GUID index the record key is the DN, and LMDB
+	 * can not store a DN longer than its maximum key size
+	 */
+	if (key.length > (size_t)mdb_env_get_maxkeysize(lmdb->env)) {
+		lmdb->error = MDB_BAD_VALSIZE;
+		ldb_asprintf_errstring(lmdb->ldb,
+				       "mdb key of %zu bytes is longer than "
+				       "the LMDB maximum of %d bytes, a "
+				       "database without GUID index can not "
+				       "hold a DN this long",
+				       key.length,
+				       mdb_env_get_maxkeysize(lmdb->env));
+		return ldb_mdb_err_map(lmdb->error);
+	}
+
+	mdb_key.mv_size = key.length;
+	mdb_key.mv_data = key.data;
+
+	mdb_data.mv_size = data.length;
+	mdb_data.mv_data = data.data;
+
+	if (flags == TDB_INSERT) {
+		mdb_flags = MDB_NOOVERWRITE;
+	} else if (flags == TDB_MODIFY) {
+		/*
+		 * Modifying a record, ensure that it exists.
+		 * This mimics the TDB semantics
+		 */
+		MDB_val value;
+		lmdb->error = mdb_get(txn, lmdb->dbi, &mdb_key, &value);
+		if (lmdb->error != MDB_SUCCESS) {
+			return ldb_mdb_error(lmdb->ldb, lmdb->error);
+		}
+		mdb_flags = 0;
+	} else {
+		mdb_flags = 0;
+	}
+
+	lmdb->error = mdb_put(txn, lmdb->dbi, &mdb_key, &mdb_data, mdb_flags);
+	if (lmdb->error != MDB_SUCCESS) {
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+
+	return ldb_mdb_err_map(lmdb->error);
+}
+
+static int lmdb_delete(struct ltdb_private *ltdb, struct ldb_val key)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	MDB_val mdb_key;
+	MDB_txn *txn = NULL;
+
+	if (ltdb->read_only) {
+		lmdb->error = EACCES;
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+
+	txn = lmdb_trans_get_tx(lmdb->txlist);
+	if (txn == NULL) {
+		ldb_debug(lmdb->ldb, LDB_DEBUG_FATAL, "No transaction");
+		lmdb->error = EINVAL;
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+
+	/* LMDB can not hold a key longer than this, so there is no record */
+	if (key.length > (size_t)mdb_env_get_maxkeysize(lmdb->env)) {
+		lmdb->error = MDB_NOTFOUND;
+		return ldb_mdb_err_map(lmdb->error);
+	}
+
+	mdb_key.mv_size = key.length;
+	mdb_key.mv_data = key.data;
+
+	lmdb->error = mdb_del(txn, lmdb->dbi, &mdb_key, NULL);
+	if (lmdb->error != MDB_SUCCESS) {
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+	return ldb_mdb_err_map(lmdb->error);
+}
+
+static int lmdb_traverse_fn(struct ltdb_private *ltdb,
+			    ldb_kv_traverse_fn fn,
+			    void *ctx)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	MDB_val mdb_key;
+	MDB_val mdb_data;
+	MDB_txn *txn = NULL;
+	MDB_cursor *cursor = NULL;
+	bool own_read_txn = false;
+	int count = 0;
+	int ret;
+
+	txn = get_current_txn(lmdb);
+	if (txn == NULL) {
+		/*
+		 * Not called under a read lock, so take a snapshot
+		 * just for this traverse
+		 */
+		lmdb->error = lmdb_read_txn_begin(lmdb);
+		if (lmdb->error != MDB_SUCCESS) {
+			ldb_mdb_error(lmdb->ldb, lmdb->error);
+			return -1;
+		}
+		own_read_txn = true;
+		txn = lmdb->read_txn;
+	}
+
+	lmdb->error = mdb_cursor_open(txn, lmdb->dbi, &cursor);
+	if (lmdb->error != MDB_SUCCESS) {
+		goto done;
+	}
+
+	while ((lmdb->error = mdb_cursor_get(cursor,
+					     &mdb_key,
+					     &mdb_data,
+					     MDB_NEXT)) == MDB_SUCCESS) {
+
+		struct ldb_val key = {
+			.length = mdb_key.mv_size,
+			.data = mdb_key.mv_data,
+		};
+		struct ldb_val data = {
+			.length = mdb_data.mv_size,
+			.data = mdb_data.mv_data,
+		};
+
+		count++;
+		ret = fn(ltdb, key, data, ctx);
+		if (ret != 0) {
+			/* the traverse was stopped, as with tdb_traverse() */
+			lmdb->error = MDB_SUCCESS;
+			break;
+		}
+	}
+	if (lmdb->error == MDB_NOTFOUND) {
+		lmdb->error = MDB_SUCCESS;
+	}
+
+done:
+	if (cursor != NULL) {
+		mdb_cursor_close(cursor);
+	}
+	if (own_read_txn) {
+		lmdb_read_txn_end(lmdb);
+	}
+
+	if (lmdb->error != MDB_SUCCESS) {
+		ldb_mdb_error(lmdb->ldb, lmdb->error);
+		return -1;
+	}
+	return count;
+}
+
+static int lmdb_update_in_iterate(struct ltdb_private *ltdb,
+				  struct ldb_val key,
+				  struct ldb_val key2,
+				  struct ldb_val data,
+				  void *state)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	struct ltdb_reindex_context *ctx =
+		(struct ltdb_reindex_context *)state;
+	struct ldb_val copy;
+	int ret;
+
+	/*
+	 * The data points into the LMDB map, which may be re-used as
+	 * soon as the old record is deleted, so take a copy first.
+	 */
+	copy.length = data.length;
+	copy.data = talloc_memdup(ltdb, data.data, data.length);
+	if (copy.data == NULL) {
+		ctx->error = ldb_oom(lmdb->ldb);
+		return -1;
+	}
+
+	ret = lmdb_delete(ltdb, key);
+	if (ret != LDB_SUCCESS) {
+		ldb_debug(lmdb->ldb, LDB_DEBUG_ERROR,
+			  "Failed to delete %*.*s "
+			  "for rekey as %*.*s: %s",
+			  (int)key.length, (int)key.length,
+			  (const char *)key.data,
+			  (int)key2.length, (int)key2.length,
+			  (const char *)key2.data,
+			  mdb_strerror(lmdb->error));
+		ctx->error = ret;
+		talloc_free(copy.data);
+		return -1;
+	}
+
+	ret = lmdb_store(ltdb, key2, copy, 0);
+	talloc_free(copy.data);
+	if (ret != LDB_SUCCESS) {
+		ldb_debug(lmdb->ldb, LDB_DEBUG_ERROR,
+			  "Failed to rekey %*.*s as %*.*s: %s",
+			  (int)key.length, (int)key.length,
+			  (const char *)key.data,
+			  (int)key2.length, (int)key2.length,
+			  (const char *)key2.data,
+			  mdb_strerror(lmdb->error));
+		ctx->error = ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Handles only a single record */
+static int lmdb_parse_record(struct ltdb_private *ltdb, struct ldb_val key,
+			     int (*parser)(struct ldb_val key,
+					   struct ldb_val data,
+					   void *private_data),
+			     void *ctx)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	MDB_val mdb_key;
+	MDB_val mdb_data;
+	MDB_txn *txn = NULL;
+	bool own_read_txn = false;
+	struct ldb_val data;
+	int ret;
+
+	/*
+	 * LMDB can not hold a key longer than this, so there is no
+	 * such record
+	 */
+	if (key.length > (size_t)mdb_env_get_maxkeysize(lmdb->env)) {
+		return LDB_ERR_NO_SUCH_OBJECT;
+	}
+
+	txn = get_current_txn(lmdb);
+	if (txn == NULL) {
+		lmdb->error = lmdb_read_txn_begin(lmdb);
+		if (lmdb->error != MDB_SUCCESS) {
+			return ldb_mdb_error(lmdb->ldb, lmdb->error);
+		}
+		own_read_txn = true;
+		txn = lmdb->read_txn;
+	}
+
+	mdb_key.mv_size = key.length;
+	mdb_key.mv_data = key.data;
+
+	lmdb->error = mdb_get(txn, lmdb->dbi, &mdb_key, &mdb_data);
+	if (lmdb->error != MDB_SUCCESS) {
+		if (own_read_txn) {
+			lmdb_read_txn_end(lmdb);
+		}
+		if (lmdb->error == MDB_NOTFOUND) {
+			return LDB_ERR_NO_SUCH_OBJECT;
+		}
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+	data.data = mdb_data.mv_data;
+	data.length = mdb_data.mv_size;
+
+	/*
+	 * The data is only valid until the end of the transaction,
+	 * so it must be parsed before our own snapshot is released
+	 */
+	ret = parser(key, data, ctx);
+
+	if (own_read_txn) {
+		lmdb_read_txn_end(lmdb);
+	}
+	return ret;
+}
+
+static int lmdb_lock_read(struct ldb_module *module)
+{
+	void *data = ldb_module_get_private(module);
+	struct ltdb_private *ltdb = talloc_get_type(data, struct ltdb_private);
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+
+	if (ltdb->in_transaction == 0 &&
+	    ltdb->read_lock_count == 0) {
+		lmdb->error = lmdb_read_txn_begin(lmdb);
+		if (lmdb->error != MDB_SUCCESS) {
+			return ldb_mdb_error(lmdb->ldb, lmdb->error);
+		}
+	}
+	ltdb->read_lock_count++;
+	return LDB_SUCCESS;
+}
+
+static int lmdb_unlock_read(struct ldb_module *module)
+{
+	void *data = ldb_module_get_private(module);
+	struct ltdb_private *ltdb = talloc_get_type(data, struct ltdb_private);
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+
+	/*
+	 * The read transaction may have been started before a write
+	 * transaction, end it with the last read lock so it does not
+	 * keep an old snapshot pinned.
+	 */
+	if (ltdb->read_lock_count == 1) {
+		lmdb_read_txn_end(lmdb);
+	}
+	ltdb->read_lock_count--;
+	return LDB_SUCCESS;
+}
+
+static int lmdb_transaction_start(struct ltdb_private *ltdb)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	struct lmdb_trans *ltx;
+	struct lmdb_trans *ltx_head;
+	MDB_txn *tx_parent;
+
+	if (!lmdb_pvt_check_pid(lmdb)) {
+		return LDB_ERR_PROTOCOL_ERROR;
+	}
+
+	ltx = talloc_zero(lmdb, struct lmdb_trans);
+	if (ltx == NULL) {
+		return ldb_oom(lmdb->ldb);
+	}
+
+	ltx_head = lmdb->txlist;
+	tx_parent = lmdb_trans_get_tx(ltx_head);
+
+	/* Nested transactions are child transactions in LMDB */
+	lmdb->error = mdb_txn_begin(lmdb->env, tx_parent, 0, &ltx->tx);
+	if (lmdb->error != MDB_SUCCESS) {
+		talloc_free(ltx);
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+
+	DLIST_ADD(lmdb->txlist, ltx);
+
+	return ldb_mdb_err_map(lmdb->error);
+}
+
+static int lmdb_transaction_cancel(struct ltdb_private *ltdb)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	struct lmdb_trans *ltx = lmdb->txlist;
+
+	if (ltx == NULL) {
+		ldb_set_errstring(lmdb->ldb, "No transaction to cancel");
+		lmdb->error = EINVAL;
+		return ldb_mdb_err_map(lmdb->error);
+	}
+
+	mdb_txn_abort(ltx->tx);
+	DLIST_REMOVE(lmdb->txlist, ltx);
+	talloc_free(ltx);
+	lmdb->error = MDB_SUCCESS;
+	return LDB_SUCCESS;
+}
+
+static int lmdb_transaction_prepare_commit(struct ltdb_private *ltdb)
+{
+	/*
+	 * LMDB commits atomically in mdb_txn_commit(), there is no
+	 * separate prepare phase
+	 */
+	return LDB_SUCCESS;
+}
+
+static int lmdb_transaction_commit(struct ltdb_private *ltdb)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	struct lmdb_trans *ltx = lmdb->txlist;
+
+	if (ltx == NULL) {
+		ldb_set_errstring(lmdb->ldb, "No transaction to commit");
+		lmdb->error = EINVAL;
+		return ldb_mdb_err_map(lmdb->error);
+	}
+
+	lmdb->error = mdb_txn_commit(ltx->tx);
+	DLIST_REMOVE(lmdb->txlist, ltx);
+	talloc_free(ltx);
+
+	if (lmdb->error != MDB_SUCCESS) {
+		return ldb_mdb_error(lmdb->ldb, lmdb->error);
+	}
+	return LDB_SUCCESS;
+}
+
+static int lmdb_error(struct ltdb_private *ltdb)
+{
+	return ldb_mdb_err_map(ltdb->lmdb_private->error);
+}
+
+static const char *lmdb_errorstr(struct ltdb_private *ltdb)
+{
+	return mdb_strerror(ltdb->lmdb_private->error);
+}
+
+static const char *lmdb_name(struct ltdb_private *ltdb)
+{
+	const char *path = NULL;
+
+	if (mdb_env_get_path(ltdb->lmdb_private->env, &path) != MDB_SUCCESS) {
+		return "lmdb";
+	}
+	return path;
+}
+
+/*
+  Every committed write transaction bumps the LMDB transaction id,
+  which makes it an exact equivalent of the tdb sequence number.
+*/
+static bool lmdb_changed(struct ltdb_private *ltdb)
+{
+	struct lmdb_private *lmdb = ltdb->lmdb_private;
+	MDB_envinfo info;
+	bool has_changed;
+
+	/*
+	 * Our own uncommitted changes are not reflected in the
+	 * environment, so always re-check inside a transaction
+	 */
+	if (lmdb->txlist != NULL) {
+		return true;
+	}
+
+	/*
+	 * Under a read lock we see the snapshot of the read
+	 * transaction, which may be older than the last commit
+	 */
+	if (lmdb->read_txn_active) {
+		info.me_last_txnid = mdb_txn_id(lmdb->read_txn);
+	} else if (mdb_env_info(lmdb->env, &info) != MDB_SUCCESS) {
+		return true;
+	}
+
+	has_changed = (info.me_last_txnid != lmdb->last_txnid);
+	lmdb->last_txnid = info.me_last_txnid;
+
+	return has_changed;
+}
+
+static const struct kv_db_ops lmdb_key_value_ops = {
+	.store              = lmdb_store,
+	.delete             = lmdb_delete,
+	.iterate            = lmdb_traverse_fn,
+	.update_in_iterate  = lmdb_update_in_iterate,
+	.fetch_and_parse    = lmdb_parse_record,
+	.lock_read          = lmdb_lock_read,
+	.unlock_read        = lmdb_unlock_read,
+	.begin_write        = lmdb_transaction_start,
+	.prepare_write      = lmdb_transaction_prepare_commit,
+	.finish_write       = lmdb_transaction_commit,
+	.abort_write        = lmdb_transaction_cancel,
+	.error              = lmdb_error,
+	.errorstr           = lmdb_errorstr,
+	.name               = lmdb_name,
+	.has_changed        = lmdb_changed,
+};
+
+static const char *lmdb_get_path(const char *url)
+{
+	const char *path;
+
+	/* parse the url */
+	if (strchr(url, ':')) {
+		if (strncmp(url, MDB_URL_PREFIX, MDB_URL_PREFIX_SIZE) != 0) {
+			return NULL;
+		}
+		path = url + MDB_URL_PREFIX_SIZE;
+	} else {
+		path = url;
+	}
+
+	return path;
+}
+
+/*
+  Like the tdb backend, an LMDB database must only be opened once in
+  a process: LMDB keeps its reader table and locks per environment.
+  Connections to the same file share the environment.
+*/
+struct mdb_env_wrap {
+	struct mdb_env_wrap *next, *prev;
+	dev_t device;
+	ino_t inode;
+	MDB_env *env;
+	pid_t pid;
+};
+
+static struct mdb_env_wrap *mdb_list;
+
+/* destroy the last connection to an mdb */
+static int mdb_env_wrap_destructor(struct mdb_env_wrap *w)
+{
+	mdb_env_close(w->env);
+	DLIST_REMOVE(mdb_list, w);
+	return 0;
+}
+
+static int lmdb_open_env(TALLOC_CTX *mem_ctx,
+			 MDB_env **env,
+			 struct ldb_context *ldb,
+			 const char *path,
+			 size_t map_size,
+			 unsigned int flags)
+{
+	int ret;
+	unsigned int mdb_flags = MDB_NOSUBDIR|MDB_NOTLS;
+	/*
+	 * MDB_NOSUBDIR implies there is a separate file called path and a
+	 * separate lockfile called path-lock
+	 */
+	struct mdb_env_wrap *w;
+	struct stat st;
+	pid_t pid = getpid();
+
+	if (stat(path, &st) == 0) {
+		for (w=mdb_list;w;w=w->next) {
+			if (st.st_dev == w->device &&
+			    st.st_ino == w->inode &&
+			    pid == w->pid) {
+				/*
+				 * We must have only one MDB_env per process
+				 */
+				if (!talloc_reference(mem_ctx, w)) {
+					return ldb_oom(ldb);
+				}
+				*env = w->env;
+				return LDB_SUCCESS;
+			}
+		}
+	}
+
+	w = talloc(mem_ctx, struct mdb_env_wrap);
+	if (w == NULL) {
+		return ldb_oom(ldb);
+	}
+
+	ret = mdb_env_create(env);
+	if (ret != 0) {
+		ldb_asprintf_errstring(
+			ldb,
+			"Could not create MDB environment %s: %s\n",
+			path,
+			mdb_strerror(ret));
+		talloc_free(w);
+		return ldb_mdb_err_map(ret);
+	}
+
+	ret = mdb_env_set_mapsize(*env, map_size);
+	if (ret != 0) {
+		ldb_asprintf_errstring(
+			ldb,
+			"Could not set MDB mmap() size to %llu on %s: %s\n",
+			(unsigned long long)map_size,
+			path,
+			mdb_strerror(ret));
+		mdb_env_close(*env);
+		talloc_free(w);
+		return ldb_mdb_err_map(ret);
+	}
+
+	mdb_env_set_maxreaders(*env, LDB_MDB_MAX_READERS);
+
+	/*
+	 * As we ensure that there is only one MDB_env open per
+	 * database per process, we can not use the MDB_RDONLY flag,
+	 * as another ldb may be opened in read write mode
+	 */
+	if (flags & LDB_FLG_NOSYNC) {
+		mdb_flags |= MDB_NOSYNC;
+	}
+	ret = mdb_env_open(*env, path, mdb_flags, 0644);
+	if (ret != 0) {
+		ldb_asprintf_errstring(ldb,
+				"Could not open DB %s: %s\n",
+				path, mdb_strerror(ret));
+		mdb_env_close(*env);
+		talloc_free(w);
+		return ldb_mdb_err_map(ret);
+	}
+
+	if (stat(path, &st) != 0) {
+		ldb_asprintf_errstring(
+			ldb,
+			"Could not stat %s:\n",
+			path);
+		mdb_env_close(*env);
+		talloc_free(w);
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+	w->env = *env;
+	w->device = st.st_dev;
+	w->inode  = st.st_ino;
+	w->pid = pid;
+
+	talloc_set_destructor(w, mdb_env_wrap_destructor);
+
+	DLIST_ADD(mdb_list, w);
+
+	return LDB_SUCCESS;
+}
+
+static int lmdb_pvt_open(struct lmdb_private *lmdb,
+			 struct ldb_context *ldb,
+			 const char *path,
+			 const char *options[],
+			 unsigned int flags)
+{
+	int ret;
+	size_t map_size = LDB_MDB_DEFAULT_MAP_SIZE;
+	const char *map_size_str;
+	MDB_txn *txn = NULL;
+
+	if (flags & LDB_FLG_DONT_CREATE_DB) {
+		struct stat st;
+		if (stat(path, &st) != 0) {
+			ldb_asprintf_errstring(ldb,
+					       "Unable to open mdb '%s': %s",
+					       path, strerror(errno));
+			return LDB_ERR_OPERATIONS_ERROR;
+		}
+	}
+
+	map_size_str = ldb_options_find(ldb, options, "lmdb_env_size");
+	if (map_size_str != NULL) {
+		unsigned long long size = strtoull(map_size_str, NULL, 0);
+		if (size != 0) {
+			map_size = size;
+		}
+	}
+
+	ret = lmdb_open_env(lmdb, &lmdb->env, ldb, path, map_size, flags);
+	if (ret != 0) {
+		return ret;
+	}
+
+	/*
+	 * Open the (unnamed) main database once, the handle is reused.
+	 * A read transaction is enough for that, and unlike a write
+	 * transaction it does not block while another process is in a
+	 * transaction on the database.
+	 */
+	ret = mdb_txn_begin(lmdb->env, NULL, MDB_RDONLY, &txn);
+	if (ret != 0) {
+		return ldb_mdb_error(ldb, ret);
+	}
+	ret = mdb_dbi_open(txn, NULL, 0, &lmdb->dbi);
+	if (ret != 0) {
+		mdb_txn_abort(txn);
+		return ldb_mdb_error(ldb, ret);
+	}
+	ret = mdb_txn_commit(txn);
+	if (ret != 0) {
+		return ldb_mdb_error(ldb, ret);
+	}
+
+	/* Store the original pid during the LMDB open */
+	lmdb->pid = getpid();
+
+	return LDB_SUCCESS;
+}
+
+static int lmdb_pvt_destructor(struct lmdb_private *lmdb)
+{
+	struct lmdb_trans *ltx = NULL;
+
+	/* Don't touch the environment of another process */
+	if (lmdb->pid != getpid()) {
+		return 0;
+	}
+
+	/*
+	 * Close the read transaction if it's open
+	 */
+	if (lmdb->read_txn != NULL) {
+		mdb_txn_abort(lmdb->read_txn);
+		lmdb->read_txn = NULL;
+		lmdb->read_txn_active = false;
+	}
+
+	/*
+	 * Abort any currently active transactions, innermost first
+	 */
+	ltx = lmdb->txlist;
+	while (ltx != NULL) {
+		struct lmdb_trans *next = ltx->next;
+		mdb_txn_abort(ltx->tx);
+		DLIST_REMOVE(lmdb->txlist, ltx);
+		talloc_free(ltx);
+		ltx = next;
+	}
+
+	return 0;
+}
+
+int lmdb_connect(struct ldb_context *ldb,
+		 const char *url,
+		 unsigned int flags,
+		 const char *options[],
+		 struct ldb_module **_module)
+{
+	const char *path = NULL;
+	struct lmdb_private *lmdb = NULL;
+	struct ltdb_private *ltdb = NULL;
+	int ret;
+
+	/*
+	 * We hold locks, so we must use a private event context
+	 * on each returned handle
+	 */
+	ldb_set_require_private_event_context(ldb);
+
+	path = lmdb_get_path(url);
+	if (path == NULL) {
+		ldb_debug(ldb, LDB_DEBUG_ERROR, "Invalid mdb URL '%s'", url);
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	ltdb = talloc_zero(ldb, struct ltdb_private);
+	if (!ltdb) {
+		ldb_oom(ldb);
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	lmdb = talloc_zero(ltdb, struct lmdb_private);
+	if (lmdb == NULL) {
+		TALLOC_FREE(ltdb);
+		return ldb_oom(ldb);
+	}
+	lmdb->ldb = ldb;
+	ltdb->kv_ops = &lmdb_key_value_ops;
+
+	ret = lmdb_pvt_open(lmdb, ldb, path, options, flags);
+	if (ret != LDB_SUCCESS) {
+		ldb_debug(ldb, LDB_DEBUG_ERROR,
+			  "Unable to open mdb '%s': %s", path,
+			  ldb_errstring(ldb));
+		TALLOC_FREE(ltdb);
+		return ret;
+	}
+	talloc_set_destructor(lmdb, lmdb_pvt_destructor);
+
+	ltdb->lmdb_private = lmdb;
+	if (flags & LDB_FLG_RDONLY) {
+		ltdb->read_only = true;
+	}
+
+	/*
+	 * Index keys longer than this are truncated, as with the
+	 * max_key_len_for_self_test option on tdb
+	 */
+	ltdb->max_key_length = mdb_env_get_maxkeysize(lmdb->env);
+
+	return init_store(ltdb, "ldb_mdb backend", ldb, options, _module);
+}
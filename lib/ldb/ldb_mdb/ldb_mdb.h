@@ -0,0 +1,76 @@
+/*
+   ldb database library using the LMDB key value store
+
+     ** NOTE! The following LGPL license applies to the ldb
+     ** library. This does NOT imply that all of Samba is released
+     ** under the LGPL
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 3 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _LDB_MDB_H_
+#define _LDB_MDB_H_
+
+#include "ldb_private.h"
+#include <lmdb.h>
+
+/*
+ * The default size of the memory map.  LMDB needs the maximum size of
+ * the database up front, but the file only grows as records are
+ * written, so this can comfortably exceed the 4GB limit of a tdb.
+ */
+#if SIZE_MAX > 0xFFFFFFFFUL
+#define LDB_MDB_DEFAULT_MAP_SIZE ((size_t)8 * 1024 * 1024 * 1024)
+#else
+#define LDB_MDB_DEFAULT_MAP_SIZE ((size_t)1024 * 1024 * 1024)
+#endif
+
+struct lmdb_private {
+	struct ldb_context *ldb;
+	MDB_env *env;
+	MDB_dbi dbi;
+
+	/* stack of nested write transactions, innermost first */
+	struct lmdb_trans *txlist;
+
+	/*
+	 * The read transaction is kept between searches and only
+	 * reset, so that taking a read lock is just a renew.
+	 */
+	MDB_txn *read_txn;
+	bool read_txn_active;
+
+	/* last raw LMDB (or errno) error */
+	int error;
+
+	/* the last committed LMDB transaction id we loaded the cache at */
+	size_t last_txnid;
+
+	/* an LMDB environment must not be used across a fork() */
+	pid_t pid;
+};
+
+struct lmdb_trans {
+	struct lmdb_trans *next;
+	struct lmdb_trans *prev;
+
+	MDB_txn *tx;
+};
+
+int ldb_mdb_err_map(int lmdb_err);
+int lmdb_connect(struct ldb_context *ldb, const char *url,
+		 unsigned int flags, const char *options[],
+		 struct ldb_module **_module);
+
+#endif /* _LDB_MDB_H_ */
@@ -33,6 +33,7 @@
 
 #include "ldb_tdb.h"
 #include "ldb_private.h"
+#include "dlinklist.h"
 
 #define LTDB_FLAG_CASE_INSENSITIVE (1<<0)
 #define LTDB_FLAG_INTEGER          (1<<1)
@@ -230,6 +231,24 @@ failed:
 	return -1;
 }
 
+/*
+  choose the ldb_pack format for new records from the @PACK_FORMAT
+  attribute of @INDEXLIST.  Databases without it keep the original
+  format, so they stay readable by older versions.
+*/
+static void ltdb_pack_format_load(struct ltdb_private *ltdb,
+				  const struct ldb_message *indexlist)
+{
+	unsigned int version
+		= ldb_msg_find_attr_as_uint(indexlist, LTDB_PACK_FORMAT, 1);
+
+	if (version == 2) {
+		ltdb->cache->pack_format_version = LDB_PACKING_FORMAT_V2;
+	} else {
+		ltdb->cache->pack_format_version = LDB_PACKING_FORMAT;
+	}
+}
+
 /*
   register any index records we find for the DB
 */
@@ -241,6 +260,8 @@ static int ltdb_index_load(struct ldb_module *module,
 	int r;
 
 	if (ldb->schema.index_handler_override) {
+		struct ldb_message *indexlist = NULL;
+
 		/*
 		 * we skip loading the @INDEXLIST record when a module is
 		 * supplying its own attribute handling
@@ -251,6 +272,28 @@ static int ltdb_index_load(struct ldb_module *module,
 			= ldb->schema.GUID_index_attribute;
 		ltdb->cache->GUID_index_dn_component
 			= ldb->schema.GUID_index_dn_component;
+
+		/*
+		 * but the pack format is still a property of this
+		 * database
+		 */
+		indexlist = ldb_msg_new(ltdb);
+		if (indexlist == NULL) {
+			return -1;
+		}
+		indexlist_dn = ldb_dn_new(indexlist, ldb, LTDB_INDEXLIST);
+		if (indexlist_dn == NULL) {
+			TALLOC_FREE(indexlist);
+			return -1;
+		}
+		r = ltdb_search_dn1(module, indexlist_dn, indexlist,
+				    LDB_UNPACK_DATA_FLAG_NO_DN);
+		if (r != LDB_SUCCESS && r != LDB_ERR_NO_SUCH_OBJECT) {
+			TALLOC_FREE(indexlist);
+			return -1;
+		}
+		ltdb_pack_format_load(ltdb, indexlist);
+		TALLOC_FREE(indexlist);
 		return 0;
 	}
 
@@ -284,12 +327,19 @@ static int ltdb_index_load(struct ldb_module *module,
 	if (ldb_msg_find_element(ltdb->cache->indexlist, LTDB_IDXATTR) != NULL) {
 		ltdb->cache->attribute_indexes = true;
 	}
+	if (ldb_msg_find_element(ltdb->cache->indexlist, LTDB_IDXORDERED) != NULL) {
+		ltdb->cache->attribute_indexes = true;
+	}
+	if (ldb_msg_find_element(ltdb->cache->indexlist, LTDB_IDXPREFIX) != NULL) {
+		ltdb->cache->attribute_indexes = true;
+	}
 	ltdb->cache->GUID_index_attribute
 		= ldb_msg_find_attr_as_string(ltdb->cache->indexlist,
 					      LTDB_IDXGUID, NULL);
 	ltdb->cache->GUID_index_dn_component
 		= ldb_msg_find_attr_as_string(ltdb->cache->indexlist,
 					      LTDB_IDX_DN_GUID, NULL);
+	ltdb_pack_format_load(ltdb, ltdb->cache->indexlist);
 
 	return 0;
 }
@@ -395,6 +445,9 @@ int ltdb_cache_load(struct ldb_module *module)
 		return 0;
 	}
 
+	/* any cached record may now be out of date */
+	ltdb_obj_cache_flush(ltdb);
+
 	if (ltdb->cache == NULL) {
 		ltdb->cache = talloc_zero(ltdb, struct ltdb_cache);
 		if (ltdb->cache == NULL) goto failed;
@@ -612,3 +665,306 @@ int ltdb_check_at_attributes_values(const struct ldb_val *value)
 	return -1;
 }
 
+
+static int ltdb_obj_cache_destructor(struct ltdb_obj_cache *cache)
+{
+	ldb_debug(cache->ldb, LDB_DEBUG_TRACE,
+		  "ldb_tdb object cache: %llu hits, %llu misses",
+		  (unsigned long long)cache->hits,
+		  (unsigned long long)cache->misses);
+	return 0;
+}
+
+/*
+  set up the cache of unpacked records, holding at most max_entries
+  objects.  A max_entries of 0 disables it.
+*/
+int ltdb_obj_cache_init(struct ldb_context *ldb,
+			struct ltdb_private *ltdb,
+			unsigned int max_entries)
+{
+	struct ltdb_obj_cache *cache = NULL;
+
+	TALLOC_FREE(ltdb->obj_cache);
+	if (max_entries == 0) {
+		return 0;
+	}
+
+	cache = talloc_zero(ltdb, struct ltdb_obj_cache);
+	if (cache == NULL) {
+		return -1;
+	}
+	cache->ldb = ldb;
+	cache->max_entries = max_entries;
+	cache->num_buckets = max_entries;
+	cache->buckets = talloc_zero_array(cache,
+					   struct ltdb_obj_cache_entry *,
+					   cache->num_buckets);
+	if (cache->buckets == NULL) {
+		talloc_free(cache);
+		return -1;
+	}
+
+	talloc_set_destructor(cache, ltdb_obj_cache_destructor);
+	ltdb->obj_cache = cache;
+	return 0;
+}
+
+static void ltdb_obj_cache_remove(struct ltdb_obj_cache *cache,
+				  struct ltdb_obj_cache_entry *entry)
+{
+	struct ltdb_obj_cache_entry **pp =
+		&cache->buckets[entry->hash % cache->num_buckets];
+
+	while (*pp != entry) {
+		pp = &(*pp)->hash_next;
+	}
+	*pp = entry->hash_next;
+
+	DLIST_REMOVE(cache->lru, entry);
+	cache->num_entries--;
+	talloc_free(entry);
+}
+
+/*
+  forget every cached record, as the database has changed
+*/
+void ltdb_obj_cache_flush(struct ltdb_private *ltdb)
+{
+	struct ltdb_obj_cache *cache = ltdb->obj_cache;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	while (cache->lru != NULL) {
+		ltdb_obj_cache_remove(cache, cache->lru);
+	}
+}
+
+/*
+  The cache only holds normal records, looked up outside a
+  transaction, for callers that accept values pointing into a copy of
+  the packed record (LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC).  Inside a
+  transaction our own uncommitted changes would not be seen by the
+  sequence number check.
+*/
+static bool ltdb_obj_cache_usable(struct ltdb_private *ltdb,
+				  struct ldb_val key,
+				  unsigned int unpack_flags)
+{
+	if (ltdb->obj_cache == NULL) {
+		return false;
+	}
+	if (ltdb->in_transaction != 0) {
+		return false;
+	}
+	if (!(unpack_flags & LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC)) {
+		return false;
+	}
+	if (key.length > 4 && memcmp(key.data, "DN=@", 4) == 0) {
+		return false;
+	}
+	return true;
+}
+
+static unsigned int ltdb_obj_cache_hash(struct ldb_val key)
+{
+	TDB_DATA tdb_key = {
+		.dptr = key.data,
+		.dsize = key.length
+	};
+
+	return tdb_jenkins_hash(&tdb_key);
+}
+
+/*
+  fill in msg from a cached record, as ldb_unpack_data would with
+  unpack_flags
+*/
+static int ltdb_obj_cache_copy(const struct ltdb_obj_cache_entry *entry,
+			       struct ldb_message *msg,
+			       unsigned int unpack_flags)
+{
+	const struct ldb_message *cached = entry->msg;
+	struct ldb_val *single_values = NULL;
+	uint8_t *data = NULL;
+	unsigned int i, j;
+
+	msg->dn = NULL;
+	msg->num_elements = 0;
+	msg->elements = NULL;
+
+	if (!(unpack_flags & LDB_UNPACK_DATA_FLAG_NO_DN) &&
+	    cached->dn != NULL) {
+		msg->dn = ldb_dn_copy(msg, cached->dn);
+		if (msg->dn == NULL) {
+			return LDB_ERR_OPERATIONS_ERROR;
+		}
+	}
+
+	if ((unpack_flags & LDB_UNPACK_DATA_FLAG_NO_ATTRS) ||
+	    cached->num_elements == 0) {
+		return LDB_SUCCESS;
+	}
+
+	/*
+	 * As with any LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC unpack, the
+	 * names and values point into a copy of the packed record
+	 * owned by the message.
+	 */
+	data = talloc_memdup(msg, entry->data.data, entry->data.length);
+	if (data == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	msg->elements = talloc_array(msg, struct ldb_message_element,
+				     cached->num_elements);
+	if (msg->elements == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	if (unpack_flags & LDB_UNPACK_DATA_FLAG_NO_VALUES_ALLOC) {
+		single_values = talloc_array(msg->elements, struct ldb_val,
+					     cached->num_elements);
+		if (single_values == NULL) {
+			return LDB_ERR_OPERATIONS_ERROR;
+		}
+	}
+
+	for (i = 0; i < cached->num_elements; i++) {
+		const struct ldb_message_element *el = &cached->elements[i];
+		struct ldb_message_element *el2 = &msg->elements[i];
+
+		*el2 = *el;
+		el2->name = (const char *)data +
+			((const uint8_t *)el->name - entry->data.data);
+
+		if (single_values != NULL && el->num_values == 1) {
+			el2->values = &single_values[i];
+		} else {
+			el2->values = talloc_array(msg->elements,
+						   struct ldb_val,
+						   el->num_values);
+			if (el2->values == NULL) {
+				return LDB_ERR_OPERATIONS_ERROR;
+			}
+		}
+		for (j = 0; j < el->num_values; j++) {
+			el2->values[j].length = el->values[j].length;
+			el2->values[j].data = data +
+				(el->values[j].data - entry->data.data);
+		}
+	}
+	msg->num_elements = cached->num_elements;
+
+	return LDB_SUCCESS;
+}
+
+/*
+  look for a record in the cache, filling in msg on a hit
+
+  returns false if the record must be read from the database, and
+  true with the result in *ret otherwise
+*/
+bool ltdb_obj_cache_fetch(struct ltdb_private *ltdb,
+			  struct ldb_val key,
+			  struct ldb_message *msg,
+			  unsigned int unpack_flags,
+			  int *ret)
+{
+	struct ltdb_obj_cache *cache = ltdb->obj_cache;
+	struct ltdb_obj_cache_entry *entry = NULL;
+	unsigned int hash;
+
+	if (!ltdb_obj_cache_usable(ltdb, key, unpack_flags)) {
+		return false;
+	}
+
+	hash = ltdb_obj_cache_hash(key);
+	for (entry = cache->buckets[hash % cache->num_buckets];
+	     entry != NULL;
+	     entry = entry->hash_next) {
+		if (entry->hash == hash &&
+		    entry->key.length == key.length &&
+		    memcmp(entry->key.data, key.data, key.length) == 0) {
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		cache->misses++;
+		return false;
+	}
+
+	cache->hits++;
+	DLIST_PROMOTE(cache->lru, entry);
+
+	*ret = ltdb_obj_cache_copy(entry, msg, unpack_flags);
+	return true;
+}
+
+/*
+  unpack a record just read from the database into msg, keeping a
+  copy in the cache if it may be used
+*/
+int ltdb_obj_cache_add(struct ldb_module *module,
+		       struct ltdb_private *ltdb,
+		       struct ldb_val key,
+		       struct ldb_val data,
+		       struct ldb_message *msg,
+		       unsigned int unpack_flags)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	struct ltdb_obj_cache *cache = ltdb->obj_cache;
+	struct ltdb_obj_cache_entry *entry = NULL;
+	int ret;
+
+	if (!ltdb_obj_cache_usable(ltdb, key, unpack_flags)) {
+		return LDB_ERR_UNWILLING_TO_PERFORM;
+	}
+
+	entry = talloc_zero(cache, struct ltdb_obj_cache_entry);
+	if (entry == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+	entry->hash = ltdb_obj_cache_hash(key);
+	entry->key.data = talloc_memdup(entry, key.data, key.length);
+	entry->key.length = key.length;
+	entry->data.data = talloc_memdup(entry, data.data, data.length);
+	entry->data.length = data.length;
+	entry->msg = ldb_msg_new(entry);
+	if (entry->key.data == NULL ||
+	    entry->data.data == NULL ||
+	    entry->msg == NULL) {
+		talloc_free(entry);
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	ret = ldb_unpack_data_only_attr_list_flags(ldb, &entry->data,
+						   entry->msg,
+						   NULL, 0,
+						   LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC,
+						   NULL);
+	if (ret == -1) {
+		talloc_free(entry);
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	ret = ltdb_obj_cache_copy(entry, msg, unpack_flags);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(entry);
+		return ret;
+	}
+
+	if (cache->num_entries >= cache->max_entries) {
+		ltdb_obj_cache_remove(cache, DLIST_TAIL(cache->lru));
+	}
+
+	entry->hash_next = cache->buckets[entry->hash % cache->num_buckets];
+	cache->buckets[entry->hash % cache->num_buckets] = entry;
+	DLIST_ADD(cache->lru, entry);
+	cache->num_entries++;
+
+	return LDB_SUCCESS;
+}
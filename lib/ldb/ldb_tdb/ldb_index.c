@@ -122,6 +122,70 @@ dn: @INDEXLIST
 @IDXATTR: nETBIOSName
 
 
+Ordered indexes for >= and <= searches
+---------------------------------------
+
+@IDXORDERED controls if an attribute has an ordered index.  Only
+attributes with an INTEGER or time syntax can be ordered, and
+the attribute does not also need to be in @IDXATTR.
+
+dn: @INDEXLIST
+@IDXORDERED: uSNChanged
+@IDXORDERED: whenChanged
+
+The TDB has no key order, so each value is mapped to a 64-bit integer
+and the integers are grouped into buckets.  Each bucket is an ordinary
+index record with the bucket number as 16 upper-case hex digits (with
+the sign bit flipped, so the string sorts in numeric order):
+
+dn: @INDEX:@IDXORDERED:USNCHANGED:8000000000000004
+@IDXVERSION: 3
+@IDX: <binary GUID>[<binary GUID>[...]]
+
+A list of the buckets in use is held in a directory record, which
+uses the same format, with the 16-byte bucket strings as the values:
+
+dn: @INDEX:@IDXORDERED:USNCHANGED
+@IDXVERSION: 3
+@IDX: 80000000000000008000000000000001...
+
+A range search loads the directory, then the union of the buckets in
+range.  The buckets at the edge of the range hold some values outside
+it, these are removed by ltdb_index_filter() as usual.
+
+When ldb_schema_set_override_indexlist() is in use, an ordered
+index is selected by LDB_ATTR_FLAG_ORDERED_INDEX instead.
+
+
+Prefix indexes for initial substring searches
+---------------------------------------------
+
+@IDXPREFIX controls if an attribute has a prefix index, used for
+searches such as (displayName=foo*) and the ANR filters built by
+Samba.  Any syntax can have a prefix index, and the attribute does
+not also need to be in @IDXATTR.
+
+dn: @INDEXLIST
+@IDXPREFIX: displayName
+@IDXPREFIX: sn
+
+Each value is canonicalised and indexed under its first
+LTDB_PREFIX_INDEX_LEN (3) bytes, or the whole value if it is
+shorter.  The key is base64 encoded (with "::") as for @IDXATTR:
+
+dn: @INDEX:@IDXPREFIX:DISPLAYNAME:FOO
+@IDXVERSION: 3
+@IDX: <binary GUID>[<binary GUID>[...]]
+
+A search with an initial substring of at least LTDB_PREFIX_INDEX_LEN
+bytes loads the one matching record, the rest of the filter is
+checked by ltdb_index_filter() as usual.  Shorter initial substrings,
+and substring searches without an initial part, need a full search.
+
+When ldb_schema_set_override_indexlist() is in use, a prefix index is
+selected by LDB_ATTR_FLAG_PREFIX_INDEX instead.
+
+
 C Override functions
 --------------------
 
@@ -163,6 +227,13 @@ struct dn_list {
 struct ltdb_idxptr {
 	struct tdb_context *itdb;
 	int error;
+	/*
+	 * Set while ltdb_reindex() rebuilds every index.  Values are
+	 * appended to the GUID index lists without keeping them
+	 * sorted, and ltdb_index_bulk_sort() sorts each list once
+	 * when the rebuild is complete.
+	 */
+	bool bulk;
 };
 
 enum key_truncation {
@@ -189,6 +260,9 @@ static void ltdb_dn_list_sort(struct ltdb_private *ltdb,
 
 #define LTDB_GUID_INDEXING_VERSION 3
 
+/* the hash size of the in-memory index TDB used by ltdb_reindex() */
+#define LTDB_REINDEX_HASH_SIZE 100003
+
 static unsigned ltdb_max_key_length(struct ltdb_private *ltdb) {
 	if (ltdb->max_key_length == 0){
 		return UINT_MAX;
@@ -208,6 +282,14 @@ int ltdb_index_transaction_start(struct ldb_module *module)
 	return LDB_SUCCESS;
 }
 
+/*
+  are we rebuilding all the indexes in ltdb_reindex()?
+*/
+static bool ltdb_index_bulk(struct ltdb_private *ltdb)
+{
+	return ltdb->idxptr != NULL && ltdb->idxptr->bulk;
+}
+
 /*
   see if two ldb_val structures contain exactly the same data
   return -1 or 1 for a mismatch, 0 for match
@@ -784,6 +866,58 @@ static int ltdb_index_traverse_store(struct tdb_context *tdb, TDB_DATA key, TDB_
 	return 0;
 }
 
+/*
+  traverse function sorting an in-memory index list built by
+  ltdb_reindex() into the order a GUID index is kept in
+ */
+static int ltdb_index_traverse_sort(struct tdb_context *tdb, TDB_DATA key, TDB_DATA data, void *state)
+{
+	struct ldb_module *module = state;
+	struct ltdb_private *ltdb = talloc_get_type(ldb_module_get_private(module), struct ltdb_private);
+	struct dn_list *list;
+
+	list = ltdb_index_idxptr(module, data, true);
+	if (list == NULL) {
+		ltdb->idxptr->error = LDB_ERR_OPERATIONS_ERROR;
+		return -1;
+	}
+
+	if (list->count > 1) {
+		TYPESAFE_QSORT(list->dn, list->count,
+			       ldb_val_equal_exact_for_qsort);
+	}
+	return 0;
+}
+
+/*
+  finish the bulk mode of ltdb_reindex(), sorting every list it built
+  once rather than keeping each one sorted as values are added
+ */
+static int ltdb_index_bulk_sort(struct ldb_module *module,
+				struct ltdb_private *ltdb)
+{
+	int ret;
+
+	ltdb->idxptr->bulk = false;
+
+	if (ltdb->cache->GUID_index_attribute == NULL ||
+	    ltdb->idxptr->itdb == NULL) {
+		return LDB_SUCCESS;
+	}
+
+	ret = tdb_traverse(ltdb->idxptr->itdb, ltdb_index_traverse_sort,
+			   module);
+	if (ret < 0) {
+		ret = ltdb->idxptr->error;
+		ltdb->idxptr->error = LDB_SUCCESS;
+		if (ret == LDB_SUCCESS) {
+			ret = LDB_ERR_OPERATIONS_ERROR;
+		}
+		return ret;
+	}
+	return LDB_SUCCESS;
+}
+
 /* cleanup the idxptr mode when transaction commits */
 int ltdb_index_transaction_commit(struct ldb_module *module)
 {
@@ -975,90 +1109,927 @@ static struct ldb_dn *ltdb_index_key(struct ldb_context *ldb,
 		}
 		talloc_free(vstr);
 	} else {
-		/* Only need two seperators */
-		num_separators = 2;
+		/* Only need two seperators */
+		num_separators = 2;
+
+		/*
+		 * Overflow here is not critical as we only use this
+		 * to choose the printf truncation
+		 */
+		key_len = num_separators + indx_len + attr_len + (int)v.length;
+		if (key_len > max_key_length) {
+			size_t excess = key_len - max_key_length;
+			frmt_len = v.length - excess;
+			*truncation = KEY_TRUNCATED;
+			/*
+			 * Truncated keys are placed in a separate key space
+			 * from the non truncated keys
+			 */
+			ret = ldb_dn_new_fmt(ldb, ldb, "%s#%s#%.*s",
+					     LTDB_INDEX, attr_for_dn,
+					     frmt_len, (char *)v.data);
+		} else {
+			frmt_len = v.length;
+			*truncation = KEY_NOT_TRUNCATED;
+			ret = ldb_dn_new_fmt(ldb, ldb, "%s:%s:%.*s",
+					     LTDB_INDEX, attr_for_dn,
+					     frmt_len, (char *)v.data);
+		}
+	}
+
+	if (v.data != value->data) {
+		talloc_free(v.data);
+	}
+	talloc_free(attr_folded);
+
+	return ret;
+}
+
+/*
+  see if a attribute value is in the list of indexed attributes
+*/
+static bool ltdb_is_indexed(struct ldb_module *module,
+			    struct ltdb_private *ltdb,
+			    const char *attr)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	unsigned int i;
+	struct ldb_message_element *el;
+
+	if ((ltdb->cache->GUID_index_attribute != NULL) &&
+	    (ldb_attr_cmp(attr,
+			  ltdb->cache->GUID_index_attribute) == 0)) {
+		/* Implicity covered, this is the index key */
+		return false;
+	}
+	if (ldb->schema.index_handler_override) {
+		const struct ldb_schema_attribute *a
+			= ldb_schema_attribute_by_name(ldb, attr);
+
+		if (a == NULL) {
+			return false;
+		}
+
+		if (a->flags & LDB_ATTR_FLAG_INDEXED) {
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	if (!ltdb->cache->attribute_indexes) {
+		return false;
+	}
+
+	el = ldb_msg_find_element(ltdb->cache->indexlist, LTDB_IDXATTR);
+	if (el == NULL) {
+		return false;
+	}
+
+	/* TODO: this is too expensive! At least use a binary search */
+	for (i=0; i<el->num_values; i++) {
+		if (ldb_attr_cmp((char *)el->values[i].data, attr) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+  see if an attribute is listed under idx_attr (eg @IDXORDERED) in
+  the @INDEXLIST record
+*/
+static bool ltdb_indexlist_has(struct ltdb_private *ltdb,
+			       const char *idx_attr,
+			       const char *attr)
+{
+	struct ldb_message_element *el;
+	unsigned int i;
+
+	if (!ltdb->cache->attribute_indexes) {
+		return false;
+	}
+	el = ldb_msg_find_element(ltdb->cache->indexlist, idx_attr);
+	if (el == NULL) {
+		return false;
+	}
+	for (i=0; i<el->num_values; i++) {
+		if (ldb_attr_cmp((char *)el->values[i].data, attr) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+  the number of low bits of an ordered value that share a bucket.
+  USNs are allocated densely, while times are in seconds and are
+  spread much more thinly
+*/
+#define LTDB_ORDERED_INTEGER_SHIFT 10
+#define LTDB_ORDERED_TIME_SHIFT 16
+
+/* length of a bucket name, the bucket number in hex */
+#define LTDB_ORDERED_BUCKET_LEN 16
+
+/*
+  return the bucket shift for an attribute syntax that can have an
+  ordered index, or 0 if it can not be ordered
+*/
+static unsigned int ltdb_ordered_syntax_shift(const struct ldb_schema_attribute *a)
+{
+	if (a->syntax->name == NULL) {
+		return 0;
+	}
+	if (strcmp(a->syntax->name, LDB_SYNTAX_INTEGER) == 0) {
+		return LTDB_ORDERED_INTEGER_SHIFT;
+	}
+	if (strcmp(a->syntax->name, LDB_SYNTAX_GENERALIZED_TIME) == 0 ||
+	    strcmp(a->syntax->name, LDB_SYNTAX_UTC_TIME) == 0) {
+		return LTDB_ORDERED_TIME_SHIFT;
+	}
+	return 0;
+}
+
+/*
+  see if a attribute has an ordered index, returning the schema
+  attribute if it does
+*/
+static const struct ldb_schema_attribute *ltdb_ordered_index_attr(
+	struct ldb_module *module,
+	struct ltdb_private *ltdb,
+	const char *attr)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	const struct ldb_schema_attribute *a;
+
+	if (attr[0] == '@') {
+		return NULL;
+	}
+	if ((ltdb->cache->GUID_index_attribute != NULL) &&
+	    (ldb_attr_cmp(attr,
+			  ltdb->cache->GUID_index_attribute) == 0)) {
+		return NULL;
+	}
+
+	if (ldb->schema.index_handler_override) {
+		a = ldb_schema_attribute_by_name(ldb, attr);
+		if (a == NULL ||
+		    !(a->flags & LDB_ATTR_FLAG_ORDERED_INDEX)) {
+			return NULL;
+		}
+	} else {
+		if (!ltdb_indexlist_has(ltdb, LTDB_IDXORDERED, attr)) {
+			return NULL;
+		}
+		a = ldb_schema_attribute_by_name(ldb, attr);
+		if (a == NULL) {
+			return NULL;
+		}
+	}
+
+	if (ltdb_ordered_syntax_shift(a) == 0) {
+		return NULL;
+	}
+	return a;
+}
+
+/*
+  work out the bucket name for a value of an ordered attribute.
+
+  Values are converted the same way as the INTEGER and time
+  comparison_fn() do, including taking a value that will not parse
+  as 0, so that the buckets sort in the same order as ldb_match()
+  compares.
+*/
+static void ltdb_ordered_bucket(const struct ldb_schema_attribute *a,
+				const struct ldb_val *value,
+				char bucket[LTDB_ORDERED_BUCKET_LEN + 1])
+{
+	unsigned int shift = ltdb_ordered_syntax_shift(a);
+	int64_t v = 0;
+	uint64_t b;
+
+	if (shift == LTDB_ORDERED_INTEGER_SHIFT) {
+		char buf[64];
+		if (value->length < sizeof(buf)) {
+			memcpy(buf, value->data, value->length);
+			buf[value->length] = '\0';
+			v = (int64_t)strtoll(buf, NULL, 0);
+		}
+	} else {
+		time_t t = 0;
+		ldb_val_to_time(value, &t);
+		v = t;
+	}
+
+	/*
+	 * The arithmetic shift keeps negative values below positive
+	 * ones, flipping the sign bit then makes the unsigned hex
+	 * string sort in the same order
+	 */
+	b = (uint64_t)(v >> shift) ^ 0x8000000000000000ULL;
+	snprintf(bucket, LTDB_ORDERED_BUCKET_LEN + 1,
+		 "%016llX", (unsigned long long)b);
+}
+
+/*
+  return the DN of an ordered index bucket, or of the bucket directory
+  if bucket is NULL
+*/
+static struct ldb_dn *ltdb_ordered_index_key(struct ldb_context *ldb,
+					     TALLOC_CTX *mem_ctx,
+					     const char *attr,
+					     const char *bucket)
+{
+	struct ldb_dn *dn;
+	char *attr_folded = ldb_attr_casefold(mem_ctx, attr);
+	if (attr_folded == NULL) {
+		return NULL;
+	}
+
+	if (bucket == NULL) {
+		dn = ldb_dn_new_fmt(mem_ctx, ldb, "%s:%s:%s",
+				    LTDB_INDEX, LTDB_IDXORDERED,
+				    attr_folded);
+	} else {
+		dn = ldb_dn_new_fmt(mem_ctx, ldb, "%s:%s:%s:%s",
+				    LTDB_INDEX, LTDB_IDXORDERED,
+				    attr_folded, bucket);
+	}
+	talloc_free(attr_folded);
+	return dn;
+}
+
+/*
+  add a value to a dn_list, keeping it sorted in the GUID index case.
+  Duplicates are kept, so that a multi-valued attribute with two
+  values in one bucket can have them removed one at a time
+*/
+static int ltdb_dn_list_add_val(struct ltdb_private *ltdb,
+				struct dn_list *list,
+				const struct ldb_val *v)
+{
+	struct ldb_val *exact = NULL, *next = NULL;
+	unsigned alloc_len;
+
+	alloc_len = ((list->count+1)+7) & ~7;
+	list->dn = talloc_realloc(list, list->dn, struct ldb_val, alloc_len);
+	if (list->dn == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	if (ltdb->cache->GUID_index_attribute != NULL &&
+	    !ltdb_index_bulk(ltdb)) {
+		BINARY_ARRAY_SEARCH_GTE(list->dn, list->count,
+					*v, ldb_val_equal_exact_ordered,
+					exact, next);
+	}
+	if (next == NULL) {
+		next = &list->dn[list->count];
+	} else {
+		memmove(&next[1], next,
+			sizeof(*next) * (list->count - (next - list->dn)));
+	}
+	*next = ldb_val_dup(list->dn, v);
+	if (next->data == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+	list->count++;
+	return LDB_SUCCESS;
+}
+
+/*
+  the value a message is listed under in an index, the DN or the GUID
+*/
+static int ltdb_index_msg_val(struct ldb_module *module,
+			      struct ltdb_private *ltdb,
+			      const struct ldb_message *msg,
+			      struct ldb_val *v)
+{
+	if (ltdb->cache->GUID_index_attribute == NULL) {
+		const char *dn_str = ldb_dn_get_linearized(msg->dn);
+		if (dn_str == NULL) {
+			return LDB_ERR_OPERATIONS_ERROR;
+		}
+		v->data = discard_const_p(uint8_t, dn_str);
+		v->length = strlen(dn_str);
+	} else {
+		const struct ldb_val *key_val
+			= ldb_msg_find_ldb_val(msg,
+					       ltdb->cache->GUID_index_attribute);
+		if (key_val == NULL ||
+		    key_val->length != LTDB_GUID_SIZE) {
+			return ldb_module_operr(module);
+		}
+		*v = *key_val;
+	}
+	return LDB_SUCCESS;
+}
+
+/*
+  sort a dn_list in the order list_intersect() and list_union() expect
+  and remove the duplicates
+*/
+static void ltdb_dn_list_unique(struct dn_list *list)
+{
+	unsigned int i, j;
+
+	if (list->count < 2) {
+		return;
+	}
+	TYPESAFE_QSORT(list->dn, list->count,
+		       ldb_val_equal_exact_for_qsort);
+	for (i = 1, j = 1; i < list->count; i++) {
+		if (ldb_val_equal_exact_for_qsort(&list->dn[i],
+						  &list->dn[j-1]) == 0) {
+			continue;
+		}
+		list->dn[j++] = list->dn[i];
+	}
+	list->count = j;
+}
+
+/*
+  remove the entry at index i of a dn_list
+*/
+static void ltdb_dn_list_remove(struct dn_list *list, unsigned int i)
+{
+	if (i != list->count - 1) {
+		memmove(&list->dn[i], &list->dn[i+1],
+			sizeof(list->dn[0])*(list->count - (i+1)));
+	}
+	list->count--;
+	if (list->count == 0) {
+		talloc_free(list->dn);
+		list->dn = NULL;
+	}
+}
+
+/*
+  add or remove a bucket in the directory of an ordered index
+*/
+static int ltdb_index_ordered_dir_modify(struct ldb_module *module,
+					 struct ltdb_private *ltdb,
+					 const char *attr,
+					 const char *bucket,
+					 bool add)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	struct ldb_dn *dn_key;
+	struct dn_list *list;
+	struct ldb_val v;
+	int ret, i;
+
+	list = talloc_zero(module, struct dn_list);
+	if (list == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	dn_key = ltdb_ordered_index_key(ldb, list, attr, NULL);
+	if (dn_key == NULL) {
+		talloc_free(list);
+		return ldb_module_oom(module);
+	}
+
+	ret = ltdb_dn_list_load(module, ltdb, dn_key, list);
+	if (ret != LDB_SUCCESS && ret != LDB_ERR_NO_SUCH_OBJECT) {
+		talloc_free(list);
+		return ret;
+	}
+
+	v.data = discard_const_p(uint8_t, bucket);
+	v.length = LTDB_ORDERED_BUCKET_LEN;
+
+	i = ltdb_dn_list_find_val(ltdb, list, &v);
+	if (add) {
+		if (i != -1) {
+			talloc_free(list);
+			return LDB_SUCCESS;
+		}
+		ret = ltdb_dn_list_add_val(ltdb, list, &v);
+		if (ret != LDB_SUCCESS) {
+			talloc_free(list);
+			return ret;
+		}
+	} else {
+		if (i == -1) {
+			talloc_free(list);
+			return LDB_SUCCESS;
+		}
+		ltdb_dn_list_remove(list, i);
+	}
+
+	ret = ltdb_dn_list_store(module, dn_key, list);
+	talloc_free(list);
+	return ret;
+}
+
+/*
+  add a value of a message to an ordered index
+*/
+static int ltdb_index_ordered_add1(struct ldb_module *module,
+				   struct ltdb_private *ltdb,
+				   const struct ldb_message *msg,
+				   const struct ldb_schema_attribute *a,
+				   const char *attr,
+				   const struct ldb_val *value)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	char bucket[LTDB_ORDERED_BUCKET_LEN + 1];
+	struct ldb_dn *dn_key;
+	struct dn_list *list;
+	struct ldb_val v;
+	bool new_bucket;
+	int ret;
+
+	ret = ltdb_index_msg_val(module, ltdb, msg, &v);
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
+	list = talloc_zero(module, struct dn_list);
+	if (list == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	ltdb_ordered_bucket(a, value, bucket);
+	dn_key = ltdb_ordered_index_key(ldb, list, attr, bucket);
+	if (dn_key == NULL) {
+		talloc_free(list);
+		return ldb_module_oom(module);
+	}
+
+	ret = ltdb_dn_list_load(module, ltdb, dn_key, list);
+	if (ret != LDB_SUCCESS && ret != LDB_ERR_NO_SUCH_OBJECT) {
+		talloc_free(list);
+		return ret;
+	}
+	new_bucket = (list->count == 0);
+
+	ret = ltdb_dn_list_add_val(ltdb, list, &v);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(list);
+		return ret;
+	}
+
+	ret = ltdb_dn_list_store(module, dn_key, list);
+	talloc_free(list);
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
+	if (new_bucket) {
+		ret = ltdb_index_ordered_dir_modify(module, ltdb,
+						    attr, bucket, true);
+	}
+	return ret;
+}
+
+/*
+  remove a value of a message from an ordered index
+*/
+static int ltdb_index_ordered_del1(struct ldb_module *module,
+				   struct ltdb_private *ltdb,
+				   const struct ldb_message *msg,
+				   const struct ldb_schema_attribute *a,
+				   const char *attr,
+				   const struct ldb_val *value)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	char bucket[LTDB_ORDERED_BUCKET_LEN + 1];
+	struct ldb_dn *dn_key;
+	struct dn_list *list;
+	int ret, i;
+
+	list = talloc_zero(module, struct dn_list);
+	if (list == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	ltdb_ordered_bucket(a, value, bucket);
+	dn_key = ltdb_ordered_index_key(ldb, list, attr, bucket);
+	if (dn_key == NULL) {
+		talloc_free(list);
+		return ldb_module_oom(module);
+	}
+
+	ret = ltdb_dn_list_load(module, ltdb, dn_key, list);
+	if (ret == LDB_ERR_NO_SUCH_OBJECT) {
+		talloc_free(list);
+		return LDB_SUCCESS;
+	}
+	if (ret != LDB_SUCCESS) {
+		talloc_free(list);
+		return ret;
+	}
+
+	i = ltdb_dn_list_find_msg(ltdb, list, msg);
+	if (i == -1) {
+		/* nothing to delete */
+		talloc_free(list);
+		return LDB_SUCCESS;
+	}
+	ltdb_dn_list_remove(list, i);
+
+	ret = ltdb_dn_list_store(module, dn_key, list);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(list);
+		return ret;
+	}
+
+	if (list->count == 0) {
+		ret = ltdb_index_ordered_dir_modify(module, ltdb,
+						    attr, bucket, false);
+	}
+	talloc_free(list);
+	return ret;
+}
+
+/*
+  return a list of dn's that might match a >= or <= search on an
+  attribute with an ordered index
+ */
+static int ltdb_index_dn_ordered(struct ldb_module *module,
+				 struct ltdb_private *ltdb,
+				 const struct ldb_parse_tree *tree,
+				 struct dn_list *list)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	const char *attr = tree->u.comparison.attr;
+	const struct ldb_schema_attribute *a;
+	char bound[LTDB_ORDERED_BUCKET_LEN + 1];
+	struct dn_list *dir;
+	struct ldb_dn *dn_key;
+	unsigned int i;
+	int ret;
+
+	list->dn = NULL;
+	list->count = 0;
+
+	a = ltdb_ordered_index_attr(module, ltdb, attr);
+	if (a == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	ltdb_ordered_bucket(a, &tree->u.comparison.value, bound);
+
+	dir = talloc_zero(list, struct dn_list);
+	if (dir == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	dn_key = ltdb_ordered_index_key(ldb, dir, attr, NULL);
+	if (dn_key == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	ret = ltdb_dn_list_load(module, ltdb, dn_key, dir);
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
+	/* Only needed in the DN index case */
+	ltdb_dn_list_sort(ltdb, dir);
+
+	for (i = 0; i < dir->count; i++) {
+		char bucket[LTDB_ORDERED_BUCKET_LEN + 1];
+		struct dn_list *bucket_list;
+		int cmp;
+
+		if (dir->dn[i].length != LTDB_ORDERED_BUCKET_LEN) {
+			return ldb_module_operr(module);
+		}
+		cmp = memcmp(dir->dn[i].data, bound, LTDB_ORDERED_BUCKET_LEN);
+		if (tree->operation == LDB_OP_GREATER && cmp < 0) {
+			continue;
+		}
+		if (tree->operation == LDB_OP_LESS && cmp > 0) {
+			break;
+		}
+
+		memcpy(bucket, dir->dn[i].data, LTDB_ORDERED_BUCKET_LEN);
+		bucket[LTDB_ORDERED_BUCKET_LEN] = '\0';
+
+		bucket_list = talloc_zero(dir, struct dn_list);
+		if (bucket_list == NULL) {
+			return ldb_module_oom(module);
+		}
+		dn_key = ltdb_ordered_index_key(ldb, bucket_list,
+						attr, bucket);
+		if (dn_key == NULL) {
+			return ldb_module_oom(module);
+		}
+		ret = ltdb_dn_list_load(module, ltdb, dn_key, bucket_list);
+		if (ret == LDB_ERR_NO_SUCH_OBJECT) {
+			continue;
+		}
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
+
+		list->dn = talloc_realloc(list, list->dn, struct ldb_val,
+					  list->count + bucket_list->count);
+		if (list->dn == NULL) {
+			return ldb_module_oom(module);
+		}
+		memcpy(&list->dn[list->count], bucket_list->dn,
+		       sizeof(list->dn[0]) * bucket_list->count);
+		list->count += bucket_list->count;
+	}
+
+	if (list->count == 0) {
+		return LDB_ERR_NO_SUCH_OBJECT;
+	}
+
+	/*
+	 * A record can be in more than one bucket (or twice in one
+	 * bucket) if the attribute is multi-valued.
+	 */
+	ltdb_dn_list_unique(list);
+
+	return LDB_SUCCESS;
+}
+
+/* the number of bytes of a canonical value used as its prefix key */
+#define LTDB_PREFIX_INDEX_LEN 3
+
+/*
+  see if a attribute has a prefix index, returning the schema
+  attribute if it does
+*/
+static const struct ldb_schema_attribute *ltdb_prefix_index_attr(
+	struct ldb_module *module,
+	struct ltdb_private *ltdb,
+	const char *attr)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	const struct ldb_schema_attribute *a;
+
+	if (attr[0] == '@') {
+		return NULL;
+	}
+	if ((ltdb->cache->GUID_index_attribute != NULL) &&
+	    (ldb_attr_cmp(attr,
+			  ltdb->cache->GUID_index_attribute) == 0)) {
+		return NULL;
+	}
+
+	if (ldb->schema.index_handler_override) {
+		a = ldb_schema_attribute_by_name(ldb, attr);
+		if (a == NULL ||
+		    !(a->flags & LDB_ATTR_FLAG_PREFIX_INDEX)) {
+			return NULL;
+		}
+		return a;
+	}
+
+	if (!ltdb_indexlist_has(ltdb, LTDB_IDXPREFIX, attr)) {
+		return NULL;
+	}
+	return ldb_schema_attribute_by_name(ldb, attr);
+}
+
+/*
+  return the DN of the prefix index record for a canonical value, which
+  is truncated to LTDB_PREFIX_INDEX_LEN bytes.
+*/
+static struct ldb_dn *ltdb_prefix_index_key(struct ldb_context *ldb,
+					    TALLOC_CTX *mem_ctx,
+					    const char *attr,
+					    const struct ldb_val *canonical)
+{
+	struct ldb_dn *dn;
+	struct ldb_val v = *canonical;
+	char *attr_folded = ldb_attr_casefold(mem_ctx, attr);
+	if (attr_folded == NULL) {
+		return NULL;
+	}
+
+	if (v.length > LTDB_PREFIX_INDEX_LEN) {
+		v.length = LTDB_PREFIX_INDEX_LEN;
+	}
+
+	if (ldb_should_b64_encode(ldb, &v)) {
+		char *vstr = ldb_base64_encode(mem_ctx,
+					       (char *)v.data, v.length);
+		if (vstr == NULL) {
+			talloc_free(attr_folded);
+			return NULL;
+		}
+		/*
+		 * Note: the double colon "::" is not a typo and
+		 * indicates that the following value is base64 encoded
+		 */
+		dn = ldb_dn_new_fmt(mem_ctx, ldb, "%s:%s:%s::%s",
+				    LTDB_INDEX, LTDB_IDXPREFIX,
+				    attr_folded, vstr);
+		talloc_free(vstr);
+	} else {
+		dn = ldb_dn_new_fmt(mem_ctx, ldb, "%s:%s:%s:%.*s",
+				    LTDB_INDEX, LTDB_IDXPREFIX,
+				    attr_folded, (int)v.length,
+				    (char *)v.data);
+	}
+	talloc_free(attr_folded);
+	return dn;
+}
 
-		/*
-		 * Overflow here is not critical as we only use this
-		 * to choose the printf truncation
-		 */
-		key_len = num_separators + indx_len + attr_len + (int)v.length;
-		if (key_len > max_key_length) {
-			size_t excess = key_len - max_key_length;
-			frmt_len = v.length - excess;
-			*truncation = KEY_TRUNCATED;
-			/*
-			 * Truncated keys are placed in a separate key space
-			 * from the non truncated keys
-			 */
-			ret = ldb_dn_new_fmt(ldb, ldb, "%s#%s#%.*s",
-					     LTDB_INDEX, attr_for_dn,
-					     frmt_len, (char *)v.data);
-		} else {
-			frmt_len = v.length;
-			*truncation = KEY_NOT_TRUNCATED;
-			ret = ldb_dn_new_fmt(ldb, ldb, "%s:%s:%.*s",
-					     LTDB_INDEX, attr_for_dn,
-					     frmt_len, (char *)v.data);
-		}
+/*
+  load the prefix index record that a value of a message is (or is to
+  be) listed in
+*/
+static int ltdb_index_prefix_load(struct ldb_module *module,
+				  struct ltdb_private *ltdb,
+				  const struct ldb_schema_attribute *a,
+				  const char *attr,
+				  const struct ldb_val *value,
+				  struct dn_list *list,
+				  struct ldb_dn **dn_key)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	struct ldb_val v;
+	int ret;
+
+	ret = a->syntax->canonicalise_fn(ldb, list, value, &v);
+	if (ret != LDB_SUCCESS) {
+		ldb_asprintf_errstring(ldb,
+				       "Failed to create prefix index "
+				       "key for attribute '%s': %s",
+				       attr, ldb_strerror(ret));
+		return LDB_ERR_OPERATIONS_ERROR;
 	}
 
-	if (v.data != value->data) {
-		talloc_free(v.data);
+	*dn_key = ltdb_prefix_index_key(ldb, list, attr, &v);
+	if (*dn_key == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	return ltdb_dn_list_load(module, ltdb, *dn_key, list);
+}
+
+/*
+  add a value of a message to a prefix index
+*/
+static int ltdb_index_prefix_add1(struct ldb_module *module,
+				  struct ltdb_private *ltdb,
+				  const struct ldb_message *msg,
+				  const struct ldb_schema_attribute *a,
+				  const char *attr,
+				  const struct ldb_val *value)
+{
+	struct ldb_dn *dn_key = NULL;
+	struct dn_list *list;
+	struct ldb_val v;
+	int ret;
+
+	ret = ltdb_index_msg_val(module, ltdb, msg, &v);
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
+	list = talloc_zero(module, struct dn_list);
+	if (list == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	ret = ltdb_index_prefix_load(module, ltdb, a, attr, value,
+				     list, &dn_key);
+	if (ret != LDB_SUCCESS && ret != LDB_ERR_NO_SUCH_OBJECT) {
+		talloc_free(list);
+		return ret;
 	}
-	talloc_free(attr_folded);
 
+	/*
+	 * Two values of a multi-valued attribute can share a prefix,
+	 * so the record is listed twice and the duplicate is removed
+	 * at search time.
+	 */
+	ret = ltdb_dn_list_add_val(ltdb, list, &v);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(list);
+		return ret;
+	}
+
+	ret = ltdb_dn_list_store(module, dn_key, list);
+	talloc_free(list);
 	return ret;
 }
 
 /*
-  see if a attribute value is in the list of indexed attributes
+  remove a value of a message from a prefix index
 */
-static bool ltdb_is_indexed(struct ldb_module *module,
-			    struct ltdb_private *ltdb,
-			    const char *attr)
+static int ltdb_index_prefix_del1(struct ldb_module *module,
+				  struct ltdb_private *ltdb,
+				  const struct ldb_message *msg,
+				  const struct ldb_schema_attribute *a,
+				  const char *attr,
+				  const struct ldb_val *value)
+{
+	struct ldb_dn *dn_key = NULL;
+	struct dn_list *list;
+	int ret, i;
+
+	list = talloc_zero(module, struct dn_list);
+	if (list == NULL) {
+		return ldb_module_oom(module);
+	}
+
+	ret = ltdb_index_prefix_load(module, ltdb, a, attr, value,
+				     list, &dn_key);
+	if (ret == LDB_ERR_NO_SUCH_OBJECT) {
+		talloc_free(list);
+		return LDB_SUCCESS;
+	}
+	if (ret != LDB_SUCCESS) {
+		talloc_free(list);
+		return ret;
+	}
+
+	i = ltdb_dn_list_find_msg(ltdb, list, msg);
+	if (i == -1) {
+		/* nothing to delete */
+		talloc_free(list);
+		return LDB_SUCCESS;
+	}
+	ltdb_dn_list_remove(list, i);
+
+	ret = ltdb_dn_list_store(module, dn_key, list);
+	talloc_free(list);
+	return ret;
+}
+
+/*
+  return a list of dn's that might match an initial substring search
+  on an attribute with a prefix index
+ */
+static int ltdb_index_dn_substring(struct ldb_module *module,
+				   struct ltdb_private *ltdb,
+				   const struct ldb_parse_tree *tree,
+				   struct dn_list *list)
 {
 	struct ldb_context *ldb = ldb_module_get_ctx(module);
-	unsigned int i;
-	struct ldb_message_element *el;
+	const char *attr = tree->u.substring.attr;
+	const struct ldb_schema_attribute *a;
+	struct ldb_dn *dn_key;
+	struct ldb_val v;
+	int ret;
 
-	if ((ltdb->cache->GUID_index_attribute != NULL) &&
-	    (ldb_attr_cmp(attr,
-			  ltdb->cache->GUID_index_attribute) == 0)) {
-		/* Implicity covered, this is the index key */
-		return false;
+	list->dn = NULL;
+	list->count = 0;
+
+	if (tree->u.substring.start_with_wildcard ||
+	    tree->u.substring.chunks == NULL ||
+	    tree->u.substring.chunks[0] == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
 	}
-	if (ldb->schema.index_handler_override) {
-		const struct ldb_schema_attribute *a
-			= ldb_schema_attribute_by_name(ldb, attr);
 
-		if (a == NULL) {
-			return false;
-		}
+	a = ltdb_prefix_index_attr(module, ltdb, attr);
+	if (a == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
 
-		if (a->flags & LDB_ATTR_FLAG_INDEXED) {
-			return true;
-		} else {
-			return false;
-		}
+	/*
+	 * ldb_wildcard_compare() canonicalises the chunk the same
+	 * way, so every match has a value starting with these bytes
+	 */
+	ret = a->syntax->canonicalise_fn(ldb, list,
+					 tree->u.substring.chunks[0], &v);
+	if (ret != LDB_SUCCESS) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+	if (v.length < LTDB_PREFIX_INDEX_LEN) {
+		/* the matches are spread over many records */
+		talloc_free(v.data);
+		return LDB_ERR_OPERATIONS_ERROR;
 	}
 
-	if (!ltdb->cache->attribute_indexes) {
-		return false;
+	dn_key = ltdb_prefix_index_key(ldb, list, attr, &v);
+	talloc_free(v.data);
+	if (dn_key == NULL) {
+		return ldb_module_oom(module);
 	}
 
-	el = ldb_msg_find_element(ltdb->cache->indexlist, LTDB_IDXATTR);
-	if (el == NULL) {
-		return false;
+	ret = ltdb_dn_list_load(module, ltdb, dn_key, list);
+	talloc_free(dn_key);
+	if (ret != LDB_SUCCESS) {
+		return ret;
 	}
 
-	/* TODO: this is too expensive! At least use a binary search */
-	for (i=0; i<el->num_values; i++) {
-		if (ldb_attr_cmp((char *)el->values[i].data, attr) == 0) {
-			return true;
+	/*
+	 * Inside a transaction the list is the one held in the
+	 * idxptr, so take a copy before removing the duplicates
+	 */
+	if (list->count > 1) {
+		list->dn = talloc_memdup(list, list->dn,
+					 sizeof(list->dn[0]) * list->count);
+		if (list->dn == NULL) {
+			return ldb_module_oom(module);
 		}
+		ltdb_dn_list_unique(list);
 	}
-	return false;
+
+	return LDB_SUCCESS;
 }
 
 /*
@@ -1693,9 +2664,15 @@ static int ltdb_index_dn(struct ldb_module *module,
 		ret = ltdb_index_dn_leaf(module, ltdb, tree, list);
 		break;
 
-	case LDB_OP_SUBSTRING:
 	case LDB_OP_GREATER:
 	case LDB_OP_LESS:
+		ret = ltdb_index_dn_ordered(module, ltdb, tree, list);
+		break;
+
+	case LDB_OP_SUBSTRING:
+		ret = ltdb_index_dn_substring(module, ltdb, tree, list);
+		break;
+
 	case LDB_OP_PRESENT:
 	case LDB_OP_APPROX:
 	case LDB_OP_EXTENDED:
@@ -1796,12 +2773,15 @@ static int ltdb_index_filter(struct ltdb_private *ltdb,
 		if (ac->scope == LDB_SCOPE_ONELEVEL
 		    && ltdb->cache->one_level_indexes
 		    && scope_one_truncation == KEY_NOT_TRUNCATED) {
-			ret = ldb_match_message(ldb, msg, ac->tree,
-						ac->scope, &matched);
+			ret = ldb_match_compiled_msg_error(ldb, msg,
+							   ac->match_program,
+							   NULL, ac->scope,
+							   &matched);
 		} else {
-			ret = ldb_match_msg_error(ldb, msg,
-						  ac->tree, ac->base,
-						  ac->scope, &matched);
+			ret = ldb_match_compiled_msg_error(ldb, msg,
+							   ac->match_program,
+							   ac->base, ac->scope,
+							   &matched);
 		}
 
 		if (ret != LDB_SUCCESS) {
@@ -2239,9 +3219,17 @@ static int ltdb_index_add1(struct ldb_module *module,
 			return ldb_module_operr(module);
 		}
 
-		BINARY_ARRAY_SEARCH_GTE(list->dn, list->count,
-					*key_val, ldb_val_equal_exact_ordered,
-					exact, next);
+		/*
+		 * In a reindex just append, ltdb_index_bulk_sort()
+		 * puts the list in order once every record has been
+		 * added
+		 */
+		if (!ltdb_index_bulk(ltdb)) {
+			BINARY_ARRAY_SEARCH_GTE(list->dn, list->count,
+						*key_val,
+						ldb_val_equal_exact_ordered,
+						exact, next);
+		}
 
 		/*
 		 * Give a warning rather than fail, this could be a
@@ -2303,12 +3291,37 @@ static int ltdb_index_add_el(struct ldb_module *module,
 			     const struct ldb_message *msg,
 			     struct ldb_message_element *el)
 {
+	const struct ldb_schema_attribute *ordered
+		= ltdb_ordered_index_attr(module, ltdb, el->name);
+	const struct ldb_schema_attribute *prefix
+		= ltdb_prefix_index_attr(module, ltdb, el->name);
+	bool indexed = ltdb_is_indexed(module, ltdb, el->name);
 	unsigned int i;
+	int ret;
+
 	for (i = 0; i < el->num_values; i++) {
-		int ret = ltdb_index_add1(module, ltdb,
-					  msg, el, i);
-		if (ret != LDB_SUCCESS) {
-			return ret;
+		if (indexed) {
+			ret = ltdb_index_add1(module, ltdb,
+					      msg, el, i);
+			if (ret != LDB_SUCCESS) {
+				return ret;
+			}
+		}
+		if (ordered != NULL) {
+			ret = ltdb_index_ordered_add1(module, ltdb,
+						      msg, ordered, el->name,
+						      &el->values[i]);
+			if (ret != LDB_SUCCESS) {
+				return ret;
+			}
+		}
+		if (prefix != NULL) {
+			ret = ltdb_index_prefix_add1(module, ltdb,
+						     msg, prefix, el->name,
+						     &el->values[i]);
+			if (ret != LDB_SUCCESS) {
+				return ret;
+			}
 		}
 	}
 
@@ -2347,9 +3360,6 @@ static int ltdb_index_add_all(struct ldb_module *module,
 	}
 
 	for (i = 0; i < msg->num_elements; i++) {
-		if (!ltdb_is_indexed(module, ltdb, elements[i].name)) {
-			continue;
-		}
 		ret = ltdb_index_add_el(module, ltdb,
 					msg, &elements[i]);
 		if (ret != LDB_SUCCESS) {
@@ -2487,9 +3497,6 @@ int ltdb_index_add_element(struct ldb_module *module,
 	if (ldb_dn_is_special(msg->dn)) {
 		return LDB_SUCCESS;
 	}
-	if (!ltdb_is_indexed(module, ltdb, el->name)) {
-		return LDB_SUCCESS;
-	}
 	return ltdb_index_add_el(module, ltdb, msg, el);
 }
 
@@ -2550,6 +3557,8 @@ int ltdb_index_del_value(struct ldb_module *module,
 	struct dn_list *list;
 	struct ldb_dn *dn = msg->dn;
 	enum key_truncation truncation = KEY_NOT_TRUNCATED;
+	const struct ldb_schema_attribute *ordered;
+	const struct ldb_schema_attribute *prefix;
 
 	ldb = ldb_module_get_ctx(module);
 
@@ -2562,6 +3571,24 @@ int ltdb_index_del_value(struct ldb_module *module,
 		return LDB_SUCCESS;
 	}
 
+	ordered = ltdb_ordered_index_attr(module, ltdb, el->name);
+	if (ordered != NULL) {
+		ret = ltdb_index_ordered_del1(module, ltdb, msg, ordered,
+					      el->name, &el->values[v_idx]);
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
+	}
+
+	prefix = ltdb_prefix_index_attr(module, ltdb, el->name);
+	if (prefix != NULL) {
+		ret = ltdb_index_prefix_del1(module, ltdb, msg, prefix,
+					     el->name, &el->values[v_idx]);
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
+	}
+
 	dn_key = ltdb_index_key(ldb, ltdb,
 				el->name, &el->values[v_idx],
 				NULL, &truncation);
@@ -2650,7 +3677,9 @@ int ltdb_index_del_element(struct ldb_module *module,
 		return LDB_SUCCESS;
 	}
 
-	if (!ltdb_is_indexed(module, ltdb, el->name)) {
+	if (!ltdb_is_indexed(module, ltdb, el->name) &&
+	    ltdb_ordered_index_attr(module, ltdb, el->name) == NULL &&
+	    ltdb_prefix_index_attr(module, ltdb, el->name) == NULL) {
 		return LDB_SUCCESS;
 	}
 	for (i = 0; i < el->num_values; i++) {
@@ -2751,6 +3780,31 @@ static int delete_index(struct ltdb_private *ltdb, struct ldb_val key, struct ld
 	return 0;
 }
 
+/*
+  seconds since the current pass of a reindex started
+*/
+static double ltdb_reindex_elapsed(const struct ltdb_reindex_context *ctx)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - ctx->start.tv_sec) +
+		(now.tv_usec - ctx->start.tv_usec) * 1.0e-6;
+}
+
+/*
+  records per second handled so far by the current pass of a reindex
+*/
+static double ltdb_reindex_rate(const struct ltdb_reindex_context *ctx)
+{
+	double elapsed = ltdb_reindex_elapsed(ctx);
+
+	if (elapsed <= 0) {
+		return 0;
+	}
+	return ctx->count / elapsed;
+}
+
 /*
   traversal function that adds @INDEX records during a re index TODO wrong comment
 */
@@ -2764,6 +3818,9 @@ static int re_key(struct ltdb_private *ltdb, struct ldb_val ldb_key, struct ldb_
 	int ret;
 	TDB_DATA key2;
 	bool is_record;
+	uint32_t pack_format_version;
+	struct ldb_val new_val;
+	bool repack = false;
 	TDB_DATA key = {
 		.dptr = ldb_key.data,
 		.dsize = ldb_key.length
@@ -2820,13 +3877,42 @@ static int re_key(struct ltdb_private *ltdb, struct ldb_val ldb_key, struct ldb_
 		talloc_free(msg);
 		return 0;
 	}
-	if (key.dsize != key2.dsize ||
+
+	/*
+	 * Also rewrite the record if it is not in the pack format
+	 * this database now uses, so a reindex upgrades (or
+	 * downgrades) every record.
+	 */
+	ret = ldb_unpack_get_format(&val, &pack_format_version);
+	if (ret != 0) {
+		talloc_free(msg);
+		return -1;
+	}
+	if (ltdb->cache->pack_format_version != 0 &&
+	    pack_format_version != ltdb->cache->pack_format_version) {
+		ret = ldb_pack_data_format(ldb, msg, &new_val,
+					   ltdb->cache->pack_format_version);
+		if (ret != 0) {
+			ldb_debug(ldb, LDB_DEBUG_ERROR,
+				  "Failed to repack %s in re_index",
+				  ldb_dn_get_linearized(msg->dn));
+			ctx->error = LDB_ERR_OPERATIONS_ERROR;
+			talloc_free(msg);
+			return -1;
+		}
+		talloc_steal(msg, new_val.data);
+		repack = true;
+	}
+
+	if (repack ||
+	    key.dsize != key2.dsize ||
 	    (memcmp(key.dptr, key2.dptr, key.dsize) != 0)) {
 		struct ldb_val ldb_key2 = {
 			.data = key2.dptr,
 			.length = key2.dsize
 		};
-		ltdb->kv_ops->update_in_iterate(ltdb, ldb_key, ldb_key2, val, ctx);
+		ltdb->kv_ops->update_in_iterate(ltdb, ldb_key, ldb_key2,
+						repack ? new_val : val, ctx);
 	}
 	talloc_free(key2.dptr);
 
@@ -2835,8 +3921,9 @@ static int re_key(struct ltdb_private *ltdb, struct ldb_val ldb_key, struct ldb_
 	ctx->count++;
 	if (ctx->count % 10000 == 0) {
 		ldb_debug(ldb, LDB_DEBUG_WARNING,
-			  "Reindexing: re-keyed %u records so far",
-			  ctx->count);
+			  "Reindexing: re-keyed %u records so far "
+			  "(%.0f records/sec)",
+			  ctx->count, ltdb_reindex_rate(ctx));
 	}
 
 	return 0;
@@ -2921,8 +4008,9 @@ static int re_index(struct ltdb_private *ltdb, struct ldb_val ldb_key, struct ld
 	ctx->count++;
 	if (ctx->count % 10000 == 0) {
 		ldb_debug(ldb, LDB_DEBUG_WARNING,
-			  "Reindexing: re-indexed %u records so far",
-			  ctx->count);
+			  "Reindexing: re-indexed %u records so far "
+			  "(%.0f records/sec)",
+			  ctx->count, ltdb_reindex_rate(ctx));
 	}
 
 	return 0;
@@ -2961,6 +4049,18 @@ int ltdb_reindex(struct ldb_module *module)
 		return ret;
 	}
 
+	/*
+	 * The in-memory TDB gets an entry for every index record,
+	 * including an @IDXDN record per object with a GUID index,
+	 * so give it a much larger hash table than a normal
+	 * transaction would use
+	 */
+	ltdb->idxptr->itdb = tdb_open(NULL, LTDB_REINDEX_HASH_SIZE,
+				      TDB_INTERNAL, O_RDWR, 0);
+	if (ltdb->idxptr->itdb == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
 	/* first traverse the database deleting any @INDEX records by
 	 * putting NULL entries in the in-memory tdb
 	 */
@@ -2975,6 +4075,7 @@ int ltdb_reindex(struct ldb_module *module)
 	ctx.module = module;
 	ctx.error = 0;
 	ctx.count = 0;
+	gettimeofday(&ctx.start, NULL);
 
 	ret = ltdb->kv_ops->iterate(ltdb, re_key, &ctx);
 	if (ret < 0) {
@@ -2992,11 +4093,21 @@ int ltdb_reindex(struct ldb_module *module)
 
 	ctx.error = 0;
 	ctx.count = 0;
+	gettimeofday(&ctx.start, NULL);
 
-	/* now traverse adding any indexes for normal LDB records */
+	/*
+	 * now traverse adding any indexes for normal LDB records.
+	 *
+	 * Nothing searches the indexes while this runs, so the
+	 * in-memory lists are built by appending to them and only
+	 * sorted once at the end, which avoids moving on average half
+	 * of a large list (eg objectClass=top) for every record.
+	 */
+	ltdb->idxptr->bulk = true;
 	ret = ltdb->kv_ops->iterate(ltdb, re_index, &ctx);
 	if (ret < 0) {
 		struct ldb_context *ldb = ldb_module_get_ctx(module);
+		ltdb->idxptr->bulk = false;
 		ldb_asprintf_errstring(ldb, "reindexing traverse failed: %s",
 				       ldb_errstring(ldb));
 		return LDB_ERR_OPERATIONS_ERROR;
@@ -3004,15 +4115,27 @@ int ltdb_reindex(struct ldb_module *module)
 
 	if (ctx.error != LDB_SUCCESS) {
 		struct ldb_context *ldb = ldb_module_get_ctx(module);
+		ltdb->idxptr->bulk = false;
 		ldb_asprintf_errstring(ldb, "reindexing failed: %s", ldb_errstring(ldb));
 		return ctx.error;
 	}
 
+	ret = ltdb_index_bulk_sort(module, ltdb);
+	if (ret != LDB_SUCCESS) {
+		struct ldb_context *ldb = ldb_module_get_ctx(module);
+		ldb_asprintf_errstring(ldb, "sorting indexes failed: %s",
+				       ldb_errstring(ldb));
+		return ret;
+	}
+
 	if (ctx.count > 10000) {
 		ldb_debug(ldb_module_get_ctx(module),
 			  LDB_DEBUG_WARNING, "Reindexing: re_index successful on %s, "
+			  "%u records in %.2f seconds (%.0f records/sec), "
 			  "final index write-out will be in transaction commit",
-			  ltdb->kv_ops->name(ltdb));
+			  ltdb->kv_ops->name(ltdb),
+			  ctx.count, ltdb_reindex_elapsed(&ctx),
+			  ltdb_reindex_rate(&ctx));
 	}
 	return LDB_SUCCESS;
 }
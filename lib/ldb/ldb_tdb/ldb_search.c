@@ -177,6 +177,7 @@ int ltdb_search_base(struct ldb_module *module,
 struct ltdb_parse_data_unpack_ctx {
 	struct ldb_message *msg;
 	struct ldb_module *module;
+	struct ltdb_private *ltdb;
 	unsigned int unpack_flags;
 };
 
@@ -190,6 +191,21 @@ static int ltdb_parse_data_unpack(struct ldb_val key,
 	struct ldb_context *ldb = ldb_module_get_ctx(ctx->module);
 	struct ldb_val data_parse = data;
 
+	/*
+	 * Keep the unpacked record for next time, if the cache will
+	 * take it
+	 */
+	ret = ltdb_obj_cache_add(ctx->module, ctx->ltdb, key, data,
+				 ctx->msg, ctx->unpack_flags);
+	if (ret != LDB_ERR_UNWILLING_TO_PERFORM) {
+		if (ret != LDB_SUCCESS) {
+			ldb_debug(ldb, LDB_DEBUG_ERROR,
+				  "Invalid data for index %*.*s\n",
+				  (int)key.length, (int)key.length, key.data);
+		}
+		return ret;
+	}
+
 	if (ctx->unpack_flags & LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC) {
 		/*
 		 * If we got LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC
@@ -242,6 +258,7 @@ int ltdb_search_key(struct ldb_module *module, struct ltdb_private *ltdb,
 	struct ltdb_parse_data_unpack_ctx ctx = {
 		.msg = msg,
 		.module = module,
+		.ltdb = ltdb,
 		.unpack_flags = unpack_flags
 	};
 	struct ldb_val ldb_key = {
@@ -254,6 +271,10 @@ int ltdb_search_key(struct ldb_module *module, struct ltdb_private *ltdb,
 	msg->num_elements = 0;
 	msg->elements = NULL;
 
+	if (ltdb_obj_cache_fetch(ltdb, ldb_key, msg, unpack_flags, &ret)) {
+		return ret;
+	}
+
 	ret = ltdb->kv_ops->fetch_and_parse(ltdb, ldb_key,
 					    ltdb_parse_data_unpack, &ctx);
 
@@ -486,6 +507,84 @@ failed:
 	return -1;
 }
 
+/*
+  callback for ltdb_tree_attrs(), adding the attribute of each leaf
+  of the parse tree
+*/
+static int ltdb_tree_attrs_add(struct ldb_parse_tree *tree, void *private_data)
+{
+	struct ltdb_context *ac = private_data;
+	const char *attr = NULL;
+	const char **attrs = NULL;
+	unsigned int i;
+
+	switch (tree->operation) {
+	case LDB_OP_AND:
+	case LDB_OP_OR:
+	case LDB_OP_NOT:
+		return LDB_SUCCESS;
+	case LDB_OP_EQUALITY:
+	case LDB_OP_GREATER:
+	case LDB_OP_LESS:
+	case LDB_OP_APPROX:
+		attr = tree->u.equality.attr;
+		break;
+	case LDB_OP_SUBSTRING:
+		attr = tree->u.substring.attr;
+		break;
+	case LDB_OP_PRESENT:
+		attr = tree->u.present.attr;
+		break;
+	case LDB_OP_EXTENDED:
+		/*
+		 * Extended match rules are given the whole message,
+		 * and may look at other attributes
+		 */
+		return LDB_ERR_UNWILLING_TO_PERFORM;
+	}
+
+	if (attr == NULL || strcmp(attr, "*") == 0) {
+		return LDB_ERR_UNWILLING_TO_PERFORM;
+	}
+
+	for (i = 0; i < ac->num_tree_attrs; i++) {
+		if (ldb_attr_cmp(ac->tree_attrs[i], attr) == 0) {
+			return LDB_SUCCESS;
+		}
+	}
+
+	attrs = talloc_realloc(ac, ac->tree_attrs, const char *,
+			       ac->num_tree_attrs + 1);
+	if (attrs == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+	attrs[ac->num_tree_attrs] = attr;
+	ac->tree_attrs = attrs;
+	ac->num_tree_attrs++;
+
+	return LDB_SUCCESS;
+}
+
+/*
+  find the attributes the search filter needs, leaving
+  ac->tree_attrs NULL if the whole record is needed
+*/
+static void ltdb_tree_attrs(struct ltdb_context *ac)
+{
+	int ret;
+
+	ac->tree_attrs = NULL;
+	ac->num_tree_attrs = 0;
+
+	ret = ldb_parse_tree_walk(discard_const_p(struct ldb_parse_tree,
+						  ac->tree),
+				  ltdb_tree_attrs_add, ac);
+	if (ret != LDB_SUCCESS || ac->num_tree_attrs == 0) {
+		TALLOC_FREE(ac->tree_attrs);
+		ac->num_tree_attrs = 0;
+	}
+}
+
 /*
   search function for a non-indexed search
  */
@@ -497,6 +596,8 @@ static int search_func(struct ltdb_private *ltdb, struct ldb_val key, struct ldb
 	int ret;
 	bool matched;
 	unsigned int nb_elements_in_db;
+	uint32_t pack_format_version = 0;
+	bool lazy = false;
 	TDB_DATA tdb_key = {
 		.dptr = key.data,
 		.dsize = key.length
@@ -515,10 +616,22 @@ static int search_func(struct ltdb_private *ltdb, struct ldb_val key, struct ldb
 		return -1;
 	}
 
+	/*
+	 * The attribute directory of LDB_PACKING_FORMAT_V2 makes it
+	 * cheap to unpack just the attributes the filter needs, and
+	 * most records in a full scan do not match.
+	 */
+	if (ac->tree_attrs != NULL &&
+	    ldb_unpack_get_format(&val, &pack_format_version) == 0 &&
+	    pack_format_version == LDB_PACKING_FORMAT_V2) {
+		lazy = true;
+	}
+
 	/* unpack the record */
 	ret = ldb_unpack_data_only_attr_list_flags(ldb, &val,
 						   msg,
-						   NULL, 0,
+						   lazy ? ac->tree_attrs : NULL,
+						   lazy ? ac->num_tree_attrs : 0,
 						   LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC|
 						   LDB_UNPACK_DATA_FLAG_NO_VALUES_ALLOC,
 						   &nb_elements_in_db);
@@ -539,8 +652,9 @@ static int search_func(struct ltdb_private *ltdb, struct ldb_val key, struct ldb
 	}
 
 	/* see if it matches the given expression */
-	ret = ldb_match_msg_error(ldb, msg,
-				  ac->tree, ac->base, ac->scope, &matched);
+	ret = ldb_match_compiled_msg_error(ldb, msg,
+					   ac->match_program,
+					   ac->base, ac->scope, &matched);
 	if (ret != LDB_SUCCESS) {
 		talloc_free(msg);
 		ac->error = LDB_ERR_OPERATIONS_ERROR;
@@ -551,6 +665,45 @@ static int search_func(struct ltdb_private *ltdb, struct ldb_val key, struct ldb
 		return 0;
 	}
 
+	if (lazy) {
+		struct ldb_dn *dn = talloc_steal(ac, msg->dn);
+		const char * const *attrs = ac->attrs;
+		unsigned int num_attrs = 0;
+
+		/*
+		 * Now unpack the attributes the caller asked for
+		 */
+		if (attrs != NULL && !ldb_attr_in_list(attrs, "*")) {
+			while (attrs[num_attrs] != NULL) {
+				num_attrs++;
+			}
+		} else {
+			attrs = NULL;
+		}
+
+		talloc_free(msg);
+		msg = ldb_msg_new(ac);
+		if (msg == NULL) {
+			talloc_free(dn);
+			ac->error = LDB_ERR_OPERATIONS_ERROR;
+			return -1;
+		}
+		ret = ldb_unpack_data_only_attr_list_flags(ldb, &val,
+							   msg,
+							   attrs, num_attrs,
+							   LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC|
+							   LDB_UNPACK_DATA_FLAG_NO_VALUES_ALLOC|
+							   LDB_UNPACK_DATA_FLAG_NO_DN,
+							   &nb_elements_in_db);
+		if (ret == -1) {
+			talloc_free(dn);
+			talloc_free(msg);
+			ac->error = LDB_ERR_OPERATIONS_ERROR;
+			return -1;
+		}
+		msg->dn = talloc_steal(msg, dn);
+	}
+
 	/* filter the attributes that the user wants */
 	ret = ltdb_filter_attrs(ac, msg, ac->attrs, &filtered_msg);
 	talloc_free(msg);
@@ -583,7 +736,10 @@ static int ltdb_search_full(struct ltdb_context *ctx)
 	int ret;
 
 	ctx->error = LDB_SUCCESS;
+	ltdb_tree_attrs(ctx);
 	ret = ltdb->kv_ops->iterate(ltdb, search_func, ctx);
+	TALLOC_FREE(ctx->tree_attrs);
+	ctx->num_tree_attrs = 0;
 
 	if (ret < 0) {
 		return LDB_ERR_OPERATIONS_ERROR;
@@ -792,6 +948,16 @@ int ltdb_search(struct ltdb_context *ctx)
 		ret = LDB_SUCCESS;
 	}
 
+	if (ret == LDB_SUCCESS) {
+		/*
+		 * Every candidate record is matched against the
+		 * filter, so resolve the attribute handlers and
+		 * canonicalise the values in it just once
+		 */
+		ret = ldb_match_compile(ldb, ctx, ctx->tree,
+					&ctx->match_program);
+	}
+
 	if (ret == LDB_SUCCESS) {
 		uint32_t match_count = 0;
 
@@ -456,6 +456,7 @@ int ltdb_store(struct ldb_module *module, const struct ldb_message *msg, int flg
 	struct ldb_val ldb_key;
 	struct ldb_val ldb_data;
 	int ret = LDB_SUCCESS;
+	uint32_t pack_format_version;
 	TALLOC_CTX *tdb_key_ctx = talloc_new(module);
 
 	if (tdb_key_ctx == NULL) {
@@ -472,8 +473,22 @@ int ltdb_store(struct ldb_module *module, const struct ldb_message *msg, int flg
 		return LDB_ERR_OTHER;
 	}
 
-	ret = ldb_pack_data(ldb_module_get_ctx(module),
-			    msg, &ldb_data);
+	/*
+	 * The pack format is not known until @INDEXLIST has been
+	 * loaded, so the records written before that (@BASEINFO) use
+	 * the original format.  Special records always do: they are
+	 * not searched, and @INDEXLIST is written before a change of
+	 * format takes effect, so it must stay readable by a version
+	 * that only knows the original format.
+	 */
+	pack_format_version = LDB_PACKING_FORMAT;
+	if (ltdb->cache != NULL && ltdb->cache->pack_format_version != 0 &&
+	    !ldb_dn_is_special(msg->dn)) {
+		pack_format_version = ltdb->cache->pack_format_version;
+	}
+
+	ret = ldb_pack_data_format(ldb_module_get_ctx(module),
+				   msg, &ldb_data, pack_format_version);
 	if (ret == -1) {
 		TALLOC_FREE(tdb_key_ctx);
 		return LDB_ERR_OTHER;
@@ -1471,6 +1486,12 @@ static int ltdb_start_trans(struct ldb_module *module)
 
 	ltdb->in_transaction++;
 
+	/*
+	 * The records are about to change, and our own changes do
+	 * not always show up as a new sequence number
+	 */
+	ltdb_obj_cache_flush(ltdb);
+
 	ltdb_index_transaction_start(module);
 
 	ltdb->reindex_failed = false;
@@ -1678,6 +1699,7 @@ done:
 
 static void ltdb_request_done(struct ltdb_context *ctx, int error)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_context *ldb;
 	struct ldb_request *req;
 	struct ldb_reply *ares;
@@ -1699,7 +1721,9 @@ static void ltdb_request_done(struct ltdb_context *ctx, int error)
 	ares->type = LDB_REPLY_DONE;
 	ares->error = error;
 
+	ldb_module_timing_enter_callback(req, &frame);
 	req->callback(req, ares);
+	ldb_module_timing_leave(&frame);
 }
 
 static void ltdb_timeout(struct tevent_context *ev,
@@ -1727,6 +1751,7 @@ static void ltdb_request_extended_done(struct ltdb_context *ctx,
 					struct ldb_extended *ext,
 					int error)
 {
+	struct ldb_module_timing_frame frame;
 	struct ldb_context *ldb;
 	struct ldb_request *req;
 	struct ldb_reply *ares;
@@ -1749,7 +1774,9 @@ static void ltdb_request_extended_done(struct ltdb_context *ctx,
 	ares->response = ext;
 	ares->error = error;
 
+	ldb_module_timing_enter_callback(req, &frame);
 	req->callback(req, ares);
+	ldb_module_timing_leave(&frame);
 }
 
 static void ltdb_handle_extended(struct ltdb_context *ctx)
@@ -1938,6 +1965,7 @@ static void ltdb_callback(struct tevent_context *ev,
 			  struct timeval t,
 			  void *private_data)
 {
+	struct ldb_module_timing_frame frame = { .generation = 0 };
 	struct ltdb_context *ctx;
 	int ret;
 
@@ -1947,6 +1975,9 @@ static void ltdb_callback(struct tevent_context *ev,
 		goto done;
 	}
 
+	/* the work of the request is done here, not in ltdb_handle_request() */
+	ldb_module_timing_enter(ctx->module, ctx->req, &frame);
+
 	switch (ctx->req->operation) {
 	case LDB_SEARCH:
 		ret = ltdb_search(ctx);
@@ -1983,6 +2014,8 @@ done:
 		ctx->spy = NULL;
 	}
 	talloc_free(ctx);
+
+	ldb_module_timing_leave(&frame);
 }
 
 static int ltdb_request_destructor(void *ptr)
@@ -2140,6 +2173,24 @@ int init_store(struct ltdb_private *ltdb,
 	ldb_module_set_private(module, ltdb);
 	talloc_steal(module, ltdb);
 
+	/*
+	 * The number of unpacked records to keep in memory, 0 to
+	 * disable the cache
+	 */
+	{
+		unsigned int obj_cache_size = LTDB_OBJ_CACHE_DEFAULT_SIZE;
+		const char *size_str =
+			ldb_options_find(ldb, options, "object_cache_size");
+		if (size_str != NULL) {
+			obj_cache_size = strtoul(size_str, NULL, 0);
+		}
+		if (ltdb_obj_cache_init(ldb, ltdb, obj_cache_size) != 0) {
+			ldb_oom(ldb);
+			talloc_free(module);
+			return LDB_ERR_OPERATIONS_ERROR;
+		}
+	}
+
 	if (ltdb_cache_load(module) != 0) {
 		ldb_asprintf_errstring(ldb, "Unable to load ltdb cache "
 				       "records for backend '%s'", name);
@@ -5,6 +5,7 @@
 #include "ldb_module.h"
 
 struct ltdb_private;
+struct lmdb_private;
 typedef int (*ldb_kv_traverse_fn)(struct ltdb_private *ltdb,
 				  struct ldb_val key, struct ldb_val data,
 				  void *ctx);
@@ -31,11 +32,41 @@ struct kv_db_ops {
 	bool (*has_changed)(struct ltdb_private *ltdb);
 };
 
+/*
+ * A bounded cache of unpacked records, so hot objects are not
+ * fetched and unpacked again on every search.  The unpacked message
+ * points into a private copy of the packed record.
+ */
+struct ltdb_obj_cache_entry {
+	/* LRU list, most recently used first */
+	struct ltdb_obj_cache_entry *prev, *next;
+	struct ltdb_obj_cache_entry *hash_next;
+	unsigned int hash;
+	struct ldb_val key;
+	struct ldb_val data;
+	struct ldb_message *msg;
+};
+
+struct ltdb_obj_cache {
+	struct ldb_context *ldb;
+	struct ltdb_obj_cache_entry **buckets;
+	unsigned int num_buckets;
+	struct ltdb_obj_cache_entry *lru;
+	unsigned int num_entries;
+	unsigned int max_entries;
+
+	uint64_t hits;
+	uint64_t misses;
+};
+
+#define LTDB_OBJ_CACHE_DEFAULT_SIZE 1024
+
 /* this private structure is used by the ltdb backend in the
    ldb_context */
 struct ltdb_private {
 	const struct kv_db_ops *kv_ops;
 	TDB_CONTEXT *tdb;
+	struct lmdb_private *lmdb_private;
 	unsigned int connect_flags;
 	
 	unsigned long long sequence_number;
@@ -50,8 +81,17 @@ struct ltdb_private {
 		bool attribute_indexes;
 		const char *GUID_index_attribute;
 		const char *GUID_index_dn_component;
+		/* the ldb_pack format new records are written in */
+		uint32_t pack_format_version;
 	} *cache;
 
+	/*
+	 * Only valid for the database sequence number it was filled
+	 * at, so it is emptied by ltdb_cache_load() whenever the
+	 * database has changed.  NULL if disabled.
+	 */
+	struct ltdb_obj_cache *obj_cache;
+
 	int in_transaction;
 
 	bool check_base;
@@ -91,6 +131,17 @@ struct ltdb_context {
 	const char * const *attrs;
 	struct tevent_timer *timeout_event;
 
+	/*
+	 * The attributes the filter needs, so records in
+	 * LDB_PACKING_FORMAT_V2 can be matched without unpacking the
+	 * whole record.  NULL if the filter needs the whole record.
+	 */
+	const char **tree_attrs;
+	unsigned int num_tree_attrs;
+
+	/* the filter compiled by ldb_match_compile() */
+	struct ldb_match_program *match_program;
+
 	/* error handling */
 	int error;
 };
@@ -99,6 +150,8 @@ struct ltdb_reindex_context {
 	struct ldb_module *module;
 	int error;
 	uint32_t count;
+	/* when the current pass started, for progress messages */
+	struct timeval start;
 };
 
 
@@ -109,9 +162,12 @@ struct ltdb_reindex_context {
 #define LTDB_IDXVERSION "@IDXVERSION"
 #define LTDB_IDXATTR    "@IDXATTR"
 #define LTDB_IDXONE     "@IDXONE"
+#define LTDB_IDXORDERED "@IDXORDERED"
+#define LTDB_IDXPREFIX  "@IDXPREFIX"
 #define LTDB_IDXDN     "@IDXDN"
 #define LTDB_IDXGUID    "@IDXGUID"
 #define LTDB_IDX_DN_GUID "@IDX_DN_GUID"
+#define LTDB_PACK_FORMAT "@PACK_FORMAT"
 #define LTDB_BASEINFO   "@BASEINFO"
 #define LTDB_OPTIONS    "@OPTIONS"
 #define LTDB_ATTRIBUTES "@ATTRIBUTES"
@@ -134,6 +190,21 @@ int ltdb_cache_reload(struct ldb_module *module);
 int ltdb_cache_load(struct ldb_module *module);
 int ltdb_increase_sequence_number(struct ldb_module *module);
 int ltdb_check_at_attributes_values(const struct ldb_val *value);
+int ltdb_obj_cache_init(struct ldb_context *ldb,
+			struct ltdb_private *ltdb,
+			unsigned int max_entries);
+void ltdb_obj_cache_flush(struct ltdb_private *ltdb);
+bool ltdb_obj_cache_fetch(struct ltdb_private *ltdb,
+			  struct ldb_val key,
+			  struct ldb_message *msg,
+			  unsigned int unpack_flags,
+			  int *ret);
+int ltdb_obj_cache_add(struct ldb_module *module,
+		       struct ltdb_private *ltdb,
+		       struct ldb_val key,
+		       struct ldb_val data,
+		       struct ldb_message *msg,
+		       unsigned int unpack_flags);
 
 /* The following definitions come from lib/ldb/ldb_tdb/ldb_index.c  */
 
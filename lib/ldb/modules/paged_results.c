@@ -26,8 +26,9 @@
  *
  *  Component: ldb paged results control module
  *
- *  Description: this module caches a complete search and sends back
- *  		 results in chunks as asked by the client
+ *  Description: this module runs a complete search, keeps the DN of
+ *  		 each result and sends back the results in chunks as
+ *  		 asked by the client, fetching each chunk as it is sent
  *
  *  Author: Simo Sorce
  */
@@ -47,6 +48,12 @@ struct message_store {
 
 struct private_data;
 
+/*
+ * The first search only returns the DN of each entry. The entries
+ * themselves are fetched again with a base search when the page
+ * holding them is sent, so a stored search costs a DN per result
+ * rather than a whole message.
+ */
 struct results_store {
 
 	struct private_data *priv;
@@ -56,9 +63,10 @@ struct results_store {
 
 	struct results_store *next;
 
-	struct message_store *first;
-	struct message_store *last;
-	int num_entries;
+	char **dn_list;
+	unsigned int num_entries;
+	unsigned int result_array_size;
+	unsigned int next_entry;
 
 	struct message_store *first_ref;
 	struct message_store *last_ref;
@@ -115,8 +123,10 @@ static struct results_store *new_store(struct private_data *priv)
 
 	newr->timestamp = time(NULL);
 
-	newr->first = NULL;
+	newr->dn_list = NULL;
 	newr->num_entries = 0;
+	newr->result_array_size = 0;
+	newr->next_entry = 0;
 	newr->first_ref = NULL;
 	newr->controls = NULL;
 
@@ -135,8 +145,147 @@ struct paged_context {
 	struct results_store *store;
 	int size;
 	struct ldb_control **controls;
+	struct ldb_control **down_controls;
 };
 
+/*
+  pass on the entry found by paged_search_by_dn()
+ */
+static int paged_fetch_callback(struct ldb_request *req, struct ldb_reply *ares)
+{
+	struct paged_context *ac;
+	int ret;
+
+	ac = talloc_get_type(req->context, struct paged_context);
+
+	if (!ares) {
+		return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+	}
+	if (ares->error != LDB_SUCCESS) {
+		ret = ares->error;
+		talloc_free(ares);
+		return ldb_request_done(req, ret);
+	}
+
+	switch (ares->type) {
+	case LDB_REPLY_ENTRY:
+		ret = ldb_module_send_entry(ac->req, ares->message,
+					    ares->controls);
+		if (ret != LDB_SUCCESS) {
+			return ldb_request_done(req, ret);
+		}
+		ac->size--;
+		break;
+
+	case LDB_REPLY_REFERRAL:
+		/* referrals were saved by the first search */
+		talloc_free(ares);
+		break;
+
+	case LDB_REPLY_DONE:
+		talloc_free(ares);
+		return ldb_request_done(req, LDB_SUCCESS);
+	}
+
+	return LDB_SUCCESS;
+}
+
+/*
+  search for one saved result by its DN, with the attributes, filter
+  and controls of the current request. If the entry has gone away or
+  no longer matches the filter nothing is sent.
+ */
+static int paged_search_by_dn(struct paged_context *ac, const char *dn_str)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(ac->module);
+	struct ldb_request *req;
+	struct ldb_dn *dn;
+	TALLOC_CTX *tmp_ctx;
+	int ret;
+
+	tmp_ctx = talloc_new(ac);
+	if (tmp_ctx == NULL) {
+		return ldb_oom(ldb);
+	}
+
+	dn = ldb_dn_new(tmp_ctx, ldb, dn_str);
+	if (dn == NULL) {
+		talloc_free(tmp_ctx);
+		return ldb_oom(ldb);
+	}
+
+	ret = ldb_build_search_req_ex(&req, ldb, tmp_ctx,
+				      dn,
+				      LDB_SCOPE_BASE,
+				      ac->req->op.search.tree,
+				      ac->req->op.search.attrs,
+				      ac->down_controls,
+				      ac,
+				      paged_fetch_callback,
+				      ac->req);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(tmp_ctx);
+		return ret;
+	}
+
+	ret = ldb_next_request(ac->module, req);
+	if (ret == LDB_SUCCESS) {
+		ret = ldb_wait(req->handle, LDB_WAIT_ALL);
+	}
+
+	talloc_free(tmp_ctx);
+	return ret;
+}
+
+/*
+  the controls of the request, less those that only make sense for
+  the whole search and must not be applied to each base search
+ */
+static struct ldb_control **
+paged_copy_down_controls(TALLOC_CTX *mem_ctx, struct ldb_control **controls)
+{
+	static const char * const skip_oids[] = {
+		LDB_CONTROL_PAGED_RESULTS_OID,
+		LDB_CONTROL_SERVER_SORT_OID,
+		LDB_CONTROL_VLV_REQ_OID,
+		LDB_CONTROL_ASQ_OID,
+		NULL
+	};
+	struct ldb_control **new_controls;
+	unsigned int i, j, k, num_ctrls;
+
+	if (controls == NULL) {
+		return NULL;
+	}
+
+	for (num_ctrls = 0; controls[num_ctrls]; num_ctrls++);
+
+	new_controls = talloc_array(mem_ctx, struct ldb_control *,
+				    num_ctrls + 1);
+	if (new_controls == NULL) {
+		return NULL;
+	}
+
+	for (j = 0, i = 0; i < num_ctrls; i++) {
+		struct ldb_control *control = controls[i];
+		if (control->oid == NULL) {
+			break;
+		}
+		for (k = 0; skip_oids[k] != NULL; k++) {
+			if (strcmp(control->oid, skip_oids[k]) == 0) {
+				break;
+			}
+		}
+		if (skip_oids[k] != NULL) {
+			continue;
+		}
+		new_controls[j] = control;
+		j++;
+	}
+	new_controls[j] = NULL;
+	return new_controls;
+}
+
 static int paged_results(struct paged_context *ac)
 {
 	struct ldb_paged_control *paged;
@@ -148,17 +297,29 @@ static int paged_results(struct paged_context *ac)
 		return LDB_ERR_OPERATIONS_ERROR;
 	}
 
-	while (ac->store->num_entries > 0 && ac->size > 0) {
-		msg = ac->store->first;
-		ret = ldb_module_send_entry(ac->req, msg->r->message, msg->r->controls);
-		if (ret != LDB_SUCCESS) {
-			return ret;
+	if (ac->req->controls != NULL) {
+		ac->down_controls = paged_copy_down_controls(ac,
+							     ac->req->controls);
+		if (ac->down_controls == NULL) {
+			return LDB_ERR_OPERATIONS_ERROR;
 		}
+	}
 
-		ac->store->first = msg->next;
-		talloc_free(msg);
-		ac->store->num_entries--;
-		ac->size--;
+	while (ac->store->next_entry < ac->store->num_entries &&
+	       ac->size > 0) {
+		i = ac->store->next_entry++;
+
+		ret = paged_search_by_dn(ac, ac->store->dn_list[i]);
+		TALLOC_FREE(ac->store->dn_list[i]);
+
+		if (ret == LDB_ERR_NO_SUCH_OBJECT) {
+			/* The entry has gone since the search was
+			   made, so we quietly send the next one
+			   instead. */
+			continue;
+		} else if (ret != LDB_SUCCESS) {
+			return ret;
+		}
 	}
 
 	while (ac->store->first_ref != NULL) {
@@ -217,7 +378,7 @@ static int paged_results(struct paged_context *ac)
 		paged->cookie = NULL;
 		paged->cookie_len = 0;
 	} else {
-		paged->size = ac->store->num_entries;
+		paged->size = ac->store->num_entries - ac->store->next_entry;
 		paged->cookie = talloc_strdup(paged, ac->store->cookie);
 		paged->cookie_len = strlen(paged->cookie) + 1;
 	}
@@ -229,6 +390,7 @@ static int paged_search_callback(struct ldb_request *req, struct ldb_reply *ares
 {
 	struct paged_context *ac ;
 	struct message_store *msg_store;
+	struct results_store *store;
 	int ret;
 
 	ac = talloc_get_type(req->context, struct paged_context);
@@ -244,22 +406,27 @@ static int paged_search_callback(struct ldb_request *req, struct ldb_reply *ares
 
 	switch (ares->type) {
 	case LDB_REPLY_ENTRY:
-		msg_store = talloc(ac->store, struct message_store);
-		if (msg_store == NULL) {
-			return ldb_module_done(ac->req, NULL, NULL,
+		store = ac->store;
+		if (store->num_entries == store->result_array_size) {
+			store->result_array_size = MAX(16,
+					store->result_array_size * 2);
+			store->dn_list = talloc_realloc(store, store->dn_list,
+							char *,
+							store->result_array_size);
+			if (store->dn_list == NULL) {
+				return ldb_module_done(ac->req, NULL, NULL,
 						LDB_ERR_OPERATIONS_ERROR);
+			}
 		}
-		msg_store->next = NULL;
-		msg_store->r = talloc_steal(msg_store, ares);
-
-		if (ac->store->first == NULL) {
-			ac->store->first = msg_store;
-		} else {
-			ac->store->last->next = msg_store;
+		store->dn_list[store->num_entries] =
+			ldb_dn_alloc_linearized(store->dn_list,
+						ares->message->dn);
+		if (store->dn_list[store->num_entries] == NULL) {
+			return ldb_module_done(ac->req, NULL, NULL,
+						LDB_ERR_OPERATIONS_ERROR);
 		}
-		ac->store->last = msg_store;
-
-		ac->store->num_entries++;
+		store->num_entries++;
+		talloc_free(ares);
 
 		break;
 
@@ -282,6 +449,18 @@ static int paged_search_callback(struct ldb_request *req, struct ldb_reply *ares
 		break;
 
 	case LDB_REPLY_DONE:
+		store = ac->store;
+		if (store->num_entries != 0) {
+			store->dn_list = talloc_realloc(store, store->dn_list,
+							char *,
+							store->num_entries);
+			if (store->dn_list == NULL) {
+				return ldb_module_done(ac->req, NULL, NULL,
+						LDB_ERR_OPERATIONS_ERROR);
+			}
+		}
+		store->result_array_size = store->num_entries;
+
 		ac->store->controls = talloc_move(ac->store, &ares->controls);
 		ret = paged_results(ac);
 		return ldb_module_done(ac->req, ac->controls,
@@ -336,6 +515,8 @@ static int paged_search(struct ldb_module *module, struct ldb_request *req)
 
 	/* check if it is a continuation search the store */
 	if (paged_ctrl->cookie_len == 0) {
+		static const char * const no_attrs[] = { NULL };
+
 		if (paged_ctrl->size == 0) {
 			return LDB_ERR_OPERATIONS_ERROR;
 		}
@@ -349,7 +530,7 @@ static int paged_search(struct ldb_module *module, struct ldb_request *req)
 						req->op.search.base,
 						req->op.search.scope,
 						req->op.search.tree,
-						req->op.search.attrs,
+						no_attrs,
 						req->controls,
 						ac,
 						paged_search_callback,
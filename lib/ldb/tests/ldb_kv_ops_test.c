@@ -1350,6 +1350,125 @@ static void test_delete_transaction_isolation(void **state)
 }
 
 
+static void assert_search_value(struct ldb_context *ldb,
+				const char *dn_str,
+				const char *expected)
+{
+	struct ldb_result *res = NULL;
+	struct ldb_dn *dn = NULL;
+	const char *attrs[] = { "value", NULL };
+	int ret;
+
+	dn = ldb_dn_new(ldb, ldb, dn_str);
+	assert_non_null(dn);
+
+	ret = ldb_search(ldb, ldb, &res, dn, LDB_SCOPE_BASE, attrs, NULL);
+	assert_int_equal(ret, LDB_SUCCESS);
+	assert_int_equal(res->count, 1);
+	assert_string_equal(ldb_msg_find_attr_as_string(res->msgs[0],
+							"value", NULL),
+			    expected);
+	talloc_free(res);
+	talloc_free(dn);
+}
+
+static void modify_value(struct ldb_context *ldb,
+			 const char *dn_str,
+			 const char *value)
+{
+	struct ldb_message *msg = NULL;
+	int ret;
+
+	msg = ldb_msg_new(ldb);
+	assert_non_null(msg);
+	msg->dn = ldb_dn_new(msg, ldb, dn_str);
+	assert_non_null(msg->dn);
+
+	ret = ldb_msg_add_empty(msg, "value", LDB_FLAG_MOD_REPLACE, NULL);
+	assert_int_equal(ret, LDB_SUCCESS);
+	ret = ldb_msg_add_string(msg, "value", value);
+	assert_int_equal(ret, LDB_SUCCESS);
+
+	ret = ldb_modify(ldb, msg);
+	assert_int_equal(ret, LDB_SUCCESS);
+	talloc_free(msg);
+}
+
+/*
+ * Test that searches are answered from the cache of unpacked records,
+ * and that it does not hide changes made by this or another process.
+ */
+static void test_object_cache(void **state)
+{
+	int ret;
+	struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+							  struct test_ctx);
+	struct ltdb_private *ltdb = get_ltdb(test_ctx->ldb);
+	struct ldb_message *msg = NULL;
+	const char *DN = "dc=cache,dc=samba,dc=org";
+	uint64_t hits, misses;
+	pid_t pid, w_pid;
+	int wstatus;
+
+	assert_non_null(ltdb->obj_cache);
+
+	msg = ldb_msg_new(test_ctx);
+	assert_non_null(msg);
+	msg->dn = ldb_dn_new(msg, test_ctx->ldb, DN);
+	assert_non_null(msg->dn);
+	ret = ldb_msg_add_string(msg, "objectUUID", "0123456789abcdef");
+	assert_int_equal(ret, LDB_SUCCESS);
+	ret = ldb_msg_add_string(msg, "value", "1");
+	assert_int_equal(ret, LDB_SUCCESS);
+	ret = ldb_add(test_ctx->ldb, msg);
+	assert_int_equal(ret, LDB_SUCCESS);
+	talloc_free(msg);
+
+	/*
+	 * The first search fills the cache, the second is a hit
+	 */
+	misses = ltdb->obj_cache->misses;
+	assert_search_value(test_ctx->ldb, DN, "1");
+	assert_int_equal(ltdb->obj_cache->misses, misses + 1);
+
+	hits = ltdb->obj_cache->hits;
+	assert_search_value(test_ctx->ldb, DN, "1");
+	assert_int_equal(ltdb->obj_cache->hits, hits + 1);
+
+	/*
+	 * Our own change is seen
+	 */
+	modify_value(test_ctx->ldb, DN, "2");
+	assert_search_value(test_ctx->ldb, DN, "2");
+	assert_search_value(test_ctx->ldb, DN, "2");
+
+	/*
+	 * And so is a change made by another process
+	 */
+	pid = fork();
+	if (pid == 0) {
+		struct ldb_context *ldb = NULL;
+
+		ldb = ldb_init(test_ctx, test_ctx->ev);
+		ret = ldb_connect(ldb, test_ctx->dbpath, 0, NULL);
+		if (ret != LDB_SUCCESS) {
+			print_error(__location__": ldb_connect returned (%d)\n",
+				    ret);
+			exit(ret);
+		}
+		modify_value(ldb, DN, "3");
+		exit(LDB_SUCCESS);
+	}
+	w_pid = waitpid(pid, &wstatus, 0);
+	assert_int_equal(w_pid, pid);
+	assert_true(WIFEXITED(wstatus));
+	assert_int_equal(WEXITSTATUS(wstatus), LDB_SUCCESS);
+
+	misses = ltdb->obj_cache->misses;
+	assert_search_value(test_ctx->ldb, DN, "3");
+	assert_int_equal(ltdb->obj_cache->misses, misses + 1);
+}
+
 int main(int argc, const char **argv)
 {
 	const struct CMUnitTest tests[] = {
@@ -1389,6 +1508,10 @@ int main(int argc, const char **argv)
 			test_delete_transaction_isolation,
 			setup,
 			teardown),
+		cmocka_unit_test_setup_teardown(
+			test_object_cache,
+			setup,
+			teardown),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,346 @@
+/*
+ * Tests for compiled ldb search filters
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * from cmocka.c:
+ * These headers or their equivalents should be included prior to
+ * including
+ * this header file.
+ *
+ * #include <stdarg.h>
+ * #include <stddef.h>
+ * #include <setjmp.h>
+ *
+ * This allows test applications to use custom definitions of C standard
+ * library functions and types.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <talloc.h>
+
+#include <ldb.h>
+#include <ldb_module.h>
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(a) (sizeof(a)/sizeof(a[0]))
+#endif
+
+struct test_ctx {
+	struct ldb_context *ldb;
+	struct ldb_message **msgs;
+	unsigned int num_msgs;
+};
+
+static const char *test_ldif =
+	"dn: cn=Smith John,ou=People,dc=example,dc=com\n"
+	"objectClass: person\n"
+	"objectClass: user\n"
+	"cn: Smith John\n"
+	"sn: Smith\n"
+	"description: first line\n"
+	"description: the second  line\n"
+	"uSNChanged: 4100\n"
+	"userAccountControl: 514\n"
+	"\n"
+	"dn: cn=jones,ou=People,dc=example,dc=com\n"
+	"objectClass: person\n"
+	"cn: jones\n"
+	"sn: JONES\n"
+	"uSNChanged: 12\n"
+	"userAccountControl: 512\n"
+	"\n"
+	"dn: ou=People,dc=example,dc=com\n"
+	"objectClass: organizationalUnit\n"
+	"ou: People\n"
+	"\n"
+	"dn: cn=aaa,dc=example,dc=com\n"
+	"objectClass: group\n"
+	"cn: aaa\n"
+	"member: cn=jones,ou=People,dc=example,dc=com\n"
+	"uSNChanged: -3\n"
+	"\n";
+
+/*
+ * Filters with every kind of node, including ones that do not parse
+ * their values (bad integers, bad DNs) and ones that give errors
+ */
+static const char *test_filters[] = {
+	"(objectClass=person)",
+	"(objectclass=PERSON)",
+	"(sn=smith)",
+	"(sn=nobody)",
+	"(cn=*)",
+	"(dn=*)",
+	"(noSuchAttr=*)",
+	"(cn=sm*)",
+	"(cn=*john)",
+	"(cn=*it*)",
+	"(cn=s*th*j*n)",
+	"(cn=s*x*)",
+	"(cn=a*a)",
+	"(cn=aa*aa)",
+	"(description=*second line)",
+	"(description=the*second*)",
+	"(uSNChanged>=100)",
+	"(uSNChanged<=100)",
+	"(uSNChanged>=-3)",
+	"(uSNChanged<=abc)",
+	"(dn=cn=jones,ou=People,dc=example,dc=com)",
+	"(distinguishedName=CN=JONES,OU=PEOPLE,DC=EXAMPLE,DC=COM)",
+	"(dn=not a dn)",
+	"(member=cn=jones,ou=people,dc=example,dc=com)",
+	"(cn~=jones)",
+	"(userAccountControl:1.2.840.113556.1.4.803:=2)",
+	"(userAccountControl:1.2.840.113556.1.4.804:=3)",
+	"(userAccountControl:1.2.3.4:=3)",
+	"(!(objectClass=person))",
+	"(&(objectClass=person)(sn=jones))",
+	"(&(objectClass=person)(!(sn=jones)))",
+	"(|(sn=jones)(ou=people)(cn=a*))",
+	"(&(|(cn=sm*)(cn=jo*))(|(uSNChanged>=4000)(uSNChanged<=12)))",
+	"(|(&(cn=x)(cn~=y))(cn=*))",
+	"(&(cn=*)(cn~=y))",
+	"(!(|(cn=x*)(!(&(objectClass=*)(uSNChanged>=0)))))",
+	NULL
+};
+
+static int ldb_match_test_setup(void **state)
+{
+	struct test_ctx *test_ctx;
+	struct ldb_ldif *ldif;
+	const char *s = test_ldif;
+	int ret;
+
+	test_ctx = talloc_zero(NULL, struct test_ctx);
+	assert_non_null(test_ctx);
+
+	test_ctx->ldb = ldb_init(test_ctx, NULL);
+	assert_non_null(test_ctx->ldb);
+
+	ret = ldb_schema_attribute_add(test_ctx->ldb, "cn", 0,
+				       LDB_SYNTAX_DIRECTORY_STRING);
+	assert_int_equal(ret, LDB_SUCCESS);
+	ret = ldb_schema_attribute_add(test_ctx->ldb, "sn", 0,
+				       LDB_SYNTAX_DIRECTORY_STRING);
+	assert_int_equal(ret, LDB_SUCCESS);
+	ret = ldb_schema_attribute_add(test_ctx->ldb, "description", 0,
+				       LDB_SYNTAX_DIRECTORY_STRING);
+	assert_int_equal(ret, LDB_SUCCESS);
+	ret = ldb_schema_attribute_add(test_ctx->ldb, "uSNChanged", 0,
+				       LDB_SYNTAX_INTEGER);
+	assert_int_equal(ret, LDB_SUCCESS);
+	ret = ldb_schema_attribute_add(test_ctx->ldb, "member", 0,
+				       LDB_SYNTAX_DN);
+	assert_int_equal(ret, LDB_SUCCESS);
+
+	while ((ldif = ldb_ldif_read_string(test_ctx->ldb, &s)) != NULL) {
+		test_ctx->msgs = talloc_realloc(test_ctx, test_ctx->msgs,
+						struct ldb_message *,
+						test_ctx->num_msgs + 1);
+		assert_non_null(test_ctx->msgs);
+		test_ctx->msgs[test_ctx->num_msgs++]
+			= talloc_steal(test_ctx->msgs, ldif->msg);
+		talloc_free(ldif);
+	}
+	assert_int_equal(test_ctx->num_msgs, 4);
+
+	*state = test_ctx;
+	return 0;
+}
+
+static int ldb_match_test_teardown(void **state)
+{
+	struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+							  struct test_ctx);
+
+	talloc_free(test_ctx);
+	return 0;
+}
+
+/*
+ * A compiled filter must give the same result and the same error as
+ * the parse tree, for every scope
+ */
+static void test_ldb_match_compiled(void **state)
+{
+	struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+							  struct test_ctx);
+	struct ldb_context *ldb = test_ctx->ldb;
+	enum ldb_scope scopes[] = {
+		LDB_SCOPE_BASE, LDB_SCOPE_ONELEVEL, LDB_SCOPE_SUBTREE
+	};
+	struct ldb_dn *base;
+	unsigned int i, j, k;
+	unsigned int num_matched = 0;
+
+	base = ldb_dn_new(test_ctx, ldb, "ou=people,dc=example,dc=com");
+	assert_non_null(base);
+
+	for (i = 0; test_filters[i] != NULL; i++) {
+		struct ldb_parse_tree *tree;
+		struct ldb_match_program *program = NULL;
+		int ret;
+
+		tree = ldb_parse_tree(test_ctx, test_filters[i]);
+		assert_non_null(tree);
+
+		ret = ldb_match_compile(ldb, test_ctx, tree, &program);
+		assert_int_equal(ret, LDB_SUCCESS);
+
+		for (j = 0; j < test_ctx->num_msgs; j++) {
+			for (k = 0; k < ARRAY_SIZE(scopes); k++) {
+				bool matched1 = false, matched2 = false;
+				int ret1, ret2;
+
+				ret1 = ldb_match_msg_error(ldb,
+							   test_ctx->msgs[j],
+							   tree, base,
+							   scopes[k],
+							   &matched1);
+				ret2 = ldb_match_compiled_msg_error(ldb,
+								    test_ctx->msgs[j],
+								    program,
+								    base,
+								    scopes[k],
+								    &matched2);
+				if (ret1 != LDB_SUCCESS) {
+					/* matched is undefined on error */
+					matched1 = matched2 = false;
+				}
+				if (ret1 != ret2 || matched1 != matched2) {
+					print_error("%s on %s: %d/%d != %d/%d\n",
+						    test_filters[i],
+						    ldb_dn_get_linearized(
+							    test_ctx->msgs[j]->dn),
+						    ret1, matched1,
+						    ret2, matched2);
+				}
+				assert_int_equal(ret1, ret2);
+				assert_int_equal(matched1, matched2);
+				if (matched1) {
+					num_matched++;
+				}
+			}
+		}
+
+		talloc_free(program);
+		talloc_free(tree);
+	}
+
+	/* make sure the filters are not all trivially false */
+	assert_true(num_matched > 20);
+}
+
+static double timeval_elapsed_since(const struct timeval *tv)
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - tv->tv_sec) +
+		(now.tv_usec - tv->tv_usec) * 1.0e-6;
+}
+
+/*
+ * Time filter evaluation the way ltdb_search_full() does it, one
+ * filter against many records, with the parse tree and compiled.
+ * This only runs when LDB_MATCH_BENCH is set in the environment.
+ */
+static void test_ldb_match_bench(void **state)
+{
+	struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+							  struct test_ctx);
+	struct ldb_context *ldb = test_ctx->ldb;
+	const char *filters[] = {
+		"(&(objectClass=person)(|(cn=*ohn*)(sn=jo*)))",
+		"(dn=cn=jones,ou=People,dc=example,dc=com)",
+		"(&(uSNChanged>=100)(!(description=*second*)))",
+	};
+	const unsigned int loops = 100000;
+	unsigned int i, f;
+
+	for (f = 0; f < ARRAY_SIZE(filters); f++) {
+		struct ldb_parse_tree *tree;
+		struct ldb_match_program *program = NULL;
+		struct timeval tv;
+		double t_tree, t_compiled;
+		unsigned int count1 = 0, count2 = 0;
+		bool matched;
+		int ret;
+
+		tree = ldb_parse_tree(test_ctx, filters[f]);
+		assert_non_null(tree);
+
+		gettimeofday(&tv, NULL);
+		for (i = 0; i < loops; i++) {
+			ret = ldb_match_msg_error(ldb,
+						  test_ctx->msgs[i % test_ctx->num_msgs],
+						  tree, NULL, LDB_SCOPE_SUBTREE,
+						  &matched);
+			assert_int_equal(ret, LDB_SUCCESS);
+			count1 += matched;
+		}
+		t_tree = timeval_elapsed_since(&tv);
+
+		gettimeofday(&tv, NULL);
+		ret = ldb_match_compile(ldb, test_ctx, tree, &program);
+		assert_int_equal(ret, LDB_SUCCESS);
+		for (i = 0; i < loops; i++) {
+			ret = ldb_match_compiled_msg_error(ldb,
+							   test_ctx->msgs[i % test_ctx->num_msgs],
+							   program, NULL,
+							   LDB_SCOPE_SUBTREE,
+							   &matched);
+			assert_int_equal(ret, LDB_SUCCESS);
+			count2 += matched;
+		}
+		t_compiled = timeval_elapsed_since(&tv);
+
+		assert_int_equal(count1, count2);
+
+		printf("%s: %u evaluations, tree %.3fs, compiled %.3fs\n",
+		       filters[f], loops, t_tree, t_compiled);
+
+		talloc_free(program);
+		talloc_free(tree);
+	}
+}
+
+int main(int argc, const char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_ldb_match_compiled,
+						ldb_match_test_setup,
+						ldb_match_test_teardown),
+	};
+	const struct CMUnitTest bench[] = {
+		cmocka_unit_test_setup_teardown(test_ldb_match_bench,
+						ldb_match_test_setup,
+						ldb_match_test_teardown),
+	};
+	int ret;
+
+	ret = cmocka_run_group_tests(tests, NULL, NULL);
+	if (ret == 0 && getenv("LDB_MATCH_BENCH") != NULL) {
+		ret = cmocka_run_group_tests(bench, NULL, NULL);
+	}
+	return ret;
+}
@@ -362,6 +362,107 @@ static void test_ldb_msg_find_common_values(void **state)
 }
 
 
+static void test_ldb_pack_format_v2(void **state)
+{
+	struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+							  struct test_ctx);
+	struct ldb_context *ldb = NULL;
+	struct ldb_message *msg = test_ctx->msg;
+	struct ldb_message *msg2 = NULL;
+	struct ldb_val v1, v2;
+	const char *attrs[] = { "attr3", "attr1" };
+	uint32_t format;
+	unsigned int nb_elements_in_db;
+	unsigned int i, j;
+	int ret;
+
+	ldb = ldb_init(test_ctx, NULL);
+	assert_non_null(ldb);
+
+	msg->dn = ldb_dn_new(msg, ldb, "cn=test,dc=samba,dc=org");
+	assert_non_null(msg->dn);
+	add_uint_value(test_ctx, msg, "attr1", 1);
+	add_uint_value(test_ctx, msg, "attr1", 2);
+	add_uint_value(test_ctx, msg, "attr2", 3);
+	add_uint_value(test_ctx, msg, "attr3", 4);
+	add_uint_value(test_ctx, msg, "attr3", 5);
+	add_uint_value(test_ctx, msg, "attr3", 6);
+
+	ret = ldb_pack_data_format(ldb, msg, &v1, LDB_PACKING_FORMAT);
+	assert_int_equal(ret, 0);
+	ret = ldb_pack_data_format(ldb, msg, &v2, LDB_PACKING_FORMAT_V2);
+	assert_int_equal(ret, 0);
+
+	ret = ldb_pack_data_format(ldb, msg, &v2, 0x12345678);
+	assert_int_equal(ret, -1);
+
+	ret = ldb_unpack_get_format(&v1, &format);
+	assert_int_equal(ret, 0);
+	assert_int_equal(format, LDB_PACKING_FORMAT);
+	ret = ldb_unpack_get_format(&v2, &format);
+	assert_int_equal(ret, 0);
+	assert_int_equal(format, LDB_PACKING_FORMAT_V2);
+
+	/* both formats unpack to the same message */
+	msg2 = ldb_msg_new(test_ctx);
+	assert_non_null(msg2);
+	ret = ldb_unpack_data(ldb, &v2, msg2);
+	assert_int_equal(ret, 0);
+	assert_int_equal(ldb_dn_compare(msg->dn, msg2->dn), 0);
+	assert_int_equal(msg2->num_elements, msg->num_elements);
+	for (i = 0; i < msg->num_elements; i++) {
+		assert_string_equal(msg2->elements[i].name,
+				    msg->elements[i].name);
+		assert_int_equal(msg2->elements[i].num_values,
+				 msg->elements[i].num_values);
+		for (j = 0; j < msg->elements[i].num_values; j++) {
+			assert_int_equal(
+				ldb_val_equal_exact(&msg2->elements[i].values[j],
+						    &msg->elements[i].values[j]),
+				1);
+		}
+	}
+	TALLOC_FREE(msg2);
+
+	/*
+	 * A selective unpack only decodes the wanted attributes, and
+	 * with LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC the values point
+	 * into the packed buffer
+	 */
+	msg2 = ldb_msg_new(test_ctx);
+	assert_non_null(msg2);
+	ret = ldb_unpack_data_only_attr_list_flags(ldb, &v2, msg2,
+						   attrs, 2,
+						   LDB_UNPACK_DATA_FLAG_NO_DATA_ALLOC|
+						   LDB_UNPACK_DATA_FLAG_NO_VALUES_ALLOC,
+						   &nb_elements_in_db);
+	assert_int_equal(ret, 0);
+	assert_int_equal(nb_elements_in_db, 3);
+	assert_int_equal(msg2->num_elements, 2);
+	assert_null(ldb_msg_find_element(msg2, "attr2"));
+	assert_int_equal(ldb_msg_find_element(msg2, "attr1")->num_values, 2);
+	assert_int_equal(ldb_msg_find_element(msg2, "attr3")->num_values, 3);
+	for (i = 0; i < msg2->num_elements; i++) {
+		for (j = 0; j < msg2->elements[i].num_values; j++) {
+			uint8_t *p = msg2->elements[i].values[j].data;
+			assert_true(p > v2.data);
+			assert_true(p < v2.data + v2.length);
+		}
+	}
+	assert_memory_equal(
+		ldb_msg_find_element(msg2, "attr3")->values[2].data,
+		"0006", 4);
+	TALLOC_FREE(msg2);
+
+	/* a truncated record is rejected */
+	msg2 = ldb_msg_new(test_ctx);
+	assert_non_null(msg2);
+	v2.length -= 3;
+	ret = ldb_unpack_data(ldb, &v2, msg2);
+	assert_int_equal(ret, -1);
+	TALLOC_FREE(msg2);
+}
+
 
 int main(int argc, const char **argv)
 {
@@ -373,6 +474,10 @@ int main(int argc, const char **argv)
 			test_ldb_msg_find_common_values,
 			ldb_msg_setup,
 			ldb_msg_teardown),
+		cmocka_unit_test_setup_teardown(
+			test_ldb_pack_format_v2,
+			ldb_msg_setup,
+			ldb_msg_teardown),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
@@ -25,6 +25,41 @@ def tempdir():
     return tempfile.mkdtemp(dir=dir_prefix)
 
 
+_lmdb_available = None
+
+
+def lmdb_available():
+    """Is the mdb:// backend available in this build?"""
+    global _lmdb_available
+    if _lmdb_available is not None:
+        return _lmdb_available
+
+    if "HAVE_LMDB" in os.environ:
+        _lmdb_available = (os.environ["HAVE_LMDB"] == "1")
+        return _lmdb_available
+
+    testdir = tempdir()
+    try:
+        ldb.Ldb(MDB_PREFIX + os.path.join(testdir, "probe.ldb"),
+                flags=ldb.FLG_NOSYNC)
+        _lmdb_available = True
+    except ldb.LdbError:
+        _lmdb_available = False
+    finally:
+        shutil.rmtree(testdir)
+    return _lmdb_available
+
+
+class LmdbTestMixin(object):
+    """Run the tests of the class this is mixed into against the
+       mdb:// backend, if it was built"""
+    def setUp(self):
+        if not lmdb_available():
+            self.skipTest("mdb:// backend not available")
+        self.prefix = MDB_PREFIX
+        super(LmdbTestMixin, self).setUp()
+
+
 class NoContextTests(TestCase):
 
     def test_valid_attr_name(self):
@@ -1153,6 +1188,70 @@ class GUIDAndOneLevelIndexedSearchTests(SearchTests):
         self.IDXONE = True
 
 
+class PackFormatV2SearchTests(SearchTests):
+    """Test full scan searches against records in the version 2 pack
+       format, which are only partly unpacked to match the filter.
+       Adding @INDEXLIST re-indexes, converting the existing records"""
+    def setUp(self):
+        super(PackFormatV2SearchTests, self).setUp()
+        self.l.add({"dn": "@INDEXLIST",
+                    "@PACK_FORMAT": [b"2"]})
+
+
+class GUIDIndexedPackFormatV2SearchTests(SearchTests):
+    """Test searches using the GUID index against records in the
+       version 2 pack format"""
+    def setUp(self):
+        super(GUIDIndexedPackFormatV2SearchTests, self).setUp()
+
+        self.l.add({"dn": "@INDEXLIST",
+                    "@IDXATTR": [b"x", b"y", b"ou"],
+                    "@IDXGUID": [b"objectUUID"],
+                    "@IDX_DN_GUID": [b"GUID"],
+                    "@PACK_FORMAT": [b"2"]})
+        self.IDXGUID = True
+        self.IDXONE = True
+
+    def record_formats(self, prefixes=(b"GUID=",)):
+        import tdb
+        import struct
+        # tdb will not open a file twice in one process, so read a copy
+        copy = self.filename + ".copy"
+        shutil.copyfile(self.filename, copy)
+        db = tdb.Tdb(copy, 0, tdb.DEFAULT, os.O_RDONLY)
+        formats = set()
+        for key in db:
+            if key.startswith(prefixes):
+                formats.add(struct.unpack("<I", db[key][:4])[0])
+        db.close()
+        return formats
+
+    def test_pack_format_upgrade(self):
+        """Records are stored in the version 2 format"""
+        self.assertEqual(self.record_formats(), set([0x26011968]))
+        # The special records stay readable by older versions
+        self.assertEqual(self.record_formats((b"DN=@",)),
+                         set([0x26011967]))
+
+    def test_pack_format_downgrade(self):
+        """Removing @PACK_FORMAT re-indexes back to the original
+           format"""
+        m = ldb.Message.from_dict(self.l,
+                                  {"dn": "@INDEXLIST",
+                                   "@PACK_FORMAT": []},
+                                  ldb.FLAG_MOD_DELETE)
+        self.l.modify(m)
+        self.assertEqual(self.record_formats((b"GUID=", b"DN=")),
+                         set([0x26011967]))
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(&(x=y)(y=b))",
+                            attrs=["name"])
+        self.assertEqual(len(res), 1)
+        self.assertEqual(str(res[0].dn), "OU=OU12,DC=SAMBA,DC=ORG")
+        self.assertEqual(len(res[0]), 1)
+
+
 class AddModifyTests(LdbBaseTest):
     def tearDown(self):
         shutil.rmtree(self.testdir)
@@ -1408,6 +1507,624 @@ class TransIndexedAddModifyTests(IndexedAddModifyTests):
         super(TransIndexedAddModifyTests, self).tearDown()
 
 
+class RangeIndexTests(LdbBaseTest):
+    """Test >= and <= searches against attributes with an ordered
+       (@IDXORDERED) index"""
+
+    def tearDown(self):
+        shutil.rmtree(self.testdir)
+        super(RangeIndexTests, self).tearDown()
+
+        # Ensure the LDB is closed now, so we close the FD
+        del(self.l)
+
+    def indexlist(self):
+        return {"dn": "@INDEXLIST",
+                "@IDXATTR": [b"x"],
+                "@IDXORDERED": [b"usn", b"multi"]}
+
+    def setUp(self):
+        super(RangeIndexTests, self).setUp()
+        self.testdir = tempdir()
+        self.filename = os.path.join(self.testdir, "range_test.ldb")
+        self.l = ldb.Ldb(self.url(),
+                         flags=self.flags(),
+                         options=["modules:rdn_name"])
+        self.l.add({"dn": "@ATTRIBUTES",
+                    "usn": "INTEGER",
+                    "multi": "INTEGER"})
+        self.l.add(self.indexlist())
+
+        # Values either side of the bucket boundaries
+        self.usns = {}
+        for i, usn in enumerate([-3, 1, 5, 1023, 1024, 2048,
+                                 5000, 100000]):
+            dn = "OU=USN%d,DC=SAMBA,DC=ORG" % i
+            self.l.add({"dn": dn,
+                        "x": "y",
+                        "usn": str(usn),
+                        "objectUUID": b"0123456789abc%03d" % i})
+            self.usns[dn] = usn
+
+    def check_range(self, attr, values):
+        for bound in [-4, -3, 0, 1, 2, 1023, 1024, 1025, 2047,
+                      2048, 4999, 5000, 99999, 100000, 100001]:
+            res = self.l.search(base="DC=SAMBA,DC=ORG",
+                                scope=ldb.SCOPE_SUBTREE,
+                                expression="(%s>=%d)" % (attr, bound))
+            expected = set(dn for dn, v in values.items()
+                           if max(v) >= bound)
+            self.assertEqual(set(str(m.dn) for m in res), expected)
+
+            res = self.l.search(base="DC=SAMBA,DC=ORG",
+                                scope=ldb.SCOPE_SUBTREE,
+                                expression="(%s<=%d)" % (attr, bound))
+            expected = set(dn for dn, v in values.items()
+                           if min(v) <= bound)
+            self.assertEqual(set(str(m.dn) for m in res), expected)
+
+    def check_index_record(self, dn, exists):
+        # The index records are only written to disk on commit
+        if hasattr(self, 'IN_TRANSACTION'):
+            return
+        res = self.l.search(base=dn, scope=ldb.SCOPE_BASE)
+        self.assertEqual(len(res), 1 if exists else 0)
+
+    def usn_values(self):
+        return dict((dn, [v]) for dn, v in self.usns.items())
+
+    def test_range_search(self):
+        self.check_range("usn", self.usn_values())
+
+    def test_range_index_records(self):
+        self.check_index_record("@INDEX:@IDXORDERED:USN", True)
+
+        # -3 is in the bucket below 1, 5 and 1023, 1024 starts a new one
+        self.check_index_record(
+            "@INDEX:@IDXORDERED:USN:8000000000000000", True)
+        self.check_index_record(
+            "@INDEX:@IDXORDERED:USN:7FFFFFFFFFFFFFFF", True)
+        self.check_index_record(
+            "@INDEX:@IDXORDERED:USN:8000000000000001", True)
+        self.check_index_record(
+            "@INDEX:@IDXORDERED:USN:8000000000000003", False)
+
+    def test_range_search_and(self):
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(&(usn>=5)(usn<=2048)(x=y))")
+        self.assertEqual(set(str(m.dn) for m in res),
+                         set(dn for dn, v in self.usns.items()
+                             if v >= 5 and v <= 2048))
+
+    def test_range_search_or(self):
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(|(usn<=1)(usn>=5000))")
+        self.assertEqual(set(str(m.dn) for m in res),
+                         set(dn for dn, v in self.usns.items()
+                             if v <= 1 or v >= 5000))
+
+    def test_range_modify(self):
+        for dn in list(self.usns.keys()):
+            self.usns[dn] += 3000
+            m = ldb.Message()
+            m.dn = ldb.Dn(self.l, dn)
+            m["usn"] = ldb.MessageElement(str(self.usns[dn]),
+                                          ldb.FLAG_MOD_REPLACE,
+                                          "usn")
+            self.l.modify(m)
+        self.check_range("usn", self.usn_values())
+
+        # The buckets below 3000 are now empty and should be gone
+        self.check_index_record(
+            "@INDEX:@IDXORDERED:USN:8000000000000000", False)
+
+    def test_range_delete_rename(self):
+        self.l.delete("OU=USN3,DC=SAMBA,DC=ORG")
+        del self.usns["OU=USN3,DC=SAMBA,DC=ORG"]
+        self.l.rename("OU=USN4,DC=SAMBA,DC=ORG",
+                      "OU=USN4a,DC=SAMBA,DC=ORG")
+        self.usns["OU=USN4a,DC=SAMBA,DC=ORG"] \
+            = self.usns.pop("OU=USN4,DC=SAMBA,DC=ORG")
+        self.check_range("usn", self.usn_values())
+
+    def test_range_multi_valued(self):
+        values = {}
+        for i in range(4):
+            dn = "OU=MULTI%d,DC=SAMBA,DC=ORG" % i
+            v = [i, i + 1, 1500 * i + 7, -2000 * i - 9]
+            self.l.add({"dn": dn,
+                        "multi": [str(x) for x in v],
+                        "objectUUID": b"0123456789abd%03d" % i})
+            values[dn] = v
+        self.check_range("multi", values)
+
+        # Remove one of the two values in the first bucket
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, "OU=MULTI1,DC=SAMBA,DC=ORG")
+        m["multi"] = ldb.MessageElement("1", ldb.FLAG_MOD_DELETE, "multi")
+        self.l.modify(m)
+        values["OU=MULTI1,DC=SAMBA,DC=ORG"].remove(1)
+        self.check_range("multi", values)
+
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, "OU=MULTI2,DC=SAMBA,DC=ORG")
+        m["multi"] = ldb.MessageElement([], ldb.FLAG_MOD_DELETE, "multi")
+        self.l.modify(m)
+        del values["OU=MULTI2,DC=SAMBA,DC=ORG"]
+        self.check_range("multi", values)
+
+    def test_range_reindex(self):
+        # Dropping and re-adding @IDXORDERED rebuilds the index
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, "@INDEXLIST")
+        m["@IDXORDERED"] = ldb.MessageElement([], ldb.FLAG_MOD_DELETE,
+                                              "@IDXORDERED")
+        self.l.modify(m)
+        self.check_index_record("@INDEX:@IDXORDERED:USN", False)
+        self.check_range("usn", self.usn_values())
+
+        m["@IDXORDERED"] = ldb.MessageElement([b"usn"], ldb.FLAG_MOD_ADD,
+                                              "@IDXORDERED")
+        self.l.modify(m)
+        self.check_index_record("@INDEX:@IDXORDERED:USN", True)
+        self.check_range("usn", self.usn_values())
+
+
+class GUIDRangeIndexTests(RangeIndexTests):
+    """Test ordered indexes with the GUID index"""
+
+    def indexlist(self):
+        return {"dn": "@INDEXLIST",
+                "@IDXATTR": [b"x"],
+                "@IDXORDERED": [b"usn", b"multi"],
+                "@IDXGUID": [b"objectUUID"],
+                "@IDX_DN_GUID": [b"GUID"]}
+
+
+class GUIDTransRangeIndexTests(GUIDRangeIndexTests):
+    """Test ordered indexes inside a transaction"""
+    def setUp(self):
+        super(GUIDTransRangeIndexTests, self).setUp()
+        self.l.transaction_start()
+        self.IN_TRANSACTION = True
+
+    def tearDown(self):
+        self.l.transaction_commit()
+        super(GUIDTransRangeIndexTests, self).tearDown()
+
+
+class PrefixIndexTests(LdbBaseTest):
+    """Test initial substring searches against attributes with a
+       prefix (@IDXPREFIX) index"""
+
+    def tearDown(self):
+        shutil.rmtree(self.testdir)
+        super(PrefixIndexTests, self).tearDown()
+
+        # Ensure the LDB is closed now, so we close the FD
+        del(self.l)
+
+    def indexlist(self):
+        return {"dn": "@INDEXLIST",
+                "@IDXATTR": [b"x"],
+                "@IDXPREFIX": [b"sn", b"multi", b"bin"]}
+
+    def setUp(self):
+        super(PrefixIndexTests, self).setUp()
+        self.testdir = tempdir()
+        self.filename = os.path.join(self.testdir, "prefix_test.ldb")
+        self.l = ldb.Ldb(self.url(),
+                         flags=self.flags(),
+                         options=["modules:rdn_name"])
+        self.l.add({"dn": "@ATTRIBUTES",
+                    "sn": "CASE_INSENSITIVE",
+                    "multi": "CASE_INSENSITIVE"})
+        self.l.add(self.indexlist())
+
+        self.names = {}
+        for i, name in enumerate(["Smith", "smithers", "SMYTHE",
+                                  "Sm", "  Smit h", "Jones", "jonas",
+                                  "J"]):
+            dn = "OU=NAME%d,DC=SAMBA,DC=ORG" % i
+            self.l.add({"dn": dn,
+                        "x": "y",
+                        "sn": name,
+                        "objectUUID": b"0123456789abc%03d" % i})
+            self.names[dn] = [name]
+
+    def canon(self, v):
+        return " ".join(v.split()).upper()
+
+    def check_prefix(self, attr, values):
+        for prefix in ["s", "sm", "smi", "SMIT", "smith", "smithe",
+                       "smy", "jon", "JONE", "j", "x", "xyz"]:
+            res = self.l.search(base="DC=SAMBA,DC=ORG",
+                                scope=ldb.SCOPE_SUBTREE,
+                                expression="(%s=%s*)" % (attr, prefix))
+            expected = set(dn for dn, v in values.items()
+                           if any(self.canon(x).startswith(prefix.upper())
+                                  for x in v))
+            self.assertEqual(set(str(m.dn) for m in res), expected)
+
+            # Each match is returned only once
+            self.assertEqual(len(res), len(expected))
+
+    def check_index_record(self, dn, exists):
+        # The index records are only written to disk on commit
+        if hasattr(self, 'IN_TRANSACTION'):
+            return
+        res = self.l.search(base=dn, scope=ldb.SCOPE_BASE)
+        self.assertEqual(len(res), 1 if exists else 0)
+
+    def test_prefix_search(self):
+        self.check_prefix("sn", self.names)
+
+    def test_prefix_search_and(self):
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(&(x=y)(sn=smi*))")
+        self.assertEqual(set(str(m.dn) for m in res),
+                         set(["OU=NAME0,DC=SAMBA,DC=ORG",
+                              "OU=NAME1,DC=SAMBA,DC=ORG",
+                              "OU=NAME4,DC=SAMBA,DC=ORG"]))
+
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(|(sn=jon*)(sn=smy*))")
+        self.assertEqual(set(str(m.dn) for m in res),
+                         set(["OU=NAME2,DC=SAMBA,DC=ORG",
+                              "OU=NAME5,DC=SAMBA,DC=ORG",
+                              "OU=NAME6,DC=SAMBA,DC=ORG"]))
+
+    def test_prefix_search_final(self):
+        # Only the initial part of the filter is indexed
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(sn=smi*s)")
+        self.assertEqual([str(m.dn) for m in res],
+                         ["OU=NAME1,DC=SAMBA,DC=ORG"])
+
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(sn=*th*)")
+        self.assertEqual(set(str(m.dn) for m in res),
+                         set(["OU=NAME0,DC=SAMBA,DC=ORG",
+                              "OU=NAME1,DC=SAMBA,DC=ORG",
+                              "OU=NAME2,DC=SAMBA,DC=ORG"]))
+
+    def test_prefix_index_records(self):
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:SMI", True)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:SMY", True)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:SM", True)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:J", True)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:SMIT", False)
+
+    def test_prefix_index_used(self):
+        if hasattr(self, 'IN_TRANSACTION'):
+            return
+        # With the index record gone an indexed search finds nothing
+        self.l.delete("@INDEX:@IDXPREFIX:SN:SMI")
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(sn=smit*)")
+        self.assertEqual(len(res), 0)
+
+    def test_prefix_modify(self):
+        for dn in list(self.names.keys()):
+            self.names[dn] = ["X" + self.names[dn][0].strip()]
+            m = ldb.Message()
+            m.dn = ldb.Dn(self.l, dn)
+            m["sn"] = ldb.MessageElement(self.names[dn][0],
+                                           ldb.FLAG_MOD_REPLACE,
+                                           "sn")
+            self.l.modify(m)
+        self.check_prefix("sn", self.names)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:SMI", False)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:XSM", True)
+
+    def test_prefix_delete_rename(self):
+        self.l.delete("OU=NAME0,DC=SAMBA,DC=ORG")
+        del self.names["OU=NAME0,DC=SAMBA,DC=ORG"]
+        self.l.rename("OU=NAME1,DC=SAMBA,DC=ORG",
+                      "OU=NAME1a,DC=SAMBA,DC=ORG")
+        self.names["OU=NAME1a,DC=SAMBA,DC=ORG"] \
+            = self.names.pop("OU=NAME1,DC=SAMBA,DC=ORG")
+        self.check_prefix("sn", self.names)
+
+    def test_prefix_multi_valued(self):
+        values = {}
+        for i, v in enumerate([["smith", "smithson"],
+                               ["jones", "smythe", "smith"],
+                               ["jo", "jon"]]):
+            dn = "OU=MULTI%d,DC=SAMBA,DC=ORG" % i
+            self.l.add({"dn": dn,
+                        "multi": v,
+                        "objectUUID": b"0123456789abd%03d" % i})
+            values[dn] = v
+        self.check_prefix("multi", values)
+
+        # Remove one of the two values with the same prefix
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, "OU=MULTI0,DC=SAMBA,DC=ORG")
+        m["multi"] = ldb.MessageElement("smith", ldb.FLAG_MOD_DELETE,
+                                        "multi")
+        self.l.modify(m)
+        values["OU=MULTI0,DC=SAMBA,DC=ORG"].remove("smith")
+        self.check_prefix("multi", values)
+
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, "OU=MULTI1,DC=SAMBA,DC=ORG")
+        m["multi"] = ldb.MessageElement([], ldb.FLAG_MOD_DELETE, "multi")
+        self.l.modify(m)
+        del values["OU=MULTI1,DC=SAMBA,DC=ORG"]
+        self.check_prefix("multi", values)
+
+    def test_prefix_binary(self):
+        self.l.add({"dn": "OU=BIN,DC=SAMBA,DC=ORG",
+                    "bin": b"\x00\x01\x02\x03\x04",
+                    "objectUUID": b"0123456789abe000"})
+        self.check_index_record("@INDEX:@IDXPREFIX:BIN::AAEC", True)
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(bin=\\00\\01\\02\\03*)")
+        self.assertEqual([str(m.dn) for m in res],
+                         ["OU=BIN,DC=SAMBA,DC=ORG"])
+
+    def test_prefix_reindex(self):
+        # Dropping and re-adding @IDXPREFIX rebuilds the index
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, "@INDEXLIST")
+        m["@IDXPREFIX"] = ldb.MessageElement([], ldb.FLAG_MOD_DELETE,
+                                             "@IDXPREFIX")
+        self.l.modify(m)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:SMI", False)
+        self.check_prefix("sn", self.names)
+
+        m["@IDXPREFIX"] = ldb.MessageElement([b"sn"], ldb.FLAG_MOD_ADD,
+                                             "@IDXPREFIX")
+        self.l.modify(m)
+        self.check_index_record("@INDEX:@IDXPREFIX:SN:SMI", True)
+        self.check_prefix("sn", self.names)
+
+
+class GUIDPrefixIndexTests(PrefixIndexTests):
+    """Test prefix indexes with the GUID index"""
+
+    def indexlist(self):
+        return {"dn": "@INDEXLIST",
+                "@IDXATTR": [b"x"],
+                "@IDXPREFIX": [b"sn", b"multi", b"bin"],
+                "@IDXGUID": [b"objectUUID"],
+                "@IDX_DN_GUID": [b"GUID"]}
+
+
+class GUIDTransPrefixIndexTests(GUIDPrefixIndexTests):
+    """Test prefix indexes inside a transaction"""
+    def setUp(self):
+        super(GUIDTransPrefixIndexTests, self).setUp()
+        self.l.transaction_start()
+        self.IN_TRANSACTION = True
+
+    def tearDown(self):
+        self.l.transaction_commit()
+        super(GUIDTransPrefixIndexTests, self).tearDown()
+
+
+class PagedResultsTests(LdbBaseTest):
+    """Test the paged_results module, which fetches each page as it
+       is sent rather than keeping every result of the search"""
+
+    def tearDown(self):
+        shutil.rmtree(self.testdir)
+        super(PagedResultsTests, self).tearDown()
+
+        # Ensure the LDB is closed now, so we close the FD
+        del(self.l)
+
+    def indexlist(self):
+        return {"dn": "@INDEXLIST",
+                "@IDXATTR": [b"x"]}
+
+    def setUp(self):
+        super(PagedResultsTests, self).setUp()
+        self.testdir = tempdir()
+        self.filename = os.path.join(self.testdir, "paged_test.ldb")
+        self.l = ldb.Ldb(self.url(),
+                         flags=self.flags(),
+                         options=["modules:paged_results"])
+        self.l.add(self.indexlist())
+
+        self.num_users = 50
+        for i in range(self.num_users):
+            self.l.add({"dn": "CN=USER%d,DC=SAMBA,DC=ORG" % i,
+                        "x": "y",
+                        "uid": str(i),
+                        "description": "user %d" % i,
+                        "objectUUID": b"0123456789abc%03d" % i})
+
+    def paged_search(self, size, cookie=None, attrs=None):
+        control = "paged_results:1:%d" % size
+        if cookie is not None:
+            control += ":" + cookie
+        res = self.l.search(base="DC=SAMBA,DC=ORG",
+                            scope=ldb.SCOPE_SUBTREE,
+                            expression="(x=y)",
+                            attrs=attrs,
+                            controls=[control])
+        cookie = None
+        for c in res.controls:
+            parts = str(c).split(":")
+            if parts[0] == "paged_results" and len(parts) > 2:
+                cookie = parts[2]
+        return res, cookie
+
+    def test_paged_all(self):
+        """Every result is sent exactly once, with the attributes
+           asked for"""
+        seen = []
+        res, cookie = self.paged_search(7, attrs=["uid"])
+        pages = 1
+        while True:
+            self.assertLessEqual(len(res), 7)
+            for msg in res:
+                self.assertEqual(list(msg.keys()), ["dn", "uid"])
+                self.assertEqual(str(msg.dn),
+                                 "CN=USER%s,DC=SAMBA,DC=ORG" % msg["uid"])
+                seen.append(str(msg.dn))
+            if cookie is None:
+                break
+            res, cookie = self.paged_search(7, cookie, attrs=["uid"])
+            pages += 1
+
+        self.assertEqual(len(seen), self.num_users)
+        self.assertEqual(len(set(seen)), self.num_users)
+        self.assertEqual(pages, 8)
+
+    def test_paged_changes_between_pages(self):
+        """Entries deleted or changed to no longer match after the
+           first page are not sent, and the page is filled from the
+           entries after them"""
+        res, cookie = self.paged_search(10)
+        self.assertEqual(len(res), 10)
+        first = set(str(msg.dn) for msg in res)
+
+        rest = ["CN=USER%d,DC=SAMBA,DC=ORG" % i
+                for i in range(self.num_users)]
+        rest = [dn for dn in rest if dn not in first]
+        self.l.delete(rest[0])
+        self.l.delete(rest[1])
+
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, rest[2])
+        m["x"] = ldb.MessageElement("z", ldb.FLAG_MOD_REPLACE, "x")
+        self.l.modify(m)
+
+        m = ldb.Message()
+        m.dn = ldb.Dn(self.l, rest[3])
+        m["description"] = ldb.MessageElement("changed",
+                                              ldb.FLAG_MOD_REPLACE,
+                                              "description")
+        self.l.modify(m)
+
+        seen = []
+        while cookie is not None:
+            res, cookie = self.paged_search(10, cookie)
+            if cookie is not None:
+                self.assertEqual(len(res), 10)
+            for msg in res:
+                seen.append(str(msg.dn))
+                if str(msg.dn) == rest[3]:
+                    self.assertEqual(str(msg["description"]), "changed")
+
+        self.assertEqual(sorted(seen), sorted(rest[3:]))
+
+
+class GUIDPagedResultsTests(PagedResultsTests):
+    """Test the paged_results module with the GUID index"""
+
+    def indexlist(self):
+        return {"dn": "@INDEXLIST",
+                "@IDXATTR": [b"x"],
+                "@IDXGUID": [b"objectUUID"],
+                "@IDX_DN_GUID": [b"GUID"]}
+
+
+class GUIDIndexedSearchTestsLmdb(LmdbTestMixin, GUIDIndexedSearchTests):
+    pass
+
+
+class GUIDAndOneLevelIndexedSearchTestsLmdb(LmdbTestMixin,
+                                            GUIDAndOneLevelIndexedSearchTests):
+    pass
+
+
+class GUIDIndexedAddModifyTestsLmdb(LmdbTestMixin, GUIDIndexedAddModifyTests):
+    pass
+
+
+class GUIDTransIndexedAddModifyTestsLmdb(LmdbTestMixin,
+                                         GUIDTransIndexedAddModifyTests):
+    pass
+
+
+class GUIDRangeIndexTestsLmdb(LmdbTestMixin, GUIDRangeIndexTests):
+    pass
+
+
+class GUIDTransRangeIndexTestsLmdb(LmdbTestMixin, GUIDTransRangeIndexTests):
+    pass
+
+
+class GUIDPrefixIndexTestsLmdb(LmdbTestMixin, GUIDPrefixIndexTests):
+    pass
+
+
+class GUIDTransPrefixIndexTestsLmdb(LmdbTestMixin, GUIDTransPrefixIndexTests):
+    pass
+
+
+class LmdbDnKeyLengthTests(LmdbTestMixin, LdbBaseTest):
+    """Without the GUID index the DN is the LMDB key, which is limited
+       to 511 bytes"""
+    def setUp(self):
+        super(LmdbDnKeyLengthTests, self).setUp()
+        self.testdir = tempdir()
+        self.filename = os.path.join(self.testdir, "test.ldb")
+        self.l = ldb.Ldb(self.url(), flags=self.flags())
+        self.long_dn = "cn=%s,dc=test" % ("x" * 520)
+
+    def tearDown(self):
+        shutil.rmtree(self.testdir)
+        super(LmdbDnKeyLengthTests, self).tearDown()
+        del(self.l)
+
+    def test_add_long_dn(self):
+        try:
+            self.l.add({"dn": self.long_dn,
+                        "objectUUID": b"0123456789abcdef"})
+            self.fail("Should have failed to add a DN of %d bytes" %
+                      len(self.long_dn))
+        except ldb.LdbError as err:
+            enum = err.args[0]
+            self.assertEqual(enum, ldb.ERR_UNWILLING_TO_PERFORM)
+
+    def test_rename_to_long_dn(self):
+        self.l.add({"dn": "cn=short,dc=test",
+                    "objectUUID": b"0123456789abcdef"})
+        try:
+            self.l.rename("cn=short,dc=test", self.long_dn)
+            self.fail("Should have failed to rename to a DN of %d bytes" %
+                      len(self.long_dn))
+        except ldb.LdbError as err:
+            enum = err.args[0]
+            self.assertEqual(enum, ldb.ERR_UNWILLING_TO_PERFORM)
+
+        res = self.l.search(base="cn=short,dc=test", scope=ldb.SCOPE_BASE)
+        self.assertEqual(len(res), 1)
+
+    def test_search_and_delete_long_dn(self):
+        res = self.l.search(base=self.long_dn, scope=ldb.SCOPE_BASE)
+        self.assertEqual(len(res), 0)
+        try:
+            self.l.delete(self.long_dn)
+            self.fail("Should have failed to delete a missing DN")
+        except ldb.LdbError as err:
+            enum = err.args[0]
+            self.assertEqual(enum, ldb.ERR_NO_SUCH_OBJECT)
+
+    def test_add_long_dn_guid_index(self):
+        self.l.add({"dn": "@INDEXLIST",
+                    "@IDXATTR": [b"x"],
+                    "@IDXGUID": [b"objectUUID"],
+                    "@IDX_DN_GUID": [b"GUID"]})
+        self.l.add({"dn": self.long_dn,
+                    "objectUUID": b"0123456789abcdef"})
+        res = self.l.search(base=self.long_dn, scope=ldb.SCOPE_BASE)
+        self.assertEqual(len(res), 1)
+
+
 class BadIndexTests(LdbBaseTest):
     def setUp(self):
         super(BadIndexTests, self).setUp()
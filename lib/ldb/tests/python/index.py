@@ -45,6 +45,41 @@ def tempdir():
     return tempfile.mkdtemp(dir=dir_prefix)
 
 
+_lmdb_available = None
+
+
+def lmdb_available():
+    """Is the mdb:// backend available in this build?"""
+    global _lmdb_available
+    if _lmdb_available is not None:
+        return _lmdb_available
+
+    if "HAVE_LMDB" in os.environ:
+        _lmdb_available = (os.environ["HAVE_LMDB"] == "1")
+        return _lmdb_available
+
+    testdir = tempdir()
+    try:
+        ldb.Ldb(MDB_PREFIX + os.path.join(testdir, "probe.ldb"),
+                flags=ldb.FLG_NOSYNC)
+        _lmdb_available = True
+    except ldb.LdbError:
+        _lmdb_available = False
+    finally:
+        shutil.rmtree(testdir)
+    return _lmdb_available
+
+
+class LmdbTestMixin(object):
+    """Run the tests of the class this is mixed into against the
+       mdb:// backend, if it was built"""
+    def setUp(self):
+        if not lmdb_available():
+            self.skipTest("mdb:// backend not available")
+        self.prefix = MDB_PREFIX
+        super(LmdbTestMixin, self).setUp()
+
+
 def contains(result, dn):
     if result is None:
         return False
@@ -1280,6 +1315,10 @@ class MaxIndexKeyLengthTests(LdbBaseTest):
             code = e.args[0]
             self.assertEqual(ldb.ERR_NO_SUCH_OBJECT, code)
 
+
+class MaxIndexKeyLengthTestsLmdb(LmdbTestMixin, MaxIndexKeyLengthTests):
+    pass
+
 if __name__ == '__main__':
     import unittest
     unittest.TestProgram()
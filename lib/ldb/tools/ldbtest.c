@@ -34,6 +34,7 @@
 #include "replace.h"
 #include "system/filesys.h"
 #include "system/time.h"
+#include "system/wait.h"
 #include "ldb.h"
 #include "tools/cmdline.h"
 
@@ -70,8 +71,8 @@ static void add_records(struct ldb_context *ldb,
         }
 #endif
 	for (i=0;i<count;i++) {
-		struct ldb_message_element el[6];
-		struct ldb_val vals[6][1];
+		struct ldb_message_element el[7];
+		struct ldb_val vals[7][1];
 		char *name;
 		TALLOC_CTX *tmp_ctx = talloc_new(ldb);
 
@@ -79,7 +80,7 @@ static void add_records(struct ldb_context *ldb,
 
 		msg.dn = ldb_dn_copy(tmp_ctx, basedn);
 		ldb_dn_add_child_fmt(msg.dn, "cn=%s", name);
-		msg.num_elements = 6;
+		msg.num_elements = 7;
 		msg.elements = el;
 
 		el[0].flags = 0;
@@ -124,6 +125,13 @@ static void add_records(struct ldb_context *ldb,
 		vals[5][0].data = (uint8_t *)name;
 		vals[5][0].length = strlen((char *)vals[5][0].data);
 
+		el[6].flags = 0;
+		el[6].name = talloc_strdup(tmp_ctx, "uSNChanged");
+		el[6].num_values = 1;
+		el[6].values = vals[6];
+		vals[6][0].data = (uint8_t *)talloc_asprintf(tmp_ctx, "%u", i + 1);
+		vals[6][0].length = strlen((char *)vals[6][0].data);
+
 		ldb_delete(ldb, msg.dn);
 
 		if (ldb_add(ldb, &msg) != LDB_SUCCESS) {
@@ -257,9 +265,200 @@ static void search_uid(struct ldb_context *ldb, struct ldb_dn *basedn,
 	printf("\n");
 }
 
+/*
+  search for the most recently changed records, the way a replication
+  partner asks for the changes since its last uSNChanged
+*/
+static void search_usn(struct ldb_context *ldb, struct ldb_dn *basedn,
+		       unsigned int nrecords, unsigned int nsearches)
+{
+	unsigned int i;
+
+	for (i=0;i<nsearches;i++) {
+		unsigned int tail = (i * 7) % nrecords;
+		unsigned int usn = nrecords - tail;
+		struct ldb_result *res = NULL;
+		int ret;
+
+		ret = ldb_search(ldb, ldb, &res, basedn, LDB_SCOPE_SUBTREE,
+				 NULL, "(uSNChanged>=%u)", usn);
+		if (ret != LDB_SUCCESS || res->count != tail + 1) {
+			printf("Failed to find (uSNChanged>=%u) - %s\n",
+			       usn, ldb_errstring(ldb));
+			exit(LDB_ERR_OPERATIONS_ERROR);
+		}
+
+		printf("Testing uSNChanged>=%u - %d  \r", usn, res->count);
+		fflush(stdout);
+
+		talloc_free(res);
+	}
+
+	printf("\n");
+}
+
+/*
+  one reader process for concurrent_test(): search on its own
+  connection and report the number of searches per second on fd
+*/
+static void concurrent_reader(unsigned int nrecords, unsigned int nsearches,
+			      int fd)
+{
+	struct ldb_context *ldb;
+	struct ldb_dn *basedn;
+	unsigned int flags = 0;
+	unsigned int i;
+	double rate;
+	int ret;
+
+	if (options->nosync) {
+		flags |= LDB_FLG_NOSYNC;
+	}
+
+	ldb = ldb_init(NULL, NULL);
+	if (ldb == NULL) {
+		exit(LDB_ERR_OPERATIONS_ERROR);
+	}
+	ret = ldb_connect(ldb, options->url, flags, NULL);
+	if (ret != LDB_SUCCESS) {
+		printf("failed to connect to %s\n", options->url);
+		exit(LDB_ERR_OPERATIONS_ERROR);
+	}
+	basedn = ldb_dn_new(ldb, ldb, options->basedn);
+
+	_start_timer();
+	for (i=0;i<nsearches;i++) {
+		int uid = (i * 700 + 17) % nrecords;
+		struct ldb_result *res = NULL;
+
+		ret = ldb_search(ldb, ldb, &res, basedn, LDB_SCOPE_SUBTREE,
+				 NULL, "(uid=TEST%d)", uid);
+		if (ret != LDB_SUCCESS || res->count != 1) {
+			printf("Failed to find (uid=TEST%d) - %s\n",
+			       uid, ldb_errstring(ldb));
+			exit(LDB_ERR_OPERATIONS_ERROR);
+		}
+		talloc_free(res);
+	}
+	rate = nsearches / _end_timer();
+
+	if (write(fd, &rate, sizeof(rate)) != sizeof(rate)) {
+		exit(LDB_ERR_OPERATIONS_ERROR);
+	}
+	talloc_free(ldb);
+	exit(LDB_SUCCESS);
+}
+
+/*
+  run LDB_TEST_READERS reader processes searching while this process
+  keeps modifying records, to compare the backends under read/write
+  contention: with tdb a search holds the all-record lock and the
+  writer has to wait, with lmdb readers work on a snapshot
+*/
+static void concurrent_test(struct ldb_context *ldb, struct ldb_dn *basedn,
+			    unsigned int nrecords, unsigned int nsearches,
+			    unsigned int nreaders)
+{
+	pid_t *pids;
+	int *fds;
+	unsigned int i, running;
+	unsigned int nmodifies = 0;
+	double search_rate = 0;
+	double elapsed;
+
+	pids = talloc_array(ldb, pid_t, nreaders);
+	fds = talloc_array(ldb, int, nreaders);
+	if (pids == NULL || fds == NULL) {
+		exit(LDB_ERR_OPERATIONS_ERROR);
+	}
+
+	for (i=0;i<nreaders;i++) {
+		int p[2];
+
+		if (pipe(p) != 0) {
+			printf("pipe failed - %s\n", strerror(errno));
+			exit(LDB_ERR_OPERATIONS_ERROR);
+		}
+		pids[i] = fork();
+		if (pids[i] == -1) {
+			printf("fork failed - %s\n", strerror(errno));
+			exit(LDB_ERR_OPERATIONS_ERROR);
+		}
+		if (pids[i] == 0) {
+			close(p[0]);
+			concurrent_reader(nrecords, nsearches, p[1]);
+		}
+		close(p[1]);
+		fds[i] = p[0];
+	}
+
+	_start_timer();
+	running = nreaders;
+	while (running > 0) {
+		struct ldb_message *msg;
+		char *mail;
+
+		msg = ldb_msg_new(ldb);
+		msg->dn = ldb_dn_copy(msg, basedn);
+		ldb_dn_add_child_fmt(msg->dn, "cn=Test%u", nmodifies % nrecords);
+		mail = talloc_asprintf(msg, "Test%u@concurrent%u.example.com",
+				       nmodifies % nrecords, nmodifies);
+		if (ldb_msg_add_string(msg, "mail", mail) != LDB_SUCCESS) {
+			exit(LDB_ERR_OPERATIONS_ERROR);
+		}
+		msg->elements[0].flags = LDB_FLAG_MOD_REPLACE;
+
+		if (ldb_modify(ldb, msg) != LDB_SUCCESS) {
+			printf("Modify of %s failed - %s\n",
+			       ldb_dn_get_linearized(msg->dn),
+			       ldb_errstring(ldb));
+			exit(LDB_ERR_OPERATIONS_ERROR);
+		}
+		talloc_free(msg);
+		nmodifies++;
+
+		for (i=0;i<nreaders;i++) {
+			int status;
+
+			if (pids[i] == 0) {
+				continue;
+			}
+			if (waitpid(pids[i], &status, WNOHANG) == pids[i]) {
+				if (!WIFEXITED(status) ||
+				    WEXITSTATUS(status) != LDB_SUCCESS) {
+					printf("reader %u failed\n", i);
+					exit(LDB_ERR_OPERATIONS_ERROR);
+				}
+				pids[i] = 0;
+				running--;
+			}
+		}
+	}
+	elapsed = _end_timer();
+
+	for (i=0;i<nreaders;i++) {
+		double rate;
+
+		if (read(fds[i], &rate, sizeof(rate)) != sizeof(rate)) {
+			printf("no result from reader %u\n", i);
+			exit(LDB_ERR_OPERATIONS_ERROR);
+		}
+		close(fds[i]);
+		search_rate += rate;
+	}
+
+	printf("%u concurrent readers: %.0f searches/sec, "
+	       "writer: %.0f modifies/sec\n",
+	       nreaders, search_rate, nmodifies / elapsed);
+
+	talloc_free(pids);
+	talloc_free(fds);
+}
+
 static void start_test(struct ldb_context *ldb, unsigned int nrecords,
 		       unsigned int nsearches)
 {
+	const char *readers;
 	struct ldb_dn *basedn;
 
 	basedn = ldb_dn_new(ldb, ldb, options->basedn);
@@ -276,6 +475,21 @@ static void start_test(struct ldb_context *ldb, unsigned int nrecords,
 	search_uid(ldb, basedn, nrecords, nsearches);
 	printf("uid search took %.2f seconds\n", _end_timer());
 
+	if (nrecords > 0) {
+		printf("Starting range search on uSNChanged\n");
+		_start_timer();
+		search_usn(ldb, basedn, nrecords, nsearches);
+		printf("uSNChanged range search took %.2f seconds\n",
+		       _end_timer());
+	}
+
+	readers = getenv("LDB_TEST_READERS");
+	if (nrecords > 0 && readers != NULL && atoi(readers) > 0) {
+		printf("Starting concurrent search and modify\n");
+		concurrent_test(ldb, basedn, nrecords, nsearches,
+				atoi(readers));
+	}
+
 	printf("Modifying records\n");
 	modify_records(ldb, basedn, nrecords);
 
@@ -399,6 +613,9 @@ static void usage(struct ldb_context *ldb)
 	printf("  --num-records  nrecords      database size to use\n");
 	printf("  --num-searches nsearches     number of searches to do\n");
 	printf("\n");
+	printf("Set LDB_TEST_READERS=n to also time n reader processes\n");
+	printf("searching concurrently with a writer.\n");
+	printf("\n");
 	printf("tests ldb API\n\n");
 	exit(LDB_ERR_OPERATIONS_ERROR);
 }
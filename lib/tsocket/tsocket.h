@@ -749,6 +749,38 @@ int _tdgram_inet_udp_broadcast_socket(const struct tsocket_address *local,
 	_tdgram_inet_udp_broadcast_socket(local, mem_ctx, dgram, __location__)
 #endif
 
+#ifdef DOXYGEN
+/**
+ * @brief Create a tdgram_context for a ipv4 or ipv6 UDP listener that
+ * shares its port with other SO_REUSEPORT sockets.
+ *
+ * Every process binding such a socket to the same address gets its own
+ * queue, and the kernel spreads the incoming datagrams over them.
+ *
+ * @param[in]  local    An 'inet' tsocket_address for the local endpoint.
+ *
+ * @param[in]  mem_ctx  The talloc memory context to use.
+ *
+ * @param[in]  dgram    The tdgram_context pointer to setup the udp
+ *                      communication. The function will allocate the memory.
+ *
+ * @return              0 on success, -1 on error with errno set,
+ *                      ENOPROTOOPT if the system has no SO_REUSEPORT.
+ *
+ * @see tdgram_inet_udp_socket()
+ */
+int tdgram_inet_udp_reuseport_socket(const struct tsocket_address *local,
+				     TALLOC_CTX *mem_ctx,
+				     struct tdgram_context **dgram);
+#else
+int _tdgram_inet_udp_reuseport_socket(const struct tsocket_address *local,
+				      TALLOC_CTX *mem_ctx,
+				      struct tdgram_context **dgram,
+				      const char *location);
+#define tdgram_inet_udp_reuseport_socket(local, mem_ctx, dgram) \
+	_tdgram_inet_udp_reuseport_socket(local, mem_ctx, dgram, __location__)
+#endif
+
 #ifdef DOXYGEN
 /**
  * @brief Create a tdgram_context for unix domain datagram communication.
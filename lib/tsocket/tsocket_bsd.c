@@ -1257,6 +1257,7 @@ static int tdgram_bsd_destructor(struct tdgram_bsd *bsds)
 static int tdgram_bsd_dgram_socket(const struct tsocket_address *local,
 				   const struct tsocket_address *remote,
 				   bool broadcast,
+				   bool reuseport,
 				   TALLOC_CTX *mem_ctx,
 				   struct tdgram_context **_dgram,
 				   const char *location)
@@ -1282,7 +1283,7 @@ static int tdgram_bsd_dgram_socket(const struct tsocket_address *local,
 
 	switch (lbsda->u.sa.sa_family) {
 	case AF_UNIX:
-		if (broadcast) {
+		if (broadcast || reuseport) {
 			errno = EINVAL;
 			return -1;
 		}
@@ -1401,6 +1402,25 @@ static int tdgram_bsd_dgram_socket(const struct tsocket_address *local,
 		}
 	}
 
+	if (reuseport) {
+#ifdef SO_REUSEPORT
+		int val = 1;
+
+		ret = setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+				 (const void *)&val, sizeof(val));
+		if (ret == -1) {
+			int saved_errno = errno;
+			talloc_free(dgram);
+			errno = saved_errno;
+			return -1;
+		}
+#else
+		talloc_free(dgram);
+		errno = ENOPROTOOPT;
+		return -1;
+#endif
+	}
+
 	if (do_bind) {
 		ret = bind(fd, &lbsda->u.sa, lbsda->sa_socklen);
 		if (ret == -1) {
@@ -1495,7 +1515,7 @@ int _tdgram_inet_udp_socket(const struct tsocket_address *local,
 		return -1;
 	}
 
-	ret = tdgram_bsd_dgram_socket(local, remote, false,
+	ret = tdgram_bsd_dgram_socket(local, remote, false, false,
 				      mem_ctx, dgram, location);
 
 	return ret;
@@ -1525,7 +1545,35 @@ int _tdgram_inet_udp_broadcast_socket(const struct tsocket_address *local,
 		return -1;
 	}
 
-	ret = tdgram_bsd_dgram_socket(local, NULL, true,
+	ret = tdgram_bsd_dgram_socket(local, NULL, true, false,
+				      mem_ctx, dgram, location);
+
+	return ret;
+}
+
+int _tdgram_inet_udp_reuseport_socket(const struct tsocket_address *local,
+				      TALLOC_CTX *mem_ctx,
+				      struct tdgram_context **dgram,
+				      const char *location)
+{
+	struct tsocket_address_bsd *lbsda =
+		talloc_get_type_abort(local->private_data,
+		struct tsocket_address_bsd);
+	int ret;
+
+	switch (lbsda->u.sa.sa_family) {
+	case AF_INET:
+		break;
+#ifdef HAVE_IPV6
+	case AF_INET6:
+		break;
+#endif
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+
+	ret = tdgram_bsd_dgram_socket(local, NULL, false, true,
 				      mem_ctx, dgram, location);
 
 	return ret;
@@ -1550,7 +1598,7 @@ int _tdgram_unix_socket(const struct tsocket_address *local,
 		return -1;
 	}
 
-	ret = tdgram_bsd_dgram_socket(local, remote, false,
+	ret = tdgram_bsd_dgram_socket(local, remote, false, false,
 				      mem_ctx, dgram, location);
 
 	return ret;
@@ -45,7 +45,12 @@ enum memcache_number {
 	SINGLETON_CACHE,
 	SMB1_SEARCH_OFFSET_MAP,
 	SHARE_MODE_LOCK_CACHE,	/* talloc */
-	VIRUSFILTER_SCAN_RESULTS_CACHE_TALLOC /* talloc */
+	VIRUSFILTER_SCAN_RESULTS_CACHE_TALLOC, /* talloc */
+	ACLREAD_SD_CACHE,
+	ACLREAD_ACCESS_CACHE,
+	DNS_RECORDS_CACHE,
+	DNS_FORWARDER_CACHE,
+	KDC_GROUP_SIDS_CACHE
 };
 
 /*
@@ -312,12 +312,14 @@ nterror:
 }
 
 /*
-  initialise a cldap_sock
+  initialise a cldap_sock, with SO_REUSEPORT set on the listener if
+  reuseport is set
 */
-NTSTATUS cldap_socket_init(TALLOC_CTX *mem_ctx,
-			   const struct tsocket_address *local_addr,
-			   const struct tsocket_address *remote_addr,
-			   struct cldap_socket **_cldap)
+static NTSTATUS cldap_socket_init_internal(TALLOC_CTX *mem_ctx,
+					   const struct tsocket_address *local_addr,
+					   const struct tsocket_address *remote_addr,
+					   bool reuseport,
+					   struct cldap_socket **_cldap)
 {
 	struct cldap_socket *c = NULL;
 	struct tsocket_address *any = NULL;
@@ -373,8 +375,13 @@ NTSTATUS cldap_socket_init(TALLOC_CTX *mem_ctx,
 		goto nomem;
 	}
 
-	ret = tdgram_inet_udp_socket(local_addr, remote_addr,
-				     c, &c->sock);
+	if (reuseport) {
+		ret = tdgram_inet_udp_reuseport_socket(local_addr,
+						       c, &c->sock);
+	} else {
+		ret = tdgram_inet_udp_socket(local_addr, remote_addr,
+					     c, &c->sock);
+	}
 	if (ret != 0) {
 		status = map_nt_error_from_unix_common(errno);
 		goto nterror;
@@ -402,6 +409,34 @@ nterror:
 	return status;
 }
 
+/*
+  initialise a cldap_sock
+*/
+NTSTATUS cldap_socket_init(TALLOC_CTX *mem_ctx,
+			   const struct tsocket_address *local_addr,
+			   const struct tsocket_address *remote_addr,
+			   struct cldap_socket **_cldap)
+{
+	return cldap_socket_init_internal(mem_ctx, local_addr, remote_addr,
+					  false, _cldap);
+}
+
+/*
+  initialise a cldap_sock listening on local_addr, sharing the port with
+  the other SO_REUSEPORT listeners
+*/
+NTSTATUS cldap_socket_init_reuseport(TALLOC_CTX *mem_ctx,
+				     const struct tsocket_address *local_addr,
+				     struct cldap_socket **_cldap)
+{
+	if (local_addr == NULL) {
+		return NT_STATUS_INVALID_PARAMETER_MIX;
+	}
+
+	return cldap_socket_init_internal(mem_ctx, local_addr, NULL,
+					  true, _cldap);
+}
+
 /*
   setup a handler for incoming requests
 */
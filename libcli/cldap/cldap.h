@@ -55,6 +55,9 @@ NTSTATUS cldap_socket_init(TALLOC_CTX *mem_ctx,
 			   const struct tsocket_address *local_addr,
 			   const struct tsocket_address *remote_addr,
 			   struct cldap_socket **_cldap);
+NTSTATUS cldap_socket_init_reuseport(TALLOC_CTX *mem_ctx,
+				     const struct tsocket_address *local_addr,
+				     struct cldap_socket **_cldap);
 
 NTSTATUS cldap_set_incoming_handler(struct cldap_socket *cldap,
 				    struct tevent_context *ev,
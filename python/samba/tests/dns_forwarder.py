@@ -188,6 +188,18 @@ class TestDnsForwarding(DNSTest):
         s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, 0)
         for i in xrange(300):
             time.sleep(0.05)
+            # A send to a port nobody has bound yet only fails on a
+            # later send, so wait until the server has bound it.
+            probe = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, 0)
+            try:
+                probe.bind((host, port))
+                continue
+            except socket.error as e:
+                if e.errno != errno.EADDRINUSE:
+                    raise
+            finally:
+                probe.close()
+
             s.connect((host, port))
             try:
                 s.send('timeout 0', 0)
@@ -604,4 +616,90 @@ class TestDnsForwarding(DNSTest):
         except socket.timeout:
             self.fail("DNS server is too slow (timeout %s)" % timeout)
 
+    def forwarded_query(self, name):
+        ad = contact_real_server(server_ip, 53)
+        p = self.make_name_packet(dns.DNS_OPCODE_QUERY)
+        q = self.make_name_question(name, dns.DNS_QTYPE_CNAME,
+                                    dns.DNS_QCLASS_IN)
+        self.finish_name_packet(p, [q])
+        p.operation |= dns.DNS_FLAG_RECURSION_DESIRED
+        ad.send(ndr.ndr_pack(p), 0)
+        ad.settimeout(timeout)
+        try:
+            data = ad.recv(0xffff + 2, 0)
+        except socket.timeout:
+            self.fail("DNS server is too slow (timeout %s)" % timeout)
+        return ndr.ndr_unpack(dns.name_packet, data)
+
+    def stop_toy_servers(self):
+        for p in self.subprocesses:
+            p.kill()
+            p.wait()
+        self.subprocesses = []
+
+    def test_cached_reply(self):
+        s = self.start_toy_server(dns_servers[0], 53, 'forwarder1')
+        s.send('ttl 300', 0)
+        name = "cached.reply"
+
+        data = self.forwarded_query(name)
+        self.assert_dns_rcode_equals(data, dns.DNS_RCODE_OK)
+        self.assertEqual('forwarder1', data.answers[0].rdata)
+        self.assertEqual(300, data.answers[0].ttl)
+
+        # The reply is now answered without the forwarder
+        self.stop_toy_servers()
+        data = self.forwarded_query(name)
+        self.assert_dns_rcode_equals(data, dns.DNS_RCODE_OK)
+        self.assertEqual('forwarder1', data.answers[0].rdata)
+        self.assertTrue(data.answers[0].ttl <= 300)
+
+        # and so is the same name in another case
+        data = self.forwarded_query(name.upper())
+        self.assert_dns_rcode_equals(data, dns.DNS_RCODE_OK)
+        self.assertEqual('forwarder1', data.answers[0].rdata)
+
+    def test_cached_nxdomain(self):
+        s = self.start_toy_server(dns_servers[0], 53, 'forwarder1')
+        s.send('ttl 300', 0)
+        name = "nxdomain.cached.reply"
+
+        data = self.forwarded_query(name)
+        self.assertEqual(data.ancount, 0)
+        self.assertEqual(data.nscount, 1)
+        self.assertEqual(data.nsrecs[0].rr_type, dns.DNS_QTYPE_SOA)
+
+        self.stop_toy_servers()
+        data = self.forwarded_query(name)
+        self.assertEqual(data.ancount, 0)
+        self.assertEqual(data.nscount, 1)
+        self.assertEqual(data.nsrecs[0].rr_type, dns.DNS_QTYPE_SOA)
+        self.assertTrue(data.nsrecs[0].ttl <= 300)
+
+    def test_reply_ttl_0_not_cached(self):
+        self.start_toy_server(dns_servers[0], 53, 'forwarder1')
+        name = "uncached.reply"
+
+        data = self.forwarded_query(name)
+        self.assert_dns_rcode_equals(data, dns.DNS_RCODE_OK)
+        self.assertEqual('forwarder1', data.answers[0].rdata)
+
+        self.stop_toy_servers()
+        data = self.forwarded_query(name)
+        self.assert_dns_rcode_equals(data, dns.DNS_RCODE_SERVFAIL)
+
+    def test_cached_reply_expires(self):
+        s = self.start_toy_server(dns_servers[0], 53, 'forwarder1')
+        s.send('ttl 1', 0)
+        name = "expiring.reply"
+
+        data = self.forwarded_query(name)
+        self.assert_dns_rcode_equals(data, dns.DNS_RCODE_OK)
+        self.assertEqual('forwarder1', data.answers[0].rdata)
+
+        self.stop_toy_servers()
+        time.sleep(2)
+        data = self.forwarded_query(name)
+        self.assert_dns_rcode_equals(data, dns.DNS_RCODE_SERVFAIL)
+
 TestProgram(module=__name__, opts=subunitopts)
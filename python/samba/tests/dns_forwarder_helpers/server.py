@@ -37,18 +37,42 @@ def debug(msg):
 
 timeout = 0
 
+# The TTL of the answers.  It is 0 unless a test asks for another, so
+# that the DNS server does not keep the answers for the tests after it.
+ttl = 0
+
 
 def answer_question(data, question):
     r = dns.res_rec()
     r.name = question.name
     r.rr_type = dns.DNS_QTYPE_CNAME
     r.rr_class = dns.DNS_QCLASS_IN
-    r.ttl = 900
+    r.ttl = ttl
     r.length = 0xffff
     r.rdata = SERVER_ID
     return r
 
 
+def no_such_name(data, question):
+    soa = dns.soa_record()
+    soa.mname = SERVER_ID
+    soa.rname = "hostmaster.%s" % SERVER_ID
+    soa.serial = 1
+    soa.refresh = 900
+    soa.retry = 600
+    soa.expire = 86400
+    soa.minimum = ttl
+
+    r = dns.res_rec()
+    r.name = question.name
+    r.rr_type = dns.DNS_QTYPE_SOA
+    r.rr_class = dns.DNS_QCLASS_IN
+    r.ttl = ttl
+    r.length = 0xffff
+    r.rdata = soa
+    return r
+
+
 class DnsHandler(SocketServer.BaseRequestHandler):
     def make_answer(self, data):
         data = ndr.ndr_unpack(dns.name_packet, data)
@@ -56,7 +80,13 @@ class DnsHandler(SocketServer.BaseRequestHandler):
         debug('answering this question:')
         debug(data.__ndr_print__())
 
-        answer = answer_question(data, data.questions[0])
+        if data.questions[0].name.startswith('nxdomain'):
+            data.nsrecs = [no_such_name(data, data.questions[0])]
+            data.nscount += 1
+            data.operation |= dns.DNS_RCODE_NXDOMAIN
+            answer = None
+        else:
+            answer = answer_question(data, data.questions[0])
         if answer is not None:
             data.answers = [answer] * 1
             data.ancount += 1
@@ -82,6 +112,13 @@ class DnsHandler(SocketServer.BaseRequestHandler):
             debug("timing out at %s" % timeout)
             return
 
+        global ttl
+        m = re.match('^ttl\s+(\d+)$', data.strip())
+        if m:
+            ttl = int(m.group(1))
+            debug("answering with ttl %s" % ttl)
+            return
+
         t = Timer(timeout, self.really_handle, [data, socket])
         t.start()
 
@@ -0,0 +1,280 @@
+# Unix SMB/CIFS implementation.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""Queries per second of the internal DNS server over UDP"""
+
+from __future__ import print_function
+import os
+import sys
+import socket
+import struct
+import time
+from samba import credentials
+from samba.dcerpc import dns, dnsserver
+from samba.netcmd.dns import data_to_dns_record
+from samba.tests.subunitrun import SubunitOptions, TestProgram
+from samba import werror, WERRORError
+from samba.tests.dns_base import DNSTest
+import samba.getopt as options
+import samba.ndr as ndr
+import optparse
+
+parser = optparse.OptionParser(
+    "dns_performance.py <server name> <server ip> [options]")
+sambaopts = options.SambaOptions(parser)
+parser.add_option_group(sambaopts)
+
+parser.add_option("--queries", type="int", dest="queries", default=5000,
+                  help="Number of queries sent by each test")
+parser.add_option("--window", type="int", dest="window", default=32,
+                  help="Number of queries in flight in the pipelined tests")
+parser.add_option("--clients", type="int", dest="clients", default=4,
+                  help="Number of client processes in the parallel tests")
+
+# use command line creds if available
+credopts = options.CredentialsOptions(parser)
+parser.add_option_group(credopts)
+subunitopts = SubunitOptions(parser)
+parser.add_option_group(subunitopts)
+
+opts, args = parser.parse_args()
+
+lp = sambaopts.get_loadparm()
+creds = credopts.get_credentials(lp)
+
+if len(args) < 2:
+    parser.print_usage()
+    sys.exit(1)
+
+server_name = args[0]
+server_ip = args[1]
+creds.set_krb_forwardable(credentials.NO_KRB_FORWARDABLE)
+
+PERF_NAME = "dnsperftest"
+PERF_IP = "10.53.57.1"
+PERF_IP2 = "10.53.57.2"
+
+
+class DNSPerformanceTests(DNSTest):
+
+    def setUp(self):
+        super(DNSPerformanceTests, self).setUp()
+        self.server = server_name
+        self.server_ip = server_ip
+        self.lp = lp
+        self.creds = creds
+        self.timeout = 10
+
+        self.conn = dnsserver.dnsserver("ncacn_ip_tcp:%s[sign]" %
+                                        self.server_ip,
+                                        self.lp, self.creds)
+        self.name = "%s.%s" % (PERF_NAME, self.get_dns_domain())
+        self.records = []
+        self.add_record(self.name, PERF_IP)
+
+    def tearDown(self):
+        for (name, data) in self.records:
+            self.delete_record(name, data)
+        super(DNSPerformanceTests, self).tearDown()
+
+    def update_record(self, name, data, add):
+        buf = dnsserver.DNS_RPC_RECORD_BUF()
+        buf.rec = data_to_dns_record(dns.DNS_QTYPE_A, data)
+        add_buf = del_buf = None
+        if add:
+            add_buf = buf
+        else:
+            del_buf = buf
+        self.conn.DnssrvUpdateRecord2(dnsserver.DNS_CLIENT_VERSION_LONGHORN,
+                                      0,
+                                      self.server,
+                                      self.get_dns_domain(),
+                                      name,
+                                      add_buf,
+                                      del_buf)
+
+    def add_record(self, name, data):
+        self.update_record(name, data, True)
+        self.records.append((name, data))
+
+    def delete_record(self, name, data):
+        try:
+            self.update_record(name, data, False)
+        except WERRORError as e:
+            if e.args[0] not in (werror.WERR_DNS_ERROR_NAME_DOES_NOT_EXIST,
+                                 werror.WERR_DNS_ERROR_RECORD_DOES_NOT_EXIST):
+                raise
+
+    def query_packet(self, name, qtype):
+        p = self.make_name_packet(dns.DNS_OPCODE_QUERY)
+        q = self.make_name_question(name, qtype, dns.DNS_QCLASS_IN)
+        self.finish_name_packet(p, [q])
+        return p
+
+    def query(self, name, qtype):
+        p = self.query_packet(name, qtype)
+        (response, response_packet) =\
+            self.dns_transaction_udp(p, host=self.server_ip)
+        return response
+
+    def send_queries(self, packet, rcode, window):
+        """Send opts.queries copies of packet over one UDP socket,
+        keeping up to window of them in flight, and return the number
+        of queries that were not answered."""
+        s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, 0)
+        s.settimeout(1)
+        s.connect((self.server_ip, 53))
+
+        sent = 0
+        received = 0
+        lost = 0
+        try:
+            while received + lost < opts.queries:
+                while (sent < opts.queries and
+                       sent - received - lost < window):
+                    s.send(struct.pack('!H', sent & 0xffff) + packet[2:])
+                    sent += 1
+                try:
+                    response = s.recv(2048)
+                except socket.timeout:
+                    # a busy server drops the queries that do not fit
+                    # in its socket buffer, give up on those in flight
+                    lost = sent - received
+                    continue
+                # the low four bits of the second flags byte are the rcode
+                self.assertEquals(ord(response[3:4]) & 0x0f, rcode)
+                received += 1
+        finally:
+            s.close()
+
+        self.assertGreater(received, 0)
+        return lost
+
+    def run_queries(self, name, qtype, rcode, window=1):
+        """Send opts.queries queries for name over one UDP socket,
+        keeping up to window of them in flight, and print the rate."""
+        packet = ndr.ndr_pack(self.query_packet(name, qtype))
+
+        start = time.time()
+        lost = self.send_queries(packet, rcode, window)
+        elapsed = time.time() - start
+
+        answered = opts.queries - lost
+        print("%d %s queries in %.2fs: %d queries/s, %d lost" %
+              (opts.queries, name, elapsed, answered / elapsed, lost),
+              file=sys.stderr)
+
+    def run_parallel_queries(self, name, qtype, rcode):
+        """Send opts.queries queries for name from each of opts.clients
+        processes, each with its own UDP socket, and print the total
+        rate. With "prefork children:dns" set the server spreads the
+        clients over its workers, so run this against 1, 2, 4 and 8
+        workers to see how the server scales."""
+        packet = ndr.ndr_pack(self.query_packet(name, qtype))
+
+        start = time.time()
+        pids = []
+        for i in range(opts.clients):
+            (r, w) = os.pipe()
+            pid = os.fork()
+            if pid == 0:
+                os.close(r)
+                status = 1
+                try:
+                    lost = self.send_queries(packet, rcode, opts.window)
+                    os.write(w, str(lost).encode('utf8'))
+                    status = 0
+                except Exception as e:
+                    print("client %d: %s" % (i, e), file=sys.stderr)
+                finally:
+                    os._exit(status)
+            os.close(w)
+            pids.append((pid, r))
+
+        lost = 0
+        for (pid, r) in pids:
+            result = os.read(r, 32)
+            os.close(r)
+            (_, status) = os.waitpid(pid, 0)
+            self.assertEquals(status, 0)
+            lost += int(result)
+        elapsed = time.time() - start
+
+        total = opts.queries * opts.clients
+        print("%d %s queries from %d clients in %.2fs: "
+              "%d queries/s, %d lost" %
+              (total, name, opts.clients, elapsed,
+               (total - lost) / elapsed, lost),
+              file=sys.stderr)
+
+    def test_udp_qps_a(self):
+        self.run_queries(self.name, dns.DNS_QTYPE_A, dns.DNS_RCODE_OK)
+
+    def test_udp_qps_srv(self):
+        name = "_ldap._tcp.%s" % self.get_dns_domain()
+        self.run_queries(name, dns.DNS_QTYPE_SRV, dns.DNS_RCODE_OK)
+
+    def test_udp_qps_nxdomain(self):
+        name = "nonexistent.%s" % self.get_dns_domain()
+        self.run_queries(name, dns.DNS_QTYPE_A, dns.DNS_RCODE_NXDOMAIN)
+
+    def test_udp_qps_a_pipelined(self):
+        self.run_queries(self.name, dns.DNS_QTYPE_A, dns.DNS_RCODE_OK,
+                         window=opts.window)
+
+    def test_udp_qps_srv_pipelined(self):
+        name = "_ldap._tcp.%s" % self.get_dns_domain()
+        self.run_queries(name, dns.DNS_QTYPE_SRV, dns.DNS_RCODE_OK,
+                         window=opts.window)
+
+    def test_udp_qps_a_parallel(self):
+        self.run_parallel_queries(self.name, dns.DNS_QTYPE_A,
+                                  dns.DNS_RCODE_OK)
+
+    def test_udp_qps_nxdomain_parallel(self):
+        name = "nonexistent.%s" % self.get_dns_domain()
+        self.run_parallel_queries(name, dns.DNS_QTYPE_A,
+                                  dns.DNS_RCODE_NXDOMAIN)
+
+    def test_changes_are_seen(self):
+        """A record changed between two queries is answered as it is
+        now, however the first answer was found."""
+        response = self.query(self.name, dns.DNS_QTYPE_A)
+        self.assert_dns_rcode_equals(response, dns.DNS_RCODE_OK)
+        self.assertEquals(response.ancount, 1)
+        self.assertEquals(response.answers[0].rdata, PERF_IP)
+
+        self.add_record(self.name, PERF_IP2)
+        response = self.query(self.name, dns.DNS_QTYPE_A)
+        self.assert_dns_rcode_equals(response, dns.DNS_RCODE_OK)
+        self.assertEquals(sorted(a.rdata for a in response.answers),
+                          [PERF_IP, PERF_IP2])
+
+        self.delete_record(self.name, PERF_IP)
+        self.delete_record(self.name, PERF_IP2)
+        response = self.query(self.name, dns.DNS_QTYPE_A)
+        self.assert_dns_rcode_equals(response, dns.DNS_RCODE_NXDOMAIN)
+
+        name = "%s2.%s" % (PERF_NAME, self.get_dns_domain())
+        response = self.query(name, dns.DNS_QTYPE_A)
+        self.assert_dns_rcode_equals(response, dns.DNS_RCODE_NXDOMAIN)
+        self.add_record(name, PERF_IP2)
+        response = self.query(name, dns.DNS_QTYPE_A)
+        self.assert_dns_rcode_equals(response, dns.DNS_RCODE_OK)
+        self.assertEquals(response.answers[0].rdata, PERF_IP2)
+
+
+TestProgram(module=__name__, opts=subunitopts)
@@ -0,0 +1,141 @@
+# Unix SMB/CIFS implementation.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""Kerberos logons per second for users in many nested groups
+
+Each logon is an AS-REQ, for which the KDC builds a PAC with the
+groups of the user, and a TGS-REQ for the host service of the DC, for
+which the KDC expands the groups in that PAC again.
+"""
+
+from __future__ import print_function
+import sys
+import time
+from samba import credentials, gensec
+from samba.auth import system_session
+from samba.samdb import SamDB
+from samba.tests.subunitrun import SubunitOptions, TestProgram
+import samba.getopt as options
+import samba.tests
+import optparse
+
+parser = optparse.OptionParser(
+    "krb5_pac_performance.py <server name> <server ip> [options]")
+sambaopts = options.SambaOptions(parser)
+parser.add_option_group(sambaopts)
+
+parser.add_option("--logons", type="int", dest="logons", default=200,
+                  help="Number of logons made by each test")
+parser.add_option("--groups", type="int", dest="groups", default=200,
+                  help="Number of nested groups in the nested tests")
+
+# use command line creds if available
+credopts = options.CredentialsOptions(parser)
+parser.add_option_group(credopts)
+subunitopts = SubunitOptions(parser)
+parser.add_option_group(subunitopts)
+
+opts, args = parser.parse_args()
+
+lp = sambaopts.get_loadparm()
+creds = credopts.get_credentials(lp)
+
+if len(args) < 2:
+    parser.print_usage()
+    sys.exit(1)
+
+server_name = args[0]
+server_ip = args[1]
+
+PERF_USER = "pacperfuser"
+PERF_GROUP = "pacperfgroup"
+PERF_PASSWORD = "P@ssw0rd.pacperf"
+
+
+class KerberosPACPerformanceTests(samba.tests.TestCase):
+
+    def setUp(self):
+        super(KerberosPACPerformanceTests, self).setUp()
+        self.lp = lp
+        self.ldb = SamDB("ldap://%s" % server_ip,
+                         credentials=creds,
+                         session_info=system_session(lp),
+                         lp=lp)
+        self.base_dn = self.ldb.domain_dn()
+        self.realm = self.lp.get("realm").upper()
+        self.groups = []
+
+        self.ldb.newuser(PERF_USER, PERF_PASSWORD)
+        self.user_dn = "CN=%s,CN=Users,%s" % (PERF_USER, self.base_dn)
+
+    def tearDown(self):
+        self.ldb.deleteuser(PERF_USER)
+        for dn in self.groups:
+            self.ldb.delete(dn)
+        super(KerberosPACPerformanceTests, self).tearDown()
+
+    def add_nested_groups(self, count):
+        """Make the user a member of the first of count groups, each of
+        which is a member of the next."""
+        member = self.user_dn
+        for i in range(count):
+            name = "%s%d" % (PERF_GROUP, i)
+            dn = "CN=%s,CN=Users,%s" % (name, self.base_dn)
+            self.ldb.add({"dn": dn,
+                          "objectclass": "group",
+                          "sAMAccountName": name,
+                          "member": member})
+            self.groups.append(dn)
+            member = dn
+
+    def logon(self):
+        """An AS-REQ for the user, then a TGS-REQ for the DC"""
+        c = credentials.Credentials()
+        c.guess(self.lp)
+        c.set_username(PERF_USER)
+        c.set_password(PERF_PASSWORD)
+        c.set_realm(self.realm)
+        c.set_kerberos_state(credentials.MUST_USE_KERBEROS)
+
+        settings = {"lp_ctx": self.lp, "target_hostname": server_name}
+        client = gensec.Security.start_client(settings)
+        client.set_credentials(c)
+        client.set_target_service("host")
+        client.start_mech_by_name("krb5")
+        (finished, token) = client.update(b"")
+        self.assertTrue(len(token) > 0)
+
+    def run_logons(self, description):
+        self.logon()
+
+        start = time.time()
+        for i in range(opts.logons):
+            self.logon()
+        elapsed = time.time() - start
+
+        print("%d logons %s in %.2fs: %.1f logons/s" %
+              (opts.logons, description, elapsed, opts.logons / elapsed),
+              file=sys.stderr)
+
+    def test_logons_no_groups(self):
+        self.run_logons("in no groups")
+
+    def test_logons_nested_groups(self):
+        self.add_nested_groups(opts.groups)
+        self.run_logons("in %d nested groups" % opts.groups)
+
+
+TestProgram(module=__name__, opts=subunitopts)
@@ -50,6 +50,54 @@ plantestsuite_loadlist("samba4.ldap.ad_dc_search_performance.python(ad_dc_ntvfs)
                         '--workgroup=$DOMAIN',
                         '$LOADLIST', '$LISTOPT'])
 
+# the same searches through the module stack alone, without the LDAP
+# server
+plantestsuite_loadlist("samba4.ldb.ad_dc_search_performance.python(ad_dc_ntvfs)",
+                       "ad_dc_ntvfs",
+                       [python,
+                        os.path.join(samba4srcdir,
+                                     "dsdb/tests/python/ad_dc_search_performance.py"),
+                        'tdb://$PREFIX_ABS/ad_dc_ntvfs/private/sam.ldb',
+                        '$LOADLIST', '$LISTOPT'])
+
+plansmbtorture4testsuite("local.dsdb.schema.speed", "none",
+                         "ncalrpc:localhost", target="samba4")
+
+plantestsuite_loadlist("samba4.ldap.ldap_pipeline_performance.python(ad_dc_ntvfs)",
+                       "ad_dc_ntvfs",
+                       [python,
+                        os.path.join(samba4srcdir,
+                                     "dsdb/tests/python/ldap_pipeline_performance.py"),
+                        '$SERVER',
+                        '$LOADLIST', '$LISTOPT'])
+
+plantestsuite_loadlist("samba4.ldap.ad_dc_password_performance.python(ad_dc_ntvfs)",
+                       "ad_dc_ntvfs",
+                       [python,
+                        os.path.join(samba4srcdir,
+                                     "dsdb/tests/python/ad_dc_password_performance.py"),
+                        '$SERVER', '-U"$USERNAME%$PASSWORD"',
+                        '--workgroup=$DOMAIN',
+                        '$LOADLIST', '$LISTOPT'])
+
+plantestsuite_loadlist("samba.tests.dns_performance(ad_dc_ntvfs)",
+                       "ad_dc_ntvfs",
+                       [python, os.path.join(srcdir(),
+                                             "python/samba/tests/dns_performance.py"),
+                        '$SERVER', '$SERVER_IP', '--machine-pass',
+                        '-U"$USERNAME%$PASSWORD"',
+                        '--workgroup=$DOMAIN',
+                        '$LOADLIST', '$LISTOPT'])
+
+plantestsuite_loadlist("samba.tests.krb5_pac_performance(ad_dc_ntvfs)",
+                       "ad_dc_ntvfs",
+                       [python, os.path.join(srcdir(),
+                                             "python/samba/tests/krb5_pac_performance.py"),
+                        '$SERVER', '$SERVER_IP',
+                        '-U"$USERNAME%$PASSWORD"',
+                        '--workgroup=$DOMAIN',
+                        '$LOADLIST', '$LISTOPT'])
+
 plantestsuite_loadlist("samba4.ldap.ad_dc_multi_bind.ntlm.python(ad_dc_ntvfs)",
                        "ad_dc_ntvfs",
                        [python, os.path.join(samba4srcdir,
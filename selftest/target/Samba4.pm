@@ -1507,6 +1507,7 @@ sub provision_ad_dc_ntvfs($$)
         rpc server port = 1027
         auth event notification = true
 	server schannel = auto
+	dsdb:pack format v2 = yes
 	";
 	my $ret = $self->provision($prefix,
 				   "domain controller",
@@ -52,6 +52,11 @@ int ctdbd_messaging_send_iov(struct ctdbd_connection *conn,
 bool ctdbd_process_exists(struct ctdbd_connection *conn, uint32_t vnn,
 			  pid_t pid, uint64_t unique_id);
 
+struct ctdb_trans3_ticket;
+int ctdbd_trans3_commit_wait(struct ctdbd_connection *conn, uint32_t vnn,
+			     const struct ctdb_trans3_ticket *ticket,
+			     int32_t *cstatus);
+
 char *ctdbd_dbpath(struct ctdbd_connection *conn,
 		   TALLOC_CTX *mem_ctx, uint32_t db_id);
 
@@ -812,6 +812,22 @@ bool ctdbd_process_exists(struct ctdbd_connection *conn, uint32_t vnn,
 	return (cstatus == 0);
 }
 
+/*
+ * Wait until a commit that node vnn has made with TRANS3_COMMIT_START
+ * has been written on all nodes
+ */
+int ctdbd_trans3_commit_wait(struct ctdbd_connection *conn, uint32_t vnn,
+			     const struct ctdb_trans3_ticket *ticket,
+			     int32_t *cstatus)
+{
+	return ctdbd_control(conn, vnn, CTDB_CONTROL_TRANS3_COMMIT_WAIT,
+			     0, 0,
+			     (TDB_DATA) {
+				     .dptr = discard_const_p(uint8_t, ticket),
+				     .dsize = sizeof(*ticket) },
+			     NULL, NULL, cstatus);
+}
+
 /*
  * Get a db path
  */
@@ -1030,6 +1046,164 @@ int ctdbd_parse(struct ctdbd_connection *conn, uint32_t db_id,
   expected.
 */
 
+/*
+ * Read and drop the rest of a streaming traverse that we gave up on,
+ * so that its batches do not turn up in later calls on this
+ * connection.
+ */
+static void ctdbd_traverse_stream_drain(struct ctdbd_connection *conn)
+{
+	while (true) {
+		struct ctdb_req_header *hdr = NULL;
+		struct ctdb_req_message_old *m;
+		struct ctdb_marshall_buffer *recs;
+		bool done = false;
+		int ret;
+
+		ret = ctdb_read_packet(conn->fd, conn->timeout, conn, &hdr);
+		if (ret != 0) {
+			DEBUG(0, ("ctdb_read_packet failed: %s\n",
+				  strerror(ret)));
+			cluster_fatal("ctdbd died\n");
+		}
+
+		if (hdr->operation == CTDB_REQ_MESSAGE) {
+			m = (struct ctdb_req_message_old *)hdr;
+			recs = (struct ctdb_marshall_buffer *)&m->data[0];
+			done = (m->srvid == conn->rand_srvid &&
+				m->datalen >= offsetof(
+					struct ctdb_marshall_buffer, data) &&
+				recs->count == 0);
+		}
+
+		TALLOC_FREE(hdr);
+		if (done) {
+			return;
+		}
+	}
+}
+
+/*
+ * Streaming traverse: ctdbd sends the records in batches of
+ * ctdb_marshall_buffer and only reads more records from the nodes once
+ * we have read the earlier batches. An empty batch ends the traverse.
+ *
+ * Returns ENOSYS if ctdbd does not support the streaming traverse.
+ */
+static int ctdbd_traverse_stream(struct ctdbd_connection *conn,
+				 uint32_t db_id,
+				 void (*fn)(TDB_DATA key, TDB_DATA data,
+					    void *private_data),
+				 void *private_data)
+{
+	struct ctdb_traverse_start_stream_old t;
+	struct ctdb_req_header *hdr = NULL;
+	TDB_DATA key, data;
+	int32_t cstatus;
+	int ret;
+
+	ZERO_STRUCT(t);
+	t.db_id = db_id;
+	t.srvid = conn->rand_srvid;
+	t.reqid = ctdbd_next_reqid(conn);
+	t.withemptyrecords = false;
+	t.prefix_len = 0;
+
+	data.dptr = (uint8_t *)&t;
+	data.dsize = offsetof(struct ctdb_traverse_start_stream_old, prefix);
+
+	ret = ctdbd_control_local(conn, CTDB_CONTROL_TRAVERSE_START_STREAM,
+				  conn->rand_srvid,
+				  0, data, NULL, NULL, &cstatus);
+	if (ret != 0) {
+		DEBUG(0,("ctdbd_control failed: %s\n", strerror(ret)));
+		return ret;
+	}
+	if (cstatus != 0) {
+		DBG_DEBUG("Streaming traverse not supported by ctdbd\n");
+		return ENOSYS;
+	}
+
+	while (true) {
+		struct ctdb_req_message_old *m;
+		struct ctdb_marshall_buffer *recs;
+		size_t offset;
+		uint32_t i;
+
+		ret = ctdb_read_packet(conn->fd, conn->timeout, conn, &hdr);
+		if (ret != 0) {
+			DEBUG(0, ("ctdb_read_packet failed: %s\n",
+				  strerror(ret)));
+			cluster_fatal("ctdbd died\n");
+		}
+
+		if (hdr->operation != CTDB_REQ_MESSAGE) {
+			DEBUG(0, ("Got operation %u, expected a message\n",
+				  (unsigned)hdr->operation));
+			goto fail;
+		}
+
+		m = (struct ctdb_req_message_old *)hdr;
+		offset = offsetof(struct ctdb_marshall_buffer, data);
+		if (m->datalen < offset) {
+			DEBUG(0, ("Got invalid traverse data of length %d\n",
+				  (int)m->datalen));
+			goto fail;
+		}
+
+		recs = (struct ctdb_marshall_buffer *)&m->data[0];
+		if (recs->count == 0) {
+			/* end of traverse */
+			TALLOC_FREE(hdr);
+			return 0;
+		}
+
+		for (i=0; i<recs->count; i++) {
+			struct ctdb_rec_data_old *d;
+
+			if (m->datalen - offset <
+			    offsetof(struct ctdb_rec_data_old, data)) {
+				DEBUG(0, ("Got truncated traverse data\n"));
+				goto fail;
+			}
+			d = (struct ctdb_rec_data_old *)&m->data[offset];
+			if (d->length > m->datalen - offset ||
+			    d->length < offsetof(struct ctdb_rec_data_old,
+						 data) +
+					(size_t)d->keylen + d->datalen) {
+				DEBUG(0, ("Got invalid record of length %d\n",
+					  (int)d->length));
+				goto fail;
+			}
+			offset += d->length;
+
+			key.dsize = d->keylen;
+			key.dptr  = &d->data[0];
+			data.dsize = d->datalen;
+			data.dptr = &d->data[d->keylen];
+
+			if (data.dsize < sizeof(struct ctdb_ltdb_header)) {
+				DEBUG(0, ("Got invalid ltdb header length "
+					  "%d\n", (int)data.dsize));
+				goto fail;
+			}
+			data.dsize -= sizeof(struct ctdb_ltdb_header);
+			data.dptr += sizeof(struct ctdb_ltdb_header);
+
+			if (fn != NULL) {
+				fn(key, data, private_data);
+			}
+		}
+
+		TALLOC_FREE(hdr);
+	}
+
+ fail:
+	TALLOC_FREE(hdr);
+	ctdbd_traverse_stream_drain(conn);
+	return EIO;
+}
+
 int ctdbd_traverse(struct ctdbd_connection *conn, uint32_t db_id,
 			void (*fn)(TDB_DATA key, TDB_DATA data,
 				   void *private_data),
@@ -1051,6 +1225,11 @@ int ctdbd_traverse(struct ctdbd_connection *conn, uint32_t db_id,
 		return EINVAL;
 	}
 
+	ret = ctdbd_traverse_stream(conn, db_id, fn, private_data);
+	if (ret != ENOSYS) {
+		return ret;
+	}
+
 	t.db_id = db_id;
 	t.srvid = conn->rand_srvid;
 	t.reqid = ctdbd_next_reqid(conn);
@@ -321,6 +321,151 @@ static bool db_ctdb_marshall_buf_parse(
 	return true;
 }
 
+/*
+ * A commit releases the g_lock of the database as soon as its changes
+ * are in the local database, before they have been replicated.  It
+ * leaves a barrier in the g_lock record, so that the next transaction
+ * waits for those changes to reach the other nodes before it reads
+ * anything.
+ */
+struct db_ctdb_transaction_barrier {
+	uint64_t seqnum;
+	uint32_t pnn;
+	struct ctdb_trans3_ticket ticket;
+};
+
+struct db_ctdb_transaction_barrier_state {
+	struct db_ctdb_transaction_barrier barrier;
+	bool found;
+};
+
+static void db_ctdb_transaction_barrier_parser(const struct g_lock_rec *locks,
+					       size_t num_locks,
+					       const uint8_t *data,
+					       size_t datalen,
+					       void *private_data)
+{
+	struct db_ctdb_transaction_barrier_state *state = private_data;
+
+	if (datalen != sizeof(state->barrier)) {
+		return;
+	}
+	memcpy(&state->barrier, data, sizeof(state->barrier));
+	state->found = true;
+}
+
+static NTSTATUS db_ctdb_fetch_db_seqnum_from_db(struct db_ctdb_ctx *db,
+						uint64_t *seqnum);
+
+/*
+ * Get the generation of the cluster, it changes with every recovery
+ */
+static int db_ctdb_fetch_generation(struct ctdbd_connection *conn,
+				    uint32_t *generation)
+{
+	struct ctdb_vnn_map_wire *map;
+	TDB_DATA outdata = { .dsize = 0 };
+	int32_t cstatus = 0;
+	int ret;
+
+	ret = ctdbd_control_local(conn, CTDB_CONTROL_GETVNNMAP, 0, 0,
+				  tdb_null, talloc_tos(), &outdata, &cstatus);
+	if ((ret != 0) || (cstatus != 0)) {
+		DEBUG(0, (__location__ " GETVNNMAP failed: ret=%d, "
+			  "cstatus=%d\n", ret, (int)cstatus));
+		return (ret != 0) ? ret : EIO;
+	}
+
+	if (outdata.dsize < offsetof(struct ctdb_vnn_map_wire, map)) {
+		TALLOC_FREE(outdata.dptr);
+		return EIO;
+	}
+
+	map = (struct ctdb_vnn_map_wire *)outdata.dptr;
+	*generation = map->generation;
+
+	TALLOC_FREE(outdata.dptr);
+	return 0;
+}
+
+/**
+ * Wait until the last commit is on this node, called with the g_lock
+ * held
+ */
+static int db_ctdb_transaction_barrier_wait(struct db_ctdb_transaction_handle *h)
+{
+	struct db_ctdb_ctx *ctx = h->ctx;
+	struct ctdbd_connection *conn = messaging_ctdb_connection();
+	struct db_ctdb_transaction_barrier_state state = { .found = false };
+	struct db_ctdb_transaction_barrier *barrier = &state.barrier;
+	uint64_t seqnum;
+	uint32_t generation;
+	int32_t cstatus;
+	NTSTATUS status;
+	int ret;
+
+	status = g_lock_dump(ctx->lock_ctx, string_term_tdb_data(h->lock_name),
+			     db_ctdb_transaction_barrier_parser, &state);
+	if (!NT_STATUS_IS_OK(status)) {
+		DEBUG(0, ("g_lock_dump failed: %s\n", nt_errstr(status)));
+		return -1;
+	}
+
+	if (!state.found || (barrier->pnn == ctdbd_vnn(conn))) {
+		/* Commits are written locally before the barrier */
+		return 0;
+	}
+
+	while (true) {
+		status = db_ctdb_fetch_db_seqnum_from_db(ctx, &seqnum);
+		if (!NT_STATUS_IS_OK(status)) {
+			DEBUG(1, (__location__ " failed to fetch the db "
+				  "sequence number on db 0x%08x\n",
+				  ctx->db_id));
+			return -1;
+		}
+
+		if (seqnum >= barrier->seqnum) {
+			return 0;
+		}
+
+		ret = ctdbd_trans3_commit_wait(conn, barrier->pnn,
+					       &barrier->ticket, &cstatus);
+		if ((ret == 0) && (cstatus == 0)) {
+			return 0;
+		}
+
+		/*
+		 * The node that made the commit is gone, or a recovery
+		 * ended the wait.  Once a recovery has made the database
+		 * the same on all nodes, the generation changes and there
+		 * is nothing left to wait for.  Our own ctdbd holds the
+		 * reply for a ticket of another node until the end of the
+		 * next recovery.
+		 */
+		DEBUG(5, (__location__ " waiting for commit on node %u on "
+			  "db 0x%08x\n", (unsigned)barrier->pnn, ctx->db_id));
+
+		ret = ctdbd_trans3_commit_wait(conn, CTDB_CURRENT_NODE,
+					       &barrier->ticket, &cstatus);
+		if ((ret != 0) || (cstatus == -1)) {
+			DEBUG(1, (__location__ " TRANS3_COMMIT_WAIT for node "
+				  "%u failed on db 0x%08x\n",
+				  (unsigned)barrier->pnn, ctx->db_id));
+			return -1;
+		}
+
+		ret = db_ctdb_fetch_generation(conn, &generation);
+		if (ret != 0) {
+			return -1;
+		}
+
+		if (generation != barrier->ticket.generation) {
+			return 0;
+		}
+	}
+}
+
 /**
  * CTDB transaction destructor
  */
@@ -391,6 +536,11 @@ static int db_ctdb_transaction_start(struct db_context *db)
 
 	talloc_set_destructor(h, db_ctdb_transaction_destructor);
 
+	if (db_ctdb_transaction_barrier_wait(h) != 0) {
+		TALLOC_FREE(h);
+		return -1;
+	}
+
 	ctx->transaction = h;
 
 	DEBUG(5,(__location__ " transaction started on db 0x%08x\n", ctx->db_id));
@@ -764,6 +914,9 @@ static int db_ctdb_transaction_commit(struct db_context *db)
 	NTSTATUS rets;
 	int32_t status;
 	struct db_ctdb_transaction_handle *h = ctx->transaction;
+	struct ctdbd_connection *conn = messaging_ctdb_connection();
+	struct db_ctdb_transaction_barrier barrier;
+	TDB_DATA outdata = { .dsize = 0 };
 	uint64_t old_seqnum, new_seqnum;
 	int ret;
 
@@ -820,9 +973,99 @@ static int db_ctdb_transaction_commit(struct db_context *db)
 		goto done;
 	}
 
+	/*
+	 * Have ctdbd write the changes to the local database.  It replies
+	 * before the other nodes have them, and replicates the commits of
+	 * all processes in groups.
+	 */
+	ret = ctdbd_control_local(conn, CTDB_CONTROL_TRANS3_COMMIT_START,
+				  h->ctx->db_id, 0,
+				  db_ctdb_marshall_finish(h->m_write),
+				  h, &outdata, &status);
+	if ((ret != 0) || (status != 0) ||
+	    (outdata.dsize != sizeof(barrier.ticket))) {
+		/*
+		 * A recovery was running, or ctdbd does not support
+		 * TRANS3_COMMIT_START.
+		 */
+		rets = db_ctdb_fetch_db_seqnum_from_db(ctx, &new_seqnum);
+		if (!NT_STATUS_IS_OK(rets)) {
+			DEBUG(1, (__location__ " failed to refetch db sequence "
+				  "number after failed TRANS3_COMMIT_START\n"));
+			ret = -1;
+			goto done;
+		}
+
+		if (new_seqnum == old_seqnum) {
+			goto again;
+		}
+		if (new_seqnum != (old_seqnum + 1)) {
+			DEBUG(0, (__location__ " ERROR: new_seqnum[%lu] != "
+				  "old_seqnum[%lu] + (0 or 1) after failed "
+				  "TRANS3_COMMIT_START - this should not "
+				  "happen!\n",
+				  (unsigned long)new_seqnum,
+				  (unsigned long)old_seqnum));
+			ret = -1;
+			goto done;
+		}
+
+		/* Recovery has written our changes on all nodes */
+		ret = 0;
+		goto done;
+	}
+
+	barrier.seqnum = old_seqnum + 1;
+	barrier.pnn = ctdbd_vnn(conn);
+	memcpy(&barrier.ticket, outdata.dptr, sizeof(barrier.ticket));
+
+	rets = g_lock_write_data(ctx->lock_ctx,
+				 string_term_tdb_data(h->lock_name),
+				 (uint8_t *)&barrier, sizeof(barrier));
+	if (NT_STATUS_IS_OK(rets)) {
+		/* Let the next transaction in */
+		h->ctx->transaction = NULL;
+		TALLOC_FREE(h);
+	} else {
+		DEBUG(1, (__location__ " failed to store the transaction "
+			  "barrier on db 0x%08x: %s\n", ctx->db_id,
+			  nt_errstr(rets)));
+	}
+
+	/* Wait until our changes are on all nodes */
+	ret = ctdbd_trans3_commit_wait(conn, CTDB_CURRENT_NODE,
+				       &barrier.ticket, &status);
+	if ((ret != 0) || (status != 0)) {
+		/*
+		 * A recovery ended the replication.  The recovery keeps
+		 * the database with the highest sequence number, so our
+		 * changes made it if they are still in the local database.
+		 */
+		rets = db_ctdb_fetch_db_seqnum_from_db(ctx, &new_seqnum);
+		if (!NT_STATUS_IS_OK(rets)) {
+			DEBUG(1, (__location__ " failed to refetch db sequence "
+				  "number after failed TRANS3_COMMIT_WAIT\n"));
+			ret = -1;
+			goto done;
+		}
+
+		if (new_seqnum < (old_seqnum + 1)) {
+			DEBUG(0, (__location__ " ERROR: new_seqnum[%lu] < "
+				  "old_seqnum[%lu] + 1 after failed "
+				  "TRANS3_COMMIT_WAIT\n",
+				  (unsigned long)new_seqnum,
+				  (unsigned long)old_seqnum));
+			ret = -1;
+			goto done;
+		}
+	}
+
+	ret = 0;
+	goto done;
+
 again:
 	/* tell ctdbd to commit to the other nodes */
-	ret = ctdbd_control_local(messaging_ctdb_connection(),
+	ret = ctdbd_control_local(conn,
 				  CTDB_CONTROL_TRANS3_COMMIT,
 				  h->ctx->db_id, 0,
 				  db_ctdb_marshall_finish(h->m_write),
@@ -865,8 +1108,8 @@ again:
 	ret = 0;
 
 done:
-	h->ctx->transaction = NULL;
-	talloc_free(h);
+	ctx->transaction = NULL;
+	TALLOC_FREE(h);
 	return ret;
 }
 
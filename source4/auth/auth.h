@@ -136,6 +136,23 @@ NTSTATUS authsam_make_user_info_dc(TALLOC_CTX *mem_ctx, struct ldb_context *sam_
 					   struct ldb_message *msg,
 					   DATA_BLOB user_sess_key, DATA_BLOB lm_sess_key,
 				  struct auth_user_info_dc **_user_info_dc);
+NTSTATUS authsam_expand_group_sids(TALLOC_CTX *mem_ctx,
+				   struct ldb_context *sam_ctx,
+				   const struct ldb_message *msg,
+				   struct dom_sid **_sids,
+				   unsigned int *_num_sids);
+NTSTATUS authsam_make_user_info_dc_sids(TALLOC_CTX *mem_ctx,
+					struct ldb_context *sam_ctx,
+					const char *netbios_name,
+					const char *domain_name,
+					const char *dns_domain_name,
+					struct ldb_dn *domain_dn,
+					struct ldb_message *msg,
+					DATA_BLOB user_sess_key,
+					DATA_BLOB lm_sess_key,
+					const struct dom_sid *sids,
+					unsigned int num_sids,
+					struct auth_user_info_dc **_user_info_dc);
 NTSTATUS authsam_update_user_info_dc(TALLOC_CTX *mem_ctx,
 			struct ldb_context *sam_ctx,
 			struct auth_user_info_dc *user_info_dc);
@@ -321,21 +321,23 @@ static NTSTATUS authsam_domain_group_filter(TALLOC_CTX *mem_ctx,
 	return NT_STATUS_OK;
 }
 
-_PUBLIC_ NTSTATUS authsam_make_user_info_dc(TALLOC_CTX *mem_ctx,
-					   struct ldb_context *sam_ctx,
-					   const char *netbios_name,
-					   const char *domain_name,
-					   const char *dns_domain_name,
-					   struct ldb_dn *domain_dn, 
-					   struct ldb_message *msg,
-					   DATA_BLOB user_sess_key,
-					   DATA_BLOB lm_sess_key,
-					   struct auth_user_info_dc **_user_info_dc)
+/*
+ * Work out the SIDs that go into the auth_user_info_dc for the account
+ * in msg: the account SID, the primary group SID, and then the SIDs of
+ * the domain groups the account is a member of, directly or through
+ * nested groups.  Builtin groups are not included.
+ *
+ * This is the part of authsam_make_user_info_dc() that searches the
+ * database, so a caller may keep the result, for as long as the
+ * database is unchanged, and pass it to authsam_make_user_info_dc_sids().
+ */
+_PUBLIC_ NTSTATUS authsam_expand_group_sids(TALLOC_CTX *mem_ctx,
+					    struct ldb_context *sam_ctx,
+					    const struct ldb_message *msg,
+					    struct dom_sid **_sids,
+					    unsigned int *_num_sids)
 {
 	NTSTATUS status;
-	struct auth_user_info_dc *user_info_dc;
-	struct auth_user_info *info;
-	const char *str = NULL;
 	char *filter = NULL;
 	/* SIDs for the account and his primary group */
 	struct dom_sid *account_sid;
@@ -349,32 +351,30 @@ _PUBLIC_ NTSTATUS authsam_make_user_info_dc(TALLOC_CTX *mem_ctx,
 	TALLOC_CTX *tmp_ctx;
 	struct ldb_message_element *el;
 
-	user_info_dc = talloc(mem_ctx, struct auth_user_info_dc);
-	NT_STATUS_HAVE_NO_MEMORY(user_info_dc);
-
-	tmp_ctx = talloc_new(user_info_dc);
-	if (user_info_dc == NULL) {
-		TALLOC_FREE(user_info_dc);
+	tmp_ctx = talloc_new(mem_ctx);
+	if (tmp_ctx == NULL) {
 		return NT_STATUS_NO_MEMORY;
 	}
 
-	sids = talloc_array(user_info_dc, struct dom_sid, 2);
+	sids = talloc_array(mem_ctx, struct dom_sid, 2);
 	if (sids == NULL) {
-		TALLOC_FREE(user_info_dc);
+		TALLOC_FREE(tmp_ctx);
 		return NT_STATUS_NO_MEMORY;
 	}
 
 	num_sids = 2;
 
-	account_sid = samdb_result_dom_sid(user_info_dc, msg, "objectSid");
+	account_sid = samdb_result_dom_sid(tmp_ctx, msg, "objectSid");
 	if (account_sid == NULL) {
-		TALLOC_FREE(user_info_dc);
+		TALLOC_FREE(sids);
+		TALLOC_FREE(tmp_ctx);
 		return NT_STATUS_NO_MEMORY;
 	}
 
 	status = dom_sid_split_rid(tmp_ctx, account_sid, &domain_sid, NULL);
 	if (!NT_STATUS_IS_OK(status)) {
-		talloc_free(user_info_dc);
+		TALLOC_FREE(sids);
+		TALLOC_FREE(tmp_ctx);
 		return status;
 	}
 
@@ -389,19 +389,22 @@ _PUBLIC_ NTSTATUS authsam_make_user_info_dc(TALLOC_CTX *mem_ctx,
 	 */
 	status = authsam_domain_group_filter(tmp_ctx, &filter);
 	if (!NT_STATUS_IS_OK(status)) {
-		TALLOC_FREE(user_info_dc);
+		TALLOC_FREE(sids);
+		TALLOC_FREE(tmp_ctx);
 		return status;
 	}
 
 	primary_group_string = dom_sid_string(tmp_ctx, &sids[PRIMARY_GROUP_SID_INDEX]);
 	if (primary_group_string == NULL) {
-		TALLOC_FREE(user_info_dc);
+		TALLOC_FREE(sids);
+		TALLOC_FREE(tmp_ctx);
 		return NT_STATUS_NO_MEMORY;
 	}
 
 	primary_group_dn = talloc_asprintf(tmp_ctx, "<SID=%s>", primary_group_string);
 	if (primary_group_dn == NULL) {
-		TALLOC_FREE(user_info_dc);
+		TALLOC_FREE(sids);
+		TALLOC_FREE(tmp_ctx);
 		return NT_STATUS_NO_MEMORY;
 	}
 
@@ -417,9 +420,10 @@ _PUBLIC_ NTSTATUS authsam_make_user_info_dc(TALLOC_CTX *mem_ctx,
 	 * 'only childs' flag to true
 	 */
 	status = dsdb_expand_nested_groups(sam_ctx, &primary_group_blob, true, filter,
-					   user_info_dc, &sids, &num_sids);
+					   mem_ctx, &sids, &num_sids);
 	if (!NT_STATUS_IS_OK(status)) {
-		talloc_free(user_info_dc);
+		TALLOC_FREE(sids);
+		TALLOC_FREE(tmp_ctx);
 		return status;
 	}
 
@@ -430,14 +434,106 @@ _PUBLIC_ NTSTATUS authsam_make_user_info_dc(TALLOC_CTX *mem_ctx,
 		 * them, as long as they meet the filter - so only
 		 * domain groups, not builtin groups */
 		status = dsdb_expand_nested_groups(sam_ctx, &el->values[i], false, filter,
-						   user_info_dc, &sids, &num_sids);
+						   mem_ctx, &sids, &num_sids);
 		if (!NT_STATUS_IS_OK(status)) {
-			talloc_free(user_info_dc);
+			TALLOC_FREE(sids);
+			TALLOC_FREE(tmp_ctx);
 			return status;
 		}
 	}
 
-	user_info_dc->sids = sids;
+	TALLOC_FREE(tmp_ctx);
+	*_sids = sids;
+	*_num_sids = num_sids;
+	return NT_STATUS_OK;
+}
+
+_PUBLIC_ NTSTATUS authsam_make_user_info_dc(TALLOC_CTX *mem_ctx,
+					   struct ldb_context *sam_ctx,
+					   const char *netbios_name,
+					   const char *domain_name,
+					   const char *dns_domain_name,
+					   struct ldb_dn *domain_dn, 
+					   struct ldb_message *msg,
+					   DATA_BLOB user_sess_key,
+					   DATA_BLOB lm_sess_key,
+					   struct auth_user_info_dc **_user_info_dc)
+{
+	struct dom_sid *sids = NULL;
+	unsigned int num_sids = 0;
+	NTSTATUS status;
+
+	status = authsam_expand_group_sids(mem_ctx, sam_ctx, msg,
+					   &sids, &num_sids);
+	if (!NT_STATUS_IS_OK(status)) {
+		return status;
+	}
+
+	status = authsam_make_user_info_dc_sids(mem_ctx, sam_ctx,
+						netbios_name,
+						domain_name,
+						dns_domain_name,
+						domain_dn,
+						msg,
+						user_sess_key,
+						lm_sess_key,
+						sids,
+						num_sids,
+						_user_info_dc);
+	TALLOC_FREE(sids);
+	return status;
+}
+
+/*
+ * As authsam_make_user_info_dc(), with the SIDs from
+ * authsam_expand_group_sids() given by the caller.
+ */
+_PUBLIC_ NTSTATUS authsam_make_user_info_dc_sids(TALLOC_CTX *mem_ctx,
+						struct ldb_context *sam_ctx,
+						const char *netbios_name,
+						const char *domain_name,
+						const char *dns_domain_name,
+						struct ldb_dn *domain_dn,
+						struct ldb_message *msg,
+						DATA_BLOB user_sess_key,
+						DATA_BLOB lm_sess_key,
+						const struct dom_sid *sids,
+						unsigned int num_sids,
+						struct auth_user_info_dc **_user_info_dc)
+{
+	NTSTATUS status;
+	struct auth_user_info_dc *user_info_dc;
+	struct auth_user_info *info;
+	const char *str = NULL;
+	struct dom_sid *domain_sid;
+	TALLOC_CTX *tmp_ctx;
+
+	if (num_sids < 2) {
+		return NT_STATUS_INVALID_PARAMETER;
+	}
+
+	user_info_dc = talloc(mem_ctx, struct auth_user_info_dc);
+	NT_STATUS_HAVE_NO_MEMORY(user_info_dc);
+
+	tmp_ctx = talloc_new(user_info_dc);
+	if (tmp_ctx == NULL) {
+		TALLOC_FREE(user_info_dc);
+		return NT_STATUS_NO_MEMORY;
+	}
+
+	status = dom_sid_split_rid(tmp_ctx, &sids[PRIMARY_USER_SID_INDEX],
+				   &domain_sid, NULL);
+	if (!NT_STATUS_IS_OK(status)) {
+		talloc_free(user_info_dc);
+		return status;
+	}
+
+	user_info_dc->sids = talloc_array(user_info_dc, struct dom_sid, num_sids);
+	if (user_info_dc->sids == NULL) {
+		TALLOC_FREE(user_info_dc);
+		return NT_STATUS_NO_MEMORY;
+	}
+	memcpy(user_info_dc->sids, sids, num_sids * sizeof(struct dom_sid));
 	user_info_dc->num_sids = num_sids;
 
 	user_info_dc->info = info = talloc_zero(user_info_dc, struct auth_user_info);
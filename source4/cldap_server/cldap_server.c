@@ -99,7 +99,7 @@ static void cldapd_request_handler(struct cldap_socket *cldap,
   start listening on the given address
 */
 static NTSTATUS cldapd_add_socket(struct cldapd_server *cldapd, struct loadparm_context *lp_ctx,
-				  const char *address)
+				  const char *address, bool reuseport)
 {
 	struct cldap_socket *cldapsock;
 	struct tsocket_address *socket_address;
@@ -120,10 +120,16 @@ static NTSTATUS cldapd_add_socket(struct cldapd_server *cldapd, struct loadparm_
 	}
 
 	/* listen for unicasts on the CLDAP port (389) */
-	status = cldap_socket_init(cldapd,
-				   socket_address,
-				   NULL,
-				   &cldapsock);
+	if (reuseport) {
+		status = cldap_socket_init_reuseport(cldapd,
+						     socket_address,
+						     &cldapsock);
+	} else {
+		status = cldap_socket_init(cldapd,
+					   socket_address,
+					   NULL,
+					   &cldapsock);
+	}
 	if (!NT_STATUS_IS_OK(status)) {
 		DEBUG(0,("Failed to bind to %s - %s\n", 
 			 tsocket_address_string(socket_address, socket_address),
@@ -143,7 +149,8 @@ static NTSTATUS cldapd_add_socket(struct cldapd_server *cldapd, struct loadparm_
   setup our listening sockets on the configured network interfaces
 */
 static NTSTATUS cldapd_startup_interfaces(struct cldapd_server *cldapd, struct loadparm_context *lp_ctx,
-					  struct interface *ifaces)
+					  struct interface *ifaces,
+					  bool reuseport)
 {
 	int i, num_interfaces;
 	TALLOC_CTX *tmp_ctx = talloc_new(cldapd);
@@ -158,7 +165,8 @@ static NTSTATUS cldapd_startup_interfaces(struct cldapd_server *cldapd, struct l
 		char **wcard = iface_list_wildcard(cldapd);
 		NT_STATUS_HAVE_NO_MEMORY(wcard);
 		for (i=0; wcard[i]; i++) {
-			status = cldapd_add_socket(cldapd, lp_ctx, wcard[i]);
+			status = cldapd_add_socket(cldapd, lp_ctx, wcard[i],
+						   reuseport);
 			if (NT_STATUS_IS_OK(status)) {
 				num_binds++;
 			}
@@ -173,7 +181,8 @@ static NTSTATUS cldapd_startup_interfaces(struct cldapd_server *cldapd, struct l
 	   so that replies always come from the right IP */
 	for (i=0; i<num_interfaces; i++) {
 		const char *address = talloc_strdup(tmp_ctx, iface_list_n_ip(ifaces, i));
-		status = cldapd_add_socket(cldapd, lp_ctx, address);
+		status = cldapd_add_socket(cldapd, lp_ctx, address,
+					   reuseport);
 		NT_STATUS_NOT_OK_RETURN(status);
 	}
 
@@ -188,7 +197,6 @@ static NTSTATUS cldapd_startup_interfaces(struct cldapd_server *cldapd, struct l
 static void cldapd_task_init(struct task_server *task)
 {
 	struct cldapd_server *cldapd;
-	NTSTATUS status;
 	struct interface *ifaces;
 	
 	load_interface_list(task, task->lp_ctx, &ifaces);
@@ -221,14 +229,31 @@ static void cldapd_task_init(struct task_server *task)
 	}
 
 	cldapd->task = task;
+	cldapd->ifaces = ifaces;
+	task->private_data = cldapd;
 	cldapd->samctx = samdb_connect(cldapd, task->event_ctx, task->lp_ctx, system_session(task->lp_ctx), 0);
 	if (cldapd->samctx == NULL) {
 		task_server_terminate(task, "cldapd failed to open samdb", true);
 		return;
 	}
+}
+
+/*
+  start listening in every process serving CLDAP, pre-forked workers
+  share the ports with SO_REUSEPORT
+*/
+static void cldapd_post_fork(struct task_server *task,
+			     struct process_details *pd)
+{
+	struct cldapd_server *cldapd =
+		talloc_get_type_abort(task->private_data,
+				      struct cldapd_server);
+	NTSTATUS status;
 
 	/* start listening on the configured network interfaces */
-	status = cldapd_startup_interfaces(cldapd, task->lp_ctx, ifaces);
+	status = cldapd_startup_interfaces(cldapd, task->lp_ctx,
+					   cldapd->ifaces,
+					   pd->instances > 1);
 	if (!NT_STATUS_IS_OK(status)) {
 		task_server_terminate(task, "cldapd failed to setup interfaces", true);
 		return;
@@ -245,7 +270,9 @@ NTSTATUS server_service_cldapd_init(TALLOC_CTX *ctx)
 {
 	struct service_details details = {
 		.inhibit_fork_on_accept = true,
-		.inhibit_pre_fork = true
+		/* pre-forked if "prefork children:cldap" is set */
+		.inhibit_pre_fork = true,
+		.post_fork = cldapd_post_fork,
 	};
 	return register_server_service(ctx, "cldap", cldapd_task_init,
 				       &details);
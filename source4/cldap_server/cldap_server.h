@@ -28,6 +28,8 @@
 struct cldapd_server {
 	struct task_server *task;
 	struct ldb_context *samctx;
+	/* listened on by each process in cldapd_post_fork() */
+	struct interface *ifaces;
 };
 
 struct ldap_SearchRequest;
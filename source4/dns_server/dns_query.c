@@ -37,6 +37,7 @@
 #include "auth/auth.h"
 #include "auth/credentials/credentials.h"
 #include "auth/gensec/gensec.h"
+#include "lib/util/memcache.h"
 
 #undef DBGC_CLASS
 #define DBGC_CLASS DBGC_DNS
@@ -269,7 +270,255 @@ static WERROR add_dns_res_rec(struct dns_res_rec **pdst,
 	return WERR_OK;
 }
 
+/*
+ * Replies from the forwarders are cached for the lowest TTL of their
+ * records.  A reply without answers is cached for the TTL the SOA in
+ * its authority section gives, as RFC 2308 describes, or not at all
+ * when there is no SOA.
+ */
+#define DNS_FORWARDER_CACHE_MAX_TTL (24 * 60 * 60)
+#define DNS_FORWARDER_CACHE_MAX_NEGATIVE_TTL (3 * 60 * 60)
+
+/* log the hit rate each time this many queries have been forwarded */
+#define DNS_FORWARDER_CACHE_REPORT 1000
+
+static DATA_BLOB forwarder_cache_key(TALLOC_CTX *mem_ctx,
+				     const struct dns_name_question *question)
+{
+	char *name = NULL;
+	char *key = NULL;
+
+	name = strlower_talloc(mem_ctx, question->name);
+	if (name == NULL) {
+		return data_blob_null;
+	}
+
+	key = talloc_asprintf(mem_ctx, "%u/%u/%s",
+			      (unsigned)question->question_class,
+			      (unsigned)question->question_type,
+			      name);
+	TALLOC_FREE(name);
+	if (key == NULL) {
+		return data_blob_null;
+	}
+
+	return data_blob_const(key, strlen(key));
+}
+
+static uint32_t forwarder_rrs_ttl(const struct dns_res_rec *rrs,
+				  uint16_t count,
+				  uint32_t ttl)
+{
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		/* the TTL of an OPT record holds flags */
+		if (rrs[i].rr_type == DNS_QTYPE_OPT) {
+			continue;
+		}
+		ttl = MIN(ttl, rrs[i].ttl);
+	}
+
+	return ttl;
+}
+
+static uint32_t forwarder_reply_ttl(const struct dns_name_packet *reply)
+{
+	uint16_t rcode = reply->operation & DNS_RCODE;
+	uint32_t ttl = DNS_FORWARDER_CACHE_MAX_TTL;
+	uint16_t i;
+
+	if (rcode != DNS_RCODE_OK && rcode != DNS_RCODE_NXDOMAIN) {
+		return 0;
+	}
+	if (reply->operation & DNS_FLAG_TRUNCATION) {
+		return 0;
+	}
+
+	if (reply->ancount == 0) {
+		for (i = 0; i < reply->nscount; i++) {
+			const struct dns_res_rec *rr = &reply->nsrecs[i];
+
+			if (rr->rr_type != DNS_QTYPE_SOA) {
+				continue;
+			}
+			ttl = MIN(rr->ttl, rr->rdata.soa_record.minimum);
+			return MIN(ttl, DNS_FORWARDER_CACHE_MAX_NEGATIVE_TTL);
+		}
+		return 0;
+	}
+
+	ttl = forwarder_rrs_ttl(reply->answers, reply->ancount, ttl);
+	ttl = forwarder_rrs_ttl(reply->nsrecs, reply->nscount, ttl);
+	ttl = forwarder_rrs_ttl(reply->additional, reply->arcount, ttl);
+
+	return ttl;
+}
+
+static void forwarder_rrs_age(struct dns_res_rec *rrs,
+			      uint16_t count,
+			      uint32_t age)
+{
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		if (rrs[i].rr_type == DNS_QTYPE_OPT) {
+			continue;
+		}
+		if (rrs[i].ttl > age) {
+			rrs[i].ttl -= age;
+		} else {
+			rrs[i].ttl = 0;
+		}
+	}
+}
+
+static void forwarder_cache_count(struct dns_server *dns, bool hit)
+{
+	uint64_t total;
+
+	if (hit) {
+		dns->forwarder_cache_hits += 1;
+	} else {
+		dns->forwarder_cache_misses += 1;
+	}
+
+	total = dns->forwarder_cache_hits + dns->forwarder_cache_misses;
+	if (total % DNS_FORWARDER_CACHE_REPORT != 0) {
+		return;
+	}
+
+	DBG_NOTICE("forwarder cache: %"PRIu64" hits, %"PRIu64" misses, "
+		   "%"PRIu64"%% hit rate\n",
+		   dns->forwarder_cache_hits,
+		   dns->forwarder_cache_misses,
+		   dns->forwarder_cache_hits * 100 / total);
+}
+
+/*
+ * A cache entry is the time it was stored at, its TTL, and the reply
+ * as it came from the forwarder.
+ */
+static void forwarder_cache_add(struct dns_server *dns,
+				const struct dns_name_question *question,
+				struct dns_name_packet *reply)
+{
+	TALLOC_CTX *tmp_ctx = NULL;
+	enum ndr_err_code ndr_err;
+	DATA_BLOB key;
+	DATA_BLOB packet;
+	DATA_BLOB value;
+	uint32_t ttl;
+
+	if (dns->forwarder_cache == NULL) {
+		return;
+	}
+
+	ttl = forwarder_reply_ttl(reply);
+	if (ttl == 0) {
+		return;
+	}
+
+	tmp_ctx = talloc_new(dns);
+	if (tmp_ctx == NULL) {
+		return;
+	}
+
+	key = forwarder_cache_key(tmp_ctx, question);
+	if (key.data == NULL) {
+		TALLOC_FREE(tmp_ctx);
+		return;
+	}
+
+	ndr_err = ndr_push_struct_blob(&packet, tmp_ctx, reply,
+			(ndr_push_flags_fn_t)ndr_push_dns_name_packet);
+	if (!NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+		TALLOC_FREE(tmp_ctx);
+		return;
+	}
+
+	value = data_blob_talloc(tmp_ctx, NULL, 12 + packet.length);
+	if (value.data == NULL) {
+		TALLOC_FREE(tmp_ctx);
+		return;
+	}
+	SBVAL(value.data, 0, time_mono(NULL));
+	SIVAL(value.data, 8, ttl);
+	memcpy(value.data + 12, packet.data, packet.length);
+
+	memcache_add(dns->forwarder_cache, DNS_FORWARDER_CACHE, key, value);
+	TALLOC_FREE(tmp_ctx);
+}
+
+static struct dns_name_packet *forwarder_cache_lookup(
+	struct dns_server *dns,
+	TALLOC_CTX *mem_ctx,
+	const struct dns_name_question *question)
+{
+	struct dns_name_packet *reply = NULL;
+	enum ndr_err_code ndr_err;
+	DATA_BLOB key;
+	DATA_BLOB value;
+	DATA_BLOB packet;
+	time_t stored;
+	uint32_t ttl;
+	uint32_t age;
+	bool found;
+
+	if (dns->forwarder_cache == NULL) {
+		return NULL;
+	}
+
+	key = forwarder_cache_key(mem_ctx, question);
+	if (key.data == NULL) {
+		return NULL;
+	}
+
+	found = memcache_lookup(dns->forwarder_cache, DNS_FORWARDER_CACHE,
+				key, &value);
+	if (!found || value.length < 12) {
+		goto miss;
+	}
+
+	stored = BVAL(value.data, 0);
+	ttl = IVAL(value.data, 8);
+	age = time_mono(NULL) - stored;
+	if (age >= ttl) {
+		memcache_delete(dns->forwarder_cache, DNS_FORWARDER_CACHE,
+				key);
+		goto miss;
+	}
+
+	reply = talloc_zero(mem_ctx, struct dns_name_packet);
+	if (reply == NULL) {
+		goto miss;
+	}
+
+	packet = data_blob_const(value.data + 12, value.length - 12);
+	ndr_err = ndr_pull_struct_blob(&packet, reply, reply,
+			(ndr_pull_flags_fn_t)ndr_pull_dns_name_packet);
+	if (!NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+		TALLOC_FREE(reply);
+		goto miss;
+	}
+
+	forwarder_rrs_age(reply->answers, reply->ancount, age);
+	forwarder_rrs_age(reply->nsrecs, reply->nscount, age);
+	forwarder_rrs_age(reply->additional, reply->arcount, age);
+
+	data_blob_free(&key);
+	forwarder_cache_count(dns, true);
+	return reply;
+
+miss:
+	data_blob_free(&key);
+	forwarder_cache_count(dns, false);
+	return NULL;
+}
+
 struct ask_forwarder_state {
+	struct dns_server *dns;
+	struct dns_name_question *question;
 	struct dns_name_packet *reply;
 };
 
@@ -277,6 +526,7 @@ static void ask_forwarder_done(struct tevent_req *subreq);
 
 static struct tevent_req *ask_forwarder_send(
 	TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+	struct dns_server *dns,
 	const char *forwarder, struct dns_name_question *question)
 {
 	struct tevent_req *req, *subreq;
@@ -286,6 +536,14 @@ static struct tevent_req *ask_forwarder_send(
 	if (req == NULL) {
 		return NULL;
 	}
+	state->dns = dns;
+	state->question = question;
+
+	state->reply = forwarder_cache_lookup(dns, state, question);
+	if (state->reply != NULL) {
+		tevent_req_done(req);
+		return tevent_req_post(req, ev);
+	}
 
 	subreq = dns_cli_request_send(state, ev, forwarder,
 				      question->name, question->question_class,
@@ -313,6 +571,8 @@ static void ask_forwarder_done(struct tevent_req *subreq)
 		return;
 	}
 
+	forwarder_cache_add(state->dns, state->question, state->reply);
+
 	tevent_req_done(req);
 }
 
@@ -364,7 +624,8 @@ static WERROR add_zone_authority_record(struct dns_server *dns,
 		return werror;
 	}
 
-	werror = dns_lookup_records(dns, mem_ctx, dn, &recs, &rec_count);
+	werror = dns_lookup_records_cached(dns, mem_ctx, dn,
+					   &recs, &rec_count);
 	if (!W_ERROR_IS_OK(werror)) {
 		return werror;
 	}
@@ -467,7 +728,7 @@ static struct tevent_req *handle_dnsrpcrec_send(
 		return req;
 	}
 
-	subreq = ask_forwarder_send(state, ev, forwarder, new_q);
+	subreq = ask_forwarder_send(state, ev, dns, forwarder, new_q);
 	if (tevent_req_nomem(subreq, req)) {
 		return tevent_req_post(req, ev);
 	}
@@ -977,6 +1238,8 @@ struct tevent_req *dns_server_process_query_send(
 
 		req_state->flags |= DNS_FLAG_AUTHORITATIVE;
 
+		dns_cache_check(dns);
+
 		/*
 		 * Initialize the response arrays, so that we can use
 		 * them as their own talloc contexts when doing the
@@ -1007,7 +1270,7 @@ struct tevent_req *dns_server_process_query_send(
 		DEBUG(5, ("Not authoritative for '%s', forwarding\n",
 			  in->questions[0].name));
 
-		subreq = ask_forwarder_send(state, ev,
+		subreq = ask_forwarder_send(state, ev, dns,
 					    (forwarders == NULL ? NULL : forwarders[0]),
 					    &in->questions[0]);
 		if (tevent_req_nomem(subreq, req)) {
@@ -1050,7 +1313,7 @@ static void dns_server_process_query_got_response(struct tevent_req *subreq)
 
 		DEBUG(5, ("DNS query returned %s, trying another forwarder.\n",
 			  win_errstr(werr)));
-		subreq = ask_forwarder_send(state, state->ev,
+		subreq = ask_forwarder_send(state, state->ev, state->dns,
 					    state->forwarders->forwarder,
 					    state->question);
 
@@ -48,14 +48,21 @@
 #include "librpc/gen_ndr/ndr_irpc.h"
 #include "lib/messaging/irpc.h"
 #include "libds/common/roles.h"
+#include "lib/util/memcache.h"
 
 #undef DBGC_CLASS
 #define DBGC_CLASS DBGC_DNS
 
 NTSTATUS server_service_dns_init(TALLOC_CTX *);
 
+/* bytes of packed records to keep, "dns:cache size = 0" disables it */
+#define DNS_CACHE_SIZE (1024 * 1024)
+/* and of forwarded replies, set by "dns:forwarder cache size" */
+#define DNS_FORWARDER_CACHE_SIZE (1024 * 1024)
+
 /* hold information about one dns socket */
 struct dns_socket {
+	struct dns_socket *next, *prev;
 	struct dns_server *dns;
 	struct tsocket_address *local_address;
 };
@@ -608,7 +615,8 @@ static void dns_udp_call_sendto_done(struct tevent_req *subreq)
 }
 
 /*
-  start listening on the given address
+  start listening on the given address, over TCP here and over UDP in
+  dns_post_fork()
 */
 static NTSTATUS dns_add_socket(struct dns_server *dns,
 			       const struct model_ops *model_ops,
@@ -617,8 +625,6 @@ static NTSTATUS dns_add_socket(struct dns_server *dns,
 			       uint16_t port)
 {
 	struct dns_socket *dns_socket;
-	struct dns_udp_socket *dns_udp_socket;
-	struct tevent_req *udpsubreq;
 	NTSTATUS status;
 	int ret;
 
@@ -651,19 +657,47 @@ static NTSTATUS dns_add_socket(struct dns_server *dns,
 		return status;
 	}
 
+	DLIST_ADD_END(dns->sockets, dns_socket);
+
+	return NT_STATUS_OK;
+}
+
+/*
+  start listening on the address of dns_socket over UDP, sharing the port
+  with the other worker processes if reuseport is set
+*/
+static NTSTATUS dns_add_udp_socket(struct dns_socket *dns_socket,
+				   bool reuseport)
+{
+	struct dns_server *dns = dns_socket->dns;
+	struct dns_udp_socket *dns_udp_socket;
+	struct tevent_req *udpsubreq;
+	NTSTATUS status;
+	int ret;
+
 	dns_udp_socket = talloc(dns_socket, struct dns_udp_socket);
 	NT_STATUS_HAVE_NO_MEMORY(dns_udp_socket);
 
 	dns_udp_socket->dns_socket = dns_socket;
 
-	ret = tdgram_inet_udp_socket(dns_socket->local_address,
-				     NULL,
-				     dns_udp_socket,
-				     &dns_udp_socket->dgram);
+	if (reuseport) {
+		ret = tdgram_inet_udp_reuseport_socket(
+			dns_socket->local_address,
+			dns_udp_socket,
+			&dns_udp_socket->dgram);
+	} else {
+		ret = tdgram_inet_udp_socket(dns_socket->local_address,
+					     NULL,
+					     dns_udp_socket,
+					     &dns_udp_socket->dgram);
+	}
 	if (ret != 0) {
 		status = map_nt_error_from_unix_common(errno);
-		DEBUG(0,("Failed to bind to %s:%u UDP - %s\n",
-			 address, port, nt_errstr(status)));
+		DEBUG(0,("Failed to bind to %s UDP - %s\n",
+			 tsocket_address_string(dns_socket->local_address,
+						dns_udp_socket),
+			 nt_errstr(status)));
+		talloc_free(dns_udp_socket);
 		return status;
 	}
 
@@ -761,6 +795,7 @@ static NTSTATUS dns_server_reload_zones(struct dns_server *dns)
 		return status;
 	}
 	dns->zones = new_list;
+	dns_cache_flush(dns);
 	while ((old_zone = DLIST_TAIL(old_list)) != NULL) {
 		DLIST_REMOVE(old_list, old_zone);
 		talloc_free(old_zone);
@@ -800,6 +835,7 @@ static void dns_task_init(struct task_server *task)
 	struct ldb_message *dns_acc;
 	char *hostname_lower;
 	char *dns_spn;
+	int cache_size;
 
 	switch (lpcfg_server_role(task->lp_ctx)) {
 	case ROLE_STANDALONE:
@@ -831,6 +867,7 @@ static void dns_task_init(struct task_server *task)
 	}
 
 	dns->task = task;
+	task->private_data = dns;
 
 	dns->server_credentials = cli_credentials_init(dns);
 	if (!dns->server_credentials) {
@@ -890,6 +927,31 @@ static void dns_task_init(struct task_server *task)
 		return;
 	}
 
+	cache_size = lpcfg_parm_int(task->lp_ctx, NULL,
+				    "dns", "cache size", DNS_CACHE_SIZE);
+	if (cache_size > 0) {
+		dns->cache = memcache_init(dns, cache_size);
+		if (dns->cache == NULL) {
+			task_server_terminate(task, "dns: out of memory", true);
+			return;
+		}
+	}
+
+	/*
+	 * Unless "prefork children:dns" is set the dns task is never
+	 * forked, so this one cache serves all the clients.
+	 */
+	cache_size = lpcfg_parm_int(task->lp_ctx, NULL, "dns",
+				    "forwarder cache size",
+				    DNS_FORWARDER_CACHE_SIZE);
+	if (cache_size > 0) {
+		dns->forwarder_cache = memcache_init(dns, cache_size);
+		if (dns->forwarder_cache == NULL) {
+			task_server_terminate(task, "dns: out of memory", true);
+			return;
+		}
+	}
+
 	status = dns_server_reload_zones(dns);
 	if (!NT_STATUS_IS_OK(status)) {
 		task_server_terminate(task, "dns: failed to load DNS zones", true);
@@ -902,17 +964,42 @@ static void dns_task_init(struct task_server *task)
 		return;
 	}
 
-	/* Setup the IRPC interface and register handlers */
-	status = irpc_add_name(task->msg_ctx, "dnssrv");
+	/* Setup the IRPC interface, the name is added in dns_post_fork() */
+	status = IRPC_REGISTER(task->msg_ctx, irpc, DNSSRV_RELOAD_DNS_ZONES,
+			       dns_reload_zones, dns);
 	if (!NT_STATUS_IS_OK(status)) {
-		task_server_terminate(task, "dns: failed to register IRPC name", true);
+		task_server_terminate(task, "dns: failed to setup reload handler", true);
 		return;
 	}
+}
 
-	status = IRPC_REGISTER(task->msg_ctx, irpc, DNSSRV_RELOAD_DNS_ZONES,
-			       dns_reload_zones, dns);
+/*
+ * Called in every process serving DNS. A pre-forked worker binds its own
+ * SO_REUSEPORT UDP sockets, so the kernel spreads the UDP queries over the
+ * workers, and registers itself for the zone reload messages.
+ */
+static void dns_post_fork(struct task_server *task, struct process_details *pd)
+{
+	struct dns_server *dns = talloc_get_type_abort(task->private_data,
+						       struct dns_server);
+	struct dns_socket *dns_socket;
+	NTSTATUS status;
+
+	for (dns_socket = dns->sockets;
+	     dns_socket != NULL;
+	     dns_socket = dns_socket->next) {
+		status = dns_add_udp_socket(dns_socket, pd->instances > 1);
+		if (!NT_STATUS_IS_OK(status)) {
+			task_server_terminate(task,
+					      "dns failed to setup UDP sockets",
+					      true);
+			return;
+		}
+	}
+
+	status = irpc_add_name(task->msg_ctx, "dnssrv");
 	if (!NT_STATUS_IS_OK(status)) {
-		task_server_terminate(task, "dns: failed to setup reload handler", true);
+		task_server_terminate(task, "dns: failed to register IRPC name", true);
 		return;
 	}
 }
@@ -921,7 +1008,12 @@ NTSTATUS server_service_dns_init(TALLOC_CTX *ctx)
 {
 	struct service_details details = {
 		.inhibit_fork_on_accept = true,
+		/*
+		 * TKEY negotiations are kept in the process that did them,
+		 * so only pre-fork if "prefork children:dns" is set.
+		 */
 		.inhibit_pre_fork = true,
+		.post_fork = dns_post_fork,
 	};
 	return register_server_service(ctx, "dns", dns_task_init, &details);
 }
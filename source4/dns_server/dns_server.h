@@ -44,12 +44,24 @@ struct dns_server_tkey_store {
 	uint16_t size;
 };
 
+struct dns_socket;
+
 struct dns_server {
 	struct task_server *task;
+	/* the addresses listened on, over UDP in each worker */
+	struct dns_socket *sockets;
 	struct ldb_context *samdb;
 	struct dns_server_zone *zones;
 	struct dns_server_tkey_store *tkeys;
 	struct cli_credentials *server_credentials;
+	/* records answered from, valid for cache_seq_num of samdb */
+	struct memcache *cache;
+	uint64_t cache_seq_num;
+	bool cache_valid;
+	/* replies from the forwarders */
+	struct memcache *forwarder_cache;
+	uint64_t forwarder_cache_hits;
+	uint64_t forwarder_cache_misses;
 };
 
 struct dns_request_state {
@@ -99,6 +111,13 @@ WERROR dns_lookup_records_wildcard(struct dns_server *dns,
 			  struct ldb_dn *dn,
 			  struct dnsp_DnssrvRpcRecord **records,
 			  uint16_t *rec_count);
+WERROR dns_lookup_records_cached(struct dns_server *dns,
+				 TALLOC_CTX *mem_ctx,
+				 struct ldb_dn *dn,
+				 struct dnsp_DnssrvRpcRecord **records,
+				 uint16_t *rec_count);
+void dns_cache_check(struct dns_server *dns);
+void dns_cache_flush(struct dns_server *dns);
 WERROR dns_replace_records(struct dns_server *dns,
 			   TALLOC_CTX *mem_ctx,
 			   struct ldb_dn *dn,
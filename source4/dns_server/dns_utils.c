@@ -29,6 +29,7 @@
 #include "dsdb/samdb/samdb.h"
 #include "dsdb/common/util.h"
 #include "dns_server/dns_server.h"
+#include "lib/util/memcache.h"
 
 #undef DBGC_CLASS
 #define DBGC_CLASS DBGC_DNS
@@ -121,6 +122,240 @@ WERROR dns_lookup_records(struct dns_server *dns,
 				 records, rec_count, NULL);
 }
 
+/*
+ * The records queries are answered from are kept in a cache, packed
+ * as they are in dnsRecord, so each answer is unpacked by
+ * dns_common_extract() just as if it came from the database.  Names
+ * that do not exist are cached too.  Everything is dropped as soon as
+ * the sequence number of the database moves on, so a change made by
+ * any process, or by replication, is seen by the next query.  The
+ * sequence number is checked once as each query arrives, rather than
+ * for each lookup, as that check costs as much as the lookups it saves.
+ *
+ * Updates do not use the cache, they have to see the database as it
+ * is in their transaction.
+ */
+
+void dns_cache_flush(struct dns_server *dns)
+{
+	if (dns->cache == NULL) {
+		return;
+	}
+	memcache_flush(dns->cache, DNS_RECORDS_CACHE);
+}
+
+void dns_cache_check(struct dns_server *dns)
+{
+	uint64_t seq_num;
+	int ret;
+
+	dns->cache_valid = false;
+
+	if (dns->cache == NULL) {
+		return;
+	}
+
+	ret = ldb_sequence_number(dns->samdb, LDB_SEQ_HIGHEST_SEQ, &seq_num);
+	if (ret != LDB_SUCCESS) {
+		dns_cache_flush(dns);
+		return;
+	}
+
+	if (seq_num != dns->cache_seq_num) {
+		dns_cache_flush(dns);
+		dns->cache_seq_num = seq_num;
+	}
+
+	dns->cache_valid = true;
+}
+
+static DATA_BLOB dns_cache_key(TALLOC_CTX *mem_ctx,
+			       struct ldb_dn *dn,
+			       bool wildcard)
+{
+	const char *casefold = ldb_dn_get_casefold(dn);
+	char *key = NULL;
+
+	if (casefold == NULL) {
+		return data_blob_null;
+	}
+
+	key = talloc_asprintf(mem_ctx, "%c%s", wildcard ? 'W' : 'E', casefold);
+	if (key == NULL) {
+		return data_blob_null;
+	}
+
+	return data_blob_const(key, strlen(key));
+}
+
+static bool dns_cache_result(WERROR werr)
+{
+	return W_ERROR_IS_OK(werr) ||
+		W_ERROR_EQUAL(werr, WERR_DNS_ERROR_NAME_DOES_NOT_EXIST) ||
+		W_ERROR_EQUAL(werr, DNS_ERR(NAME_ERROR));
+}
+
+/*
+ * A cache entry is the result code, the number of records, and the
+ * length and packed bytes of each record.
+ */
+static void dns_cache_add(struct dns_server *dns,
+			  DATA_BLOB key,
+			  WERROR werr,
+			  struct dnsp_DnssrvRpcRecord *records,
+			  uint16_t rec_count)
+{
+	TALLOC_CTX *tmp_ctx = talloc_new(dns);
+	DATA_BLOB *blobs = NULL;
+	DATA_BLOB value;
+	size_t len = 6;
+	size_t ofs;
+	uint16_t i;
+
+	if (tmp_ctx == NULL) {
+		return;
+	}
+
+	blobs = talloc_array(tmp_ctx, DATA_BLOB, rec_count);
+	if (blobs == NULL) {
+		TALLOC_FREE(tmp_ctx);
+		return;
+	}
+
+	for (i = 0; i < rec_count; i++) {
+		enum ndr_err_code ndr_err;
+
+		ndr_err = ndr_push_struct_blob(&blobs[i], blobs, &records[i],
+				(ndr_push_flags_fn_t)ndr_push_dnsp_DnssrvRpcRecord);
+		if (!NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+			TALLOC_FREE(tmp_ctx);
+			return;
+		}
+		len += 4 + blobs[i].length;
+	}
+
+	value = data_blob_talloc(tmp_ctx, NULL, len);
+	if (value.data == NULL) {
+		TALLOC_FREE(tmp_ctx);
+		return;
+	}
+
+	SIVAL(value.data, 0, W_ERROR_V(werr));
+	SSVAL(value.data, 4, rec_count);
+	ofs = 6;
+	for (i = 0; i < rec_count; i++) {
+		SIVAL(value.data, ofs, blobs[i].length);
+		memcpy(value.data + ofs + 4, blobs[i].data, blobs[i].length);
+		ofs += 4 + blobs[i].length;
+	}
+
+	memcache_add(dns->cache, DNS_RECORDS_CACHE, key, value);
+	TALLOC_FREE(tmp_ctx);
+}
+
+static bool dns_cache_lookup(struct dns_server *dns,
+			     TALLOC_CTX *mem_ctx,
+			     DATA_BLOB key,
+			     WERROR *werr,
+			     struct dnsp_DnssrvRpcRecord **records,
+			     uint16_t *rec_count)
+{
+	struct ldb_message_element el = { .name = "dnsRecord" };
+	DATA_BLOB value;
+	size_t ofs;
+	uint16_t i;
+
+	if (!memcache_lookup(dns->cache, DNS_RECORDS_CACHE, key, &value)) {
+		return false;
+	}
+	if (value.length < 6) {
+		return false;
+	}
+
+	*werr = W_ERROR(IVAL(value.data, 0));
+	el.num_values = SVAL(value.data, 4);
+
+	if (!W_ERROR_IS_OK(*werr)) {
+		*records = NULL;
+		*rec_count = 0;
+		return true;
+	}
+
+	el.values = talloc_array(mem_ctx, struct ldb_val, el.num_values);
+	if (el.values == NULL) {
+		return false;
+	}
+
+	ofs = 6;
+	for (i = 0; i < el.num_values; i++) {
+		if (ofs + 4 > value.length) {
+			TALLOC_FREE(el.values);
+			return false;
+		}
+		el.values[i].length = IVAL(value.data, ofs);
+		el.values[i].data = value.data + ofs + 4;
+		ofs += 4 + el.values[i].length;
+		if (ofs > value.length) {
+			TALLOC_FREE(el.values);
+			return false;
+		}
+	}
+
+	*werr = dns_common_extract(dns->samdb, &el, mem_ctx,
+				   records, rec_count);
+	TALLOC_FREE(el.values);
+	return true;
+}
+
+static WERROR dns_lookup_records_via_cache(struct dns_server *dns,
+					   TALLOC_CTX *mem_ctx,
+					   struct ldb_dn *dn,
+					   bool wildcard,
+					   struct dnsp_DnssrvRpcRecord **records,
+					   uint16_t *rec_count)
+{
+	DATA_BLOB key = data_blob_null;
+	WERROR werr;
+
+	if (dns->cache_valid) {
+		key = dns_cache_key(mem_ctx, dn, wildcard);
+	}
+
+	if (key.data != NULL &&
+	    dns_cache_lookup(dns, mem_ctx, key, &werr, records, rec_count)) {
+		data_blob_free(&key);
+		return werr;
+	}
+
+	if (wildcard) {
+		werr = dns_common_wildcard_lookup(dns->samdb, mem_ctx, dn,
+						  records, rec_count);
+	} else {
+		werr = dns_common_lookup(dns->samdb, mem_ctx, dn,
+					 records, rec_count, NULL);
+	}
+
+	if (key.data != NULL && dns_cache_result(werr)) {
+		dns_cache_add(dns, key, werr, *records, *rec_count);
+	}
+	data_blob_free(&key);
+
+	return werr;
+}
+
+/*
+ * Lookup a DNS record for a query, performing an exact match.
+ */
+WERROR dns_lookup_records_cached(struct dns_server *dns,
+				 TALLOC_CTX *mem_ctx,
+				 struct ldb_dn *dn,
+				 struct dnsp_DnssrvRpcRecord **records,
+				 uint16_t *rec_count)
+{
+	return dns_lookup_records_via_cache(dns, mem_ctx, dn, false,
+					    records, rec_count);
+}
+
 /*
  * Lookup a DNS record, will match DNS wild card records if an exact match
  * is not found.
@@ -131,8 +366,8 @@ WERROR dns_lookup_records_wildcard(struct dns_server *dns,
 			  struct dnsp_DnssrvRpcRecord **records,
 			  uint16_t *rec_count)
 {
-	return dns_common_wildcard_lookup(dns->samdb, mem_ctx, dn,
-				 records, rec_count);
+	return dns_lookup_records_via_cache(dns, mem_ctx, dn, true,
+					    records, rec_count);
 }
 
 WERROR dns_replace_records(struct dns_server *dns,
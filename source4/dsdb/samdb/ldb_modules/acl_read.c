@@ -37,6 +37,10 @@
 #include "librpc/gen_ndr/ndr_security.h"
 #include "param/param.h"
 #include "dsdb/samdb/ldb_modules/util.h"
+#include "lib/util/memcache.h"
+
+/* the size of the cache of access check results, in bytes */
+#define ACLREAD_CACHE_SIZE (1024*1024)
 
 
 struct aclread_context {
@@ -62,6 +66,45 @@ struct aclread_private {
 	/* cache of the last SD we read during any search */
 	struct security_descriptor *sd_cached;
 	struct ldb_val sd_cached_blob;
+
+	/*
+	 * Cache of access check results, see
+	 * aclread_check_access_on_attribute().  It is flushed at the
+	 * start of each search, unless "acl:search cache per
+	 * connection" is set, and whenever the token changes.
+	 */
+	struct memcache *cache;
+	bool cache_per_connection;
+	struct security_token *cache_token;
+	uint32_t cache_next_sd_id;
+};
+
+/*
+ * What we know about an SD in the cache.  The id stands for the SD
+ * in the keys of the access check results, so the SD need only be
+ * parsed when a result is not already known.
+ */
+struct aclread_sd_info {
+	uint32_t id;
+	/* the DACL has an ACE for PRINCIPAL_SELF */
+	bool has_self;
+};
+
+/*
+ * The key of a cached access check result: everything that
+ * acl_check_access_on_attribute() depends on, other than the token
+ */
+struct aclread_access_key {
+	uint32_t sd_id;
+	uint32_t access_mask;
+	struct GUID class_guid;
+	struct GUID attr_guid;
+	struct GUID attr_security_guid;
+	/*
+	 * An ACE for PRINCIPAL_SELF applies to the objectSid, so all
+	 * that matters about the object is whether the token has it
+	 */
+	uint32_t self_in_token;
 };
 
 static void aclread_mark_inaccesslible(struct ldb_message_element *el) {
@@ -227,6 +270,225 @@ static int aclread_get_sd_from_ldb_message(struct aclread_context *ac,
 	return LDB_SUCCESS;
 }
 
+/*
+ * Find the cache id of the SD of a message, parsing the SD (into *sd)
+ * if we have not seen it before.
+ */
+static int aclread_get_sd_info(struct aclread_context *ac,
+			       struct ldb_message *msg,
+			       struct aclread_sd_info *info,
+			       struct security_descriptor **sd)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(ac->module);
+	struct aclread_private *private_data
+		= talloc_get_type(ldb_module_get_private(ac->module),
+				  struct aclread_private);
+	struct ldb_message_element *sd_element;
+	struct dom_sid self_sid;
+	DATA_BLOB blob, value;
+	uint32_t i;
+	int ret;
+
+	*sd = NULL;
+
+	sd_element = ldb_msg_find_element(msg, "nTSecurityDescriptor");
+	if (sd_element == NULL) {
+		return ldb_error(ldb, LDB_ERR_INSUFFICIENT_ACCESS_RIGHTS,
+				 "nTSecurityDescriptor is missing");
+	}
+
+	if (sd_element->num_values != 1) {
+		return ldb_operr(ldb);
+	}
+
+	/*
+	 * aclread_get_sd_from_ldb_message() may take the blob
+	 * from the message, so keep our own pointer to it
+	 */
+	blob = sd_element->values[0];
+
+	if (memcache_lookup(private_data->cache, ACLREAD_SD_CACHE,
+			    blob, &value)) {
+		if (value.length != sizeof(*info)) {
+			return ldb_operr(ldb);
+		}
+		memcpy(info, value.data, sizeof(*info));
+		return LDB_SUCCESS;
+	}
+
+	ret = aclread_get_sd_from_ldb_message(ac, msg, sd);
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
+	ZERO_STRUCTP(info);
+	info->id = ++private_data->cache_next_sd_id;
+
+	dom_sid_parse(SID_NT_SELF, &self_sid);
+	for (i = 0; (*sd)->dacl != NULL && i < (*sd)->dacl->num_aces; i++) {
+		struct security_ace *ace = &(*sd)->dacl->aces[i];
+
+		if (ace->flags & SEC_ACE_FLAG_INHERIT_ONLY) {
+			continue;
+		}
+		if (dom_sid_equal(&ace->trustee, &self_sid)) {
+			info->has_self = true;
+			break;
+		}
+	}
+
+	memcache_add(private_data->cache, ACLREAD_SD_CACHE, blob,
+		     data_blob_const(info, sizeof(*info)));
+	return LDB_SUCCESS;
+}
+
+/*
+ * Does the user have the SID that PRINCIPAL_SELF stands for in an
+ * access check on this object?  See sec_access_check_ds().
+ */
+static bool aclread_self_in_token(struct ldb_module *module,
+				  const struct aclread_sd_info *info,
+				  const struct dom_sid *sid)
+{
+	struct security_token *token = acl_user_token(module);
+	struct dom_sid self_sid;
+
+	if (!info->has_self || token == NULL) {
+		return false;
+	}
+	if (sid == NULL) {
+		dom_sid_parse(SID_NT_SELF, &self_sid);
+		sid = &self_sid;
+	}
+	return security_token_has_sid(token, sid);
+}
+
+/*
+ * acl_check_access_on_attribute() for an entry being returned.
+ *
+ * Most objects share one of a small number of SDs, so the result is
+ * cached against the SD (by its id), the object class, the attribute
+ * and the access mask.  The SD is parsed into *sd only if the result
+ * is not already known.
+ */
+static int aclread_check_access_on_attribute(struct aclread_context *ac,
+					     TALLOC_CTX *mem_ctx,
+					     struct ldb_message *msg,
+					     const struct aclread_sd_info *info,
+					     bool self_in_token,
+					     struct security_descriptor **sd,
+					     struct dom_sid *sid,
+					     uint32_t access_mask,
+					     const struct dsdb_attribute *attr,
+					     const struct dsdb_class *objectclass)
+{
+	struct aclread_private *private_data
+		= talloc_get_type(ldb_module_get_private(ac->module),
+				  struct aclread_private);
+	struct aclread_access_key key;
+	DATA_BLOB key_blob = data_blob_const(&key, sizeof(key));
+	DATA_BLOB value;
+	int ret;
+
+	ZERO_STRUCT(key);
+	key.sd_id = info->id;
+	key.access_mask = access_mask;
+	key.class_guid = objectclass->schemaIDGUID;
+	key.attr_guid = attr->schemaIDGUID;
+	key.attr_security_guid = attr->attributeSecurityGUID;
+	key.self_in_token = self_in_token;
+
+	if (memcache_lookup(private_data->cache, ACLREAD_ACCESS_CACHE,
+			    key_blob, &value)) {
+		if (value.length != sizeof(ret)) {
+			return ldb_operr(ldb_module_get_ctx(ac->module));
+		}
+		memcpy(&ret, value.data, sizeof(ret));
+		return ret;
+	}
+
+	if (*sd == NULL) {
+		ret = aclread_get_sd_from_ldb_message(ac, msg, sd);
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
+	}
+
+	ret = acl_check_access_on_attribute(ac->module,
+					    mem_ctx,
+					    *sd,
+					    sid,
+					    access_mask,
+					    attr,
+					    objectclass);
+	if (ret == LDB_SUCCESS || ret == LDB_ERR_INSUFFICIENT_ACCESS_RIGHTS) {
+		memcache_add(private_data->cache, ACLREAD_ACCESS_CACHE,
+			     key_blob, data_blob_const(&ret, sizeof(ret)));
+	}
+	return ret;
+}
+
+/*
+ * Is this the token the cached access check results were made with?
+ */
+static bool aclread_cache_token_matches(struct aclread_private *p,
+					const struct security_token *token)
+{
+	uint32_t i;
+
+	if (p->cache_token == NULL || token == NULL) {
+		return false;
+	}
+	if (p->cache_token->num_sids != token->num_sids ||
+	    p->cache_token->privilege_mask != token->privilege_mask ||
+	    p->cache_token->rights_mask != token->rights_mask) {
+		return false;
+	}
+	for (i = 0; i < token->num_sids; i++) {
+		if (!dom_sid_equal(&p->cache_token->sids[i],
+				   &token->sids[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Flush the cached access check results at the start of a search if
+ * they may not apply to it
+ */
+static int aclread_cache_start_search(struct ldb_module *module,
+				      struct aclread_private *p)
+{
+	struct security_token *token = acl_user_token(module);
+
+	if (p->cache_per_connection &&
+	    aclread_cache_token_matches(p, token)) {
+		return LDB_SUCCESS;
+	}
+
+	memcache_flush(p->cache, ACLREAD_SD_CACHE);
+	memcache_flush(p->cache, ACLREAD_ACCESS_CACHE);
+	TALLOC_FREE(p->cache_token);
+
+	if (p->cache_per_connection && token != NULL) {
+		p->cache_token = talloc_zero(p, struct security_token);
+		if (p->cache_token == NULL) {
+			return ldb_module_oom(module);
+		}
+		*p->cache_token = *token;
+		p->cache_token->sids = talloc_memdup(p->cache_token,
+						     token->sids,
+						     sizeof(token->sids[0]) *
+						     token->num_sids);
+		if (token->num_sids > 0 && p->cache_token->sids == NULL) {
+			TALLOC_FREE(p->cache_token);
+			return ldb_module_oom(module);
+		}
+	}
+	return LDB_SUCCESS;
+}
+
 
 static int aclread_callback(struct ldb_request *req, struct ldb_reply *ares)
 {
@@ -237,6 +499,8 @@ static int aclread_callback(struct ldb_request *req, struct ldb_reply *ares)
 	int ret, num_of_attrs = 0;
 	unsigned int i, k = 0;
 	struct security_descriptor *sd = NULL;
+	struct aclread_sd_info sd_info;
+	bool self_in_token;
 	struct dom_sid *sid = NULL;
 	TALLOC_CTX *tmp_ctx;
 	uint32_t instanceType;
@@ -255,19 +519,13 @@ static int aclread_callback(struct ldb_request *req, struct ldb_reply *ares)
 	switch (ares->type) {
 	case LDB_REPLY_ENTRY:
 		msg = ares->message;
-		ret = aclread_get_sd_from_ldb_message(ac, msg, &sd);
+		ret = aclread_get_sd_info(ac, msg, &sd_info, &sd);
 		if (ret != LDB_SUCCESS) {
 			ldb_debug_set(ldb, LDB_DEBUG_FATAL,
 				      "acl_read: cannot get descriptor of %s: %s\n",
 				      ldb_dn_get_linearized(msg->dn), ldb_strerror(ret));
 			ret = LDB_ERR_OPERATIONS_ERROR;
 			goto fail;
-		} else if (sd == NULL) {
-			ldb_debug_set(ldb, LDB_DEBUG_FATAL,
-				      "acl_read: cannot get descriptor of %s (attribute not found)\n",
-				      ldb_dn_get_linearized(msg->dn));
-			ret = LDB_ERR_OPERATIONS_ERROR;
-			goto fail;
 		}
 		/*
 		 * Get the most specific structural object class for the ACL check
@@ -281,6 +539,7 @@ static int aclread_callback(struct ldb_request *req, struct ldb_reply *ares)
 		}
 
 		sid = samdb_result_dom_sid(tmp_ctx, msg, "objectSid");
+		self_in_token = aclread_self_in_token(ac->module, &sd_info, sid);
 		/* get the object instance type */
 		instanceType = ldb_msg_find_attr_as_uint(msg,
 							 "instanceType", 0);
@@ -368,13 +627,16 @@ static int aclread_callback(struct ldb_request *req, struct ldb_reply *ares)
 				continue;
 			}
 
-			ret = acl_check_access_on_attribute(ac->module,
-							    tmp_ctx,
-							    sd,
-							    sid,
-							    access_mask,
-							    attr,
-							    objectclass);
+			ret = aclread_check_access_on_attribute(ac,
+								tmp_ctx,
+								msg,
+								&sd_info,
+								self_in_token,
+								&sd,
+								sid,
+								access_mask,
+								attr,
+								objectclass);
 
 			/*
 			 * Dirsync control needs the replpropertymetadata attribute
@@ -508,6 +770,11 @@ static int aclread_search(struct ldb_module *module, struct ldb_request *req)
 		return ldb_next_request(module, req);
 	}
 
+	ret = aclread_cache_start_search(module, p);
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
 	/* check accessibility of base */
 	if (!ldb_dn_is_null(req->op.search.base)) {
 		ret = dsdb_module_search_dn(module, req, &res, req->op.search.base,
@@ -638,6 +905,15 @@ static int aclread_init(struct ldb_module *module)
 		return ldb_module_oom(module);
 	}
 	p->enabled = lpcfg_parm_bool(ldb_get_opaque(ldb, "loadparm"), NULL, "acl", "search", true);
+	p->cache_per_connection = lpcfg_parm_bool(ldb_get_opaque(ldb, "loadparm"),
+						  NULL, "acl",
+						  "search cache per connection",
+						  false);
+	p->cache = memcache_init(p, ACLREAD_CACHE_SIZE);
+	if (p->cache == NULL) {
+		talloc_free(p);
+		return ldb_module_oom(module);
+	}
 	ldb_module_set_private(module, p);
 	return ldb_next_init(module);
 }
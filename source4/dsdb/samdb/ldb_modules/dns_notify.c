@@ -51,7 +51,8 @@ struct dns_notify_private {
 
 struct dns_notify_dnssrv_state {
 	struct imessaging_context *msg_ctx;
-	struct dnssrv_reload_dns_zones r;
+	/* the notifications not yet answered */
+	unsigned num_pending;
 };
 
 static void dns_notify_dnssrv_done(struct tevent_req *req)
@@ -66,9 +67,14 @@ static void dns_notify_dnssrv_done(struct tevent_req *req)
 		DEBUG(1, ("%s: Error notifying dns server: %s\n",
 		      __func__, nt_errstr(status)));
 	}
-	imessaging_cleanup(state->msg_ctx);
-
 	talloc_free(req);
+
+	state->num_pending--;
+	if (state->num_pending > 0) {
+		return;
+	}
+
+	imessaging_cleanup(state->msg_ctx);
 	talloc_free(state);
 }
 
@@ -78,7 +84,12 @@ static void dns_notify_dnssrv_send(struct ldb_module *module)
 	struct loadparm_context *lp_ctx;
 	struct dns_notify_dnssrv_state *state;
 	struct dcerpc_binding_handle *handle;
+	struct dnssrv_reload_dns_zones *r;
 	struct tevent_req *req;
+	struct server_id *servers = NULL;
+	unsigned num_servers = 0;
+	unsigned i;
+	NTSTATUS status;
 
 	ldb = ldb_module_get_ctx(module);
 
@@ -102,27 +113,47 @@ static void dns_notify_dnssrv_send(struct ldb_module *module)
 		return;
 	}
 
-	/* Get a handle to notify the DNS server */
-	handle = irpc_binding_handle_by_name(state, state->msg_ctx,
-					     "dnssrv",
-					     &ndr_table_irpc);
-	if (handle == NULL) {
+	/*
+	 * Notify every DNS server process, there is one per worker if
+	 * the DNS server is pre-forked.
+	 */
+	status = irpc_servers_byname(state->msg_ctx, state, "dnssrv",
+				     &num_servers, &servers);
+	if (!NT_STATUS_IS_OK(status)) {
 		imessaging_cleanup(state->msg_ctx);
 		talloc_free(state);
 		return;
 	}
 
 	/* Send the notifications */
-	req = dcerpc_dnssrv_reload_dns_zones_r_send(state,
-						    ldb_get_event_context(ldb),
-						    handle,
-						    &state->r);
-	if (req == NULL) {
+	for (i = 0; i < num_servers; i++) {
+		handle = irpc_binding_handle(state, state->msg_ctx,
+					     servers[i], &ndr_table_irpc);
+		if (handle == NULL) {
+			continue;
+		}
+
+		r = talloc_zero(handle, struct dnssrv_reload_dns_zones);
+		if (r == NULL) {
+			continue;
+		}
+
+		req = dcerpc_dnssrv_reload_dns_zones_r_send(state,
+							    ldb_get_event_context(ldb),
+							    handle,
+							    r);
+		if (req == NULL) {
+			continue;
+		}
+		tevent_req_set_callback(req, dns_notify_dnssrv_done, state);
+		state->num_pending++;
+	}
+	TALLOC_FREE(servers);
+
+	if (state->num_pending == 0) {
 		imessaging_cleanup(state->msg_ctx);
 		talloc_free(state);
-		return;
 	}
-	tevent_req_set_callback(req, dns_notify_dnssrv_done, state);
 }
 
 static int dns_notify_add(struct ldb_module *module, struct ldb_request *req)
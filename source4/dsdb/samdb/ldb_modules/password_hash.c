@@ -47,6 +47,10 @@
 #include "lib/krb5_wrap/krb5_samba.h"
 #include "auth/common_auth.h"
 #include "lib/messaging/messaging.h"
+#ifdef WITH_PTHREADPOOL
+#include <pthread.h>
+#include "lib/pthreadpool/pthreadpool.h"
+#endif
 
 #ifdef ENABLE_GPGME
 #undef class
@@ -88,6 +92,16 @@
 /* Notice: Definition of "dsdb_control_password_change_status" moved into
  * "samdb.h" */
 
+struct ph_private {
+#ifdef WITH_PTHREADPOOL
+	/*
+	 * The expensive key derivations of a password set run in
+	 * parallel on this pool, see run_password_jobs().
+	 */
+	struct pthreadpool *pool;
+#endif
+};
+
 struct ph_context {
 	struct ldb_module *module;
 	struct ldb_request *req;
@@ -169,7 +183,50 @@ struct setup_password_fields_io {
 		DATA_BLOB des_crc;
 		struct ldb_val supplemental;
 		NTTIME last_set;
+		struct package_PrimaryUserPasswordValue *userPassword_hashes;
 	} g;
+
+	/* key derivations waiting for run_password_jobs() */
+	struct password_job *jobs;
+	size_t num_jobs;
+};
+
+/*
+ * A key derivation of the new password.  fn() may run on a thread of
+ * the pool, so it only reads its inputs and writes its outputs, it
+ * does not use talloc or the ldb.  done() then takes the results over
+ * into the io struct in the main thread.
+ */
+struct password_job {
+	void (*fn)(struct password_job *job);
+	int (*done)(struct setup_password_fields_io *io,
+		    struct password_job *job);
+	bool thread_safe;
+	struct password_job_batch *batch;
+
+	union {
+		struct {
+			krb5_context krb5_context;
+			krb5_data salt;
+			krb5_data cleartext;
+			krb5_enctype enctype;
+			const char *name;
+			DATA_BLOB *result;
+			krb5_keyblock key;
+			krb5_error_code krb5_ret;
+		} key;
+		struct {
+			const char *password;
+			const char *setting;
+			const char *scheme;
+			struct package_PrimaryUserPasswordValue *result;
+#ifdef HAVE_CRYPT_R
+			struct crypt_data *crypt_data;
+#endif
+			const char *hash;
+			int err;
+		} crypt;
+	} u;
 };
 
 static int msg_find_old_and_new_pwd_val(const struct ldb_message *msg,
@@ -667,6 +724,264 @@ static int setup_lm_fields(struct setup_password_fields_io *io)
 	return LDB_SUCCESS;
 }
 
+static struct password_job *add_password_job(
+	struct setup_password_fields_io *io,
+	void (*fn)(struct password_job *job),
+	int (*done)(struct setup_password_fields_io *io,
+		    struct password_job *job))
+{
+	struct password_job *jobs = NULL;
+	struct password_job *job = NULL;
+
+	jobs = talloc_realloc(io->ac, io->jobs, struct password_job,
+			      io->num_jobs + 1);
+	if (jobs == NULL) {
+		return NULL;
+	}
+	io->jobs = jobs;
+
+	job = &io->jobs[io->num_jobs++];
+	*job = (struct password_job) {
+		.fn = fn,
+		.done = done,
+	};
+
+	return job;
+}
+
+#ifdef WITH_PTHREADPOOL
+/*
+ * The jobs of one password set that were handed to the pool, the
+ * main thread waits on cond until num_running drops to zero.
+ */
+struct password_job_batch {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	size_t num_running;
+};
+
+static void password_job_run(void *private_data)
+{
+	struct password_job *job = (struct password_job *)private_data;
+
+	job->fn(job);
+}
+
+/*
+ * Called by the pool on the thread that ran the job
+ */
+static int password_job_signal(int jobid,
+			       void (*job_fn)(void *private_data),
+			       void *job_private_data,
+			       void *private_data)
+{
+	struct password_job *job = (struct password_job *)job_private_data;
+	struct password_job_batch *batch = job->batch;
+	int ret;
+
+	ret = pthread_mutex_lock(&batch->mutex);
+	if (ret != 0) {
+		return ret;
+	}
+	batch->num_running -= 1;
+	if (batch->num_running == 0) {
+		ret = pthread_cond_signal(&batch->cond);
+	}
+	pthread_mutex_unlock(&batch->mutex);
+
+	return ret;
+}
+
+static void password_jobs_to_pool(struct pthreadpool *pool,
+				  struct setup_password_fields_io *io,
+				  struct password_job_batch *batch)
+{
+	bool first = true;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < io->num_jobs; i++) {
+		struct password_job *job = &io->jobs[i];
+
+		if (!job->thread_safe) {
+			continue;
+		}
+		if (first) {
+			/*
+			 * Left for the main thread, it would only
+			 * wait otherwise.
+			 */
+			first = false;
+			continue;
+		}
+
+		job->batch = batch;
+
+		pthread_mutex_lock(&batch->mutex);
+		batch->num_running += 1;
+		pthread_mutex_unlock(&batch->mutex);
+
+		ret = pthreadpool_add_job(pool, 0, password_job_run, job);
+		if (ret != 0) {
+			/*
+			 * The job did not make it into the pool,
+			 * it runs in the main thread instead.
+			 */
+			pthread_mutex_lock(&batch->mutex);
+			batch->num_running -= 1;
+			pthread_mutex_unlock(&batch->mutex);
+			job->batch = NULL;
+		}
+	}
+}
+
+static void password_jobs_wait(struct password_job_batch *batch)
+{
+	pthread_mutex_lock(&batch->mutex);
+	while (batch->num_running > 0) {
+		pthread_cond_wait(&batch->cond, &batch->mutex);
+	}
+	pthread_mutex_unlock(&batch->mutex);
+}
+#endif
+
+/*
+ * Run the key derivations queued by setup_kerberos_keys() and
+ * setup_userPassword_hashes().  They are independent of each other,
+ * so with "password hash:threads" above one they run in parallel on
+ * the thread pool, while the main thread runs one of them itself.
+ * All of them are done before this returns, so the password set
+ * still happens within the transaction, it just takes about as long
+ * as the slowest derivation rather than as long as all of them.
+ */
+static int run_password_jobs(struct setup_password_fields_io *io)
+{
+	struct ph_private *ph_private = talloc_get_type_abort(
+		ldb_module_get_private(io->ac->module), struct ph_private);
+#ifdef WITH_PTHREADPOOL
+	struct password_job_batch batch = { .num_running = 0 };
+	bool use_pool = (ph_private->pool != NULL && io->num_jobs > 1);
+#endif
+	int result = LDB_SUCCESS;
+	size_t i;
+	int ret;
+
+#ifdef WITH_PTHREADPOOL
+	if (use_pool) {
+		ret = pthread_mutex_init(&batch.mutex, NULL);
+		if (ret != 0) {
+			use_pool = false;
+		}
+	}
+	if (use_pool) {
+		ret = pthread_cond_init(&batch.cond, NULL);
+		if (ret != 0) {
+			pthread_mutex_destroy(&batch.mutex);
+			use_pool = false;
+		}
+	}
+	if (use_pool) {
+		password_jobs_to_pool(ph_private->pool, io, &batch);
+	}
+#else
+	(void)ph_private;
+#endif
+
+	for (i = 0; i < io->num_jobs; i++) {
+		struct password_job *job = &io->jobs[i];
+
+		if (job->batch != NULL) {
+			continue;
+		}
+
+		job->fn(job);
+
+		if (!job->thread_safe) {
+			/*
+			 * Take the result over at once, crypt()
+			 * overwrites it with the next call.
+			 */
+			ret = job->done(io, job);
+			job->done = NULL;
+			if (ret != LDB_SUCCESS && result == LDB_SUCCESS) {
+				result = ret;
+			}
+		}
+	}
+
+#ifdef WITH_PTHREADPOOL
+	if (use_pool) {
+		/*
+		 * Even on failure we have to wait for the jobs, they
+		 * write into io.
+		 */
+		password_jobs_wait(&batch);
+		pthread_cond_destroy(&batch.cond);
+		pthread_mutex_destroy(&batch.mutex);
+	}
+#endif
+
+	/*
+	 * done() also frees what the job allocated, so it is called
+	 * for all of them, the first error is returned.
+	 */
+	for (i = 0; i < io->num_jobs; i++) {
+		struct password_job *job = &io->jobs[i];
+
+		if (job->done == NULL) {
+			continue;
+		}
+		ret = job->done(io, job);
+		if (ret != LDB_SUCCESS && result == LDB_SUCCESS) {
+			result = ret;
+		}
+	}
+
+	TALLOC_FREE(io->jobs);
+	io->num_jobs = 0;
+
+	return result;
+}
+
+static void setup_kerberos_key_job(struct password_job *job)
+{
+	job->u.key.krb5_ret = smb_krb5_create_key_from_string(
+		job->u.key.krb5_context,
+		NULL,
+		&job->u.key.salt,
+		&job->u.key.cleartext,
+		job->u.key.enctype,
+		&job->u.key.key);
+}
+
+static int setup_kerberos_key_done(struct setup_password_fields_io *io,
+				   struct password_job *job)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(io->ac->module);
+	krb5_context krb5_context = job->u.key.krb5_context;
+	krb5_keyblock *key = &job->u.key.key;
+
+	if (job->u.key.krb5_ret) {
+		ldb_asprintf_errstring(ldb,
+				       "setup_kerberos_keys: "
+				       "generation of a %s key failed: %s",
+				       job->u.key.name,
+				       smb_get_krb5_error_message(krb5_context,
+								  job->u.key.krb5_ret,
+								  io->ac));
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+	*job->u.key.result = data_blob_talloc(io->ac,
+					      KRB5_KEY_DATA(key),
+					      KRB5_KEY_LENGTH(key));
+	krb5_free_keyblock_contents(krb5_context, key);
+	if (!job->u.key.result->data) {
+		return ldb_oom(ldb);
+	}
+
+	return LDB_SUCCESS;
+}
+
 static int setup_kerberos_keys(struct setup_password_fields_io *io)
 {
 	struct ldb_context *ldb;
@@ -674,8 +989,34 @@ static int setup_kerberos_keys(struct setup_password_fields_io *io)
 	char *salt_principal = NULL;
 	char *salt_data = NULL;
 	krb5_data salt;
-	krb5_keyblock key;
 	krb5_data cleartext_data;
+	struct {
+		krb5_enctype enctype;
+		const char *name;
+		DATA_BLOB *result;
+	} keys[] = {
+		{
+			.enctype = ENCTYPE_AES256_CTS_HMAC_SHA1_96,
+			.name = "aes256-cts-hmac-sha1-96",
+			.result = &io->g.aes_256,
+		},
+		{
+			.enctype = ENCTYPE_AES128_CTS_HMAC_SHA1_96,
+			.name = "aes128-cts-hmac-sha1-96",
+			.result = &io->g.aes_128,
+		},
+		{
+			.enctype = ENCTYPE_DES_CBC_MD5,
+			.name = "des-cbc-md5",
+			.result = &io->g.des_md5,
+		},
+		{
+			.enctype = ENCTYPE_DES_CBC_CRC,
+			.name = "des-cbc-crc",
+			.result = &io->g.des_crc,
+		},
+	};
+	size_t i;
 
 	ldb = ldb_module_get_ctx(io->ac->module);
 	cleartext_data.data = (char *)io->n.cleartext_utf8->data;
@@ -716,107 +1057,31 @@ static int setup_kerberos_keys(struct setup_password_fields_io *io)
 	salt.length	= strlen(io->g.salt);
 
 	/*
-	 * create ENCTYPE_AES256_CTS_HMAC_SHA1_96 key out of
-	 * the salt and the cleartext password
+	 * create the keys out of the salt and the cleartext password,
+	 * see run_password_jobs()
 	 */
-	krb5_ret = smb_krb5_create_key_from_string(io->smb_krb5_context->krb5_context,
-						   NULL,
-						   &salt,
-						   &cleartext_data,
-						   ENCTYPE_AES256_CTS_HMAC_SHA1_96,
-						   &key);
-	if (krb5_ret) {
-		ldb_asprintf_errstring(ldb,
-				       "setup_kerberos_keys: "
-				       "generation of a aes256-cts-hmac-sha1-96 key failed: %s",
-				       smb_get_krb5_error_message(io->smb_krb5_context->krb5_context,
-								  krb5_ret, io->ac));
-		return LDB_ERR_OPERATIONS_ERROR;
-	}
-	io->g.aes_256 = data_blob_talloc(io->ac,
-					 KRB5_KEY_DATA(&key),
-					 KRB5_KEY_LENGTH(&key));
-	krb5_free_keyblock_contents(io->smb_krb5_context->krb5_context, &key);
-	if (!io->g.aes_256.data) {
-		return ldb_oom(ldb);
-	}
-
-	/*
-	 * create ENCTYPE_AES128_CTS_HMAC_SHA1_96 key out of
-	 * the salt and the cleartext password
-	 */
-	krb5_ret = smb_krb5_create_key_from_string(io->smb_krb5_context->krb5_context,
-						   NULL,
-						   &salt,
-						   &cleartext_data,
-						   ENCTYPE_AES128_CTS_HMAC_SHA1_96,
-						   &key);
-	if (krb5_ret) {
-		ldb_asprintf_errstring(ldb,
-				       "setup_kerberos_keys: "
-				       "generation of a aes128-cts-hmac-sha1-96 key failed: %s",
-				       smb_get_krb5_error_message(io->smb_krb5_context->krb5_context,
-								  krb5_ret, io->ac));
-		return LDB_ERR_OPERATIONS_ERROR;
-	}
-	io->g.aes_128 = data_blob_talloc(io->ac,
-					 KRB5_KEY_DATA(&key),
-					 KRB5_KEY_LENGTH(&key));
-	krb5_free_keyblock_contents(io->smb_krb5_context->krb5_context, &key);
-	if (!io->g.aes_128.data) {
-		return ldb_oom(ldb);
-	}
-
-	/*
-	 * create ENCTYPE_DES_CBC_MD5 key out of
-	 * the salt and the cleartext password
-	 */
-	krb5_ret = smb_krb5_create_key_from_string(io->smb_krb5_context->krb5_context,
-						   NULL,
-						   &salt,
-						   &cleartext_data,
-						   ENCTYPE_DES_CBC_MD5,
-						   &key);
-	if (krb5_ret) {
-		ldb_asprintf_errstring(ldb,
-				       "setup_kerberos_keys: "
-				       "generation of a des-cbc-md5 key failed: %s",
-				       smb_get_krb5_error_message(io->smb_krb5_context->krb5_context,
-								  krb5_ret, io->ac));
-		return LDB_ERR_OPERATIONS_ERROR;
-	}
-	io->g.des_md5 = data_blob_talloc(io->ac,
-					 KRB5_KEY_DATA(&key),
-					 KRB5_KEY_LENGTH(&key));
-	krb5_free_keyblock_contents(io->smb_krb5_context->krb5_context, &key);
-	if (!io->g.des_md5.data) {
-		return ldb_oom(ldb);
-	}
+	for (i = 0; i < ARRAY_SIZE(keys); i++) {
+		struct password_job *job = NULL;
 
-	/*
-	 * create ENCTYPE_DES_CBC_CRC key out of
-	 * the salt and the cleartext password
-	 */
-	krb5_ret = smb_krb5_create_key_from_string(io->smb_krb5_context->krb5_context,
-						   NULL,
-						   &salt,
-						   &cleartext_data,
-						   ENCTYPE_DES_CBC_CRC,
-						   &key);
-	if (krb5_ret) {
-		ldb_asprintf_errstring(ldb,
-				       "setup_kerberos_keys: "
-				       "generation of a des-cbc-crc key failed: %s",
-				       smb_get_krb5_error_message(io->smb_krb5_context->krb5_context,
-								  krb5_ret, io->ac));
-		return LDB_ERR_OPERATIONS_ERROR;
-	}
-	io->g.des_crc = data_blob_talloc(io->ac,
-					 KRB5_KEY_DATA(&key),
-					 KRB5_KEY_LENGTH(&key));
-	krb5_free_keyblock_contents(io->smb_krb5_context->krb5_context, &key);
-	if (!io->g.des_crc.data) {
-		return ldb_oom(ldb);
+		job = add_password_job(io,
+				       setup_kerberos_key_job,
+				       setup_kerberos_key_done);
+		if (job == NULL) {
+			return ldb_oom(ldb);
+		}
+#ifdef SAMBA4_USES_HEIMDAL
+		/*
+		 * Heimdal only uses the krb5_context for error
+		 * messages here, and guards those with a mutex.
+		 */
+		job->thread_safe = true;
+#endif
+		job->u.key.krb5_context = io->smb_krb5_context->krb5_context;
+		job->u.key.salt = salt;
+		job->u.key.cleartext = cleartext_data;
+		job->u.key.enctype = keys[i].enctype;
+		job->u.key.name = keys[i].name;
+		job->u.key.result = keys[i].result;
 	}
 
 	return LDB_SUCCESS;
@@ -1419,9 +1684,74 @@ static bool parse_scheme(const char *scheme, int *algorithm, int *rounds) {
 	return true;
 }
 
+static void setup_userPassword_hash_job(struct password_job *job)
+{
+	/*
+	 * Relies on the assertion that cleartext_utf8->data is a zero
+	 * terminated UTF-8 string
+	 */
+#ifdef HAVE_CRYPT_R
+	job->u.crypt.hash = crypt_r(discard_const_p(char, job->u.crypt.password),
+				    job->u.crypt.setting,
+				    job->u.crypt.crypt_data);
+#else
+	/*
+	 * No crypt_r falling back to crypt, which is NOT thread safe
+	 * Thread safety MT-Unsafe race:crypt
+	 */
+	job->u.crypt.hash = crypt(discard_const_p(char, job->u.crypt.password),
+				  job->u.crypt.setting);
+#endif
+	if (job->u.crypt.hash == NULL) {
+		job->u.crypt.err = errno;
+	}
+}
+
+static int setup_userPassword_hash_done(struct setup_password_fields_io *io,
+					struct password_job *job)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(io->ac->module);
+	struct package_PrimaryUserPasswordValue *hash_value =
+		job->u.crypt.result;
+	DATA_BLOB *hash_blob = NULL;
+
+	if (job->u.crypt.hash == NULL) {
+		char buf[1024];
+		int err = strerror_r(job->u.crypt.err, buf, sizeof(buf));
+		if (err != 0) {
+			strlcpy(buf, "Unknown error", sizeof(buf)-1);
+		}
+		ldb_asprintf_errstring(
+			ldb,
+			"setup_primary_userPassword: generation of a %s "
+			"password hash failed: (%s)",
+			job->u.crypt.scheme,
+			buf);
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	hash_blob = talloc_zero(io->g.userPassword_hashes, DATA_BLOB);
+
+	if (hash_blob == NULL) {
+		return ldb_oom(ldb);
+	}
+
+	*hash_blob =  data_blob_talloc(hash_blob,
+				       (const uint8_t *)job->u.crypt.hash,
+				       strlen(job->u.crypt.hash));
+	if (hash_blob->data == NULL) {
+		return ldb_oom(ldb);
+	}
+	hash_value->value = hash_blob;
+#ifdef HAVE_CRYPT_R
+	TALLOC_FREE(job->u.crypt.crypt_data);
+#endif
+	return LDB_SUCCESS;
+}
+
 /*
  * Calculate the password hash specified by scheme, and return it in
- * hash_value
+ * hash_value, once run_password_jobs() ran the job queued here.
  */
 static int setup_primary_userPassword_hash(
 	TALLOC_CTX *ctx,
@@ -1432,14 +1762,10 @@ static int setup_primary_userPassword_hash(
 	struct ldb_context *ldb = ldb_module_get_ctx(io->ac->module);
 	const char *salt = NULL;        /* Randomly generated salt */
 	const char *cmd = NULL;         /* command passed to crypt */
-	const char *hash = NULL;        /* password hash generated by crypt */
 	int algorithm = 0;              /* crypt hash algorithm number */
 	int rounds = 0;                 /* The number of hash rounds */
-	DATA_BLOB *hash_blob = NULL;
+	struct password_job *job = NULL;
 	TALLOC_CTX *frame = talloc_stackframe();
-#ifdef HAVE_CRYPT_R
-	struct crypt_data crypt_data;   /* working storage used by crypt */
-#endif
 
 	/* Genrate a random password salt */
 	salt = generate_random_str_list(frame,
@@ -1466,60 +1792,75 @@ static int setup_primary_userPassword_hash(
 
 	/* generate the id/salt parameter used by crypt */
 	if (rounds) {
-		cmd = talloc_asprintf(frame,
+		cmd = talloc_asprintf(ctx,
 			              "$%d$rounds=%d$%s",
 				      algorithm,
 				      rounds,
 				      salt);
 	} else {
-		cmd = talloc_asprintf(frame, "$%d$%s", algorithm, salt);
+		cmd = talloc_asprintf(ctx, "$%d$%s", algorithm, salt);
+	}
+	TALLOC_FREE(frame);
+	if (cmd == NULL) {
+		return ldb_oom(ldb);
 	}
 
-	/*
-	 * Relies on the assertion that cleartext_utf8->data is a zero
-	 * terminated UTF-8 string
-	 */
+	job = add_password_job(io,
+			       setup_userPassword_hash_job,
+			       setup_userPassword_hash_done);
+	if (job == NULL) {
+		return ldb_oom(ldb);
+	}
+	job->u.crypt.password = (const char *)io->n.cleartext_utf8->data;
+	job->u.crypt.setting = cmd;
+	job->u.crypt.scheme = scheme;
+	job->u.crypt.result = hash_value;
 #ifdef HAVE_CRYPT_R
-	hash = crypt_r((char *)io->n.cleartext_utf8->data, cmd, &crypt_data);
-#else
-	/*
-	 * No crypt_r falling back to crypt, which is NOT thread safe
-	 * Thread safety MT-Unsafe race:crypt
-	 */
-	hash = crypt((char *)io->n.cleartext_utf8->data, cmd);
-#endif
-	if (hash == NULL) {
-		char buf[1024];
-		int err = strerror_r(errno, buf, sizeof(buf));
-		if (err != 0) {
-			strlcpy(buf, "Unknown error", sizeof(buf)-1);
-		}
-		ldb_asprintf_errstring(
-			ldb,
-			"setup_primary_userPassword: generation of a %s "
-			"password hash failed: (%s)",
-			scheme,
-			buf);
-		TALLOC_FREE(frame);
-		return LDB_ERR_OPERATIONS_ERROR;
+	/* working storage used by crypt */
+	job->u.crypt.crypt_data = talloc_zero(ctx, struct crypt_data);
+	if (job->u.crypt.crypt_data == NULL) {
+		return ldb_oom(ldb);
 	}
+	job->thread_safe = true;
+#endif
 
-	hash_blob = talloc_zero(ctx, DATA_BLOB);
+	return LDB_SUCCESS;
+}
 
-	if (hash_blob == NULL) {
-		TALLOC_FREE(frame);
-		return ldb_oom(ldb);
+/*
+ * Queue the desired extra password hashes, they are run together
+ * with the Kerberos keys.
+ */
+static int setup_userPassword_hashes(struct setup_password_fields_io *io)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(io->ac->module);
+	size_t num_hashes = 0;
+	size_t i;
+	int ret;
+
+	for (i = 0; io->ac->userPassword_schemes[i]; i++) {
+		num_hashes++;
 	}
 
-	*hash_blob =  data_blob_talloc(hash_blob,
-				       (const uint8_t *)hash,
-				       strlen(hash));
-	if (hash_blob->data == NULL) {
-		TALLOC_FREE(frame);
+	io->g.userPassword_hashes
+		= talloc_zero_array(io->ac,
+				    struct package_PrimaryUserPasswordValue,
+				    num_hashes);
+	if (io->g.userPassword_hashes == NULL) {
 		return ldb_oom(ldb);
 	}
-	hash_value->value = hash_blob;
-	TALLOC_FREE(frame);
+
+	for (i = 0; io->ac->userPassword_schemes[i]; i++) {
+		ret = setup_primary_userPassword_hash(
+			io->g.userPassword_hashes,
+			io,
+			io->ac->userPassword_schemes[i],
+			&io->g.userPassword_hashes[i]);
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
+	}
+
 	return LDB_SUCCESS;
 }
 
@@ -1532,9 +1873,7 @@ static int setup_primary_userPassword(
 	struct package_PrimaryUserPasswordBlob *p_userPassword_b)
 {
 	struct ldb_context *ldb = ldb_module_get_ctx(io->ac->module);
-	TALLOC_CTX *frame = talloc_stackframe();
 	int i;
-	int ret;
 
 	/*
 	 * Save the current nt_hash, use this to determine if the password
@@ -1560,26 +1899,12 @@ static int setup_primary_userPassword(
 		p_userPassword_b->num_hashes++;
 	}
 
-	p_userPassword_b->hashes
-		= talloc_array(io->ac,
-			       struct package_PrimaryUserPasswordValue,
-			       p_userPassword_b->num_hashes);
+	/* calculated by setup_userPassword_hashes() */
+	p_userPassword_b->hashes = io->g.userPassword_hashes;
 	if (p_userPassword_b->hashes == NULL) {
-		TALLOC_FREE(frame);
-		return ldb_oom(ldb);
+		return ldb_operr(ldb);
 	}
 
-	for (i = 0; io->ac->userPassword_schemes[i]; i++) {
-		ret = setup_primary_userPassword_hash(
-			p_userPassword_b->hashes,
-			io,
-			io->ac->userPassword_schemes[i],
-			&p_userPassword_b->hashes[i]);
-		if (ret != LDB_SUCCESS) {
-			TALLOC_FREE(frame);
-			return ret;
-		}
-	}
 	return LDB_SUCCESS;
 }
 
@@ -2420,6 +2745,18 @@ static int setup_password_fields(struct setup_password_fields_io *io)
 		if (ret != LDB_SUCCESS) {
 			return ret;
 		}
+
+		if (io->ac->userPassword_schemes) {
+			ret = setup_userPassword_hashes(io);
+			if (ret != LDB_SUCCESS) {
+				return ret;
+			}
+		}
+
+		ret = run_password_jobs(io);
+		if (ret != LDB_SUCCESS) {
+			return ret;
+		}
 	}
 
 	ret = setup_nt_fields(io);
@@ -4577,8 +4914,68 @@ static int password_hash_mod_do_mod(struct ph_context *ac)
 	return ldb_next_request(ac->module, mod_req);
 }
 
+#ifdef WITH_PTHREADPOOL
+static int ph_private_destructor(struct ph_private *ph_private)
+{
+	if (ph_private->pool != NULL) {
+		pthreadpool_destroy(ph_private->pool);
+		ph_private->pool = NULL;
+	}
+	return 0;
+}
+#endif
+
+static int password_hash_init(struct ldb_module *module)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	struct ph_private *ph_private = NULL;
+#ifdef WITH_PTHREADPOOL
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int threads;
+	int ret;
+#endif
+
+	ph_private = talloc_zero(module, struct ph_private);
+	if (ph_private == NULL) {
+		return ldb_module_oom(module);
+	}
+
+#ifdef WITH_PTHREADPOOL
+	/*
+	 * The number of key derivations of a password set that run at
+	 * the same time, including the one run by the main thread.
+	 * There are only four Kerberos keys plus the configured
+	 * userPassword schemes, so more threads than that are of no
+	 * use.
+	 */
+	threads = lpcfg_parm_int(ldb_get_opaque(ldb, "loadparm"),
+				 NULL, "password hash", "threads",
+				 MIN(MAX(num_cpus, 1), 4));
+	if (threads > 1) {
+		ret = pthreadpool_init(threads - 1,
+				       &ph_private->pool,
+				       password_job_signal,
+				       NULL);
+		if (ret != 0) {
+			ldb_debug(ldb, LDB_DEBUG_ERROR,
+				  "password_hash: pthreadpool_init failed: %s, "
+				  "hashing passwords in the main thread\n",
+				  strerror(ret));
+			ph_private->pool = NULL;
+		}
+		talloc_set_destructor(ph_private, ph_private_destructor);
+	}
+#else
+	(void)ldb;
+#endif
+
+	ldb_module_set_private(module, ph_private);
+	return ldb_next_init(module);
+}
+
 static const struct ldb_module_ops ldb_password_hash_module_ops = {
 	.name          = "password_hash",
+	.init_context  = password_hash_init,
 	.add           = password_hash_add,
 	.modify        = password_hash_modify
 };
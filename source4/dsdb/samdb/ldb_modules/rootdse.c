@@ -487,6 +487,28 @@ static int rootdse_add_dynamic(struct rootdse_context *ac, struct ldb_message *m
 		}
 	}
 
+	if (do_attribute_explicit(attrs, "moduleTiming")) {
+		/* Only administrators see what the modules spend */
+		struct auth_session_info *session_info
+			= (struct auth_session_info *)ldb_get_opaque(ldb, "sessionInfo");
+		enum security_user_level level
+			= security_session_user_level(session_info, NULL);
+
+		if (level >= SECURITY_ADMINISTRATOR) {
+			const char **report = ldb_module_timing_report(msg);
+
+			if (report == NULL) {
+				goto failed;
+			}
+			for (i = 0; report[i] != NULL; i++) {
+				if (ldb_msg_add_string(msg, "moduleTiming",
+						       report[i]) != LDB_SUCCESS) {
+					goto failed;
+				}
+			}
+		}
+	}
+
 	/* TODO: lots more dynamic attributes should be added here */
 
 	edn_control = ldb_request_get_control(ac->req, LDB_CONTROL_EXTENDED_DN_OID);
@@ -990,6 +1012,15 @@ static int rootdse_init(struct ldb_module *module)
 		return ret;
 	}
 
+	/*
+	 * With "dsdb:module timing = yes" every process that opens the
+	 * database times its modules from the start
+	 */
+	if (lpcfg_parm_bool(ldb_get_opaque(ldb, "loadparm"),
+			    NULL, "dsdb", "module timing", false)) {
+		ldb_module_timing_enable(true);
+	}
+
 	mem_ctx = talloc_new(data);
 	if (!mem_ctx) {
 		return ldb_oom(ldb);
@@ -1620,6 +1651,44 @@ static int rootdse_become_master(struct ldb_module *module,
 	return LDB_SUCCESS;
 }
 
+/*
+ * "moduleTiming: enable", "disable" or "reset" starts, stops or clears
+ * the per-module timing of this process, read back in the moduleTiming
+ * attribute of the rootDSE.
+ */
+static int rootdse_moduletiming(struct ldb_module *module, struct ldb_request *req)
+{
+	struct ldb_context *ldb = ldb_module_get_ctx(module);
+	struct auth_session_info *session_info;
+	enum security_user_level level;
+	struct ldb_message_element *el;
+
+	session_info = (struct auth_session_info *)ldb_get_opaque(ldb, "sessionInfo");
+	level = security_session_user_level(session_info, NULL);
+	if (level < SECURITY_ADMINISTRATOR) {
+		return ldb_error(ldb, LDB_ERR_INSUFFICIENT_ACCESS_RIGHTS, "Denied rootDSE modify for non-administrator");
+	}
+
+	el = ldb_msg_find_element(req->op.mod.message, "moduleTiming");
+	if (el->num_values != 1) {
+		return ldb_error(ldb, LDB_ERR_UNWILLING_TO_PERFORM,
+				 "moduleTiming must have one value");
+	}
+
+	if (ldb_val_string_cmp(&el->values[0], "enable") == 0) {
+		ldb_module_timing_enable(true);
+	} else if (ldb_val_string_cmp(&el->values[0], "disable") == 0) {
+		ldb_module_timing_enable(false);
+	} else if (ldb_val_string_cmp(&el->values[0], "reset") == 0) {
+		ldb_module_timing_reset();
+	} else {
+		return ldb_error(ldb, LDB_ERR_UNWILLING_TO_PERFORM,
+				 "moduleTiming must be enable, disable or reset");
+	}
+
+	return ldb_module_done(req, NULL, NULL, LDB_SUCCESS);
+}
+
 static int rootdse_modify(struct ldb_module *module, struct ldb_request *req)
 {
 	struct ldb_context *ldb = ldb_module_get_ctx(module);
@@ -1670,6 +1739,9 @@ static int rootdse_modify(struct ldb_module *module, struct ldb_request *req)
 	if (ldb_msg_find_element(req->op.mod.message, "schemaUpgradeInProgress")) {
 		return rootdse_schemaupgradeinprogress(module, req);
 	}
+	if (ldb_msg_find_element(req->op.mod.message, "moduleTiming")) {
+		return rootdse_moduletiming(module, req);
+	}
 
 	ldb_set_errstring(ldb, "rootdse_modify: unknown attribute to change!");
 	return LDB_ERR_UNWILLING_TO_PERFORM;
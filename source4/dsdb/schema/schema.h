@@ -207,6 +207,18 @@ struct dsdb_schema_info {
 };
 
 
+/*
+ * An open addressing hash table (linear probing) over one of the
+ * sorted accessor arrays of struct dsdb_schema.  The slots hold the
+ * index into the array plus one, zero marks an empty slot.  Built by
+ * dsdb_setup_sorted_accessors(), using dsdb_schema_hash_name() or
+ * dsdb_schema_hash_id() on the key.
+ */
+struct dsdb_schema_hash {
+	uint32_t mask;
+	uint32_t *slots;
+};
+
 struct dsdb_schema {
 	struct dsdb_schema_prefixmap *prefixmap;
 
@@ -245,6 +257,13 @@ struct dsdb_schema {
 	uint32_t num_int_id_attr;
 	struct dsdb_attribute **attributes_by_msDS_IntId;
 
+	/* hash tables over some of the lists above, for the lookups
+	   every module does for every attribute of every object */
+	struct dsdb_schema_hash classes_hash_lDAPDisplayName;
+	struct dsdb_schema_hash attributes_hash_lDAPDisplayName;
+	struct dsdb_schema_hash attributes_hash_attributeID_id;
+	struct dsdb_schema_hash attributes_hash_msDS_IntId;
+
 	struct {
 		bool we_are_master;
 		bool update_allowed;
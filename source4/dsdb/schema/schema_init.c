@@ -472,6 +472,25 @@ static bool dsdb_schema_unique_attribute(const char *attr)
 }
 
 
+/*
+  attributes that are searched by range, such as the (uSNChanged>=N)
+  of every replication cycle, get an ordered index
+ */
+static bool dsdb_schema_ordered_attribute(const char *attr)
+{
+	const char *attrs[] = { "uSNChanged", "uSNCreated",
+				"whenChanged", "whenCreated",
+				"lastLogonTimestamp", NULL };
+	unsigned int i;
+	for (i=0;attrs[i];i++) {
+		if (ldb_attr_cmp(attr, attrs[i]) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
 /*
   setup the ldb_schema_attribute field for a dsdb_attribute
  */
@@ -517,6 +536,16 @@ static int dsdb_schema_setup_ldb_schema_attribute(struct ldb_context *ldb,
 	if (attr->searchFlags & SEARCH_FLAG_ATTINDEX) {
 		a->flags |= LDB_ATTR_FLAG_INDEXED;
 	}
+	if (dsdb_schema_ordered_attribute(a->name)) {
+		a->flags |= LDB_ATTR_FLAG_ORDERED_INDEX;
+	}
+	/*
+	 * ANR searches are initial substring searches, as are most
+	 * searches on attributes marked for tuple (substring) indexing
+	 */
+	if (attr->searchFlags & (SEARCH_FLAG_ANR|SEARCH_FLAG_TUPLEINDEX)) {
+		a->flags |= LDB_ATTR_FLAG_PREFIX_INDEX;
+	}
 
 	
 	return LDB_SUCCESS;
@@ -54,6 +54,65 @@ static int strcasecmp_with_ldb_val(const struct ldb_val *target, const char *str
 	return ret;
 }
 
+/*
+ * The hash of an lDAPDisplayName for the dsdb_schema_hash tables.
+ * Like the strcasecmp() of the sorted arrays it ignores the case of
+ * ASCII letters, and it stops at len bytes or at the first NUL.
+ * (32 bit FNV-1a)
+ */
+uint32_t dsdb_schema_hash_name(const char *name, size_t len)
+{
+	uint32_t h = 2166136261U;
+	size_t i;
+
+	for (i = 0; i < len && name[i] != '\0'; i++) {
+		uint8_t c = name[i];
+		if (c >= 'A' && c <= 'Z') {
+			c += 'a' - 'A';
+		}
+		h ^= c;
+		h *= 16777619U;
+	}
+
+	return h;
+}
+
+/*
+ * The hash of an attributeID_id or msDS_IntId, these share their
+ * upper bits, so they are mixed down into the lower ones the tables
+ * use (the finaliser of MurmurHash3)
+ */
+uint32_t dsdb_schema_hash_id(uint32_t id)
+{
+	id ^= id >> 16;
+	id *= 0x85ebca6bU;
+	id ^= id >> 13;
+	id *= 0xc2b2ae35U;
+	id ^= id >> 16;
+
+	return id;
+}
+
+/*
+  like BINARY_ARRAY_SEARCH_P, but finds the element through the
+  dsdb_schema_hash built over the sorted array, starting at the slot
+  of hash_value
+ */
+#define SCHEMA_HASH_SEARCH_P(hash, array, field, target, hash_value, comparison_fn, result) do { \
+	uint32_t _s; \
+	(result) = NULL; \
+	if ((hash).slots != NULL) { \
+		for (_s = (hash_value) & (hash).mask; \
+		     (hash).slots[_s] != 0; \
+		     _s = (_s + 1) & (hash).mask) { \
+			uint32_t _i = (hash).slots[_s] - 1; \
+			if (comparison_fn(target, array[_i]->field) == 0) { \
+				(result) = array[_i]; \
+				break; \
+			} \
+		} \
+	} } while (0)
+
 const struct dsdb_attribute *dsdb_attribute_by_attributeID_id(const struct dsdb_schema *schema,
 							      uint32_t id)
 {
@@ -67,13 +126,17 @@ const struct dsdb_attribute *dsdb_attribute_by_attributeID_id(const struct dsdb_
 
 	/* check for msDS-IntId type attribute */
 	if (dsdb_pfm_get_attid_type(id) == DSDB_ATTID_TYPE_INTID) {
-		BINARY_ARRAY_SEARCH_P(schema->attributes_by_msDS_IntId,
-				      schema->num_int_id_attr, msDS_IntId, id, uint32_cmp, c);
+		SCHEMA_HASH_SEARCH_P(schema->attributes_hash_msDS_IntId,
+				     schema->attributes_by_msDS_IntId,
+				     msDS_IntId, id, dsdb_schema_hash_id(id),
+				     uint32_cmp, c);
 		return c;
 	}
 
-	BINARY_ARRAY_SEARCH_P(schema->attributes_by_attributeID_id,
-			      schema->num_attributes, attributeID_id, id, uint32_cmp, c);
+	SCHEMA_HASH_SEARCH_P(schema->attributes_hash_attributeID_id,
+			     schema->attributes_by_attributeID_id,
+			     attributeID_id, id, dsdb_schema_hash_id(id),
+			     uint32_cmp, c);
 	return c;
 }
 
@@ -96,8 +159,11 @@ const struct dsdb_attribute *dsdb_attribute_by_lDAPDisplayName(const struct dsdb
 
 	if (!name) return NULL;
 
-	BINARY_ARRAY_SEARCH_P(schema->attributes_by_lDAPDisplayName,
-			      schema->num_attributes, lDAPDisplayName, name, strcasecmp, c);
+	SCHEMA_HASH_SEARCH_P(schema->attributes_hash_lDAPDisplayName,
+			     schema->attributes_by_lDAPDisplayName,
+			     lDAPDisplayName, name,
+			     dsdb_schema_hash_name(name, SIZE_MAX),
+			     strcasecmp, c);
 	return c;
 }
 
@@ -108,8 +174,12 @@ const struct dsdb_attribute *dsdb_attribute_by_lDAPDisplayName_ldb_val(const str
 
 	if (!name) return NULL;
 
-	BINARY_ARRAY_SEARCH_P(schema->attributes_by_lDAPDisplayName,
-			      schema->num_attributes, lDAPDisplayName, name, strcasecmp_with_ldb_val, a);
+	SCHEMA_HASH_SEARCH_P(schema->attributes_hash_lDAPDisplayName,
+			     schema->attributes_by_lDAPDisplayName,
+			     lDAPDisplayName, name,
+			     dsdb_schema_hash_name((const char *)name->data,
+						   name->length),
+			     strcasecmp_with_ldb_val, a);
 	return a;
 }
 
@@ -154,8 +224,11 @@ const struct dsdb_class *dsdb_class_by_lDAPDisplayName(const struct dsdb_schema
 {
 	struct dsdb_class *c;
 	if (!name) return NULL;
-	BINARY_ARRAY_SEARCH_P(schema->classes_by_lDAPDisplayName,
-			      schema->num_classes, lDAPDisplayName, name, strcasecmp, c);
+	SCHEMA_HASH_SEARCH_P(schema->classes_hash_lDAPDisplayName,
+			     schema->classes_by_lDAPDisplayName,
+			     lDAPDisplayName, name,
+			     dsdb_schema_hash_name(name, SIZE_MAX),
+			     strcasecmp, c);
 	return c;
 }
 
@@ -164,8 +237,12 @@ const struct dsdb_class *dsdb_class_by_lDAPDisplayName_ldb_val(const struct dsdb
 {
 	struct dsdb_class *c;
 	if (!name) return NULL;
-	BINARY_ARRAY_SEARCH_P(schema->classes_by_lDAPDisplayName,
-			      schema->num_classes, lDAPDisplayName, name, strcasecmp_with_ldb_val, c);
+	SCHEMA_HASH_SEARCH_P(schema->classes_hash_lDAPDisplayName,
+			     schema->classes_by_lDAPDisplayName,
+			     lDAPDisplayName, name,
+			     dsdb_schema_hash_name((const char *)name->data,
+						   name->length),
+			     strcasecmp_with_ldb_val, c);
 	return c;
 }
 
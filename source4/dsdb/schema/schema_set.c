@@ -33,7 +33,7 @@
 /* change this when we change something in our schema code that
  * requires a re-index of the database
  */
-#define SAMDB_INDEXING_VERSION "2"
+#define SAMDB_INDEXING_VERSION "5"
 
 /*
   override the name to attribute handler function
@@ -129,6 +129,22 @@ int dsdb_schema_set_indices_and_attributes(struct ldb_context *ldb,
 		}
 	}
 
+	/*
+	 * Store records with an attribute directory, so searches only
+	 * decode the attributes they need.  Changing this re-indexes
+	 * the database, which rewrites every record in the selected
+	 * format.  Older Samba versions can not read the new format,
+	 * so it is only used when asked for, and setting the option
+	 * back to "no" rewrites the records in the original format.
+	 */
+	if (lp_ctx != NULL &&
+	    lpcfg_parm_bool(lp_ctx, NULL, "dsdb", "pack format v2", false)) {
+		ret = ldb_msg_add_string(msg_idx, "@PACK_FORMAT", "2");
+		if (ret != LDB_SUCCESS) {
+			goto op_error;
+		}
+	}
+
 	ret = ldb_msg_add_string(msg_idx, "@SAMDB_INDEXING_VERSION", SAMDB_INDEXING_VERSION);
 	if (ret != LDB_SUCCESS) {
 		goto op_error;
@@ -165,6 +181,22 @@ int dsdb_schema_set_indices_and_attributes(struct ldb_context *ldb,
 				break;
 			}
 		}
+
+		if (attr->ldb_schema_attribute != NULL &&
+		    attr->ldb_schema_attribute->flags & LDB_ATTR_FLAG_ORDERED_INDEX) {
+			ret = ldb_msg_add_string(msg_idx, "@IDXORDERED", attr->lDAPDisplayName);
+			if (ret != LDB_SUCCESS) {
+				break;
+			}
+		}
+
+		if (attr->ldb_schema_attribute != NULL &&
+		    attr->ldb_schema_attribute->flags & LDB_ATTR_FLAG_PREFIX_INDEX) {
+			ret = ldb_msg_add_string(msg_idx, "@IDXPREFIX", attr->lDAPDisplayName);
+			if (ret != LDB_SUCCESS) {
+				break;
+			}
+		}
 	}
 
 	if (ret != LDB_SUCCESS) {
@@ -394,6 +426,120 @@ static int dsdb_compare_attribute_by_linkID(struct dsdb_attribute **a1, struct d
 	return uint32_cmp((*a1)->linkID, (*a2)->linkID);
 }
 
+/*
+ * Size a hash table for num entries, at most half of the slots are
+ * used, so the probe sequences stay short
+ */
+static bool dsdb_schema_hash_init(TALLOC_CTX *mem_ctx,
+				  struct dsdb_schema_hash *hash,
+				  uint32_t num)
+{
+	uint32_t size = 16;
+
+	while (size < num * 2) {
+		size *= 2;
+	}
+
+	hash->slots = talloc_zero_array(mem_ctx, uint32_t, size);
+	if (hash->slots == NULL) {
+		return false;
+	}
+	hash->mask = size - 1;
+
+	return true;
+}
+
+/*
+ * Add the element at idx of the sorted array.  With duplicate keys
+ * the first one added is found, so add them in the order of the
+ * array.
+ */
+static void dsdb_schema_hash_add(struct dsdb_schema_hash *hash,
+				 uint32_t hash_value,
+				 uint32_t idx)
+{
+	uint32_t s = hash_value & hash->mask;
+
+	while (hash->slots[s] != 0) {
+		s = (s + 1) & hash->mask;
+	}
+	hash->slots[s] = idx + 1;
+}
+
+static void dsdb_schema_hash_free(struct dsdb_schema_hash *hash)
+{
+	TALLOC_FREE(hash->slots);
+	hash->mask = 0;
+}
+
+static const char *dsdb_schema_hash_key(const char *name)
+{
+	return name != NULL ? name : "";
+}
+
+/*
+  create the hash tables over the sorted accessor arrays
+ */
+static bool dsdb_setup_hash_accessors(struct dsdb_schema *schema)
+{
+	uint32_t i;
+
+	if (!dsdb_schema_hash_init(schema,
+				   &schema->classes_hash_lDAPDisplayName,
+				   schema->num_classes) ||
+	    !dsdb_schema_hash_init(schema,
+				   &schema->attributes_hash_lDAPDisplayName,
+				   schema->num_attributes) ||
+	    !dsdb_schema_hash_init(schema,
+				   &schema->attributes_hash_attributeID_id,
+				   schema->num_attributes) ||
+	    !dsdb_schema_hash_init(schema,
+				   &schema->attributes_hash_msDS_IntId,
+				   schema->num_int_id_attr)) {
+		return false;
+	}
+
+	for (i = 0; i < schema->num_classes; i++) {
+		const struct dsdb_class *c =
+			schema->classes_by_lDAPDisplayName[i];
+		const char *name = dsdb_schema_hash_key(c->lDAPDisplayName);
+
+		dsdb_schema_hash_add(&schema->classes_hash_lDAPDisplayName,
+				     dsdb_schema_hash_name(name, SIZE_MAX),
+				     i);
+	}
+
+	for (i = 0; i < schema->num_attributes; i++) {
+		const struct dsdb_attribute *a =
+			schema->attributes_by_lDAPDisplayName[i];
+		const char *name = dsdb_schema_hash_key(a->lDAPDisplayName);
+
+		dsdb_schema_hash_add(&schema->attributes_hash_lDAPDisplayName,
+				     dsdb_schema_hash_name(name, SIZE_MAX),
+				     i);
+	}
+
+	for (i = 0; i < schema->num_attributes; i++) {
+		const struct dsdb_attribute *a =
+			schema->attributes_by_attributeID_id[i];
+
+		dsdb_schema_hash_add(&schema->attributes_hash_attributeID_id,
+				     dsdb_schema_hash_id(a->attributeID_id),
+				     i);
+	}
+
+	for (i = 0; i < schema->num_int_id_attr; i++) {
+		const struct dsdb_attribute *a =
+			schema->attributes_by_msDS_IntId[i];
+
+		dsdb_schema_hash_add(&schema->attributes_hash_msDS_IntId,
+				     dsdb_schema_hash_id(a->msDS_IntId),
+				     i);
+	}
+
+	return true;
+}
+
 /**
  * Clean up Classes and Attributes accessor arrays
  */
@@ -410,6 +556,11 @@ static void dsdb_sorted_accessors_free(struct dsdb_schema *schema)
 	TALLOC_FREE(schema->attributes_by_msDS_IntId);
 	TALLOC_FREE(schema->attributes_by_attributeID_oid);
 	TALLOC_FREE(schema->attributes_by_linkID);
+	/* free the hash tables over them */
+	dsdb_schema_hash_free(&schema->classes_hash_lDAPDisplayName);
+	dsdb_schema_hash_free(&schema->attributes_hash_lDAPDisplayName);
+	dsdb_schema_hash_free(&schema->attributes_hash_attributeID_id);
+	dsdb_schema_hash_free(&schema->attributes_hash_msDS_IntId);
 }
 
 /*
@@ -519,6 +670,10 @@ int dsdb_setup_sorted_accessors(struct ldb_context *ldb,
 	TYPESAFE_QSORT(schema->attributes_by_attributeID_oid, schema->num_attributes, dsdb_compare_attribute_by_attributeID_oid);
 	TYPESAFE_QSORT(schema->attributes_by_linkID, schema->num_attributes, dsdb_compare_attribute_by_linkID);
 
+	if (!dsdb_setup_hash_accessors(schema)) {
+		goto failed;
+	}
+
 	dsdb_setup_attribute_shortcuts(ldb, schema);
 
 	ret = schema_fill_constructed(schema);
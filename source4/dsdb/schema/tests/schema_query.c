@@ -0,0 +1,291 @@
+/*
+   Unix SMB/CIFS implementation.
+
+   Test the DSDB schema lookup functions
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "includes.h"
+#include <ldb.h>
+#include "dsdb/samdb/samdb.h"
+#include "param/param.h"
+#include "torture/smbtorture.h"
+#include "torture/local/proto.h"
+#include "param/provision.h"
+#include "lib/util/binsearch.h"
+
+struct torture_dsdb_schema_query {
+	struct ldb_context *ldb;
+	const struct dsdb_schema *schema;
+};
+
+/*
+ * Every attribute and class is found by its lDAPDisplayName, in any
+ * case and as an ldb_val that is not NUL terminated, and by its
+ * attributeID_id and msDS_IntId
+ */
+static bool torture_dsdb_schema_lookups(struct torture_context *tctx,
+					struct torture_dsdb_schema_query *priv)
+{
+	const struct dsdb_schema *schema = priv->schema;
+	const struct dsdb_attribute *a;
+	const struct dsdb_class *c;
+
+	for (a = schema->attributes; a != NULL; a = a->next) {
+		char *upper = strupper_talloc(tctx, a->lDAPDisplayName);
+		char *padded = talloc_asprintf(tctx, "%sXYZ",
+					       a->lDAPDisplayName);
+		struct ldb_val val = {
+			.data = (uint8_t *)padded,
+			.length = strlen(a->lDAPDisplayName),
+		};
+
+		torture_assert(tctx, upper != NULL && padded != NULL,
+			       "No memory");
+
+		torture_assert(tctx,
+			       dsdb_attribute_by_lDAPDisplayName(
+				       schema, a->lDAPDisplayName) == a,
+			       a->lDAPDisplayName);
+		torture_assert(tctx,
+			       dsdb_attribute_by_lDAPDisplayName(
+				       schema, upper) == a,
+			       upper);
+		torture_assert(tctx,
+			       dsdb_attribute_by_lDAPDisplayName_ldb_val(
+				       schema, &val) == a,
+			       padded);
+		torture_assert(tctx,
+			       dsdb_attribute_by_attributeID_id(
+				       schema, a->attributeID_id) == a,
+			       a->attributeID_oid);
+		if (a->msDS_IntId != 0) {
+			torture_assert(tctx,
+				       dsdb_attribute_by_attributeID_id(
+					       schema, a->msDS_IntId) == a,
+				       a->lDAPDisplayName);
+		}
+
+		/* the name with a suffix is another name */
+		torture_assert(tctx,
+			       dsdb_attribute_by_lDAPDisplayName(
+				       schema, padded) == NULL,
+			       padded);
+
+		talloc_free(upper);
+		talloc_free(padded);
+	}
+
+	for (c = schema->classes; c != NULL; c = c->next) {
+		char *upper = strupper_talloc(tctx, c->lDAPDisplayName);
+		struct ldb_val val = data_blob_string_const(c->lDAPDisplayName);
+
+		torture_assert(tctx, upper != NULL, "No memory");
+
+		torture_assert(tctx,
+			       dsdb_class_by_lDAPDisplayName(
+				       schema, c->lDAPDisplayName) == c,
+			       c->lDAPDisplayName);
+		torture_assert(tctx,
+			       dsdb_class_by_lDAPDisplayName(
+				       schema, upper) == c,
+			       upper);
+		torture_assert(tctx,
+			       dsdb_class_by_lDAPDisplayName_ldb_val(
+				       schema, &val) == c,
+			       c->lDAPDisplayName);
+
+		talloc_free(upper);
+	}
+
+	torture_assert(tctx,
+		       dsdb_attribute_by_lDAPDisplayName(schema, "") == NULL,
+		       "empty name found");
+	torture_assert(tctx,
+		       dsdb_attribute_by_lDAPDisplayName(
+			       schema, "noSuchAttribute") == NULL,
+		       "noSuchAttribute found");
+	torture_assert(tctx,
+		       dsdb_class_by_lDAPDisplayName(
+			       schema, "noSuchClass") == NULL,
+		       "noSuchClass found");
+	torture_assert(tctx,
+		       dsdb_attribute_by_attributeID_id(
+			       schema, 0xFFFFFFFF) == NULL,
+		       "0xFFFFFFFF found");
+
+	return true;
+}
+
+static int uint32_cmp(uint32_t c1, uint32_t c2)
+{
+	if (c1 == c2) return 0;
+	return c1 > c2 ? 1 : -1;
+}
+
+/*
+ * The lookups every module makes for every attribute of every object,
+ * compared with the binary search of the sorted arrays they used
+ * before.  This is in its own suite, planned by selftest/perf_tests.py
+ * rather than with the other local tests.
+ */
+static bool torture_dsdb_schema_lookup_speed(struct torture_context *tctx,
+					     struct torture_dsdb_schema_query *priv)
+{
+	const struct dsdb_schema *schema = priv->schema;
+	int timelimit = torture_setting_int(tctx, "timelimit", 3);
+	const struct dsdb_attribute *a;
+	struct timeval tv;
+	unsigned int count;
+	double hash_rate;
+	double bsearch_rate;
+
+	tv = timeval_current();
+	count = 0;
+	while (timeval_elapsed(&tv) < timelimit) {
+		for (a = schema->attributes; a != NULL; a = a->next) {
+			const struct dsdb_attribute *found;
+
+			found = dsdb_attribute_by_lDAPDisplayName(
+				schema, a->lDAPDisplayName);
+			torture_assert(tctx, found == a, a->lDAPDisplayName);
+			found = dsdb_attribute_by_attributeID_id(
+				schema, a->attributeID_id);
+			torture_assert(tctx, found == a, a->attributeID_oid);
+			count += 2;
+		}
+	}
+	hash_rate = count / timeval_elapsed(&tv);
+
+	tv = timeval_current();
+	count = 0;
+	while (timeval_elapsed(&tv) < timelimit) {
+		for (a = schema->attributes; a != NULL; a = a->next) {
+			struct dsdb_attribute *found;
+
+			BINARY_ARRAY_SEARCH_P(
+				schema->attributes_by_lDAPDisplayName,
+				schema->num_attributes, lDAPDisplayName,
+				a->lDAPDisplayName, strcasecmp, found);
+			torture_assert(tctx, found == a, a->lDAPDisplayName);
+			BINARY_ARRAY_SEARCH_P(
+				schema->attributes_by_attributeID_id,
+				schema->num_attributes, attributeID_id,
+				a->attributeID_id, uint32_cmp, found);
+			torture_assert(tctx, found == a, a->attributeID_oid);
+			count += 2;
+		}
+	}
+	bsearch_rate = count / timeval_elapsed(&tv);
+
+	torture_comment(tctx,
+			"%u attributes: %.0f lookups/sec hashed, "
+			"%.0f lookups/sec by binary search\n",
+			schema->num_attributes, hash_rate, bsearch_rate);
+
+	return true;
+}
+
+/*
+ * DSDB-SCHEMA fixture setup/teardown handlers implementation
+ */
+static bool torture_dsdb_schema_query_tcase_setup(struct torture_context *tctx,
+						  void **data)
+{
+	struct torture_dsdb_schema_query *priv;
+
+	priv = talloc_zero(tctx, struct torture_dsdb_schema_query);
+	torture_assert(tctx, priv, "No memory");
+
+	priv->ldb = provision_get_schema(priv, tctx->lp_ctx, NULL, NULL);
+	torture_assert(tctx, priv->ldb, "Failed to load schema from disk");
+
+	priv->schema = dsdb_get_schema(priv->ldb, NULL);
+	torture_assert(tctx, priv->schema, "Failed to fetch schema");
+
+	*data = priv;
+	return true;
+}
+
+static bool torture_dsdb_schema_query_tcase_teardown(struct torture_context *tctx,
+						     void *data)
+{
+	struct torture_dsdb_schema_query *priv;
+
+	priv = talloc_get_type_abort(data, struct torture_dsdb_schema_query);
+	talloc_free(priv);
+
+	return true;
+}
+
+/**
+ * DSDB-SCHEMA test suite creation
+ */
+struct torture_suite *torture_dsdb_schema_query(TALLOC_CTX *mem_ctx)
+{
+	typedef bool (*pfn_run)(struct torture_context *, void *);
+
+	struct torture_tcase *tc;
+	struct torture_suite *suite = torture_suite_create(mem_ctx, "dsdb.schema");
+
+	if (suite == NULL) {
+		return NULL;
+	}
+
+	tc = torture_suite_add_tcase(suite, "query");
+	if (!tc) {
+		return NULL;
+	}
+
+	torture_tcase_set_fixture(tc,
+				  torture_dsdb_schema_query_tcase_setup,
+				  torture_dsdb_schema_query_tcase_teardown);
+
+	torture_tcase_add_simple_test(tc, "lookups", (pfn_run)torture_dsdb_schema_lookups);
+
+	suite->description = talloc_strdup(suite, "DSDB schema lookup tests");
+
+	return suite;
+}
+
+/**
+ * DSDB-SCHEMA lookup speed suite creation
+ */
+struct torture_suite *torture_dsdb_schema_speed(TALLOC_CTX *mem_ctx)
+{
+	typedef bool (*pfn_run)(struct torture_context *, void *);
+
+	struct torture_tcase *tc;
+	struct torture_suite *suite = torture_suite_create(mem_ctx, "dsdb.schema.speed");
+
+	if (suite == NULL) {
+		return NULL;
+	}
+
+	tc = torture_suite_add_tcase(suite, "query");
+	if (!tc) {
+		return NULL;
+	}
+
+	torture_tcase_set_fixture(tc,
+				  torture_dsdb_schema_query_tcase_setup,
+				  torture_dsdb_schema_query_tcase_teardown);
+
+	torture_tcase_add_simple_test(tc, "lookup-speed", (pfn_run)torture_dsdb_schema_lookup_speed);
+
+	suite->description = talloc_strdup(suite, "DSDB schema lookup speed");
+
+	return suite;
+}
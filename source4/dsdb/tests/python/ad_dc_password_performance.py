@@ -0,0 +1,129 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""Password sets per second over LDAP
+
+Each password set has the password_hash module derive the Kerberos
+keys, the WDigest hashes and any "password hash userPassword schemes"
+of the new password.  Run it against a DC with "password hash:threads"
+set to 1 and to the number of CPUs to see what the parallel derivation
+of those gains.
+"""
+
+from __future__ import print_function
+import optparse
+import sys
+import time
+sys.path.insert(0, "bin/python")
+
+import samba.getopt as options
+import samba.tests
+from samba.tests.subunitrun import SubunitOptions, TestProgram
+from samba.auth import system_session
+from samba.samdb import SamDB
+from ldb import Message, MessageElement, FLAG_MOD_REPLACE
+
+parser = optparse.OptionParser(
+    "ad_dc_password_performance.py <host> [options]")
+sambaopts = options.SambaOptions(parser)
+parser.add_option_group(sambaopts)
+
+parser.add_option("--sets", type="int", dest="sets", default=200,
+                  help="Number of passwords set by each test")
+
+# use command line creds if available
+credopts = options.CredentialsOptions(parser)
+parser.add_option_group(credopts)
+subunitopts = SubunitOptions(parser)
+parser.add_option_group(subunitopts)
+
+opts, args = parser.parse_args()
+
+if len(args) < 1:
+    parser.print_usage()
+    sys.exit(1)
+
+host = args[0]
+
+lp = sambaopts.get_loadparm()
+creds = credopts.get_credentials(lp)
+
+PERF_USER = "pwperfuser"
+PERF_PASSWORD = "P@ssw0rd.pwperf%d"
+
+
+class PasswordPerformanceTests(samba.tests.TestCase):
+
+    def setUp(self):
+        super(PasswordPerformanceTests, self).setUp()
+        if "://" not in host:
+            url = "ldap://%s" % host
+        else:
+            url = host
+        self.ldb = SamDB(url,
+                         credentials=creds,
+                         session_info=system_session(lp),
+                         lp=lp)
+        self.base_dn = self.ldb.domain_dn()
+        self.users = []
+
+    def tearDown(self):
+        for name in self.users:
+            self.ldb.deleteuser(name)
+        super(PasswordPerformanceTests, self).tearDown()
+
+    def set_password(self, dn, password):
+        """A password reset, as done by an administrator"""
+        m = Message()
+        m.dn = dn
+        unicodePwd = ('"%s"' % password).encode('utf-16-le')
+        m["unicodePwd"] = MessageElement(unicodePwd,
+                                         FLAG_MOD_REPLACE,
+                                         "unicodePwd")
+        self.ldb.modify(m)
+
+    def report(self, what, count, elapsed):
+        print("%d %s in %.2fs: %.1f per second" %
+              (count, what, elapsed, count / elapsed),
+              file=sys.stderr)
+
+    def test_password_resets(self):
+        self.ldb.newuser(PERF_USER, PERF_PASSWORD % 0)
+        self.users.append(PERF_USER)
+        dn = self.ldb.search(base=self.base_dn,
+                             expression="(sAMAccountName=%s)" % PERF_USER,
+                             attrs=[])[0].dn
+
+        start = time.time()
+        for i in range(opts.sets):
+            self.set_password(dn, PERF_PASSWORD % (i + 1))
+        elapsed = time.time() - start
+
+        self.report("password resets", opts.sets, elapsed)
+
+    def test_user_adds_with_password(self):
+        start = time.time()
+        for i in range(opts.sets):
+            name = "%s%d" % (PERF_USER, i)
+            self.ldb.newuser(name, PERF_PASSWORD % i)
+            self.users.append(name)
+        elapsed = time.time() - start
+
+        self.report("user adds with a password", opts.sets, elapsed)
+
+
+TestProgram(module=__name__, opts=subunitopts)
@@ -35,6 +35,8 @@ except ImportError:
 
 from samba.samdb import SamDB
 from samba.auth import system_session
+from samba.dcerpc import drsuapi, misc
+from samba.drs_utils import drsuapi_connect
 from ldb import Message, MessageElement, Dn, LdbError
 from ldb import FLAG_MOD_ADD, FLAG_MOD_REPLACE, FLAG_MOD_DELETE
 from ldb import SCOPE_BASE, SCOPE_SUBTREE, SCOPE_ONELEVEL
@@ -73,6 +75,11 @@ class PerfTestException(Exception):
 BATCH_SIZE = 1000
 N_GROUPS = 5
 
+# a normal user, for whom the acl_read module checks access to every
+# attribute of every object returned
+SEARCH_USER = "perfsearchuser"
+SEARCH_USER_PASS = "samba123@AAA"
+
 
 class GlobalState(object):
     next_user_id = 0
@@ -81,6 +88,8 @@ class GlobalState(object):
     next_relinked_user = 0
     next_linked_user_3 = 0
     next_removed_link_0 = 0
+    user_ldb = None
+    drs = None
 
 
 class UserTests(samba.tests.TestCase):
@@ -227,6 +236,126 @@ class UserTests(samba.tests.TestCase):
                                           time.time() - t),
                   file=sys.stderr)
 
+    def _get_user_ldb(self):
+        if self.state.user_ldb is None:
+            try:
+                self.ldb.newuser(SEARCH_USER, SEARCH_USER_PASS)
+            except LdbError:
+                pass
+            user_creds = self.insta_creds(template=creds,
+                                          username=SEARCH_USER,
+                                          userpass=SEARCH_USER_PASS)
+            self.state.user_ldb = SamDB(host, credentials=user_creds,
+                                        lp=lp)
+        return self.state.user_ldb
+
+    def _test_user_search(self, rounds=10):
+        # Searches returning every user as a normal user, which are
+        # dominated by the access checks in the acl_read module
+        user_ldb = self._get_user_ldb()
+        attr_lists = [['cn'],
+                      ['cn', 'sAMAccountName', 'objectSid', 'whenChanged',
+                       'userAccountControl', 'description', 'memberOf'],
+                      ['*']]
+        for attrs in attr_lists:
+            t = time.time()
+            for i in range(rounds):
+                res = user_ldb.search(self.ou_users,
+                                      expression='(objectClass=user)',
+                                      scope=SCOPE_SUBTREE,
+                                      attrs=attrs)
+            print('%d runs returning %d users with %s took %s' %
+                  (rounds, len(res), ','.join(attrs), time.time() - t),
+                  file=sys.stderr)
+
+    def _test_module_stack_search(self, rounds=5):
+        # Searches returning every user as system, which pay the cost
+        # of the dsdb modules for every entry.  Run against a tdb://
+        # URL this leaves the LDAP server out.
+        for attrs in (['cn'], ['*']):
+            t = time.time()
+            for i in range(rounds):
+                res = self.ldb.search(self.ou_users,
+                                      expression='(objectClass=user)',
+                                      scope=SCOPE_SUBTREE,
+                                      attrs=attrs)
+            t = time.time() - t
+            print('%d runs returning %d users with %s took %s, '
+                  '%.1fus per entry' %
+                  (rounds, len(res), ','.join(attrs), t,
+                   t * 1e6 / (rounds * max(len(res), 1))),
+                  file=sys.stderr)
+
+    def _getncchanges_cycle(self, usn):
+        # one replication cycle of the domain NC, from the given USN,
+        # as a DC that has seen nothing newer would ask for it
+        drs, drs_handle = self.state.drs
+        req = drsuapi.DsGetNCChangesRequest8()
+        req.destination_dsa_guid = misc.GUID(
+            "9c637462-5b8c-4467-aef2-bdb1f57bc4ef")
+        req.source_dsa_invocation_id = misc.GUID(
+            self.ldb.get_invocation_id())
+        req.naming_context = drsuapi.DsReplicaObjectIdentifier()
+        req.naming_context.dn = self.base_dn
+        req.highwatermark = drsuapi.DsReplicaHighWaterMark()
+        req.highwatermark.tmp_highest_usn = usn
+        req.highwatermark.reserved_usn = 0
+        req.highwatermark.highest_usn = usn
+        req.uptodateness_vector = None
+        req.replica_flags = (drsuapi.DRSUAPI_DRS_INIT_SYNC |
+                             drsuapi.DRSUAPI_DRS_PER_SYNC |
+                             drsuapi.DRSUAPI_DRS_WRIT_REP)
+        req.max_object_count = 402
+        req.max_ndr_size = 402116
+        req.extended_op = drsuapi.DRSUAPI_EXOP_NONE
+        req.fsmo_info = 0
+        req.partial_attribute_set = None
+        req.partial_attribute_set_ex = None
+        req.mapping_ctr.num_mappings = 0
+        req.mapping_ctr.mappings = None
+
+        n = 0
+        while True:
+            (level, ctr) = drs.DsGetNCChanges(drs_handle, 8, req)
+            n += ctr.object_count
+            if not ctr.more_data:
+                return n
+            req.highwatermark = ctr.new_highwatermark
+
+    def _test_getncchanges(self, n_changes=10, rounds=10):
+        # A full replication of the domain NC, then incremental cycles
+        # after a few changes, which should cost about the same
+        # however many users there are
+        if not host.startswith("ldap://"):
+            self.skipTest("DRS needs a server")
+        if self.state.drs is None:
+            drs, drs_handle, ext = drsuapi_connect(host[len("ldap://"):],
+                                                   lp, creds)
+            self.state.drs = (drs, drs_handle)
+
+        t = time.time()
+        n = self._getncchanges_cycle(0)
+        print('full replication of %d objects took %s' %
+              (n, time.time() - t), file=sys.stderr)
+
+        res = self.ldb.search(base="", scope=SCOPE_BASE,
+                              attrs=["highestCommittedUSN"])
+        usn = int(res[0]["highestCommittedUSN"][0])
+        for i in range(n_changes):
+            m = Message()
+            m.dn = Dn(self.ldb, "cn=u%d,%s" % (i, self.ou_users))
+            m["description"] = MessageElement("changed at %s" % time.time(),
+                                              FLAG_MOD_REPLACE,
+                                              "description")
+            self.ldb.modify(m)
+
+        t = time.time()
+        for i in range(rounds):
+            n = self._getncchanges_cycle(usn)
+        print('%d incremental replications of %d objects took %s' %
+              (rounds, n, time.time() - t), file=sys.stderr)
+        self.assertGreaterEqual(n, n_changes)
+
     def _test_add_many_users(self, n=BATCH_SIZE):
         s = self.state.next_user_id
         e = s + n
@@ -264,6 +393,9 @@ class UserTests(samba.tests.TestCase):
     test_00_11_unindexed_search_1k_users = _test_unindexed_search
     test_00_12_indexed_search_1k_users = _test_indexed_search
     test_00_13_member_search_1k_users = _test_member_search
+    test_00_14_user_search_1k_users = _test_user_search
+    test_00_15_getncchanges_1k_users = _test_getncchanges
+    test_00_16_module_stack_search_1k_users = _test_module_stack_search
 
     test_01_02_adding_users_2000_ldif = _test_add_many_users_ldif
     test_01_03_adding_users_3000 = _test_add_many_users
@@ -274,6 +406,12 @@ class UserTests(samba.tests.TestCase):
     def test_01_13_member_search_3k_users(self):
         self._test_member_search(rounds=5)
 
+    def test_01_14_user_search_3k_users(self):
+        self._test_user_search(rounds=5)
+
+    test_01_15_getncchanges_3k_users = _test_getncchanges
+    test_01_16_module_stack_search_3k_users = _test_module_stack_search
+
     test_02_01_link_users_1000 = _test_link_many_users
     test_02_02_link_users_2000 = _test_link_many_users
     test_02_03_link_users_3000 = _test_link_many_users
@@ -284,6 +422,8 @@ class UserTests(samba.tests.TestCase):
     def test_03_13_member_search_linked_users(self):
         self._test_member_search(rounds=2)
 
+    test_03_15_getncchanges_linked_users = _test_getncchanges
+
 if "://" not in host:
     if os.path.isfile(host):
         host = "tdb://%s" % host
@@ -3264,6 +3264,57 @@ class BaseDnTests(samba.tests.TestCase):
         expected = "%s:%s$@%s" % (dns_domainname.lower(), hostname.lower(), dns_domainname.upper())
         self.assertEquals(given, expected)
 
+    def set_module_timing(self, value):
+        m = Message()
+        m.dn = Dn(self.ldb, "")
+        m["moduleTiming"] = MessageElement(value, FLAG_MOD_REPLACE,
+                                           "moduleTiming")
+        self.ldb.modify(m)
+
+    def get_module_timing(self):
+        res = self.ldb.search("", scope=SCOPE_BASE, attrs=["moduleTiming"])
+        self.assertEquals(len(res), 1)
+        timing = {}
+        for v in res[0].get("moduleTiming", []):
+            (module, op, calls, usec) = v.split(" ")
+            timing[(module, op)] = (int(calls), int(usec))
+        return timing
+
+    def test_moduleTiming(self):
+        """Testing the module timing in rootDSE"""
+        res = self.ldb.search("", scope=SCOPE_BASE, attrs=["*"])
+        self.assertEquals(len(res), 1)
+        self.assertFalse("moduleTiming" in res[0])
+
+        self.set_module_timing("enable")
+        self.addCleanup(self.set_module_timing, "disable")
+        self.set_module_timing("reset")
+
+        for i in range(10):
+            self.ldb.search(self.ldb.domain_dn(), scope=SCOPE_SUBTREE,
+                            expression="(objectClass=user)", attrs=["cn"])
+
+        timing = self.get_module_timing()
+        self.assertTrue(timing[("rootdse", "search")][0] >= 10)
+        self.assertTrue(timing[("partition", "search")][0] >= 10)
+
+        # the counters stop while disabled
+        self.set_module_timing("disable")
+        self.ldb.search(self.ldb.domain_dn(), scope=SCOPE_SUBTREE,
+                        expression="(objectClass=user)", attrs=["cn"])
+        self.assertEquals(self.get_module_timing()[("rootdse", "search")][0],
+                          timing[("rootdse", "search")][0])
+
+        self.set_module_timing("reset")
+        self.assertEquals(self.get_module_timing(), {})
+
+        try:
+            self.set_module_timing("sometimes")
+            self.fail()
+        except LdbError as e:
+            (num, _) = e.args
+            self.assertEquals(num, ERR_UNWILLING_TO_PERFORM)
+
 if not "://" in host:
     if os.path.isfile(host):
         host = "tdb://%s" % host
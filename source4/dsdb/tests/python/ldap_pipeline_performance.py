@@ -0,0 +1,242 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""Searches per second over one LDAP connection, with up to --window
+requests sent before the replies to them are read.
+
+The requests are encoded by hand, as the client libraries wait for the
+reply to each request before they send the next one.  The searches are
+anonymous searches of the rootDSE, so the server does little more per
+request than read, decode and answer it.
+"""
+
+from __future__ import print_function
+import optparse
+import socket
+import struct
+import sys
+import time
+sys.path.insert(0, "bin/python")
+
+import samba.getopt as options
+import samba.tests
+from samba.tests.subunitrun import SubunitOptions, TestProgram
+
+parser = optparse.OptionParser(
+    "ldap_pipeline_performance.py <host> [options]")
+sambaopts = options.SambaOptions(parser)
+parser.add_option_group(sambaopts)
+
+parser.add_option("--searches", type="int", dest="searches", default=10000,
+                  help="Number of searches sent by each test")
+parser.add_option("--window", type="int", dest="window", default=32,
+                  help="Number of searches in flight in the pipelined tests")
+
+subunitopts = SubunitOptions(parser)
+parser.add_option_group(subunitopts)
+
+opts, args = parser.parse_args()
+
+if len(args) < 1:
+    parser.print_usage()
+    sys.exit(1)
+
+host = args[0]
+
+LDAP_BIND_REQUEST = 0x60
+LDAP_BIND_RESPONSE = 0x61
+LDAP_SEARCH_REQUEST = 0x63
+LDAP_SEARCH_ENTRY = 0x64
+LDAP_SEARCH_DONE = 0x65
+LDAP_ABANDON_REQUEST = 0x50
+
+
+def ber_length(length):
+    if length < 0x80:
+        return struct.pack("B", length)
+    return struct.pack("!BI", 0x84, length)
+
+
+def ber(tag, value):
+    return struct.pack("B", tag) + ber_length(len(value)) + value
+
+
+def ber_int(tag, value):
+    return ber(tag, struct.pack("!i", value))
+
+
+def ldap_message(msgid, op):
+    return ber(0x30, ber_int(0x02, msgid) + op)
+
+
+def search_request(msgid):
+    attrs = b"".join(ber(0x04, a) for a in (b"dnsHostName",
+                                             b"defaultNamingContext"))
+    return ldap_message(msgid,
+                        ber(LDAP_SEARCH_REQUEST,
+                            ber(0x04, b"") +           # base
+                            ber_int(0x0a, 0) +         # scope base
+                            ber_int(0x0a, 0) +         # never deref
+                            ber_int(0x02, 0) +         # size limit
+                            ber_int(0x02, 0) +         # time limit
+                            ber(0x01, b"\x00") +       # types only
+                            ber(0x87, b"objectClass") +  # present
+                            ber(0x30, attrs)))
+
+
+def anonymous_bind_request(msgid):
+    return ldap_message(msgid,
+                        ber(LDAP_BIND_REQUEST,
+                            ber_int(0x02, 3) +
+                            ber(0x04, b"") +
+                            ber(0x80, b"")))
+
+
+def abandon_request(msgid, abandoned):
+    return ldap_message(msgid,
+                        ber_int(LDAP_ABANDON_REQUEST, abandoned))
+
+
+class LDAPReader(object):
+    """Splits the replies read from a socket into (msgid, tag) pairs"""
+
+    def __init__(self, s):
+        self.s = s
+        self.buf = b""
+
+    def fill(self, size):
+        while len(self.buf) < size:
+            data = self.s.recv(65536)
+            if len(data) == 0:
+                raise EOFError("connection closed by the server")
+            self.buf += data
+
+    def next_reply(self):
+        self.fill(2)
+        length = struct.unpack("B", self.buf[1:2])[0]
+        offset = 2
+        if length & 0x80:
+            n = length & 0x7f
+            self.fill(offset + n)
+            length = 0
+            for c in struct.unpack("%dB" % n, self.buf[offset:offset + n]):
+                length = (length << 8) | c
+            offset += n
+        self.fill(offset + length)
+        pdu = self.buf[offset:offset + length]
+        self.buf = self.buf[offset + length:]
+
+        # INTEGER messageID, then the tag of the protocolOp
+        n = struct.unpack("B", pdu[1:2])[0]
+        msgid = 0
+        for c in struct.unpack("%dB" % n, pdu[2:2 + n]):
+            msgid = (msgid << 8) | c
+        tag = struct.unpack("B", pdu[2 + n:3 + n])[0]
+        return (msgid, tag)
+
+
+class LDAPPipelineTests(samba.tests.TestCase):
+
+    def setUp(self):
+        super(LDAPPipelineTests, self).setUp()
+        self.s = socket.create_connection((host, 389))
+        self.s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.s.settimeout(30)
+        self.reader = LDAPReader(self.s)
+
+    def tearDown(self):
+        self.s.close()
+        super(LDAPPipelineTests, self).tearDown()
+
+    def wait_for(self, msgid, tag):
+        """Read replies until the one ending msgid, asserting that no
+        other request is answered first."""
+        while True:
+            (reply_msgid, reply_tag) = self.reader.next_reply()
+            self.assertEqual(reply_msgid, msgid)
+            if reply_tag == tag:
+                return
+            self.assertEqual(reply_tag, LDAP_SEARCH_ENTRY)
+
+    def run_searches(self, window):
+        """Send opts.searches searches over one connection, keeping up
+        to window of them in flight, and print the rate."""
+        sent = 0
+        done = 0
+        start = time.time()
+        while done < opts.searches:
+            pdus = []
+            while sent < opts.searches and sent - done < window:
+                sent += 1
+                pdus.append(search_request(sent))
+            if pdus:
+                self.s.sendall(b"".join(pdus))
+            (msgid, tag) = self.reader.next_reply()
+            self.assertTrue(0 < msgid <= sent)
+            if tag == LDAP_SEARCH_DONE:
+                done += 1
+            else:
+                self.assertEqual(tag, LDAP_SEARCH_ENTRY)
+        elapsed = time.time() - start
+
+        print("%d searches with %d in flight in %.2fs: %d searches/s" %
+              (opts.searches, window, elapsed, opts.searches / elapsed),
+              file=sys.stderr)
+
+    def test_searches_unpipelined(self):
+        self.run_searches(1)
+
+    def test_searches_pipelined(self):
+        self.run_searches(opts.window)
+
+    def test_bind_waits_for_earlier_requests(self):
+        """A bind sent behind searches is answered after all of them,
+        and the searches behind it after the bind."""
+        pdus = [search_request(i) for i in range(1, 11)]
+        pdus.append(anonymous_bind_request(11))
+        pdus += [search_request(i) for i in range(12, 22)]
+        self.s.sendall(b"".join(pdus))
+
+        done = set()
+        while len(done) < 21:
+            (msgid, tag) = self.reader.next_reply()
+            if msgid == 11:
+                self.assertEqual(tag, LDAP_BIND_RESPONSE)
+                self.assertEqual(done, set(range(1, 11)))
+            elif tag == LDAP_SEARCH_DONE:
+                if msgid > 11:
+                    self.assertIn(11, done)
+            else:
+                self.assertEqual(tag, LDAP_SEARCH_ENTRY)
+                continue
+            done.add(msgid)
+
+    def test_abandon_is_not_answered(self):
+        """An abandon, even of a request that is not known, gets no
+        reply, and the requests around it are still answered."""
+        self.s.sendall(search_request(1) +
+                       abandon_request(2, 1) +
+                       abandon_request(3, 1000) +
+                       search_request(4))
+        self.wait_for(1, LDAP_SEARCH_DONE)
+        self.wait_for(4, LDAP_SEARCH_DONE)
+
+
+if "://" in host:
+    host = host.split("://", 1)[1]
+
+TestProgram(module=__name__, opts=subunitopts)
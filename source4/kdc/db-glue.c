@@ -37,6 +37,8 @@
 #include "kdc/db-glue.h"
 #include "librpc/gen_ndr/ndr_irpc_c.h"
 #include "lib/messaging/irpc.h"
+#include "lib/util/dlinklist.h"
+#include "lib/util/memcache.h"
 
 
 #define SAMBA_KVNO_GET_KRBTGT(kvno) \
@@ -2317,6 +2319,295 @@ static krb5_error_code samba_kdc_lookup_realm(krb5_context context,
 	return SDB_ERR_WRONG_REALM;
 }
 
+/*
+ * The entries found by samba_kdc_fetch() are kept in a small
+ * per-process cache, so that the krbtgt account and busy service
+ * principals are not searched for, and their keys decrypted and
+ * parsed, for every AS-REQ and TGS-REQ.
+ *
+ * Entries are keyed on the principal as asked for, the fetch flags and
+ * the kvno, as all of them shape the entry.  The whole cache is
+ * flushed when the sequence number of the sam.ldb moves on, so a
+ * password change, whether made through our kpasswd service, over
+ * LDAP or by replication, is seen by the next request.  Entries also
+ * expire after "kdc:entry cache lifetime" seconds, to pick up values
+ * that are computed from the time of the search.
+ *
+ * The client of an AS-REQ is never cached: it is checked for lockout
+ * against its bad password count, and is usually only asked for once.
+ * Nor is any entry that is locked out.
+ */
+struct samba_kdc_cache_entry {
+	struct samba_kdc_cache_entry *prev, *next;
+	struct samba_kdc_cache_entry *hash_next;
+	unsigned int hash;
+	const char *key;
+	time_t expires;
+	struct sdb_entry_ex entry_ex;
+};
+
+struct samba_kdc_entry_cache {
+	/* most recently used first */
+	struct samba_kdc_cache_entry *lru;
+	struct samba_kdc_cache_entry **buckets;
+	unsigned int num_buckets;
+	unsigned int num_entries;
+	unsigned int max_entries;
+	time_t lifetime;
+	uint64_t seq_num;
+};
+
+static int samba_kdc_cache_init(struct samba_kdc_db_context *kdc_db_ctx)
+{
+	struct samba_kdc_entry_cache *cache = NULL;
+	int max_entries;
+
+	max_entries = lpcfg_parm_int(kdc_db_ctx->lp_ctx, NULL,
+				     "kdc", "entry cache size", 1000);
+	if (max_entries <= 0) {
+		return 0;
+	}
+
+	cache = talloc_zero(kdc_db_ctx, struct samba_kdc_entry_cache);
+	if (cache == NULL) {
+		return ENOMEM;
+	}
+	cache->max_entries = max_entries;
+	cache->num_buckets = max_entries;
+	cache->buckets = talloc_zero_array(cache,
+					   struct samba_kdc_cache_entry *,
+					   cache->num_buckets);
+	if (cache->buckets == NULL) {
+		talloc_free(cache);
+		return ENOMEM;
+	}
+	cache->lifetime = lpcfg_parm_int(kdc_db_ctx->lp_ctx, NULL,
+					 "kdc", "entry cache lifetime", 60);
+
+	kdc_db_ctx->entry_cache = cache;
+	return 0;
+}
+
+static int samba_kdc_cache_entry_destructor(struct samba_kdc_cache_entry *e)
+{
+	sdb_free_entry(&e->entry_ex);
+	return 0;
+}
+
+static void samba_kdc_cache_remove(struct samba_kdc_entry_cache *cache,
+				   struct samba_kdc_cache_entry *e)
+{
+	struct samba_kdc_cache_entry **pp =
+		&cache->buckets[e->hash % cache->num_buckets];
+
+	while (*pp != e) {
+		pp = &(*pp)->hash_next;
+	}
+	*pp = e->hash_next;
+
+	DLIST_REMOVE(cache->lru, e);
+	cache->num_entries--;
+	talloc_free(e);
+}
+
+static void samba_kdc_cache_flush(struct samba_kdc_entry_cache *cache)
+{
+	while (cache->lru != NULL) {
+		samba_kdc_cache_remove(cache, cache->lru);
+	}
+}
+
+static unsigned int samba_kdc_cache_hash(const char *key)
+{
+	unsigned int hash = 5381;
+
+	for (; *key != '\0'; key++) {
+		hash = hash * 33 + (unsigned char)*key;
+	}
+	return hash;
+}
+
+/*
+ * Return the cache key for a fetch, or NULL if the result is not to be
+ * cached.  This also flushes the cache if the database has changed.
+ */
+static const char *samba_kdc_cache_key(krb5_context context,
+				       struct samba_kdc_db_context *kdc_db_ctx,
+				       TALLOC_CTX *mem_ctx,
+				       krb5_const_principal principal,
+				       unsigned flags,
+				       krb5_kvno kvno)
+{
+	struct samba_kdc_entry_cache *cache = kdc_db_ctx->entry_cache;
+	char *principal_string = NULL;
+	const char *key = NULL;
+	uint64_t seq_num;
+	krb5_error_code ret;
+	int ldb_ret;
+
+	if (cache == NULL || principal == NULL) {
+		return NULL;
+	}
+	if ((flags & SDB_F_GET_CLIENT) && (flags & SDB_F_FOR_AS_REQ)) {
+		return NULL;
+	}
+
+	ldb_ret = ldb_sequence_number(kdc_db_ctx->samdb,
+				      LDB_SEQ_HIGHEST_SEQ, &seq_num);
+	if (ldb_ret != LDB_SUCCESS) {
+		samba_kdc_cache_flush(cache);
+		return NULL;
+	}
+	if (seq_num != cache->seq_num) {
+		samba_kdc_cache_flush(cache);
+		cache->seq_num = seq_num;
+	}
+
+	ret = krb5_unparse_name(context, principal, &principal_string);
+	if (ret != 0) {
+		return NULL;
+	}
+
+	key = talloc_asprintf(mem_ctx, "%x:%u:%d:%s",
+			      flags, (unsigned int)kvno,
+			      smb_krb5_principal_get_type(context, principal),
+			      principal_string);
+	SAFE_FREE(principal_string);
+	return key;
+}
+
+/*
+ * Copy an entry, and the samba_kdc_entry that goes with it, from or
+ * to the cache.
+ */
+static krb5_error_code samba_kdc_entry_copy(krb5_context context,
+					    TALLOC_CTX *mem_ctx,
+					    const struct sdb_entry_ex *from,
+					    struct sdb_entry_ex *to)
+{
+	const struct samba_kdc_entry *src =
+		talloc_get_type_abort(from->ctx, struct samba_kdc_entry);
+	struct samba_kdc_entry *p = NULL;
+	krb5_error_code ret;
+
+	p = talloc_zero(mem_ctx, struct samba_kdc_entry);
+	if (p == NULL) {
+		return ENOMEM;
+	}
+	p->kdc_db_ctx = src->kdc_db_ctx;
+	p->is_krbtgt = src->is_krbtgt;
+	p->is_rodc = src->is_rodc;
+	p->is_trust = src->is_trust;
+
+	if (src->realm_dn != NULL) {
+		p->realm_dn = ldb_dn_copy(p, src->realm_dn);
+		if (p->realm_dn == NULL) {
+			talloc_free(p);
+			return ENOMEM;
+		}
+	}
+	if (src->msg != NULL) {
+		p->msg = ldb_msg_copy(p, src->msg);
+		if (p->msg == NULL) {
+			talloc_free(p);
+			return ENOMEM;
+		}
+	}
+
+	ZERO_STRUCTP(to);
+	ret = copy_sdb_entry(context, &from->entry, &to->entry);
+	if (ret != 0) {
+		talloc_free(p);
+		return ret;
+	}
+
+	talloc_set_destructor(p, samba_kdc_entry_destructor);
+	to->ctx = p;
+	return 0;
+}
+
+static krb5_error_code samba_kdc_cache_lookup(krb5_context context,
+					      struct samba_kdc_db_context *kdc_db_ctx,
+					      const char *key,
+					      struct sdb_entry_ex *entry_ex)
+{
+	struct samba_kdc_entry_cache *cache = kdc_db_ctx->entry_cache;
+	struct samba_kdc_cache_entry *e = NULL;
+	unsigned int hash = samba_kdc_cache_hash(key);
+	krb5_error_code ret;
+
+	for (e = cache->buckets[hash % cache->num_buckets];
+	     e != NULL;
+	     e = e->hash_next) {
+		if (e->hash == hash && strcmp(e->key, key) == 0) {
+			break;
+		}
+	}
+	if (e == NULL) {
+		return SDB_ERR_NOENTRY;
+	}
+
+	if (e->expires <= time(NULL)) {
+		samba_kdc_cache_remove(cache, e);
+		return SDB_ERR_NOENTRY;
+	}
+
+	ret = samba_kdc_entry_copy(context, kdc_db_ctx, &e->entry_ex,
+				   entry_ex);
+	if (ret != 0) {
+		samba_kdc_cache_remove(cache, e);
+		return ret;
+	}
+
+	DLIST_PROMOTE(cache->lru, e);
+	return 0;
+}
+
+static void samba_kdc_cache_add(krb5_context context,
+				struct samba_kdc_db_context *kdc_db_ctx,
+				const char *key,
+				const struct sdb_entry_ex *entry_ex)
+{
+	struct samba_kdc_entry_cache *cache = kdc_db_ctx->entry_cache;
+	struct samba_kdc_cache_entry *e = NULL;
+	unsigned int bucket;
+	krb5_error_code ret;
+
+	if (entry_ex->ctx == NULL || entry_ex->entry.flags.locked_out) {
+		return;
+	}
+
+	e = talloc_zero(cache, struct samba_kdc_cache_entry);
+	if (e == NULL) {
+		return;
+	}
+	e->key = talloc_strdup(e, key);
+	if (e->key == NULL) {
+		talloc_free(e);
+		return;
+	}
+
+	ret = samba_kdc_entry_copy(context, e, entry_ex, &e->entry_ex);
+	if (ret != 0) {
+		talloc_free(e);
+		return;
+	}
+	talloc_set_destructor(e, samba_kdc_cache_entry_destructor);
+
+	e->hash = samba_kdc_cache_hash(key);
+	e->expires = time(NULL) + cache->lifetime;
+
+	if (cache->num_entries >= cache->max_entries) {
+		samba_kdc_cache_remove(cache, DLIST_TAIL(cache->lru));
+	}
+
+	bucket = e->hash % cache->num_buckets;
+	e->hash_next = cache->buckets[bucket];
+	cache->buckets[bucket] = e;
+	DLIST_ADD(cache->lru, e);
+	cache->num_entries++;
+}
+
 krb5_error_code samba_kdc_fetch(krb5_context context,
 				struct samba_kdc_db_context *kdc_db_ctx,
 				krb5_const_principal principal,
@@ -2326,6 +2617,7 @@ krb5_error_code samba_kdc_fetch(krb5_context context,
 {
 	krb5_error_code ret = SDB_ERR_NOENTRY;
 	TALLOC_CTX *mem_ctx;
+	const char *cache_key = NULL;
 
 	mem_ctx = talloc_named(kdc_db_ctx, 0, "samba_kdc_fetch context");
 	if (!mem_ctx) {
@@ -2340,6 +2632,18 @@ krb5_error_code samba_kdc_fetch(krb5_context context,
 		goto done;
 	}
 
+	cache_key = samba_kdc_cache_key(context, kdc_db_ctx, mem_ctx,
+					principal, flags, kvno);
+	if (cache_key != NULL) {
+		ret = samba_kdc_cache_lookup(context, kdc_db_ctx,
+					     cache_key, entry_ex);
+		if (ret == 0) {
+			/* no need to add it again */
+			cache_key = NULL;
+			goto done;
+		}
+	}
+
 	ret = SDB_ERR_NOENTRY;
 
 	if (flags & SDB_F_GET_CLIENT) {
@@ -2361,6 +2665,9 @@ krb5_error_code samba_kdc_fetch(krb5_context context,
 	}
 
 done:
+	if (ret == 0 && cache_key != NULL) {
+		samba_kdc_cache_add(context, kdc_db_ctx, cache_key, entry_ex);
+	}
 	talloc_free(mem_ctx);
 	return ret;
 }
@@ -2742,6 +3049,7 @@ NTSTATUS samba_kdc_setup_db_ctx(TALLOC_CTX *mem_ctx, struct samba_kdc_base_conte
 				struct samba_kdc_db_context **kdc_db_ctx_out)
 {
 	int ldb_ret;
+	int group_cache_size;
 	struct ldb_message *msg;
 	struct auth_session_info *session_info;
 	struct samba_kdc_db_context *kdc_db_ctx;
@@ -2863,6 +3171,23 @@ NTSTATUS samba_kdc_setup_db_ctx(TALLOC_CTX *mem_ctx, struct samba_kdc_base_conte
 		kdc_db_ctx->my_krbtgt_number = 0;
 		talloc_free(msg);
 	}
+
+	if (samba_kdc_cache_init(kdc_db_ctx) != 0) {
+		talloc_free(kdc_db_ctx);
+		return NT_STATUS_NO_MEMORY;
+	}
+
+	group_cache_size = lpcfg_parm_int(kdc_db_ctx->lp_ctx, NULL, "kdc",
+					  "group cache size", 1024 * 1024);
+	if (group_cache_size > 0) {
+		kdc_db_ctx->group_cache = memcache_init(kdc_db_ctx,
+							group_cache_size);
+		if (kdc_db_ctx->group_cache == NULL) {
+			talloc_free(kdc_db_ctx);
+			return NT_STATUS_NO_MEMORY;
+		}
+	}
+
 	*kdc_db_ctx_out = kdc_db_ctx;
 	return NT_STATUS_OK;
 }
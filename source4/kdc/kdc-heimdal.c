@@ -302,7 +302,7 @@ static void kdc_task_init(struct task_server *task)
 	}
 
 	kdc->task = task;
-
+	task->private_data = kdc;
 
 	/* get a samdb connection */
 	kdc->samdb = samdb_connect(kdc, kdc->task->event_ctx, kdc->task->lp_ctx,
@@ -453,6 +453,24 @@ static void kdc_task_init(struct task_server *task)
 		task_server_terminate(task, "kdc failed to setup monitoring", true);
 		return;
 	}
+}
+
+/*
+ * Called in every process serving the KDC. A pre-forked worker opens its
+ * own SO_REUSEPORT UDP sockets and registers its own irpc name, as it
+ * does not run the event loop of the pre-fork master.
+ */
+static void kdc_post_fork(struct task_server *task, struct process_details *pd)
+{
+	struct kdc_server *kdc = talloc_get_type_abort(task->private_data,
+						       struct kdc_server);
+	NTSTATUS status;
+
+	status = kdc_add_udp_sockets(kdc, pd->instances > 1);
+	if (!NT_STATUS_IS_OK(status)) {
+		task_server_terminate(task, "kdc failed to setup UDP sockets", true);
+		return;
+	}
 
 	irpc_add_name(task->msg_ctx, "kdc_server");
 }
@@ -463,18 +481,15 @@ NTSTATUS server_service_kdc_init(TALLOC_CTX *ctx)
 {
 	struct service_details details = {
 		.inhibit_fork_on_accept = true,
-		/* 
-		 * Need to prevent pre-forking on kdc.
-		 * The task_init function is run on the master process only
-		 * and the irpc process name is registered in it's event loop.
-		 * The child worker processes initialise their event loops on
-		 * fork, so are not listening for the irpc event.
-		 *
-		 * The master process does not wait on that event context
-		 * the master process is responsible for managing the worker
-		 * processes not performing work.
+		/*
+		 * Only pre-fork the kdc if "prefork children:kdc" is set.
+		 * The task_init function is run on the master process only,
+		 * which does not wait on the event context of the task, so
+		 * the irpc name and the UDP sockets are set up in each
+		 * worker process by kdc_post_fork().
 		 */
-		.inhibit_pre_fork = true
+		.inhibit_pre_fork = true,
+		.post_fork = kdc_post_fork,
 	};
 	return register_server_service(ctx, "kdc", kdc_task_init, &details);
 }
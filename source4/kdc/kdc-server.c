@@ -29,6 +29,7 @@
 #include "kdc/kdc-server.h"
 #include "kdc/kdc-proxy.h"
 #include "lib/stream/packet.h"
+#include "lib/util/dlinklist.h"
 
 /*
  * State of an open tcp connection
@@ -540,7 +541,8 @@ static const struct stream_server_ops kdc_tcp_stream_ops = {
 };
 
 /*
- * Start listening on the given address
+ * Start listening on the given address over TCP, unless udp_only is set.
+ * The UDP sockets are opened by kdc_add_udp_sockets().
  */
 NTSTATUS kdc_add_socket(struct kdc_server *kdc,
 			const struct model_ops *model_ops,
@@ -551,8 +553,6 @@ NTSTATUS kdc_add_socket(struct kdc_server *kdc,
 			bool udp_only)
 {
 	struct kdc_socket *kdc_socket;
-	struct kdc_udp_socket *kdc_udp_socket;
-	struct tevent_req *udpsubreq;
 	NTSTATUS status;
 	int ret;
 
@@ -588,19 +588,43 @@ NTSTATUS kdc_add_socket(struct kdc_server *kdc,
 		}
 	}
 
+	DLIST_ADD_END(kdc->sockets, kdc_socket);
+
+	return NT_STATUS_OK;
+}
+
+static NTSTATUS kdc_add_udp_socket(struct kdc_socket *kdc_socket,
+				   bool reuseport)
+{
+	struct kdc_server *kdc = kdc_socket->kdc;
+	struct kdc_udp_socket *kdc_udp_socket;
+	struct tevent_req *udpsubreq;
+	NTSTATUS status;
+	int ret;
+
 	kdc_udp_socket = talloc(kdc_socket, struct kdc_udp_socket);
 	NT_STATUS_HAVE_NO_MEMORY(kdc_udp_socket);
 
 	kdc_udp_socket->kdc_socket = kdc_socket;
 
-	ret = tdgram_inet_udp_socket(kdc_socket->local_address,
-				     NULL,
-				     kdc_udp_socket,
-				     &kdc_udp_socket->dgram);
+	if (reuseport) {
+		ret = tdgram_inet_udp_reuseport_socket(
+			kdc_socket->local_address,
+			kdc_udp_socket,
+			&kdc_udp_socket->dgram);
+	} else {
+		ret = tdgram_inet_udp_socket(kdc_socket->local_address,
+					     NULL,
+					     kdc_udp_socket,
+					     &kdc_udp_socket->dgram);
+	}
 	if (ret != 0) {
 		status = map_nt_error_from_unix_common(errno);
-		DEBUG(0,("Failed to bind to %s:%u UDP - %s\n",
-			 address, port, nt_errstr(status)));
+		DEBUG(0,("Failed to bind to %s UDP - %s\n",
+			 tsocket_address_string(kdc_socket->local_address,
+						kdc_udp_socket),
+			 nt_errstr(status)));
+		talloc_free(kdc_udp_socket);
 		return status;
 	}
 
@@ -616,3 +640,22 @@ NTSTATUS kdc_add_socket(struct kdc_server *kdc,
 
 	return NT_STATUS_OK;
 }
+
+/*
+ * Start listening over UDP on the addresses given to kdc_add_socket(),
+ * sharing the ports with the other worker processes if reuseport is set
+ */
+NTSTATUS kdc_add_udp_sockets(struct kdc_server *kdc, bool reuseport)
+{
+	struct kdc_socket *kdc_socket;
+	NTSTATUS status;
+
+	for (kdc_socket = kdc->sockets;
+	     kdc_socket != NULL;
+	     kdc_socket = kdc_socket->next) {
+		status = kdc_add_udp_socket(kdc_socket, reuseport);
+		NT_STATUS_NOT_OK_RETURN(status);
+	}
+
+	return NT_STATUS_OK;
+}
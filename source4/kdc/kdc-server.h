@@ -29,6 +29,7 @@
 
 struct tsocket_address;
 struct model_ops;
+struct kdc_socket;
 
 /*
  * Context structure for the kdc server
@@ -42,6 +43,8 @@ struct kdc_server {
 	uint32_t proxy_timeout;
 	const char *keytab_name;
 	void *private_data;
+	/* the addresses listened on, see kdc_add_udp_sockets() */
+	struct kdc_socket *sockets;
 };
 
 typedef enum kdc_code_e {
@@ -60,6 +63,7 @@ typedef kdc_code (*kdc_process_fn_t)(struct kdc_server *kdc,
 
 /* Information about one kdc socket */
 struct kdc_socket {
+	struct kdc_socket *next, *prev;
 	struct kdc_server *kdc;
 	struct tsocket_address *local_address;
 	kdc_process_fn_t process;
@@ -79,5 +83,6 @@ NTSTATUS kdc_add_socket(struct kdc_server *kdc,
 			uint16_t port,
 			kdc_process_fn_t process,
 			bool udp_only);
+NTSTATUS kdc_add_udp_sockets(struct kdc_server *kdc, bool reuseport);
 
 #endif /* _KDC_SERVER_H */
@@ -127,6 +127,9 @@ static NTSTATUS startup_kpasswd_server(TALLOC_CTX *mem_ctx,
 	}
 
 out:
+	if (NT_STATUS_IS_OK(status)) {
+		status = kdc_add_udp_sockets(kdc, false);
+	}
 	talloc_free(tmp_ctx);
 	return status;
 }
@@ -35,6 +35,7 @@
 #include "libcli/security/security.h"
 #include "dsdb/samdb/samdb.h"
 #include "auth/kerberos/pac_utils.h"
+#include "lib/util/memcache.h"
 
 static
 NTSTATUS samba_get_logon_info_pac_blob(TALLOC_CTX *mem_ctx,
@@ -633,6 +634,169 @@ int samba_krbtgt_is_in_db(struct samba_kdc_entry *p,
 	return 0;
 }
 
+/*
+ * Expanding the nested group memberships for a PAC takes a search for
+ * each group, so the SIDs found are kept in a per-process cache.  When
+ * a PAC is built from the account it is keyed on the account SID, and
+ * when the groups of a PAC are expanded on a TGS-REQ it is keyed on the
+ * SIDs already in it.
+ *
+ * The cache is flushed when the sequence number of the sam.ldb moves
+ * on, which covers any change to a group membership, whether made here
+ * or by replication.
+ */
+static bool samba_kdc_group_cache_check(struct samba_kdc_db_context *kdc_db_ctx)
+{
+	uint64_t seq_num;
+	int ret;
+
+	if (kdc_db_ctx->group_cache == NULL) {
+		return false;
+	}
+
+	ret = ldb_sequence_number(kdc_db_ctx->samdb, LDB_SEQ_HIGHEST_SEQ,
+				  &seq_num);
+	if (ret != LDB_SUCCESS) {
+		memcache_flush(kdc_db_ctx->group_cache, KDC_GROUP_SIDS_CACHE);
+		return false;
+	}
+	if (seq_num != kdc_db_ctx->group_cache_seq_num) {
+		memcache_flush(kdc_db_ctx->group_cache, KDC_GROUP_SIDS_CACHE);
+		kdc_db_ctx->group_cache_seq_num = seq_num;
+	}
+	return true;
+}
+
+static DATA_BLOB samba_kdc_group_cache_key(TALLOC_CTX *mem_ctx,
+					   char type,
+					   const void *data,
+					   size_t length)
+{
+	DATA_BLOB key = data_blob_talloc(mem_ctx, NULL, length + 1);
+
+	if (key.data == NULL) {
+		return data_blob_null;
+	}
+	key.data[0] = type;
+	memcpy(key.data + 1, data, length);
+	return key;
+}
+
+/*
+ * Only the used part of each SID goes into the key, so that equal SIDs
+ * give equal keys.
+ */
+static DATA_BLOB samba_kdc_group_cache_sids_key(TALLOC_CTX *mem_ctx,
+						const struct dom_sid *sids,
+						unsigned int num_sids)
+{
+	DATA_BLOB key;
+	size_t ofs = 1;
+	unsigned int i;
+
+	key = data_blob_talloc(mem_ctx, NULL,
+			       1 + num_sids * sizeof(struct dom_sid));
+	if (key.data == NULL) {
+		return data_blob_null;
+	}
+	key.data[0] = 'T';
+
+	for (i = 0; i < num_sids; i++) {
+		const struct dom_sid *sid = &sids[i];
+		size_t len;
+
+		if (sid->num_auths < 0 ||
+		    sid->num_auths > ARRAY_SIZE(sid->sub_auths)) {
+			data_blob_free(&key);
+			return data_blob_null;
+		}
+		len = offsetof(struct dom_sid, sub_auths) +
+			sid->num_auths * sizeof(sid->sub_auths[0]);
+		memcpy(key.data + ofs, sid, len);
+		ofs += len;
+	}
+
+	key.length = ofs;
+	return key;
+}
+
+static bool samba_kdc_group_cache_lookup(TALLOC_CTX *mem_ctx,
+					 struct samba_kdc_db_context *kdc_db_ctx,
+					 DATA_BLOB key,
+					 struct dom_sid **_sids,
+					 unsigned int *_num_sids)
+{
+	struct dom_sid *sids = NULL;
+	unsigned int num_sids;
+	DATA_BLOB value;
+
+	if (!memcache_lookup(kdc_db_ctx->group_cache, KDC_GROUP_SIDS_CACHE,
+			     key, &value)) {
+		return false;
+	}
+	if (value.length == 0 || value.length % sizeof(struct dom_sid) != 0) {
+		return false;
+	}
+
+	num_sids = value.length / sizeof(struct dom_sid);
+	sids = talloc_array(mem_ctx, struct dom_sid, num_sids);
+	if (sids == NULL) {
+		return false;
+	}
+	memcpy(sids, value.data, value.length);
+
+	*_sids = sids;
+	*_num_sids = num_sids;
+	return true;
+}
+
+static void samba_kdc_group_cache_add(struct samba_kdc_db_context *kdc_db_ctx,
+				      DATA_BLOB key,
+				      const struct dom_sid *sids,
+				      unsigned int num_sids)
+{
+	DATA_BLOB value = data_blob_const(sids,
+					  num_sids * sizeof(struct dom_sid));
+
+	memcache_add(kdc_db_ctx->group_cache, KDC_GROUP_SIDS_CACHE,
+		     key, value);
+}
+
+static NTSTATUS samba_kdc_expand_group_sids(TALLOC_CTX *mem_ctx,
+					    struct samba_kdc_entry *p,
+					    struct dom_sid **_sids,
+					    unsigned int *_num_sids)
+{
+	struct samba_kdc_db_context *kdc_db_ctx = p->kdc_db_ctx;
+	const struct ldb_val *sid_val = NULL;
+	DATA_BLOB key = data_blob_null;
+	NTSTATUS status;
+
+	sid_val = ldb_msg_find_ldb_val(p->msg, "objectSid");
+	if (sid_val != NULL && samba_kdc_group_cache_check(kdc_db_ctx)) {
+		key = samba_kdc_group_cache_key(mem_ctx, 'A',
+						sid_val->data,
+						sid_val->length);
+	}
+
+	if (key.data != NULL &&
+	    samba_kdc_group_cache_lookup(mem_ctx, kdc_db_ctx, key,
+					 _sids, _num_sids)) {
+		data_blob_free(&key);
+		return NT_STATUS_OK;
+	}
+
+	status = authsam_expand_group_sids(mem_ctx, kdc_db_ctx->samdb, p->msg,
+					   _sids, _num_sids);
+	if (NT_STATUS_IS_OK(status) && key.data != NULL) {
+		samba_kdc_group_cache_add(kdc_db_ctx, key,
+					  *_sids, *_num_sids);
+	}
+
+	data_blob_free(&key);
+	return status;
+}
+
 NTSTATUS samba_kdc_get_pac_blobs(TALLOC_CTX *mem_ctx,
 				 struct samba_kdc_entry *p,
 				 DATA_BLOB **_logon_info_blob,
@@ -640,6 +804,8 @@ NTSTATUS samba_kdc_get_pac_blobs(TALLOC_CTX *mem_ctx,
 				 DATA_BLOB **_upn_info_blob)
 {
 	struct auth_user_info_dc *user_info_dc;
+	struct dom_sid *sids = NULL;
+	unsigned int num_sids = 0;
 	DATA_BLOB *logon_blob = NULL;
 	DATA_BLOB *cred_blob = NULL;
 	DATA_BLOB *upn_blob = NULL;
@@ -673,7 +839,14 @@ NTSTATUS samba_kdc_get_pac_blobs(TALLOC_CTX *mem_ctx,
 		return NT_STATUS_NO_MEMORY;
 	}
 
-	nt_status = authsam_make_user_info_dc(mem_ctx, p->kdc_db_ctx->samdb,
+	nt_status = samba_kdc_expand_group_sids(mem_ctx, p, &sids, &num_sids);
+	if (!NT_STATUS_IS_OK(nt_status)) {
+		DEBUG(0, ("Getting groups for PAC failed: %s\n",
+			  nt_errstr(nt_status)));
+		return nt_status;
+	}
+
+	nt_status = authsam_make_user_info_dc_sids(mem_ctx, p->kdc_db_ctx->samdb,
 					     lpcfg_netbios_name(p->kdc_db_ctx->lp_ctx),
 					     lpcfg_sam_name(p->kdc_db_ctx->lp_ctx),
 					     lpcfg_sam_dnsname(p->kdc_db_ctx->lp_ctx),
@@ -681,7 +854,10 @@ NTSTATUS samba_kdc_get_pac_blobs(TALLOC_CTX *mem_ctx,
 					     p->msg,
 					     data_blob(NULL, 0),
 					     data_blob(NULL, 0),
+					     sids,
+					     num_sids,
 					     &user_info_dc);
+	TALLOC_FREE(sids);
 	if (!NT_STATUS_IS_OK(nt_status)) {
 		DEBUG(0, ("Getting user info for PAC failed: %s\n",
 			  nt_errstr(nt_status)));
@@ -754,6 +930,9 @@ NTSTATUS samba_kdc_update_pac_blob(TALLOC_CTX *mem_ctx,
 				   struct PAC_SIGNATURE_DATA *pac_kdc_sig)
 {
 	struct auth_user_info_dc *user_info_dc;
+	struct dom_sid *sids = NULL;
+	unsigned int num_sids = 0;
+	DATA_BLOB key = data_blob_null;
 	krb5_error_code ret;
 	NTSTATUS nt_status;
 
@@ -767,12 +946,32 @@ NTSTATUS samba_kdc_update_pac_blob(TALLOC_CTX *mem_ctx,
 	 * We need to expand group memberships within our local domain,
 	 * as the token might be generated by a trusted domain.
 	 */
-	nt_status = authsam_update_user_info_dc(mem_ctx,
-						krbtgt->kdc_db_ctx->samdb,
-						user_info_dc);
-	if (!NT_STATUS_IS_OK(nt_status)) {
-		return nt_status;
+	if (samba_kdc_group_cache_check(krbtgt->kdc_db_ctx)) {
+		key = samba_kdc_group_cache_sids_key(mem_ctx,
+						     user_info_dc->sids,
+						     user_info_dc->num_sids);
+	}
+
+	if (key.data != NULL &&
+	    samba_kdc_group_cache_lookup(user_info_dc, krbtgt->kdc_db_ctx,
+					 key, &sids, &num_sids)) {
+		TALLOC_FREE(user_info_dc->sids);
+		user_info_dc->sids = sids;
+		user_info_dc->num_sids = num_sids;
+	} else {
+		nt_status = authsam_update_user_info_dc(mem_ctx,
+							krbtgt->kdc_db_ctx->samdb,
+							user_info_dc);
+		if (!NT_STATUS_IS_OK(nt_status)) {
+			return nt_status;
+		}
+		if (key.data != NULL) {
+			samba_kdc_group_cache_add(krbtgt->kdc_db_ctx, key,
+						  user_info_dc->sids,
+						  user_info_dc->num_sids);
+		}
 	}
+	data_blob_free(&key);
 
 	nt_status = samba_get_logon_info_pac_blob(mem_ctx, 
 						  user_info_dc, pac_blob);
@@ -37,6 +37,7 @@ struct samba_kdc_base_context {
 };
 
 struct samba_kdc_seq;
+struct samba_kdc_entry_cache;
 
 struct samba_kdc_db_context {
 	struct tevent_context *ev_ctx;
@@ -48,6 +49,9 @@ struct samba_kdc_db_context {
 	unsigned int my_krbtgt_number;
 	struct ldb_dn *krbtgt_dn;
 	struct samba_kdc_policy policy;
+	struct samba_kdc_entry_cache *entry_cache;
+	struct memcache *group_cache;
+	uint64_t group_cache_seq_num;
 };
 
 struct samba_kdc_entry {
@@ -63,6 +63,7 @@ static void free_sdb_key(struct sdb_key *k)
 
 	if (k->salt) {
 		smb_krb5_free_data_contents(NULL, &k->salt->salt);
+		SAFE_FREE(k->salt);
 	}
 
 	ZERO_STRUCTP(k);
@@ -88,14 +89,178 @@ void free_sdb_entry(struct sdb_entry *s)
 	krb5_free_principal(NULL, s->created_by.principal);
 	if (s->modified_by) {
 		krb5_free_principal(NULL, s->modified_by->principal);
+		SAFE_FREE(s->modified_by);
 	}
 	SAFE_FREE(s->valid_start);
 	SAFE_FREE(s->valid_end);
 	SAFE_FREE(s->pw_end);
+	SAFE_FREE(s->max_life);
+	SAFE_FREE(s->max_renew);
 
 	ZERO_STRUCTP(s);
 }
 
+static krb5_error_code copy_sdb_time(time_t *const *from, time_t **to)
+{
+	if (*from == NULL) {
+		*to = NULL;
+		return 0;
+	}
+	*to = malloc(sizeof(**to));
+	if (*to == NULL) {
+		return ENOMEM;
+	}
+	**to = **from;
+	return 0;
+}
+
+static krb5_error_code copy_sdb_uint(unsigned int *const *from,
+				     unsigned int **to)
+{
+	if (*from == NULL) {
+		*to = NULL;
+		return 0;
+	}
+	*to = malloc(sizeof(**to));
+	if (*to == NULL) {
+		return ENOMEM;
+	}
+	**to = **from;
+	return 0;
+}
+
+static krb5_error_code copy_sdb_key(krb5_context context,
+				    const struct sdb_key *from,
+				    struct sdb_key *to)
+{
+	krb5_error_code ret;
+
+	ret = krb5_copy_keyblock_contents(context, &from->key, &to->key);
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = copy_sdb_uint(&from->mkvno, &to->mkvno);
+	if (ret != 0) {
+		return ret;
+	}
+
+	if (from->salt != NULL) {
+		to->salt = calloc(1, sizeof(*to->salt));
+		if (to->salt == NULL) {
+			return ENOMEM;
+		}
+		to->salt->type = from->salt->type;
+		ret = smb_krb5_copy_data_contents(&to->salt->salt,
+						  from->salt->salt.data,
+						  from->salt->salt.length);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static krb5_error_code copy_sdb_event(krb5_context context,
+				      const struct sdb_event *from,
+				      struct sdb_event *to)
+{
+	to->time = from->time;
+	if (from->principal == NULL) {
+		to->principal = NULL;
+		return 0;
+	}
+	return krb5_copy_principal(context, from->principal, &to->principal);
+}
+
+/*
+ * Make a deep copy of an sdb_entry, to be freed with
+ * sdb_free_entry() like any other.
+ */
+krb5_error_code copy_sdb_entry(krb5_context context,
+			       const struct sdb_entry *from,
+			       struct sdb_entry *to)
+{
+	struct sdb_entry_ex tmp = { .ctx = NULL, };
+	struct sdb_entry *s = &tmp.entry;
+	krb5_error_code ret;
+	unsigned int i;
+
+	s->kvno = from->kvno;
+	s->flags = from->flags;
+
+	if (from->principal != NULL) {
+		ret = krb5_copy_principal(context, from->principal,
+					  &s->principal);
+		if (ret != 0) {
+			goto fail;
+		}
+	}
+
+	if (from->keys.len > 0) {
+		s->keys.val = calloc(from->keys.len, sizeof(struct sdb_key));
+		if (s->keys.val == NULL) {
+			ret = ENOMEM;
+			goto fail;
+		}
+		s->keys.len = from->keys.len;
+		for (i = 0; i < from->keys.len; i++) {
+			ret = copy_sdb_key(context, &from->keys.val[i],
+					   &s->keys.val[i]);
+			if (ret != 0) {
+				goto fail;
+			}
+		}
+	}
+
+	ret = copy_sdb_event(context, &from->created_by, &s->created_by);
+	if (ret != 0) {
+		goto fail;
+	}
+
+	if (from->modified_by != NULL) {
+		s->modified_by = calloc(1, sizeof(*s->modified_by));
+		if (s->modified_by == NULL) {
+			ret = ENOMEM;
+			goto fail;
+		}
+		ret = copy_sdb_event(context, from->modified_by,
+				     s->modified_by);
+		if (ret != 0) {
+			goto fail;
+		}
+	}
+
+	ret = copy_sdb_time(&from->valid_start, &s->valid_start);
+	if (ret != 0) {
+		goto fail;
+	}
+	ret = copy_sdb_time(&from->valid_end, &s->valid_end);
+	if (ret != 0) {
+		goto fail;
+	}
+	ret = copy_sdb_time(&from->pw_end, &s->pw_end);
+	if (ret != 0) {
+		goto fail;
+	}
+	ret = copy_sdb_uint(&from->max_life, &s->max_life);
+	if (ret != 0) {
+		goto fail;
+	}
+	ret = copy_sdb_uint(&from->max_renew, &s->max_renew);
+	if (ret != 0) {
+		goto fail;
+	}
+
+	*to = *s;
+	return 0;
+
+fail:
+	sdb_free_entry(&tmp);
+	return ret;
+}
+
 struct SDBFlags int2SDBFlags(unsigned n)
 {
 	struct SDBFlags flags;
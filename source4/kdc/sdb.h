@@ -117,6 +117,9 @@ struct sdb_entry_ex {
 
 void sdb_free_entry(struct sdb_entry_ex *e);
 void free_sdb_entry(struct sdb_entry *s);
+krb5_error_code copy_sdb_entry(krb5_context context,
+			       const struct sdb_entry *from,
+			       struct sdb_entry *to);
 struct SDBFlags int2SDBFlags(unsigned n);
 
 #endif /* _KDC_SDB_H_ */
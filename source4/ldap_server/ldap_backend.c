@@ -31,6 +31,7 @@
 #include <ldb_errors.h>
 #include <ldb_module.h>
 #include "ldb_wrap.h"
+#include "libcli/ldap/ldap_proto.h"
 
 static int map_ldb_error(TALLOC_CTX *mem_ctx, int ldb_err,
 	const char *add_err_string, const char **errstring)
@@ -501,13 +502,135 @@ static int ldapsrv_rename_with_controls(struct ldapsrv_call *call,
 	return ret;
 }
 
+struct ldapsrv_search_context {
+	struct ldapsrv_call *call;
+	int extended_type;
+	bool attributesonly;
+	/* only the count, referrals and controls, never the entries */
+	struct ldb_result *res;
+	/* encoded entries, queued once the search has succeeded */
+	struct ldapsrv_reply *entries;
+};
+
+/*
+  encode each entry as it is found, so that the ldb message can be
+  freed at once. Otherwise a large search keeps every message, each
+  holding its whole unpacked record, until the search is finished.
+  The encoded replies are kept on the search context and only queued
+  when the search succeeds, so a failed search sends no entries.
+ */
+static int ldapsrv_search_callback(struct ldb_request *req,
+				   struct ldb_reply *ares)
+{
+	struct ldapsrv_search_context *ctx =
+		talloc_get_type(req->context, struct ldapsrv_search_context);
+	struct ldapsrv_call *call = ctx->call;
+	struct ldb_result *res = ctx->res;
+	struct ldb_message *msg;
+	struct ldap_SearchResEntry *ent;
+	struct ldapsrv_reply *ent_r;
+	unsigned int n, j;
+	bool ok;
+
+	if (!ares) {
+		return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+	}
+	if (ares->error != LDB_SUCCESS) {
+		return ldb_request_done(req, ares->error);
+	}
+
+	switch (ares->type) {
+	case LDB_REPLY_ENTRY:
+		msg = ares->message;
+
+		ent_r = ldapsrv_init_reply(call, LDAP_TAG_SearchResultEntry);
+		if (ent_r == NULL) {
+			return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+		}
+
+		/* Better to have the whole message kept here,
+		 * than to find someone further up didn't put
+		 * a value in the right spot in the talloc tree */
+		talloc_steal(ent_r->msg, msg);
+
+		ent = &ent_r->msg->r.SearchResultEntry;
+		ent->dn = ldb_dn_get_extended_linearized(ent_r, msg->dn,
+							 ctx->extended_type);
+		ent->num_attributes = 0;
+		ent->attributes = NULL;
+		if (msg->num_elements != 0) {
+			ent->num_attributes = msg->num_elements;
+			ent->attributes = talloc_array(ent_r,
+						       struct ldb_message_element,
+						       ent->num_attributes);
+			if (ent->attributes == NULL) {
+				TALLOC_FREE(ent_r);
+				return ldb_request_done(req,
+						LDB_ERR_OPERATIONS_ERROR);
+			}
+		}
+		for (j=0; j < ent->num_attributes; j++) {
+			ent->attributes[j].name = msg->elements[j].name;
+			ent->attributes[j].num_values = 0;
+			ent->attributes[j].values = NULL;
+			if (ctx->attributesonly &&
+			    (msg->elements[j].num_values == 0)) {
+				continue;
+			}
+			ent->attributes[j].num_values = msg->elements[j].num_values;
+			ent->attributes[j].values = msg->elements[j].values;
+		}
+
+		ok = ldap_encode(ent_r->msg, samba_ldap_control_handlers(),
+				 &ent_r->blob, ent_r);
+		if (!ok) {
+			DEBUG(0,("Failed to encode ldap search entry for %s\n",
+				 ldb_dn_get_linearized(msg->dn)));
+			TALLOC_FREE(ent_r);
+			return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+		}
+		TALLOC_FREE(ent->attributes);
+		TALLOC_FREE(ent_r->msg);
+
+		talloc_steal(ctx, ent_r);
+		DLIST_ADD_END(ctx->entries, ent_r);
+		res->count++;
+		break;
+
+	case LDB_REPLY_REFERRAL:
+		if (res->refs) {
+			for (n = 0; res->refs[n]; n++) /*noop*/ ;
+		} else {
+			n = 0;
+		}
+
+		res->refs = talloc_realloc(res, res->refs, char *, n + 2);
+		if (! res->refs) {
+			return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+		}
+
+		res->refs[n] = talloc_move(res->refs, &ares->referral);
+		res->refs[n + 1] = NULL;
+		break;
+
+	case LDB_REPLY_DONE:
+		res->controls = talloc_move(res, &ares->controls);
+		talloc_free(ares);
+		return ldb_request_done(req, LDB_SUCCESS);
+	}
+
+	talloc_free(ares);
+
+	return LDB_SUCCESS;
+}
+
 static NTSTATUS ldapsrv_SearchRequest(struct ldapsrv_call *call)
 {
 	struct ldap_SearchRequest *req = &call->request->r.SearchRequest;
-	struct ldap_SearchResEntry *ent;
 	struct ldap_Result *done;
 	struct ldapsrv_reply *ent_r, *done_r;
 	TALLOC_CTX *local_ctx;
+	struct ldapsrv_search_context *callback_ctx = NULL;
 	struct ldb_context *samdb = talloc_get_type(call->conn->ldb, struct ldb_context);
 	struct ldb_dn *basedn;
 	struct ldb_result *res = NULL;
@@ -523,7 +646,7 @@ static NTSTATUS ldapsrv_SearchRequest(struct ldapsrv_call *call)
 	int success_limit = 1;
 	int result = -1;
 	int ldb_ret = -1;
-	unsigned int i, j;
+	unsigned int i;
 	int extended_type = 1;
 
 	DEBUG(10, ("SearchRequest"));
@@ -582,11 +705,18 @@ static NTSTATUS ldapsrv_SearchRequest(struct ldapsrv_call *call)
 	res = talloc_zero(local_ctx, struct ldb_result);
 	NT_STATUS_HAVE_NO_MEMORY(res);
 
+	callback_ctx = talloc_zero(local_ctx, struct ldapsrv_search_context);
+	NT_STATUS_HAVE_NO_MEMORY(callback_ctx);
+	callback_ctx->call = call;
+	callback_ctx->attributesonly = req->attributesonly;
+	callback_ctx->res = res;
+
 	ldb_ret = ldb_build_search_req_ex(&lreq, samdb, local_ctx,
 					  basedn, scope,
 					  req->tree, attrs,
 					  call->request->controls,
-					  res, ldb_search_default_callback,
+					  callback_ctx,
+					  ldapsrv_search_callback,
 					  NULL);
 
 	if (ldb_ret != LDB_SUCCESS) {
@@ -620,6 +750,7 @@ static NTSTATUS ldapsrv_SearchRequest(struct ldapsrv_call *call)
 			extended_type = 0;
 		}
 	}
+	callback_ctx->extended_type = extended_type;
 
 	notification_control = ldb_request_get_control(lreq, LDB_CONTROL_NOTIFICATION_OID);
 	if (notification_control != NULL) {
@@ -663,38 +794,13 @@ static NTSTATUS ldapsrv_SearchRequest(struct ldapsrv_call *call)
 	ldb_ret = ldb_wait(lreq->handle, LDB_WAIT_ALL);
 
 	if (ldb_ret == LDB_SUCCESS) {
-		for (i = 0; i < res->count; i++) {
-			ent_r = ldapsrv_init_reply(call, LDAP_TAG_SearchResultEntry);
-			NT_STATUS_HAVE_NO_MEMORY(ent_r);
-
-			/* Better to have the whole message kept here,
-			 * than to find someone further up didn't put
-			 * a value in the right spot in the talloc tree */
-			talloc_steal(ent_r, res->msgs[i]);
-			
-			ent = &ent_r->msg->r.SearchResultEntry;
-			ent->dn = ldb_dn_get_extended_linearized(ent_r, res->msgs[i]->dn, extended_type);
-			ent->num_attributes = 0;
-			ent->attributes = NULL;
-			if (res->msgs[i]->num_elements == 0) {
-				goto queue_reply;
-			}
-			ent->num_attributes = res->msgs[i]->num_elements;
-			ent->attributes = talloc_array(ent_r, struct ldb_message_element, ent->num_attributes);
-			NT_STATUS_HAVE_NO_MEMORY(ent->attributes);
-			for (j=0; j < ent->num_attributes; j++) {
-				ent->attributes[j].name = res->msgs[i]->elements[j].name;
-				ent->attributes[j].num_values = 0;
-				ent->attributes[j].values = NULL;
-				if (req->attributesonly && (res->msgs[i]->elements[j].num_values == 0)) {
-					continue;
-				}
-				ent->attributes[j].num_values = res->msgs[i]->elements[j].num_values;
-				ent->attributes[j].values = res->msgs[i]->elements[j].values;
-			}
-queue_reply:
-			ldapsrv_queue_reply(call, ent_r);
+		for (ent_r = callback_ctx->entries;
+		     ent_r != NULL;
+		     ent_r = ent_r->next) {
+			talloc_steal(call, ent_r);
 		}
+		DLIST_CONCATENATE(call->replies, callback_ctx->entries);
+		callback_ctx->entries = NULL;
 
 		if (call->notification.busy) {
 			/* Move/Add it to the end */
@@ -1219,6 +1325,16 @@ static NTSTATUS ldapsrv_AbandonRequest(struct ldapsrv_call *call)
 		}
 
 		DLIST_REMOVE(call->conn->pending_calls, c);
+		c->notification.busy = false;
+
+		if (c->in_flight) {
+			/*
+			 * Its replies are still being written,
+			 * ldapsrv_call_finished() frees it after that.
+			 */
+			continue;
+		}
+
 		TALLOC_FREE(c);
 	}
 
@@ -68,10 +68,6 @@ static void ldapsrv_terminate_connection(struct ldapsrv_connection *conn,
 
 	tevent_queue_stop(conn->sockets.send_queue);
 	TALLOC_FREE(conn->sockets.read_req);
-	if (conn->active_call) {
-		tevent_req_cancel(conn->active_call);
-		conn->active_call = NULL;
-	}
 
 	conn->limits.reason = talloc_strdup(conn, reason);
 	if (conn->limits.reason == NULL) {
@@ -254,6 +250,23 @@ failed:
 	return -1;
 }
 
+static void ldapsrv_call_leave_pipeline(struct ldapsrv_call *call)
+{
+	struct ldapsrv_connection *conn = call->conn;
+
+	if (!call->in_flight) {
+		return;
+	}
+
+	call->in_flight = false;
+	conn->pipeline.num_calls -= 1;
+
+	if (conn->pipeline.exclusive_call == call) {
+		conn->pipeline.exclusive_call = NULL;
+		conn->pipeline.exclusive_waiting = false;
+	}
+}
+
 static int ldapsrv_call_destructor(struct ldapsrv_call *call)
 {
 	if (call->conn == NULL) {
@@ -261,6 +274,7 @@ static int ldapsrv_call_destructor(struct ldapsrv_call *call)
 	}
 
 	DLIST_REMOVE(call->conn->pending_calls, call);
+	ldapsrv_call_leave_pipeline(call);
 
 	call->conn = NULL;
 	return 0;
@@ -375,6 +389,14 @@ static void ldapsrv_accept(struct stream_connection *c,
 	/* load limits from the conf partition */
 	ldapsrv_load_limits(conn); /* should we fail on error ? */
 
+	conn->limits.max_pipelined_calls = lpcfg_parm_int(conn->lp_ctx, NULL,
+							  "ldap server",
+							  "max pipelined calls",
+							  32);
+	if (conn->limits.max_pipelined_calls < 1) {
+		conn->limits.max_pipelined_calls = 1;
+	}
+
 	/* register the server */	
 	irpc_add_name(c->msg_ctx, "ldap_server");
 
@@ -437,20 +459,50 @@ static void ldapsrv_call_read_done(struct tevent_req *subreq);
 static bool ldapsrv_call_read_next(struct ldapsrv_connection *conn)
 {
 	struct tevent_req *subreq;
+	struct timeval endtime;
+
+	if (conn->limits.reason != NULL) {
+		/* the connection is being terminated */
+		return false;
+	}
+
+	if (conn->pipeline.exclusive_call != NULL) {
+		/* ldapsrv_call_finished() reads on once it is done */
+		return true;
+	}
+
+	if (conn->pipeline.num_calls >= conn->limits.max_pipelined_calls) {
+		return true;
+	}
 
 	if (conn->pending_calls != NULL) {
 		conn->limits.endtime = timeval_zero();
+		endtime = conn->limits.endtime;
 
 		ldapsrv_notification_retry_setup(conn->service, false);
+	} else if (conn->pipeline.num_calls != 0) {
+		/*
+		 * The connection is not idle before all replies are
+		 * written, ldapsrv_call_finished() calls us again to
+		 * start the idle timeout.
+		 */
+		endtime = timeval_zero();
 	} else if (timeval_is_zero(&conn->limits.endtime)) {
 		conn->limits.endtime =
 			timeval_current_ofs(conn->limits.initial_timeout, 0);
+		endtime = conn->limits.endtime;
 	} else {
 		conn->limits.endtime =
 			timeval_current_ofs(conn->limits.conn_idle_time, 0);
+		endtime = conn->limits.endtime;
 	}
 
 	if (conn->sockets.read_req != NULL) {
+		if (!timeval_is_zero(&endtime)) {
+			tevent_req_set_endtime(conn->sockets.read_req,
+					       conn->connection->event.ctx,
+					       endtime);
+		}
 		return true;
 	}
 
@@ -493,10 +545,10 @@ static bool ldapsrv_call_read_next(struct ldapsrv_connection *conn)
 				"no memory for tstream_read_pdu_blob_send");
 		return false;
 	}
-	if (!timeval_is_zero(&conn->limits.endtime)) {
+	if (!timeval_is_zero(&endtime)) {
 		tevent_req_set_endtime(subreq,
 				       conn->connection->event.ctx,
-				       conn->limits.endtime);
+				       endtime);
 	}
 	tevent_req_set_callback(subreq, ldapsrv_call_read_done, conn);
 	conn->sockets.read_req = subreq;
@@ -505,6 +557,77 @@ static bool ldapsrv_call_read_next(struct ldapsrv_connection *conn)
 
 static void ldapsrv_call_process_done(struct tevent_req *subreq);
 
+static bool ldapsrv_call_start(struct ldapsrv_call *call)
+{
+	struct ldapsrv_connection *conn = call->conn;
+	struct tevent_req *subreq;
+
+	/* queue the call in the global queue */
+	subreq = ldapsrv_process_call_send(call,
+					   conn->connection->event.ctx,
+					   conn->service->call_queue,
+					   call);
+	if (subreq == NULL) {
+		ldapsrv_terminate_connection(conn, "ldapsrv_process_call_send failed");
+		return false;
+	}
+	tevent_req_set_callback(subreq, ldapsrv_call_process_done, call);
+	return true;
+}
+
+/*
+ * Calls that change the state of the connection, the authentication
+ * or the socket, have to see the connection as all earlier calls left
+ * it, and no later request may be read before they are done.
+ */
+static bool ldapsrv_call_is_exclusive(struct ldapsrv_call *call)
+{
+	switch (call->request->type) {
+	case LDAP_TAG_BindRequest:
+	case LDAP_TAG_UnbindRequest:
+		return true;
+	case LDAP_TAG_ExtendedRequest: {
+		struct ldap_ExtendedRequest *req =
+			&call->request->r.ExtendedRequest;
+		if (strcmp(req->oid, LDB_EXTENDED_START_TLS_OID) == 0) {
+			return true;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+
+	return false;
+}
+
+/*
+ * All replies of the call are written
+ */
+static void ldapsrv_call_finished(struct ldapsrv_call *call)
+{
+	struct ldapsrv_connection *conn = call->conn;
+	struct ldapsrv_call *exclusive_call = NULL;
+
+	ldapsrv_call_leave_pipeline(call);
+
+	if (!call->notification.busy) {
+		TALLOC_FREE(call);
+	}
+
+	exclusive_call = conn->pipeline.exclusive_call;
+	if (exclusive_call != NULL) {
+		if (conn->pipeline.exclusive_waiting &&
+		    conn->pipeline.num_calls == 1) {
+			conn->pipeline.exclusive_waiting = false;
+			ldapsrv_call_start(exclusive_call);
+		}
+		return;
+	}
+
+	ldapsrv_call_read_next(conn);
+}
+
 static void ldapsrv_call_read_done(struct tevent_req *subreq)
 {
 	struct ldapsrv_connection *conn =
@@ -570,18 +693,26 @@ static void ldapsrv_call_read_done(struct tevent_req *subreq)
 
 	data_blob_free(&blob);
 
+	call->in_flight = true;
+	conn->pipeline.num_calls += 1;
 
-	/* queue the call in the global queue */
-	subreq = ldapsrv_process_call_send(call,
-					   conn->connection->event.ctx,
-					   conn->service->call_queue,
-					   call);
-	if (subreq == NULL) {
-		ldapsrv_terminate_connection(conn, "ldapsrv_process_call_send failed");
+	if (ldapsrv_call_is_exclusive(call)) {
+		conn->pipeline.exclusive_call = call;
+		if (conn->pipeline.num_calls > 1) {
+			/* ldapsrv_call_finished() starts it */
+			conn->pipeline.exclusive_waiting = true;
+			return;
+		}
+		ldapsrv_call_start(call);
 		return;
 	}
-	tevent_req_set_callback(subreq, ldapsrv_call_process_done, call);
-	conn->active_call = subreq;
+
+	if (!ldapsrv_call_start(call)) {
+		return;
+	}
+
+	/* read the next request while this one is answered */
+	ldapsrv_call_read_next(conn);
 }
 
 static void ldapsrv_call_wait_done(struct tevent_req *subreq);
@@ -596,8 +727,6 @@ static void ldapsrv_call_process_done(struct tevent_req *subreq)
 	struct ldapsrv_connection *conn = call->conn;
 	NTSTATUS status;
 
-	conn->active_call = NULL;
-
 	status = ldapsrv_process_call_recv(subreq);
 	TALLOC_FREE(subreq);
 	if (!NT_STATUS_IS_OK(status)) {
@@ -618,7 +747,6 @@ static void ldapsrv_call_process_done(struct tevent_req *subreq)
 		tevent_req_set_callback(subreq,
 					ldapsrv_call_wait_done,
 					call);
-		conn->active_call = subreq;
 		return;
 	}
 
@@ -633,8 +761,6 @@ static void ldapsrv_call_wait_done(struct tevent_req *subreq)
 	struct ldapsrv_connection *conn = call->conn;
 	NTSTATUS status;
 
-	conn->active_call = NULL;
-
 	status = call->wait_recv(subreq);
 	TALLOC_FREE(subreq);
 	if (!NT_STATUS_IS_OK(status)) {
@@ -654,54 +780,72 @@ static void ldapsrv_call_wait_done(struct tevent_req *subreq)
 	ldapsrv_call_writev_start(call);
 }
 
+/*
+ * Each reply is written from its own buffer, up to this many in one
+ * writev, rather than all being copied into one blob first.
+ */
+#define LDAPSRV_MAX_IOV MIN(IOV_MAX, 1024)
+
 static void ldapsrv_call_writev_start(struct ldapsrv_call *call)
 {
 	struct ldapsrv_connection *conn = call->conn;
-	DATA_BLOB blob = data_blob_null;
+	struct ldapsrv_reply *reply = NULL;
 	struct tevent_req *subreq = NULL;
+	size_t i;
 
-	/* build all the replies into a single blob */
-	while (call->replies) {
-		DATA_BLOB b;
-		bool ret;
+	if (call->iov_count != 0) {
+		/*
+		 * A write is still in flight, ldapsrv_call_writev_done()
+		 * sends the newly queued replies once it is finished.
+		 */
+		return;
+	}
 
-		if (!ldap_encode(call->replies->msg, samba_ldap_control_handlers(), &b, call)) {
-			DEBUG(0,("Failed to encode ldap reply of type %d\n",
-				 call->replies->msg->type));
-			ldapsrv_terminate_connection(conn, "ldap_encode failed");
-			return;
+	for (reply = call->replies; reply != NULL; reply = reply->next) {
+		if (call->iov_count == LDAPSRV_MAX_IOV) {
+			break;
 		}
+		call->iov_count++;
+	}
 
-		ret = data_blob_append(call, &blob, b.data, b.length);
-		data_blob_free(&b);
-
-		talloc_set_name_const(blob.data, "Outgoing, encoded LDAP packet");
-
-		if (!ret) {
-			ldapsrv_terminate_connection(conn, "data_blob_append failed");
-			return;
-		}
+	if (call->iov_count == 0) {
+		ldapsrv_call_finished(call);
+		return;
+	}
 
-		DLIST_REMOVE(call->replies, call->replies);
+	call->out_iov = talloc_realloc(call, call->out_iov, struct iovec,
+				       call->iov_count);
+	if (call->out_iov == NULL) {
+		ldapsrv_terminate_connection(conn, "talloc_realloc failed");
+		return;
 	}
 
-	if (blob.length == 0) {
-		if (!call->notification.busy) {
-			TALLOC_FREE(call);
+	reply = call->replies;
+	for (i = 0; i < call->iov_count; i++) {
+		/* search entries are encoded as they are found */
+		if (reply->msg != NULL) {
+			if (!ldap_encode(reply->msg,
+					 samba_ldap_control_handlers(),
+					 &reply->blob, reply)) {
+				DEBUG(0,("Failed to encode ldap reply of type %d\n",
+					 reply->msg->type));
+				ldapsrv_terminate_connection(conn,
+							     "ldap_encode failed");
+				return;
+			}
+			TALLOC_FREE(reply->msg);
 		}
 
-		ldapsrv_call_read_next(conn);
-		return;
+		call->out_iov[i].iov_base = reply->blob.data;
+		call->out_iov[i].iov_len = reply->blob.length;
+		reply = reply->next;
 	}
 
-	call->out_iov.iov_base = blob.data;
-	call->out_iov.iov_len = blob.length;
-
 	subreq = tstream_writev_queue_send(call,
 					   conn->connection->event.ctx,
 					   conn->sockets.active,
 					   conn->sockets.send_queue,
-					   &call->out_iov, 1);
+					   call->out_iov, call->iov_count);
 	if (subreq == NULL) {
 		ldapsrv_terminate_connection(conn, "stream_writev_queue_send failed");
 		return;
@@ -719,6 +863,7 @@ static void ldapsrv_call_writev_done(struct tevent_req *subreq)
 	struct ldapsrv_connection *conn = call->conn;
 	int sys_errno;
 	int rc;
+	size_t i;
 
 	rc = tstream_writev_queue_recv(subreq, &sys_errno);
 	TALLOC_FREE(subreq);
@@ -737,6 +882,20 @@ static void ldapsrv_call_writev_done(struct tevent_req *subreq)
 		return;
 	}
 
+	for (i = 0; i < call->iov_count; i++) {
+		struct ldapsrv_reply *reply = call->replies;
+
+		DLIST_REMOVE(call->replies, reply);
+		TALLOC_FREE(reply);
+	}
+	call->iov_count = 0;
+
+	if (call->replies != NULL) {
+		/* there were more replies than fit in one writev */
+		ldapsrv_call_writev_start(call);
+		return;
+	}
+
 	if (call->postprocess_send) {
 		subreq = call->postprocess_send(call,
 						conn->connection->event.ctx,
@@ -752,11 +911,7 @@ static void ldapsrv_call_writev_done(struct tevent_req *subreq)
 		return;
 	}
 
-	if (!call->notification.busy) {
-		TALLOC_FREE(call);
-	}
-
-	ldapsrv_call_read_next(conn);
+	ldapsrv_call_finished(call);
 }
 
 static void ldapsrv_call_postprocess_done(struct tevent_req *subreq)
@@ -783,9 +938,7 @@ static void ldapsrv_call_postprocess_done(struct tevent_req *subreq)
 		return;
 	}
 
-	TALLOC_FREE(call);
-
-	ldapsrv_call_read_next(conn);
+	ldapsrv_call_finished(call);
 }
 
 static void ldapsrv_notification_retry_done(struct tevent_req *subreq);
@@ -869,7 +1022,7 @@ static void ldapsrv_notification_retry_done(struct tevent_req *subreq)
 			continue;
 		}
 
-		if (conn->active_call != NULL) {
+		if (conn->pipeline.num_calls != 0) {
 			continue;
 		}
 
@@ -877,18 +1030,10 @@ static void ldapsrv_notification_retry_done(struct tevent_req *subreq)
 		call->notification.generation =
 				service->notification.generation;
 
-		/* queue the call in the global queue */
-		subreq = ldapsrv_process_call_send(call,
-						   conn->connection->event.ctx,
-						   conn->service->call_queue,
-						   call);
-		if (subreq == NULL) {
-			ldapsrv_terminate_connection(conn,
-					"ldapsrv_process_call_send failed");
-			continue;
-		}
-		tevent_req_set_callback(subreq, ldapsrv_call_process_done, call);
-		conn->active_call = subreq;
+		call->in_flight = true;
+		conn->pipeline.num_calls += 1;
+
+		ldapsrv_call_start(call);
 	}
 
 	ldapsrv_notification_retry_setup(service, false);
@@ -936,6 +1081,12 @@ static void ldapsrv_process_call_trigger(struct tevent_req *req,
 		struct ldapsrv_process_call_state);
 	NTSTATUS status;
 
+	if (state->call->conn->limits.reason != NULL) {
+		/* the connection was terminated while the call was queued */
+		tevent_req_nterror(req, NT_STATUS_CONNECTION_DISCONNECTED);
+		return;
+	}
+
 	/* make the call */
 	status = ldapsrv_do_call(state->call);
 	if (!NT_STATUS_IS_OK(status)) {
@@ -54,11 +54,22 @@ struct ldapsrv_connection {
 		int max_page_size;
 		int max_notifications;
 		int search_timeout;
+		int max_pipelined_calls;
 		struct timeval endtime;
 		const char *reason;
 	} limits;
 
-	struct tevent_req *active_call;
+	/*
+	 * Requests are read and processed while the replies to earlier
+	 * ones are still being written, up to limits.max_pipelined_calls
+	 * of them.  Binds, unbinds and StartTLS wait for all earlier
+	 * calls to finish and nothing is read until they are done.
+	 */
+	struct {
+		size_t num_calls;
+		struct ldapsrv_call *exclusive_call;
+		bool exclusive_waiting;
+	} pipeline;
 
 	struct ldapsrv_call *pending_calls;
 };
@@ -70,8 +81,11 @@ struct ldapsrv_call {
 	struct ldapsrv_reply {
 		struct ldapsrv_reply *prev, *next;
 		struct ldap_message *msg;
+		DATA_BLOB blob;
 	} *replies;
-	struct iovec out_iov;
+	struct iovec *out_iov;
+	size_t iov_count;
+	bool in_flight;
 
 	struct tevent_req *(*wait_send)(TALLOC_CTX *mem_ctx,
 					struct tevent_context *ev,
@@ -1043,6 +1043,7 @@ struct drsuapi_changed_objects {
 	struct ldb_dn *dn;
 	struct GUID guid;
 	uint64_t usn;
+	bool is_nc_root;
 };
 
 /*
@@ -1052,15 +1053,16 @@ static int site_res_cmp_usn_order(struct drsuapi_changed_objects *m1,
 				  struct drsuapi_changed_objects *m2,
 				  struct drsuapi_getncchanges_state *getnc_state)
 {
-	int ret;
-
-	ret = ldb_dn_compare(getnc_state->ncRoot_dn, m1->dn);
-	if (ret == 0) {
+	/*
+	 * The NC root always goes first. This is worked out once per
+	 * object, as comparing the DNs here would be done
+	 * O(n log n) times on a full replication.
+	 */
+	if (m1->is_nc_root) {
 		return -1;
 	}
 
-	ret = ldb_dn_compare(getnc_state->ncRoot_dn, m2->dn);
-	if (ret == 0) {
+	if (m2->is_nc_root) {
 		return 1;
 	}
 
@@ -3153,6 +3155,8 @@ allowed:
 			changes[i].dn = search_res->msgs[i]->dn;
 			changes[i].guid = samdb_result_guid(search_res->msgs[i], "objectGUID");
 			changes[i].usn = ldb_msg_find_attr_as_uint64(search_res->msgs[i], "uSNChanged", 0);
+			changes[i].is_nc_root = GUID_equal(&changes[i].guid,
+							   &getnc_state->ncRoot_guid);
 
 			if (changes[i].usn > getnc_state->max_usn) {
 				getnc_state->max_usn = changes[i].usn;
@@ -335,8 +335,10 @@ plansmbtorture4testsuite(t, "rpc_proxy", ['//$NETBIOSNAME/cifs_to_dc', '-U$DC_US
 
 plansmbtorture4testsuite('echo.udp', 'ad_dc_ntvfs:local', '//$SERVER/whatever')
 
-# Local tests
-for t in smbtorture4_testsuites("local."):
+# Local tests, without the speed tests run from selftest/perf_tests.py
+local_tests = filter(lambda x: x != "local.dsdb.schema.speed",
+                     smbtorture4_testsuites("local."))
+for t in local_tests:
     #The local.resolve test needs a name to look up using real system (not emulated) name routines
     plansmbtorture4testsuite(t, "none", "ncalrpc:localhost")
 
@@ -33,7 +33,8 @@
  * with a comment and maybe update struct process_model_critical_sizes.
  */
 /* version 1 - initial version - metze */
-#define PROCESS_MODEL_VERSION 1
+/* version 2 - new_task callback returns the task, service post_fork hook */
+#define PROCESS_MODEL_VERSION 2
 
 /* the process model operations structure - contains function pointers to 
    the model-specific implementations of each operation */
@@ -54,11 +55,14 @@ struct model_ops {
 					   struct server_id , void *, void *),
 				  void *, void *);
 
-	/* function to create a task */
+	/*
+	 * function to create a task, the callback returns the task or
+	 * NULL if it failed to start
+	 */
 	void (*new_task)(struct tevent_context *, 
 			 struct loadparm_context *lp_ctx,
 			 const char *service_name,
-			 void (*)(struct tevent_context *, 
+			 struct task_server *(*)(struct tevent_context *,
 				  struct loadparm_context *, struct server_id, 
 				  void *, void *),
 			 void *,
@@ -220,6 +220,26 @@ static void setup_handlers(struct tevent_context *ev, int from_parent_fd) {
 	}
 }
 
+/*
+ * Should the task be run in pre-forked worker processes?
+ *
+ * A service that inhibits pre-forking but can set up its per process
+ * state in post_fork is pre-forked when "prefork children" is set for it.
+ */
+static bool prefork_service(struct loadparm_context *lp_ctx,
+			    const char *service_name,
+			    const struct service_details *service_details)
+{
+	if (!service_details->inhibit_pre_fork) {
+		return true;
+	}
+	if (service_details->post_fork == NULL) {
+		return false;
+	}
+	return lpcfg_parm_int(lp_ctx, NULL, "prefork children",
+			      service_name, 0) > 0;
+}
+
 /*
  * called to create a new server task
  */
@@ -227,7 +247,7 @@ static void prefork_new_task(
 	struct tevent_context *ev,
 	struct loadparm_context *lp_ctx,
 	const char *service_name,
-	void (*new_task_fn)(struct tevent_context *,
+	struct task_server *(*new_task_fn)(struct tevent_context *,
 			    struct loadparm_context *lp_ctx,
 			    struct server_id , void *, void *),
 	void *private_data,
@@ -237,6 +257,8 @@ static void prefork_new_task(
 	pid_t pid;
 	struct tfork* t = NULL;
 	int i, num_children;
+	struct task_server *task = NULL;
+	struct process_details pd = { .instances = 1 };
 
 	struct tevent_context *ev2;
 
@@ -276,8 +298,12 @@ static void prefork_new_task(
 	prefork_reload_after_fork();
 	setup_handlers(ev, from_parent_fd);
 
-	if (service_details->inhibit_pre_fork) {
-		new_task_fn(ev, lp_ctx, cluster_id(pid, 0), private_data, NULL);
+	if (!prefork_service(lp_ctx, service_name, service_details)) {
+		task = new_task_fn(ev, lp_ctx, cluster_id(pid, 0),
+				   private_data, NULL);
+		if (task != NULL && service_details->post_fork != NULL) {
+			service_details->post_fork(task, &pd);
+		}
 		/* The task does not support pre-fork */
 		tevent_loop_wait(ev);
 		TALLOC_FREE(ev);
@@ -298,7 +324,7 @@ static void prefork_new_task(
 	 * process accepting and handling requests, it's responsible for
 	 * monitoring and controlling the child work processes.
 	 */
-	new_task_fn(ev2, lp_ctx, cluster_id(pid, 0), private_data, NULL);
+	task = new_task_fn(ev2, lp_ctx, cluster_id(pid, 0), private_data, NULL);
 
 	{
 		int default_children;
@@ -313,6 +339,7 @@ static void prefork_new_task(
 	}
 	DBG_NOTICE("Forking %d %s worker processes\n",
 		   num_children, service_name);
+	pd.instances = num_children;
 	/* We are now free to spawn some worker processes */
 	for (i=0; i < num_children; i++) {
 		struct tfork* w = NULL;
@@ -343,6 +370,10 @@ static void prefork_new_task(
 				     service_name);
 			prefork_reload_after_fork();
 			setup_handlers(ev2, from_parent_fd);
+			if (task != NULL &&
+			    service_details->post_fork != NULL) {
+				service_details->post_fork(task, &pd);
+			}
 			tevent_loop_wait(ev2);
 			talloc_free(ev2);
 			exit(0);
@@ -27,6 +27,15 @@
 #include "smbd/service_stream.h"
 #include "smbd/service_task.h"
 
+/*
+ * Passed to the post_fork hook of a service, describing the processes
+ * running the task.
+ */
+struct process_details {
+	/* the number of processes serving the task, all running post_fork */
+	unsigned int instances;
+};
+
 struct service_details {
 	/*
 	 * Prevent the standard process model from forking a new worker
@@ -39,8 +48,18 @@ struct service_details {
 	 * Prevent the pre-fork process model from pre-forking any worker
 	 * processes. In this mode pre-fork is equivalent to standard with
 	 * inhibit_fork_on_accept set.
+	 *
+	 * A service that also has a post_fork hook is still pre-forked
+	 * when "prefork children:<service>" is set explicitly.
 	 */
 	 bool inhibit_pre_fork;
+	/*
+	 * Called in every process that serves the task once the task is
+	 * initialised: in each pre-forked worker after the fork, otherwise
+	 * straight after task_init in the task's own process. Per process
+	 * resources, like UDP sockets and IRPC names, are set up here.
+	 */
+	void (*post_fork)(struct task_server *, struct process_details *);
 };
 
 #include "smbd/service_proto.h"
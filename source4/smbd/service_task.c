@@ -64,24 +64,40 @@ void task_server_terminate(struct task_server *task, const char *reason, bool fa
 struct task_state {
 	void (*task_init)(struct task_server *);
 	const struct model_ops *model_ops;
+	/* the task being started, NULL once it is freed */
+	struct task_server *task;
+};
+
+/*
+  a child of the task, telling the task_state when task_init terminated it
+*/
+struct task_guard {
+	struct task_state *state;
 };
 
+static int task_guard_destructor(struct task_guard *guard)
+{
+	guard->state->task = NULL;
+	return 0;
+}
 
 /*
   called by the process model code when the new task starts up. This then calls
-  the server specific startup code
+  the server specific startup code, and returns the task or NULL if it
+  failed to start
 */
-static void task_server_callback(struct tevent_context *event_ctx,
-				 struct loadparm_context *lp_ctx,
-				 struct server_id server_id,
-				 void *private_data,
-				 void *context)
+static struct task_server *task_server_callback(struct tevent_context *event_ctx,
+						struct loadparm_context *lp_ctx,
+						struct server_id server_id,
+						void *private_data,
+						void *context)
 {
 	struct task_state *state = talloc_get_type(private_data, struct task_state);
 	struct task_server *task;
+	struct task_guard *guard;
 
 	task = talloc(event_ctx, struct task_server);
-	if (task == NULL) return;
+	if (task == NULL) return NULL;
 
 	task->event_ctx = event_ctx;
 	task->model_ops = state->model_ops;
@@ -89,16 +105,33 @@ static void task_server_callback(struct tevent_context *event_ctx,
 	task->lp_ctx = lp_ctx;
 	task->process_context = context;
 
+	guard = talloc(task, struct task_guard);
+	if (guard == NULL) {
+		talloc_free(task);
+		return NULL;
+	}
+	guard->state = state;
+	talloc_set_destructor(guard, task_guard_destructor);
+	state->task = task;
+
 	task->msg_ctx = imessaging_init(task,
 					task->lp_ctx,
 					task->server_id,
 					task->event_ctx);
 	if (!task->msg_ctx) {
 		task_server_terminate(task, "imessaging_init() failed", true);
-		return;
+		return NULL;
 	}
 
 	state->task_init(task);
+
+	/* task_init frees the task with task_server_terminate() on failure */
+	task = state->task;
+	if (task != NULL) {
+		talloc_set_destructor(guard, NULL);
+		talloc_free(guard);
+	}
+	return task;
 }
 
 /*
@@ -119,6 +152,7 @@ NTSTATUS task_server_startup(struct tevent_context *event_ctx,
 
 	state->task_init = task_init;
 	state->model_ops = model_ops;
+	state->task = NULL;
 
 	state->model_ops->new_task(event_ctx, lp_ctx, service_name,
 			           task_server_callback, state, service_details,
@@ -53,6 +53,9 @@ enum torture_krb5_test {
 	TORTURE_KRB5_TEST_CHANGE_SERVER_OUT,
 	TORTURE_KRB5_TEST_CHANGE_SERVER_IN,
 	TORTURE_KRB5_TEST_CHANGE_SERVER_BOTH,
+
+	/* repeated AS-REQs, only timed */
+	TORTURE_KRB5_TEST_BENCH,
 };
 
 struct torture_krb5_context {
@@ -79,6 +82,8 @@ static bool torture_krb5_pre_send_test(struct torture_krb5_context *test_context
 	size_t used;
 	switch (test_context->test)
 	{
+	case TORTURE_KRB5_TEST_BENCH:
+		break;
 	case TORTURE_KRB5_TEST_PLAIN:
 	case TORTURE_KRB5_TEST_PAC_REQUEST:
 	case TORTURE_KRB5_TEST_BREAK_PW:
@@ -246,6 +251,8 @@ static bool torture_krb5_post_recv_test(struct torture_krb5_context *test_contex
 
 	switch (test_context->test)
 	{
+	case TORTURE_KRB5_TEST_BENCH:
+		break;
 	case TORTURE_KRB5_TEST_CHANGE_SERVER_OUT:
 	case TORTURE_KRB5_TEST_PLAIN:
 		if (test_context->packet_count == 0) {
@@ -669,6 +676,7 @@ static bool torture_krb5_as_req_creds(struct torture_context *tctx,
 	case TORTURE_KRB5_TEST_CHANGE_SERVER_OUT:
 	case TORTURE_KRB5_TEST_CHANGE_SERVER_IN:
 	case TORTURE_KRB5_TEST_CHANGE_SERVER_BOTH:
+	case TORTURE_KRB5_TEST_BENCH:
 		break;
 
 	case TORTURE_KRB5_TEST_PAC_REQUEST:
@@ -746,6 +754,7 @@ static bool torture_krb5_as_req_creds(struct torture_context *tctx,
 	{
 	case TORTURE_KRB5_TEST_PLAIN:
 	case TORTURE_KRB5_TEST_CHANGE_SERVER_IN:
+	case TORTURE_KRB5_TEST_BENCH:
 	case TORTURE_KRB5_TEST_PAC_REQUEST:
 	case TORTURE_KRB5_TEST_AES:
 	case TORTURE_KRB5_TEST_RC4:
@@ -929,12 +938,177 @@ static bool torture_krb5_as_req_change_server_both(struct torture_context *tctx)
 					 TORTURE_KRB5_TEST_CHANGE_SERVER_BOTH);
 }
 
+/*
+  benchmark AS-REQs for the command line credentials.  Each one has
+  the KDC look up the client and krbtgt accounts in the sam.ldb.
+*/
+static bool torture_krb5_as_req_bench(struct torture_context *tctx)
+{
+	struct cli_credentials *credentials = popt_get_cmdline_credentials();
+	const char *password = cli_credentials_get_password(credentials);
+	int timelimit = torture_setting_int(tctx, "timelimit", 10);
+	struct timeval tv;
+	struct smb_krb5_context *smb_krb5_context = NULL;
+	krb5_context k5_context;
+	krb5_principal principal;
+	enum credentials_obtained obtained;
+	const char *error_string;
+	krb5_error_code k5ret;
+	int pass_count = 0;
+	int fail_count = 0;
+	bool ok;
+
+	ok = torture_krb5_init_context(tctx, TORTURE_KRB5_TEST_BENCH,
+				       &smb_krb5_context);
+	torture_assert(tctx, ok, "torture_krb5_init_context failed");
+	k5_context = smb_krb5_context->krb5_context;
+
+	k5ret = principal_from_credentials(tctx, credentials, smb_krb5_context,
+					   &principal, &obtained,  &error_string);
+	torture_assert_int_equal(tctx, k5ret, 0, error_string);
+
+	printf("Running AS-REQs for %d seconds\n", timelimit);
+	tv = timeval_current();
+	while (timeval_elapsed(&tv) < timelimit) {
+		krb5_creds my_creds;
+
+		k5ret = krb5_get_init_creds_password(k5_context, &my_creds,
+						     principal, password,
+						     NULL, NULL, 0,
+						     NULL, NULL);
+		if (k5ret != 0) {
+			fail_count++;
+			continue;
+		}
+		krb5_free_cred_contents(k5_context, &my_creds);
+		pass_count++;
+
+		if (pass_count % 50 == 0 &&
+		    torture_setting_bool(tctx, "progress", true)) {
+			printf("%.1f AS-REQs per second (%d failures)  \r",
+			       pass_count / timeval_elapsed(&tv),
+			       fail_count);
+			fflush(stdout);
+		}
+	}
+
+	printf("%.1f AS-REQs per second (%d failures)  \n",
+	       pass_count / timeval_elapsed(&tv),
+	       fail_count);
+
+	torture_assert(tctx, pass_count > 0, "no AS-REQ succeeded");
+	return true;
+}
+
+/*
+  benchmark TGS-REQs for the command line credentials.  Each one has
+  the KDC look up the krbtgt, client and server accounts.  The service
+  to ask for is given with
+  --option=torture:tgs-target=host/dc.example.com@EXAMPLE.COM
+*/
+static bool torture_krb5_tgs_req_bench(struct torture_context *tctx)
+{
+	struct cli_credentials *credentials = popt_get_cmdline_credentials();
+	const char *password = cli_credentials_get_password(credentials);
+	const char *target = torture_setting_string(tctx, "tgs-target", NULL);
+	int timelimit = torture_setting_int(tctx, "timelimit", 10);
+	struct timeval tv;
+	struct smb_krb5_context *smb_krb5_context = NULL;
+	krb5_context k5_context;
+	krb5_principal principal;
+	krb5_principal server_principal;
+	krb5_get_creds_opt opt;
+	krb5_ccache ccache;
+	krb5_creds my_creds;
+	enum credentials_obtained obtained;
+	const char *error_string;
+	krb5_error_code k5ret;
+	int pass_count = 0;
+	int fail_count = 0;
+	bool ok;
+
+	if (target == NULL) {
+		torture_skip(tctx, "set torture:tgs-target to the service "
+			     "principal to ask for");
+	}
+
+	ok = torture_krb5_init_context(tctx, TORTURE_KRB5_TEST_BENCH,
+				       &smb_krb5_context);
+	torture_assert(tctx, ok, "torture_krb5_init_context failed");
+	k5_context = smb_krb5_context->krb5_context;
+
+	k5ret = principal_from_credentials(tctx, credentials, smb_krb5_context,
+					   &principal, &obtained,  &error_string);
+	torture_assert_int_equal(tctx, k5ret, 0, error_string);
+
+	k5ret = krb5_parse_name(k5_context, target, &server_principal);
+	torture_assert_int_equal(tctx, k5ret, 0, "krb5_parse_name failed");
+
+	k5ret = krb5_get_init_creds_password(k5_context, &my_creds,
+					     principal, password,
+					     NULL, NULL, 0,
+					     NULL, NULL);
+	torture_assert_int_equal(tctx, k5ret, 0,
+				 "krb5_get_init_creds_password failed");
+
+	k5ret = krb5_cc_new_unique(k5_context, "MEMORY", NULL, &ccache);
+	torture_assert_int_equal(tctx, k5ret, 0, "krb5_cc_new_unique failed");
+	k5ret = krb5_cc_initialize(k5_context, ccache, principal);
+	torture_assert_int_equal(tctx, k5ret, 0, "krb5_cc_initialize failed");
+	k5ret = krb5_cc_store_cred(k5_context, ccache, &my_creds);
+	torture_assert_int_equal(tctx, k5ret, 0, "krb5_cc_store_cred failed");
+	krb5_free_cred_contents(k5_context, &my_creds);
+
+	/* do not keep the tickets, so that each one is a TGS-REQ */
+	k5ret = krb5_get_creds_opt_alloc(k5_context, &opt);
+	torture_assert_int_equal(tctx, k5ret, 0,
+				 "krb5_get_creds_opt_alloc failed");
+	krb5_get_creds_opt_set_options(k5_context, opt, KRB5_GC_NO_STORE);
+
+	printf("Running TGS-REQs for %s for %d seconds\n", target, timelimit);
+	tv = timeval_current();
+	while (timeval_elapsed(&tv) < timelimit) {
+		krb5_creds *creds = NULL;
+
+		k5ret = krb5_get_creds(k5_context, opt, ccache,
+				       server_principal, &creds);
+		if (k5ret != 0) {
+			fail_count++;
+			continue;
+		}
+		krb5_free_creds(k5_context, creds);
+		pass_count++;
+
+		if (pass_count % 50 == 0 &&
+		    torture_setting_bool(tctx, "progress", true)) {
+			printf("%.1f TGS-REQs per second (%d failures)  \r",
+			       pass_count / timeval_elapsed(&tv),
+			       fail_count);
+			fflush(stdout);
+		}
+	}
+
+	printf("%.1f TGS-REQs per second (%d failures)  \n",
+	       pass_count / timeval_elapsed(&tv),
+	       fail_count);
+
+	krb5_get_creds_opt_free(k5_context, opt);
+	krb5_cc_destroy(k5_context, ccache);
+	krb5_free_principal(k5_context, server_principal);
+
+	torture_assert(tctx, pass_count > 0, "no TGS-REQ succeeded");
+	return true;
+}
+
 NTSTATUS torture_krb5_init(TALLOC_CTX *ctx)
 {
 	struct torture_suite *suite = torture_suite_create(ctx, "krb5");
 	struct torture_suite *kdc_suite = torture_suite_create(suite, "kdc");
+	struct torture_suite *bench_suite = torture_suite_create(suite, "bench");
 	suite->description = talloc_strdup(suite, "Kerberos tests");
 	kdc_suite->description = talloc_strdup(kdc_suite, "Kerberos KDC tests");
+	bench_suite->description = talloc_strdup(bench_suite,
+						 "Kerberos KDC benchmarks");
 
 	torture_suite_add_simple_test(kdc_suite, "as-req-cmdline",
 				      torture_krb5_as_req_cmdline);
@@ -979,6 +1153,13 @@ NTSTATUS torture_krb5_init(TALLOC_CTX *ctx)
 	torture_suite_add_suite(kdc_suite, torture_krb5_canon(kdc_suite));
 	torture_suite_add_suite(suite, kdc_suite);
 
+	/* not part of krb5.kdc, so selftest does not run it */
+	torture_suite_add_simple_test(bench_suite, "as-req",
+				      torture_krb5_as_req_bench);
+	torture_suite_add_simple_test(bench_suite, "tgs-req",
+				      torture_krb5_tgs_req_bench);
+	torture_suite_add_suite(suite, bench_suite);
+
 	torture_register_suite(ctx, suite);
 	return NT_STATUS_OK;
 }
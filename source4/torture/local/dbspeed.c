@@ -257,6 +257,579 @@ failed:
 	return false;
 }
 
+/*
+  a made up display name for the i'th user, spread over enough
+  surnames that an initial substring matches only a few users
+*/
+static void ldb_substring_name(unsigned i, char name[32])
+{
+	static const char *syl[] = {
+		"ka", "lo", "mi", "ne", "ru", "ta", "vo", "ze",
+		"ba", "ci", "do", "fe", "gu", "ha", "ji", "po"
+	};
+	static const char *first[] = {
+		"Alice", "Bob", "Carol", "Dave", "Eve", "Frank", "Grace"
+	};
+
+	snprintf(name, 32, "%s%s%s %s",
+		 syl[i % 16], syl[(i / 16) % 16], syl[(i / 256) % 16],
+		 first[i % 7]);
+}
+
+static int ldb_substring_search(struct ldb_context *ldb,
+				TALLOC_CTX *mem_ctx,
+				const char *prefix)
+{
+	struct ldb_result *res;
+	int count;
+
+	if (ldb_search(ldb, mem_ctx, &res, NULL, LDB_SCOPE_SUBTREE, NULL,
+		       "(displayName=%s*)", prefix) != LDB_SUCCESS) {
+		return -1;
+	}
+	count = res->count;
+	talloc_free(res);
+	return count;
+}
+
+/*
+  time initial substring searches, like those made for ANR, before
+  and after adding a prefix index
+*/
+static bool test_ldb_substring_speed(struct torture_context *torture,
+				     const void *_data)
+{
+	struct timeval tv;
+	struct ldb_context *ldb;
+	int timelimit = torture_setting_int(torture, "timelimit", 10);
+	int i, j, count;
+	TALLOC_CTX *tmp_ctx = talloc_new(torture);
+	struct ldb_ldif *ldif;
+	const char *init_ldif = "dn: @ATTRIBUTES\n" \
+		"displayName: CASE_INSENSITIVE\n" \
+		"\n" \
+		"dn: @INDEXLIST\n" \
+		"@IDXATTR: objectClass\n";
+	struct ldb_message *msg;
+	char name[32];
+	float speed[2];
+
+	unlink("./test_substring.ldb");
+
+	torture_comment(torture, "Testing ldb initial substring search speed\n");
+
+	ldb = ldb_wrap_connect(tmp_ctx, torture->ev, torture->lp_ctx,
+			       "tdb://test_substring.ldb",
+			       NULL, NULL, LDB_FLG_NOSYNC);
+	if (!ldb) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to open test_substring.ldb");
+		goto failed;
+	}
+
+	while ((ldif = ldb_ldif_read_string(ldb, &init_ldif)) != NULL) {
+		if (ldb_add(ldb, ldif->msg) != LDB_SUCCESS) {
+			torture_result(torture, TORTURE_FAIL,
+				       "Couldn't apply LDIF data!");
+			talloc_free(ldif);
+			goto failed;
+		}
+		talloc_free(ldif);
+	}
+
+	torture_comment(torture, "Adding %d user records\n", torture_entries);
+
+	if (ldb_transaction_start(ldb) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to start transaction");
+		goto failed;
+	}
+	for (i=0;i<torture_entries;i++) {
+		msg = ldb_msg_new(tmp_ctx);
+		if (msg == NULL) {
+			goto failed;
+		}
+		msg->dn = ldb_dn_new_fmt(msg, ldb,
+					 "CN=user%u,DC=example,DC=com", i);
+		ldb_substring_name(i, name);
+		if (msg->dn == NULL ||
+		    ldb_msg_add_string(msg, "objectClass", "user") != LDB_SUCCESS ||
+		    ldb_msg_add_string(msg, "displayName", name) != LDB_SUCCESS ||
+		    ldb_add(ldb, msg) != LDB_SUCCESS) {
+			torture_result(torture, TORTURE_FAIL,
+				       "Failed to add user %d", i);
+			talloc_free(msg);
+			ldb_transaction_cancel(ldb);
+			goto failed;
+		}
+		talloc_free(msg);
+	}
+	if (ldb_transaction_commit(ldb) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to commit transaction");
+		goto failed;
+	}
+
+	for (j=0;j<2;j++) {
+		if (j == 1) {
+			torture_comment(torture,
+					"Adding a prefix index on displayName\n");
+			msg = ldb_msg_new(tmp_ctx);
+			if (msg == NULL) {
+				goto failed;
+			}
+			msg->dn = ldb_dn_new(msg, ldb, "@INDEXLIST");
+			tv = timeval_current();
+			if (msg->dn == NULL ||
+			    ldb_msg_add_empty(msg, "@IDXPREFIX",
+					      LDB_FLAG_MOD_ADD,
+					      NULL) != LDB_SUCCESS ||
+			    ldb_msg_add_string(msg, "@IDXPREFIX",
+					       "displayName") != LDB_SUCCESS ||
+			    ldb_modify(ldb, msg) != LDB_SUCCESS) {
+				torture_result(torture, TORTURE_FAIL,
+					       "Failed to add prefix index");
+				talloc_free(msg);
+				goto failed;
+			}
+			talloc_free(msg);
+			torture_comment(torture, "reindex took %.2f seconds\n",
+					timeval_elapsed(&tv));
+		}
+
+		torture_comment(torture, "Testing %s searches for %d seconds\n",
+				j == 0 ? "unindexed" : "indexed",
+				(timelimit + 1) / 2);
+
+		tv = timeval_current();
+
+		for (count=0;timeval_elapsed(&tv) < (timelimit + 1) / 2;count++) {
+			i = random() % torture_entries;
+			ldb_substring_name(i, name);
+			name[5] = '\0';
+			if (ldb_substring_search(ldb, tmp_ctx, name) < 1) {
+				torture_result(torture, TORTURE_FAIL,
+					       "Failed to find (displayName=%s*)",
+					       name);
+				goto failed;
+			}
+		}
+
+		speed[j] = count/timeval_elapsed(&tv);
+		torture_comment(torture, "%s substring search speed %.2f ops/sec\n",
+				j == 0 ? "unindexed" : "indexed", speed[j]);
+	}
+
+	/* the index must find exactly what a full scan would */
+	for (i=0;i<10 && i<torture_entries;i++) {
+		char prefix[32];
+		int expected = 0;
+
+		ldb_substring_name(random() % torture_entries, prefix);
+		prefix[3 + i % 4] = '\0';
+		for (j=0;j<torture_entries;j++) {
+			ldb_substring_name(j, name);
+			if (strncasecmp(name, prefix, strlen(prefix)) == 0) {
+				expected++;
+			}
+		}
+		count = ldb_substring_search(ldb, tmp_ctx, prefix);
+		if (count != expected) {
+			torture_result(torture, TORTURE_FAIL,
+				       "(displayName=%s*) found %d, expected %d",
+				       prefix, count, expected);
+			goto failed;
+		}
+	}
+
+	torture_comment(torture, "indexed/unindexed speed ratio is %.2f\n",
+			speed[1]/speed[0]);
+
+	talloc_free(tmp_ctx);
+	unlink("./test_substring.ldb");
+	return true;
+
+failed:
+	talloc_free(tmp_ctx);
+	unlink("./test_substring.ldb");
+	return false;
+}
+
+static int ldb_reindex_count(struct ldb_context *ldb,
+			     TALLOC_CTX *mem_ctx,
+			     const char *filter)
+{
+	struct ldb_result *res;
+	int count;
+
+	if (ldb_search(ldb, mem_ctx, &res, NULL, LDB_SCOPE_SUBTREE, NULL,
+		       "%s", filter) != LDB_SUCCESS) {
+		return -1;
+	}
+	count = res->count;
+	talloc_free(res);
+	return count;
+}
+
+/*
+  time a full reindex of a GUID indexed database, as done on an
+  upgrade, a schema change or by dbcheck --reindex
+*/
+static bool test_ldb_reindex_speed(struct torture_context *torture,
+				   const void *_data)
+{
+	struct timeval tv;
+	struct ldb_context *ldb;
+	int i;
+	TALLOC_CTX *tmp_ctx = talloc_new(torture);
+	struct ldb_ldif *ldif;
+	const char *init_ldif = "dn: @INDEXLIST\n" \
+		"@IDXGUID: objectUUID\n" \
+		"@IDX_DN_GUID: GUID\n" \
+		"@IDXATTR: objectClass\n" \
+		"@IDXATTR: cn\n";
+	struct ldb_message *msg;
+	double elapsed;
+	char name[32];
+
+	unlink("./test_reindex.ldb");
+
+	torture_comment(torture, "Testing ldb reindex speed\n");
+
+	ldb = ldb_wrap_connect(tmp_ctx, torture->ev, torture->lp_ctx,
+			       "tdb://test_reindex.ldb",
+			       NULL, NULL, LDB_FLG_NOSYNC);
+	if (!ldb) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to open test_reindex.ldb");
+		goto failed;
+	}
+
+	while ((ldif = ldb_ldif_read_string(ldb, &init_ldif)) != NULL) {
+		if (ldb_add(ldb, ldif->msg) != LDB_SUCCESS) {
+			torture_result(torture, TORTURE_FAIL,
+				       "Couldn't apply LDIF data!");
+			talloc_free(ldif);
+			goto failed;
+		}
+		talloc_free(ldif);
+	}
+
+	torture_comment(torture, "Adding %d user records\n", torture_entries);
+
+	if (ldb_transaction_start(ldb) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to start transaction");
+		goto failed;
+	}
+	for (i=0;i<torture_entries;i++) {
+		uint8_t guid[16];
+		struct ldb_val v = {
+			.data = guid,
+			.length = sizeof(guid)
+		};
+		int j;
+
+		for (j=0;j<sizeof(guid);j++) {
+			guid[j] = random();
+		}
+		SIVAL(guid, 0, i);
+
+		msg = ldb_msg_new(tmp_ctx);
+		if (msg == NULL) {
+			goto failed;
+		}
+		msg->dn = ldb_dn_new_fmt(msg, ldb,
+					 "CN=user%u,DC=example,DC=com", i);
+		ldb_substring_name(i, name);
+		if (msg->dn == NULL ||
+		    ldb_msg_add_value(msg, "objectUUID", &v,
+				      NULL) != LDB_SUCCESS ||
+		    ldb_msg_add_string(msg, "objectClass", "top") != LDB_SUCCESS ||
+		    ldb_msg_add_string(msg, "objectClass", "user") != LDB_SUCCESS ||
+		    ldb_msg_add_string(msg, "cn", name) != LDB_SUCCESS ||
+		    ldb_add(ldb, msg) != LDB_SUCCESS) {
+			torture_result(torture, TORTURE_FAIL,
+				       "Failed to add user %d", i);
+			talloc_free(msg);
+			ldb_transaction_cancel(ldb);
+			goto failed;
+		}
+		talloc_free(msg);
+	}
+	if (ldb_transaction_commit(ldb) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to commit transaction");
+		goto failed;
+	}
+
+	/* changing @INDEXLIST reindexes the whole database */
+	torture_comment(torture, "Adding an index on displayName\n");
+	msg = ldb_msg_new(tmp_ctx);
+	if (msg == NULL) {
+		goto failed;
+	}
+	msg->dn = ldb_dn_new(msg, ldb, "@INDEXLIST");
+	tv = timeval_current();
+	if (msg->dn == NULL ||
+	    ldb_msg_add_empty(msg, "@IDXATTR",
+			      LDB_FLAG_MOD_ADD, NULL) != LDB_SUCCESS ||
+	    ldb_msg_add_string(msg, "@IDXATTR",
+			       "displayName") != LDB_SUCCESS ||
+	    ldb_modify(ldb, msg) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL, "Failed to reindex");
+		talloc_free(msg);
+		goto failed;
+	}
+	talloc_free(msg);
+	elapsed = timeval_elapsed(&tv);
+
+	torture_comment(torture, "reindex took %.2f seconds, "
+			"%.0f records/sec\n",
+			elapsed, torture_entries / elapsed);
+
+	/* the rebuilt indexes must still find every record */
+	if (ldb_reindex_count(ldb, tmp_ctx, "(objectClass=user)")
+	    != torture_entries) {
+		torture_result(torture, TORTURE_FAIL,
+			       "(objectClass=user) did not find every user");
+		goto failed;
+	}
+	for (i=0;i<10 && i<torture_entries;i++) {
+		char *filter;
+		int expected = 0;
+		int j;
+
+		ldb_substring_name(random() % torture_entries, name);
+		for (j=0;j<torture_entries;j++) {
+			char name2[32];
+			ldb_substring_name(j, name2);
+			if (strcasecmp(name, name2) == 0) {
+				expected++;
+			}
+		}
+		filter = talloc_asprintf(tmp_ctx, "(cn=%s)", name);
+		if (filter == NULL) {
+			goto failed;
+		}
+		if (ldb_reindex_count(ldb, tmp_ctx, filter) != expected) {
+			torture_result(torture, TORTURE_FAIL,
+				       "%s did not find %d users",
+				       filter, expected);
+			goto failed;
+		}
+	}
+
+	talloc_free(tmp_ctx);
+	unlink("./test_reindex.ldb");
+	return true;
+
+failed:
+	talloc_free(tmp_ctx);
+	unlink("./test_reindex.ldb");
+	return false;
+}
+
+/*
+  fetch one page of all the users with the paged results control,
+  returning the cookie for the next page or NULL on the last page
+*/
+static int ldb_paged_page(struct ldb_context *ldb,
+			  TALLOC_CTX *mem_ctx,
+			  int size,
+			  char **cookie,
+			  struct ldb_result **_res)
+{
+	struct ldb_request *req;
+	struct ldb_result *res;
+	struct ldb_paged_control *paged;
+	struct ldb_control *control;
+	int i, ret;
+
+	res = talloc_zero(mem_ctx, struct ldb_result);
+	if (res == NULL) {
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+
+	ret = ldb_build_search_req(&req, ldb, res, NULL, LDB_SCOPE_SUBTREE,
+				   "(objectClass=user)", NULL, NULL,
+				   res, ldb_search_default_callback, NULL);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(res);
+		return ret;
+	}
+
+	paged = talloc_zero(req, struct ldb_paged_control);
+	if (paged == NULL) {
+		talloc_free(res);
+		return LDB_ERR_OPERATIONS_ERROR;
+	}
+	paged->size = size;
+	if (*cookie != NULL) {
+		paged->cookie = *cookie;
+		paged->cookie_len = strlen(*cookie) + 1;
+	}
+
+	ret = ldb_request_add_control(req, LDB_CONTROL_PAGED_RESULTS_OID,
+				      true, paged);
+	if (ret == LDB_SUCCESS) {
+		ret = ldb_request(ldb, req);
+	}
+	if (ret == LDB_SUCCESS) {
+		ret = ldb_wait(req->handle, LDB_WAIT_ALL);
+	}
+	if (ret != LDB_SUCCESS) {
+		talloc_free(res);
+		return ret;
+	}
+
+	TALLOC_FREE(*cookie);
+	for (i=0;res->controls != NULL && res->controls[i] != NULL;i++) {
+		control = res->controls[i];
+		if (strcmp(control->oid, LDB_CONTROL_PAGED_RESULTS_OID) != 0) {
+			continue;
+		}
+		paged = talloc_get_type(control->data,
+					struct ldb_paged_control);
+		if (paged != NULL && paged->cookie_len != 0) {
+			*cookie = talloc_strndup(mem_ctx, paged->cookie,
+						 paged->cookie_len);
+		}
+	}
+
+	talloc_free(req);
+	*_res = res;
+	return LDB_SUCCESS;
+}
+
+/*
+  measure the memory held by the paged_results module while a paged
+  search is in progress, and the time taken to page through it
+*/
+static bool test_ldb_paged_memory(struct torture_context *torture,
+				  const void *_data)
+{
+	struct timeval tv;
+	struct ldb_context *ldb;
+	int i, count, pages;
+	TALLOC_CTX *tmp_ctx = talloc_new(torture);
+	const char *options[] = { "modules:paged_results", NULL };
+	struct ldb_result *res;
+	struct ldb_message *msg;
+	char *cookie = NULL;
+	size_t before, after;
+	double first_page;
+	char name[32];
+
+	unlink("./test_paged.ldb");
+
+	torture_comment(torture, "Testing ldb paged search memory\n");
+
+	ldb = ldb_init(tmp_ctx, torture->ev);
+	if (ldb == NULL ||
+	    ldb_connect(ldb, "tdb://test_paged.ldb",
+			LDB_FLG_NOSYNC, options) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to open test_paged.ldb");
+		goto failed;
+	}
+
+	torture_comment(torture, "Adding %d user records\n", torture_entries);
+
+	if (ldb_transaction_start(ldb) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to start transaction");
+		goto failed;
+	}
+	for (i=0;i<torture_entries;i++) {
+		msg = ldb_msg_new(tmp_ctx);
+		if (msg == NULL) {
+			goto failed;
+		}
+		msg->dn = ldb_dn_new_fmt(msg, ldb,
+					 "CN=user%u,DC=example,DC=com", i);
+		ldb_substring_name(i, name);
+		if (msg->dn == NULL ||
+		    ldb_msg_add_string(msg, "objectClass", "top") != LDB_SUCCESS ||
+		    ldb_msg_add_string(msg, "objectClass", "user") != LDB_SUCCESS ||
+		    ldb_msg_add_string(msg, "cn", name) != LDB_SUCCESS ||
+		    ldb_msg_add_string(msg, "displayName", name) != LDB_SUCCESS ||
+		    ldb_msg_add_fmt(msg, "description",
+				    "%s is user number %u of %d", name,
+				    i, torture_entries) != LDB_SUCCESS ||
+		    ldb_msg_add_fmt(msg, "uidNumber", "%u", 10000 + i) != LDB_SUCCESS ||
+		    ldb_add(ldb, msg) != LDB_SUCCESS) {
+			torture_result(torture, TORTURE_FAIL,
+				       "Failed to add user %d", i);
+			talloc_free(msg);
+			ldb_transaction_cancel(ldb);
+			goto failed;
+		}
+		talloc_free(msg);
+	}
+	if (ldb_transaction_commit(ldb) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to commit transaction");
+		goto failed;
+	}
+
+	/* fill any caches in the backend first, so that only the
+	 * memory held for the paged search is counted */
+	if (ldb_reindex_count(ldb, tmp_ctx, "(objectClass=user)")
+	    != torture_entries) {
+		torture_result(torture, TORTURE_FAIL,
+			       "(objectClass=user) did not find every user");
+		goto failed;
+	}
+
+	before = talloc_total_size(ldb);
+	tv = timeval_current();
+	if (ldb_paged_page(ldb, tmp_ctx, 100, &cookie, &res) != LDB_SUCCESS) {
+		torture_result(torture, TORTURE_FAIL,
+			       "Failed to fetch the first page");
+		goto failed;
+	}
+	first_page = timeval_elapsed(&tv);
+	count = res->count;
+	talloc_free(res);
+	after = talloc_total_size(ldb);
+
+	torture_comment(torture, "first page took %.3f seconds, "
+			"the search holds %lu bytes (%.1f per entry)\n",
+			first_page, (unsigned long)(after - before),
+			(double)(after - before) / torture_entries);
+
+	for (pages=1;cookie != NULL;pages++) {
+		if (ldb_paged_page(ldb, tmp_ctx, 100, &cookie,
+				   &res) != LDB_SUCCESS) {
+			torture_result(torture, TORTURE_FAIL,
+				       "Failed to fetch page %d", pages);
+			goto failed;
+		}
+		count += res->count;
+		talloc_free(res);
+	}
+
+	torture_comment(torture, "%d pages took %.3f seconds\n",
+			pages, timeval_elapsed(&tv));
+
+	if (count != torture_entries) {
+		torture_result(torture, TORTURE_FAIL,
+			       "paged search found %d of %d users",
+			       count, torture_entries);
+		goto failed;
+	}
+
+	talloc_free(tmp_ctx);
+	unlink("./test_paged.ldb");
+	return true;
+
+failed:
+	talloc_free(tmp_ctx);
+	unlink("./test_paged.ldb");
+	return false;
+}
+
 struct torture_suite *torture_local_dbspeed(TALLOC_CTX *mem_ctx)
 {
 	struct torture_suite *s = torture_suite_create(mem_ctx, "dbspeed");
@@ -264,5 +837,11 @@ struct torture_suite *torture_local_dbspeed(TALLOC_CTX *mem_ctx)
 			NULL);
 	torture_suite_add_simple_tcase_const(s, "ldb_speed", test_ldb_speed,
 			NULL);
+	torture_suite_add_simple_tcase_const(s, "ldb_substring_speed",
+			test_ldb_substring_speed, NULL);
+	torture_suite_add_simple_tcase_const(s, "ldb_reindex_speed",
+			test_ldb_reindex_speed, NULL);
+	torture_suite_add_simple_tcase_const(s, "ldb_paged_memory",
+			test_ldb_paged_memory, NULL);
 	return s;
 }
@@ -70,6 +70,8 @@
 	torture_ldb,
 	torture_dsdb_dn,
 	torture_dsdb_syntax,
+	torture_dsdb_schema_query,
+	torture_dsdb_schema_speed,
 	torture_registry,
 	torture_local_verif_trailer,
 	torture_local_nss,